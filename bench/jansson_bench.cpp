@@ -0,0 +1,445 @@
+// Throughput and allocation benchmarks for the parser, the serializer, the
+// C API and value access.
+//
+//   jansson_bench [--time SECONDS] [--filter TEXT] [FILE...]
+//
+// Without files, synthetic corpora shaped like the usual reference
+// documents are generated: twitter (string-heavy objects with nested
+// users), canada (long arrays of coordinate pairs), citm_catalog (maps of
+// small integer-keyed objects) and an NDJSON log. Files named on the
+// command line are benchmarked instead; .ndjson and .jsonl files are read
+// as one record per line. Only rows whose "corpus/operation" name contains
+// the filter text are run. Configure with -DCMAKE_BUILD_TYPE=Release for
+// meaningful numbers.
+//
+// Allocations count every operator new in the process, including those
+// made by pool threads while a row runs.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "json_c_api.hpp"
+#include "json_lines.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_value.hpp"
+
+// Every heap allocation made by the program is counted
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+
+using namespace jansson;
+using Clock = std::chrono::steady_clock;
+
+// Results are stored here so the optimizer keeps the work that made them
+volatile std::size_t sink = 0;
+
+struct Corpus {
+    std::string name;
+    std::string text;
+    bool lines = false;
+};
+
+// Deterministic pseudo-random numbers, so every run sees the same corpora
+struct Random {
+    std::uint64_t state = 0x9E3779B97F4A7C15ull;
+
+    std::uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    std::size_t below(std::size_t bound) { return static_cast<std::size_t>(next() % bound); }
+
+    std::string word(std::size_t length) {
+        std::string text;
+        for (std::size_t i = 0; i < length; ++i) {
+            text += static_cast<char>('a' + below(26));
+        }
+        return text;
+    }
+};
+
+std::string twitter(Random& random) {
+    std::ostringstream out;
+    out << "{\"statuses\": [";
+    for (int i = 0; i < 400; ++i) {
+        out << (i ? ", " : "") << "{\"id\": " << 500000000000000000ull + random.below(1000000000)
+            << ", \"text\": \"" << random.word(20) << " \\u00e9\\u2603 " << random.word(40)
+            << " \\\"quoted\\\" #" << random.word(6) << "\", \"truncated\": false,"
+            << " \"entities\": {\"hashtags\": [{\"text\": \"" << random.word(6) << "\", \"indices\": ["
+            << random.below(100) << ", " << random.below(100) << "]}], \"urls\": []},"
+            << " \"user\": {\"id\": " << random.below(100000000) << ", \"name\": \"" << random.word(12)
+            << "\", \"screen_name\": \"" << random.word(10) << "\", \"description\": \"" << random.word(60)
+            << "\", \"followers_count\": " << random.below(100000) << ", \"verified\": "
+            << (random.below(2) ? "true" : "false") << ", \"profile_image_url\": \"http://a0.example.com/"
+            << random.word(24) << ".png\"}, \"retweet_count\": " << random.below(1000)
+            << ", \"favorited\": false, \"lang\": \"en\", \"geo\": null}";
+    }
+    out << "], \"search_metadata\": {\"count\": 400, \"query\": \"" << random.word(8) << "\"}}";
+    return out.str();
+}
+
+std::string canada(Random& random) {
+    std::ostringstream out;
+    out.precision(15);
+    out << "{\"type\": \"FeatureCollection\", \"features\": [{\"type\": \"Feature\", \"properties\": "
+        << "{\"name\": \"Canada\"}, \"geometry\": {\"type\": \"Polygon\", \"coordinates\": [";
+    for (int ring = 0; ring < 40; ++ring) {
+        out << (ring ? ", " : "") << "[";
+        for (int point = 0; point < 1000; ++point) {
+            double x = -141.0 + static_cast<double>(random.below(8000000)) / 100000.0;
+            double y = 41.0 + static_cast<double>(random.below(4000000)) / 100000.0;
+            out << (point ? ", " : "") << "[" << x << ", " << y << "]";
+        }
+        out << "]";
+    }
+    out << "]}}]}";
+    return out.str();
+}
+
+std::string citm_catalog(Random& random) {
+    std::ostringstream out;
+    out << "{\"areaNames\": {";
+    for (int i = 0; i < 200; ++i) {
+        out << (i ? ", " : "") << "\"" << 205705993 + i << "\": \"" << random.word(16) << "\"";
+    }
+    out << "}, \"events\": {";
+    for (int i = 0; i < 600; ++i) {
+        out << (i ? ", " : "") << "\"" << 138586341 + i << "\": {\"description\": null, \"id\": "
+            << 138586341 + i << ", \"logo\": \"/images/UE0AAAAACEKo6QAAAA" << random.word(4)
+            << ".jpg\", \"name\": \"" << random.word(18) << "\", \"subTopicIds\": [" << 337184269 + random.below(50)
+            << ", " << 337184283 + random.below(50) << "], \"subjectCode\": null, \"subtitle\": null,"
+            << " \"topicIds\": [" << 324846099 + random.below(50) << ", " << 107888604 + random.below(50) << "]}";
+    }
+    out << "}, \"performances\": [";
+    for (int i = 0; i < 600; ++i) {
+        out << (i ? ", " : "") << "{\"eventId\": " << 138586341 + random.below(600) << ", \"id\": "
+            << 339887544 + i << ", \"prices\": [{\"amount\": " << 90250 + random.below(1000)
+            << ", \"audienceSubCategoryId\": 337100890, \"seatCategoryId\": " << 338937295 + random.below(10)
+            << "}], \"seatCategories\": [{\"areas\": [{\"areaId\": " << 205705999 + random.below(200)
+            << ", \"blockIds\": []}], \"seatCategoryId\": 338937295}], \"start\": " << 1372701600000
+            + static_cast<long long>(random.below(100000000)) << ", \"venueCode\": \"PLEYEL_PLEYEL\"}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+std::string log_lines(Random& random) {
+    std::ostringstream out;
+    const char* levels[] = {"debug", "info", "warn", "error"};
+    for (int i = 0; i < 5000; ++i) {
+        out << "{\"ts\": " << 1700000000000 + i * 17 << ", \"level\": \"" << levels[random.below(4)]
+            << "\", \"service\": \"" << random.word(8) << "\", \"msg\": \"" << random.word(30)
+            << "\", \"latency_ms\": " << static_cast<double>(random.below(100000)) / 100.0
+            << ", \"status\": " << 200 + random.below(4) * 100 << ", \"tags\": [\"" << random.word(5)
+            << "\", \"" << random.word(5) << "\"]}\n";
+    }
+    return out.str();
+}
+
+std::vector<Corpus> generated_corpora() {
+    Random random;
+    std::vector<Corpus> corpora;
+    corpora.push_back({"twitter", twitter(random)});
+    corpora.push_back({"canada", canada(random)});
+    corpora.push_back({"citm_catalog", citm_catalog(random)});
+    corpora.push_back({"log.ndjson", log_lines(random), true});
+    return corpora;
+}
+
+bool read_corpus(const std::string& path, Corpus& corpus) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    corpus.text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    std::size_t slash = path.find_last_of("/\\");
+    corpus.name = slash == std::string::npos ? path : path.substr(slash + 1);
+    auto ends_with = [&](const char* suffix) {
+        std::string_view name = corpus.name;
+        std::size_t length = std::char_traits<char>::length(suffix);
+        return name.size() >= length && name.substr(name.size() - length) == suffix;
+    };
+    corpus.lines = ends_with(".ndjson") || ends_with(".jsonl");
+    return true;
+}
+
+// Run body repeatedly for at least min_seconds and report the time,
+// throughput (if bytes is nonzero) and allocations of one run. body
+// returns the number of operations it performed.
+struct Runner {
+    double min_seconds = 0.5;
+    std::string filter;
+
+    template <typename Body>
+    void run(const std::string& corpus, const char* operation, std::size_t bytes, Body&& body) {
+        std::string name = corpus + "/" + operation;
+        if (name.find(filter) == std::string::npos) {
+            return;
+        }
+
+        std::size_t operations = body(); // warm-up
+        std::size_t runs = 0;
+        std::size_t allocated = allocations.load(std::memory_order_relaxed);
+        Clock::time_point start = Clock::now();
+        double elapsed = 0;
+        do {
+            body();
+            runs++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < min_seconds);
+        allocated = allocations.load(std::memory_order_relaxed) - allocated;
+
+        double count = static_cast<double>(runs) * static_cast<double>(std::max<std::size_t>(operations, 1));
+        std::printf("%-32s %12.1f", name.c_str(), elapsed * 1e9 / count);
+        if (bytes) {
+            std::printf(" %10.1f", static_cast<double>(bytes) * static_cast<double>(runs) / elapsed / 1e6);
+        } else {
+            std::printf(" %10s", "-");
+        }
+        std::printf(" %12.1f\n", static_cast<double>(allocated) / count);
+    }
+};
+
+// Every object in the tree, and every key it holds, for the lookup passes
+void collect_objects(const JsonValue& value, std::vector<const JsonObject*>& objects) {
+    if (value.is_object()) {
+        const auto& object = static_cast<const JsonObject&>(value);
+        objects.push_back(&object);
+        for (const auto& member : object) {
+            collect_objects(*member.second, objects);
+        }
+    } else if (value.is_array()) {
+        for (const auto& element : static_cast<const JsonArray&>(value)) {
+            collect_objects(*element, objects);
+        }
+    }
+}
+
+void bench_document(Runner& runner, const Corpus& corpus) {
+    std::size_t bytes = corpus.text.size();
+    auto parsed = JsonParser::parse(corpus.text);
+    if (!parsed) {
+        std::fprintf(stderr, "%s: %s\n", corpus.name.c_str(), parsed.error().message().c_str());
+        return;
+    }
+    JsonRef<JsonValue> root = parsed.value();
+
+    runner.run(corpus.name, "parse", bytes, [&] {
+        auto result = JsonParser::parse(corpus.text);
+        return std::size_t(1);
+    });
+    JsonParseOptions indexed;
+    indexed.use_structural_index = true;
+    runner.run(corpus.name, "parse_indexed", bytes, [&] {
+        auto result = JsonParser::parse(corpus.text, indexed);
+        return std::size_t(1);
+    });
+    // Nodes recycled through this thread's pool
+    set_node_pool_limit(4096);
+    runner.run(corpus.name, "parse_pooled", bytes, [&] {
+        auto result = JsonParser::parse(corpus.text);
+        return std::size_t(1);
+    });
+    set_node_pool_limit(0);
+    trim_node_pool();
+
+    std::size_t serialized = JsonSerializer::serialize(*root).size();
+    runner.run(corpus.name, "serialize", serialized, [&] {
+        std::string text = JsonSerializer::serialize(*root);
+        return std::size_t(1);
+    });
+
+    // The same tree with its encoding cached on the root
+    JsonRef<JsonValue> cached = root->clone();
+    if (cached->is_array()) {
+        static_cast<JsonArray&>(*cached).cache_encoding();
+    } else if (cached->is_object()) {
+        static_cast<JsonObject&>(*cached).cache_encoding();
+    }
+    runner.run(corpus.name, "serialize_cached", serialized, [&] {
+        std::string text = JsonSerializer::serialize(*cached);
+        return std::size_t(1);
+    });
+
+    runner.run(corpus.name, "json_loads", bytes, [&] {
+        json_t* json = json_loads(corpus.text.c_str(), 0, nullptr);
+        json_decref(json);
+        return std::size_t(1);
+    });
+    json_t* loaded = json_loads(corpus.text.c_str(), 0, nullptr);
+    char* dumped = json_dumps(loaded, 0);
+    std::size_t dumped_bytes = dumped ? std::char_traits<char>::length(dumped) : 0;
+    json_dumps_free(dumped);
+    runner.run(corpus.name, "json_dumps", dumped_bytes, [&] {
+        json_dumps_free(json_dumps(loaded, 0));
+        return std::size_t(1);
+    });
+    json_decref(loaded);
+
+    // One operation is one member lookup or one set-and-erase
+    std::vector<const JsonObject*> objects;
+    collect_objects(*root, objects);
+    std::vector<std::pair<const JsonObject*, std::string>> members;
+    for (const JsonObject* object : objects) {
+        for (const auto& member : *object) {
+            members.emplace_back(object, std::string(member.first.view()));
+        }
+    }
+    if (members.empty()) {
+        return;
+    }
+    runner.run(corpus.name, "lookup", 0, [&] {
+        std::size_t found = 0;
+        for (const auto& member : members) {
+            found += member.first->has(member.second);
+        }
+        sink = found;
+        return members.size();
+    });
+    runner.run(corpus.name, "get", 0, [&] {
+        for (const auto& member : members) {
+            JsonRef<JsonValue> value = member.first->get(member.second);
+        }
+        return members.size();
+    });
+    runner.run(corpus.name, "set_erase", 0, [&] {
+        for (const JsonObject* object : objects) {
+            auto* mutable_object = const_cast<JsonObject*>(object);
+            mutable_object->set("bench_key", JsonNull::create());
+            mutable_object->erase("bench_key");
+        }
+        return objects.size();
+    });
+}
+
+void bench_lines(Runner& runner, const Corpus& corpus) {
+    std::size_t bytes = corpus.text.size();
+
+    // Record boundaries are found once, outside the timed loop
+    std::vector<std::string_view> records;
+    std::string_view text = corpus.text;
+    while (!text.empty()) {
+        std::size_t end = std::min(text.find('\n'), text.size());
+        if (end > 0) {
+            records.push_back(text.substr(0, end));
+        }
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+
+    runner.run(corpus.name, "parse_records", bytes, [&] {
+        for (std::string_view record : records) {
+            auto result = JsonParser::parse(record);
+        }
+        return records.size();
+    });
+    runner.run(corpus.name, "json_loadb", bytes, [&] {
+        for (std::string_view record : records) {
+            json_decref(json_loadb(record.data(), record.size(), 0, nullptr));
+        }
+        return records.size();
+    });
+    JsonLinesReader reader;
+    runner.run(corpus.name, "lines_reader", bytes, [&] {
+        reader.parse(corpus.text);
+        return records.size();
+    });
+
+    std::vector<JsonRef<JsonValue>> values;
+    for (std::string_view record : records) {
+        auto result = JsonParser::parse(record);
+        if (result) {
+            values.push_back(result.value());
+        }
+    }
+    runner.run(corpus.name, "serialize_records", bytes, [&] {
+        for (const auto& value : values) {
+            std::string line = JsonSerializer::serialize(*value);
+        }
+        return values.size();
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Runner runner;
+    std::vector<Corpus> corpora;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--time" && i + 1 < argc) {
+            runner.min_seconds = std::atof(argv[++i]);
+        } else if (argument == "--filter" && i + 1 < argc) {
+            runner.filter = argv[++i];
+        } else {
+            Corpus corpus;
+            if (!read_corpus(argument, corpus)) {
+                std::fprintf(stderr, "cannot read %s\n", argument.c_str());
+                return 1;
+            }
+            corpora.push_back(std::move(corpus));
+        }
+    }
+    if (corpora.empty()) {
+        corpora = generated_corpora();
+    }
+
+    std::printf("%-32s %12s %10s %12s\n", "benchmark", "ns/op", "MB/s", "allocs/op");
+    for (const Corpus& corpus : corpora) {
+        if (corpus.lines) {
+            bench_lines(runner, corpus);
+        } else {
+            bench_document(runner, corpus);
+        }
+    }
+    return 0;
+}
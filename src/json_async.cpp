@@ -0,0 +1,94 @@
+#include "json_async.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace jansson {
+
+static bool would_block(int error) noexcept {
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+    return error == EAGAIN || error == EWOULDBLOCK;
+#else
+    return error == EAGAIN;
+#endif
+}
+
+JsonFdReader::JsonFdReader(int fd, std::size_t buffer_size)
+    : fd_(fd),
+      buffer_size_(std::max<std::size_t>(buffer_size, 1)),
+      buffer_(new char[buffer_size_]) {}
+
+Result<JsonIoStatus> JsonFdReader::read() {
+    if (finished_) {
+        return Result<JsonIoStatus>(JsonIoStatus::Complete);
+    }
+    while (true) {
+#if defined(_WIN32)
+        int count = _read(fd_, buffer_.get(), static_cast<unsigned>(std::min<std::size_t>(buffer_size_, 1 << 30)));
+#else
+        ssize_t count = ::read(fd_, buffer_.get(), buffer_size_);
+#endif
+        if (count < 0) {
+            int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            if (would_block(error)) {
+                return Result<JsonIoStatus>(JsonIoStatus::WouldBlock);
+            }
+            return Result<JsonIoStatus>(std::error_code(error, std::generic_category()));
+        }
+        if (count == 0) {
+            finished_ = true;
+            auto finished = parser_.finish();
+            if (!finished) {
+                return Result<JsonIoStatus>(finished.error());
+            }
+            return Result<JsonIoStatus>(JsonIoStatus::Complete);
+        }
+        bytes_read_ += static_cast<std::size_t>(count);
+        auto fed = parser_.feed(std::string_view(buffer_.get(), static_cast<std::size_t>(count)));
+        if (!fed) {
+            return Result<JsonIoStatus>(fed.error());
+        }
+    }
+}
+
+JsonFdSender::JsonFdSender(int fd, JsonRef<JsonValue> value, const JsonSerializeOptions& options,
+                           std::size_t chunk_size)
+    : fd_(fd),
+      chunk_size_(std::max<std::size_t>(chunk_size, 1)),
+      serializer_(std::move(value), options) {}
+
+Result<JsonIoStatus> JsonFdSender::send() {
+    while (true) {
+        std::string_view pending = serializer_.peek(chunk_size_);
+        if (pending.empty()) {
+            return Result<JsonIoStatus>(JsonIoStatus::Complete);
+        }
+#if defined(_WIN32)
+        int written = _write(fd_, pending.data(), static_cast<unsigned>(std::min<std::size_t>(pending.size(), 1 << 30)));
+#else
+        ssize_t written = ::write(fd_, pending.data(), pending.size());
+#endif
+        if (written < 0) {
+            int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            if (would_block(error)) {
+                return Result<JsonIoStatus>(JsonIoStatus::WouldBlock);
+            }
+            return Result<JsonIoStatus>(std::error_code(error, std::generic_category()));
+        }
+        serializer_.consume(static_cast<std::size_t>(written));
+    }
+}
+
+} // namespace jansson
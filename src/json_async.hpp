@@ -0,0 +1,86 @@
+#ifndef JSON_ASYNC_HPP
+#define JSON_ASYNC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "json_stream.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+// Parsing from and serializing to non-blocking descriptors (sockets,
+// pipes) for servers built on an event loop (epoll, kqueue, io_uring
+// readiness polls). Each call does as much I/O as the descriptor accepts
+// and returns WouldBlock when the loop should wait for readiness and call
+// again, so one thread can serve many connections and large bodies are
+// parsed and sent as they move instead of being buffered whole. A
+// coroutine layer can wrap either call in an awaitable that suspends on
+// WouldBlock and resumes when the descriptor is ready.
+enum class JsonIoStatus : std::uint8_t {
+    WouldBlock, // wait until the descriptor is ready, then call again
+    Complete    // end of input reached, or all output written
+};
+
+// Feeds what a descriptor delivers to a JsonStreamParser
+class JsonFdReader {
+public:
+    static constexpr std::size_t default_buffer_size = 64 * 1024;
+
+    explicit JsonFdReader(int fd, std::size_t buffer_size = default_buffer_size);
+
+    JsonFdReader(const JsonFdReader&) = delete;
+    JsonFdReader& operator=(const JsonFdReader&) = delete;
+
+    // Read until the descriptor would block or reports end of input,
+    // parsing as the bytes arrive; completed values queue on parser().
+    // Complete means end of input, at which point the parser has been
+    // finished. Fails with the parser's error, or with the errno of a
+    // failed read (in std::generic_category()).
+    Result<JsonIoStatus> read();
+
+    JsonStreamParser& parser() noexcept { return parser_; }
+    int fd() const noexcept { return fd_; }
+
+    // Bytes read so far
+    std::size_t bytes_read() const noexcept { return bytes_read_; }
+
+private:
+    int fd_;
+    std::size_t buffer_size_;
+    std::unique_ptr<char[]> buffer_;
+    JsonStreamParser parser_;
+    std::size_t bytes_read_ = 0;
+    bool finished_ = false;
+};
+
+// Writes a value to a descriptor through a JsonStreamSerializer
+class JsonFdSender {
+public:
+    static constexpr std::size_t default_chunk_size = 16 * 1024;
+
+    JsonFdSender(int fd, JsonRef<JsonValue> value,
+                 const JsonSerializeOptions& options = JsonSerializeOptions(),
+                 std::size_t chunk_size = default_chunk_size);
+
+    JsonFdSender(const JsonFdSender&) = delete;
+    JsonFdSender& operator=(const JsonFdSender&) = delete;
+
+    // Write until the descriptor would block or the whole value is sent.
+    // Fails with the errno of a failed write (in std::generic_category());
+    // on a socket whose peer has gone, that needs SIGPIPE to be ignored.
+    Result<JsonIoStatus> send();
+
+    bool done() const noexcept { return serializer_.done(); }
+    std::size_t bytes_sent() const noexcept { return serializer_.bytes_consumed(); }
+    int fd() const noexcept { return fd_; }
+
+private:
+    int fd_;
+    std::size_t chunk_size_;
+    JsonStreamSerializer serializer_;
+};
+
+} // namespace jansson
+
+#endif // JSON_ASYNC_HPP
@@ -0,0 +1,626 @@
+#include "json_binary.hpp"
+#include "json_builder.hpp"
+#include "json_shape.hpp"
+#include "json_simd.hpp"
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace jansson {
+
+namespace {
+
+// Write the low `bytes` bytes of value, most significant first
+void write_big_endian(JsonWriter& writer, std::uint64_t value, int bytes) {
+    char buffer[8];
+    for (int i = bytes - 1; i >= 0; --i) {
+        buffer[i] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+    writer.write(buffer, static_cast<std::size_t>(bytes));
+}
+
+// Whether a double survives a round trip through a float
+bool fits_float(double value) noexcept {
+    return std::isfinite(value) && std::fabs(value) <= FLT_MAX &&
+           static_cast<double>(static_cast<float>(value)) == value;
+}
+
+std::uint32_t float_bits(double value) noexcept {
+    float narrow = static_cast<float>(value);
+    std::uint32_t bits;
+    std::memcpy(&bits, &narrow, sizeof(bits));
+    return bits;
+}
+
+std::uint64_t double_bits(double value) noexcept {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// CBOR: an initial byte with major type and argument, followed by the
+// argument's big-endian bytes when it does not fit in the low five bits
+void cbor_head(JsonWriter& writer, int major, std::uint64_t argument) {
+    char type = static_cast<char>(major << 5);
+    if (argument < 24) {
+        writer.put(static_cast<char>(type | argument));
+    } else if (argument <= 0xff) {
+        writer.put(static_cast<char>(type | 24));
+        write_big_endian(writer, argument, 1);
+    } else if (argument <= 0xffff) {
+        writer.put(static_cast<char>(type | 25));
+        write_big_endian(writer, argument, 2);
+    } else if (argument <= 0xffffffff) {
+        writer.put(static_cast<char>(type | 26));
+        write_big_endian(writer, argument, 4);
+    } else {
+        writer.put(static_cast<char>(type | 27));
+        write_big_endian(writer, argument, 8);
+    }
+}
+
+void cbor_value(JsonWriter& writer, const JsonValue& value) {
+    switch (value.type()) {
+        case JsonType::Null:
+            writer.put(static_cast<char>(0xf6));
+            break;
+        case JsonType::Boolean:
+            writer.put(static_cast<char>(static_cast<const JsonBoolean&>(value).value() ? 0xf5 : 0xf4));
+            break;
+        case JsonType::Number: {
+            const auto& number = static_cast<const JsonNumber&>(value);
+            if (number.is_integer()) {
+                std::int64_t integer = number.integer();
+                if (integer >= 0) {
+                    cbor_head(writer, 0, static_cast<std::uint64_t>(integer));
+                } else {
+                    // -1 - n, computed without overflow for INT64_MIN
+                    cbor_head(writer, 1, ~static_cast<std::uint64_t>(integer));
+                }
+            } else if (fits_float(number.real())) {
+                writer.put(static_cast<char>(0xfa));
+                write_big_endian(writer, float_bits(number.real()), 4);
+            } else {
+                writer.put(static_cast<char>(0xfb));
+                write_big_endian(writer, double_bits(number.real()), 8);
+            }
+            break;
+        }
+        case JsonType::String: {
+            std::string_view text = static_cast<const JsonStringValue&>(value).view();
+            cbor_head(writer, 3, text.size());
+            writer.write(text);
+            break;
+        }
+        case JsonType::Array: {
+            const auto& array = static_cast<const JsonArray&>(value);
+            cbor_head(writer, 4, array.size());
+            for (const auto& element : array) {
+                cbor_value(writer, *element);
+            }
+            break;
+        }
+        case JsonType::Object: {
+            const auto& members = static_cast<const JsonObject&>(value).values();
+            cbor_head(writer, 5, members.size());
+            for (const auto& member : members) {
+                cbor_head(writer, 3, member.first.size());
+                writer.write(member.first.view());
+                cbor_value(writer, *member.second);
+            }
+            break;
+        }
+    }
+}
+
+// MessagePack: fixed-size prefixes for small lengths, then 8/16/32-bit
+// length forms selected by the given type bytes (0 when a form does not
+// exist for that kind)
+void msgpack_length(JsonWriter& writer, std::size_t length, unsigned fix_base, std::size_t fix_limit,
+                    unsigned type8, unsigned type16, unsigned type32) {
+    if (length < fix_limit) {
+        writer.put(static_cast<char>(fix_base | length));
+    } else if (type8 != 0 && length <= 0xff) {
+        writer.put(static_cast<char>(type8));
+        write_big_endian(writer, length, 1);
+    } else if (length <= 0xffff) {
+        writer.put(static_cast<char>(type16));
+        write_big_endian(writer, length, 2);
+    } else if (length <= 0xffffffff) {
+        writer.put(static_cast<char>(type32));
+        write_big_endian(writer, length, 4);
+    } else {
+        throw JsonException("Value too large for MessagePack");
+    }
+}
+
+void msgpack_string(JsonWriter& writer, std::string_view text) {
+    msgpack_length(writer, text.size(), 0xa0, 32, 0xd9, 0xda, 0xdb);
+    writer.write(text);
+}
+
+void msgpack_integer(JsonWriter& writer, std::int64_t integer) {
+    if (integer >= 0) {
+        auto value = static_cast<std::uint64_t>(integer);
+        if (value < 0x80) {
+            writer.put(static_cast<char>(value));
+        } else if (value <= 0xff) {
+            writer.put(static_cast<char>(0xcc));
+            write_big_endian(writer, value, 1);
+        } else if (value <= 0xffff) {
+            writer.put(static_cast<char>(0xcd));
+            write_big_endian(writer, value, 2);
+        } else if (value <= 0xffffffff) {
+            writer.put(static_cast<char>(0xce));
+            write_big_endian(writer, value, 4);
+        } else {
+            writer.put(static_cast<char>(0xcf));
+            write_big_endian(writer, value, 8);
+        }
+    } else if (integer >= -32) {
+        writer.put(static_cast<char>(integer));
+    } else if (integer >= INT8_MIN) {
+        writer.put(static_cast<char>(0xd0));
+        write_big_endian(writer, static_cast<std::uint64_t>(integer), 1);
+    } else if (integer >= INT16_MIN) {
+        writer.put(static_cast<char>(0xd1));
+        write_big_endian(writer, static_cast<std::uint64_t>(integer), 2);
+    } else if (integer >= INT32_MIN) {
+        writer.put(static_cast<char>(0xd2));
+        write_big_endian(writer, static_cast<std::uint64_t>(integer), 4);
+    } else {
+        writer.put(static_cast<char>(0xd3));
+        write_big_endian(writer, static_cast<std::uint64_t>(integer), 8);
+    }
+}
+
+void msgpack_value(JsonWriter& writer, const JsonValue& value) {
+    switch (value.type()) {
+        case JsonType::Null:
+            writer.put(static_cast<char>(0xc0));
+            break;
+        case JsonType::Boolean:
+            writer.put(static_cast<char>(static_cast<const JsonBoolean&>(value).value() ? 0xc3 : 0xc2));
+            break;
+        case JsonType::Number: {
+            const auto& number = static_cast<const JsonNumber&>(value);
+            if (number.is_integer()) {
+                msgpack_integer(writer, number.integer());
+            } else if (fits_float(number.real())) {
+                writer.put(static_cast<char>(0xca));
+                write_big_endian(writer, float_bits(number.real()), 4);
+            } else {
+                writer.put(static_cast<char>(0xcb));
+                write_big_endian(writer, double_bits(number.real()), 8);
+            }
+            break;
+        }
+        case JsonType::String:
+            msgpack_string(writer, static_cast<const JsonStringValue&>(value).view());
+            break;
+        case JsonType::Array: {
+            const auto& array = static_cast<const JsonArray&>(value);
+            msgpack_length(writer, array.size(), 0x90, 16, 0, 0xdc, 0xdd);
+            for (const auto& element : array) {
+                msgpack_value(writer, *element);
+            }
+            break;
+        }
+        case JsonType::Object: {
+            const auto& members = static_cast<const JsonObject&>(value).values();
+            msgpack_length(writer, members.size(), 0x80, 16, 0, 0xde, 0xdf);
+            for (const auto& member : members) {
+                msgpack_string(writer, member.first.view());
+                msgpack_value(writer, *member.second);
+            }
+            break;
+        }
+    }
+}
+
+// Decoding failure, carrying the code parse() reports
+struct BinaryError {
+    JsonErrorCode code;
+};
+
+[[noreturn]] void fail(JsonErrorCode code = JsonErrorCode::ParseError) {
+    throw BinaryError{code};
+}
+
+class BinaryDecoder {
+public:
+    BinaryDecoder(std::string_view input, const JsonParseOptions& options)
+        : input_(input), arena_(options.arena), borrow_strings_(options.borrow_strings),
+          builder_(options.arena) {
+        if (options.intern_keys) {
+            keys_ = options.key_table ? options.key_table : &local_keys_;
+        }
+        if (options.share_shapes) {
+            shapes_ = options.shape_table ? options.shape_table : &local_shapes_;
+        }
+    }
+
+    bool at_end() const noexcept { return position_ == input_.size(); }
+
+    JsonRef<JsonValue> cbor_value(std::size_t depth);
+    JsonRef<JsonValue> msgpack_value(std::size_t depth);
+
+private:
+    std::uint8_t byte() {
+        if (position_ >= input_.size()) {
+            fail();
+        }
+        return static_cast<std::uint8_t>(input_[position_++]);
+    }
+
+    std::uint64_t big_endian(int bytes) {
+        if (input_.size() - position_ < static_cast<std::size_t>(bytes)) {
+            fail();
+        }
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value = (value << 8) | static_cast<std::uint8_t>(input_[position_++]);
+        }
+        return value;
+    }
+
+    std::string_view bytes(std::uint64_t length) {
+        if (input_.size() - position_ < length) {
+            fail();
+        }
+        std::string_view text = input_.substr(position_, static_cast<std::size_t>(length));
+        position_ += static_cast<std::size_t>(length);
+        return text;
+    }
+
+    std::string_view text(std::uint64_t length) {
+        std::string_view view = bytes(length);
+        if (!simd::validate_utf8(view)) {
+            fail(JsonErrorCode::InvalidUTF8);
+        }
+        return view;
+    }
+
+    // A container's elements each take at least one byte, which bounds
+    // the reservations a hostile length can cause
+    void check_count(std::uint64_t count, std::uint64_t bytes_per_element) {
+        if (count > (input_.size() - position_) / bytes_per_element) {
+            fail();
+        }
+    }
+
+    JsonRef<JsonValue> make_string(std::string_view view) {
+        if (borrow_strings_) {
+            return make_value_in<JsonStringValue>(arena_, view, JsonStringValue::borrowed);
+        }
+        return make_value_in<JsonStringValue>(arena_, view);
+    }
+
+    JsonRef<JsonValue> make_integer(std::uint64_t value, bool negative) {
+        // CBOR negatives are -1 - value
+        if (value > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+            double real = static_cast<double>(value);
+            return make_value_in<JsonNumber>(arena_, negative ? -1.0 - real : real);
+        }
+        auto integer = static_cast<std::int64_t>(value);
+        return make_value_in<JsonNumber>(arena_, negative ? -1 - integer : integer);
+    }
+
+    JsonRef<JsonValue> make_real(double value) {
+        return make_value_in<JsonNumber>(arena_, value);
+    }
+
+    JsonKey make_key(std::string_view view) {
+        return keys_ ? keys_->intern(view) : JsonKey(view);
+    }
+
+    JsonRef<JsonValue> finish_object(JsonBuilder::Mark mark) {
+        auto object = builder_.finish_object(mark);
+        if (shapes_ && !object->empty()) {
+            shapes_->assign(*object);
+        }
+        return object;
+    }
+
+    std::uint64_t cbor_argument(std::uint8_t info);
+    std::string cbor_chunked_text();
+    JsonKey cbor_key();
+
+    std::string_view input_;
+    std::size_t position_ = 0;
+    JsonArena* arena_;
+    bool borrow_strings_;
+    JsonBuilder builder_;
+    JsonKeyTable local_keys_;
+    JsonKeyTable* keys_ = nullptr;
+    JsonShapeTable local_shapes_;
+    JsonShapeTable* shapes_ = nullptr;
+};
+
+std::uint64_t BinaryDecoder::cbor_argument(std::uint8_t info) {
+    if (info < 24) {
+        return info;
+    }
+    switch (info) {
+        case 24: return big_endian(1);
+        case 25: return big_endian(2);
+        case 26: return big_endian(4);
+        case 27: return big_endian(8);
+        default: fail();
+    }
+}
+
+// Contents of an indefinite-length text string: definite-length text
+// chunks up to a break byte
+std::string BinaryDecoder::cbor_chunked_text() {
+    std::string result;
+    for (;;) {
+        std::uint8_t initial = byte();
+        if (initial == 0xff) {
+            return result;
+        }
+        if ((initial >> 5) != 3 || (initial & 0x1f) == 31) {
+            fail();
+        }
+        std::string_view chunk = text(cbor_argument(initial & 0x1f));
+        result.append(chunk.data(), chunk.size());
+    }
+}
+
+JsonKey BinaryDecoder::cbor_key() {
+    std::uint8_t initial = byte();
+    while ((initial >> 5) == 6) {
+        cbor_argument(initial & 0x1f);
+        initial = byte();
+    }
+    if ((initial >> 5) != 3) {
+        fail(JsonErrorCode::InvalidType);
+    }
+    if ((initial & 0x1f) == 31) {
+        return make_key(cbor_chunked_text());
+    }
+    return make_key(text(cbor_argument(initial & 0x1f)));
+}
+
+JsonRef<JsonValue> BinaryDecoder::cbor_value(std::size_t depth) {
+    std::uint8_t initial = byte();
+    int major = initial >> 5;
+    std::uint8_t info = initial & 0x1f;
+    bool indefinite = info == 31;
+
+    switch (major) {
+        case 0:
+            return make_integer(cbor_argument(info), false);
+        case 1:
+            return make_integer(cbor_argument(info), true);
+        case 2:
+            fail(JsonErrorCode::InvalidType);
+        case 3:
+            if (indefinite) {
+                return make_value_in<JsonStringValue>(arena_, cbor_chunked_text());
+            }
+            return make_string(text(cbor_argument(info)));
+        case 4:
+        case 5: {
+            if (depth >= JsonBinaryParser::max_depth) {
+                fail();
+            }
+            auto mark = builder_.mark();
+            auto add_item = [&]() {
+                if (major == 5) {
+                    JsonKey key = cbor_key();
+                    builder_.add(std::move(key), cbor_value(depth + 1));
+                } else {
+                    builder_.add(cbor_value(depth + 1));
+                }
+            };
+            if (indefinite) {
+                // Items up to a break byte
+                while (position_ >= input_.size() || static_cast<std::uint8_t>(input_[position_]) != 0xff) {
+                    add_item();
+                }
+                position_++;
+            } else {
+                std::uint64_t count = cbor_argument(info);
+                check_count(count, major == 5 ? 2 : 1);
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    add_item();
+                }
+            }
+            if (major == 5) {
+                return finish_object(mark);
+            }
+            return builder_.finish_array(mark);
+        }
+        case 6:
+            // Tags only annotate the value that follows
+            cbor_argument(info);
+            return cbor_value(depth);
+        default:
+            break;
+    }
+
+    switch (info) {
+        case 20:
+            return make_value_in<JsonBoolean>(arena_, false);
+        case 21:
+            return make_value_in<JsonBoolean>(arena_, true);
+        case 22:
+        case 23:
+            return make_value_in<JsonNull>(arena_);
+        case 25: {
+            // IEEE 754 half precision
+            auto half = static_cast<std::uint32_t>(big_endian(2));
+            int exponent = (half >> 10) & 0x1f;
+            double mantissa = half & 0x3ff;
+            double value;
+            if (exponent == 0) {
+                value = std::ldexp(mantissa, -24);
+            } else if (exponent == 31) {
+                value = mantissa == 0 ? HUGE_VAL : NAN;
+            } else {
+                value = std::ldexp(mantissa + 1024, exponent - 25);
+            }
+            return make_real(half & 0x8000 ? -value : value);
+        }
+        case 26: {
+            auto bits = static_cast<std::uint32_t>(big_endian(4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return make_real(value);
+        }
+        case 27: {
+            std::uint64_t bits = big_endian(8);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return make_real(value);
+        }
+        default:
+            fail();
+    }
+}
+
+JsonRef<JsonValue> BinaryDecoder::msgpack_value(std::size_t depth) {
+    std::uint8_t initial = byte();
+
+    if (initial < 0x80) {
+        return make_integer(initial, false);
+    }
+    if (initial >= 0xe0) {
+        return make_value_in<JsonNumber>(arena_, static_cast<std::int64_t>(static_cast<std::int8_t>(initial)));
+    }
+    if ((initial & 0xe0) == 0xa0) {
+        return make_string(text(initial & 0x1f));
+    }
+
+    std::uint64_t count = 0;
+    bool is_map = false;
+    if ((initial & 0xf0) == 0x90) {
+        count = initial & 0x0f;
+    } else if ((initial & 0xf0) == 0x80) {
+        count = initial & 0x0f;
+        is_map = true;
+    } else {
+        switch (initial) {
+            case 0xc0:
+                return make_value_in<JsonNull>(arena_);
+            case 0xc2:
+                return make_value_in<JsonBoolean>(arena_, false);
+            case 0xc3:
+                return make_value_in<JsonBoolean>(arena_, true);
+            case 0xca: {
+                auto bits = static_cast<std::uint32_t>(big_endian(4));
+                float value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return make_real(value);
+            }
+            case 0xcb: {
+                std::uint64_t bits = big_endian(8);
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return make_real(value);
+            }
+            case 0xcc: return make_integer(big_endian(1), false);
+            case 0xcd: return make_integer(big_endian(2), false);
+            case 0xce: return make_integer(big_endian(4), false);
+            case 0xcf: return make_integer(big_endian(8), false);
+            case 0xd0:
+                return make_value_in<JsonNumber>(arena_, static_cast<std::int64_t>(static_cast<std::int8_t>(big_endian(1))));
+            case 0xd1:
+                return make_value_in<JsonNumber>(arena_, static_cast<std::int64_t>(static_cast<std::int16_t>(big_endian(2))));
+            case 0xd2:
+                return make_value_in<JsonNumber>(arena_, static_cast<std::int64_t>(static_cast<std::int32_t>(big_endian(4))));
+            case 0xd3:
+                return make_value_in<JsonNumber>(arena_, static_cast<std::int64_t>(big_endian(8)));
+            case 0xd9: return make_string(text(big_endian(1)));
+            case 0xda: return make_string(text(big_endian(2)));
+            case 0xdb: return make_string(text(big_endian(4)));
+            case 0xdc: count = big_endian(2); break;
+            case 0xdd: count = big_endian(4); break;
+            case 0xde: count = big_endian(2); is_map = true; break;
+            case 0xdf: count = big_endian(4); is_map = true; break;
+            case 0xc1:
+                fail();
+            default:
+                // bin, ext and fixext
+                fail(JsonErrorCode::InvalidType);
+        }
+    }
+
+    if (depth >= JsonBinaryParser::max_depth) {
+        fail();
+    }
+    check_count(count, is_map ? 2 : 1);
+    auto mark = builder_.mark();
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (is_map) {
+            std::uint8_t key_type = byte();
+            std::uint64_t length;
+            if ((key_type & 0xe0) == 0xa0) {
+                length = key_type & 0x1f;
+            } else if (key_type == 0xd9) {
+                length = big_endian(1);
+            } else if (key_type == 0xda) {
+                length = big_endian(2);
+            } else if (key_type == 0xdb) {
+                length = big_endian(4);
+            } else {
+                fail(JsonErrorCode::InvalidType);
+            }
+            JsonKey key = make_key(text(length));
+            builder_.add(std::move(key), msgpack_value(depth + 1));
+        } else {
+            builder_.add(msgpack_value(depth + 1));
+        }
+    }
+    if (is_map) {
+        return finish_object(mark);
+    }
+    return builder_.finish_array(mark);
+}
+
+} // namespace
+
+// JsonBinarySerializer implementation
+std::string JsonBinarySerializer::serialize(const JsonValue& value, JsonBinaryFormat format) {
+    JsonStringWriter writer;
+    serialize(writer, value, format);
+    return writer.take();
+}
+
+void JsonBinarySerializer::serialize(JsonWriter& writer, const JsonValue& value, JsonBinaryFormat format) {
+    if (format == JsonBinaryFormat::Cbor) {
+        cbor_value(writer, value);
+    } else {
+        msgpack_value(writer, value);
+    }
+}
+
+// JsonBinaryParser implementation
+Result<JsonRef<JsonValue>> JsonBinaryParser::parse(std::string_view input, JsonBinaryFormat format) {
+    return parse(input, format, JsonParseOptions());
+}
+
+Result<JsonRef<JsonValue>> JsonBinaryParser::parse(std::string_view input, JsonBinaryFormat format,
+                                                   const JsonParseOptions& options) {
+    try {
+        BinaryDecoder decoder(input, options);
+        JsonRef<JsonValue> result = format == JsonBinaryFormat::Cbor ? decoder.cbor_value(0)
+                                                                     : decoder.msgpack_value(0);
+        if (!decoder.at_end()) {
+            return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::ParseError));
+        }
+        return Result<JsonRef<JsonValue>>(std::move(result));
+    } catch (const BinaryError& e) {
+        return Result<JsonRef<JsonValue>>(make_error_code(e.code));
+    } catch (const JsonException&) {
+        return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::ParseError));
+    } catch (...) {
+        return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::UnknownError));
+    }
+}
+
+} // namespace jansson
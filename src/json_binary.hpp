@@ -0,0 +1,55 @@
+#ifndef JSON_BINARY_HPP
+#define JSON_BINARY_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_writer.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+// Binary encodings of the JSON data model
+enum class JsonBinaryFormat {
+    Cbor,           // RFC 8949
+    MessagePack
+};
+
+// Encodes a JsonValue tree as CBOR or MessagePack.
+//
+// Integers use the shortest encoding that holds them; reals are written as
+// 32-bit floats when that is exact and as 64-bit floats otherwise, so they
+// decode to the same double. Strings and keys are copied as they are, with
+// no escaping. Containers are always written with definite lengths.
+class JsonBinarySerializer {
+public:
+    static std::string serialize(const JsonValue& value, JsonBinaryFormat format);
+    static void serialize(JsonWriter& writer, const JsonValue& value, JsonBinaryFormat format);
+};
+
+// Decodes CBOR or MessagePack into a JsonValue tree.
+//
+// arena, borrow_strings (no string needs unescaping, so every string can
+// reference the input), intern_keys, key_table, share_shapes and
+// shape_table have the same meaning as for JsonParser; the other options
+// are ignored. Input must hold exactly one value; items that have no JSON
+// equivalent (byte strings, MessagePack extensions, CBOR maps with
+// non-string keys) are rejected with InvalidType, malformed strings with
+// InvalidUTF8 and anything else malformed with ParseError. CBOR tags are
+// skipped, and undefined decodes as null. Unsigned integers above
+// INT64_MAX decode as reals.
+class JsonBinaryParser {
+public:
+    // Containers nested deeper than this are rejected
+    static constexpr std::size_t max_depth = 1024;
+
+    static Result<JsonRef<JsonValue>> parse(std::string_view input, JsonBinaryFormat format);
+    static Result<JsonRef<JsonValue>> parse(std::string_view input, JsonBinaryFormat format,
+                                            const JsonParseOptions& options);
+};
+
+} // namespace jansson
+
+#endif // JSON_BINARY_HPP
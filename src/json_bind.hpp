@@ -0,0 +1,580 @@
+#ifndef JSON_BIND_HPP
+#define JSON_BIND_HPP
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "json_parser.hpp"
+#include "json_sax.hpp"
+#include "json_writer.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+// Member of a struct mapped with JSON_BIND: its JSON name and the data
+// member it is stored in
+template <typename Class, typename Member>
+struct JsonField {
+    std::string_view name;
+    Member Class::*member;
+};
+
+template <typename Class, typename Member>
+constexpr JsonField<Class, Member> json_field(std::string_view name, Member Class::*member) noexcept {
+    return JsonField<Class, Member>{name, member};
+}
+
+namespace bind_detail {
+
+class Reader;
+struct SinkOps;
+struct Frame;
+
+// Where the next decoded value goes: an object and the functions that
+// store each kind of event into it
+struct Sink {
+    void* target;
+    const SinkOps* ops;
+};
+
+// Each function returns false if the value does not fit the target. The
+// object and array functions push one frame for the container they accept.
+struct SinkOps {
+    bool (*null)(void* target);
+    bool (*boolean)(void* target, bool value);
+    bool (*integer)(void* target, std::int64_t value);
+    bool (*real)(void* target, double value);
+    bool (*string)(void* target, std::string_view value);
+    bool (*object)(Reader& reader, void* target);
+    bool (*array)(Reader& reader, void* target);
+};
+
+// An open object or array: key() sees each member name of an object and
+// element() gives the destination of every value inside the container
+struct FrameOps {
+    bool (*key)(Frame& frame, std::string_view key);
+    Sink (*element)(Frame& frame);
+};
+
+struct Frame {
+    void* target;
+    const FrameOps* ops;
+    Sink pending;       // Destination selected by the last key
+};
+
+// Accepts anything and stores nothing (members with no field)
+struct Skip {
+    static bool null(void*) noexcept { return true; }
+    static bool boolean(void*, bool) noexcept { return true; }
+    static bool integer(void*, std::int64_t) noexcept { return true; }
+    static bool real(void*, double) noexcept { return true; }
+    static bool string(void*, std::string_view) noexcept { return true; }
+    static bool object(Reader& reader, void*);
+    static bool array(Reader& reader, void*);
+    static bool key(Frame&, std::string_view) noexcept { return true; }
+    static Sink element(Frame& frame) noexcept;
+
+    static constexpr SinkOps sink_ops{&null, &boolean, &integer, &real, &string, &object, &array};
+    static constexpr FrameOps frame_ops{&key, &element};
+};
+
+// Parser events routed into a tree of typed targets
+class Reader final : public JsonHandler {
+public:
+    explicit Reader(Sink root) : root_(root) { frames_.reserve(16); }
+
+    // Open a container whose values are placed by ops
+    void push(void* target, const FrameOps* ops) {
+        frames_.push_back(Frame{target, ops, Sink{nullptr, &Skip::sink_ops}});
+    }
+
+    bool on_null() override {
+        Sink sink = next();
+        return sink.ops->null(sink.target);
+    }
+    bool on_boolean(bool value) override {
+        Sink sink = next();
+        return sink.ops->boolean(sink.target, value);
+    }
+    bool on_integer(std::int64_t value) override {
+        Sink sink = next();
+        return sink.ops->integer(sink.target, value);
+    }
+    bool on_real(double value) override {
+        Sink sink = next();
+        return sink.ops->real(sink.target, value);
+    }
+    bool on_string(std::string_view value) override {
+        Sink sink = next();
+        return sink.ops->string(sink.target, value);
+    }
+
+    bool on_start_object() override {
+        Sink sink = next();
+        return sink.ops->object(*this, sink.target);
+    }
+    bool on_key(std::string_view key) override {
+        Frame& frame = frames_.back();
+        return frame.ops->key(frame, key);
+    }
+    bool on_end_object(std::size_t) override {
+        frames_.pop_back();
+        return true;
+    }
+
+    bool on_start_array() override {
+        Sink sink = next();
+        return sink.ops->array(*this, sink.target);
+    }
+    bool on_end_array(std::size_t) override {
+        frames_.pop_back();
+        return true;
+    }
+
+private:
+    Sink next() {
+        if (frames_.empty()) {
+            return root_;
+        }
+        Frame& frame = frames_.back();
+        return frame.ops->element(frame);
+    }
+
+    Sink root_;
+    std::vector<Frame> frames_;
+};
+
+inline bool Skip::object(Reader& reader, void*) {
+    reader.push(nullptr, &frame_ops);
+    return true;
+}
+
+inline bool Skip::array(Reader& reader, void*) {
+    reader.push(nullptr, &frame_ops);
+    return true;
+}
+
+inline Sink Skip::element(Frame&) noexcept {
+    return Sink{nullptr, &sink_ops};
+}
+
+// Whether T has a JSON_BIND mapping (json_fields() is found by argument
+// dependent lookup, so the macro goes in the namespace of T)
+template <typename T, typename = void>
+struct is_bound : std::false_type {};
+
+template <typename T>
+struct is_bound<T, std::void_t<decltype(json_fields(static_cast<const T*>(nullptr)))>> : std::true_type {};
+
+} // namespace bind_detail
+
+// How values of type T are read and written. Specializations derive from
+// JsonBindingBase, whose read functions reject every value, hide the
+// reads that make sense for T and add write(). Provided for bool,
+// integers, floating point, std::string, std::optional, std::vector,
+// std::map with string keys and structs mapped with JSON_BIND.
+template <typename T, typename = void>
+struct JsonBinding;
+
+struct JsonBindingBase {
+    template <typename T>
+    static bool read_null(T&) noexcept { return false; }
+    template <typename T>
+    static bool read_boolean(T&, bool) noexcept { return false; }
+    template <typename T>
+    static bool read_integer(T&, std::int64_t) noexcept { return false; }
+    template <typename T>
+    static bool read_real(T&, double) noexcept { return false; }
+    template <typename T>
+    static bool read_string(T&, std::string_view) noexcept { return false; }
+    template <typename T>
+    static bool read_object(bind_detail::Reader&, T&) noexcept { return false; }
+    template <typename T>
+    static bool read_array(bind_detail::Reader&, T&) noexcept { return false; }
+};
+
+namespace bind_detail {
+
+// Type-erased entry points into JsonBinding<T>
+template <typename T>
+struct SinkFor {
+    static bool null(void* target) { return JsonBinding<T>::read_null(*static_cast<T*>(target)); }
+    static bool boolean(void* target, bool value) {
+        return JsonBinding<T>::read_boolean(*static_cast<T*>(target), value);
+    }
+    static bool integer(void* target, std::int64_t value) {
+        return JsonBinding<T>::read_integer(*static_cast<T*>(target), value);
+    }
+    static bool real(void* target, double value) {
+        return JsonBinding<T>::read_real(*static_cast<T*>(target), value);
+    }
+    static bool string(void* target, std::string_view value) {
+        return JsonBinding<T>::read_string(*static_cast<T*>(target), value);
+    }
+    static bool object(Reader& reader, void* target) {
+        return JsonBinding<T>::read_object(reader, *static_cast<T*>(target));
+    }
+    static bool array(Reader& reader, void* target) {
+        return JsonBinding<T>::read_array(reader, *static_cast<T*>(target));
+    }
+
+    static constexpr SinkOps ops{&null, &boolean, &integer, &real, &string, &object, &array};
+};
+
+template <typename T>
+Sink sink(T& target) noexcept {
+    return Sink{&target, &SinkFor<T>::ops};
+}
+
+} // namespace bind_detail
+
+template <>
+struct JsonBinding<bool> : JsonBindingBase {
+    static bool read_boolean(bool& target, bool value) noexcept {
+        target = value;
+        return true;
+    }
+
+    static void write(JsonWriter& writer, bool value) {
+        if (value) {
+            writer.write("true", 4);
+        } else {
+            writer.write("false", 5);
+        }
+    }
+};
+
+// Integers out of range of T are rejected
+template <typename T>
+struct JsonBinding<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> : JsonBindingBase {
+    static bool read_integer(T& target, std::int64_t value) noexcept {
+        if constexpr (std::is_signed_v<T>) {
+            if (value < static_cast<std::int64_t>(std::numeric_limits<T>::min()) ||
+                value > static_cast<std::int64_t>(std::numeric_limits<T>::max())) {
+                return false;
+            }
+        } else {
+            if (value < 0 || static_cast<std::uint64_t>(value) > std::numeric_limits<T>::max()) {
+                return false;
+            }
+        }
+        target = static_cast<T>(value);
+        return true;
+    }
+
+    static void write(JsonWriter& writer, T value) {
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        writer.write(buffer, static_cast<std::size_t>(result.ptr - buffer));
+    }
+};
+
+// Accepts integers too. Written in the shortest form that reads back as
+// the same T; non-finite values cannot be written.
+template <typename T>
+struct JsonBinding<T, std::enable_if_t<std::is_floating_point_v<T>>> : JsonBindingBase {
+    static bool read_integer(T& target, std::int64_t value) noexcept {
+        target = static_cast<T>(value);
+        return true;
+    }
+    static bool read_real(T& target, double value) noexcept {
+        target = static_cast<T>(value);
+        return true;
+    }
+
+    static void write(JsonWriter& writer, T value) {
+        if (!std::isfinite(value)) {
+            throw JsonException("Cannot encode a non-finite number");
+        }
+        char buffer[JsonNumber::max_formatted_length];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        writer.write(buffer, static_cast<std::size_t>(result.ptr - buffer));
+    }
+};
+
+template <>
+struct JsonBinding<std::string> : JsonBindingBase {
+    static bool read_string(std::string& target, std::string_view value) {
+        target.assign(value.data(), value.size());
+        return true;
+    }
+
+    static void write(JsonWriter& writer, const std::string& value) { writer.write_escaped(value); }
+};
+
+// null empties the optional; anything else is read into its value
+template <typename T>
+struct JsonBinding<std::optional<T>> : JsonBindingBase {
+    static bool read_null(std::optional<T>& target) {
+        target.reset();
+        return true;
+    }
+    static bool read_boolean(std::optional<T>& target, bool value) {
+        return JsonBinding<T>::read_boolean(slot(target), value);
+    }
+    static bool read_integer(std::optional<T>& target, std::int64_t value) {
+        return JsonBinding<T>::read_integer(slot(target), value);
+    }
+    static bool read_real(std::optional<T>& target, double value) {
+        return JsonBinding<T>::read_real(slot(target), value);
+    }
+    static bool read_string(std::optional<T>& target, std::string_view value) {
+        return JsonBinding<T>::read_string(slot(target), value);
+    }
+    static bool read_object(bind_detail::Reader& reader, std::optional<T>& target) {
+        return JsonBinding<T>::read_object(reader, slot(target));
+    }
+    static bool read_array(bind_detail::Reader& reader, std::optional<T>& target) {
+        return JsonBinding<T>::read_array(reader, slot(target));
+    }
+
+    static void write(JsonWriter& writer, const std::optional<T>& value) {
+        if (value) {
+            JsonBinding<T>::write(writer, *value);
+        } else {
+            writer.write("null", 4);
+        }
+    }
+
+private:
+    static T& slot(std::optional<T>& target) {
+        if (!target) {
+            target.emplace();
+        }
+        return *target;
+    }
+};
+
+// Elements are appended to the cleared vector, so its capacity is reused
+// when the same vector is decoded into again
+template <typename T, typename Allocator>
+struct JsonBinding<std::vector<T, Allocator>> : JsonBindingBase {
+    static_assert(!std::is_same_v<T, bool>, "std::vector<bool> cannot be bound");
+
+    static bool read_array(bind_detail::Reader& reader, std::vector<T, Allocator>& target) {
+        target.clear();
+        reader.push(&target, &frame_ops);
+        return true;
+    }
+
+    static void write(JsonWriter& writer, const std::vector<T, Allocator>& values) {
+        writer.write("[", 1);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) {
+                writer.write(", ", 2);
+            }
+            JsonBinding<T>::write(writer, values[i]);
+        }
+        writer.write("]", 1);
+    }
+
+private:
+    static bind_detail::Sink element(bind_detail::Frame& frame) {
+        auto& values = *static_cast<std::vector<T, Allocator>*>(frame.target);
+        values.emplace_back();
+        return bind_detail::sink(values.back());
+    }
+
+    static constexpr bind_detail::FrameOps frame_ops{&bind_detail::Skip::key, &element};
+};
+
+// Objects with arbitrary member names
+template <typename T, typename Compare, typename Allocator>
+struct JsonBinding<std::map<std::string, T, Compare, Allocator>> : JsonBindingBase {
+    using Map = std::map<std::string, T, Compare, Allocator>;
+
+    static bool read_object(bind_detail::Reader& reader, Map& target) {
+        target.clear();
+        reader.push(&target, &frame_ops);
+        return true;
+    }
+
+    static void write(JsonWriter& writer, const Map& values) {
+        writer.write("{", 1);
+        bool first = true;
+        for (const auto& member : values) {
+            if (!first) {
+                writer.write(", ", 2);
+            }
+            first = false;
+            writer.write_escaped(member.first);
+            writer.write(": ", 2);
+            JsonBinding<T>::write(writer, member.second);
+        }
+        writer.write("}", 1);
+    }
+
+private:
+    static bool key(bind_detail::Frame& frame, std::string_view key) {
+        auto& values = *static_cast<Map*>(frame.target);
+        frame.pending = bind_detail::sink(values[std::string(key)]);
+        return true;
+    }
+
+    static bind_detail::Sink element(bind_detail::Frame& frame) { return frame.pending; }
+
+    static constexpr bind_detail::FrameOps frame_ops{&key, &element};
+};
+
+// Structs mapped with JSON_BIND. Members without a field are skipped and
+// fields without a member keep their value.
+template <typename T>
+struct JsonBinding<T, std::enable_if_t<bind_detail::is_bound<T>::value>> : JsonBindingBase {
+    static bool read_object(bind_detail::Reader& reader, T& target) {
+        reader.push(&target, &frame_ops);
+        return true;
+    }
+
+    static void write(JsonWriter& writer, const T& value) {
+        static constexpr auto fields = json_fields(static_cast<const T*>(nullptr));
+        writer.write("{", 1);
+        write_fields(writer, value, fields, std::make_index_sequence<std::tuple_size_v<decltype(fields)>>());
+        writer.write("}", 1);
+    }
+
+private:
+    template <typename Fields, std::size_t... I>
+    static void write_fields(JsonWriter& writer, const T& value, const Fields& fields, std::index_sequence<I...>) {
+        ((I > 0 ? writer.write(", ", 2) : void(),
+          writer.write_escaped(std::get<I>(fields).name),
+          writer.write(": ", 2),
+          write_member(writer, value.*(std::get<I>(fields).member))), ...);
+    }
+
+    template <typename Member>
+    static void write_member(JsonWriter& writer, const Member& member) {
+        JsonBinding<Member>::write(writer, member);
+    }
+
+    static bool key(bind_detail::Frame& frame, std::string_view key) {
+        static constexpr auto fields = json_fields(static_cast<const T*>(nullptr));
+        T& object = *static_cast<T*>(frame.target);
+        frame.pending = bind_detail::Sink{nullptr, &bind_detail::Skip::sink_ops};
+        std::apply([&](const auto&... field) {
+            ((key == field.name ? (frame.pending = bind_detail::sink(object.*(field.member)), true) : false) || ...);
+        }, fields);
+        return true;
+    }
+
+    static bind_detail::Sink element(bind_detail::Frame& frame) { return frame.pending; }
+
+    static constexpr bind_detail::FrameOps frame_ops{&key, &element};
+};
+
+// Decode JSON text directly into C++ objects, and encode them directly
+// to a writer, with no JsonValue tree in between.
+//
+//     struct Order { std::string id; int quantity; std::vector<double> prices; };
+//     JSON_BIND(Order, id, quantity, prices)
+//
+//     auto order = JsonBinder::decode<Order>(text);
+//     std::string json = JsonBinder::encode(order.value());
+//
+// A value that does not fit its target (a string for an int field, an
+// integer out of the field's range, an array for a struct) fails with
+// InvalidType; malformed input fails as it does for JsonParser.
+class JsonBinder {
+public:
+    // Decode into an existing object, reusing the capacity of its strings
+    // and vectors. On failure target may be partly written.
+    template <typename T>
+    static Result<bool> decode(std::string_view input, T& target) {
+        bind_detail::Reader reader(bind_detail::sink(target));
+        auto result = JsonParser::parse(input, reader);
+        if (!result) {
+            return result;
+        }
+        if (!result.value()) {
+            return Result<bool>(make_error_code(JsonErrorCode::InvalidType));
+        }
+        return Result<bool>(true);
+    }
+
+    // Decode into a value-initialized T
+    template <typename T>
+    static Result<T> decode(std::string_view input) {
+        T target{};
+        auto result = decode(input, target);
+        if (!result) {
+            return Result<T>(result.error());
+        }
+        return Result<T>(std::move(target));
+    }
+
+    // Compact output, formatted like JsonSerializer's
+    template <typename T>
+    static void encode(JsonWriter& writer, const T& value) {
+        JsonBinding<T>::write(writer, value);
+    }
+
+    template <typename T>
+    static std::string encode(const T& value) {
+        JsonStringWriter writer;
+        encode(writer, value);
+        return writer.take();
+    }
+};
+
+} // namespace jansson
+
+// Map the listed data members of Type to JSON members of the same names
+// (up to 24). Use in the namespace that declares Type:
+//
+//     JSON_BIND(Order, id, quantity, prices)
+//
+// For other names, define json_fields() there directly:
+//
+//     constexpr auto json_fields(const Order*) noexcept {
+//         return std::make_tuple(jansson::json_field("order-id", &Order::id));
+//     }
+#define JSON_BIND(Type, ...)                                                          \
+    [[maybe_unused]] constexpr auto json_fields(const Type*) noexcept {               \
+        return ::std::make_tuple(JSON_BIND_EXPAND(JSON_BIND_CAT(JSON_BIND_FIELDS_,     \
+            JSON_BIND_COUNT(__VA_ARGS__))(Type, __VA_ARGS__)));                        \
+    }
+
+#define JSON_BIND_EXPAND(x) x
+#define JSON_BIND_CAT(a, b) JSON_BIND_CAT_(a, b)
+#define JSON_BIND_CAT_(a, b) a##b
+#define JSON_BIND_COUNT(...)                                                          \
+    JSON_BIND_EXPAND(JSON_BIND_PICK(__VA_ARGS__, 24, 23, 22, 21, 20, 19, 18, 17, 16,   \
+                                    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define JSON_BIND_PICK(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14,    \
+                       _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, N, ...) N
+#define JSON_BIND_FIELD(T, m) ::jansson::json_field(#m, &T::m)
+#define JSON_BIND_FIELDS_1(T, m) JSON_BIND_FIELD(T, m)
+#define JSON_BIND_FIELDS_2(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_1(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_3(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_2(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_4(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_3(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_5(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_4(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_6(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_5(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_7(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_6(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_8(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_7(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_9(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_8(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_10(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_9(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_11(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_10(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_12(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_11(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_13(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_12(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_14(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_13(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_15(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_14(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_16(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_15(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_17(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_16(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_18(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_17(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_19(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_18(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_20(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_19(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_21(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_20(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_22(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_21(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_23(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_22(T, __VA_ARGS__))
+#define JSON_BIND_FIELDS_24(T, m, ...) JSON_BIND_FIELD(T, m), JSON_BIND_EXPAND(JSON_BIND_FIELDS_23(T, __VA_ARGS__))
+
+#endif // JSON_BIND_HPP
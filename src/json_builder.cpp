@@ -0,0 +1,51 @@
+#include "json_builder.hpp"
+#include <iterator>
+
+namespace jansson {
+
+JsonRef<JsonArray> JsonBuilder::finish_array(Mark mark) {
+    if (mark.values > values_.size() || mark.keys != keys_.size()) {
+        throw JsonException("JsonBuilder: array finished out of order");
+    }
+    
+    auto first = values_.begin() + static_cast<std::ptrdiff_t>(mark.values);
+    JsonValueVector storage(memory_resource_of(arena_));
+    storage.reserve(static_cast<std::size_t>(values_.end() - first));
+    storage.insert(storage.end(), std::make_move_iterator(first), std::make_move_iterator(values_.end()));
+    values_.erase(first, values_.end());
+    return make_value_in<JsonArray>(arena_, std::move(storage));
+}
+
+JsonRef<JsonObject> JsonBuilder::finish_object(Mark mark) {
+    if (mark.keys > keys_.size() || mark.values > values_.size() ||
+        keys_.size() - mark.keys != values_.size() - mark.values) {
+        throw JsonException("JsonBuilder: object finished out of order");
+    }
+    
+    auto object = make_value_in<JsonObject>(arena_, memory_resource_of(arena_));
+    object->reserve(keys_.size() - mark.keys);
+    for (std::size_t i = mark.keys, j = mark.values; i < keys_.size(); ++i, ++j) {
+        object->set(std::move(keys_[i]), std::move(values_[j]));
+    }
+    keys_.erase(keys_.begin() + static_cast<std::ptrdiff_t>(mark.keys), keys_.end());
+    values_.erase(values_.begin() + static_cast<std::ptrdiff_t>(mark.values), values_.end());
+    return object;
+}
+
+JsonRef<JsonArray> JsonBuilder::array(std::vector<JsonRef<JsonValue>> values, JsonArena* arena) {
+    JsonValueVector storage(memory_resource_of(arena));
+    storage.reserve(values.size());
+    storage.insert(storage.end(), std::make_move_iterator(values.begin()),
+                   std::make_move_iterator(values.end()));
+    return make_value_in<JsonArray>(arena, std::move(storage));
+}
+
+JsonRef<JsonObject> JsonBuilder::object(std::vector<std::pair<JsonKey, JsonRef<JsonValue>>> members,
+                                        JsonArena* arena) {
+    auto object = make_value_in<JsonObject>(arena, memory_resource_of(arena));
+    object->insert_range(std::make_move_iterator(members.begin()),
+                         std::make_move_iterator(members.end()));
+    return object;
+}
+
+} // namespace jansson
@@ -0,0 +1,80 @@
+#ifndef JSON_BUILDER_HPP
+#define JSON_BUILDER_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "json_key.hpp"
+#include "json_value.hpp"
+#include "memory_policy.hpp"
+
+namespace jansson {
+
+// Builds arrays and objects whose size is only known once they are
+// complete, allocating each container exactly once.
+//
+// Elements and members are pushed onto scratch stacks; finishing a
+// container moves everything above its mark into storage allocated at
+// the final size and pops it. Containers nest: start an inner one by
+// taking a mark, finish it, then add the result to the outer one. The
+// stacks keep their capacity, so one builder reused for a whole document
+// (as the parser does) stops allocating scratch space after the first
+// few containers.
+class JsonBuilder {
+public:
+    // Stack depths at the start of a container
+    struct Mark {
+        std::size_t values;
+        std::size_t keys;
+    };
+    
+    // Containers are allocated from arena when given
+    explicit JsonBuilder(JsonArena* arena = nullptr) noexcept : arena_(arena) {}
+    
+    JsonArena* arena() const noexcept { return arena_; }
+    void set_arena(JsonArena* arena) noexcept { arena_ = arena; }
+    
+    Mark mark() const noexcept { return Mark{values_.size(), keys_.size()}; }
+    
+    // Add an array element
+    void add(JsonRef<JsonValue> value) {
+        values_.push_back(std::move(value));
+    }
+    
+    // Add an object member
+    void add(JsonKey key, JsonRef<JsonValue> value) {
+        keys_.push_back(std::move(key));
+        values_.push_back(std::move(value));
+    }
+    
+    // Pop the elements added since mark into a new array
+    JsonRef<JsonArray> finish_array(Mark mark);
+    
+    // Pop the members added since mark into a new object. A repeated key
+    // keeps its last value, as with JsonObject::set.
+    JsonRef<JsonObject> finish_object(Mark mark);
+    
+    // Drop everything pushed so far, keeping the scratch capacity
+    void clear() noexcept {
+        values_.clear();
+        keys_.clear();
+    }
+
+    // Values the scratch stack holds without growing
+    std::size_t capacity() const noexcept { return values_.capacity(); }
+    
+    // Build a container from a complete list by moving its elements
+    static JsonRef<JsonArray> array(std::vector<JsonRef<JsonValue>> values,
+                                    JsonArena* arena = nullptr);
+    static JsonRef<JsonObject> object(std::vector<std::pair<JsonKey, JsonRef<JsonValue>>> members,
+                                      JsonArena* arena = nullptr);
+
+private:
+    JsonArena* arena_;
+    std::vector<JsonRef<JsonValue>> values_;
+    std::vector<JsonKey> keys_;
+};
+
+} // namespace jansson
+
+#endif // JSON_BUILDER_HPP
@@ -1,81 +1,191 @@
 #include "json_c_api.hpp"
 #include "json_value.hpp"
 #include "json_parser.hpp"
+#include "json_stream.hpp"
 #include "json_serializer.hpp"
 #include "json_error.hpp"
+#include "json_writer.hpp"
+#include "json_pack.hpp"
+#include "json_stats.hpp"
+#include "memory_policy.hpp"
 #include "string_utils.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <memory>
+#include <new>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
-// Opaque json_t structure
-typedef struct json_t {
-    std::shared_ptr<jansson::JsonValue> value;
-} json_t;
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// A json_t is the node itself: the pointers the C API hands out are
+// JsonValue pointers, so accessors return borrowed references without
+// allocating, and the node's own count tracks the references C callers hold.
+namespace {
+
+jansson::JsonValue* node_of(json_t* json) {
+    return reinterpret_cast<jansson::JsonValue*>(json);
+}
+
+const jansson::JsonValue* node_of(const json_t* json) {
+    return reinterpret_cast<const jansson::JsonValue*>(json);
+}
+
+// Borrowed reference: valid while the node is held elsewhere
+json_t* borrow(const jansson::JsonValue* value) {
+    return reinterpret_cast<json_t*>(const_cast<jansson::JsonValue*>(value));
+}
+
+// New reference, owned by the caller and dropped by json_delete
+json_t* give(jansson::JsonRef<jansson::JsonValue> value) {
+    return reinterpret_cast<json_t*>(value.detach());
+}
+
+// Take over a reference passed to a _new function
+jansson::JsonRef<jansson::JsonValue> steal(json_t* value) {
+    return jansson::JsonRef<jansson::JsonValue>(node_of(value), jansson::JsonRef<jansson::JsonValue>::adopt);
+}
+
+// Parser options selected by json_load* flags
+jansson::JsonParseOptions load_options(size_t flags) {
+    jansson::JsonParseOptions options;
+    options.allow_trailing_data = (flags & JSON_DISABLE_EOF_CHECK) != 0;
+    return options;
+}
+
+// Error code reported for a failed load
+json_error_code load_error(const std::error_code& error) {
+    if (error == jansson::make_error_code(jansson::JsonErrorCode::InvalidUTF8)) {
+        return JSON_ERROR_INVALID_UTF8;
+    }
+    if (error == jansson::make_error_code(jansson::JsonErrorCode::LimitExceeded)) {
+        return JSON_ERROR_LIMIT_EXCEEDED;
+    }
+    return JSON_ERROR_PARSE_ERROR;
+}
+
+// Serializer options selected by json_dump* flags
+jansson::JsonSerializeOptions dump_options(size_t flags) {
+    jansson::JsonSerializeOptions options;
+    options.indent = static_cast<int>(flags & JSON_MAX_INDENT);
+    options.pretty_print = options.indent > 0;
+    options.compact = (flags & JSON_COMPACT) != 0;
+    options.sort_keys = (flags & JSON_SORT_KEYS) != 0;
+    options.canonical = (flags & JSON_CANONICAL) != 0;
+    options.real_precision = static_cast<int>((flags >> 11) & 0x1F);
+    return options;
+}
+
+// json_free is not told the size, so stats builds keep it in a header in
+// front of each block
+constexpr size_t malloc_header = jansson::json_stats_enabled ? alignof(std::max_align_t) : 0;
+
+} // namespace
 
 // Memory management
 void* json_malloc(size_t size) {
-    return ::operator new(size);
+    if (size > SIZE_MAX - malloc_header) {
+        return nullptr;
+    }
+    
+    try {
+        char* block = static_cast<char*>(jansson::allocate_memory(size + malloc_header));
+        if (malloc_header != 0) {
+            std::memcpy(block, &size, sizeof(size));
+        }
+        return block + malloc_header;
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
 }
 
 void json_free(void* ptr) {
-    ::operator delete(ptr);
+    if (!ptr) {
+        return;
+    }
+    
+    char* block = static_cast<char*>(ptr) - malloc_header;
+    size_t size = 0;
+    if (malloc_header != 0) {
+        std::memcpy(&size, block, sizeof(size));
+    }
+    jansson::deallocate_memory(block, size + malloc_header);
+}
+
+void json_set_alloc_funcs(json_malloc_t malloc_fn, json_free_t free_fn) {
+    jansson::set_allocation_functions(malloc_fn, free_fn);
+}
+
+void json_get_alloc_funcs(json_malloc_t* malloc_fn, json_free_t* free_fn) {
+    jansson::get_allocation_functions(malloc_fn, free_fn);
 }
 
 // JSON value creation and destruction
 json_t* json_null() {
-    json_t* json = new json_t;
-    json->value = jansson::JsonNull::create();
-    return json;
+    return give(jansson::JsonNull::create());
 }
 
 json_t* json_boolean(int value) {
-    json_t* json = new json_t;
-    json->value = jansson::JsonBoolean::create(value != 0);
-    return json;
+    return give(jansson::JsonBoolean::create(value != 0));
 }
 
 json_t* json_number(double value) {
-    json_t* json = new json_t;
-    json->value = jansson::JsonNumber::create(value);
-    return json;
+    return give(jansson::JsonNumber::create(value));
+}
+
+json_t* json_integer(json_int_t value) {
+    return give(jansson::JsonNumber::create(static_cast<int64_t>(value)));
+}
+
+json_t* json_real(double value) {
+    return give(jansson::JsonNumber::create(value));
 }
 
 json_t* json_string(const char* value) {
     if (!value) {
         return nullptr;
     }
-    json_t* json = new json_t;
-    json->value = jansson::JsonStringValue::create(value);
-    return json;
+    return give(jansson::JsonStringValue::create(value));
 }
 
 json_t* json_array() {
-    json_t* json = new json_t;
-    json->value = jansson::JsonArray::create();
-    return json;
+    return give(jansson::JsonArray::create());
 }
 
 json_t* json_object() {
-    json_t* json = new json_t;
-    json->value = jansson::JsonObject::create();
+    return give(jansson::JsonObject::create());
+}
+
+json_t* json_incref(json_t* json) {
+    if (json) {
+        node_of(json)->retain();
+    }
     return json;
 }
 
-void json_delete(json_t* json) {
+void json_decref(json_t* json) {
     if (json) {
-        delete json;
+        node_of(json)->release();
     }
 }
 
+void json_delete(json_t* json) {
+    json_decref(json);
+}
+
 // Type checking
 json_type json_typeof(const json_t* json) {
-    if (!json || !json->value) {
+    if (!json) {
         return JSON_NULL;
     }
     
-    switch (json->value->type()) {
+    switch (node_of(json)->type()) {
         case jansson::JsonType::Null: return JSON_NULL;
         case jansson::JsonType::Boolean: return JSON_BOOLEAN;
         case jansson::JsonType::Number: return JSON_NUMBER;
@@ -87,103 +197,132 @@ json_type json_typeof(const json_t* json) {
 }
 
 int json_is_null(const json_t* json) {
-    return json && json->value && json->value->is_null();
+    return json && node_of(json)->is_null();
 }
 
 int json_is_boolean(const json_t* json) {
-    return json && json->value && json->value->is_boolean();
+    return json && node_of(json)->is_boolean();
 }
 
 int json_is_number(const json_t* json) {
-    return json && json->value && json->value->is_number();
+    return json && node_of(json)->is_number();
+}
+
+int json_is_integer(const json_t* json) {
+    return json && node_of(json)->is_integer();
+}
+
+int json_is_real(const json_t* json) {
+    return json && node_of(json)->is_real();
 }
 
 int json_is_string(const json_t* json) {
-    return json && json->value && json->value->is_string();
+    return json && node_of(json)->is_string();
 }
 
 int json_is_array(const json_t* json) {
-    return json && json->value && json->value->is_array();
+    return json && node_of(json)->is_array();
 }
 
 int json_is_object(const json_t* json) {
-    return json && json->value && json->value->is_object();
+    return json && node_of(json)->is_object();
 }
 
 // Value access
 int json_boolean_value(const json_t* json) {
-    if (!json || !json->value || !json->value->is_boolean()) {
+    if (!json || !node_of(json)->is_boolean()) {
         return 0;
     }
-    return json->value->boolean_value() ? 1 : 0;
+    return node_of(json)->boolean_value() ? 1 : 0;
 }
 
 double json_number_value(const json_t* json) {
-    if (!json || !json->value || !json->value->is_number()) {
+    if (!json || !node_of(json)->is_number()) {
+        return 0.0;
+    }
+    return node_of(json)->number_value();
+}
+
+json_int_t json_integer_value(const json_t* json) {
+    if (!json || !node_of(json)->is_number()) {
+        return 0;
+    }
+    return static_cast<json_int_t>(node_of(json)->integer_value());
+}
+
+double json_real_value(const json_t* json) {
+    if (!json || !node_of(json)->is_real()) {
         return 0.0;
     }
-    return json->value->number_value();
+    return node_of(json)->number_value();
 }
 
 const char* json_string_value(const json_t* json) {
-    if (!json || !json->value || !json->value->is_string()) {
+    if (!json || !node_of(json)->is_string()) {
         return nullptr;
     }
-    return json->value->string_value().c_str();
+    return node_of(json)->string_value().c_str();
 }
 
 size_t json_array_size(const json_t* json) {
-    if (!json || !json->value || !json->value->is_array()) {
+    if (!json || !node_of(json)->is_array()) {
         return 0;
     }
-    return static_cast<const jansson::JsonArray*>(json->value.get())->size();
+    return static_cast<const jansson::JsonArray*>(node_of(json))->size();
 }
 
 json_t* json_array_get(const json_t* json, size_t index) {
-    if (!json || !json->value || !json->value->is_array()) {
+    if (!json || !node_of(json)->is_array()) {
         return nullptr;
     }
     
-    try {
-        auto value = static_cast<const jansson::JsonArray*>(json->value.get())->at(index);
-        json_t* result = new json_t;
-        result->value = value;
-        return result;
-    } catch (...) {
+    const auto& values = static_cast<const jansson::JsonArray*>(node_of(json))->values();
+    if (index >= values.size()) {
         return nullptr;
     }
+    return borrow(values[index].get());
 }
 
 size_t json_object_size(const json_t* json) {
-    if (!json || !json->value || !json->value->is_object()) {
+    if (!json || !node_of(json)->is_object()) {
         return 0;
     }
-    return static_cast<const jansson::JsonObject*>(json->value.get())->size();
+    return static_cast<const jansson::JsonObject*>(node_of(json))->size();
 }
 
 json_t* json_object_get(const json_t* json, const char* key) {
-    if (!json || !json->value || !json->value->is_object() || !key) {
+    if (!key) {
         return nullptr;
     }
-    
-    auto value = static_cast<const jansson::JsonObject*>(json->value.get())->get(key);
-    if (!value) {
+    return json_object_getn(json, key, std::strlen(key));
+}
+
+json_t* json_object_getn(const json_t* json, const char* key, size_t key_len) {
+    if (!json || !node_of(json)->is_object() || !key) {
         return nullptr;
     }
     
-    json_t* result = new json_t;
-    result->value = value;
-    return result;
+    const auto& values = static_cast<const jansson::JsonObject*>(node_of(json))->values();
+    auto it = values.find(std::string_view(key, key_len));
+    if (it == values.end()) {
+        return nullptr;
+    }
+    return borrow(it->second.get());
 }
 
 // Array operations
 int json_array_append(json_t* json, json_t* value) {
-    if (!json || !json->value || !json->value->is_array() || !value || !value->value) {
+    return json_array_append_new(json, json_incref(value));
+}
+
+int json_array_append_new(json_t* json, json_t* value) {
+    auto stolen = steal(value);
+    if (!json || !node_of(json)->is_array() || !stolen || value == json) {
         return JSON_ERROR_INVALID_ARGUMENT;
     }
     
     try {
-        static_cast<jansson::JsonArray*>(json->value.get())->push_back(value->value);
+        static_cast<jansson::JsonArray*>(node_of(json))->push_back(std::move(stolen));
         return JSON_ERROR_SUCCESS;
     } catch (...) {
         return JSON_ERROR_MEMORY_ALLOCATION_FAILED;
@@ -191,12 +330,17 @@ int json_array_append(json_t* json, json_t* value) {
 }
 
 int json_array_insert(json_t* json, json_t* value, size_t index) {
-    if (!json || !json->value || !json->value->is_array() || !value || !value->value) {
+    return json_array_insert_new(json, json_incref(value), index);
+}
+
+int json_array_insert_new(json_t* json, json_t* value, size_t index) {
+    auto stolen = steal(value);
+    if (!json || !node_of(json)->is_array() || !stolen || value == json) {
         return JSON_ERROR_INVALID_ARGUMENT;
     }
     
     try {
-        static_cast<jansson::JsonArray*>(json->value.get())->insert(index, value->value);
+        static_cast<jansson::JsonArray*>(node_of(json))->insert(index, std::move(stolen));
         return JSON_ERROR_SUCCESS;
     } catch (...) {
         return JSON_ERROR_MEMORY_ALLOCATION_FAILED;
@@ -204,12 +348,12 @@ int json_array_insert(json_t* json, json_t* value, size_t index) {
 }
 
 int json_array_remove(json_t* json, size_t index) {
-    if (!json || !json->value || !json->value->is_array()) {
+    if (!json || !node_of(json)->is_array()) {
         return JSON_ERROR_INVALID_ARGUMENT;
     }
     
     try {
-        static_cast<jansson::JsonArray*>(json->value.get())->remove(index);
+        static_cast<jansson::JsonArray*>(node_of(json))->remove(index);
         return JSON_ERROR_SUCCESS;
     } catch (const std::out_of_range&) {
         return JSON_ERROR_INDEX_OUT_OF_BOUNDS;
@@ -219,12 +363,12 @@ int json_array_remove(json_t* json, size_t index) {
 }
 
 int json_array_clear(json_t* json) {
-    if (!json || !json->value || !json->value->is_array()) {
+    if (!json || !node_of(json)->is_array()) {
         return JSON_ERROR_INVALID_ARGUMENT;
     }
     
     try {
-        static_cast<jansson::JsonArray*>(json->value.get())->clear();
+        static_cast<jansson::JsonArray*>(node_of(json))->clear();
         return JSON_ERROR_SUCCESS;
     } catch (...) {
         return JSON_ERROR_UNKNOWN_ERROR;
@@ -233,12 +377,29 @@ int json_array_clear(json_t* json) {
 
 // Object operations
 int json_object_set(json_t* json, const char* key, json_t* value) {
-    if (!json || !json->value || !json->value->is_object() || !key || !value || !value->value) {
+    return json_object_set_new(json, key, json_incref(value));
+}
+
+int json_object_set_new(json_t* json, const char* key, json_t* value) {
+    if (!key) {
+        json_decref(value);
+        return JSON_ERROR_INVALID_ARGUMENT;
+    }
+    return json_object_setn_new(json, key, std::strlen(key), value);
+}
+
+int json_object_setn(json_t* json, const char* key, size_t key_len, json_t* value) {
+    return json_object_setn_new(json, key, key_len, json_incref(value));
+}
+
+int json_object_setn_new(json_t* json, const char* key, size_t key_len, json_t* value) {
+    auto stolen = steal(value);
+    if (!json || !node_of(json)->is_object() || !key || !stolen || value == json) {
         return JSON_ERROR_INVALID_ARGUMENT;
     }
     
     try {
-        static_cast<jansson::JsonObject*>(json->value.get())->set(key, value->value);
+        static_cast<jansson::JsonObject*>(node_of(json))->set(std::string_view(key, key_len), std::move(stolen));
         return JSON_ERROR_SUCCESS;
     } catch (...) {
         return JSON_ERROR_MEMORY_ALLOCATION_FAILED;
@@ -246,12 +407,19 @@ int json_object_set(json_t* json, const char* key, json_t* value) {
 }
 
 int json_object_del(json_t* json, const char* key) {
-    if (!json || !json->value || !json->value->is_object() || !key) {
+    if (!key) {
+        return JSON_ERROR_INVALID_ARGUMENT;
+    }
+    return json_object_deln(json, key, std::strlen(key));
+}
+
+int json_object_deln(json_t* json, const char* key, size_t key_len) {
+    if (!json || !node_of(json)->is_object() || !key) {
         return JSON_ERROR_INVALID_ARGUMENT;
     }
     
     try {
-        static_cast<jansson::JsonObject*>(json->value.get())->erase(key);
+        static_cast<jansson::JsonObject*>(node_of(json))->erase(std::string_view(key, key_len));
         return JSON_ERROR_SUCCESS;
     } catch (...) {
         return JSON_ERROR_UNKNOWN_ERROR;
@@ -259,18 +427,117 @@ int json_object_del(json_t* json, const char* key) {
 }
 
 int json_object_clear(json_t* json) {
-    if (!json || !json->value || !json->value->is_object()) {
+    if (!json || !node_of(json)->is_object()) {
         return JSON_ERROR_INVALID_ARGUMENT;
     }
     
     try {
-        static_cast<jansson::JsonObject*>(json->value.get())->clear();
+        static_cast<jansson::JsonObject*>(node_of(json))->clear();
         return JSON_ERROR_SUCCESS;
     } catch (...) {
         return JSON_ERROR_UNKNOWN_ERROR;
     }
 }
 
+void json_object_seed(size_t seed) {
+    jansson::set_hash_seed(seed);
+}
+
+// Object iterators point at the member's entry in the object's storage
+using ObjectEntry = jansson::JsonObjectMap::value_type;
+
+static ObjectEntry* entry_of(void* iter) {
+    return static_cast<ObjectEntry*>(iter);
+}
+
+static jansson::JsonObject* object_of(json_t* json) {
+    if (!json || !node_of(json)->is_object()) {
+        return nullptr;
+    }
+    return static_cast<jansson::JsonObject*>(node_of(json));
+}
+
+// Position of iter in object, or the size if it is not a member's entry
+static size_t entry_index(const jansson::JsonObject& object, void* iter) {
+    const ObjectEntry* entries = object.values().empty() ? nullptr : &*object.values().begin();
+    const ObjectEntry* entry = entry_of(iter);
+    if (!entries || entry < entries || entry >= entries + object.size()) {
+        return object.size();
+    }
+    return static_cast<size_t>(entry - entries);
+}
+
+void* json_object_iter(json_t* json) {
+    jansson::JsonObject* object = object_of(json);
+    if (!object || object->empty()) {
+        return nullptr;
+    }
+    return const_cast<ObjectEntry*>(&*object->values().begin());
+}
+
+void* json_object_iter_at(json_t* json, const char* key) {
+    jansson::JsonObject* object = object_of(json);
+    if (!object || !key) {
+        return nullptr;
+    }
+    const auto& values = object->values();
+    auto found = values.find(std::string_view(key));
+    if (found == values.end()) {
+        return nullptr;
+    }
+    return const_cast<ObjectEntry*>(&*found);
+}
+
+void* json_object_iter_next(json_t* json, void* iter) {
+    jansson::JsonObject* object = object_of(json);
+    if (!object || !iter) {
+        return nullptr;
+    }
+    size_t index = entry_index(*object, iter);
+    if (index + 1 >= object->size()) {
+        return nullptr;
+    }
+    return entry_of(iter) + 1;
+}
+
+void* json_object_iter_check(json_t* json, void* iter) {
+    jansson::JsonObject* object = object_of(json);
+    if (!object || !iter || entry_index(*object, iter) == object->size()) {
+        return nullptr;
+    }
+    return iter;
+}
+
+const char* json_object_iter_key(void* iter) {
+    return iter ? entry_of(iter)->first.c_str() : nullptr;
+}
+
+size_t json_object_iter_key_len(void* iter) {
+    return iter ? entry_of(iter)->first.size() : 0;
+}
+
+json_t* json_object_iter_value(void* iter) {
+    return iter ? borrow(entry_of(iter)->second.get()) : nullptr;
+}
+
+int json_object_iter_set(json_t* json, void* iter, json_t* value) {
+    return json_object_iter_set_new(json, iter, json_incref(value));
+}
+
+int json_object_iter_set_new(json_t* json, void* iter, json_t* value) {
+    auto stolen = steal(value);
+    jansson::JsonObject* object = object_of(json);
+    if (!object || !iter || !stolen) {
+        return JSON_ERROR_INVALID_ARGUMENT;
+    }
+    size_t index = entry_index(*object, iter);
+    if (index == object->size()) {
+        return JSON_ERROR_INVALID_ARGUMENT;
+    }
+    object->set_slot(index, std::move(stolen));
+    return JSON_ERROR_SUCCESS;
+}
+
 // Parsing
 json_t* json_loads(const char* input, size_t flags, json_error_code* error) {
     if (!input) {
@@ -279,22 +546,30 @@ json_t* json_loads(const char* input, size_t flags, json_error_code* error) {
         }
         return nullptr;
     }
+    return json_loadb(input, std::strlen(input), flags, error);
+}
+
+json_t* json_loadb(const char* buffer, size_t buflen, size_t flags, json_error_code* error) {
+    if (!buffer && buflen > 0) {
+        if (error) {
+            *error = JSON_ERROR_INVALID_ARGUMENT;
+        }
+        return nullptr;
+    }
     
     try {
-        auto result = jansson::JsonParser::parse(input);
+        auto result = jansson::JsonParser::parse(std::string_view(buffer, buflen), load_options(flags));
         if (!result) {
             if (error) {
-                *error = JSON_ERROR_PARSE_ERROR;
+                *error = load_error(result.error());
             }
             return nullptr;
         }
         
-        json_t* json = new json_t;
-        json->value = result.value();
         if (error) {
             *error = JSON_ERROR_SUCCESS;
         }
-        return json;
+        return give(result.value());
     } catch (...) {
         if (error) {
             *error = JSON_ERROR_PARSE_ERROR;
@@ -303,24 +578,295 @@ json_t* json_loads(const char* input, size_t flags, json_error_code* error) {
     }
 }
 
-// Serialization
-char* json_dumps(const json_t* json, size_t flags) {
-    if (!json || !json->value) {
+json_t* json_loads_ex(const char* input, size_t flags, json_error_t* error) {
+    // A null input is rejected by json_loadb_ex whatever its length
+    return json_loadb_ex(input, input ? std::strlen(input) : 1, flags, error);
+}
+
+json_t* json_loadb_ex(const char* buffer, size_t buflen, size_t flags, json_error_t* error) {
+    json_error_t ignored;
+    if (!error) {
+        error = &ignored;
+    }
+    *error = json_error_t{};
+    if (!buffer && buflen > 0) {
+        error->code = JSON_ERROR_INVALID_ARGUMENT;
+        std::snprintf(error->text, sizeof(error->text), "%s", json_error_text(error->code));
+        return nullptr;
+    }
+    
+    try {
+        jansson::JsonParseError failure;
+        auto result = jansson::JsonParser::parse(std::string_view(buffer, buflen), load_options(flags), failure);
+        if (!result) {
+            error->code = load_error(result.error());
+            error->line = static_cast<int>(failure.line);
+            error->column = static_cast<int>(failure.column);
+            error->position = static_cast<int>(failure.position);
+            std::snprintf(error->text, sizeof(error->text), "%s", failure.message.c_str());
+            return nullptr;
+        }
+        
+        error->code = JSON_ERROR_SUCCESS;
+        return give(result.value());
+    } catch (...) {
+        error->code = JSON_ERROR_PARSE_ERROR;
+        std::snprintf(error->text, sizeof(error->text), "%s", json_error_text(error->code));
+        return nullptr;
+    }
+}
+
+json_t* json_loadb_next(const char* buffer, size_t buflen, size_t* consumed, size_t flags, json_error_code* error) {
+    if ((!buffer && buflen > 0) || !consumed) {
+        if (error) {
+            *error = JSON_ERROR_INVALID_ARGUMENT;
+        }
         return nullptr;
     }
     
     try {
-        std::string result = jansson::JsonSerializer::serialize(*json->value);
-        char* buffer = static_cast<char*>(json_malloc(result.size() + 1));
-        if (!buffer) {
+        auto result = jansson::JsonParser::parse_first(std::string_view(buffer, buflen), load_options(flags), *consumed);
+        if (!result) {
+            if (error) {
+                *error = load_error(result.error());
+            }
+            return nullptr;
+        }
+        
+        if (error) {
+            *error = JSON_ERROR_SUCCESS;
+        }
+        return give(result.value());
+    } catch (...) {
+        if (error) {
+            *error = JSON_ERROR_PARSE_ERROR;
+        }
+        return nullptr;
+    }
+}
+
+json_t* json_load_file(const char* path, size_t flags, json_error_code* error) {
+    if (!path) {
+        if (error) {
+            *error = JSON_ERROR_INVALID_ARGUMENT;
+        }
+        return nullptr;
+    }
+    
+    try {
+        auto result = jansson::JsonParser::parse_file(path, load_options(flags));
+        if (!result) {
+            if (error) {
+                *error = result.error() == jansson::make_error_code(jansson::JsonErrorCode::InvalidArgument)
+                    ? JSON_ERROR_INVALID_ARGUMENT
+                    : JSON_ERROR_PARSE_ERROR;
+            }
+            return nullptr;
+        }
+        
+        if (error) {
+            *error = JSON_ERROR_SUCCESS;
+        }
+        return give(result.value());
+    } catch (...) {
+        if (error) {
+            *error = JSON_ERROR_UNKNOWN_ERROR;
+        }
+        return nullptr;
+    }
+}
+
+json_t* json_load_callback(json_load_callback_t callback, void* data, size_t flags, json_error_code* error) {
+    if (!callback) {
+        if (error) {
+            *error = JSON_ERROR_INVALID_ARGUMENT;
+        }
+        return nullptr;
+    }
+    
+    try {
+        // Without the EOF check, reading stops once the first value is
+        // complete and anything after it is ignored
+        bool check_eof = (flags & JSON_DISABLE_EOF_CHECK) == 0;
+        jansson::JsonStreamParser parser(load_options(flags));
+        char buffer[64 * 1024];
+        while (check_eof || !parser.has_value()) {
+            size_t length = callback(buffer, sizeof(buffer), data);
+            if (length == static_cast<size_t>(-1)) {
+                if (error) {
+                    *error = JSON_ERROR_INVALID_ARGUMENT;
+                }
+                return nullptr;
+            }
+            if (length == 0) {
+                break;
+            }
+            auto fed = parser.feed(std::string_view(buffer, length));
+            if (!check_eof && parser.has_value()) {
+                break;
+            }
+            if (!fed || parser.value_count() > 1) {
+                if (error) {
+                    *error = fed ? JSON_ERROR_PARSE_ERROR : load_error(fed.error());
+                }
+                return nullptr;
+            }
+        }
+        
+        if (check_eof || !parser.has_value()) {
+            auto finished = parser.finish();
+            if (!finished) {
+                if (error) {
+                    *error = load_error(finished.error());
+                }
+                return nullptr;
+            }
+        }
+        bool complete = check_eof ? parser.value_count() == 1 : parser.has_value();
+        if (!complete) {
+            if (error) {
+                *error = JSON_ERROR_PARSE_ERROR;
+            }
             return nullptr;
         }
-        std::copy(result.begin(), result.end(), buffer);
-        buffer[result.size()] = '\0';
-        return buffer;
+        
+        if (error) {
+            *error = JSON_ERROR_SUCCESS;
+        }
+        return give(parser.take_value());
     } catch (...) {
+        if (error) {
+            *error = JSON_ERROR_UNKNOWN_ERROR;
+        }
+        return nullptr;
+    }
+}
+
+static size_t read_file(void* buffer, size_t buflen, void* data) {
+    FILE* input = static_cast<FILE*>(data);
+    size_t length = std::fread(buffer, 1, buflen, input);
+    if (length == 0 && std::ferror(input)) {
+        return static_cast<size_t>(-1);
+    }
+    return length;
+}
+
+static size_t read_fd(void* buffer, size_t buflen, void* data) {
+    int fd = *static_cast<int*>(data);
+#if defined(_WIN32)
+    int length = _read(fd, buffer, static_cast<unsigned>(buflen));
+#else
+    ssize_t length = read(fd, buffer, buflen);
+#endif
+    if (length < 0) {
+        return static_cast<size_t>(-1);
+    }
+    return static_cast<size_t>(length);
+}
+
+json_t* json_loadf(FILE* input, size_t flags, json_error_code* error) {
+    if (!input) {
+        if (error) {
+            *error = JSON_ERROR_INVALID_ARGUMENT;
+        }
         return nullptr;
     }
+    return json_load_callback(read_file, input, flags, error);
+}
+
+json_t* json_loadfd(int input, size_t flags, json_error_code* error) {
+    if (input < 0) {
+        if (error) {
+            *error = JSON_ERROR_INVALID_ARGUMENT;
+        }
+        return nullptr;
+    }
+    return json_load_callback(read_fd, &input, flags, error);
+}
+
+// Serialization
+
+// Writer that grows a json_malloc block, so json_dumps can return the
+// buffer it serialized into instead of copying a finished std::string
+namespace {
+class MallocWriter : public jansson::JsonWriter {
+public:
+    MallocWriter() {
+        data_ = allocate(capacity_);
+        set_buffer(data_, data_, data_ + capacity_);
+    }
+
+    ~MallocWriter() override {
+        json_free(data_);
+    }
+
+    // Terminate the output and hand the block to the caller
+    char* release() {
+        put('\0');
+        if (truncated()) {
+            return nullptr;
+        }
+        char* data = data_;
+        data_ = nullptr;
+        return data;
+    }
+
+protected:
+    bool grow(std::size_t needed) override {
+        std::size_t used = buffered();
+        std::size_t capacity = capacity_ * 2;
+        while (capacity < used + needed) {
+            capacity *= 2;
+        }
+        char* data = allocate(capacity);
+        std::memcpy(data, data_, used);
+        json_free(data_);
+        data_ = data;
+        capacity_ = capacity;
+        set_buffer(data_, data_ + used, data_ + capacity_);
+        return true;
+    }
+
+private:
+    static char* allocate(std::size_t size) {
+        char* data = static_cast<char*>(json_malloc(size));
+        if (!data) {
+            throw std::bad_alloc();
+        }
+        return data;
+    }
+    
+    std::size_t capacity_ = 256;
+    char* data_;
+};
+} // namespace
+
+char* json_dumps(const json_t* json, size_t flags) {
+    if (!json) {
+        return nullptr;
+    }
+    
+    try {
+        MallocWriter writer;
+        jansson::JsonSerializer::serialize(writer, *node_of(json), dump_options(flags));
+        return writer.release();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+size_t json_dumpb(const json_t* json, char* buffer, size_t size, size_t flags) {
+    if (!json || (!buffer && size > 0)) {
+        return 0;
+    }
+    
+    try {
+        jansson::JsonBufferWriter writer(buffer, size);
+        jansson::JsonSerializer::serialize(writer, *node_of(json), dump_options(flags));
+        return writer.size();
+    } catch (...) {
+        return 0;
+    }
 }
 
 void json_dumps_free(char* json) {
@@ -329,6 +875,560 @@ void json_dumps_free(char* json) {
     }
 }
 
+int json_dump_callback(const json_t* json, json_dump_callback_t callback, void* data, size_t flags) {
+    if (!json || !callback) {
+        return -1;
+    }
+    
+    try {
+        jansson::JsonCallbackWriter writer([callback, data](const char* buffer, std::size_t size) {
+            return callback(buffer, size, data) == 0;
+        });
+        jansson::JsonSerializer::serialize(writer, *node_of(json), dump_options(flags));
+        writer.flush();
+        return writer.failed() ? -1 : 0;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int json_dumpf(const json_t* json, FILE* output, size_t flags) {
+    if (!json || !output) {
+        return -1;
+    }
+    
+    try {
+        jansson::JsonFileWriter writer(output);
+        jansson::JsonSerializer::serialize(writer, *node_of(json), dump_options(flags));
+        writer.flush();
+        return writer.failed() ? -1 : 0;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int json_dumpfd(const json_t* json, int output, size_t flags) {
+    if (!json || output < 0) {
+        return -1;
+    }
+    
+    try {
+        jansson::JsonFdWriter writer(output);
+        jansson::JsonSerializer::serialize(writer, *node_of(json), dump_options(flags));
+        writer.flush();
+        return writer.failed() ? -1 : 0;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int json_dump_file(const json_t* json, const char* path, size_t flags) {
+    if (!json || !path) {
+        return -1;
+    }
+    
+    FILE* output = std::fopen(path, "wb");
+    if (!output) {
+        return -1;
+    }
+    int result = json_dumpf(json, output, flags);
+    if (std::fclose(output) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+// Packing and unpacking
+namespace {
+
+// Failure while packing or unpacking, reported as code
+struct PackError {
+    json_error_code code;
+};
+
+// Reads one format character at a time, skipping separators
+class FormatScanner {
+public:
+    explicit FormatScanner(const char* format) noexcept : pos_(format) {}
+    
+    char peek() const noexcept {
+        const char* pos = pos_;
+        while (jansson::pack_detail::is_separator(*pos)) {
+            ++pos;
+        }
+        return *pos;
+    }
+    
+    char next() noexcept {
+        while (jansson::pack_detail::is_separator(*pos_)) {
+            ++pos_;
+        }
+        char c = *pos_;
+        if (c) {
+            ++pos_;
+        }
+        return c;
+    }
+
+private:
+    const char* pos_;
+};
+
+std::string_view checked_utf8(std::string_view text) {
+    if (!jansson::JsonString::is_valid_utf8(text)) {
+        throw PackError{JSON_ERROR_INVALID_UTF8};
+    }
+    return text;
+}
+
+class Packer {
+public:
+    Packer(const char* format, va_list* args) noexcept : format_(format), args_(args) {}
+    
+    jansson::JsonRef<jansson::JsonValue> pack() {
+        jansson::JsonRef<jansson::JsonValue> value = pack_value(format_.next());
+        if (!value || format_.peek() != '\0') {
+            throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+        }
+        return value;
+    }
+
+private:
+    // Null only for an omitted s*, o* or O* value
+    jansson::JsonRef<jansson::JsonValue> pack_value(char type) {
+        switch (type) {
+            case '{':
+                return pack_object();
+            case '[':
+                return pack_array();
+            case 's': {
+                char modifier = optional_modifier();
+                std::string buffer;
+                const char* text = nullptr;
+                std::string_view string = read_string(modifier != '\0', text, buffer);
+                if (!text) {
+                    return null_for(modifier);
+                }
+                return jansson::make_value<jansson::JsonStringValue>(string);
+            }
+            case 'n':
+                return jansson::JsonNull::create();
+            case 'b':
+                return jansson::JsonBoolean::create(va_arg(*args_, int) != 0);
+            case 'i':
+                return jansson::JsonNumber::create(static_cast<int64_t>(va_arg(*args_, int)));
+            case 'I':
+                return jansson::JsonNumber::create(static_cast<int64_t>(va_arg(*args_, json_int_t)));
+            case 'f': {
+                double value = va_arg(*args_, double);
+                if (!std::isfinite(value)) {
+                    throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+                }
+                return jansson::JsonNumber::create(value);
+            }
+            case 'o':
+            case 'O': {
+                json_t* json = va_arg(*args_, json_t*);
+                char modifier = optional_modifier();
+                if (!json) {
+                    return null_for(modifier);
+                }
+                return type == 'o' ? steal(json) : jansson::JsonRef<jansson::JsonValue>(node_of(json));
+            }
+            default:
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+        }
+    }
+    
+    jansson::JsonRef<jansson::JsonValue> pack_object() {
+        auto object = jansson::JsonObject::create();
+        for (char c = format_.next(); c != '}'; c = format_.next()) {
+            if (c != 's') {
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+            }
+            std::string buffer;
+            const char* text = nullptr;
+            std::string_view key = read_string(false, text, buffer);
+            jansson::JsonRef<jansson::JsonValue> value = pack_value(format_.next());
+            if (value) {
+                object->set(key, std::move(value));
+            }
+        }
+        return object;
+    }
+    
+    jansson::JsonRef<jansson::JsonValue> pack_array() {
+        auto array = jansson::JsonArray::create();
+        for (char c = format_.next(); c != ']'; c = format_.next()) {
+            if (c == '\0') {
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+            }
+            jansson::JsonRef<jansson::JsonValue> value = pack_value(c);
+            if (value) {
+                array->push_back(std::move(value));
+            }
+        }
+        return array;
+    }
+    
+    // '?' or '*' after a value, consumed, or '\0'
+    char optional_modifier() noexcept {
+        char c = format_.peek();
+        if (c == '?' || c == '*') {
+            return format_.next();
+        }
+        return '\0';
+    }
+    
+    jansson::JsonRef<jansson::JsonValue> null_for(char modifier) {
+        if (modifier == '?') {
+            return jansson::JsonNull::create();
+        }
+        if (modifier == '*') {
+            return nullptr;
+        }
+        throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+    }
+    
+    // Arguments of an s item: one string, or with #, % and + a run of
+    // strings with explicit lengths joined into buffer. text is left null
+    // for a null optional string.
+    std::string_view read_string(bool optional, const char*& text, std::string& buffer) {
+        char c = format_.peek();
+        if (c != '#' && c != '%' && c != '+') {
+            text = va_arg(*args_, const char*);
+            if (!text) {
+                if (optional) {
+                    return std::string_view();
+                }
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+            }
+            return checked_utf8(text);
+        }
+        if (optional) {
+            throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+        }
+        for (;;) {
+            text = va_arg(*args_, const char*);
+            if (!text) {
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+            }
+            size_t length;
+            c = format_.peek();
+            if (c == '#') {
+                format_.next();
+                length = static_cast<size_t>(va_arg(*args_, int));
+            } else if (c == '%') {
+                format_.next();
+                length = va_arg(*args_, size_t);
+            } else {
+                length = std::strlen(text);
+            }
+            buffer.append(text, length);
+            if (format_.peek() != '+') {
+                break;
+            }
+            format_.next();
+        }
+        return checked_utf8(buffer);
+    }
+    
+    FormatScanner format_;
+    va_list* args_;
+};
+
+class Unpacker {
+public:
+    Unpacker(const char* format, va_list* args, size_t flags) noexcept
+        : format_(format), args_(args), flags_(flags) {}
+    
+    void unpack(const jansson::JsonValue* root) {
+        unpack_value(format_.next(), root);
+        if (format_.peek() != '\0') {
+            throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+        }
+    }
+
+private:
+    bool validate_only() const noexcept { return (flags_ & JSON_VALIDATE_ONLY) != 0; }
+    
+    static void expect(bool matches) {
+        if (!matches) {
+            throw PackError{JSON_ERROR_INVALID_TYPE};
+        }
+    }
+    
+    template <typename T>
+    T* target() {
+        T* target = va_arg(*args_, T*);
+        if (!target) {
+            throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+        }
+        return target;
+    }
+    
+    // A null value (the member of a missing optional key) only consumes
+    // the arguments of its format
+    void unpack_value(char type, const jansson::JsonValue* value) {
+        switch (type) {
+            case '{':
+                unpack_object(value);
+                return;
+            case '[':
+                unpack_array(value);
+                return;
+            case 's': {
+                expect(!value || value->is_string());
+                bool with_length = format_.peek() == '%';
+                if (with_length) {
+                    format_.next();
+                }
+                if (validate_only()) {
+                    return;
+                }
+                const char** text = target<const char*>();
+                size_t* length = with_length ? target<size_t>() : nullptr;
+                if (value) {
+                    const auto* string = static_cast<const jansson::JsonStringValue*>(value);
+                    *text = string->value().c_str();
+                    if (length) {
+                        *length = string->view().size();
+                    }
+                }
+                return;
+            }
+            case 'n':
+                expect(!value || value->is_null());
+                return;
+            case 'b':
+                expect(!value || value->is_boolean());
+                store<int>(value, [](const jansson::JsonValue& v) { return v.boolean_value() ? 1 : 0; });
+                return;
+            case 'i':
+                expect(!value || value->is_integer());
+                store<int>(value, [](const jansson::JsonValue& v) { return static_cast<int>(v.integer_value()); });
+                return;
+            case 'I':
+                expect(!value || value->is_integer());
+                store<json_int_t>(value, [](const jansson::JsonValue& v) {
+                    return static_cast<json_int_t>(v.integer_value());
+                });
+                return;
+            case 'f':
+                expect(!value || value->is_real());
+                store<double>(value, [](const jansson::JsonValue& v) { return v.number_value(); });
+                return;
+            case 'F':
+                expect(!value || value->is_number());
+                store<double>(value, [](const jansson::JsonValue& v) { return v.number_value(); });
+                return;
+            case 'o':
+            case 'O':
+                if (!validate_only()) {
+                    json_t** json = target<json_t*>();
+                    if (value) {
+                        *json = type == 'O' ? give(jansson::JsonRef<jansson::JsonValue>(const_cast<jansson::JsonValue*>(value)))
+                                            : borrow(value);
+                    }
+                }
+                return;
+            default:
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+        }
+    }
+    
+    template <typename T, typename Read>
+    void store(const jansson::JsonValue* value, Read read) {
+        if (validate_only()) {
+            return;
+        }
+        T* out = target<T>();
+        if (value) {
+            *out = read(*value);
+        }
+    }
+    
+    // '!' or '*' closing a container, or '\0' if the next character is
+    // not one of them
+    char strictness(char close) {
+        char c = format_.peek();
+        if (c != '!' && c != '*') {
+            return '\0';
+        }
+        format_.next();
+        if (format_.peek() != close) {
+            throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+        }
+        return c;
+    }
+    
+    void unpack_object(const jansson::JsonValue* value) {
+        expect(!value || value->is_object());
+        const auto* object = static_cast<const jansson::JsonObject*>(value);
+        // Keys unpacked; a set, since the same key may be unpacked twice
+        jansson::JsonHash<std::string_view, bool> seen;
+        char strict = '\0';
+        for (;;) {
+            strict = strictness('}');
+            char c = format_.next();
+            if (c == '}') {
+                break;
+            }
+            if (c != 's') {
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+            }
+            const char* key = va_arg(*args_, const char*);
+            if (!key) {
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+            }
+            bool optional = format_.peek() == '?';
+            if (optional) {
+                format_.next();
+            }
+            const jansson::JsonValue* member = nullptr;
+            if (object) {
+                auto it = object->values().find(std::string_view(key));
+                if (it != object->values().end()) {
+                    member = it->second.get();
+                    seen.try_emplace(std::string_view(key), true);
+                } else if (!optional) {
+                    throw PackError{JSON_ERROR_KEY_NOT_FOUND};
+                }
+            }
+            unpack_value(format_.next(), member);
+        }
+        if (strict == '\0' && (flags_ & JSON_STRICT)) {
+            strict = '!';
+        }
+        if (object && strict == '!' && seen.size() != object->size()) {
+            throw PackError{JSON_ERROR_INVALID_TYPE};
+        }
+    }
+    
+    void unpack_array(const jansson::JsonValue* value) {
+        expect(!value || value->is_array());
+        const auto* array = static_cast<const jansson::JsonArray*>(value);
+        size_t index = 0;
+        char strict = '\0';
+        for (;;) {
+            strict = strictness(']');
+            char c = format_.next();
+            if (c == ']') {
+                break;
+            }
+            if (c == '\0') {
+                throw PackError{JSON_ERROR_INVALID_ARGUMENT};
+            }
+            const jansson::JsonValue* element = nullptr;
+            if (array) {
+                if (index >= array->size()) {
+                    throw PackError{JSON_ERROR_INDEX_OUT_OF_BOUNDS};
+                }
+                element = array->values()[index].get();
+            }
+            unpack_value(c, element);
+            ++index;
+        }
+        if (strict == '\0' && (flags_ & JSON_STRICT)) {
+            strict = '!';
+        }
+        if (array && strict == '!' && index != array->size()) {
+            throw PackError{JSON_ERROR_INVALID_TYPE};
+        }
+    }
+    
+    FormatScanner format_;
+    va_list* args_;
+    size_t flags_;
+};
+
+void set_error(json_error_code* error, json_error_code code) {
+    if (error) {
+        *error = code;
+    }
+}
+
+} // namespace
+
+json_t* json_pack(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    json_t* value = json_vpack_ex(nullptr, 0, fmt, ap);
+    va_end(ap);
+    return value;
+}
+
+json_t* json_pack_ex(json_error_code* error, size_t flags, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    json_t* value = json_vpack_ex(error, flags, fmt, ap);
+    va_end(ap);
+    return value;
+}
+
+json_t* json_vpack_ex(json_error_code* error, size_t /*flags*/, const char* fmt, va_list ap) {
+    if (!fmt || !*fmt) {
+        set_error(error, JSON_ERROR_INVALID_ARGUMENT);
+        return nullptr;
+    }
+    
+    va_list args;
+    va_copy(args, ap);
+    json_error_code code = JSON_ERROR_SUCCESS;
+    json_t* value = nullptr;
+    try {
+        value = give(Packer(fmt, &args).pack());
+    } catch (const PackError& e) {
+        code = e.code;
+    } catch (const std::bad_alloc&) {
+        code = JSON_ERROR_MEMORY_ALLOCATION_FAILED;
+    } catch (...) {
+        code = JSON_ERROR_UNKNOWN_ERROR;
+    }
+    va_end(args);
+    set_error(error, code);
+    return value;
+}
+
+int json_unpack(json_t* root, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int result = json_vunpack_ex(root, nullptr, 0, fmt, ap);
+    va_end(ap);
+    return result;
+}
+
+int json_unpack_ex(json_t* root, json_error_code* error, size_t flags, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int result = json_vunpack_ex(root, error, flags, fmt, ap);
+    va_end(ap);
+    return result;
+}
+
+int json_vunpack_ex(json_t* root, json_error_code* error, size_t flags, const char* fmt, va_list ap) {
+    if (!root || !fmt || !*fmt) {
+        set_error(error, JSON_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+    
+    va_list args;
+    va_copy(args, ap);
+    json_error_code code = JSON_ERROR_SUCCESS;
+    try {
+        Unpacker(fmt, &args, flags).unpack(node_of(root));
+    } catch (const PackError& e) {
+        code = e.code;
+    } catch (const std::bad_alloc&) {
+        code = JSON_ERROR_MEMORY_ALLOCATION_FAILED;
+    } catch (...) {
+        code = JSON_ERROR_UNKNOWN_ERROR;
+    }
+    va_end(args);
+    set_error(error, code);
+    return code == JSON_ERROR_SUCCESS ? 0 : -1;
+}
+
 // Error handling
 const char* json_error_text(json_error_code error) {
     switch (error) {
@@ -344,6 +1444,7 @@ const char* json_error_text(json_error_code error) {
         case JSON_ERROR_SERIALIZATION_ERROR: return "Serialization error";
         case JSON_ERROR_NOT_IMPLEMENTED: return "Not implemented";
         case JSON_ERROR_UNKNOWN_ERROR: return "Unknown error";
+        case JSON_ERROR_LIMIT_EXCEEDED: return "Limit exceeded";
         default: return "Unknown error";
     }
 }
@@ -1,15 +1,24 @@
 #ifndef JSON_C_API_HPP
 #define JSON_C_API_HPP
 
+#include <cstdarg>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 
 // Forward declarations for C API compatibility
 extern "C" {
 
-// Opaque type for JSON values
+// Opaque type for JSON values. A json_t is the value node itself.
+// Functions that create or load a value return a new reference, released
+// with json_delete; json_array_get and json_object_get return borrowed
+// references, valid for as long as the container holds the value, which
+// must not be passed to json_delete.
 typedef struct json_t json_t;
 
+// Integer type used for JSON integers
+typedef long long json_int_t;
+
 // JSON types
 typedef enum {
     JSON_NULL,
@@ -33,20 +42,39 @@ typedef enum {
     JSON_ERROR_PARSE_ERROR,
     JSON_ERROR_SERIALIZATION_ERROR,
     JSON_ERROR_NOT_IMPLEMENTED,
-    JSON_ERROR_UNKNOWN_ERROR
+    JSON_ERROR_UNKNOWN_ERROR,
+    JSON_ERROR_LIMIT_EXCEEDED
 } json_error_code;
 
-// Memory management
+// Memory management. json_malloc returns NULL when out of memory. The
+// allocation functions back every allocation the library makes (values,
+// containers, keys, json_malloc); set them before creating any value.
+// Passing NULL restores malloc or free.
+typedef void *(*json_malloc_t)(size_t);
+typedef void (*json_free_t)(void *);
+
 void* json_malloc(size_t size);
 void json_free(void* ptr);
+void json_set_alloc_funcs(json_malloc_t malloc_fn, json_free_t free_fn);
+void json_get_alloc_funcs(json_malloc_t* malloc_fn, json_free_t* free_fn);
 
 // JSON value creation and destruction
 json_t* json_null();
 json_t* json_boolean(int value);
 json_t* json_number(double value);
+json_t* json_integer(json_int_t value);
+json_t* json_real(double value);
 json_t* json_string(const char* value);
 json_t* json_array();
 json_t* json_object();
+
+// Reference counting. json_incref adds a reference to json (if not NULL)
+// and returns it; json_decref releases one, destroying the value once no
+// container or caller refers to it.
+json_t* json_incref(json_t* json);
+void json_decref(json_t* json);
+
+// Same as json_decref
 void json_delete(json_t* json);
 
 // Type checking
@@ -54,6 +82,8 @@ json_type json_typeof(const json_t* json);
 int json_is_null(const json_t* json);
 int json_is_boolean(const json_t* json);
 int json_is_number(const json_t* json);
+int json_is_integer(const json_t* json);
+int json_is_real(const json_t* json);
 int json_is_string(const json_t* json);
 int json_is_array(const json_t* json);
 int json_is_object(const json_t* json);
@@ -61,33 +91,200 @@ int json_is_object(const json_t* json);
 // Value access
 int json_boolean_value(const json_t* json);
 double json_number_value(const json_t* json);
+json_int_t json_integer_value(const json_t* json);
+double json_real_value(const json_t* json);
 const char* json_string_value(const json_t* json);
 size_t json_array_size(const json_t* json);
 json_t* json_array_get(const json_t* json, size_t index);
 size_t json_object_size(const json_t* json);
 json_t* json_object_get(const json_t* json, const char* key);
+json_t* json_object_getn(const json_t* json, const char* key, size_t key_len);
 
-// Array operations
+// Array operations. Containers take their own reference to value; the
+// caller keeps its reference. The _new variants steal the caller's
+// reference instead, even when they fail.
 int json_array_append(json_t* json, json_t* value);
+int json_array_append_new(json_t* json, json_t* value);
 int json_array_insert(json_t* json, json_t* value, size_t index);
+int json_array_insert_new(json_t* json, json_t* value, size_t index);
 int json_array_remove(json_t* json, size_t index);
 int json_array_clear(json_t* json);
 
 // Object operations
 int json_object_set(json_t* json, const char* key, json_t* value);
+int json_object_set_new(json_t* json, const char* key, json_t* value);
+int json_object_setn(json_t* json, const char* key, size_t key_len, json_t* value);
+int json_object_setn_new(json_t* json, const char* key, size_t key_len, json_t* value);
 int json_object_del(json_t* json, const char* key);
+int json_object_deln(json_t* json, const char* key, size_t key_len);
 int json_object_clear(json_t* json);
 
-// Parsing
+// Seed of the key hash (0 picks a random one). Only effective before the
+// first object or key is created.
+void json_object_seed(size_t seed);
+
+// Iteration. An object iterator points at a member in place, so walking an
+// object allocates nothing and keys and values are borrowed: valid while
+// the member stays in the object. Members come in insertion order. Adding
+// a member invalidates every iterator of the object; deleting one
+// invalidates those at and after it, except as json_object_foreach_safe
+// allows. json_object_iter_at takes a NUL-terminated key, like
+// json_object_get. There is no json_object_key_to_iter: keys are shared
+// between objects, so a key does not lead back to its member.
+void* json_object_iter(json_t* json);
+void* json_object_iter_at(json_t* json, const char* key);
+void* json_object_iter_next(json_t* json, void* iter);
+const char* json_object_iter_key(void* iter);
+size_t json_object_iter_key_len(void* iter);
+json_t* json_object_iter_value(void* iter);
+int json_object_iter_set(json_t* json, void* iter, json_t* value);
+int json_object_iter_set_new(json_t* json, void* iter, json_t* value);
+
+// iter if it points at a member of json, otherwise NULL. Used by
+// json_object_foreach_safe after its body deletes the current member, which
+// moves the next member into its place.
+void* json_object_iter_check(json_t* json, void* iter);
+
+#define json_object_foreach(object, key, value) \
+    for (void* json_iter_ = json_object_iter(object); \
+         json_iter_ && ((key) = json_object_iter_key(json_iter_), \
+                        (value) = json_object_iter_value(json_iter_), 1); \
+         json_iter_ = json_object_iter_next(object, json_iter_))
+
+#define json_object_keylen_foreach(object, key, key_len, value) \
+    for (void* json_iter_ = json_object_iter(object); \
+         json_iter_ && ((key) = json_object_iter_key(json_iter_), \
+                        (key_len) = json_object_iter_key_len(json_iter_), \
+                        (value) = json_object_iter_value(json_iter_), 1); \
+         json_iter_ = json_object_iter_next(object, json_iter_))
+
+// Like json_object_foreach, but the body may delete the current member;
+// n is a void* that holds the iterator
+#define json_object_foreach_safe(object, n, key, value) \
+    for (size_t json_size_ = ((n) = json_object_iter(object), json_object_size(object)); \
+         (n) && ((key) = json_object_iter_key(n), (value) = json_object_iter_value(n), 1); \
+         (n) = json_object_size(object) < json_size_ \
+             ? (json_size_ = json_object_size(object), json_object_iter_check(object, n)) \
+             : json_object_iter_next(object, n))
+
+#define json_array_foreach(array, index, value) \
+    for ((index) = 0; \
+         (index) < json_array_size(array) && ((value) = json_array_get(array, index)) != NULL; \
+         (index)++)
+
+// Load flags. JSON_DISABLE_EOF_CHECK stops after the first value instead
+// of failing when more input follows it. Values of any type are accepted
+// at the top level, so JSON_DECODE_ANY has no effect.
+#define JSON_DISABLE_EOF_CHECK 0x2
+#define JSON_DECODE_ANY 0x4
+
+// Parsing. json_loadb reads exactly buflen bytes, which need not be
+// NUL-terminated.
 json_t* json_loads(const char* input, size_t flags, json_error_code* error);
+json_t* json_loadb(const char* buffer, size_t buflen, size_t flags, json_error_code* error);
+
+// Where and why a load failed. line and column are 1-based; column and
+// position count bytes. text is always NUL-terminated.
+#define JSON_ERROR_TEXT_LENGTH 160
+
+typedef struct {
+    int line;
+    int column;
+    int position;
+    char text[JSON_ERROR_TEXT_LENGTH];
+    json_error_code code;
+} json_error_t;
+
+json_t* json_loads_ex(const char* input, size_t flags, json_error_t* error);
+json_t* json_loadb_ex(const char* buffer, size_t buflen, size_t flags, json_error_t* error);
+
+// Parse the value at the start of buffer, which may be followed by more
+// values (pipelined input), and set *consumed to the bytes read: the value
+// and the whitespace after it. The next value starts at buffer + *consumed.
+json_t* json_loadb_next(const char* buffer, size_t buflen, size_t* consumed, size_t flags,
+                        json_error_code* error);
+
+// Stream parsing. The input is read in chunks until end of file and must
+// hold exactly one JSON value.
+// A load callback fills buffer with up to buflen bytes and returns the
+// number of bytes written, 0 at end of input or (size_t)-1 on error.
+typedef size_t (*json_load_callback_t)(void* buffer, size_t buflen, void* data);
+
+json_t* json_load_file(const char* path, size_t flags, json_error_code* error);
+json_t* json_loadf(FILE* input, size_t flags, json_error_code* error);
+json_t* json_loadfd(int input, size_t flags, json_error_code* error);
+json_t* json_load_callback(json_load_callback_t callback, void* data, size_t flags, json_error_code* error);
+
+// Dump flags. JSON_INDENT(n) pretty-prints with n spaces per level and
+// JSON_COMPACT drops the spaces after ',' and ':'. JSON_SORT_KEYS orders
+// object members by key; otherwise they are written in insertion order
+// (JSON_PRESERVE_ORDER is accepted for compatibility). JSON_REAL_PRECISION(n)
+// writes reals with n significant digits instead of the shortest form that
+// reads back the same. JSON_CANONICAL writes RFC 8785 canonical JSON and
+// overrides the other layout flags. Values of any type are encoded, so
+// JSON_ENCODE_ANY is also accepted and has no effect.
+#define JSON_MAX_INDENT 0x1F
+#define JSON_INDENT(n) ((n) & JSON_MAX_INDENT)
+#define JSON_COMPACT 0x20
+#define JSON_SORT_KEYS 0x80
+#define JSON_PRESERVE_ORDER 0x100
+#define JSON_ENCODE_ANY 0x200
+#define JSON_REAL_PRECISION(n) (((n) & 0x1F) << 11)
+#define JSON_CANONICAL 0x20000
 
 // Serialization
 char* json_dumps(const json_t* json, size_t flags);
+size_t json_dumpb(const json_t* json, char* buffer, size_t size, size_t flags);
 void json_dumps_free(char* json);
 
+// Streaming serialization. Output is produced in fixed-size chunks, so the
+// whole document is never held in memory. These return 0 on success and
+// -1 on error.
+// A dump callback consumes size bytes from buffer and returns 0 on
+// success or -1 to abort.
+typedef int (*json_dump_callback_t)(const char* buffer, size_t size, void* data);
+
+int json_dump_callback(const json_t* json, json_dump_callback_t callback, void* data, size_t flags);
+int json_dumpf(const json_t* json, FILE* output, size_t flags);
+int json_dumpfd(const json_t* json, int output, size_t flags);
+int json_dump_file(const json_t* json, const char* path, size_t flags);
+
+// Building and destructuring values from format strings, with the
+// format characters of jansson::pack() and jansson::unpack() (plus s+ to
+// concatenate strings when packing). json_pack returns a new reference,
+// or NULL on error; o steals the reference it is given, even on error.
+// json_unpack returns 0 on success and -1 on error, possibly after some
+// targets have been stored; s targets are borrowed from root and O
+// targets are new references.
+json_t* json_pack(const char* fmt, ...);
+json_t* json_pack_ex(json_error_code* error, size_t flags, const char* fmt, ...);
+json_t* json_vpack_ex(json_error_code* error, size_t flags, const char* fmt, va_list ap);
+
+// Unpack flags: JSON_VALIDATE_ONLY checks root against fmt without taking
+// target arguments, JSON_STRICT makes every container behave as if it
+// ended with '!'
+#define JSON_VALIDATE_ONLY 0x1
+#define JSON_STRICT 0x2
+
+int json_unpack(json_t* root, const char* fmt, ...);
+int json_unpack_ex(json_t* root, json_error_code* error, size_t flags, const char* fmt, ...);
+int json_vunpack_ex(json_t* root, json_error_code* error, size_t flags, const char* fmt, va_list ap);
+
 // Error handling
 const char* json_error_text(json_error_code error);
 
 } // extern "C"
 
+// Release *json when the variable goes out of scope (GCC and Clang)
+#if defined(__GNUC__) || defined(__clang__)
+inline void json_decrefp(json_t** json) {
+    if (json) {
+        json_decref(*json);
+        *json = nullptr;
+    }
+}
+
+#define json_auto_t json_t __attribute__((cleanup(json_decrefp)))
+#endif
+
 #endif // JSON_C_API_HPP
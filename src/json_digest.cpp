@@ -0,0 +1,165 @@
+#include "json_digest.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace jansson {
+
+namespace {
+
+constexpr std::uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline std::uint32_t rotate_right(std::uint32_t value, int bits) noexcept {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+} // namespace
+
+// JsonSha256 implementation
+void JsonSha256::reset() noexcept {
+    static constexpr std::uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    std::memcpy(state_, initial, sizeof(state_));
+    buffered_ = 0;
+    length_ = 0;
+}
+
+void JsonSha256::compress(const std::uint8_t* block) noexcept {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = static_cast<std::uint32_t>(block[4 * i]) << 24 | static_cast<std::uint32_t>(block[4 * i + 1]) << 16 |
+               static_cast<std::uint32_t>(block[4 * i + 2]) << 8 | static_cast<std::uint32_t>(block[4 * i + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        std::uint32_t s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    std::uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    std::uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; ++i) {
+        std::uint32_t s1 = rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+        std::uint32_t choice = (e & f) ^ (~e & g);
+        std::uint32_t t1 = h + s1 + choice + round_constants[i] + w[i];
+        std::uint32_t s0 = rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+        std::uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        std::uint32_t t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+}
+
+void JsonSha256::update(const void* data, std::size_t length) noexcept {
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    length_ += length;
+    if (buffered_ != 0) {
+        std::size_t take = std::min(length, sizeof(block_) - buffered_);
+        std::memcpy(block_ + buffered_, bytes, take);
+        buffered_ += take;
+        bytes += take;
+        length -= take;
+        if (buffered_ < sizeof(block_)) {
+            return;
+        }
+        compress(block_);
+        buffered_ = 0;
+    }
+    // Whole blocks straight from the input
+    for (; length >= sizeof(block_); bytes += sizeof(block_), length -= sizeof(block_)) {
+        compress(bytes);
+    }
+    std::memcpy(block_, bytes, length);
+    buffered_ = length;
+}
+
+JsonSha256::Digest JsonSha256::finish() noexcept {
+    // A 1 bit, zeros up to 56 bytes into a block, then the length in bits
+    std::uint64_t bits = length_ * 8;
+    std::uint8_t padding[72] = {0x80};
+    std::size_t pad = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; ++i) {
+        padding[pad + static_cast<std::size_t>(i)] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+    }
+    update(padding, pad + 8);
+
+    Digest digest;
+    for (std::size_t i = 0; i < 8; ++i) {
+        digest[4 * i] = static_cast<std::uint8_t>(state_[i] >> 24);
+        digest[4 * i + 1] = static_cast<std::uint8_t>(state_[i] >> 16);
+        digest[4 * i + 2] = static_cast<std::uint8_t>(state_[i] >> 8);
+        digest[4 * i + 3] = static_cast<std::uint8_t>(state_[i]);
+    }
+    reset();
+    return digest;
+}
+
+JsonSha256::Digest JsonSha256::hash(std::string_view data) noexcept {
+    JsonSha256 hasher;
+    hasher.update(data);
+    return hasher.finish();
+}
+
+std::string JsonSha256::hex(const Digest& digest) {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string text(digest.size() * 2, '\0');
+    for (std::size_t i = 0; i < digest.size(); ++i) {
+        text[2 * i] = digits[digest[i] >> 4];
+        text[2 * i + 1] = digits[digest[i] & 0xF];
+    }
+    return text;
+}
+
+// JsonDigestWriter implementation
+JsonDigestWriter::JsonDigestWriter(std::size_t chunk_size) : JsonChunkedWriter(chunk_size) {}
+
+JsonDigestWriter::~JsonDigestWriter() {
+    flush();
+}
+
+JsonSha256::Digest JsonDigestWriter::finish() {
+    flush();
+    return hash_.finish();
+}
+
+bool JsonDigestWriter::write_chunk(const char* data, std::size_t length) {
+    hash_.update(data, length);
+    return true;
+}
+
+JsonSha256::Digest json_digest(const JsonValue& value) {
+    JsonSerializeOptions options;
+    options.canonical = true;
+    return json_digest(value, options);
+}
+
+JsonSha256::Digest json_digest(const JsonValue& value, const JsonSerializeOptions& options) {
+    JsonDigestWriter writer;
+    JsonSerializer::serialize(writer, value, options);
+    return writer.finish();
+}
+
+} // namespace jansson
@@ -0,0 +1,72 @@
+#ifndef JSON_DIGEST_HPP
+#define JSON_DIGEST_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "json_serializer.hpp"
+#include "json_value.hpp"
+#include "json_writer.hpp"
+
+namespace jansson {
+
+// Incremental SHA-256 (FIPS 180-4)
+class JsonSha256 {
+public:
+    using Digest = std::array<std::uint8_t, 32>;
+
+    JsonSha256() noexcept { reset(); }
+
+    void update(const void* data, std::size_t length) noexcept;
+    void update(std::string_view data) noexcept { update(data.data(), data.size()); }
+
+    // Digest of everything passed to update(); the hasher starts over
+    Digest finish() noexcept;
+
+    void reset() noexcept;
+
+    // Digest of data in one call
+    static Digest hash(std::string_view data) noexcept;
+
+    // Lowercase hexadecimal form of a digest
+    static std::string hex(const Digest& digest);
+
+private:
+    void compress(const std::uint8_t* block) noexcept;
+
+    std::uint32_t state_[8];
+    std::uint8_t block_[64];
+    std::size_t buffered_ = 0;
+    std::uint64_t length_ = 0;
+};
+
+// Writer that hashes its output instead of keeping it, so the digest of a
+// serialization is computed as the text is produced and the text is never
+// held whole in memory
+class JsonDigestWriter : public JsonChunkedWriter {
+public:
+    explicit JsonDigestWriter(std::size_t chunk_size = default_chunk_size);
+    ~JsonDigestWriter() override;
+
+    // Digest of everything written; the writer starts over
+    JsonSha256::Digest finish();
+
+protected:
+    bool write_chunk(const char* data, std::size_t length) override;
+
+private:
+    JsonSha256 hash_;
+};
+
+// SHA-256 of value's RFC 8785 canonical serialization: a content address,
+// or the bytes to sign
+JsonSha256::Digest json_digest(const JsonValue& value);
+
+// SHA-256 of value serialized with options
+JsonSha256::Digest json_digest(const JsonValue& value, const JsonSerializeOptions& options);
+
+} // namespace jansson
+
+#endif // JSON_DIGEST_HPP
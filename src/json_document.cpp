@@ -0,0 +1,110 @@
+#include "json_document.hpp"
+#include "json_frozen.hpp"
+#include <cstring>
+
+namespace jansson {
+
+JsonDocument::JsonDocument(std::size_t block_size)
+    : arena_(block_size) {}
+
+JsonDocument::~JsonDocument() {
+    // The tree must be destroyed before the arena that holds it
+    root_.reset();
+}
+
+Result<JsonRef<JsonValue>> JsonDocument::parse(std::string_view input) {
+    return parse(input, JsonParseOptions());
+}
+
+Result<JsonRef<JsonValue>> JsonDocument::parse(std::string_view input,
+                                                       JsonParseOptions options) {
+    clear();
+    options.arena = &arena_;
+    
+    if (options.borrow_strings && !input.empty()) {
+        // Borrowed strings point into this copy, which lives as long as
+        // the tree
+        char* copy = static_cast<char*>(arena_.allocate(input.size(), 1));
+        std::memcpy(copy, input.data(), input.size());
+        input = std::string_view(copy, input.size());
+    }
+    
+    auto result = JsonParser::parse(input, options);
+    if (result) {
+        root_ = result.value();
+    }
+    return result;
+}
+
+Result<JsonRef<JsonValue>> JsonDocument::parse_file(const std::string& path) {
+    return parse_file(path, JsonParseOptions());
+}
+
+Result<JsonRef<JsonValue>> JsonDocument::parse_file(const std::string& path,
+                                                            JsonParseOptions options) {
+    clear();
+    options.arena = &arena_;
+    
+    auto file = JsonMappedFile::open(path);
+    if (!file) {
+        return Result<JsonRef<JsonValue>>(file.error());
+    }
+    
+    auto result = JsonParser::parse(file.value()->view(), options);
+    if (result) {
+        root_ = result.value();
+        if (options.borrow_strings) {
+            file_ = std::move(file.value());
+        }
+    }
+    return result;
+}
+
+JsonRef<JsonNull> JsonDocument::make_null() {
+    return make_value_in<JsonNull>(&arena_);
+}
+
+JsonRef<JsonBoolean> JsonDocument::make_boolean(bool value) {
+    return make_value_in<JsonBoolean>(&arena_, value);
+}
+
+JsonRef<JsonNumber> JsonDocument::make_number(double value) {
+    return make_value_in<JsonNumber>(&arena_, value);
+}
+
+JsonRef<JsonNumber> JsonDocument::make_integer(std::int64_t value) {
+    return make_value_in<JsonNumber>(&arena_, value);
+}
+
+JsonRef<JsonStringValue> JsonDocument::make_string(std::string_view value) {
+    return make_value_in<JsonStringValue>(&arena_, value);
+}
+
+JsonRef<JsonArray> JsonDocument::make_array() {
+    return make_value_in<JsonArray>(&arena_, &arena_);
+}
+
+JsonRef<JsonObject> JsonDocument::make_object() {
+    return make_value_in<JsonObject>(&arena_, &arena_);
+}
+
+std::shared_ptr<const JsonFrozenDocument> JsonDocument::freeze() const {
+    if (!root_) {
+        return nullptr;
+    }
+    return JsonFrozenDocument::freeze(*root_);
+}
+
+void JsonDocument::clear() {
+    root_.reset();
+    arena_.reset();
+    file_.reset();
+}
+
+void JsonDocument::release() {
+    root_.reset();
+    arena_.release();
+    file_.reset();
+}
+
+} // namespace jansson
@@ -0,0 +1,82 @@
+#ifndef JSON_DOCUMENT_HPP
+#define JSON_DOCUMENT_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_error.hpp"
+#include "memory_policy.hpp"
+#include "json_file.hpp"
+
+namespace jansson {
+
+class JsonFrozenDocument;
+
+// A JSON tree whose nodes all live in one arena owned by the document.
+// Building a tree costs a few block allocations instead of one heap
+// allocation per node, and the whole tree is released at once.
+//
+// Container storage of arrays and objects is drawn from the same arena, so
+// one request's tree comes from a handful of blocks. Nodes created by a
+// document (or by parse()) must not be used after the document is cleared
+// or destroyed.
+class JsonDocument {
+public:
+    explicit JsonDocument(std::size_t block_size = 64 * 1024);
+    ~JsonDocument();
+    
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+    
+    // Parse input into this document, replacing the current root
+    Result<JsonRef<JsonValue>> parse(std::string_view input);
+    Result<JsonRef<JsonValue>> parse(std::string_view input, JsonParseOptions options);
+    
+    // Parse a file, memory-mapped where possible. With borrow_strings the
+    // mapping is kept until the document is cleared, and strings point
+    // straight into it.
+    Result<JsonRef<JsonValue>> parse_file(const std::string& path);
+    Result<JsonRef<JsonValue>> parse_file(const std::string& path, JsonParseOptions options);
+    
+    // Root value (null if nothing has been parsed or set)
+    const JsonRef<JsonValue>& root() const noexcept { return root_; }
+    void set_root(JsonRef<JsonValue> root) { root_ = std::move(root); }
+    
+    // Create nodes in the document's arena
+    JsonRef<JsonNull> make_null();
+    JsonRef<JsonBoolean> make_boolean(bool value);
+    JsonRef<JsonNumber> make_number(double value);
+    JsonRef<JsonNumber> make_integer(std::int64_t value);
+    JsonRef<JsonStringValue> make_string(std::string_view value);
+    JsonRef<JsonArray> make_array();
+    JsonRef<JsonObject> make_object();
+    
+    // Immutable, compacted copy of the tree that any number of threads can
+    // read at once (see JsonFrozenDocument); independent of this document,
+    // so it stays valid after the document is cleared. Null if there is no
+    // root.
+    std::shared_ptr<const JsonFrozenDocument> freeze() const;
+    
+    // Destroy the tree and make the arena memory available for reuse
+    void clear();
+    
+    // Destroy the tree and return the arena memory to the system
+    void release();
+    
+    // Bytes handed out to nodes and bytes reserved from the system
+    std::size_t memory_usage() const noexcept { return arena_.bytes_used(); }
+    std::size_t memory_reserved() const noexcept { return arena_.bytes_reserved(); }
+    
+    JsonArena& arena() noexcept { return arena_; }
+
+private:
+    JsonArena arena_;
+    std::unique_ptr<JsonMappedFile> file_;
+    JsonRef<JsonValue> root_;
+};
+
+} // namespace jansson
+
+#endif // JSON_DOCUMENT_HPP
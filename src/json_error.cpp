@@ -33,6 +33,10 @@ std::string JsonErrorCategory::message(int ev) const {
             return "Not implemented";
         case JsonErrorCode::UnknownError:
             return "Unknown error";
+        case JsonErrorCode::LimitExceeded:
+            return "Limit exceeded";
+        case JsonErrorCode::SchemaViolation:
+            return "Schema violation";
         default:
             return "Unknown JSON error";
     }
@@ -21,7 +21,9 @@ enum class JsonErrorCode {
     ParseError,
     SerializationError,
     NotImplemented,
-    UnknownError
+    UnknownError,
+    LimitExceeded,
+    SchemaViolation
 };
 
 // Error category for JSON errors
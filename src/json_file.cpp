@@ -0,0 +1,84 @@
+#include "json_file.hpp"
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JANSSON_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jansson {
+
+JsonMappedFile::~JsonMappedFile() {
+#if defined(JANSSON_HAVE_MMAP)
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+Result<std::unique_ptr<JsonMappedFile>> JsonMappedFile::open(const std::string& path) {
+    using FileResult = Result<std::unique_ptr<JsonMappedFile>>;
+    std::unique_ptr<JsonMappedFile> file(new JsonMappedFile());
+    
+#if defined(JANSSON_HAVE_MMAP)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return FileResult(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            // The parser reads front to back
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            file->data_ = static_cast<const char*>(mapping);
+            file->size_ = size;
+            file->mapped_ = true;
+            ::close(fd);
+            return FileResult(std::move(file));
+        }
+    }
+    
+    // Not mappable (pipe, empty file, mmap failure): read it instead
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t length = ::read(fd, chunk, sizeof(chunk));
+        if (length < 0) {
+            ::close(fd);
+            return FileResult(make_error_code(JsonErrorCode::InvalidArgument));
+        }
+        if (length == 0) {
+            break;
+        }
+        file->buffer_.append(chunk, static_cast<std::size_t>(length));
+    }
+    ::close(fd);
+#else
+    FILE* input = std::fopen(path.c_str(), "rb");
+    if (!input) {
+        return FileResult(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    
+    char chunk[64 * 1024];
+    std::size_t length;
+    while ((length = std::fread(chunk, 1, sizeof(chunk), input)) > 0) {
+        file->buffer_.append(chunk, length);
+    }
+    bool failed = std::ferror(input) != 0;
+    std::fclose(input);
+    if (failed) {
+        return FileResult(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+#endif
+    
+    file->data_ = file->buffer_.data();
+    file->size_ = file->buffer_.size();
+    return FileResult(std::move(file));
+}
+
+} // namespace jansson
@@ -0,0 +1,43 @@
+#ifndef JSON_FILE_HPP
+#define JSON_FILE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "json_error.hpp"
+
+namespace jansson {
+
+// Read-only view of a whole file. The file is memory-mapped where the
+// platform supports it, so parsing reads the page cache directly instead
+// of a private copy; otherwise (or if mapping fails) it is read into a
+// buffer.
+class JsonMappedFile {
+public:
+    ~JsonMappedFile();
+    
+    JsonMappedFile(const JsonMappedFile&) = delete;
+    JsonMappedFile& operator=(const JsonMappedFile&) = delete;
+    
+    static Result<std::unique_ptr<JsonMappedFile>> open(const std::string& path);
+    
+    const char* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    std::string_view view() const noexcept { return std::string_view(data_, size_); }
+    
+    // Whether the contents come from a mapping rather than a read buffer
+    bool is_mapped() const noexcept { return mapped_; }
+
+private:
+    JsonMappedFile() = default;
+    
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+};
+
+} // namespace jansson
+
+#endif // JSON_FILE_HPP
@@ -0,0 +1,447 @@
+#include "json_frozen.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace jansson {
+
+[[noreturn]] static void throw_type_error(const char* expected) {
+    throw JsonException(std::string("Value is not ") + expected);
+}
+
+// JsonFrozenValue implementation
+JsonType JsonFrozenValue::type() const noexcept {
+    return document_->nodes_[node_].type;
+}
+
+bool JsonFrozenValue::is_integer() const noexcept {
+    const auto& node = document_->nodes_[node_];
+    return node.type == JsonType::Number && node.flag;
+}
+
+bool JsonFrozenValue::is_real() const noexcept {
+    const auto& node = document_->nodes_[node_];
+    return node.type == JsonType::Number && !node.flag;
+}
+
+bool JsonFrozenValue::boolean_value() const {
+    const auto& node = document_->nodes_[node_];
+    if (node.type != JsonType::Boolean) {
+        throw_type_error("a boolean");
+    }
+    return node.flag;
+}
+
+double JsonFrozenValue::number_value() const {
+    const auto& node = document_->nodes_[node_];
+    if (node.type != JsonType::Number) {
+        throw_type_error("a number");
+    }
+    return node.flag ? static_cast<double>(node.integer) : node.real;
+}
+
+std::int64_t JsonFrozenValue::integer_value() const {
+    const auto& node = document_->nodes_[node_];
+    if (node.type != JsonType::Number) {
+        throw_type_error("a number");
+    }
+    return node.flag ? node.integer : static_cast<std::int64_t>(node.real);
+}
+
+std::string_view JsonFrozenValue::string_value() const {
+    const auto& node = document_->nodes_[node_];
+    if (node.type != JsonType::String) {
+        throw_type_error("a string");
+    }
+    return std::string_view(document_->strings_ + node.payload, node.size);
+}
+
+std::size_t JsonFrozenValue::size() const noexcept {
+    const auto& node = document_->nodes_[node_];
+    if (node.type != JsonType::Array && node.type != JsonType::Object) {
+        return 0;
+    }
+    return node.size;
+}
+
+JsonFrozenValue JsonFrozenValue::at(std::size_t index) const {
+    const auto& node = document_->nodes_[node_];
+    if (node.type != JsonType::Array && node.type != JsonType::Object) {
+        throw_type_error("an array");
+    }
+    if (index >= node.size) {
+        throw JsonException("Array index out of bounds");
+    }
+    return JsonFrozenValue(document_, document_->first_child(node) + static_cast<std::uint32_t>(index));
+}
+
+std::string_view JsonFrozenValue::key_at(std::size_t index) const {
+    const auto& node = document_->nodes_[node_];
+    if (node.type != JsonType::Object) {
+        throw_type_error("an object");
+    }
+    if (index >= node.size) {
+        throw JsonException("Object index out of bounds");
+    }
+    return document_->key_of(document_->first_child(node) + static_cast<std::uint32_t>(index));
+}
+
+JsonFrozenValue JsonFrozenValue::find(std::string_view key) const noexcept {
+    std::uint32_t child = document_->find(node_, key);
+    if (child == JsonFrozenDocument::no_index) {
+        return JsonFrozenValue();
+    }
+    return JsonFrozenValue(document_, child);
+}
+
+JsonRef<JsonValue> JsonFrozenValue::thaw() const {
+    return document_->thaw(node_);
+}
+
+// JsonFrozenDocument implementation
+std::shared_ptr<const JsonFrozenDocument> JsonFrozenDocument::freeze(const JsonValue& root) {
+    std::vector<Node> nodes;
+    std::vector<KeyRef> keys;
+    std::vector<std::uint32_t> members;
+    std::string strings;
+
+    // Breadth-first: sources[i] is the value of nodes_[i], and each
+    // container's children are appended as one block when it is reached
+    std::vector<const JsonValue*> sources;
+    sources.push_back(&root);
+
+    // Keys are stored once; strings are not deduplicated
+    std::unordered_map<std::string_view, KeyRef> key_offsets;
+
+    auto append_bytes = [&](std::string_view bytes) {
+        if (strings.size() + bytes.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw JsonException("Document too large to freeze");
+        }
+        auto offset = static_cast<std::uint32_t>(strings.size());
+        strings.append(bytes.data(), bytes.size());
+        return KeyRef{offset, static_cast<std::uint32_t>(bytes.size())};
+    };
+
+    auto check_count = [](std::size_t count) {
+        if (count >= no_index) {
+            throw JsonException("Document too large to freeze");
+        }
+    };
+
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        const JsonValue& value = *sources[i];
+        Node node{};
+        node.type = value.type();
+        switch (value.type()) {
+            case JsonType::Null:
+                break;
+            case JsonType::Boolean:
+                node.flag = static_cast<const JsonBoolean&>(value).value();
+                break;
+            case JsonType::Number: {
+                const auto& number = static_cast<const JsonNumber&>(value);
+                node.flag = number.is_integer();
+                if (node.flag) {
+                    node.integer = number.integer();
+                } else {
+                    node.real = number.real();
+                }
+                break;
+            }
+            case JsonType::String: {
+                // view() reads borrowed strings without materializing them
+                KeyRef bytes = append_bytes(static_cast<const JsonStringValue&>(value).view());
+                node.size = bytes.length;
+                node.payload = bytes.offset;
+                break;
+            }
+            case JsonType::Array: {
+                const auto& elements = static_cast<const JsonArray&>(value).values();
+                check_count(sources.size() + elements.size());
+                node.size = static_cast<std::uint32_t>(elements.size());
+                node.payload = sources.size();
+                for (const auto& element : elements) {
+                    sources.push_back(element.get());
+                }
+                break;
+            }
+            case JsonType::Object: {
+                const auto& entries = static_cast<const JsonObject&>(value).values();
+                check_count(sources.size() + entries.size());
+                auto first = static_cast<std::uint32_t>(sources.size());
+                node.size = static_cast<std::uint32_t>(entries.size());
+                node.payload = first;
+
+                keys.resize(first + entries.size(), KeyRef{0, 0});
+                for (const auto& member : entries) {
+                    auto found = key_offsets.find(member.first.view());
+                    KeyRef key;
+                    if (found != key_offsets.end()) {
+                        key = found->second;
+                    } else {
+                        key = append_bytes(member.first.view());
+                        key_offsets.emplace(member.first.view(), key);
+                    }
+                    keys[sources.size()] = key;
+                    sources.push_back(member.second.get());
+                }
+
+                // Larger objects get their children sorted by key for
+                // binary search
+                if (entries.size() > JsonObjectMap::linear_limit) {
+                    check_count(members.size() + entries.size());
+                    auto index = static_cast<std::uint32_t>(members.size());
+                    for (std::uint32_t k = 0; k < node.size; ++k) {
+                        members.push_back(first + k);
+                    }
+                    auto key_text = [&](std::uint32_t child) {
+                        return std::string_view(strings.data() + keys[child].offset, keys[child].length);
+                    };
+                    std::stable_sort(members.begin() + index, members.end(),
+                                     [&](std::uint32_t lhs, std::uint32_t rhs) {
+                                         return key_text(lhs) < key_text(rhs);
+                                     });
+                    node.payload |= static_cast<std::uint64_t>(index) << 32;
+                }
+                break;
+            }
+        }
+        nodes.push_back(node);
+    }
+    keys.resize(nodes.size(), KeyRef{0, 0});
+
+    // Pack the tables into one snapshot image
+    Header header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.byte_order = snapshot_byte_order;
+    header.node_count = nodes.size();
+    header.member_count = members.size();
+    header.strings_size = strings.size();
+
+    std::shared_ptr<JsonFrozenDocument> document(new JsonFrozenDocument());
+    std::size_t size = image_size(header);
+    document->storage_.reset(new std::uint64_t[(size + 7) / 8]);
+    char* image = reinterpret_cast<char*>(document->storage_.get());
+    std::memcpy(image, &header, sizeof(header));
+    std::memcpy(image + nodes_offset(header), nodes.data(), nodes.size() * sizeof(Node));
+    // An empty table may have no storage, and memcpy needs a valid source
+    if (!keys.empty()) {
+        std::memcpy(image + keys_offset(header), keys.data(), keys.size() * sizeof(KeyRef));
+    }
+    if (!members.empty()) {
+        std::memcpy(image + members_offset(header), members.data(), members.size() * sizeof(std::uint32_t));
+    }
+    if (!strings.empty()) {
+        std::memcpy(image + strings_offset(header), strings.data(), strings.size());
+    }
+    document->attach(image, size);
+    return document;
+}
+
+Result<std::shared_ptr<const JsonFrozenDocument>> JsonFrozenDocument::load(const std::string& path,
+                                                                           bool verify) {
+    using DocumentResult = Result<std::shared_ptr<const JsonFrozenDocument>>;
+    auto file = JsonMappedFile::open(path);
+    if (!file) {
+        return DocumentResult(file.error());
+    }
+
+    std::string_view image = file.value()->view();
+    if (reinterpret_cast<std::uintptr_t>(image.data()) % alignof(Node) != 0) {
+        // Read buffers are not guaranteed to be aligned; copy instead
+        return from_snapshot(image, verify);
+    }
+    if (!check_image(image, verify)) {
+        return DocumentResult(make_error_code(JsonErrorCode::ParseError));
+    }
+
+    std::shared_ptr<JsonFrozenDocument> document(new JsonFrozenDocument());
+    document->attach(image.data(), image.size());
+    document->file_ = std::move(file.value());
+    return DocumentResult(std::shared_ptr<const JsonFrozenDocument>(std::move(document)));
+}
+
+Result<std::shared_ptr<const JsonFrozenDocument>> JsonFrozenDocument::from_snapshot(std::string_view image,
+                                                                                    bool verify) {
+    using DocumentResult = Result<std::shared_ptr<const JsonFrozenDocument>>;
+    std::shared_ptr<JsonFrozenDocument> document(new JsonFrozenDocument());
+    document->storage_.reset(new std::uint64_t[(image.size() + 7) / 8]);
+    char* copy = reinterpret_cast<char*>(document->storage_.get());
+    if (!image.empty()) {
+        std::memcpy(copy, image.data(), image.size());
+    }
+    if (!check_image(std::string_view(copy, image.size()), verify)) {
+        return DocumentResult(make_error_code(JsonErrorCode::ParseError));
+    }
+    document->attach(copy, image.size());
+    return DocumentResult(std::shared_ptr<const JsonFrozenDocument>(std::move(document)));
+}
+
+Result<std::size_t> JsonFrozenDocument::save(const std::string& path) const {
+    std::FILE* output = std::fopen(path.c_str(), "wb");
+    if (!output) {
+        return Result<std::size_t>(make_error_code(JsonErrorCode::SerializationError));
+    }
+    bool written = std::fwrite(image_, 1, image_size_, output) == image_size_;
+    if (std::fclose(output) != 0 || !written) {
+        return Result<std::size_t>(make_error_code(JsonErrorCode::SerializationError));
+    }
+    return Result<std::size_t>(image_size_);
+}
+
+void JsonFrozenDocument::attach(const char* image, std::size_t size) noexcept {
+    Header header;
+    std::memcpy(&header, image, sizeof(header));
+    image_ = image;
+    image_size_ = size;
+    nodes_ = reinterpret_cast<const Node*>(image + nodes_offset(header));
+    keys_ = reinterpret_cast<const KeyRef*>(image + keys_offset(header));
+    members_ = reinterpret_cast<const std::uint32_t*>(image + members_offset(header));
+    strings_ = image + strings_offset(header);
+    node_count_ = static_cast<std::uint32_t>(header.node_count);
+}
+
+bool JsonFrozenDocument::check_image(std::string_view image, bool verify) noexcept {
+    Header header;
+    if (image.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0 ||
+        header.version != snapshot_version || header.byte_order != snapshot_byte_order ||
+        header.node_count == 0 || header.node_count >= no_index ||
+        header.member_count >= no_index || header.strings_size > UINT32_MAX ||
+        image.size() != image_size(header)) {
+        return false;
+    }
+    if (!verify) {
+        return true;
+    }
+
+    // Every reference must stay inside its table, and children must come
+    // after their parent so that walks terminate
+    const char* data = image.data();
+    const Node* nodes = reinterpret_cast<const Node*>(data + nodes_offset(header));
+    const KeyRef* keys = reinterpret_cast<const KeyRef*>(data + keys_offset(header));
+    const std::uint32_t* members = reinterpret_cast<const std::uint32_t*>(data + members_offset(header));
+    std::uint64_t node_count = header.node_count;
+    for (std::uint64_t i = 0; i < node_count; ++i) {
+        const Node& node = nodes[i];
+        switch (node.type) {
+            case JsonType::Null:
+            case JsonType::Boolean:
+            case JsonType::Number:
+                break;
+            case JsonType::String:
+                if (node.payload > header.strings_size || node.size > header.strings_size - node.payload) {
+                    return false;
+                }
+                break;
+            case JsonType::Array:
+            case JsonType::Object: {
+                std::uint64_t first = static_cast<std::uint32_t>(node.payload);
+                if (first <= i || first > node_count || node.size > node_count - first) {
+                    return false;
+                }
+                if (node.type == JsonType::Array) {
+                    if ((node.payload >> 32) != 0) {
+                        return false;
+                    }
+                    break;
+                }
+                for (std::uint64_t child = first; child < first + node.size; ++child) {
+                    const KeyRef& key = keys[child];
+                    if (key.offset > header.strings_size || key.length > header.strings_size - key.offset) {
+                        return false;
+                    }
+                }
+                if (node.size > JsonObjectMap::linear_limit) {
+                    std::uint64_t index = node.payload >> 32;
+                    if (index > header.member_count || node.size > header.member_count - index) {
+                        return false;
+                    }
+                    for (std::uint64_t k = index; k < index + node.size; ++k) {
+                        if (members[k] < first || members[k] >= first + node.size) {
+                            return false;
+                        }
+                    }
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+std::size_t JsonFrozenDocument::memory_usage() const noexcept {
+    return sizeof(*this) + image_size_;
+}
+
+std::uint32_t JsonFrozenDocument::find(std::uint32_t index, std::string_view key) const noexcept {
+    const Node& node = nodes_[index];
+    if (node.type != JsonType::Object) {
+        return no_index;
+    }
+
+    std::uint32_t first = first_child(node);
+    if (node.size <= JsonObjectMap::linear_limit) {
+        for (std::uint32_t child = first; child < first + node.size; ++child) {
+            if (key_of(child) == key) {
+                return child;
+            }
+        }
+        return no_index;
+    }
+
+    const std::uint32_t* begin = members_ + member_index(node);
+    const std::uint32_t* end = begin + node.size;
+    auto found = std::lower_bound(begin, end, key, [this](std::uint32_t child, std::string_view name) {
+        return key_of(child) < name;
+    });
+    if (found != end && key_of(*found) == key) {
+        return *found;
+    }
+    return no_index;
+}
+
+JsonRef<JsonValue> JsonFrozenDocument::thaw(std::uint32_t index) const {
+    const Node& node = nodes_[index];
+    switch (node.type) {
+        case JsonType::Null:
+            return JsonNull::create();
+        case JsonType::Boolean:
+            return JsonBoolean::create(node.flag);
+        case JsonType::Number:
+            if (node.flag) {
+                return JsonNumber::create(node.integer);
+            }
+            return JsonNumber::create(node.real);
+        case JsonType::String:
+            return make_value<JsonStringValue>(std::string_view(strings_ + node.payload, node.size));
+        case JsonType::Array: {
+            auto array = JsonArray::create();
+            array->reserve(node.size);
+            for (std::uint32_t k = 0; k < node.size; ++k) {
+                array->push_back(thaw(first_child(node) + k));
+            }
+            return array;
+        }
+        case JsonType::Object: {
+            auto object = JsonObject::create();
+            object->reserve(node.size);
+            for (std::uint32_t k = 0; k < node.size; ++k) {
+                std::uint32_t child = first_child(node) + k;
+                object->set(key_of(child), thaw(child));
+            }
+            return object;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace jansson
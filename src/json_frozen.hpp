@@ -0,0 +1,255 @@
+#ifndef JSON_FROZEN_HPP
+#define JSON_FROZEN_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_value.hpp"
+#include "json_error.hpp"
+#include "json_file.hpp"
+
+namespace jansson {
+
+class JsonFrozenDocument;
+
+// A value inside a JsonFrozenDocument. Handles are two words, cheap to
+// copy, and stay valid as long as the document they came from; reading
+// through them never touches a reference count.
+//
+// A default-constructed handle (and the result of a failed find()) is
+// empty and converts to false; calling accessors on it is undefined.
+class JsonFrozenValue {
+public:
+    JsonFrozenValue() noexcept = default;
+
+    explicit operator bool() const noexcept { return document_ != nullptr; }
+
+    JsonType type() const noexcept;
+
+    bool is_null() const noexcept { return type() == JsonType::Null; }
+    bool is_boolean() const noexcept { return type() == JsonType::Boolean; }
+    bool is_number() const noexcept { return type() == JsonType::Number; }
+    bool is_string() const noexcept { return type() == JsonType::String; }
+    bool is_array() const noexcept { return type() == JsonType::Array; }
+    bool is_object() const noexcept { return type() == JsonType::Object; }
+    bool is_integer() const noexcept;
+    bool is_real() const noexcept;
+
+    // Value access (will throw if wrong type)
+    bool boolean_value() const;
+    double number_value() const;
+    std::int64_t integer_value() const;
+    std::string_view string_value() const;
+
+    // Number of elements or members (0 for scalars)
+    std::size_t size() const noexcept;
+
+    // Element of an array, or value of the index-th member of an object
+    // (throws JsonException when out of bounds)
+    JsonFrozenValue at(std::size_t index) const;
+
+    // Name of the index-th member of an object, in insertion order
+    // (throws JsonException when out of bounds)
+    std::string_view key_at(std::size_t index) const;
+
+    // Member of an object; empty if missing or not an object
+    JsonFrozenValue find(std::string_view key) const noexcept;
+    bool contains(std::string_view key) const noexcept { return static_cast<bool>(find(key)); }
+
+    // Build an ordinary (mutable, heap-allocated) tree from this value
+    JsonRef<JsonValue> thaw() const;
+
+private:
+    friend class JsonFrozenDocument;
+
+    JsonFrozenValue(const JsonFrozenDocument* document, std::uint32_t node) noexcept
+        : document_(document), node_(node) {}
+
+    const JsonFrozenDocument* document_ = nullptr;
+    std::uint32_t node_ = 0;
+};
+
+// Immutable, compacted copy of a JSON tree.
+//
+// freeze() lays the whole tree out in a few flat tables: 16-byte node
+// records in breadth-first order (so the children of a container are
+// contiguous and at() is O(1)), one buffer holding every string and key
+// (keys are stored once however many objects use them), and a sorted
+// member index for objects larger than JsonHash's linear limit. Nothing
+// in it is ever written after freeze() returns, so any number of threads
+// may read one document concurrently without locks or reference count
+// traffic. Publish documents to readers through a JsonFrozenSlot.
+//
+// The tables hold offsets rather than pointers and sit in one contiguous
+// image, which is also the snapshot format: save() writes the image as it
+// is and load() maps a saved image back and reads it in place, so a
+// document is available without any parsing. Snapshots are in the native
+// byte order of the host that wrote them and are rejected elsewhere.
+class JsonFrozenDocument {
+public:
+    JsonFrozenDocument(const JsonFrozenDocument&) = delete;
+    JsonFrozenDocument& operator=(const JsonFrozenDocument&) = delete;
+
+    // Copy root into a new frozen document. The tree must not be modified
+    // while it is being frozen; it is not referenced afterwards.
+    static std::shared_ptr<const JsonFrozenDocument> freeze(const JsonValue& root);
+
+    // Map a snapshot written by save(). With verify, every offset in the
+    // image is bounds-checked first (one pass over the node table, no
+    // allocation); skip it only for files this process can trust, since a
+    // corrupt unverified image is undefined behavior to read. Fails with
+    // ParseError for anything that is not a snapshot of this format.
+    static Result<std::shared_ptr<const JsonFrozenDocument>> load(const std::string& path,
+                                                                  bool verify = true);
+
+    // Copy a snapshot image held in memory (e.g. received over the network)
+    static Result<std::shared_ptr<const JsonFrozenDocument>> from_snapshot(std::string_view image,
+                                                                           bool verify = true);
+
+    // Write snapshot() to path; the value is the number of bytes written
+    Result<std::size_t> save(const std::string& path) const;
+
+    // The snapshot image backing this document
+    std::string_view snapshot() const noexcept { return std::string_view(image_, image_size_); }
+
+    JsonFrozenValue root() const noexcept { return JsonFrozenValue(this, 0); }
+
+    // Number of values in the tree
+    std::size_t node_count() const noexcept { return node_count_; }
+
+    // Bytes held by the document
+    std::size_t memory_usage() const noexcept;
+
+    // Whether the image is a mapping of a snapshot file
+    bool is_mapped() const noexcept { return file_ && file_->is_mapped(); }
+
+private:
+    friend class JsonFrozenValue;
+
+    // Node payloads: a boolean or number for scalars, the offset of the
+    // bytes for strings, the first child for containers (objects also
+    // keep the offset of their sorted member index in the upper half)
+    struct Node {
+        JsonType type;
+        std::uint8_t flag;      // Boolean value, or number is an integer
+        std::uint32_t size;     // String length or number of children
+        union {
+            std::int64_t integer;
+            double real;
+            std::uint64_t payload;
+        };
+    };
+
+    // Member name of a node whose parent is an object
+    struct KeyRef {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    // Start of a snapshot image; the node, key, member and string tables
+    // follow in that order, each starting on an 8-byte boundary
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t node_count;
+        std::uint64_t member_count;
+        std::uint64_t strings_size;
+    };
+
+    static_assert(sizeof(Node) == 16, "frozen nodes are 16 bytes");
+    static_assert(sizeof(KeyRef) == 8, "frozen keys are 8 bytes");
+    static_assert(sizeof(Header) == 40, "snapshot header is 40 bytes");
+
+    static constexpr char snapshot_magic[8] = {'J', 'S', 'N', 'F', 'R', 'Z', '\r', '\n'};
+    static constexpr std::uint32_t snapshot_version = 1;
+    static constexpr std::uint32_t snapshot_byte_order = 0x01020304;
+    static constexpr std::uint32_t no_index = UINT32_MAX;
+
+    static std::size_t nodes_offset(const Header&) noexcept { return sizeof(Header); }
+    static std::size_t keys_offset(const Header& header) noexcept {
+        return nodes_offset(header) + header.node_count * sizeof(Node);
+    }
+    static std::size_t members_offset(const Header& header) noexcept {
+        return keys_offset(header) + header.node_count * sizeof(KeyRef);
+    }
+    static std::size_t strings_offset(const Header& header) noexcept {
+        return members_offset(header) + (header.member_count * sizeof(std::uint32_t) + 7) / 8 * 8;
+    }
+    static std::size_t image_size(const Header& header) noexcept {
+        return strings_offset(header) + header.strings_size;
+    }
+
+    // Whether image is a well-formed snapshot; only the header is checked
+    // without verify
+    static bool check_image(std::string_view image, bool verify) noexcept;
+
+    JsonFrozenDocument() = default;
+
+    // Point the tables into a checked image
+    void attach(const char* image, std::size_t size) noexcept;
+
+    std::uint32_t first_child(const Node& node) const noexcept {
+        return static_cast<std::uint32_t>(node.payload);
+    }
+    std::uint32_t member_index(const Node& node) const noexcept {
+        return static_cast<std::uint32_t>(node.payload >> 32);
+    }
+    std::string_view key_of(std::uint32_t node) const noexcept {
+        const KeyRef& key = keys_[node];
+        return std::string_view(strings_ + key.offset, key.length);
+    }
+
+    std::uint32_t find(std::uint32_t node, std::string_view key) const noexcept;
+    JsonRef<JsonValue> thaw(std::uint32_t node) const;
+
+    const Node* nodes_ = nullptr;
+    const KeyRef* keys_ = nullptr;     // Indexed like nodes_
+    const std::uint32_t* members_ = nullptr;
+    const char* strings_ = nullptr;
+    std::uint32_t node_count_ = 0;
+
+    // The image, and whichever of the two owns it
+    const char* image_ = nullptr;
+    std::size_t image_size_ = 0;
+    std::unique_ptr<std::uint64_t[]> storage_;
+    std::unique_ptr<JsonMappedFile> file_;
+};
+
+// Holder for the current version of a frozen document, read by many
+// threads and replaced by one (RCU style). load() takes one reference to
+// the current document, which stays valid for as long as the reader holds
+// it even if a new version is stored meanwhile; the old version is freed
+// when its last reader lets go.
+class JsonFrozenSlot {
+public:
+    JsonFrozenSlot() = default;
+    explicit JsonFrozenSlot(std::shared_ptr<const JsonFrozenDocument> document)
+        : document_(std::move(document)) {}
+
+    JsonFrozenSlot(const JsonFrozenSlot&) = delete;
+    JsonFrozenSlot& operator=(const JsonFrozenSlot&) = delete;
+
+    std::shared_ptr<const JsonFrozenDocument> load() const {
+        return std::atomic_load_explicit(&document_, std::memory_order_acquire);
+    }
+
+    void store(std::shared_ptr<const JsonFrozenDocument> document) {
+        std::atomic_store_explicit(&document_, std::move(document), std::memory_order_release);
+    }
+
+    // Install document and return the version it replaced
+    std::shared_ptr<const JsonFrozenDocument> exchange(std::shared_ptr<const JsonFrozenDocument> document) {
+        return std::atomic_exchange_explicit(&document_, std::move(document), std::memory_order_acq_rel);
+    }
+
+private:
+    std::shared_ptr<const JsonFrozenDocument> document_;
+};
+
+} // namespace jansson
+
+#endif // JSON_FROZEN_HPP
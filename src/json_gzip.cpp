@@ -0,0 +1,250 @@
+#include "json_gzip.hpp"
+#include "json_serializer.hpp"
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <zlib.h>
+
+namespace jansson {
+
+// Inflated output reaches the parser, and deflated output the downstream
+// writer, in blocks of this size
+static constexpr std::size_t block_size = 64 * 1024;
+
+// zlib counts input in 32-bit units, so larger chunks are fed in slices
+static constexpr std::size_t max_slice = 1u << 30;
+
+// Window bits selecting gzip or zlib framing, and automatic detection
+static constexpr int zlib_window_bits = 15;
+static constexpr int gzip_window_bits = 15 + 16;
+static constexpr int detect_window_bits = 15 + 32;
+
+// Closes a file left open when parsing or serializing throws
+struct FileCloser {
+    void operator()(std::FILE* file) const noexcept { std::fclose(file); }
+};
+using FileHandle = std::unique_ptr<std::FILE, FileCloser>;
+
+struct JsonGzipReader::Stream {
+    z_stream z{};
+
+    Stream() {
+        int status = inflateInit2(&z, detect_window_bits);
+        if (status == Z_MEM_ERROR) {
+            throw std::bad_alloc();
+        }
+        if (status != Z_OK) {
+            throw JsonException("Cannot initialize decompression");
+        }
+    }
+
+    ~Stream() {
+        inflateEnd(&z);
+    }
+};
+
+JsonGzipReader::JsonGzipReader(JsonStreamParser& parser)
+    : parser_(parser), stream_(new Stream()), output_(new char[block_size]) {}
+
+JsonGzipReader::~JsonGzipReader() = default;
+
+Result<std::size_t> JsonGzipReader::feed(std::string_view compressed) {
+    if (failed_) {
+        return Result<std::size_t>(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    
+    if (compressed.size() > max_slice) {
+        std::size_t completed = 0;
+        for (std::size_t offset = 0; offset < compressed.size(); offset += max_slice) {
+            auto fed = feed(compressed.substr(offset, max_slice));
+            if (!fed) {
+                return fed;
+            }
+            completed += fed.value();
+        }
+        return Result<std::size_t>(completed);
+    }
+    
+    z_stream& z = stream_->z;
+    z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    z.avail_in = static_cast<uInt>(compressed.size());
+    std::size_t completed = 0;
+    
+    while (z.avail_in > 0) {
+        if (member_done_) {
+            // Another gzip member follows the one that just ended
+            inflateReset(&z);
+            member_done_ = false;
+        }
+        
+        // Inflate until the input is used up and no output is pending
+        do {
+            z.next_out = reinterpret_cast<Bytef*>(output_.get());
+            z.avail_out = static_cast<uInt>(block_size);
+            int status = inflate(&z, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+                failed_ = true;
+                return Result<std::size_t>(make_error_code(JsonErrorCode::InvalidArgument));
+            }
+            
+            std::size_t produced = block_size - z.avail_out;
+            if (produced > 0) {
+                inflated_ += produced;
+                auto fed = parser_.feed(std::string_view(output_.get(), produced));
+                if (!fed) {
+                    failed_ = true;
+                    return Result<std::size_t>(fed.error());
+                }
+                completed += fed.value();
+            }
+            if (status == Z_STREAM_END) {
+                member_done_ = true;
+                break;
+            }
+        } while (z.avail_out == 0);
+    }
+    return Result<std::size_t>(completed);
+}
+
+Result<std::size_t> JsonGzipReader::finish() {
+    if (failed_ || !member_done_) {
+        // Corrupt, truncated or empty input
+        failed_ = true;
+        return Result<std::size_t>(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    return parser_.finish();
+}
+
+struct JsonGzipWriter::Stream {
+    z_stream z{};
+
+    Stream(JsonCompression format, int level) {
+        int bits = format == JsonCompression::Gzip ? gzip_window_bits : zlib_window_bits;
+        int status = deflateInit2(&z, level, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY);
+        if (status == Z_MEM_ERROR) {
+            throw std::bad_alloc();
+        }
+        if (status != Z_OK) {
+            throw JsonException("Invalid compression level");
+        }
+    }
+
+    ~Stream() {
+        deflateEnd(&z);
+    }
+};
+
+JsonGzipWriter::JsonGzipWriter(JsonWriter& out, JsonCompression format, int level, std::size_t chunk_size)
+    : JsonChunkedWriter(chunk_size),
+      out_(out),
+      stream_(new Stream(format, level)),
+      output_(new char[block_size]) {}
+
+JsonGzipWriter::~JsonGzipWriter() {
+    finish();
+}
+
+void JsonGzipWriter::finish() {
+    if (finished_) {
+        return;
+    }
+    flush();
+    if (!failed()) {
+        deflate_into(nullptr, 0, Z_FINISH);
+    }
+    finished_ = true;
+    out_.flush();
+}
+
+bool JsonGzipWriter::write_chunk(const char* data, std::size_t length) {
+    return !finished_ && deflate_into(data, length, Z_NO_FLUSH);
+}
+
+bool JsonGzipWriter::deflate_into(const char* data, std::size_t length, int flush) {
+    z_stream& z = stream_->z;
+    z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    z.avail_in = static_cast<uInt>(length);
+    while (true) {
+        z.next_out = reinterpret_cast<Bytef*>(output_.get());
+        z.avail_out = static_cast<uInt>(block_size);
+        int status = deflate(&z, flush);
+        if (status == Z_STREAM_ERROR) {
+            return false;
+        }
+        std::size_t produced = block_size - z.avail_out;
+        if (produced > 0) {
+            out_.write(output_.get(), produced);
+            compressed_ += produced;
+            if (out_.truncated()) {
+                return false;
+            }
+        }
+        if (flush == Z_FINISH ? status == Z_STREAM_END : z.avail_out != 0) {
+            return true;
+        }
+    }
+}
+
+Result<JsonRef<JsonValue>> parse_gzip_file(const std::string& path) {
+    using ParseResult = Result<JsonRef<JsonValue>>;
+    FileHandle file(std::fopen(path.c_str(), "rb"));
+    if (!file) {
+        return ParseResult(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    
+    JsonStreamParser parser;
+    JsonGzipReader reader(parser);
+    std::unique_ptr<char[]> block(new char[block_size]);
+    bool read_error = false;
+    while (true) {
+        std::size_t length = std::fread(block.get(), 1, block_size, file.get());
+        if (length == 0) {
+            read_error = std::ferror(file.get()) != 0;
+            break;
+        }
+        auto fed = reader.feed(std::string_view(block.get(), length));
+        if (!fed) {
+            return ParseResult(fed.error());
+        }
+    }
+    file.reset();
+    if (read_error) {
+        return ParseResult(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    
+    auto finished = reader.finish();
+    if (!finished) {
+        return ParseResult(finished.error());
+    }
+    if (parser.value_count() == 0) {
+        return ParseResult(make_error_code(JsonErrorCode::ParseError));
+    }
+    if (parser.value_count() > 1) {
+        // As with trailing characters after a document
+        return ParseResult(make_error_code(JsonErrorCode::SyntaxError));
+    }
+    return ParseResult(parser.take_value());
+}
+
+Result<bool> write_gzip_file(const std::string& path, const JsonValue& value,
+                             const JsonSerializeOptions& options, int level) {
+    FileHandle file(std::fopen(path.c_str(), "wb"));
+    if (!file) {
+        return Result<bool>(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    
+    bool failed;
+    {
+        JsonFileWriter file_writer(file.get());
+        JsonGzipWriter compressed(file_writer, JsonCompression::Gzip, level);
+        JsonSerializer::serialize(compressed, value, options);
+        compressed.finish();
+        failed = compressed.failed() || file_writer.failed();
+    }
+    if (std::fclose(file.release()) != 0 || failed) {
+        return Result<bool>(make_error_code(JsonErrorCode::SerializationError));
+    }
+    return Result<bool>(true);
+}
+
+} // namespace jansson
@@ -0,0 +1,107 @@
+#ifndef JSON_GZIP_HPP
+#define JSON_GZIP_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "json_error.hpp"
+#include "json_stream.hpp"
+#include "json_value.hpp"
+#include "json_writer.hpp"
+
+// Compressed JSON streams, available when the library is built with zlib
+// (JANSSON_HAVE_ZLIB=1, set by CMake when zlib is found). Data is inflated
+// and deflated block by block as it passes between the push parser or a
+// chunked writer and its source or sink, so a compressed document is never
+// held whole in memory, compressed or not.
+
+namespace jansson {
+
+enum class JsonCompression {
+    Gzip,   // RFC 1952, as written by gzip(1)
+    Zlib    // RFC 1950
+};
+
+// Inflates gzip or zlib data (told apart by its header) as it arrives and
+// feeds the JSON to a JsonStreamParser. Concatenated gzip members, as
+// produced by appending to a .gz file, are read as one stream.
+class JsonGzipReader {
+public:
+    explicit JsonGzipReader(JsonStreamParser& parser);
+    ~JsonGzipReader();
+
+    JsonGzipReader(const JsonGzipReader&) = delete;
+    JsonGzipReader& operator=(const JsonGzipReader&) = delete;
+
+    // Consume a chunk of compressed input. The value is the number of
+    // top-level values it completed. Fails with InvalidArgument for
+    // corrupt compressed data and with the parser's error for bad JSON.
+    Result<std::size_t> feed(std::string_view compressed);
+
+    // Signal the end of input: fails if the compressed stream is
+    // truncated, then finishes the parser
+    Result<std::size_t> finish();
+
+    JsonStreamParser& parser() noexcept { return parser_; }
+
+    // Bytes inflated so far
+    std::size_t bytes_inflated() const noexcept { return inflated_; }
+
+private:
+    struct Stream;
+
+    JsonStreamParser& parser_;
+    std::unique_ptr<Stream> stream_;
+    std::unique_ptr<char[]> output_;
+    std::size_t inflated_ = 0;
+    bool member_done_ = false;
+    bool failed_ = false;
+};
+
+// Writer that deflates its output into another writer, chunk by chunk.
+// The compressed stream is completed by finish() or the destructor; the
+// downstream writer is flushed then and must outlive this one. size()
+// counts the uncompressed JSON.
+class JsonGzipWriter : public JsonChunkedWriter {
+public:
+    explicit JsonGzipWriter(JsonWriter& out, JsonCompression format = JsonCompression::Gzip,
+                            int level = 6, std::size_t chunk_size = 64 * 1024);
+    ~JsonGzipWriter() override;
+
+    // Write the end of the compressed stream. Output written afterwards is
+    // dropped.
+    void finish();
+
+    // Compressed bytes handed to the downstream writer
+    std::size_t compressed_size() const noexcept { return compressed_; }
+
+protected:
+    bool write_chunk(const char* data, std::size_t length) override;
+
+private:
+    struct Stream;
+
+    // Deflate input with flush mode, passing output downstream
+    bool deflate_into(const char* data, std::size_t length, int flush);
+
+    JsonWriter& out_;
+    std::unique_ptr<Stream> stream_;
+    std::unique_ptr<char[]> output_;
+    std::size_t compressed_ = 0;
+    bool finished_ = false;
+};
+
+// Parse the gzip or zlib file at path, reading and inflating it block by
+// block. The file must hold one JSON value. Fails with InvalidArgument
+// when the file cannot be read or is not valid compressed data.
+Result<JsonRef<JsonValue>> parse_gzip_file(const std::string& path);
+
+// Write value to path as a gzip file, streaming it through the compressor
+Result<bool> write_gzip_file(const std::string& path, const JsonValue& value,
+                             const JsonSerializeOptions& options = JsonSerializeOptions(),
+                             int level = 6);
+
+} // namespace jansson
+
+#endif // JSON_GZIP_HPP
@@ -0,0 +1,43 @@
+#include "json_hash.hpp"
+#include <atomic>
+#include <chrono>
+#include <random>
+
+namespace jansson {
+
+namespace {
+
+std::atomic<std::uint64_t> requested_seed{0};
+
+std::uint64_t random_seed() noexcept {
+    try {
+        std::random_device device;
+        return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+    } catch (...) {
+        // No entropy source; fall back to the clock and an address, as the
+        // C library does with the time and process id
+        auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        return static_cast<std::uint64_t>(now) ^ reinterpret_cast<std::uintptr_t>(&requested_seed);
+    }
+}
+
+} // namespace
+
+namespace hash_detail {
+
+std::uint64_t initial_seed() noexcept {
+    std::uint64_t seed = requested_seed.load(std::memory_order_acquire);
+    if (seed == 0) {
+        seed = random_seed();
+    }
+    // Premixed once here, so hash_bytes does not start each hash with it
+    return seed ^ mix(seed ^ secret[0], secret[1]);
+}
+
+} // namespace hash_detail
+
+void set_hash_seed(std::uint64_t seed) noexcept {
+    requested_seed.store(seed, std::memory_order_release);
+}
+
+} // namespace jansson
@@ -1,12 +1,130 @@
 #ifndef JSON_HASH_HPP
 #define JSON_HASH_HPP
 
-#include <unordered_map>
-#include <string>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace jansson {
 
+// String hashing.
+//
+// Keys are hashed with a wyhash-style function: 64-bit multiply-xor rounds
+// over unaligned 8-byte reads, so a short key costs a few instructions.
+// The hash is keyed by a per-process seed, drawn from std::random_device
+// unless set_hash_seed chose one, so the colliding keys a client would
+// need to degrade a table to a linear scan cannot be computed in advance.
+// Hashes therefore differ between runs and must not be persisted.
+
+namespace hash_detail {
+
+constexpr std::uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                     0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+// The seed requested with set_hash_seed, or a random one
+std::uint64_t initial_seed() noexcept;
+
+inline void multiply(std::uint64_t& a, std::uint64_t& b) noexcept {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    a = static_cast<std::uint64_t>(product);
+    b = static_cast<std::uint64_t>(product >> 64);
+#else
+    std::uint64_t a_high = a >> 32, a_low = static_cast<std::uint32_t>(a);
+    std::uint64_t b_high = b >> 32, b_low = static_cast<std::uint32_t>(b);
+    std::uint64_t high = a_high * b_high, middle1 = a_high * b_low;
+    std::uint64_t middle2 = a_low * b_high, low = a_low * b_low;
+    std::uint64_t t = low + (middle1 << 32);
+    std::uint64_t carry = t < low;
+    std::uint64_t result_low = t + (middle2 << 32);
+    carry += result_low < t;
+    a = result_low;
+    b = high + (middle1 >> 32) + (middle2 >> 32) + carry;
+#endif
+}
+
+inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) noexcept {
+    multiply(a, b);
+    return a ^ b;
+}
+
+inline std::uint64_t read64(const unsigned char* p) noexcept {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint64_t read32(const unsigned char* p) noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+} // namespace hash_detail
+
+// Seed of every string hash in this process, fixed on first use
+inline std::uint64_t hash_seed() noexcept {
+    static const std::uint64_t seed = hash_detail::initial_seed();
+    return seed;
+}
+
+// Choose the seed (0 picks a random one). Only effective before the first
+// string is hashed: tables built under one seed cannot be searched under
+// another.
+void set_hash_seed(std::uint64_t seed) noexcept;
+
+inline std::size_t hash_bytes(std::string_view bytes) noexcept {
+    using namespace hash_detail;
+    const auto* p = reinterpret_cast<const unsigned char*>(bytes.data());
+    std::size_t length = bytes.size();
+    std::uint64_t seed = hash_seed();
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+    if (length <= 16) {
+        if (length >= 4) {
+            std::size_t step = (length >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + step);
+            b = (read32(p + length - 4) << 32) | read32(p + length - 4 - step);
+        } else if (length > 0) {
+            a = (std::uint64_t(p[0]) << 16) | (std::uint64_t(p[length >> 1]) << 8) | p[length - 1];
+        }
+    } else {
+        std::size_t remaining = length;
+        if (remaining > 48) {
+            std::uint64_t seed1 = seed;
+            std::uint64_t seed2 = seed;
+            do {
+                seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                seed1 = mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ seed1);
+                seed2 = mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ seed2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (remaining > 16) {
+            seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        a = read64(p + remaining - 16);
+        b = read64(p + remaining - 8);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    multiply(a, b);
+    return static_cast<std::size_t>(mix(a ^ secret[0] ^ length, b ^ secret[1]));
+}
+
 // Custom hash function for strings
 template <typename T>
 struct JsonStringHash {
@@ -15,6 +133,13 @@ struct JsonStringHash {
     }
 };
 
+template <>
+struct JsonStringHash<std::string_view> {
+    std::size_t operator()(std::string_view key) const noexcept {
+        return hash_bytes(key);
+    }
+};
+
 // Custom equality comparison for strings
 template <typename T>
 struct JsonStringEqual {
@@ -23,7 +148,62 @@ struct JsonStringEqual {
     }
 };
 
-// JSON hash table implementation
+// std::string keys hash and compare as string_view, so lookups with a
+// string_view or a C string need no temporary std::string
+template <>
+struct JsonStringHash<std::string> {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view key) const noexcept {
+        return hash_bytes(key);
+    }
+};
+
+template <>
+struct JsonStringEqual<std::string> {
+    using is_transparent = void;
+
+    bool operator()(std::string_view lhs, std::string_view rhs) const noexcept {
+        return lhs == rhs;
+    }
+};
+
+template <typename T, typename = void>
+struct JsonIsTransparent : std::false_type {};
+
+template <typename T>
+struct JsonIsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+// Slot of a JsonHash index: entry position and the low bits of its hash
+struct JsonHashSlot {
+    std::uint32_t entry;
+    std::uint32_t hash;
+};
+
+// Immutable index that tables holding the same keys in the same order can
+// share (see JsonShape)
+struct JsonHashIndex {
+    std::vector<JsonHashSlot> slots;
+};
+
+// JSON hash table implementation.
+//
+// Entries live in a dense vector in insertion order, so iteration (and
+// therefore serialization) is deterministic, and walking an object touches
+// contiguous memory. Small tables are searched linearly; once a table
+// outgrows linear_limit entries, an open-addressing index of (entry,
+// hash) slots with linear probing is built next to the entries.
+// Assigning to an existing key keeps its position. Erasing preserves the
+// order of the remaining entries and is linear in the size of the table.
+//
+// Unlike std::unordered_map, inserting may move entries, invalidating
+// iterators and references. Keys must not be modified through iterators.
+// When Hash and KeyEqual are transparent, lookup, erase and operator[]
+// also accept any type they can hash and compare against a Key.
+//
+// Tables with identical key layouts can share one immutable index
+// (share_index / adopt_index); a table copies the shared index back into
+// its own storage before its key set changes.
 template <
     typename Key,
     typename Value,
@@ -34,98 +214,392 @@ class JsonHash {
 public:
     using key_type = Key;
     using mapped_type = Value;
-    using value_type = std::pair<const Key, Value>;
+    using value_type = std::pair<Key, Value>;
     using size_type = std::size_t;
-    using iterator = typename std::unordered_map<Key, Value, Hash, KeyEqual>::iterator;
-    using const_iterator = typename std::unordered_map<Key, Value, Hash, KeyEqual>::const_iterator;
-    
-    // Constructors
+    using entry_vector = std::pmr::vector<value_type>;
+    using iterator = typename entry_vector::iterator;
+    using const_iterator = typename entry_vector::const_iterator;
+
+    // Tables up to this size have no index
+    static constexpr size_type linear_limit = 8;
+
+private:
+    // Enables the heterogeneous overloads for a lookup argument of type K
+    template <typename K>
+    using if_transparent = std::enable_if_t<
+        JsonIsTransparent<Hash>::value && JsonIsTransparent<KeyEqual>::value &&
+        !std::is_convertible_v<const K&, const_iterator>, int>;
+
+public:
+
+    // Constructors (storage comes from the given memory resource, or the
+    // default resource)
     JsonHash() = default;
-    explicit JsonHash(std::size_t bucket_count)
-        : map_(bucket_count) {}
-    
+    explicit JsonHash(size_type capacity) {
+        reserve(capacity);
+    }
+    explicit JsonHash(std::pmr::memory_resource* resource)
+        : entries_(resource), index_(resource) {}
+    JsonHash(size_type capacity, std::pmr::memory_resource* resource)
+        : entries_(resource), index_(resource) {
+        reserve(capacity);
+    }
+
     // Insertion
     std::pair<iterator, bool> insert(const value_type& value) {
-        return map_.insert(value);
+        return try_emplace(value.first, value.second);
     }
-    
+
     std::pair<iterator, bool> insert(value_type&& value) {
-        return map_.insert(std::move(value));
+        return try_emplace(std::move(value.first), std::move(value.second));
     }
-    
+
     template <typename... Args>
     std::pair<iterator, bool> emplace(Args&&... args) {
-        return map_.emplace(std::forward<Args>(args)...);
+        value_type value(std::forward<Args>(args)...);
+        return insert(std::move(value));
     }
-    
+
+    // Insert key with a value built from args unless it is already present
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        std::size_t hash = 0;
+        size_type found = lookup(key, hash);
+        if (found != npos) {
+            return {entries_.begin() + found, false};
+        }
+        detach();
+        entries_.emplace_back(std::piecewise_construct,
+                              std::forward_as_tuple(std::forward<K>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        index_entry(entries_.size() - 1, hash);
+        return {entries_.end() - 1, true};
+    }
+
     // Access
     Value& at(const Key& key) {
-        return map_.at(key);
+        size_type found = find_index(key);
+        if (found == npos) {
+            throw std::out_of_range("JsonHash::at");
+        }
+        return entries_[found].second;
     }
-    
+
     const Value& at(const Key& key) const {
-        return map_.at(key);
+        size_type found = find_index(key);
+        if (found == npos) {
+            throw std::out_of_range("JsonHash::at");
+        }
+        return entries_[found].second;
+    }
+
+    template <typename K, if_transparent<K> = 0>
+    Value& at(const K& key) {
+        size_type found = find_index(key);
+        if (found == npos) {
+            throw std::out_of_range("JsonHash::at");
+        }
+        return entries_[found].second;
+    }
+
+    template <typename K, if_transparent<K> = 0>
+    const Value& at(const K& key) const {
+        size_type found = find_index(key);
+        if (found == npos) {
+            throw std::out_of_range("JsonHash::at");
+        }
+        return entries_[found].second;
     }
-    
+
     Value& operator[](const Key& key) {
-        return map_[key];
+        return try_emplace(key).first->second;
+    }
+
+    Value& operator[](Key&& key) {
+        return try_emplace(std::move(key)).first->second;
     }
-    
+
+    template <typename K, if_transparent<K> = 0>
+    Value& operator[](const K& key) {
+        return try_emplace(key).first->second;
+    }
+
     // Lookup
     iterator find(const Key& key) {
-        return map_.find(key);
+        size_type found = find_index(key);
+        return found == npos ? entries_.end() : entries_.begin() + found;
     }
-    
+
     const_iterator find(const Key& key) const {
-        return map_.find(key);
+        size_type found = find_index(key);
+        return found == npos ? entries_.end() : entries_.begin() + found;
     }
-    
+
     bool contains(const Key& key) const {
-        return map_.find(key) != map_.end();
+        return find_index(key) != npos;
+    }
+
+    template <typename K, if_transparent<K> = 0>
+    iterator find(const K& key) {
+        size_type found = find_index(key);
+        return found == npos ? entries_.end() : entries_.begin() + found;
+    }
+
+    template <typename K, if_transparent<K> = 0>
+    const_iterator find(const K& key) const {
+        size_type found = find_index(key);
+        return found == npos ? entries_.end() : entries_.begin() + found;
+    }
+
+    template <typename K, if_transparent<K> = 0>
+    bool contains(const K& key) const {
+        return find_index(key) != npos;
     }
-    
+
     // Erase
     size_type erase(const Key& key) {
-        return map_.erase(key);
+        size_type found = find_index(key);
+        if (found == npos) {
+            return 0;
+        }
+        erase_entry(found);
+        return 1;
+    }
+
+    template <typename K, if_transparent<K> = 0>
+    size_type erase(const K& key) {
+        size_type found = find_index(key);
+        if (found == npos) {
+            return 0;
+        }
+        erase_entry(found);
+        return 1;
     }
-    
+
     iterator erase(iterator pos) {
-        return map_.erase(pos);
+        return erase(const_iterator(pos));
     }
-    
+
+    iterator erase(const_iterator pos) {
+        size_type entry = static_cast<size_type>(pos - entries_.cbegin());
+        erase_entry(entry);
+        return entries_.begin() + entry;
+    }
+
     // Size
     bool empty() const noexcept {
-        return map_.empty();
+        return entries_.empty();
     }
-    
+
     size_type size() const noexcept {
-        return map_.size();
+        return entries_.size();
+    }
+
+    // Bytes of entry and index storage owned by this table; an index shared
+    // with other tables is not included
+    size_type storage_bytes() const noexcept {
+        return entries_.capacity() * sizeof(value_type) + index_.capacity() * sizeof(JsonHashSlot);
     }
-    
-    // Iteration
+
+    // Make room for capacity entries without reallocating
+    void reserve(size_type capacity) {
+        detach();
+        entries_.reserve(capacity);
+        if (capacity > linear_limit && slots_for(capacity) > index_.size()) {
+            rebuild_index(slots_for(capacity));
+        }
+    }
+
+    // Iteration, in insertion order
     iterator begin() noexcept {
-        return map_.begin();
+        return entries_.begin();
     }
-    
+
     const_iterator begin() const noexcept {
-        return map_.begin();
+        return entries_.begin();
     }
-    
+
     iterator end() noexcept {
-        return map_.end();
+        return entries_.end();
     }
-    
+
     const_iterator end() const noexcept {
-        return map_.end();
+        return entries_.end();
     }
-    
+
     // Clear
     void clear() noexcept {
-        map_.clear();
+        entries_.clear();
+        index_.clear();
+        shared_index_.reset();
+    }
+
+    // The index as an immutable object other tables with the same keys in
+    // the same order may adopt. Null while the table is searched linearly.
+    std::shared_ptr<const JsonHashIndex> share_index() {
+        if (!shared_index_ && !index_.empty()) {
+            auto index = std::make_shared<JsonHashIndex>();
+            index->slots.assign(index_.begin(), index_.end());
+            shared_index_ = std::move(index);
+            index_.clear();
+            index_.shrink_to_fit();
+        }
+        return shared_index_;
+    }
+
+    // Use an index from share_index() on a table with the same keys in the
+    // same order instead of this table's own
+    void adopt_index(std::shared_ptr<const JsonHashIndex> index) noexcept {
+        if (index) {
+            shared_index_ = std::move(index);
+            index_.clear();
+            index_.shrink_to_fit();
+        }
+    }
+
+    bool shares_index() const noexcept {
+        return shared_index_ != nullptr;
     }
 
 private:
-    std::unordered_map<Key, Value, Hash, KeyEqual> map_;
+    static constexpr size_type npos = static_cast<size_type>(-1);
+    static constexpr std::uint32_t empty_slot = UINT32_MAX;
+
+    using Slot = JsonHashSlot;
+
+    const Slot* slots() const noexcept {
+        return shared_index_ ? shared_index_->slots.data() : index_.data();
+    }
+
+    size_type slot_count() const noexcept {
+        return shared_index_ ? shared_index_->slots.size() : index_.size();
+    }
+
+    // Take a private copy of a shared index before changing the key set
+    void detach() {
+        if (shared_index_) {
+            index_.assign(shared_index_->slots.begin(), shared_index_->slots.end());
+            shared_index_.reset();
+        }
+    }
+
+    // Index size keeping the load factor at or below 3/4
+    static size_type slots_for(size_type count) noexcept {
+        size_type slots = 16;
+        while (slots * 3 < count * 4) {
+            slots *= 2;
+        }
+        return slots;
+    }
+
+    size_type home(std::uint32_t hash) const noexcept {
+        return hash & (slot_count() - 1);
+    }
+
+    template <typename K>
+    size_type find_index(const K& key) const {
+        std::size_t hash = 0;
+        return lookup(key, hash);
+    }
+
+    // Entry holding key, or npos. Sets hash when the table is indexed so
+    // an insertion that follows does not hash the key again.
+    template <typename K>
+    size_type lookup(const K& key, std::size_t& hash) const {
+        size_type count = slot_count();
+        if (count == 0) {
+            for (size_type i = 0; i < entries_.size(); ++i) {
+                if (equal_(entries_[i].first, key)) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        hash = hasher_(key);
+        std::uint32_t tag = static_cast<std::uint32_t>(hash);
+        const Slot* table = slots();
+        size_type mask = count - 1;
+        for (size_type pos = home(tag);; pos = (pos + 1) & mask) {
+            const Slot& slot = table[pos];
+            if (slot.entry == empty_slot) {
+                return npos;
+            }
+            if (slot.hash == tag && equal_(entries_[slot.entry].first, key)) {
+                return slot.entry;
+            }
+        }
+    }
+
+    // Add a slot for a newly appended entry
+    void index_entry(size_type entry, std::size_t hash) {
+        if (index_.empty()) {
+            if (entries_.size() > linear_limit) {
+                rebuild_index(slots_for(entries_.size()));
+            }
+            return;
+        }
+        if (entries_.size() * 4 > index_.size() * 3) {
+            rebuild_index(index_.size() * 2);
+            return;
+        }
+        place(static_cast<std::uint32_t>(entry), static_cast<std::uint32_t>(hash));
+    }
+
+    void place(std::uint32_t entry, std::uint32_t hash) noexcept {
+        size_type mask = index_.size() - 1;
+        size_type pos = home(hash);
+        while (index_[pos].entry != empty_slot) {
+            pos = (pos + 1) & mask;
+        }
+        index_[pos] = Slot{entry, hash};
+    }
+
+    void rebuild_index(size_type slots) {
+        index_.assign(slots, Slot{empty_slot, 0});
+        for (size_type i = 0; i < entries_.size(); ++i) {
+            place(static_cast<std::uint32_t>(i),
+                  static_cast<std::uint32_t>(hasher_(entries_[i].first)));
+        }
+    }
+
+    void erase_entry(size_type entry) {
+        detach();
+        if (!index_.empty()) {
+            size_type mask = index_.size() - 1;
+            size_type hole = home(static_cast<std::uint32_t>(hasher_(entries_[entry].first)));
+            while (index_[hole].entry != entry) {
+                hole = (hole + 1) & mask;
+            }
+
+            // Backward-shift deletion: pull later slots of the probe run
+            // into the hole unless that would move them before their home
+            for (size_type pos = (hole + 1) & mask; index_[pos].entry != empty_slot; pos = (pos + 1) & mask) {
+                size_type ideal = home(index_[pos].hash);
+                bool movable = hole <= pos ? (ideal <= hole || ideal > pos)
+                                           : (ideal <= hole && ideal > pos);
+                if (movable) {
+                    index_[hole] = index_[pos];
+                    hole = pos;
+                }
+            }
+            index_[hole].entry = empty_slot;
+
+            // Later entries shift down by one
+            for (Slot& slot : index_) {
+                if (slot.entry != empty_slot && slot.entry > entry) {
+                    slot.entry--;
+                }
+            }
+        }
+        entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(entry));
+    }
+
+    entry_vector entries_;
+    std::pmr::vector<Slot> index_;
+    std::shared_ptr<const JsonHashIndex> shared_index_;
+    Hash hasher_;
+    KeyEqual equal_;
 };
 
 } // namespace jansson
@@ -0,0 +1,118 @@
+#include "json_key.hpp"
+#include "memory_policy.hpp"
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace jansson {
+
+// JsonKey implementation
+JsonKey::JsonKey(std::string_view text)
+    : record_(allocate(text, hash_bytes(text))) {}
+
+JsonKey::Record* JsonKey::allocate(std::string_view text, std::size_t hash) {
+    if (text.size() >= UINT32_MAX) {
+        throw std::length_error("JsonKey: key too long");
+    }
+
+    void* memory = allocate_memory(offsetof(Record, data) + text.size() + 1);
+    Record* record = static_cast<Record*>(memory);
+    new (&record->refs) std::atomic<std::uint32_t>(1);
+    record->length = static_cast<std::uint32_t>(text.size());
+    record->hash = hash;
+    if (!text.empty()) {
+        std::memcpy(record->data, text.data(), text.size());
+    }
+    record->data[text.size()] = '\0';
+    return record;
+}
+
+JsonKey::Record* JsonKey::empty_record() noexcept {
+    // Holds a reference of its own, so it is never destroyed
+    static Record record{{1}, 0, hash_bytes(std::string_view()), {'\0'}};
+    return &record;
+}
+
+void JsonKey::destroy(Record* record) noexcept {
+    std::size_t size = offsetof(Record, data) + record->length + 1;
+    record->refs.~atomic();
+    deallocate_memory(record, size);
+}
+
+// JsonKeyTable implementation
+JsonKeyTable::~JsonKeyTable() {
+    clear();
+}
+
+JsonKey JsonKeyTable::intern(std::string_view text) {
+    if (synchronized_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return intern_locked(text);
+    }
+    return intern_locked(text);
+}
+
+JsonKey JsonKeyTable::intern_locked(std::string_view text) {
+    auto it = records_.find(text);
+    if (it != records_.end()) {
+        return JsonKey(it->second);
+    }
+
+    // The table holds the initial reference; the key is keyed by a view of
+    // the record's own bytes
+    JsonKey::Record* record = JsonKey::allocate(text, hash_bytes(text));
+    try {
+        records_.try_emplace(std::string_view(record->data, record->length), record);
+    } catch (...) {
+        JsonKey::destroy(record);
+        throw;
+    }
+    return JsonKey(record);
+}
+
+std::size_t JsonKeyTable::size() const {
+    if (synchronized_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_.size();
+    }
+    return records_.size();
+}
+
+void JsonKeyTable::purge() {
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    if (synchronized_) {
+        lock.lock();
+    }
+
+    JsonHash<std::string_view, JsonKey::Record*> kept;
+    kept.reserve(records_.size());
+    for (const auto& entry : records_) {
+        // Only the table refers to the record; nobody else can copy it
+        // while the lock is held
+        if (entry.second->refs.load(std::memory_order_acquire) == 1) {
+            JsonKey::release(entry.second);
+        } else {
+            kept.try_emplace(entry.first, entry.second);
+        }
+    }
+    records_ = std::move(kept);
+}
+
+void JsonKeyTable::clear() {
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    if (synchronized_) {
+        lock.lock();
+    }
+
+    for (const auto& entry : records_) {
+        JsonKey::release(entry.second);
+    }
+    records_.clear();
+}
+
+JsonKeyTable& JsonKeyTable::global() {
+    static JsonKeyTable table(true);
+    return table;
+}
+
+} // namespace jansson
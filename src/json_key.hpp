@@ -0,0 +1,194 @@
+#ifndef JSON_KEY_HPP
+#define JSON_KEY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "json_hash.hpp"
+
+namespace jansson {
+
+class JsonKeyTable;
+
+// Object member name.
+//
+// A key is a single pointer to an immutable, reference-counted record that
+// holds the bytes (NUL-terminated) and their hash. Copying a key shares the
+// record, so keys interned through a JsonKeyTable are stored once however
+// many objects use them, compare equal by pointer and are never rehashed.
+// A moved-from key may only be assigned to or destroyed.
+class JsonKey {
+public:
+    // The empty key; shares a static record and does not allocate
+    JsonKey() noexcept : record_(empty_record()) {
+        retain(record_);
+    }
+    explicit JsonKey(std::string_view text);
+
+    JsonKey(const JsonKey& other) noexcept : record_(other.record_) {
+        retain(record_);
+    }
+    JsonKey(JsonKey&& other) noexcept : record_(other.record_) {
+        other.record_ = nullptr;
+    }
+    JsonKey& operator=(const JsonKey& other) noexcept {
+        retain(other.record_);
+        release(record_);
+        record_ = other.record_;
+        return *this;
+    }
+    JsonKey& operator=(JsonKey&& other) noexcept {
+        if (this != &other) {
+            release(record_);
+            record_ = other.record_;
+            other.record_ = nullptr;
+        }
+        return *this;
+    }
+    ~JsonKey() {
+        release(record_);
+    }
+
+    std::string_view view() const noexcept {
+        return std::string_view(record_->data, record_->length);
+    }
+    operator std::string_view() const noexcept { return view(); }
+
+    const char* c_str() const noexcept { return record_->data; }
+    std::size_t size() const noexcept { return record_->length; }
+    bool empty() const noexcept { return record_->length == 0; }
+    std::string str() const { return std::string(view()); }
+
+    // Hash of the bytes, equal to hash_bytes(view())
+    std::size_t hash() const noexcept { return record_->hash; }
+
+    // Whether both keys share one record (always true for equal keys
+    // interned in the same table)
+    bool same_record(const JsonKey& other) const noexcept { return record_ == other.record_; }
+
+    friend bool operator==(const JsonKey& lhs, const JsonKey& rhs) noexcept {
+        return lhs.record_ == rhs.record_ ||
+               (lhs.record_->hash == rhs.record_->hash && lhs.view() == rhs.view());
+    }
+    friend bool operator!=(const JsonKey& lhs, const JsonKey& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+    friend bool operator==(const JsonKey& lhs, std::string_view rhs) noexcept {
+        return lhs.view() == rhs;
+    }
+    friend bool operator==(std::string_view lhs, const JsonKey& rhs) noexcept {
+        return lhs == rhs.view();
+    }
+    friend bool operator!=(const JsonKey& lhs, std::string_view rhs) noexcept {
+        return lhs.view() != rhs;
+    }
+    friend bool operator!=(std::string_view lhs, const JsonKey& rhs) noexcept {
+        return lhs != rhs.view();
+    }
+
+private:
+    friend class JsonKeyTable;
+
+    struct Record {
+        std::atomic<std::uint32_t> refs;
+        std::uint32_t length;
+        std::size_t hash;
+        char data[1];
+    };
+
+    explicit JsonKey(Record* record) noexcept : record_(record) {
+        retain(record_);
+    }
+
+    static Record* allocate(std::string_view text, std::size_t hash);
+    static Record* empty_record() noexcept;
+
+    static void retain(Record* record) noexcept {
+        if (record) {
+            record->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void release(Record* record) noexcept {
+        if (record && record->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy(record);
+        }
+    }
+
+    static void destroy(Record* record) noexcept;
+
+    Record* record_;
+};
+
+// Keys hash through the cached value and compare by record first; lookups
+// with string_views are transparent.
+template <>
+struct JsonStringHash<JsonKey> {
+    using is_transparent = void;
+
+    std::size_t operator()(const JsonKey& key) const noexcept {
+        return key.hash();
+    }
+
+    std::size_t operator()(std::string_view key) const noexcept {
+        return hash_bytes(key);
+    }
+};
+
+template <>
+struct JsonStringEqual<JsonKey> {
+    using is_transparent = void;
+
+    bool operator()(const JsonKey& lhs, const JsonKey& rhs) const noexcept {
+        return lhs == rhs;
+    }
+
+    bool operator()(const JsonKey& lhs, std::string_view rhs) const noexcept {
+        return lhs.view() == rhs;
+    }
+};
+
+// Dictionary of interned keys.
+//
+// intern() returns the table's key for the given bytes, creating it on the
+// first request, so every object built from the table shares one record
+// per distinct name. Keys stay valid after the table is cleared or
+// destroyed. A table may be shared between threads only if it was created
+// synchronized.
+class JsonKeyTable {
+public:
+    explicit JsonKeyTable(bool synchronized = false) : synchronized_(synchronized) {}
+    ~JsonKeyTable();
+
+    JsonKeyTable(const JsonKeyTable&) = delete;
+    JsonKeyTable& operator=(const JsonKeyTable&) = delete;
+
+    JsonKey intern(std::string_view text);
+
+    // Number of distinct keys held
+    std::size_t size() const;
+
+    bool synchronized() const noexcept { return synchronized_; }
+
+    // Drop keys no longer used outside the table
+    void purge();
+
+    void clear();
+
+    // Process-wide synchronized table
+    static JsonKeyTable& global();
+
+private:
+    JsonKey intern_locked(std::string_view text);
+
+    bool synchronized_;
+    mutable std::mutex mutex_;
+    JsonHash<std::string_view, JsonKey::Record*> records_;
+};
+
+} // namespace jansson
+
+#endif // JSON_KEY_HPP
@@ -0,0 +1,265 @@
+#include "json_lazy.hpp"
+#include "json_parser.hpp"
+#include "json_simd.hpp"
+#include "string_utils.hpp"
+
+namespace jansson {
+
+// JsonLazyDocument implementation
+Result<JsonLazyValue> JsonLazyDocument::load(std::string_view input) {
+    input_.assign(input.data(), input.size());
+    index_.clear();
+    match_.clear();
+    cache_.clear();
+
+    if (!simd::validate_utf8(input_)) {
+        return Result<JsonLazyValue>(make_error_code(JsonErrorCode::InvalidUTF8));
+    }
+    if (!simd::build_structural_index(input_, index_) || index_.empty()) {
+        return Result<JsonLazyValue>(make_error_code(JsonErrorCode::SyntaxError));
+    }
+
+    // Pair brackets so skip() can jump over whole subtrees
+    match_.assign(index_.size(), no_match);
+    std::vector<std::uint32_t> open;
+    for (std::uint32_t entry = 0; entry < index_.size(); ++entry) {
+        char c = byte_at(entry);
+        if (c == '{' || c == '[') {
+            open.push_back(entry);
+        } else if (c == '}' || c == ']') {
+            if (open.empty() || byte_at(open.back()) != (c == '}' ? '{' : '[')) {
+                return Result<JsonLazyValue>(make_error_code(JsonErrorCode::SyntaxError));
+            }
+            match_[open.back()] = entry;
+            open.pop_back();
+        } else if (c == '"') {
+            // The closing quote is the next entry
+            ++entry;
+        }
+    }
+
+    if (!open.empty() || skip(0) != index_.size()) {
+        return Result<JsonLazyValue>(make_error_code(JsonErrorCode::SyntaxError));
+    }
+
+    return Result<JsonLazyValue>(root());
+}
+
+std::uint32_t JsonLazyDocument::skip(std::uint32_t entry) const noexcept {
+    switch (byte_at(entry)) {
+        case '{':
+        case '[':
+            return match_[entry] + 1;
+        case '"':
+            return entry + 2;
+        default:
+            return entry + 1;
+    }
+}
+
+void JsonLazyDocument::value_range(std::uint32_t entry, std::size_t& begin,
+                                   std::size_t& end) const noexcept {
+    begin = index_[entry];
+    switch (byte_at(entry)) {
+        case '{':
+        case '[':
+            end = index_[match_[entry]] + 1;
+            return;
+        case '"':
+            end = index_[entry + 1] + 1;
+            return;
+        default:
+            break;
+    }
+
+    // A scalar runs up to the next token, minus trailing whitespace
+    end = entry + 1 < index_.size() ? index_[entry + 1] : input_.size();
+    while (end > begin) {
+        char c = input_[end - 1];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        --end;
+    }
+}
+
+// JsonLazyValue implementation
+JsonType JsonLazyValue::type() const noexcept {
+    switch (document_->byte_at(entry_)) {
+        case '{': return JsonType::Object;
+        case '[': return JsonType::Array;
+        case '"': return JsonType::String;
+        case 't':
+        case 'f': return JsonType::Boolean;
+        case 'n': return JsonType::Null;
+        default: return JsonType::Number;
+    }
+}
+
+std::string_view JsonLazyValue::raw() const noexcept {
+    std::size_t begin, end;
+    document_->value_range(entry_, begin, end);
+    return std::string_view(document_->input_).substr(begin, end - begin);
+}
+
+Result<JsonLazyValue> JsonLazyValue::get(std::string_view key) const {
+    if (!is_object()) {
+        return Result<JsonLazyValue>(make_error_code(JsonErrorCode::InvalidType));
+    }
+
+    const JsonLazyDocument& doc = *document_;
+    std::string_view input = doc.input_;
+    std::uint32_t close = doc.match_[entry_];
+    std::uint32_t entry = entry_ + 1;
+
+    // Members are: key (two quote entries), ':', value, then ',' or '}'.
+    // The first member with a matching key wins.
+    while (entry < close) {
+        if (doc.byte_at(entry) != '"' || entry + 3 >= close || doc.byte_at(entry + 2) != ':') {
+            return Result<JsonLazyValue>(make_error_code(JsonErrorCode::SyntaxError));
+        }
+
+        std::size_t key_begin = doc.index_[entry] + 1;
+        std::string_view member = input.substr(key_begin, doc.index_[entry + 1] - key_begin);
+        bool found;
+        if (member.find('\\') == std::string_view::npos) {
+            found = member == key;
+        } else {
+            try {
+                found = JsonString::unescape(input.substr(key_begin - 1, member.size() + 2)) == key;
+            } catch (const JsonException&) {
+                return Result<JsonLazyValue>(make_error_code(JsonErrorCode::SyntaxError));
+            }
+        }
+
+        std::uint32_t value = entry + 3;
+        if (found) {
+            return Result<JsonLazyValue>(JsonLazyValue(document_, value));
+        }
+
+        entry = doc.skip(value);
+        if (entry < close) {
+            if (doc.byte_at(entry) != ',') {
+                return Result<JsonLazyValue>(make_error_code(JsonErrorCode::SyntaxError));
+            }
+            ++entry;
+        }
+    }
+
+    return Result<JsonLazyValue>(make_error_code(JsonErrorCode::KeyNotFound));
+}
+
+Result<JsonLazyValue> JsonLazyValue::at(std::size_t index) const {
+    if (!is_array()) {
+        return Result<JsonLazyValue>(make_error_code(JsonErrorCode::InvalidType));
+    }
+
+    const JsonLazyDocument& doc = *document_;
+    std::uint32_t close = doc.match_[entry_];
+    std::uint32_t entry = entry_ + 1;
+
+    for (std::size_t i = 0; entry < close; ++i) {
+        if (i == index) {
+            return Result<JsonLazyValue>(JsonLazyValue(document_, entry));
+        }
+
+        entry = doc.skip(entry);
+        if (entry < close) {
+            if (doc.byte_at(entry) != ',') {
+                return Result<JsonLazyValue>(make_error_code(JsonErrorCode::SyntaxError));
+            }
+            ++entry;
+        }
+    }
+
+    return Result<JsonLazyValue>(make_error_code(JsonErrorCode::IndexOutOfBounds));
+}
+
+Result<std::size_t> JsonLazyValue::size() const {
+    JsonType kind = type();
+    if (kind != JsonType::Array && kind != JsonType::Object) {
+        return Result<std::size_t>(std::size_t(0));
+    }
+
+    const JsonLazyDocument& doc = *document_;
+    std::uint32_t close = doc.match_[entry_];
+    std::uint32_t entry = entry_ + 1;
+    std::size_t count = 0;
+
+    while (entry < close) {
+        if (kind == JsonType::Object) {
+            if (doc.byte_at(entry) != '"' || entry + 3 >= close || doc.byte_at(entry + 2) != ':') {
+                return Result<std::size_t>(make_error_code(JsonErrorCode::SyntaxError));
+            }
+            entry += 3;
+        }
+
+        entry = doc.skip(entry);
+        ++count;
+        if (entry < close) {
+            if (doc.byte_at(entry) != ',') {
+                return Result<std::size_t>(make_error_code(JsonErrorCode::SyntaxError));
+            }
+            ++entry;
+        }
+    }
+
+    return Result<std::size_t>(count);
+}
+
+Result<JsonRef<JsonValue>> JsonLazyValue::materialize() const {
+    auto& cache = document_->cache_;
+    auto it = cache.find(entry_);
+    if (it != cache.end()) {
+        return Result<JsonRef<JsonValue>>(it->second);
+    }
+
+    auto result = JsonParser::parse(raw());
+    if (result) {
+        cache.emplace(entry_, result.value());
+    }
+    return result;
+}
+
+Result<std::string> JsonLazyValue::get_string() const {
+    if (!is_string()) {
+        return Result<std::string>(make_error_code(JsonErrorCode::InvalidType));
+    }
+    return materialize().map([](const JsonRef<JsonValue>& value) {
+        return value->string_value();
+    });
+}
+
+Result<std::int64_t> JsonLazyValue::get_integer() const {
+    if (!is_number()) {
+        return Result<std::int64_t>(make_error_code(JsonErrorCode::InvalidType));
+    }
+    auto value = materialize();
+    if (!value) {
+        return Result<std::int64_t>(value.error());
+    }
+    if (!value.value()->is_integer()) {
+        return Result<std::int64_t>(make_error_code(JsonErrorCode::InvalidType));
+    }
+    return Result<std::int64_t>(value.value()->integer_value());
+}
+
+Result<double> JsonLazyValue::get_number() const {
+    if (!is_number()) {
+        return Result<double>(make_error_code(JsonErrorCode::InvalidType));
+    }
+    return materialize().map([](const JsonRef<JsonValue>& value) {
+        return value->number_value();
+    });
+}
+
+Result<bool> JsonLazyValue::get_boolean() const {
+    if (!is_boolean()) {
+        return Result<bool>(make_error_code(JsonErrorCode::InvalidType));
+    }
+    return materialize().map([](const JsonRef<JsonValue>& value) {
+        return value->boolean_value();
+    });
+}
+
+} // namespace jansson
@@ -0,0 +1,118 @@
+#ifndef JSON_LAZY_HPP
+#define JSON_LAZY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "json_value.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+class JsonLazyDocument;
+
+// A value inside a JsonLazyDocument, identified by the structural index
+// entry of its first token. Handles are cheap to copy and stay valid as
+// long as the document they came from.
+//
+// Navigation (get, at, size) only walks the structural index; nothing is
+// decoded until a scalar is read or materialize() is called, and only the
+// bytes of that value are parsed.
+class JsonLazyValue {
+public:
+    JsonType type() const noexcept;
+
+    bool is_null() const noexcept { return type() == JsonType::Null; }
+    bool is_boolean() const noexcept { return type() == JsonType::Boolean; }
+    bool is_number() const noexcept { return type() == JsonType::Number; }
+    bool is_string() const noexcept { return type() == JsonType::String; }
+    bool is_array() const noexcept { return type() == JsonType::Array; }
+    bool is_object() const noexcept { return type() == JsonType::Object; }
+
+    // Member of an object
+    Result<JsonLazyValue> get(std::string_view key) const;
+
+    // Element of an array
+    Result<JsonLazyValue> at(std::size_t index) const;
+
+    // Number of elements or members (0 for scalars)
+    Result<std::size_t> size() const;
+
+    // Scalar values, parsed on demand
+    Result<std::string> get_string() const;
+    Result<std::int64_t> get_integer() const;
+    Result<double> get_number() const;
+    Result<bool> get_boolean() const;
+
+    // Source text of the value
+    std::string_view raw() const noexcept;
+
+    // Build the DOM subtree for this value. The result is cached by the
+    // document, so repeated calls return the same node.
+    Result<JsonRef<JsonValue>> materialize() const;
+
+private:
+    friend class JsonLazyDocument;
+
+    JsonLazyValue(const JsonLazyDocument* document, std::uint32_t entry) noexcept
+        : document_(document), entry_(entry) {}
+
+    const JsonLazyDocument* document_;
+    std::uint32_t entry_;
+};
+
+// A JSON text that is indexed at load time and parsed on demand, in the
+// spirit of simdjson's On-Demand API. load() runs the vectorized stage-1
+// pass and pairs every opening bracket with its closing bracket, so any
+// subtree can be skipped in O(1); values are only decoded when accessed.
+//
+// Syntax errors inside values that are never accessed are not reported.
+// The document is not safe to share between threads while values are
+// being materialized.
+class JsonLazyDocument {
+public:
+    JsonLazyDocument() = default;
+
+    JsonLazyDocument(const JsonLazyDocument&) = delete;
+    JsonLazyDocument& operator=(const JsonLazyDocument&) = delete;
+
+    // Copy and index input, replacing the current contents. Fails on
+    // malformed UTF-8, an unterminated string, unbalanced brackets or
+    // more than one top-level value.
+    Result<JsonLazyValue> load(std::string_view input);
+
+    // Root value (only meaningful after a successful load)
+    JsonLazyValue root() const noexcept { return JsonLazyValue(this, 0); }
+
+    // Bytes of input retained and number of indexed tokens
+    std::size_t input_size() const noexcept { return input_.size(); }
+    std::size_t structural_count() const noexcept { return index_.size(); }
+
+private:
+    friend class JsonLazyValue;
+
+    static constexpr std::uint32_t no_match = UINT32_MAX;
+
+    char byte_at(std::uint32_t entry) const noexcept { return input_[index_[entry]]; }
+
+    // Entry just past the value that starts at entry
+    std::uint32_t skip(std::uint32_t entry) const noexcept;
+
+    // Byte range [begin, end) of the value that starts at entry
+    void value_range(std::uint32_t entry, std::size_t& begin, std::size_t& end) const noexcept;
+
+    std::string input_;
+    std::vector<std::uint32_t> index_;
+
+    // For an opening bracket, the entry of its closing bracket
+    std::vector<std::uint32_t> match_;
+
+    mutable std::unordered_map<std::uint32_t, JsonRef<JsonValue>> cache_;
+};
+
+} // namespace jansson
+
+#endif // JSON_LAZY_HPP
@@ -0,0 +1,140 @@
+#include "json_lines.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace jansson {
+
+namespace {
+
+// One chunk of lines and, once parsed, its records
+struct LineChunk {
+    std::string_view text;
+    std::vector<std::size_t> lines;
+    std::vector<Result<JsonRef<JsonValue>>> records;
+    std::size_t line_count = 0;
+    bool done = false;
+};
+
+bool is_blank(std::string_view line) {
+    for (char c : line) {
+        if (c != ' ' && c != '\t' && c != '\r') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Cut input into pieces of about chunk_size bytes ending after a newline
+std::vector<LineChunk> split_chunks(std::string_view input, std::size_t chunk_size) {
+    std::vector<LineChunk> chunks;
+    std::size_t begin = 0;
+    while (begin < input.size()) {
+        std::size_t end = begin + chunk_size;
+        if (end >= input.size()) {
+            end = input.size();
+        } else {
+            const void* newline = std::memchr(input.data() + end, '\n', input.size() - end);
+            end = newline ? static_cast<const char*>(newline) - input.data() + 1 : input.size();
+        }
+        chunks.emplace_back();
+        chunks.back().text = input.substr(begin, end - begin);
+        begin = end;
+    }
+    return chunks;
+}
+
+void parse_chunk(LineChunk& chunk, const JsonParseOptions& options) {
+    std::string_view text = chunk.text;
+    std::size_t line = 0;
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+        const void* newline = std::memchr(text.data() + begin, '\n', text.size() - begin);
+        std::size_t end = newline ? static_cast<const char*>(newline) - text.data() : text.size();
+        std::string_view record = text.substr(begin, end - begin);
+        if (!is_blank(record)) {
+            chunk.lines.push_back(line);
+            chunk.records.push_back(JsonParser::parse(record, options));
+        }
+        line++;
+        begin = end + 1;
+    }
+    chunk.line_count = line;
+}
+
+} // namespace
+
+JsonLinesReader::JsonLinesReader(JsonLinesOptions options)
+    : options_(std::move(options))
+{
+    options_.parse.arena = nullptr;
+    if (options_.chunk_size == 0) {
+        options_.chunk_size = 1;
+    }
+    if (options_.threads > 0) {
+        owned_pool_ = std::make_unique<JsonThreadPool>(options_.threads);
+        pool_ = owned_pool_.get();
+    } else {
+        pool_ = &JsonThreadPool::shared();
+    }
+}
+
+std::vector<JsonLinesReader::RecordResult> JsonLinesReader::parse(std::string_view input) {
+    std::vector<RecordResult> records;
+    parse(input, [&records](std::size_t, RecordResult& record) {
+        records.push_back(std::move(record));
+        return true;
+    });
+    return records;
+}
+
+std::size_t JsonLinesReader::parse(std::string_view input, const RecordCallback& callback) {
+    std::vector<LineChunk> chunks = split_chunks(input, options_.chunk_size);
+    
+    std::mutex mutex;
+    std::condition_variable chunk_done;
+    std::atomic<bool> cancelled(false);
+    
+    std::size_t delivered = 0;
+    {
+        JsonTaskGroup group(*pool_);
+        for (LineChunk& chunk : chunks) {
+            group.run([&chunk, &mutex, &chunk_done, &cancelled, this] {
+                if (!cancelled.load(std::memory_order_relaxed)) {
+                    parse_chunk(chunk, options_.parse);
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                chunk.done = true;
+                chunk_done.notify_all();
+            });
+        }
+        
+        // Deliver chunks in order while later ones are still being parsed
+        std::size_t line_base = 0;
+        for (LineChunk& chunk : chunks) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunk_done.wait(lock, [&chunk] { return chunk.done; });
+            }
+            if (cancelled.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            for (std::size_t i = 0; i < chunk.records.size(); ++i) {
+                delivered++;
+                if (!callback(line_base + chunk.lines[i] + 1, chunk.records[i])) {
+                    cancelled.store(true, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            line_base += chunk.line_count;
+            chunk.records.clear();
+        }
+        // The group waits for any chunks still running before the vector
+        // they write into is destroyed
+    }
+    
+    return delivered;
+}
+
+} // namespace jansson
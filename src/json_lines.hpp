@@ -0,0 +1,63 @@
+#ifndef JSON_LINES_HPP
+#define JSON_LINES_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "json_value.hpp"
+#include "json_error.hpp"
+#include "json_parser.hpp"
+#include "json_thread_pool.hpp"
+
+namespace jansson {
+
+// Options for JsonLinesReader
+struct JsonLinesOptions {
+    // Worker threads for a reader-owned pool; 0 uses the shared pool
+    std::size_t threads = 0;
+    
+    // Input is split at line boundaries into chunks of about this many
+    // bytes; each chunk is one task
+    std::size_t chunk_size = 256 * 1024;
+    
+    // Options for each record. The arena is ignored because records are
+    // parsed concurrently.
+    JsonParseOptions parse;
+};
+
+// Reader for newline-delimited JSON (NDJSON / JSON Lines).
+//
+// The input is cut into chunks at newline boundaries and the chunks are
+// parsed on a thread pool; records are delivered in input order. Lines
+// that contain only whitespace are skipped; "\r\n" line endings are
+// accepted.
+class JsonLinesReader {
+public:
+    using RecordResult = Result<JsonRef<JsonValue>>;
+    
+    // Called for each record with its 1-based line number. Return false to
+    // stop; chunks not yet started are then skipped.
+    using RecordCallback = std::function<bool(std::size_t line, RecordResult& record)>;
+    
+    explicit JsonLinesReader(JsonLinesOptions options = JsonLinesOptions());
+    
+    // Parse every record, in input order
+    std::vector<RecordResult> parse(std::string_view input);
+    
+    // Parse every record and hand each to callback, in input order, as
+    // soon as its chunk is done. Returns the number of records delivered.
+    std::size_t parse(std::string_view input, const RecordCallback& callback);
+    
+    std::size_t thread_count() const noexcept { return pool_->size(); }
+
+private:
+    JsonLinesOptions options_;
+    std::unique_ptr<JsonThreadPool> owned_pool_;
+    JsonThreadPool* pool_;
+};
+
+} // namespace jansson
+
+#endif // JSON_LINES_HPP
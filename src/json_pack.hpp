@@ -0,0 +1,551 @@
+#ifndef JSON_PACK_HPP
+#define JSON_PACK_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "json_value.hpp"
+#include "json_error.hpp"
+#include "string_utils.hpp"
+
+// Format string for jansson::pack() and jansson::unpack(). The text is
+// wrapped in a constexpr lambda so that its characters are available to
+// template code: the format is checked against the arguments at compile
+// time, and expands to straight-line code with no format string left at
+// run time.
+#define JSON_FORMAT(text) ([]() constexpr { return ::std::string_view(text); })
+
+namespace jansson {
+namespace pack_detail {
+
+constexpr std::size_t invalid = static_cast<std::size_t>(-1);
+
+// One value of a format: where it ends, how many arguments it takes, its
+// modifier character (if any) and, for containers, the number of members
+// or elements. end is invalid if the format is malformed.
+struct Item {
+    std::size_t end;
+    std::size_t args;
+    char modifier;
+    std::size_t count;
+};
+
+constexpr Item malformed{invalid, 0, '\0', 0};
+
+// Whitespace, ',' and ':' may be used freely to make formats readable
+constexpr bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == ':';
+}
+
+constexpr std::size_t skip(std::string_view format, std::size_t pos) {
+    while (pos < format.size() && is_separator(format[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+constexpr char char_at(std::string_view format, std::size_t pos) {
+    return pos < format.size() ? format[pos] : '\0';
+}
+
+// Pack grammar: { (s value)* }  [ value* ]  s s? s* s# s%  n b i I f
+// o o? o* O O? O*. Keys take s, s# or s%.
+constexpr Item pack_item(std::string_view format, std::size_t pos, bool key = false) {
+    char type = char_at(format, pos);
+    if (key && type != 's') {
+        return malformed;
+    }
+    switch (type) {
+        case '{':
+        case '[': {
+            char close = type == '{' ? '}' : ']';
+            Item container{0, 0, '\0', 0};
+            std::size_t next = skip(format, pos + 1);
+            while (char_at(format, next) != close) {
+                if (type == '{') {
+                    Item name = pack_item(format, next, true);
+                    if (name.end == invalid) {
+                        return malformed;
+                    }
+                    container.args += name.args;
+                    next = skip(format, name.end);
+                }
+                Item value = pack_item(format, next);
+                if (value.end == invalid) {
+                    return malformed;
+                }
+                container.args += value.args;
+                ++container.count;
+                next = skip(format, value.end);
+            }
+            container.end = next + 1;
+            return container;
+        }
+        case 's': {
+            std::size_t next = skip(format, pos + 1);
+            char modifier = char_at(format, next);
+            if (modifier == '#' || modifier == '%') {
+                return Item{next + 1, 2, modifier, 0};
+            }
+            if (!key && (modifier == '?' || modifier == '*')) {
+                return Item{next + 1, 1, modifier, 0};
+            }
+            return Item{pos + 1, 1, '\0', 0};
+        }
+        case 'o':
+        case 'O': {
+            std::size_t next = skip(format, pos + 1);
+            char modifier = char_at(format, next);
+            if (modifier == '?' || modifier == '*') {
+                return Item{next + 1, 1, modifier, 0};
+            }
+            return Item{pos + 1, 1, '\0', 0};
+        }
+        case 'n':
+            return Item{pos + 1, 0, '\0', 0};
+        case 'b':
+        case 'i':
+        case 'I':
+        case 'f':
+            return Item{pos + 1, 1, '\0', 0};
+        default:
+            return malformed;
+    }
+}
+
+// Unpack grammar: { (s [?] value)* [! or *] }  [ value* [! or *] ]  s s%
+// n b i I f F o O. '!' requires every member or element to be unpacked,
+// '*' (the default) allows the rest to be ignored; '?' after a key makes
+// the member optional.
+constexpr Item unpack_item(std::string_view format, std::size_t pos) {
+    char type = char_at(format, pos);
+    switch (type) {
+        case '{':
+        case '[': {
+            char close = type == '{' ? '}' : ']';
+            Item container{0, 0, '\0', 0};
+            std::size_t next = skip(format, pos + 1);
+            while (char_at(format, next) != close) {
+                char c = char_at(format, next);
+                if (c == '!' || c == '*') {
+                    container.modifier = c;
+                    next = skip(format, next + 1);
+                    if (char_at(format, next) != close) {
+                        return malformed;
+                    }
+                    break;
+                }
+                if (type == '{') {
+                    if (c != 's') {
+                        return malformed;
+                    }
+                    ++container.args;
+                    next = skip(format, next + 1);
+                    if (char_at(format, next) == '?') {
+                        next = skip(format, next + 1);
+                    }
+                }
+                Item value = unpack_item(format, next);
+                if (value.end == invalid) {
+                    return malformed;
+                }
+                container.args += value.args;
+                ++container.count;
+                next = skip(format, value.end);
+            }
+            container.end = next + 1;
+            return container;
+        }
+        case 's': {
+            std::size_t next = skip(format, pos + 1);
+            if (char_at(format, next) == '%') {
+                return Item{next + 1, 2, '%', 0};
+            }
+            return Item{pos + 1, 1, '\0', 0};
+        }
+        case 'n':
+            return Item{pos + 1, 0, '\0', 0};
+        case 'b':
+        case 'i':
+        case 'I':
+        case 'f':
+        case 'F':
+        case 'o':
+        case 'O':
+            return Item{pos + 1, 1, '\0', 0};
+        default:
+            return malformed;
+    }
+}
+
+// Whole format: exactly one value
+constexpr Item pack_format(std::string_view format) {
+    Item item = pack_item(format, skip(format, 0));
+    return item.end != invalid && skip(format, item.end) == format.size() ? item : malformed;
+}
+
+constexpr Item unpack_format(std::string_view format) {
+    Item item = unpack_item(format, skip(format, 0));
+    return item.end != invalid && skip(format, item.end) == format.size() ? item : malformed;
+}
+
+// Argument Index, forwarded as it was passed
+template <std::size_t Index, typename Args>
+decltype(auto) arg(Args& args) {
+    return std::forward<std::tuple_element_t<Index, Args>>(std::get<Index>(args));
+}
+
+inline bool is_null_arg(const char* value) noexcept { return value == nullptr; }
+inline bool is_null_arg(std::string_view) noexcept { return false; }
+
+inline std::string_view string_arg(const char* value) {
+    if (!value) {
+        throw JsonException("NULL string argument");
+    }
+    return value;
+}
+
+inline std::string_view string_arg(std::string_view value) noexcept { return value; }
+
+inline std::string_view checked_utf8(std::string_view value) {
+    if (!JsonString::is_valid_utf8(value)) {
+        throw JsonException("Invalid UTF-8 string");
+    }
+    return value;
+}
+
+// String (or key) taken by an s item, with its length argument for s#/s%
+template <char Modifier, std::size_t Arg, typename Args>
+std::string_view pack_string(Args& args) {
+    if constexpr (Modifier == '#' || Modifier == '%') {
+        static_assert(std::is_integral_v<std::decay_t<std::tuple_element_t<Arg + 1, Args>>>,
+                      "s# and s% take a string and an integer length");
+        const char* data = arg<Arg>(args);
+        if (!data) {
+            throw JsonException("NULL string argument");
+        }
+        return checked_utf8(std::string_view(data, static_cast<std::size_t>(arg<Arg + 1>(args))));
+    } else {
+        return checked_utf8(string_arg(arg<Arg>(args)));
+    }
+}
+
+template <std::size_t Pos, std::size_t Arg, typename Format, typename Args>
+JsonRef<JsonValue> pack_value(Format format, Args& args);
+
+template <std::size_t Pos, std::size_t Arg, typename Format, typename Args>
+void pack_members(Format format, Args& args, JsonObject& object) {
+    constexpr std::string_view text = format();
+    if constexpr (text[Pos] != '}') {
+        constexpr Item name = pack_item(text, Pos, true);
+        constexpr std::size_t value_pos = skip(text, name.end);
+        constexpr Item value_item = pack_item(text, value_pos);
+        std::string_view key = pack_string<name.modifier, Arg>(args);
+        JsonRef<JsonValue> value = pack_value<value_pos, Arg + name.args>(format, args);
+        if (value) {
+            object.set(key, std::move(value));
+        }
+        pack_members<skip(text, value_item.end), Arg + name.args + value_item.args>(format, args, object);
+    }
+}
+
+template <std::size_t Pos, std::size_t Arg, typename Format, typename Args>
+void pack_elements(Format format, Args& args, JsonArray& array) {
+    constexpr std::string_view text = format();
+    if constexpr (text[Pos] != ']') {
+        constexpr Item item = pack_item(text, Pos);
+        JsonRef<JsonValue> value = pack_value<Pos, Arg>(format, args);
+        if (value) {
+            array.push_back(std::move(value));
+        }
+        pack_elements<skip(text, item.end), Arg + item.args>(format, args, array);
+    }
+}
+
+// Value for the item at Pos; null only when a '*' item is omitted
+template <std::size_t Pos, std::size_t Arg, typename Format, typename Args>
+JsonRef<JsonValue> pack_value(Format format, Args& args) {
+    constexpr std::string_view text = format();
+    constexpr char type = text[Pos];
+    constexpr Item item = pack_item(text, Pos);
+    if constexpr (type == '{') {
+        auto object = JsonObject::create();
+        object->reserve(item.count);
+        pack_members<skip(text, Pos + 1), Arg>(format, args, *object);
+        return object;
+    } else if constexpr (type == '[') {
+        auto array = JsonArray::create();
+        array->reserve(item.count);
+        pack_elements<skip(text, Pos + 1), Arg>(format, args, *array);
+        return array;
+    } else if constexpr (type == 's') {
+        if constexpr (item.modifier == '?' || item.modifier == '*') {
+            if (is_null_arg(arg<Arg>(args))) {
+                if constexpr (item.modifier == '?') {
+                    return JsonNull::create();
+                } else {
+                    return nullptr;
+                }
+            }
+        }
+        return make_value<JsonStringValue>(pack_string<item.modifier, Arg>(args));
+    } else if constexpr (type == 'n') {
+        return JsonNull::create();
+    } else if constexpr (type == 'b') {
+        return JsonBoolean::create(static_cast<bool>(arg<Arg>(args)));
+    } else if constexpr (type == 'i' || type == 'I') {
+        static_assert(std::is_integral_v<std::decay_t<std::tuple_element_t<Arg, Args>>>,
+                      "i and I take an integer");
+        return JsonNumber::create(static_cast<std::int64_t>(arg<Arg>(args)));
+    } else if constexpr (type == 'f') {
+        double value = static_cast<double>(arg<Arg>(args));
+        if (!std::isfinite(value)) {
+            throw JsonException("Invalid floating point value");
+        }
+        return JsonNumber::create(value);
+    } else {
+        // o hands its reference over when passed an rvalue; O always
+        // takes a new one
+        JsonRef<JsonValue> value;
+        if constexpr (type == 'o') {
+            value = arg<Arg>(args);
+        } else {
+            value = std::get<Arg>(args);
+        }
+        if (!value) {
+            if constexpr (item.modifier == '?') {
+                return JsonNull::create();
+            } else if constexpr (item.modifier == '*') {
+                return nullptr;
+            } else {
+                throw JsonException("NULL object");
+            }
+        }
+        return value;
+    }
+}
+
+inline const char* type_name(const JsonValue& value) noexcept {
+    switch (value.type()) {
+        case JsonType::Null: return "null";
+        case JsonType::Boolean: return "boolean";
+        case JsonType::Number: return value.is_integer() ? "integer" : "real";
+        case JsonType::String: return "string";
+        case JsonType::Array: return "array";
+        case JsonType::Object: return "object";
+    }
+    return "unknown";
+}
+
+[[noreturn]] inline void type_error(const char* expected, const JsonValue& value) {
+    throw JsonException(std::string("Expected ") + expected + ", got " + type_name(value));
+}
+
+inline std::string_view key_arg(const char* key) {
+    if (!key) {
+        throw JsonException("NULL object key");
+    }
+    return key;
+}
+
+inline std::string_view key_arg(std::string_view key) noexcept { return key; }
+
+inline void store_string(const char** target, const JsonStringValue& value) { *target = value.value().c_str(); }
+inline void store_string(std::string* target, const JsonStringValue& value) { target->assign(value.view()); }
+inline void store_string(std::string_view* target, const JsonStringValue& value) { *target = value.view(); }
+
+template <std::size_t Pos, std::size_t Arg, typename Format, typename Args>
+void unpack_value(Format format, Args& args, const JsonValue& value);
+
+template <std::size_t Pos, std::size_t Arg, typename Format, typename Args>
+void unpack_members(Format format, Args& args, const JsonObject& object,
+                    std::string_view* seen, std::size_t& found) {
+    constexpr std::string_view text = format();
+    constexpr char c = text[Pos];
+    if constexpr (c != '}' && c != '!' && c != '*') {
+        constexpr std::size_t after_key = skip(text, Pos + 1);
+        constexpr bool optional = char_at(text, after_key) == '?';
+        constexpr std::size_t value_pos = optional ? skip(text, after_key + 1) : after_key;
+        constexpr Item value_item = unpack_item(text, value_pos);
+        std::string_view key = key_arg(std::get<Arg>(args));
+        auto it = object.values().find(key);
+        if (it != object.values().end()) {
+            if (seen) {
+                seen[found] = key;
+            }
+            ++found;
+            unpack_value<value_pos, Arg + 1>(format, args, *it->second);
+        } else if constexpr (!optional) {
+            throw JsonException("Object item not found: " + std::string(key));
+        }
+        unpack_members<skip(text, value_item.end), Arg + 1 + value_item.args>(format, args, object,
+                                                                               seen, found);
+    }
+}
+
+template <std::size_t Pos, std::size_t Arg, std::size_t Index, typename Format, typename Args>
+void unpack_elements(Format format, Args& args, const JsonArray& array) {
+    constexpr std::string_view text = format();
+    constexpr char c = text[Pos];
+    if constexpr (c != ']' && c != '!' && c != '*') {
+        constexpr Item item = unpack_item(text, Pos);
+        if (Index >= array.size()) {
+            throw JsonException("Array index " + std::to_string(Index) + " out of range");
+        }
+        unpack_value<Pos, Arg>(format, args, *array.values()[Index]);
+        unpack_elements<skip(text, item.end), Arg + item.args, Index + 1>(format, args, array);
+    }
+}
+
+template <std::size_t Pos, std::size_t Arg, typename Format, typename Args>
+void unpack_value(Format format, Args& args, const JsonValue& value) {
+    constexpr std::string_view text = format();
+    constexpr char type = text[Pos];
+    constexpr Item item = unpack_item(text, Pos);
+    if constexpr (type == '{') {
+        if (!value.is_object()) {
+            type_error("object", value);
+        }
+        const auto& object = static_cast<const JsonObject&>(value);
+        std::size_t found = 0;
+        if constexpr (item.modifier == '!') {
+            // Keys matched, to tell which members were left over
+            std::array<std::string_view, item.count> seen{};
+            unpack_members<skip(text, Pos + 1), Arg>(format, args, object, seen.data(), found);
+            std::size_t unpacked = 0;
+            std::string_view left;
+            for (const auto& member : object.values()) {
+                bool matched = false;
+                for (std::size_t i = 0; i < found && !matched; ++i) {
+                    matched = seen[i] == member.first.view();
+                }
+                if (matched) {
+                    ++unpacked;
+                } else if (left.data() == nullptr) {
+                    left = member.first.view();
+                }
+            }
+            if (unpacked < object.size()) {
+                throw JsonException(std::to_string(object.size() - unpacked) +
+                                    " object item(s) left unpacked: " + std::string(left));
+            }
+        } else {
+            unpack_members<skip(text, Pos + 1), Arg>(format, args, object, nullptr, found);
+        }
+    } else if constexpr (type == '[') {
+        if (!value.is_array()) {
+            type_error("array", value);
+        }
+        const auto& array = static_cast<const JsonArray&>(value);
+        unpack_elements<skip(text, Pos + 1), Arg, 0>(format, args, array);
+        if constexpr (item.modifier == '!') {
+            if (array.size() > item.count) {
+                throw JsonException(std::to_string(array.size() - item.count) +
+                                    " array item(s) left unpacked");
+            }
+        }
+    } else if constexpr (type == 's') {
+        if (!value.is_string()) {
+            type_error("string", value);
+        }
+        const auto& string = static_cast<const JsonStringValue&>(value);
+        store_string(std::get<Arg>(args), string);
+        if constexpr (item.modifier == '%') {
+            *std::get<Arg + 1>(args) = string.view().size();
+        }
+    } else if constexpr (type == 'n') {
+        if (!value.is_null()) {
+            type_error("null", value);
+        }
+    } else if constexpr (type == 'b') {
+        if (!value.is_boolean()) {
+            type_error("true or false", value);
+        }
+        *std::get<Arg>(args) = value.boolean_value();
+    } else if constexpr (type == 'i' || type == 'I') {
+        if (!value.is_integer()) {
+            type_error("integer", value);
+        }
+        using Target = std::remove_pointer_t<std::tuple_element_t<Arg, Args>>;
+        *std::get<Arg>(args) = static_cast<Target>(value.integer_value());
+    } else if constexpr (type == 'f') {
+        if (!value.is_real()) {
+            type_error("real", value);
+        }
+        *std::get<Arg>(args) = value.number_value();
+    } else if constexpr (type == 'F') {
+        if (!value.is_number()) {
+            type_error("real or integer", value);
+        }
+        *std::get<Arg>(args) = value.number_value();
+    } else if constexpr (type == 'o') {
+        *std::get<Arg>(args) = &value;
+    } else {
+        *std::get<Arg>(args) = JsonRef<JsonValue>(const_cast<JsonValue*>(&value));
+    }
+}
+
+} // namespace pack_detail
+
+// Build a value from a format and arguments, as json_pack() does:
+//
+//     auto message = pack(JSON_FORMAT("{s:i, s:[s, b]}"), "id", 7, "tags", name, true);
+//
+// s takes a const char*, std::string or std::string_view (s# and s% a
+// pointer and a length); i, I, b and f take arithmetic values; o and O
+// take a JsonRef. s?, o? and O? pack null for a null argument, and s*,
+// o* and O* leave the value (or member) out. Throws JsonException for
+// null, non-finite or invalid UTF-8 arguments; a malformed format or a
+// wrong number of arguments does not compile.
+template <typename Format, typename... Args>
+JsonRef<JsonValue> pack(Format format, Args&&... args) {
+    constexpr std::string_view text = format();
+    constexpr pack_detail::Item item = pack_detail::pack_format(text);
+    static_assert(item.end != pack_detail::invalid, "malformed pack format");
+    static_assert(item.args == sizeof...(Args), "pack format and arguments do not match");
+    if constexpr (item.end != pack_detail::invalid && item.args == sizeof...(Args)) {
+        auto arguments = std::forward_as_tuple(std::forward<Args>(args)...);
+        JsonRef<JsonValue> value =
+            pack_detail::pack_value<pack_detail::skip(text, 0), 0>(format, arguments);
+        if (!value) {
+            throw JsonException("NULL object");
+        }
+        return value;
+    } else {
+        return nullptr;
+    }
+}
+
+// Destructure value into targets, as json_unpack() does:
+//
+//     int id;
+//     std::string_view name;
+//     unpack(*message, JSON_FORMAT("{s:i, s:[s!]}"), "id", &id, "tags", &name);
+//
+// Keys are const char* or std::string_view. Targets are pointers: s
+// stores to const char*, std::string or std::string_view (s% also a
+// std::size_t length), i and I to integers, b to bool or int, f and F to
+// double, o to const JsonValue* (borrowed from value) and O to
+// JsonRef<JsonValue>. Throws JsonException when value does not match,
+// possibly after some targets have been written.
+template <typename Format, typename... Targets>
+void unpack(const JsonValue& value, Format format, Targets... targets) {
+    constexpr std::string_view text = format();
+    constexpr pack_detail::Item item = pack_detail::unpack_format(text);
+    static_assert(item.end != pack_detail::invalid, "malformed unpack format");
+    static_assert(item.args == sizeof...(Targets), "unpack format and arguments do not match");
+    if constexpr (item.end != pack_detail::invalid && item.args == sizeof...(Targets)) {
+        std::tuple<Targets...> arguments(targets...);
+        pack_detail::unpack_value<pack_detail::skip(text, 0), 0>(format, arguments, value);
+    }
+}
+
+} // namespace jansson
+
+#endif // JSON_PACK_HPP
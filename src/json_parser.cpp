@@ -1,25 +1,132 @@
 #include "json_parser.hpp"
 #include "string_utils.hpp"
+#include "json_simd.hpp"
+#include "json_file.hpp"
+#include "json_shape.hpp"
+#include "json_projection.hpp"
+#include "json_stats.hpp"
+#include "json_thread_pool.hpp"
+#include <algorithm>
 #include <cctype>
 #include <sstream>
 #include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <exception>
+#include <mutex>
 
 namespace jansson {
 
+// Scratch buffers of more entries than this are freed after a parse
+// rather than kept for the next one
+static constexpr size_t retained_scratch_entries = 64 * 1024;
+
+void JsonParser::ParseContext::reset() noexcept {
+    ParseContext fresh;
+    if (frames.capacity() <= retained_scratch_entries) {
+        frames.clear();
+        fresh.frames = std::move(frames);
+    }
+    if (builder.capacity() <= retained_scratch_entries) {
+        builder.clear();
+        builder.set_arena(nullptr);
+        fresh.builder = std::move(builder);
+    }
+    if (index.capacity() <= retained_scratch_entries) {
+        index.clear();
+        fresh.index = std::move(index);
+    }
+    if (scratch.capacity() <= retained_scratch_entries) {
+        scratch.clear();
+        fresh.scratch = std::move(scratch);
+    }
+    *this = std::move(fresh);
+}
+
+// Set once the thread's context has been destroyed at thread exit, so
+// parses run by later destructors get their own
+static thread_local bool thread_context_gone = false;
+
+class JsonParser::ContextLease {
+public:
+    ContextLease() {
+        if (!thread_context_gone) {
+            ThreadContext& shared = thread_context();
+            if (!shared.in_use) {
+                shared.in_use = true;
+                context_ = &shared.context;
+                return;
+            }
+        }
+        own_ = std::make_unique<ParseContext>();
+        context_ = own_.get();
+    }
+
+    ~ContextLease() {
+        if (!own_) {
+            context_->reset();
+            thread_context().in_use = false;
+        }
+    }
+
+    ContextLease(const ContextLease&) = delete;
+    ContextLease& operator=(const ContextLease&) = delete;
+
+    ParseContext& context() noexcept { return *context_; }
+
+private:
+    struct ThreadContext {
+        ParseContext context;
+        bool in_use = false;
+
+        ~ThreadContext() { thread_context_gone = true; }
+    };
+
+    static ThreadContext& thread_context() {
+        static thread_local ThreadContext shared;
+        return shared;
+    }
+
+    ParseContext* context_;
+    std::unique_ptr<ParseContext> own_;
+};
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
 void JsonParser::skip_whitespace(ParseContext& ctx) {
-    while (ctx.position < ctx.input.length()) {
-        char c = ctx.input[ctx.position];
-        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-            ctx.position++;
-        } else {
+    const char* data = ctx.input.data();
+    size_t length = ctx.input.length();
+    size_t pos = ctx.position;
+    
+    if (ctx.structurals && pos < length && is_whitespace(data[pos])) {
+        // Every token start is indexed, so the next entry past the current
+        // position is the end of the whitespace run.
+        const auto& index = *ctx.structurals;
+        size_t next = ctx.next_structural;
+        while (next < index.size() && index[next] < pos) {
+            next++;
+        }
+        ctx.next_structural = next;
+        ctx.position = next < index.size() ? index[next] : length;
+        return;
+    }
+    
+    while (pos < length) {
+        char c = data[pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
             break;
         }
+        pos++;
     }
+    
+    ctx.position = pos;
 }
 
+// peek() and consume() operate on the raw byte at the current position.
+// Whitespace is only skipped between tokens, never inside string contents.
 char JsonParser::peek(ParseContext& ctx) {
-    skip_whitespace(ctx);
     if (ctx.position >= ctx.input.length()) {
         return '\0';
     }
@@ -27,207 +134,618 @@ char JsonParser::peek(ParseContext& ctx) {
 }
 
 char JsonParser::consume(ParseContext& ctx) {
-    skip_whitespace(ctx);
     if (ctx.position >= ctx.input.length()) {
         return '\0';
     }
     return ctx.input[ctx.position++];
 }
 
-void JsonParser::expect(ParseContext& ctx, char expected) {
-    char c = consume(ctx);
+bool JsonParser::expect(ParseContext& ctx, char expected) {
+    if (ctx.position >= ctx.input.length()) {
+        return ctx.fail("Unexpected end of input", ctx.position);
+    }
+    char c = ctx.input[ctx.position];
     if (c != expected) {
-        ctx.error_message = "Expected '";
-        ctx.error_message += expected;
-        ctx.error_message += "' but found '";
-        ctx.error_message += c;
-        ctx.error_message += "';";
-        ctx.error_position = ctx.position - 1;
-        throw JsonException(ctx.error_message);
+        std::string message = "Expected '";
+        message += expected;
+        message += "' but found '";
+        message += c;
+        message += "'";
+        return ctx.fail(message, ctx.position);
+    }
+    ctx.position++;
+    return true;
+}
+
+bool JsonParser::expect_literal(ParseContext& ctx, std::string_view literal) {
+    if (ctx.input.substr(ctx.position, literal.length()) != literal) {
+        std::string message = "Invalid literal, expected '";
+        message += literal;
+        message += "'";
+        return ctx.fail(message, ctx.position);
     }
+    ctx.position += literal.length();
+    return true;
 }
 
-std::string JsonParser::parse_raw_string(ParseContext& ctx) {
-    std::string result;
+// Look up the closing quote of the string whose opening quote was just
+// consumed. Only string delimiters are indexed inside a string, so it is the
+// entry following the opening quote.
+bool JsonParser::indexed_string_end(ParseContext& ctx, size_t& end) {
+    const auto& index = *ctx.structurals;
+    size_t next = ctx.next_structural;
+    while (next < index.size() && index[next] < ctx.position) {
+        next++;
+    }
+    ctx.next_structural = next;
+    if (next >= index.size()) {
+        return false;
+    }
+    end = index[next];
+    return true;
+}
+
+bool JsonParser::parse_raw_string(ParseContext& ctx, std::string& result) {
+    result.clear();
+    size_t start = ctx.position;
+    if (!expect(ctx, '"')) {
+        return false;
+    }
+    
+    const char* data = ctx.input.data();
+    size_t length = ctx.input.length();
     
-    expect(ctx, '"');
+    size_t end;
+    if (ctx.structurals && indexed_string_end(ctx, end)) {
+        const char* begin = data + ctx.position;
+        size_t span = end - ctx.position;
+        if (simd::find_escape(begin, span) == span) {
+            // No escapes: the whole string is copied at once
+            if (!ctx.string_fits(span, start)) {
+                return false;
+            }
+            result.assign(begin, span);
+            ctx.position = end + 1;
+            return true;
+        }
+    }
     
     while (true) {
-        char c = consume(ctx);
+        // Find the end of the current run of plain characters and copy it
+        // with a single append.
+        size_t run_start = ctx.position;
+        size_t pos = run_start + simd::find_escape(data + run_start, length - run_start);
+        result.append(data + run_start, pos - run_start);
+        ctx.position = pos;
+        if (!ctx.string_fits(result.size(), start)) {
+            return false;
+        }
+        
+        if (pos >= length) {
+            return ctx.fail("Unterminated string", pos);
+        }
+        
+        char c = data[ctx.position++];
         
         if (c == '"') {
             break;
         }
         
-        if (c == '\\') {
-            c = consume(ctx);
-            switch (c) {
-                case '"': result += '"'; break;
-                case '\\': result += '\\'; break;
-                case '/': result += '/'; break;
-                case 'b': result += '\b'; break;
-                case 'f': result += '\f'; break;
-                case 'n': result += '\n'; break;
-                case 'r': result += '\r'; break;
-                case 't': result += '\t'; break;
-                case 'u': {
-                    // Unicode escape
-                    std::string hex_str;
-                    for (int i = 0; i < 4; ++i) {
-                        hex_str += consume(ctx);
-                    }
-                    
-                    try {
-                        int code_point = std::stoi(hex_str, nullptr, 16);
-                        
-                        // Convert code point to UTF-8
-                        if (code_point <= 0x7F) {
-                            result += static_cast<char>(code_point);
-                        } else if (code_point <= 0x7FF) {
-                            result += static_cast<char>(0xC0 | ((code_point >> 6) & 0x1F));
-                            result += static_cast<char>(0x80 | (code_point & 0x3F));
-                        } else if (code_point <= 0xFFFF) {
-                            result += static_cast<char>(0xE0 | ((code_point >> 12) & 0x0F));
-                            result += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
-                            result += static_cast<char>(0x80 | (code_point & 0x3F));
-                        } else if (code_point <= 0x10FFFF) {
-                            result += static_cast<char>(0xF0 | ((code_point >> 18) & 0x07));
-                            result += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
-                            result += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
-                            result += static_cast<char>(0x80 | (code_point & 0x3F));
-                        }
-                    } catch (...) {
-                        ctx.error_message = "Invalid Unicode escape sequence";
-                        ctx.error_position = ctx.position - 5;
-                        throw JsonException(ctx.error_message);
-                    }
-                    break;
+        if (c != '\\') {
+            return ctx.fail("Control character in string", ctx.position - 1);
+        }
+        
+        c = consume(ctx);
+        switch (c) {
+            case '"': result += '"'; break;
+            case '\\': result += '\\'; break;
+            case '/': result += '/'; break;
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            case 'u': {
+                UnicodeEscapeError error = UnicodeEscapeError::None;
+                size_t used = decode_unicode_escape(data + ctx.position, length - ctx.position, result, error);
+                if (used == 0) {
+                    return ctx.fail(error == UnicodeEscapeError::UnpairedSurrogate
+                                        ? "Invalid Unicode surrogate pair"
+                                        : "Invalid Unicode escape sequence",
+                                    ctx.position - 2);
                 }
-                default:
-                    ctx.error_message = "Invalid escape sequence";
-                    ctx.error_position = ctx.position - 1;
-                    throw JsonException(ctx.error_message);
+                ctx.position += used;
+                break;
             }
-        } else {
-            result += c;
+            default:
+                return ctx.fail("Invalid escape sequence", ctx.position - 1);
         }
     }
     
-    return result;
+    return true;
 }
 
-std::shared_ptr<JsonStringValue> JsonParser::parse_string(ParseContext& ctx) {
-    std::string raw_str = parse_raw_string(ctx);
-    return JsonStringValue::create(raw_str);
+// If the string at the current position contains no escapes and fits the
+// length limit, point text at its contents and move past it. Otherwise leave the position alone so
+// parse_raw_string() can decode it (or report the error).
+bool JsonParser::scan_plain_string(ParseContext& ctx, std::string_view& text) {
+    const char* data = ctx.input.data();
+    size_t length = ctx.input.length();
+    size_t start = ctx.position + 1;
+    if (ctx.position >= length || data[ctx.position] != '"') {
+        return false;
+    }
+    
+    // Without escapes the first special byte is the closing quote
+    size_t end = start + simd::find_escape(data + start, length - start);
+    if (end >= length || data[end] != '"' || end - start > ctx.max_string_length) {
+        return false;
+    }
+    
+    text = std::string_view(data + start, end - start);
+    ctx.position = end + 1;
+    return true;
 }
 
-std::shared_ptr<JsonNumber> JsonParser::parse_number(ParseContext& ctx) {
-    std::string num_str;
-    char c = peek(ctx);
+// Keys without escapes are interned straight from the input
+bool JsonParser::parse_key(ParseContext& ctx, JsonKey& key) {
+    std::string_view text;
+    if (!scan_plain_string(ctx, text)) {
+        if (!parse_raw_string(ctx, ctx.scratch)) {
+            return false;
+        }
+        text = ctx.scratch;
+    }
+    key = ctx.keys ? ctx.keys->intern(text) : JsonKey(text);
+    return true;
+}
+
+JsonRef<JsonStringValue> JsonParser::parse_string(ParseContext& ctx) {
+    std::string_view text;
+    if (ctx.borrow_strings && scan_plain_string(ctx, text)) {
+        return make_value_in<JsonStringValue>(ctx.arena, text, JsonStringValue::borrowed);
+    }
+    std::string decoded;
+    if (!parse_raw_string(ctx, decoded)) {
+        return nullptr;
+    }
+    return make_value_in<JsonStringValue>(ctx.arena, std::move(decoded));
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Powers of ten that are exactly representable as doubles
+static constexpr double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool JsonParser::scan_number(ParseContext& ctx, NumberToken& token) {
+    const char* data = ctx.input.data();
+    size_t length = ctx.input.length();
+    size_t start = ctx.position;
+    size_t pos = start;
     
     // Handle optional sign
-    if (c == '-' || c == '+') {
-        num_str += consume(ctx);
-        c = peek(ctx);
+    if (pos < length && data[pos] == '-') {
+        pos++;
     }
     
+    bool negative = pos > start;
+    
+    // Significant digits are accumulated while scanning (up to 19 fit in a
+    // uint64_t). decimal_exponent tracks where the decimal point falls
+    // relative to the accumulated digits.
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int64_t decimal_exponent = 0;
+    bool overflow = false;
+    
     // Parse integer part
-    if (c == '0') {
-        num_str += consume(ctx);
-        c = peek(ctx);
-        // Check for hex, octal, or binary (not standard JSON but some implementations support)
+    if (pos < length && data[pos] == '0') {
         // For standard JSON, we just accept single 0
-    } else if (std::isdigit(c)) {
-        while (std::isdigit(peek(ctx))) {
-            num_str += consume(ctx);
+        pos++;
+    } else if (pos < length && is_digit(data[pos])) {
+        while (pos < length && is_digit(data[pos])) {
+            uint64_t digit = static_cast<uint64_t>(data[pos] - '0');
+            if (significant_digits < 19) {
+                mantissa = mantissa * 10 + digit;
+                significant_digits++;
+            } else {
+                if (mantissa <= (UINT64_MAX - digit) / 10) {
+                    mantissa = mantissa * 10 + digit;
+                    significant_digits++;
+                } else {
+                    overflow = true;
+                    decimal_exponent++;
+                }
+            }
+            pos++;
         }
     } else {
-        ctx.error_message = "Invalid number format";
-        ctx.error_position = ctx.position;
-        throw JsonException(ctx.error_message);
+        return ctx.fail("Invalid number format", pos);
     }
     
-    c = peek(ctx);
+    // Integer fast path: no fraction or exponent and the value fits in
+    // an int64_t, so no floating point conversion is needed
+    bool has_fraction = pos < length && data[pos] == '.';
+    bool has_exponent = pos < length && (data[pos] == 'e' || data[pos] == 'E');
+    if (!has_fraction && !has_exponent && !overflow) {
+        constexpr uint64_t max_positive = static_cast<uint64_t>(INT64_MAX);
+        if (!negative && mantissa <= max_positive) {
+            ctx.position = pos;
+            token.is_integer = true;
+            token.integer = static_cast<int64_t>(mantissa);
+            return true;
+        }
+        if (negative && mantissa <= max_positive + 1) {
+            ctx.position = pos;
+            token.is_integer = true;
+            token.integer = mantissa == max_positive + 1
+                ? INT64_MIN
+                : -static_cast<int64_t>(mantissa);
+            return true;
+        }
+    }
     
     // Parse fractional part
-    if (c == '.') {
-        num_str += consume(ctx);
-        if (!std::isdigit(peek(ctx))) {
-            ctx.error_message = "Invalid number format - expected digit after decimal point";
-            ctx.error_position = ctx.position;
-            throw JsonException(ctx.error_message);
+    if (has_fraction) {
+        pos++;
+        if (pos >= length || !is_digit(data[pos])) {
+            return ctx.fail("Invalid number format - expected digit after decimal point", pos);
         }
-        while (std::isdigit(peek(ctx))) {
-            num_str += consume(ctx);
+        while (pos < length && is_digit(data[pos])) {
+            if (significant_digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(data[pos] - '0');
+                if (mantissa != 0) {
+                    significant_digits++;
+                }
+                decimal_exponent--;
+            } else {
+                overflow = true;
+            }
+            pos++;
         }
-        c = peek(ctx);
     }
     
     // Parse exponent
-    if (c == 'e' || c == 'E') {
-        num_str += consume(ctx);
-        c = peek(ctx);
-        if (c == '+' || c == '-') {
-            num_str += consume(ctx);
+    if (pos < length && (data[pos] == 'e' || data[pos] == 'E')) {
+        pos++;
+        bool negative_exponent = false;
+        if (pos < length && (data[pos] == '+' || data[pos] == '-')) {
+            negative_exponent = data[pos] == '-';
+            pos++;
         }
-        if (!std::isdigit(peek(ctx))) {
-            ctx.error_message = "Invalid number format - expected digit in exponent";
-            ctx.error_position = ctx.position;
-            throw JsonException(ctx.error_message);
+        if (pos >= length || !is_digit(data[pos])) {
+            return ctx.fail("Invalid number format - expected digit in exponent", pos);
         }
-        while (std::isdigit(peek(ctx))) {
-            num_str += consume(ctx);
+        int64_t exponent = 0;
+        while (pos < length && is_digit(data[pos])) {
+            if (exponent < 1000000) {
+                exponent = exponent * 10 + (data[pos] - '0');
+            }
+            pos++;
         }
+        decimal_exponent += negative_exponent ? -exponent : exponent;
     }
     
-    try {
-        double value = std::stod(num_str);
-        return JsonNumber::create(value);
-    } catch (...) {
-        ctx.error_message = "Invalid number format";
-        ctx.error_position = ctx.position - num_str.length();
-        throw JsonException(ctx.error_message);
+    ctx.position = pos;
+    
+    // Fast path (Clinger): an exact mantissa scaled by an exact power of ten
+    // is correctly rounded by a single multiplication or division
+    if (!overflow && mantissa <= (uint64_t(1) << 53) &&
+        decimal_exponent >= -22 && decimal_exponent <= 22) {
+        double value = static_cast<double>(mantissa);
+        if (decimal_exponent < 0) {
+            value /= exact_powers_of_ten[-decimal_exponent];
+        } else {
+            value *= exact_powers_of_ten[decimal_exponent];
+        }
+        token.is_integer = false;
+        token.real = negative ? -value : value;
+        return true;
+    }
+    
+    // Slow path: correctly rounded, locale-independent conversion straight
+    // from the input
+    double value = 0.0;
+    auto result = std::from_chars(data + start, data + pos, value);
+    if (result.ec == std::errc::result_out_of_range) {
+        // Magnitude of the leading digit decides overflow vs. underflow
+        if (mantissa != 0 && decimal_exponent + significant_digits > 0) {
+            return ctx.fail("Real number overflow", start);
+        }
+        value = negative ? -0.0 : 0.0;
+    } else if (result.ec != std::errc() || result.ptr != data + pos) {
+        return ctx.fail("Invalid number format", start);
     }
+    
+    token.is_integer = false;
+    token.real = value;
+    return true;
+}
+
+JsonRef<JsonNumber> JsonParser::parse_number(ParseContext& ctx) {
+    NumberToken token;
+    if (!scan_number(ctx, token)) {
+        return nullptr;
+    }
+    if (token.is_integer) {
+        return make_value_in<JsonNumber>(ctx.arena, token.integer);
+    }
+    return make_value_in<JsonNumber>(ctx.arena, token.real);
 }
 
-std::shared_ptr<JsonBoolean> JsonParser::parse_boolean(ParseContext& ctx) {
+JsonRef<JsonBoolean> JsonParser::parse_boolean(ParseContext& ctx) {
     if (peek(ctx) == 't') {
-        expect(ctx, 't');
-        expect(ctx, 'r');
-        expect(ctx, 'u');
-        expect(ctx, 'e');
-        return JsonBoolean::create(true);
+        if (!expect_literal(ctx, "true")) {
+            return nullptr;
+        }
+        return make_value_in<JsonBoolean>(ctx.arena, true);
     } else if (peek(ctx) == 'f') {
-        expect(ctx, 'f');
-        expect(ctx, 'a');
-        expect(ctx, 'l');
-        expect(ctx, 's');
-        expect(ctx, 'e');
-        return JsonBoolean::create(false);
+        if (!expect_literal(ctx, "false")) {
+            return nullptr;
+        }
+        return make_value_in<JsonBoolean>(ctx.arena, false);
     }
     
-    ctx.error_message = "Invalid boolean value";
-    ctx.error_position = ctx.position;
-    throw JsonException(ctx.error_message);
+    ctx.fail("Invalid boolean value", ctx.position);
+    return nullptr;
+}
+
+JsonRef<JsonNull> JsonParser::parse_null(ParseContext& ctx) {
+    if (!expect_literal(ctx, "null")) {
+        return nullptr;
+    }
+    return make_value_in<JsonNull>(ctx.arena);
 }
 
-std::shared_ptr<JsonNull> JsonParser::parse_null(ParseContext& ctx) {
-    expect(ctx, 'n');
-    expect(ctx, 'u');
-    expect(ctx, 'l');
-    expect(ctx, 'l');
-    return JsonNull::create();
+// Containers are parsed with an explicit stack of open frames rather than
+// by recursion, so nesting is bounded by max_depth instead of the thread's
+// stack. Frames below base belong to an enclosing call (a projected parse
+// building a whole subtree).
+JsonRef<JsonValue> JsonParser::parse_value(ParseContext& ctx) {
+    const size_t base = ctx.frames.size();
+    JsonRef<JsonValue> value;
+    
+    while (true) {
+        // The start of a value: a scalar, or the opening of a container
+        skip_whitespace(ctx);
+        if (!ctx.count_node(ctx.position)) {
+            return nullptr;
+        }
+        char c = peek(ctx);
+        if (c == '[' || c == '{') {
+            if (!ctx.enter(ctx.position)) {
+                return nullptr;
+            }
+            consume(ctx);
+            ctx.frames.push_back(ParseFrame{ctx.builder.mark(), c == '{', JsonKey()});
+            skip_whitespace(ctx);
+            if (peek(ctx) != (c == '{' ? '}' : ']')) {
+                if (c == '{' && !parse_member_key(ctx, ctx.frames.back().key)) {
+                    return nullptr;
+                }
+                continue;
+            }
+            consume(ctx);
+            value = finish_container(ctx);
+        } else {
+            value = parse_scalar(ctx);
+            if (!value) {
+                return nullptr;
+            }
+        }
+        
+        // Add the value to the innermost container, closing each container
+        // that ends after it
+        while (ctx.frames.size() > base) {
+            ParseFrame& frame = ctx.frames.back();
+            if (frame.object) {
+                ctx.builder.add(std::move(frame.key), std::move(value));
+            } else {
+                ctx.builder.add(std::move(value));
+            }
+            skip_whitespace(ctx);
+            
+            char next = peek(ctx);
+            if (next == ',') {
+                consume(ctx);
+                skip_whitespace(ctx);
+                if (frame.object && !parse_member_key(ctx, frame.key)) {
+                    return nullptr;
+                }
+                break;
+            }
+            if (next != (frame.object ? '}' : ']')) {
+                ctx.fail(frame.object ? "Expected ',' or '}' in object" : "Expected ',' or ']' in array",
+                         ctx.position);
+                return nullptr;
+            }
+            consume(ctx);
+            value = finish_container(ctx);
+        }
+        if (ctx.frames.size() == base) {
+            return value;
+        }
+    }
 }
 
-std::shared_ptr<JsonArray> JsonParser::parse_array(ParseContext& ctx) {
-    auto array = JsonArray::create();
+JsonRef<JsonValue> JsonParser::parse_scalar(ParseContext& ctx) {
+    if (ctx.position >= ctx.input.length()) {
+        ctx.fail("Unexpected end of input", ctx.position);
+        return nullptr;
+    }
     
-    expect(ctx, '[');
+    switch (peek(ctx)) {
+        case '"':
+            return parse_string(ctx);
+        case 't':
+        case 'f':
+            return parse_boolean(ctx);
+        case 'n':
+            return parse_null(ctx);
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            return parse_number(ctx);
+        default:
+            ctx.fail("Unexpected character", ctx.position);
+            return nullptr;
+    }
+}
+
+// A member key and the colon after it
+bool JsonParser::parse_member_key(ParseContext& ctx, JsonKey& key) {
+    if (!parse_key(ctx, key)) {
+        return false;
+    }
+    skip_whitespace(ctx);
+    if (!expect(ctx, ':')) {
+        return false;
+    }
     skip_whitespace(ctx);
+    return true;
+}
+
+// Pop the innermost frame into its container
+JsonRef<JsonValue> JsonParser::finish_container(ParseContext& ctx) {
+    ParseFrame& frame = ctx.frames.back();
+    JsonBuilder::Mark mark = frame.mark;
+    bool object = frame.object;
+    ctx.frames.pop_back();
+    ctx.depth--;
     
-    if (peek(ctx) != ']') {
+    if (!object) {
+        return ctx.builder.finish_array(mark);
+    }
+    auto result = ctx.builder.finish_object(mark);
+    if (ctx.shapes && !result->empty()) {
+        ctx.shapes->assign(*result);
+    }
+    return result;
+}
+
+JsonRef<JsonValue> JsonParser::parse_projected(ParseContext& ctx, std::uint32_t node) {
+    skip_whitespace(ctx);
+    char c = peek(ctx);
+    if (c != '{' && c != '[') {
+        skip_value(ctx);
+        return nullptr;
+    }
+    if (!ctx.count_node(ctx.position) || !ctx.enter(ctx.position)) {
+        return nullptr;
+    }
+    JsonRef<JsonValue> value;
+    if (c == '{') {
+        value = parse_object_projected(ctx, node);
+    } else {
+        value = parse_array_projected(ctx, node);
+    }
+    ctx.depth--;
+    return value;
+}
+
+JsonRef<JsonObject> JsonParser::parse_object_projected(ParseContext& ctx, std::uint32_t node) {
+    JsonBuilder::Mark mark = ctx.builder.mark();
+    
+    if (!expect(ctx, '{')) {
+        return nullptr;
+    }
+    skip_whitespace(ctx);
+    
+    if (peek(ctx) != '}') {
         while (true) {
-            array->push_back(parse_value(ctx));
+            // Keys of skipped members are compared, never interned
+            std::string_view text;
+            std::string decoded;
+            if (!scan_plain_string(ctx, text)) {
+                if (!parse_raw_string(ctx, decoded)) {
+                    return nullptr;
+                }
+                text = decoded;
+            }
+            skip_whitespace(ctx);
+            if (!expect(ctx, ':')) {
+                return nullptr;
+            }
+            skip_whitespace(ctx);
+            
+            std::uint32_t child = ctx.projection->member(node, text);
+            if (child == JsonProjection::none) {
+                if (!skip_value(ctx)) {
+                    return nullptr;
+                }
+            } else {
+                JsonRef<JsonValue> value = ctx.projection->whole(child) ? parse_value(ctx)
+                                                                        : parse_projected(ctx, child);
+                if (ctx.failed) {
+                    return nullptr;
+                }
+                if (value) {
+                    ctx.builder.add(ctx.keys ? ctx.keys->intern(text) : JsonKey(text), std::move(value));
+                }
+            }
+            skip_whitespace(ctx);
+            
+            char c = peek(ctx);
+            if (c == '}') {
+                break;
+            } else if (c == ',') {
+                consume(ctx);
+                skip_whitespace(ctx);
+            } else {
+                ctx.fail("Expected ',' or '}' in object", ctx.position);
+                return nullptr;
+            }
+        }
+    }
+    
+    if (!expect(ctx, '}')) {
+        return nullptr;
+    }
+    auto object = ctx.builder.finish_object(mark);
+    if (ctx.shapes && !object->empty()) {
+        ctx.shapes->assign(*object);
+    }
+    return object;
+}
+
+JsonRef<JsonArray> JsonParser::parse_array_projected(ParseContext& ctx, std::uint32_t node) {
+    JsonBuilder::Mark mark = ctx.builder.mark();
+    
+    if (!expect(ctx, '[')) {
+        return nullptr;
+    }
+    skip_whitespace(ctx);
+    
+    if (peek(ctx) != ']') {
+        for (std::size_t index = 0;; ++index) {
+            std::uint32_t child = ctx.projection->element(node, index);
+            if (child == JsonProjection::none) {
+                if (!skip_value(ctx)) {
+                    return nullptr;
+                }
+            } else {
+                JsonRef<JsonValue> value = ctx.projection->whole(child) ? parse_value(ctx)
+                                                                        : parse_projected(ctx, child);
+                if (ctx.failed) {
+                    return nullptr;
+                }
+                if (value) {
+                    ctx.builder.add(std::move(value));
+                }
+            }
             skip_whitespace(ctx);
             
             char c = peek(ctx);
@@ -237,31 +755,316 @@ std::shared_ptr<JsonArray> JsonParser::parse_array(ParseContext& ctx) {
                 consume(ctx);
                 skip_whitespace(ctx);
             } else {
-                ctx.error_message = "Expected ',' or ']' in array";
-                ctx.error_position = ctx.position;
-                throw JsonException(ctx.error_message);
+                ctx.fail("Expected ',' or ']' in array", ctx.position);
+                return nullptr;
+            }
+        }
+    }
+    
+    if (!expect(ctx, ']')) {
+        return nullptr;
+    }
+    return ctx.builder.finish_array(mark);
+}
+
+bool JsonParser::skip_string(ParseContext& ctx) {
+    const char* data = ctx.input.data();
+    size_t length = ctx.input.length();
+    size_t pos = ctx.position + 1;
+    
+    while (true) {
+        pos += simd::find_escape(data + pos, length - pos);
+        if (pos >= length) {
+            return ctx.fail("Unterminated string", ctx.position);
+        }
+        if (data[pos] == '"') {
+            ctx.position = pos + 1;
+            return true;
+        }
+        if (data[pos] != '\\') {
+            return ctx.fail("Invalid control character in string", pos);
+        }
+        pos += 2;
+    }
+}
+
+// Subtrees are skipped by following strings and bracket depth only; with a
+// structural index the scan jumps from bracket to bracket
+bool JsonParser::skip_value(ParseContext& ctx) {
+    skip_whitespace(ctx);
+    const char* data = ctx.input.data();
+    size_t length = ctx.input.length();
+    size_t pos = ctx.position;
+    
+    char c = peek(ctx);
+    if (c == '"') {
+        return skip_string(ctx);
+    }
+    if (c != '{' && c != '[') {
+        if (c != '-' && !is_digit(c) && c != 't' && c != 'f' && c != 'n') {
+            return ctx.fail("Unexpected character", pos);
+        }
+        while (pos < length && !is_whitespace(data[pos]) && data[pos] != ',' &&
+               data[pos] != ']' && data[pos] != '}') {
+            pos++;
+        }
+        ctx.position = pos;
+        return true;
+    }
+    
+    size_t depth = 0;
+    if (ctx.structurals) {
+        const auto& index = *ctx.structurals;
+        size_t next = ctx.next_structural;
+        while (next < index.size() && index[next] < pos) {
+            next++;
+        }
+        for (; next < index.size(); ++next) {
+            char token = data[index[next]];
+            if (token == '{' || token == '[') {
+                depth++;
+            } else if (token == '}' || token == ']') {
+                if (--depth == 0) {
+                    ctx.position = index[next] + 1;
+                    ctx.next_structural = next + 1;
+                    return true;
+                }
+            } else if (token == '"') {
+                // The closing quote is the next entry
+                next++;
+            }
+        }
+    } else {
+        while (pos < length) {
+            char token = data[pos];
+            if (token == '"') {
+                ctx.position = pos;
+                if (!skip_string(ctx)) {
+                    return false;
+                }
+                pos = ctx.position;
+                continue;
             }
+            if (token == '{' || token == '[') {
+                depth++;
+            } else if (token == '}' || token == ']') {
+                if (--depth == 0) {
+                    ctx.position = pos + 1;
+                    return true;
+                }
+            }
+            pos++;
+        }
+    }
+    
+    return ctx.fail("Unexpected end of input", length);
+}
+
+// Speculative splitting of a large top-level array. The structural index
+// is walked once to find the commas at depth one; each element is then
+// parsed from its first token to the comma that follows it, on a pool
+// thread. Elements must end exactly at their comma, so a malformed element
+// is reported rather than resynchronized.
+JsonRef<JsonValue> JsonParser::parse_array_parallel(ParseContext& ctx, const JsonParseOptions& options) {
+    const auto& index = *ctx.structurals;
+    std::string_view input = ctx.input;
+    if (index.size() < 3 || input[index[0]] != '[') {
+        return nullptr;
+    }
+    
+    // Index entries holding the first token of each element, and the entry
+    // of the closing bracket
+    std::vector<std::uint32_t> starts;
+    size_t close = 0;
+    size_t depth = 0;
+    for (size_t entry = 1; entry < index.size() && close == 0; ++entry) {
+        switch (input[index[entry]]) {
+            case '"':
+                // Skip the closing quote
+                ++entry;
+                break;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+                if (depth == 0) {
+                    return nullptr;
+                }
+                --depth;
+                break;
+            case ']':
+                if (depth == 0) {
+                    close = entry;
+                } else {
+                    --depth;
+                }
+                break;
+            case ',':
+                if (depth == 0) {
+                    starts.push_back(static_cast<std::uint32_t>(entry + 1));
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (close <= 1) {
+        // Unterminated or empty; the sequential parser handles it
+        return nullptr;
+    }
+    starts.insert(starts.begin(), 1);
+    
+    size_t count = starts.size();
+    std::vector<JsonRef<JsonValue>> elements(count);
+    JsonThreadPool& pool = options.pool ? *options.pool : JsonThreadPool::shared();
+    size_t groups = std::min(count, pool.size() * 4);
+    size_t per_group = (count + groups - 1) / groups;
+    
+    // Elements are one level down and the array itself is one node
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    size_t nodes = 1;
+    {
+        JsonTaskGroup group(pool);
+        for (size_t first = 0; first < count; first += per_group) {
+            size_t last = std::min(first + per_group, count);
+            group.run([&, first, last] {
+                try {
+                    // Unsynchronized tables are not shared between tasks
+                    JsonKeyTable task_keys;
+                    JsonShapeTable task_shapes;
+                    ContextLease lease;
+                    ParseContext& local = lease.context();
+                    local.input = input;
+                    local.structurals = &index;
+                    local.borrow_strings = ctx.borrow_strings;
+                    local.max_depth = ctx.max_depth;
+                    local.max_nodes = ctx.max_nodes;
+                    local.max_string_length = ctx.max_string_length;
+                    local.depth = 1;
+                    if (ctx.keys) {
+                        local.keys = ctx.keys->synchronized() ? ctx.keys : &task_keys;
+                    }
+                    if (ctx.shapes) {
+                        local.shapes = ctx.shapes->synchronized() ? ctx.shapes : &task_shapes;
+                    }
+                    for (size_t i = first; i < last; ++i) {
+                        // The element ends at the next separator entry
+                        size_t end_entry = i + 1 < count ? starts[i + 1] - 1 : close;
+                        local.position = index[starts[i]];
+                        local.next_structural = starts[i];
+                        elements[i] = parse_value(local);
+                        if (!elements[i]) {
+                            break;
+                        }
+                        skip_whitespace(local);
+                        if (local.position != index[end_entry]) {
+                            local.fail("Expected ',' or ']' in array", local.position);
+                            break;
+                        }
+                    }
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    nodes += local.nodes;
+                    if (local.failed && (!ctx.failed || local.error_position < ctx.error_position)) {
+                        // The error nearest the start of the input is reported
+                        ctx.failed = true;
+                        ctx.error_code = local.error_code;
+                        ctx.error_message = std::move(local.error_message);
+                        ctx.error_position = local.error_position;
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            });
         }
+        group.wait();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (!ctx.failed && nodes > ctx.max_nodes) {
+        ctx.fail("Too many values", index[0], JsonErrorCode::LimitExceeded);
+    }
+    if (ctx.failed) {
+        return nullptr;
     }
     
-    expect(ctx, ']');
+    auto array = JsonBuilder::array(std::move(elements));
+    ctx.position = index[close] + 1;
+    ctx.next_structural = close + 1;
     return array;
 }
 
-std::shared_ptr<JsonObject> JsonParser::parse_object(ParseContext& ctx) {
-    auto object = JsonObject::create();
+// Event-driven parsing: the same tokenizer as the DOM path, reporting each
+// token to a handler instead of building nodes. Every function returns
+// false once the handler asks to stop.
+bool JsonParser::emit_string(ParseContext& ctx, JsonHandler& handler, bool is_key) {
+    std::string_view text;
+    if (!scan_plain_string(ctx, text)) {
+        if (!parse_raw_string(ctx, ctx.scratch)) {
+            return false;
+        }
+        text = ctx.scratch;
+    }
+    return is_key ? handler.on_key(text) : handler.on_string(text);
+}
+
+bool JsonParser::emit_array(ParseContext& ctx, JsonHandler& handler) {
+    if (!expect(ctx, '[') || !handler.on_start_array()) {
+        return false;
+    }
+    skip_whitespace(ctx);
     
-    expect(ctx, '{');
+    std::size_t count = 0;
+    if (peek(ctx) != ']') {
+        while (true) {
+            if (!emit_value(ctx, handler)) {
+                return false;
+            }
+            count++;
+            skip_whitespace(ctx);
+            
+            char c = peek(ctx);
+            if (c == ']') {
+                break;
+            } else if (c == ',') {
+                consume(ctx);
+                skip_whitespace(ctx);
+            } else {
+                return ctx.fail("Expected ',' or ']' in array", ctx.position);
+            }
+        }
+    }
+    
+    return expect(ctx, ']') && handler.on_end_array(count);
+}
+
+bool JsonParser::emit_object(ParseContext& ctx, JsonHandler& handler) {
+    if (!expect(ctx, '{') || !handler.on_start_object()) {
+        return false;
+    }
     skip_whitespace(ctx);
     
+    std::size_t count = 0;
     if (peek(ctx) != '}') {
         while (true) {
-            std::string key = parse_raw_string(ctx);
+            if (!emit_string(ctx, handler, true)) {
+                return false;
+            }
             skip_whitespace(ctx);
-            expect(ctx, ':');
+            if (!expect(ctx, ':')) {
+                return false;
+            }
             skip_whitespace(ctx);
             
-            object->set(key, parse_value(ctx));
+            if (!emit_value(ctx, handler)) {
+                return false;
+            }
+            count++;
             skip_whitespace(ctx);
             
             char c = peek(ctx);
@@ -271,40 +1074,43 @@ std::shared_ptr<JsonObject> JsonParser::parse_object(ParseContext& ctx) {
                 consume(ctx);
                 skip_whitespace(ctx);
             } else {
-                ctx.error_message = "Expected ',' or '}' in object";
-                ctx.error_position = ctx.position;
-                throw JsonException(ctx.error_message);
+                return ctx.fail("Expected ',' or '}' in object", ctx.position);
             }
         }
     }
     
-    expect(ctx, '}');
-    return object;
+    return expect(ctx, '}') && handler.on_end_object(count);
 }
 
-std::shared_ptr<JsonValue> JsonParser::parse_value(ParseContext& ctx) {
+bool JsonParser::emit_value(ParseContext& ctx, JsonHandler& handler) {
     skip_whitespace(ctx);
     
     if (ctx.position >= ctx.input.length()) {
-        ctx.error_message = "Unexpected end of input";
-        ctx.error_position = ctx.position;
-        throw JsonException(ctx.error_message);
+        return ctx.fail("Unexpected end of input", ctx.position);
+    }
+    if (!ctx.count_node(ctx.position)) {
+        return false;
     }
     
-    char c = peek(ctx);
-    
-    switch (c) {
+    switch (peek(ctx)) {
         case '"':
-            return parse_string(ctx);
+            return emit_string(ctx, handler, false);
         case '{':
-            return parse_object(ctx);
-        case '[':
-            return parse_array(ctx);
+        case '[': {
+            // Recursion is bounded by the depth limit
+            if (!ctx.enter(ctx.position)) {
+                return false;
+            }
+            bool more = peek(ctx) == '{' ? emit_object(ctx, handler) : emit_array(ctx, handler);
+            ctx.depth--;
+            return more;
+        }
         case 't':
+            return expect_literal(ctx, "true") && handler.on_boolean(true);
         case 'f':
-            return parse_boolean(ctx);
+            return expect_literal(ctx, "false") && handler.on_boolean(false);
         case 'n':
-            return parse_null(ctx);
+            return expect_literal(ctx, "null") && handler.on_null();
         case '-':
         case '0':
         case '1':
@@ -315,68 +1121,282 @@ std::shared_ptr<JsonValue> JsonParser::parse_value(ParseContext& ctx) {
         case '6':
         case '7':
         case '8':
-        case '9':
-            return parse_number(ctx);
+        case '9': {
+            NumberToken token;
+            if (!scan_number(ctx, token)) {
+                return false;
+            }
+            return token.is_integer ? handler.on_integer(token.integer)
+                                    : handler.on_real(token.real);
+        }
         default:
-            ctx.error_message = "Unexpected character";
-            ctx.error_position = ctx.position;
-            throw JsonException(ctx.error_message);
+            return ctx.fail("Unexpected character", ctx.position);
     }
 }
 
-Result<std::shared_ptr<JsonValue>> JsonParser::parse(std::string_view input) {
+Result<JsonRef<JsonValue>> JsonParser::parse(std::string_view input) {
+    return parse(input, JsonParseOptions());
+}
+
+Result<JsonRef<JsonValue>> JsonParser::parse(std::string_view input,
+                                                     const JsonParseOptions& options) {
+    return parse_document(input, options, nullptr, nullptr);
+}
+
+Result<JsonRef<JsonValue>> JsonParser::parse(std::string_view input,
+                                             const JsonParseOptions& options,
+                                             JsonParseError& error) {
+    return parse_document(input, options, nullptr, &error);
+}
+
+Result<JsonRef<JsonValue>> JsonParser::parse_first(std::string_view input, std::size_t& consumed) {
+    return parse_document(input, JsonParseOptions(), &consumed, nullptr);
+}
+
+Result<JsonRef<JsonValue>> JsonParser::parse_first(std::string_view input,
+                                                   const JsonParseOptions& options,
+                                                   std::size_t& consumed) {
+    return parse_document(input, options, &consumed, nullptr);
+}
+
+void JsonParser::set_limits(ParseContext& ctx, const JsonParseOptions& options) {
+    auto limit = [](std::size_t value) { return value != 0 ? value : SIZE_MAX; };
+    ctx.max_depth = limit(options.max_depth);
+    ctx.max_nodes = limit(options.max_nodes);
+    ctx.max_string_length = limit(options.max_string_length);
+}
+
+// Lines are only counted once a parse has failed
+void JsonParser::describe_error(std::string_view input, std::string_view message, size_t position,
+                                JsonParseError& error) {
+    position = std::min(position, input.size());
+    std::string_view before = input.substr(0, position);
+    size_t line_start = before.rfind('\n');
+    line_start = line_start == std::string_view::npos ? 0 : line_start + 1;
+    
+    error.message.assign(message);
+    error.line = static_cast<size_t>(std::count(before.begin(), before.end(), '\n')) + 1;
+    error.column = position - line_start + 1;
+    error.position = position;
+}
+
+// When the value may be followed by more input, only the bytes it spans
+// are validated and nothing is indexed past it, so parsing a buffer of
+// back-to-back values one at a time stays linear in the buffer size
+Result<JsonRef<JsonValue>> JsonParser::parse_document(std::string_view input,
+                                                      const JsonParseOptions& options,
+                                                      std::size_t* consumed,
+                                                      JsonParseError* error) {
+    stats_detail::Timer timer;
+    bool prefix = consumed || options.allow_trailing_data;
+    if (!prefix && options.max_input_size != 0 && input.size() > options.max_input_size) {
+        if (error) {
+            describe_error(input, "Input too large", options.max_input_size, *error);
+        }
+        return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::LimitExceeded));
+    }
+    if (!prefix && !simd::validate_utf8(input)) {
+        if (error) {
+            describe_error(input, "Invalid UTF-8 sequence", simd::find_invalid_utf8(input), *error);
+        }
+        return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::InvalidUTF8));
+    }
+    
+    // A value that may be followed by more input is parsed from the bytes
+    // it may span, so nothing past the limit is ever built
+    bool windowed = prefix && options.max_input_size != 0 && input.size() > options.max_input_size;
+    
     try {
-        ParseContext ctx;
-        ctx.input = input;
+        ContextLease lease;
+        ParseContext& ctx = lease.context();
+        ctx.input = windowed ? input.substr(0, options.max_input_size) : input;
         ctx.position = 0;
+        ctx.arena = options.arena;
+        ctx.builder.set_arena(options.arena);
+        ctx.borrow_strings = options.borrow_strings;
+        set_limits(ctx, options);
         
-        auto result = parse_value(ctx);
+        JsonKeyTable local_keys;
+        if (options.intern_keys) {
+            ctx.keys = options.key_table ? options.key_table : &local_keys;
+        }
+        JsonShapeTable local_shapes;
+        if (options.share_shapes) {
+            ctx.shapes = options.shape_table ? options.shape_table : &local_shapes;
+        }
+        
+        // If stage 1 fails (e.g. unterminated string) the plain scanner runs
+        // and reports the error.
+        std::vector<std::uint32_t>& structurals = ctx.index;
+        if (options.use_structural_index && !prefix &&
+            simd::build_structural_index(input, structurals)) {
+            ctx.structurals = &structurals;
+        }
+        
+        JsonRef<JsonValue> result;
+        if (options.parallel_threshold != 0 && input.size() >= options.parallel_threshold &&
+            !options.arena && !options.projection && !prefix) {
+            if (!ctx.structurals && simd::build_structural_index(input, structurals)) {
+                ctx.structurals = &structurals;
+            }
+            if (ctx.structurals) {
+                result = parse_array_parallel(ctx, options);
+            }
+        }
+        if (options.projection && !options.projection->selects_all()) {
+            // A scalar document has nothing to project
+            ctx.projection = options.projection;
+            skip_whitespace(ctx);
+            char c = peek(ctx);
+            if (c == '{' || c == '[') {
+                result = parse_projected(ctx, 0);
+            }
+        }
+        if (!result && !ctx.failed) {
+            result = parse_value(ctx);
+        }
+        if (windowed) {
+            // A number ending at the limit may go on past it
+            bool cut = ctx.failed ? runs_past_window(ctx)
+                                  : result && result->is_number() && ctx.position == ctx.input.size();
+            if (cut) {
+                ctx.failed = false;
+                ctx.fail("Input too large", options.max_input_size, JsonErrorCode::LimitExceeded);
+            }
+        }
         skip_whitespace(ctx);
+        if (ctx.failed) {
+            if (error) {
+                describe_error(input, ctx.error_message, ctx.error_position, *error);
+            }
+            return Result<JsonRef<JsonValue>>(make_error_code(ctx.error_code));
+        }
         
-        if (ctx.position < ctx.input.length()) {
-            std::string error_msg = "Unexpected trailing characters at position ";
-            error_msg += std::to_string(ctx.position);
-            return Result<std::shared_ptr<JsonValue>>(make_error_code(JsonErrorCode::SyntaxError));
+        if (prefix) {
+            if (!simd::validate_utf8(input.substr(0, ctx.position))) {
+                if (error) {
+                    describe_error(input, "Invalid UTF-8 sequence",
+                                   simd::find_invalid_utf8(input.substr(0, ctx.position)), *error);
+                }
+                return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::InvalidUTF8));
+            }
+            if (consumed) {
+                *consumed = ctx.position;
+            }
+        } else if (ctx.position < ctx.input.length()) {
+            if (error) {
+                describe_error(input, "Unexpected trailing characters", ctx.position, *error);
+            }
+            return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::SyntaxError));
         }
         
-        return Result<std::shared_ptr<JsonValue>>(result);
+        timer.finish_parse(prefix ? ctx.position : input.size());
+        return Result<JsonRef<JsonValue>>(result);
     } catch (const JsonException& e) {
-        return Result<std::shared_ptr<JsonValue>>(make_error_code(JsonErrorCode::ParseError));
+        if (error) {
+            describe_error(input, e.what(), 0, *error);
+        }
+        return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::ParseError));
     } catch (...) {
-        return Result<std::shared_ptr<JsonValue>>(make_error_code(JsonErrorCode::UnknownError));
+        if (error) {
+            describe_error(input, "Unknown error during parsing", 0, *error);
+        }
+        return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::UnknownError));
     }
 }
 
-Result<std::shared_ptr<JsonValue>> JsonParser::parse_with_error(
-    std::string_view input,
-    std::string& error_message,
-    size_t& error_position
-) {
+// Skipping only follows strings and brackets, so it fails where the value
+// is unfinished, not where it is malformed
+bool JsonParser::runs_past_window(ParseContext& ctx) {
+    if (ctx.error_code == JsonErrorCode::LimitExceeded) {
+        return false;
+    }
+    JsonErrorCode code = ctx.error_code;
+    std::string message = std::move(ctx.error_message);
+    size_t at = ctx.error_position;
+    
+    ctx.failed = false;
+    ctx.position = 0;
+    skip_whitespace(ctx);
+    char first = peek(ctx);
+    bool scalar = first != '"' && first != '{' && first != '[';
+    bool cut = !skip_value(ctx) || (scalar && ctx.position == ctx.input.size());
+    
+    ctx.failed = false;
+    ctx.fail(message, at, code);
+    return cut;
+}
+
+Result<JsonRef<JsonValue>> JsonParser::parse_file(const std::string& path) {
+    return parse_file(path, JsonParseOptions());
+}
+
+Result<JsonRef<JsonValue>> JsonParser::parse_file(const std::string& path,
+                                                          const JsonParseOptions& options) {
+    auto file = JsonMappedFile::open(path);
+    if (!file) {
+        return Result<JsonRef<JsonValue>>(file.error());
+    }
+    
+    JsonParseOptions copying = options;
+    copying.borrow_strings = false;
+    return parse(file.value()->view(), copying);
+}
+
+Result<bool> JsonParser::parse(std::string_view input, JsonHandler& handler) {
+    return parse(input, JsonParseOptions(), handler);
+}
+
+Result<bool> JsonParser::parse(std::string_view input, const JsonParseOptions& options,
+                               JsonHandler& handler) {
+    stats_detail::Timer timer;
+    if (options.max_input_size != 0 && input.size() > options.max_input_size) {
+        return Result<bool>(make_error_code(JsonErrorCode::LimitExceeded));
+    }
+    if (!simd::validate_utf8(input)) {
+        return Result<bool>(make_error_code(JsonErrorCode::InvalidUTF8));
+    }
+    
     try {
-        ParseContext ctx;
+        ContextLease lease;
+        ParseContext& ctx = lease.context();
         ctx.input = input;
         ctx.position = 0;
+        set_limits(ctx, options);
         
-        auto result = parse_value(ctx);
+        if (!emit_value(ctx, handler)) {
+            if (ctx.failed) {
+                return Result<bool>(make_error_code(ctx.error_code));
+            }
+            return Result<bool>(false);
+        }
         skip_whitespace(ctx);
         
         if (ctx.position < ctx.input.length()) {
-            error_message = "Unexpected trailing characters at position ";
-            error_message += std::to_string(ctx.position);
-            error_position = ctx.position;
-            return Result<std::shared_ptr<JsonValue>>(make_error_code(JsonErrorCode::SyntaxError));
+            return Result<bool>(make_error_code(JsonErrorCode::SyntaxError));
         }
         
-        return Result<std::shared_ptr<JsonValue>>(result);
+        timer.finish_parse(input.size());
+        return Result<bool>(true);
     } catch (const JsonException& e) {
-        error_message = e.what();
-        error_position = 0; // Would be set in context if we had it
-        return Result<std::shared_ptr<JsonValue>>(make_error_code(JsonErrorCode::ParseError));
+        return Result<bool>(make_error_code(JsonErrorCode::ParseError));
     } catch (...) {
-        error_message = "Unknown error during parsing";
-        error_position = 0;
-        return Result<std::shared_ptr<JsonValue>>(make_error_code(JsonErrorCode::UnknownError));
+        return Result<bool>(make_error_code(JsonErrorCode::UnknownError));
+    }
+}
+
+Result<JsonRef<JsonValue>> JsonParser::parse_with_error(
+    std::string_view input,
+    std::string& error_message,
+    size_t& error_position
+) {
+    JsonParseError error;
+    auto result = parse_document(input, JsonParseOptions(), nullptr, &error);
+    if (!result) {
+        error_message = std::move(error.message);
+        error_position = error.position;
     }
+    return result;
 }
 
 } // namespace jansson
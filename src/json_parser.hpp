@@ -4,44 +4,315 @@
 #include <string>
 #include <string_view>
 #include <memory>
+#include <vector>
+#include <cstdint>
 #include "json_value.hpp"
+#include "json_builder.hpp"
 #include "json_error.hpp"
+#include "memory_policy.hpp"
+#include "json_sax.hpp"
 
 namespace jansson {
 
+class JsonThreadPool;
+class JsonShapeTable;
+class JsonProjection;
+
+// Options controlling how JsonParser processes its input
+struct JsonParseOptions {
+    // Run a vectorized stage-1 pass that indexes structural characters and
+    // let the parser jump between tokens using that index.
+    bool use_structural_index = false;
+    
+    // Allocate every node from this arena instead of the heap. The arena
+    // must outlive the returned tree (see JsonDocument).
+    JsonArena* arena = nullptr;
+    
+    // Strings without escapes reference the input instead of being copied
+    // (see JsonStringValue::view). The input must outlive the returned
+    // tree; JsonDocument keeps its own copy of the input when this is set.
+    bool borrow_strings = false;
+    
+    // Object keys are interned so that repeated member names share one
+    // JsonKey record. Keys are interned in key_table if set (a
+    // synchronized table when parsing in parallel), otherwise in a table
+    // local to the parse.
+    bool intern_keys = true;
+    JsonKeyTable* key_table = nullptr;
+    
+    // Objects are assigned shared key layouts (see JsonShape) from
+    // shape_table if set (a synchronized table when parsing in parallel),
+    // otherwise from a table local to the parse
+    bool share_shapes = false;
+    JsonShapeTable* shape_table = nullptr;
+    
+    // A top-level array in an input of at least this many bytes is split at
+    // its top-level commas after the structural pre-scan, and its elements
+    // are parsed concurrently into a single JsonArray. Ignored when an arena
+    // is set, since arenas are not thread-safe. 0 disables.
+    std::size_t parallel_threshold = 0;
+    
+    // Pool for parallel parsing; nullptr selects JsonThreadPool::shared().
+    // Must not be called from a task running on the same pool.
+    JsonThreadPool* pool = nullptr;
+    
+    // Build only the values selected by projection (see JsonProjection)
+    // and skip the rest of the input without building anything. Skipped
+    // subtrees are only checked for terminated strings and balanced
+    // brackets. Disables parallel parsing.
+    const JsonProjection* projection = nullptr;
+    
+    // Stop after the first complete value instead of failing when more
+    // input follows it; what follows is not examined. Disables parallel
+    // parsing and the structural index.
+    bool allow_trailing_data = false;
+    
+    // Limits for untrusted input. A parse that exceeds one fails with
+    // JsonErrorCode::LimitExceeded; 0 disables a limit. Only nesting is
+    // limited by default, at jansson's JSON_PARSER_MAX_DEPTH.
+    std::size_t max_depth = 2048;
+    // Values of any kind, containers included, that are built
+    std::size_t max_nodes = 0;
+    // Bytes in one decoded string or key
+    std::size_t max_string_length = 0;
+    // Bytes of input; for parse_first, bytes consumed
+    std::size_t max_input_size = 0;
+};
+
+// Where and why a parse failed. line and column are 1-based; column and
+// position count bytes from the start of the line and of the input.
+struct JsonParseError {
+    std::string message;
+    std::size_t line = 0;
+    std::size_t column = 0;
+    std::size_t position = 0;
+};
+
 class JsonParser {
 public:
     // Parse JSON from string
-    static Result<std::shared_ptr<JsonValue>> parse(std::string_view input);
+    static Result<JsonRef<JsonValue>> parse(std::string_view input);
+    
+    // Parse JSON from string with explicit options
+    static Result<JsonRef<JsonValue>> parse(std::string_view input,
+                                                    const JsonParseOptions& options);
+    
+    // Parse JSON and describe the failure in error if there is one
+    static Result<JsonRef<JsonValue>> parse(std::string_view input,
+                                            const JsonParseOptions& options,
+                                            JsonParseError& error);
+    
+    // Parse the value at the start of input, which may be followed by more
+    // values (e.g. pipelined messages in a receive buffer). consumed is set
+    // to the bytes read, the value and the whitespace after it, so the next
+    // value starts at input.substr(consumed). Only those bytes are examined;
+    // allow_trailing_data is implied.
+    static Result<JsonRef<JsonValue>> parse_first(std::string_view input, std::size_t& consumed);
+    static Result<JsonRef<JsonValue>> parse_first(std::string_view input,
+                                                  const JsonParseOptions& options,
+                                                  std::size_t& consumed);
+    
+    // Parse a file, memory-mapped where possible. Strings are always copied
+    // out of the mapping, which is released before returning; use
+    // JsonDocument::parse_file to keep it for borrowed strings.
+    static Result<JsonRef<JsonValue>> parse_file(const std::string& path);
+    static Result<JsonRef<JsonValue>> parse_file(const std::string& path,
+                                                         const JsonParseOptions& options);
+    
+    // Parse JSON and report it to handler as a sequence of events, without
+    // building a tree. The value is true if the whole input was parsed and
+    // false if the handler stopped early.
+    static Result<bool> parse(std::string_view input, JsonHandler& handler);
+    
+    // The same with the limits in options (max_depth, max_nodes, where
+    // every reported value counts, max_string_length and max_input_size);
+    // its other options do not apply to events
+    static Result<bool> parse(std::string_view input, const JsonParseOptions& options,
+                              JsonHandler& handler);
     
     // Parse JSON from string with error reporting
-    static Result<std::shared_ptr<JsonValue>> parse_with_error(
+    static Result<JsonRef<JsonValue>> parse_with_error(
         std::string_view input,
         std::string& error_message,
         size_t& error_position
     );
 
 private:
+    // Shared by parse and parse_first; trailing input is allowed when
+    // consumed is set or options allow it. error is filled in on failure
+    // if set.
+    static Result<JsonRef<JsonValue>> parse_document(std::string_view input,
+                                                     const JsonParseOptions& options,
+                                                     std::size_t* consumed,
+                                                     JsonParseError* error);
+    
+    // The push parser decodes buffered tokens with the same tokenizer
+    friend class JsonStreamParser;
+    
+    // A container being parsed: where its contents start on the builder
+    // stack and, in an object, the key of the member being parsed
+    struct ParseFrame {
+        JsonBuilder::Mark mark;
+        bool object;
+        JsonKey key;
+    };
+    
+    // Errors are not thrown: the step that finds one records it here
+    // and returns a null or false result, which every caller passes
+    // straight back up.
     struct ParseContext {
         std::string_view input;
         size_t position = 0;
+        bool failed = false;
+        JsonErrorCode error_code = JsonErrorCode::ParseError;
         std::string error_message;
         size_t error_position = 0;
+        
+        // Record the error (the first one wins) and return false
+        bool fail(std::string_view message, size_t at,
+                  JsonErrorCode code = JsonErrorCode::ParseError) {
+            if (!failed) {
+                failed = true;
+                error_code = code;
+                error_message.assign(message);
+                error_position = at;
+            }
+            return false;
+        }
+        
+        // Limits, with 0 in the options mapped to the largest value so
+        // each check is a single comparison
+        size_t max_depth = SIZE_MAX;
+        size_t max_nodes = SIZE_MAX;
+        size_t max_string_length = SIZE_MAX;
+        size_t depth = 0;
+        size_t nodes = 0;
+        
+        // Open containers of the iterative parser, shared by nested calls
+        std::vector<ParseFrame> frames;
+        
+        // Enter a container; false if that nests too deeply
+        bool enter(size_t at) {
+            if (depth >= max_depth) {
+                return fail("Maximum nesting depth exceeded", at, JsonErrorCode::LimitExceeded);
+            }
+            depth++;
+            return true;
+        }
+        
+        // Count a value that is built; false if there are too many
+        bool count_node(size_t at) {
+            if (++nodes > max_nodes) {
+                return fail("Too many values", at, JsonErrorCode::LimitExceeded);
+            }
+            return true;
+        }
+        
+        // Check the length of a string starting at at
+        bool string_fits(size_t length, size_t at) {
+            if (length > max_string_length) {
+                return fail("String too long", at, JsonErrorCode::LimitExceeded);
+            }
+            return true;
+        }
+        
+        // Optional stage-1 structural index and the next entry to visit
+        const std::vector<std::uint32_t>* structurals = nullptr;
+        size_t next_structural = 0;
+        
+        // Storage for the index of this parse, when one is built
+        std::vector<std::uint32_t> index;
+        
+        // Decoded text of an escaped key, reused from key to key
+        std::string scratch;
+        
+        // Arena that nodes are allocated from (heap if null)
+        JsonArena* arena = nullptr;
+        
+        // String values may reference the input
+        bool borrow_strings = false;
+        
+        // Table that object keys are interned in (none if null)
+        JsonKeyTable* keys = nullptr;
+        
+        // Table that objects take their shapes from (none if null)
+        JsonShapeTable* shapes = nullptr;
+        
+        // Paths to build; everything else is skipped (all if null)
+        const JsonProjection* projection = nullptr;
+        
+        // Scratch stack shared by every container of the parse, so each
+        // one is allocated once at its final size. Allocates from arena.
+        JsonBuilder builder;
+        
+        // Return to the state of a new context, keeping the capacity of
+        // the stacks and buffers unless they grew unusually large
+        void reset() noexcept;
     };
     
-    static std::shared_ptr<JsonValue> parse_value(ParseContext& ctx);
-    static std::shared_ptr<JsonObject> parse_object(ParseContext& ctx);
-    static std::shared_ptr<JsonArray> parse_array(ParseContext& ctx);
-    static std::shared_ptr<JsonStringValue> parse_string(ParseContext& ctx);
-    static std::shared_ptr<JsonNumber> parse_number(ParseContext& ctx);
-    static std::shared_ptr<JsonBoolean> parse_boolean(ParseContext& ctx);
-    static std::shared_ptr<JsonNull> parse_null(ParseContext& ctx);
+    // The context of one parse. Each thread keeps a context between
+    // parses, so steady-state parsing reuses its stacks and buffers instead
+    // of allocating them again; a parse started while the thread's context
+    // is in use (from a handler, or by a task run inline) gets its own.
+    class ContextLease;
+    
+    // A number as scanned from the input
+    struct NumberToken {
+        bool is_integer = false;
+        std::int64_t integer = 0;
+        double real = 0.0;
+    };
+    
+    // Containers are parsed iteratively on ctx.frames
+    static JsonRef<JsonValue> parse_value(ParseContext& ctx);
+    static JsonRef<JsonValue> parse_scalar(ParseContext& ctx);
+    static bool parse_member_key(ParseContext& ctx, JsonKey& key);
+    static JsonRef<JsonValue> finish_container(ParseContext& ctx);
+    static JsonRef<JsonStringValue> parse_string(ParseContext& ctx);
+    static JsonRef<JsonNumber> parse_number(ParseContext& ctx);
+    static JsonRef<JsonBoolean> parse_boolean(ParseContext& ctx);
+    static JsonRef<JsonNull> parse_null(ParseContext& ctx);
+    
+    // Parse the value under projection trie node (which selects only some
+    // of it); null if it is a scalar, which the projection drops
+    static JsonRef<JsonValue> parse_projected(ParseContext& ctx, std::uint32_t node);
+    static JsonRef<JsonObject> parse_object_projected(ParseContext& ctx, std::uint32_t node);
+    static JsonRef<JsonArray> parse_array_projected(ParseContext& ctx, std::uint32_t node);
+    
+    // Move past the value at the current position without decoding it
+    static bool skip_value(ParseContext& ctx);
+    static bool skip_string(ParseContext& ctx);
+    
+    // After a failed parse of input cut at max_input_size: whether the
+    // value goes on past the cut, rather than being malformed before it
+    static bool runs_past_window(ParseContext& ctx);
+    
+    // Parse a top-level array by splitting it into element ranges; null if
+    // the index does not describe a splittable array
+    static JsonRef<JsonValue> parse_array_parallel(ParseContext& ctx, const JsonParseOptions& options);
+    
+    static bool emit_value(ParseContext& ctx, JsonHandler& handler);
+    static bool emit_object(ParseContext& ctx, JsonHandler& handler);
+    static bool emit_array(ParseContext& ctx, JsonHandler& handler);
+    static bool emit_string(ParseContext& ctx, JsonHandler& handler, bool is_key);
     
     static void skip_whitespace(ParseContext& ctx);
     static char peek(ParseContext& ctx);
     static char consume(ParseContext& ctx);
-    static void expect(ParseContext& ctx, char expected);
-    static std::string parse_raw_string(ParseContext& ctx);
+    static bool expect(ParseContext& ctx, char expected);
+    static bool expect_literal(ParseContext& ctx, std::string_view literal);
+    static bool parse_raw_string(ParseContext& ctx, std::string& result);
+    static bool parse_key(ParseContext& ctx, JsonKey& key);
+    static bool scan_plain_string(ParseContext& ctx, std::string_view& text);
+    static bool scan_number(ParseContext& ctx, NumberToken& token);
+    
+    // Copy the limits in options to ctx
+    static void set_limits(ParseContext& ctx, const JsonParseOptions& options);
+    
+    // Fill in error for a failure at position in input
+    static void describe_error(std::string_view input, std::string_view message, size_t position,
+                               JsonParseError& error);
+    static bool indexed_string_end(ParseContext& ctx, size_t& end);
 };
 
 } // namespace jansson
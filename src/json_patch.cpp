@@ -0,0 +1,486 @@
+#include "json_patch.hpp"
+#include "json_pointer.hpp"
+#include <algorithm>
+
+namespace jansson {
+
+namespace {
+
+// Reference to a value held by a const tree, for sharing it into another
+JsonRef<JsonValue> share(const JsonValue& value) {
+    return JsonRef<JsonValue>(const_cast<JsonValue*>(&value));
+}
+
+// Equal values, deciding by structural hash where it can
+bool same(const JsonValue& lhs, const JsonValue& rhs) noexcept {
+    return &lhs == &rhs || (lhs.hash() == rhs.hash() && lhs.equals(rhs));
+}
+
+// A document shared with someone else is copied before it is modified
+void unshare(JsonRef<JsonValue>& document) {
+    if (document.use_count() > 1 && (document->is_array() || document->is_object())) {
+        document = document->cow_clone();
+    }
+}
+
+// Failure of one operation
+struct Failure {
+    JsonErrorCode code = JsonErrorCode::Success;
+    const char* message = nullptr;
+
+    explicit operator bool() const noexcept { return code != JsonErrorCode::Success; }
+};
+
+constexpr Failure ok{};
+
+Failure fail(JsonErrorCode code, const char* message) noexcept {
+    return Failure{code, message};
+}
+
+// Follow token index of path down from node, for modification
+Failure step(JsonValue*& node, const JsonPointer& path, std::size_t index) {
+    if (node->is_object()) {
+        JsonValue* child = static_cast<JsonObject*>(node)->mutable_get(path.token(index));
+        if (!child) {
+            return fail(JsonErrorCode::KeyNotFound, "Member not found");
+        }
+        node = child;
+    } else if (node->is_array()) {
+        auto& array = static_cast<JsonArray&>(*node);
+        std::size_t position = path.array_index(index);
+        if (position >= array.size()) {
+            return fail(JsonErrorCode::IndexOutOfBounds, "Array index out of bounds");
+        }
+        node = &array.mutable_at(position);
+    } else {
+        return fail(JsonErrorCode::InvalidType, "Path runs through a scalar");
+    }
+    return ok;
+}
+
+// Container holding the value path (not empty) refers to
+Failure find_parent(JsonRef<JsonValue>& document, const JsonPointer& path, JsonValue*& parent) {
+    unshare(document);
+    parent = document.get();
+    for (std::size_t i = 0; i + 1 < path.size(); ++i) {
+        if (Failure failure = step(parent, path, i)) {
+            return failure;
+        }
+    }
+    if (!parent->is_array() && !parent->is_object()) {
+        return fail(JsonErrorCode::InvalidType, "Path runs through a scalar");
+    }
+    return ok;
+}
+
+Failure add(JsonRef<JsonValue>& document, const JsonPointer& path, JsonRef<JsonValue> value) {
+    if (path.empty()) {
+        document = std::move(value);
+        return ok;
+    }
+    JsonValue* parent = nullptr;
+    if (Failure failure = find_parent(document, path, parent)) {
+        return failure;
+    }
+    
+    std::size_t last = path.size() - 1;
+    if (parent->is_object()) {
+        static_cast<JsonObject*>(parent)->set(path.token(last), std::move(value));
+        return ok;
+    }
+    auto& array = static_cast<JsonArray&>(*parent);
+    if (path.is_end_of_array(last)) {
+        array.push_back(std::move(value));
+        return ok;
+    }
+    std::size_t position = path.array_index(last);
+    if (position > array.size()) {
+        return fail(JsonErrorCode::IndexOutOfBounds, "Array index out of bounds");
+    }
+    array.insert(position, std::move(value));
+    return ok;
+}
+
+Failure remove(JsonRef<JsonValue>& document, const JsonPointer& path, JsonRef<JsonValue>* removed) {
+    if (path.empty()) {
+        return fail(JsonErrorCode::InvalidArgument, "Cannot remove the whole document");
+    }
+    JsonValue* parent = nullptr;
+    if (Failure failure = find_parent(document, path, parent)) {
+        return failure;
+    }
+    
+    std::size_t last = path.size() - 1;
+    JsonRef<JsonValue> value;
+    if (parent->is_object()) {
+        value = static_cast<JsonObject*>(parent)->take(path.token(last));
+        if (!value) {
+            return fail(JsonErrorCode::KeyNotFound, "Member not found");
+        }
+    } else {
+        auto& array = static_cast<JsonArray&>(*parent);
+        std::size_t position = path.array_index(last);
+        if (position >= array.size()) {
+            return fail(JsonErrorCode::IndexOutOfBounds, "Array index out of bounds");
+        }
+        value = array.take(position);
+    }
+    if (removed) {
+        *removed = std::move(value);
+    }
+    return ok;
+}
+
+Failure replace(JsonRef<JsonValue>& document, const JsonPointer& path, JsonRef<JsonValue> value) {
+    if (path.empty()) {
+        document = std::move(value);
+        return ok;
+    }
+    JsonValue* parent = nullptr;
+    if (Failure failure = find_parent(document, path, parent)) {
+        return failure;
+    }
+    
+    std::size_t last = path.size() - 1;
+    if (parent->is_object()) {
+        auto& object = static_cast<JsonObject&>(*parent);
+        if (!object.has(path.token(last))) {
+            return fail(JsonErrorCode::KeyNotFound, "Member not found");
+        }
+        object.set(path.token(last), std::move(value));
+        return ok;
+    }
+    auto& array = static_cast<JsonArray&>(*parent);
+    std::size_t position = path.array_index(last);
+    if (position >= array.size()) {
+        return fail(JsonErrorCode::IndexOutOfBounds, "Array index out of bounds");
+    }
+    array.set(position, std::move(value));
+    return ok;
+}
+
+// Whether prefix names a proper ancestor of path
+bool is_ancestor(const JsonPointer& prefix, const JsonPointer& path) noexcept {
+    if (prefix.size() >= path.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+        if (prefix.token(i) != path.token(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pointer in member name of an operation
+Failure pointer_member(const JsonObject& operation, const char* name, JsonPointer& pointer) {
+    JsonRef<JsonValue> text = operation.get(name);
+    if (!text || !text->is_string()) {
+        return fail(JsonErrorCode::InvalidArgument, "Operation is missing a path");
+    }
+    auto parsed = JsonPointer::parse(static_cast<const JsonStringValue&>(*text).view());
+    if (!parsed) {
+        return fail(JsonErrorCode::InvalidArgument, "Invalid JSON Pointer");
+    }
+    pointer = std::move(parsed.value());
+    return ok;
+}
+
+Failure apply_operation(JsonRef<JsonValue>& document, const JsonValue& entry) {
+    if (!entry.is_object()) {
+        return fail(JsonErrorCode::InvalidArgument, "Operation is not an object");
+    }
+    const auto& operation = static_cast<const JsonObject&>(entry);
+    JsonRef<JsonValue> name = operation.get("op");
+    if (!name || !name->is_string()) {
+        return fail(JsonErrorCode::InvalidArgument, "Operation has no \"op\"");
+    }
+    std::string_view op = static_cast<const JsonStringValue&>(*name).view();
+    
+    JsonPointer path;
+    if (Failure failure = pointer_member(operation, "path", path)) {
+        return failure;
+    }
+    
+    if (op == "add" || op == "replace" || op == "test") {
+        JsonRef<JsonValue> value = operation.get("value");
+        if (!value) {
+            return fail(JsonErrorCode::InvalidArgument, "Operation is missing a value");
+        }
+        if (op == "add") {
+            return add(document, path, std::move(value));
+        }
+        if (op == "replace") {
+            return replace(document, path, std::move(value));
+        }
+        const JsonValue* current = path.find(*document);
+        if (!current) {
+            return fail(JsonErrorCode::KeyNotFound, "Tested value not found");
+        }
+        if (!current->equals(*value)) {
+            return fail(JsonErrorCode::InvalidArgument, "Test failed");
+        }
+        return ok;
+    }
+    if (op == "remove") {
+        return remove(document, path, nullptr);
+    }
+    if (op == "move" || op == "copy") {
+        JsonPointer from;
+        if (Failure failure = pointer_member(operation, "from", from)) {
+            return failure;
+        }
+        if (op == "copy") {
+            const JsonValue* source = from.find(*document);
+            if (!source) {
+                return fail(JsonErrorCode::KeyNotFound, "Source value not found");
+            }
+            return add(document, path, share(*source));
+        }
+        if (from == path) {
+            return ok;
+        }
+        if (is_ancestor(from, path)) {
+            return fail(JsonErrorCode::InvalidArgument, "Cannot move a value into itself");
+        }
+        JsonRef<JsonValue> value;
+        if (Failure failure = remove(document, from, &value)) {
+            return failure;
+        }
+        return add(document, path, std::move(value));
+    }
+    return fail(JsonErrorCode::InvalidArgument, "Unknown operation");
+}
+
+// Builds a JSON Patch, keeping the escaped path of the values compared
+class Differ {
+public:
+    explicit Differ(JsonArray& operations) : operations_(operations) {}
+
+    void diff(const JsonValue& source, const JsonValue& target) {
+        if (same(source, target)) {
+            return;
+        }
+        if (source.type() != target.type() || (!source.is_array() && !source.is_object())) {
+            emit("replace", &target);
+        } else if (source.is_array()) {
+            diff_arrays(static_cast<const JsonArray&>(source), static_cast<const JsonArray&>(target));
+        } else {
+            diff_objects(static_cast<const JsonObject&>(source), static_cast<const JsonObject&>(target));
+        }
+    }
+
+private:
+    void diff_arrays(const JsonArray& source, const JsonArray& target) {
+        const auto& from = source.values();
+        const auto& to = target.values();
+        std::size_t prefix = 0;
+        while (prefix < from.size() && prefix < to.size() && same(*from[prefix], *to[prefix])) {
+            ++prefix;
+        }
+        std::size_t suffix = 0;
+        while (suffix < from.size() - prefix && suffix < to.size() - prefix &&
+               same(*from[from.size() - 1 - suffix], *to[to.size() - 1 - suffix])) {
+            ++suffix;
+        }
+        
+        std::size_t removed = from.size() - prefix - suffix;
+        std::size_t added = to.size() - prefix - suffix;
+        std::size_t common = std::min(removed, added);
+        for (std::size_t i = 0; i < common; ++i) {
+            std::size_t mark = push(prefix + i);
+            diff(*from[prefix + i], *to[prefix + i]);
+            path_.resize(mark);
+        }
+        // Each removal shifts the next element into the same position
+        for (std::size_t i = common; i < removed; ++i) {
+            std::size_t mark = push(prefix + common);
+            emit("remove", nullptr);
+            path_.resize(mark);
+        }
+        for (std::size_t i = common; i < added; ++i) {
+            std::size_t mark = push(prefix + i);
+            emit("add", to[prefix + i].get());
+            path_.resize(mark);
+        }
+    }
+
+    void diff_objects(const JsonObject& source, const JsonObject& target) {
+        const auto& to = target.values();
+        for (const auto& [key, value] : source) {
+            std::size_t mark = push(key.view());
+            auto it = to.find(key.view());
+            if (it == to.end()) {
+                emit("remove", nullptr);
+            } else {
+                diff(*value, *it->second);
+            }
+            path_.resize(mark);
+        }
+        for (const auto& [key, value] : target) {
+            if (!source.has(key.view())) {
+                std::size_t mark = push(key.view());
+                emit("add", value.get());
+                path_.resize(mark);
+            }
+        }
+    }
+
+    // Append a reference token to the path; returns the length to restore
+    std::size_t push(std::string_view token) {
+        std::size_t mark = path_.size();
+        path_ += '/';
+        for (char c : token) {
+            if (c == '~') {
+                path_ += "~0";
+            } else if (c == '/') {
+                path_ += "~1";
+            } else {
+                path_ += c;
+            }
+        }
+        return mark;
+    }
+
+    std::size_t push(std::size_t index) {
+        std::size_t mark = path_.size();
+        path_ += '/';
+        path_ += std::to_string(index);
+        return mark;
+    }
+
+    void emit(const char* op, const JsonValue* value) {
+        auto operation = JsonObject::create();
+        operation->set("op", JsonStringValue::create(op));
+        operation->set("path", JsonStringValue::create(path_));
+        if (value) {
+            operation->set("value", share(*value));
+        }
+        operations_.push_back(std::move(operation));
+    }
+
+    JsonArray& operations_;
+    std::string path_;
+};
+
+// Whether applying patch to a non-object would need its null members
+// dropped
+bool has_null_members(const JsonValue& patch) noexcept {
+    if (!patch.is_object()) {
+        return false;
+    }
+    for (const auto& [key, value] : static_cast<const JsonObject&>(patch)) {
+        if (value->is_null() || has_null_members(*value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Result of merging patch into a value that is not an object
+JsonRef<JsonValue> merged_alone(const JsonValue& patch) {
+    if (!has_null_members(patch)) {
+        return share(patch);
+    }
+    auto result = JsonObject::create();
+    for (const auto& [key, value] : static_cast<const JsonObject&>(patch)) {
+        if (!value->is_null()) {
+            result->set(key, merged_alone(*value));
+        }
+    }
+    return result;
+}
+
+void merge_into(JsonObject& target, const JsonObject& patch) {
+    for (const auto& [key, value] : patch) {
+        if (value->is_null()) {
+            target.erase(key.view());
+        } else if (value->is_object()) {
+            JsonValue* child = target.mutable_get(key.view());
+            if (child && child->is_object()) {
+                merge_into(static_cast<JsonObject&>(*child), static_cast<const JsonObject&>(*value));
+            } else {
+                target.set(key, merged_alone(*value));
+            }
+        } else {
+            target.set(key, value);
+        }
+    }
+}
+
+} // namespace
+
+// JsonPatch implementation
+Result<bool> JsonPatch::apply(JsonRef<JsonValue>& document, const JsonValue& patch, JsonPatchError* error) {
+    auto report = [&](std::size_t operation, Failure failure) {
+        if (error) {
+            error->operation = operation;
+            error->message = failure.message;
+        }
+        return Result<bool>(make_error_code(failure.code));
+    };
+    
+    if (!patch.is_array()) {
+        return report(0, fail(JsonErrorCode::InvalidArgument, "Patch is not an array"));
+    }
+    if (!document) {
+        return report(0, fail(JsonErrorCode::InvalidArgument, "No document"));
+    }
+    const auto& operations = static_cast<const JsonArray&>(patch).values();
+    for (std::size_t i = 0; i < operations.size(); ++i) {
+        if (Failure failure = apply_operation(document, *operations[i])) {
+            return report(i, failure);
+        }
+    }
+    return Result<bool>(true);
+}
+
+JsonRef<JsonArray> JsonPatch::diff(const JsonValue& source, const JsonValue& target) {
+    auto operations = JsonArray::create();
+    Differ(*operations).diff(source, target);
+    return operations;
+}
+
+// JsonMergePatch implementation
+void JsonMergePatch::apply(JsonRef<JsonValue>& document, const JsonValue& patch) {
+    if (!patch.is_object()) {
+        document = share(patch);
+        return;
+    }
+    if (!document || !document->is_object()) {
+        document = merged_alone(patch);
+        return;
+    }
+    unshare(document);
+    merge_into(static_cast<JsonObject&>(*document), static_cast<const JsonObject&>(patch));
+}
+
+JsonRef<JsonValue> JsonMergePatch::diff(const JsonValue& source, const JsonValue& target) {
+    if (!source.is_object() || !target.is_object()) {
+        return share(target);
+    }
+    
+    const auto& from = static_cast<const JsonObject&>(source);
+    const auto& to = static_cast<const JsonObject&>(target);
+    auto patch = JsonObject::create();
+    for (const auto& [key, value] : from) {
+        if (!to.has(key.view())) {
+            patch->set(key, JsonNull::create());
+        }
+    }
+    for (const auto& [key, value] : to) {
+        JsonRef<JsonValue> previous = from.get(key.view());
+        if (value->is_null()) {
+            if (previous && !previous->is_null()) {
+                patch->set(key, value);
+            }
+        } else if (!previous) {
+            patch->set(key, value);
+        } else if (!same(*previous, *value)) {
+            patch->set(key, previous->is_object() && value->is_object() ? diff(*previous, *value) : value);
+        }
+    }
+    return patch;
+}
+
+} // namespace jansson
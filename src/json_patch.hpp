@@ -0,0 +1,64 @@
+#ifndef JSON_PATCH_HPP
+#define JSON_PATCH_HPP
+
+#include <cstddef>
+#include <string>
+#include "json_value.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+// Why JsonPatch::apply failed: the position of the operation in the patch
+// and a description
+struct JsonPatchError {
+    std::size_t operation = 0;
+    std::string message;
+};
+
+// JSON Patch (RFC 6902).
+//
+// Patches are applied in place. Containers on each operation's path are
+// reached through mutable_at()/mutable_get(), so only those shared with
+// another tree are copied (shallowly, see cow_clone()); everything else is
+// modified where it is. "move" relinks the subtree it moves, and values
+// taken from the patch ("add", "replace", and "copy" sources) are shared
+// rather than cloned, as cow_clone() shares children.
+class JsonPatch {
+public:
+    // Apply patch, an array of operation objects, in order. A path of ""
+    // in "add" or "replace" swaps the whole document. Fails with
+    // InvalidArgument for a malformed operation or a failed "test",
+    // KeyNotFound or IndexOutOfBounds when a location does not exist, and
+    // InvalidType when a path runs through a scalar. Operations before the
+    // failing one stay applied; patch a cow_clone() when the original must
+    // survive a failed patch unchanged.
+    static Result<bool> apply(JsonRef<JsonValue>& document, const JsonValue& patch,
+                              JsonPatchError* error = nullptr);
+
+    // Patch that turns source into target, made of "add", "remove" and
+    // "replace" operations. Subtrees are compared by structural hash
+    // first: hashes are kept between calls (see JsonValue::hash), so a
+    // subtree that changed is told apart from the old one without walking
+    // both. Arrays keep their common prefix and suffix and differ element
+    // by element in between. Values in the patch are shared with target.
+    static JsonRef<JsonArray> diff(const JsonValue& source, const JsonValue& target);
+};
+
+// JSON Merge Patch (RFC 7386): an object whose members replace those of
+// the target, recursively, with null deleting a member; anything but an
+// object replaces the target outright.
+class JsonMergePatch {
+public:
+    // Merge patch into document in place, as JsonPatch::apply does. Never
+    // fails.
+    static void apply(JsonRef<JsonValue>& document, const JsonValue& patch);
+
+    // Merge patch that turns source into target. A merge patch cannot set
+    // a member to null, since null deletes it, so a member that target
+    // sets to null comes out deleted. Values are shared with target.
+    static JsonRef<JsonValue> diff(const JsonValue& source, const JsonValue& target);
+};
+
+} // namespace jansson
+
+#endif // JSON_PATCH_HPP
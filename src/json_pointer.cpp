@@ -0,0 +1,169 @@
+#include "json_pointer.hpp"
+#include <limits>
+
+namespace jansson {
+
+// Array index in a reference token: "0" or digits without a leading zero
+static std::size_t parse_array_index(std::string_view token) noexcept {
+    if (token.empty() || (token[0] == '0' && token.size() > 1)) {
+        return JsonPointer::npos;
+    }
+    std::size_t value = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') {
+            return JsonPointer::npos;
+        }
+        std::size_t digit = static_cast<std::size_t>(c - '0');
+        if (value > (std::numeric_limits<std::size_t>::max() - 1 - digit) / 10) {
+            return JsonPointer::npos;
+        }
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+Result<JsonPointer> JsonPointer::parse(std::string_view text) {
+    JsonPointer pointer;
+    if (text.empty()) {
+        return Result<JsonPointer>(std::move(pointer));
+    }
+    if (text[0] != '/' || text.size() > std::numeric_limits<std::uint32_t>::max()) {
+        return Result<JsonPointer>(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+
+    pointer.storage_.reserve(text.size());
+    std::size_t pos = 1;
+    for (;;) {
+        auto offset = static_cast<std::uint32_t>(pointer.storage_.size());
+        while (pos < text.size() && text[pos] != '/') {
+            char c = text[pos++];
+            if (c == '~') {
+                char escape = pos < text.size() ? text[pos++] : '\0';
+                if (escape == '0') {
+                    c = '~';
+                } else if (escape == '1') {
+                    c = '/';
+                } else {
+                    return Result<JsonPointer>(make_error_code(JsonErrorCode::InvalidArgument));
+                }
+            }
+            pointer.storage_ += c;
+        }
+
+        auto length = static_cast<std::uint32_t>(pointer.storage_.size() - offset);
+        std::string_view token(pointer.storage_.data() + offset, length);
+        pointer.tokens_.push_back(Token{offset, length, parse_array_index(token)});
+
+        if (pos == text.size()) {
+            break;
+        }
+        ++pos;
+    }
+    return Result<JsonPointer>(std::move(pointer));
+}
+
+JsonPointer JsonPointer::parent() const {
+    JsonPointer result;
+    if (tokens_.empty()) {
+        return result;
+    }
+    result.tokens_.assign(tokens_.begin(), tokens_.end() - 1);
+    const Token& last = tokens_.back();
+    result.storage_.assign(storage_, 0, last.offset);
+    return result;
+}
+
+std::string JsonPointer::to_string() const {
+    std::string result;
+    result.reserve(storage_.size() + tokens_.size());
+    for (std::size_t i = 0; i < tokens_.size(); ++i) {
+        result += '/';
+        for (char c : token(i)) {
+            if (c == '~') {
+                result += "~0";
+            } else if (c == '/') {
+                result += "~1";
+            } else {
+                result += c;
+            }
+        }
+    }
+    return result;
+}
+
+const JsonValue* JsonPointer::find(const JsonValue& root) const noexcept {
+    const JsonValue* value = &root;
+    for (std::size_t i = 0; i < tokens_.size(); ++i) {
+        if (value->is_object()) {
+            const auto& members = static_cast<const JsonObject*>(value)->values();
+            auto found = members.find(token(i));
+            if (found == members.end()) {
+                return nullptr;
+            }
+            value = found->second.get();
+        } else if (value->is_array()) {
+            const auto& elements = static_cast<const JsonArray*>(value)->values();
+            std::size_t index = tokens_[i].array_index;
+            if (index >= elements.size()) {
+                return nullptr;
+            }
+            value = elements[index].get();
+        } else {
+            return nullptr;
+        }
+    }
+    return value;
+}
+
+JsonValue* JsonPointer::find(JsonValue& root) const noexcept {
+    return const_cast<JsonValue*>(find(static_cast<const JsonValue&>(root)));
+}
+
+JsonRef<JsonValue> JsonPointer::get(const JsonValue& root) const {
+    return JsonRef<JsonValue>(const_cast<JsonValue*>(find(root)));
+}
+
+Result<JsonLazyValue> JsonPointer::find(const JsonLazyValue& root) const {
+    JsonLazyValue value = root;
+    for (std::size_t i = 0; i < tokens_.size(); ++i) {
+        if (value.is_array() && tokens_[i].array_index == npos) {
+            return Result<JsonLazyValue>(make_error_code(JsonErrorCode::IndexOutOfBounds));
+        }
+        // Scalars fail in get() with InvalidType
+        Result<JsonLazyValue> next = value.is_array() ? value.at(tokens_[i].array_index)
+                                                      : value.get(token(i));
+        if (!next) {
+            return next;
+        }
+        value = next.value();
+    }
+    return Result<JsonLazyValue>(value);
+}
+
+JsonFrozenValue JsonPointer::find(const JsonFrozenValue& root) const noexcept {
+    JsonFrozenValue value = root;
+    for (std::size_t i = 0; i < tokens_.size() && value; ++i) {
+        if (value.is_object()) {
+            value = value.find(token(i));
+        } else if (value.is_array() && tokens_[i].array_index < value.size()) {
+            value = value.at(tokens_[i].array_index);
+        } else {
+            return JsonFrozenValue();
+        }
+    }
+    return value;
+}
+
+bool operator==(const JsonPointer& lhs, const JsonPointer& rhs) noexcept {
+    if (lhs.tokens_.size() != rhs.tokens_.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.tokens_.size(); ++i) {
+        if (lhs.token(i) != rhs.token(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace jansson
@@ -0,0 +1,95 @@
+#ifndef JSON_POINTER_HPP
+#define JSON_POINTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_value.hpp"
+#include "json_lazy.hpp"
+#include "json_frozen.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+// JSON Pointer (RFC 6901), parsed once and evaluated any number of times.
+//
+// parse() splits the pointer into reference tokens, decodes the ~0 and ~1
+// escapes and converts tokens that are valid array indices to numbers, so
+// evaluation is a loop of member lookups and vector indexing that never
+// allocates. Lookups against a JsonLazyDocument only walk its structural
+// index: subtrees off the path are skipped, and nothing on it is decoded.
+// A pointer is immutable and may be shared between threads.
+class JsonPointer {
+public:
+    // Token value of reference tokens that are not array indices
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // The empty pointer, which refers to the whole document
+    JsonPointer() = default;
+
+    // Fails with InvalidArgument if text is neither empty nor starts with
+    // '/', or has a '~' not followed by '0' or '1'
+    static Result<JsonPointer> parse(std::string_view text);
+
+    // Number of reference tokens
+    std::size_t size() const noexcept { return tokens_.size(); }
+    bool empty() const noexcept { return tokens_.empty(); }
+
+    // Unescaped reference token
+    std::string_view token(std::size_t index) const noexcept {
+        const Token& token = tokens_[index];
+        return std::string_view(storage_.data() + token.offset, token.length);
+    }
+
+    // Array index named by a token, or npos if it is not one ("-" and
+    // numbers with leading zeros are not)
+    std::size_t array_index(std::size_t index) const noexcept { return tokens_[index].array_index; }
+
+    // Whether a token is "-", the position after the last array element
+    bool is_end_of_array(std::size_t index) const noexcept { return token(index) == "-"; }
+
+    // Pointer to the value containing this one (the empty pointer's parent
+    // is itself)
+    JsonPointer parent() const;
+
+    // Escaped string form; parse(to_string()) gives an equal pointer
+    std::string to_string() const;
+
+    // Value the pointer refers to, or null if it does not resolve. The
+    // result is borrowed from root.
+    const JsonValue* find(const JsonValue& root) const noexcept;
+    JsonValue* find(JsonValue& root) const noexcept;
+
+    // Owning reference to the value, or null if it does not resolve
+    JsonRef<JsonValue> get(const JsonValue& root) const;
+
+    // Lazy lookup; fails with KeyNotFound, IndexOutOfBounds or InvalidType
+    // where the path leaves the document (or with the document's
+    // SyntaxError for malformed text on the path)
+    Result<JsonLazyValue> find(const JsonLazyValue& root) const;
+
+    // Frozen lookup; empty if the pointer does not resolve
+    JsonFrozenValue find(const JsonFrozenValue& root) const noexcept;
+
+    friend bool operator==(const JsonPointer& lhs, const JsonPointer& rhs) noexcept;
+    friend bool operator!=(const JsonPointer& lhs, const JsonPointer& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+private:
+    struct Token {
+        std::uint32_t offset;
+        std::uint32_t length;
+        std::size_t array_index;
+    };
+
+    // Unescaped tokens, back to back
+    std::string storage_;
+    std::vector<Token> tokens_;
+};
+
+} // namespace jansson
+
+#endif // JSON_POINTER_HPP
@@ -0,0 +1,65 @@
+#include "json_projection.hpp"
+
+namespace jansson {
+
+JsonProjection::JsonProjection() : nodes_(1) {}
+
+JsonProjection::JsonProjection(const std::vector<JsonPointer>& paths) : JsonProjection() {
+    for (const auto& path : paths) {
+        add(path);
+    }
+}
+
+JsonProjection JsonProjection::keys(const std::vector<std::string>& names) {
+    JsonProjection projection;
+    for (const auto& name : names) {
+        projection.add_key(name);
+    }
+    return projection;
+}
+
+void JsonProjection::add(const JsonPointer& path) {
+    std::uint32_t node = 0;
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        if (nodes_[node].whole) {
+            return;
+        }
+
+        // A token names both an object member and, if it is a number, an
+        // array element; both lead to the same child
+        std::uint32_t child = member(node, path.token(i));
+        if (child == none) {
+            child = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+            nodes_[node].members.try_emplace(std::string(path.token(i)), child);
+            if (path.array_index(i) != JsonPointer::npos) {
+                nodes_[node].elements.emplace_back(path.array_index(i), child);
+            }
+        }
+        node = child;
+    }
+
+    // Everything below is selected; the subtrie is no longer consulted
+    Node& selected = nodes_[node];
+    selected.whole = true;
+    selected.members.clear();
+    selected.elements.clear();
+}
+
+void JsonProjection::add_key(std::string_view name) {
+    std::uint32_t child = member(0, name);
+    if (nodes_[0].whole) {
+        return;
+    }
+    if (child == none) {
+        child = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+        nodes_[0].members.try_emplace(std::string(name), child);
+    }
+    Node& selected = nodes_[child];
+    selected.whole = true;
+    selected.members.clear();
+    selected.elements.clear();
+}
+
+} // namespace jansson
@@ -0,0 +1,77 @@
+#ifndef JSON_PROJECTION_HPP
+#define JSON_PROJECTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "json_hash.hpp"
+#include "json_pointer.hpp"
+
+namespace jansson {
+
+// Set of paths for JsonParser to materialize (JsonParseOptions::projection).
+//
+// The paths form a trie: the parser walks it alongside the input, builds
+// nodes for selected values and everything below them, keeps the objects
+// and arrays on the way to a selected value, and skips every other
+// subtree with a scan that only follows strings and brackets. Kept arrays
+// hold just their selected elements, so element indices in the result
+// are not those of the input. A container on a selected path is kept
+// (possibly empty) even if nothing under it is present; a scalar where the
+// path needs a container is dropped.
+class JsonProjection {
+public:
+    // Selects only the root container, without any of its contents
+    JsonProjection();
+
+    explicit JsonProjection(const std::vector<JsonPointer>& paths);
+
+    // Top-level member whitelist
+    static JsonProjection keys(const std::vector<std::string>& names);
+
+    // Select the value at path and everything below it. The empty pointer
+    // selects the whole document.
+    void add(const JsonPointer& path);
+
+    // Select a top-level member
+    void add_key(std::string_view name);
+
+    // Whether the whole document is selected
+    bool selects_all() const noexcept { return nodes_[0].whole; }
+
+private:
+    friend class JsonParser;
+
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+    struct Node {
+        bool whole = false;
+        JsonHash<std::string, std::uint32_t> members;
+        std::vector<std::pair<std::size_t, std::uint32_t>> elements;
+    };
+
+    // Child of node for an object member or array element, or none
+    std::uint32_t member(std::uint32_t node, std::string_view key) const noexcept {
+        const auto& members = nodes_[node].members;
+        auto found = members.find(key);
+        return found == members.end() ? none : found->second;
+    }
+    std::uint32_t element(std::uint32_t node, std::size_t index) const noexcept {
+        for (const auto& entry : nodes_[node].elements) {
+            if (entry.first == index) {
+                return entry.second;
+            }
+        }
+        return none;
+    }
+    bool whole(std::uint32_t node) const noexcept { return nodes_[node].whole; }
+
+    std::vector<Node> nodes_;
+};
+
+} // namespace jansson
+
+#endif // JSON_PROJECTION_HPP
@@ -0,0 +1,904 @@
+#include "json_query.hpp"
+#include <limits>
+#include "json_builder.hpp"
+#include "json_parser.hpp"
+#include "json_sax.hpp"
+
+namespace jansson {
+
+// JMESPath truthiness: false, null and empty strings, arrays and objects
+// are false
+static bool truthy(const JsonValue* value) noexcept {
+    if (!value) {
+        return false;
+    }
+    switch (value->type()) {
+        case JsonType::Null:
+            return false;
+        case JsonType::Boolean:
+            return static_cast<const JsonBoolean*>(value)->value();
+        case JsonType::String:
+            return !static_cast<const JsonStringValue*>(value)->view().empty();
+        case JsonType::Array:
+            return !static_cast<const JsonArray*>(value)->empty();
+        case JsonType::Object:
+            return !static_cast<const JsonObject*>(value)->empty();
+        default:
+            return true;
+    }
+}
+
+static bool is_null(const JsonValue* value) noexcept {
+    return !value || value->is_null();
+}
+
+static JsonRef<JsonValue> share(const JsonValue* value) {
+    return JsonRef<JsonValue>(const_cast<JsonValue*>(value));
+}
+
+// Null results are represented by a null reference
+static JsonRef<JsonValue> normalize(JsonRef<JsonValue> value) {
+    return is_null(value.get()) ? JsonRef<JsonValue>() : std::move(value);
+}
+
+// Recursive descent over the expression. Filter operands are compiled into
+// pipelines of their own, appended to the query as they are found.
+class JsonQuery::Compiler {
+public:
+    Compiler(JsonQuery& query, std::string_view text) noexcept : query_(query), text_(text) {}
+
+    bool compile() {
+        query_.pipelines_.emplace_back();
+        Pipeline top;
+        if (!path(top)) {
+            return false;
+        }
+        while (accept('|')) {
+            if (!path(top)) {
+                return false;
+            }
+        }
+        skip_space();
+        if (position_ != text_.size()) {
+            return fail("Unexpected character");
+        }
+        query_.pipelines_[0] = std::move(top);
+        return true;
+    }
+
+    std::size_t position() const noexcept { return position_; }
+    const std::string& message() const noexcept { return message_; }
+
+private:
+    bool fail(const char* message) {
+        if (message_.empty()) {
+            message_ = message;
+        }
+        return false;
+    }
+
+    void skip_space() noexcept {
+        while (position_ < text_.size() &&
+               (text_[position_] == ' ' || text_[position_] == '\t' ||
+                text_[position_] == '\n' || text_[position_] == '\r')) {
+            ++position_;
+        }
+    }
+
+    char peek() noexcept {
+        skip_space();
+        return position_ < text_.size() ? text_[position_] : '\0';
+    }
+
+    bool accept(std::string_view token) noexcept {
+        skip_space();
+        if (text_.substr(position_, token.size()) != token) {
+            return false;
+        }
+        position_ += token.size();
+        return true;
+    }
+    bool accept(char c) noexcept { return accept(std::string_view(&c, 1)); }
+
+    // A path starts a new segment: head then any number of sub-expressions
+    bool path(Pipeline& pipeline) {
+        pipeline.emplace_back();
+        char c = peek();
+        if (accept('@')) {
+            // The current value
+        } else if (accept('*')) {
+            pipeline.back().push_back(Step{StepKind::Values});
+        } else if (c == '[') {
+            if (!bracket(pipeline)) {
+                return false;
+            }
+        } else if (!member(pipeline)) {
+            return false;
+        }
+
+        while (true) {
+            if (accept('.')) {
+                if (accept('*')) {
+                    pipeline.back().push_back(Step{StepKind::Values});
+                } else if (!member(pipeline)) {
+                    return false;
+                }
+            } else if (peek() == '[') {
+                if (!bracket(pipeline)) {
+                    return false;
+                }
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool member(Pipeline& pipeline) {
+        Step step{StepKind::Member};
+        if (!identifier(step.name)) {
+            return false;
+        }
+        pipeline.back().push_back(std::move(step));
+        return true;
+    }
+
+    bool identifier(std::string& name) {
+        skip_space();
+        std::size_t start = position_;
+        if (position_ < text_.size() && text_[position_] == '"') {
+            for (++position_; position_ < text_.size() && text_[position_] != '"'; ++position_) {
+                if (text_[position_] == '\\') {
+                    ++position_;
+                }
+            }
+            if (position_ >= text_.size()) {
+                position_ = start;
+                return fail("Unterminated quoted identifier");
+            }
+            ++position_;
+            auto parsed = JsonParser::parse(text_.substr(start, position_ - start));
+            if (!parsed) {
+                position_ = start;
+                return fail("Invalid quoted identifier");
+            }
+            name = parsed.value()->string_value();
+            return true;
+        }
+        auto word = [](char c, bool first) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+                   (!first && c >= '0' && c <= '9');
+        };
+        while (position_ < text_.size() && word(text_[position_], position_ == start)) {
+            ++position_;
+        }
+        if (position_ == start) {
+            return fail("Expected an identifier");
+        }
+        name.assign(text_.data() + start, position_ - start);
+        return true;
+    }
+
+    bool integer(std::int64_t& value) {
+        skip_space();
+        std::size_t start = position_;
+        bool negative = position_ < text_.size() && text_[position_] == '-';
+        if (negative) {
+            ++position_;
+        }
+        std::uint64_t magnitude = 0;
+        std::size_t digits = position_;
+        while (position_ < text_.size() && text_[position_] >= '0' && text_[position_] <= '9') {
+            magnitude = magnitude * 10 + static_cast<std::uint64_t>(text_[position_] - '0');
+            if (magnitude > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+                position_ = start;
+                return fail("Number out of range");
+            }
+            ++position_;
+        }
+        if (position_ == digits) {
+            position_ = start;
+            return fail("Expected a number");
+        }
+        value = negative ? -static_cast<std::int64_t>(magnitude) : static_cast<std::int64_t>(magnitude);
+        return true;
+    }
+
+    bool bracket(Pipeline& pipeline) {
+        accept('[');
+        if (accept(']')) {
+            // Flatten ends the projection before it, as a pipe does
+            if (!pipeline.back().empty()) {
+                pipeline.emplace_back();
+            }
+            pipeline.back().push_back(Step{StepKind::Flatten});
+            return true;
+        }
+
+        Step step{StepKind::Elements};
+        if (accept('*')) {
+            // Elements
+        } else if (accept('?')) {
+            step.kind = StepKind::Filter;
+            if (!disjunction(step.condition)) {
+                return false;
+            }
+        } else {
+            char c = peek();
+            bool has_start = c != ':';
+            if (has_start && !integer(step.index)) {
+                return false;
+            }
+            if (accept(':')) {
+                step.kind = StepKind::Slice;
+                step.has_start = has_start;
+                c = peek();
+                if (c != ':' && c != ']') {
+                    step.has_stop = true;
+                    if (!integer(step.stop)) {
+                        return false;
+                    }
+                }
+                if (accept(':') && peek() != ']') {
+                    std::size_t start = position_;
+                    if (!integer(step.stride)) {
+                        return false;
+                    }
+                    if (step.stride == 0) {
+                        position_ = start;
+                        return fail("Slice step cannot be 0");
+                    }
+                }
+            } else {
+                step.kind = StepKind::Index;
+            }
+        }
+        if (!accept(']')) {
+            return fail("Expected ']'");
+        }
+        pipeline.back().push_back(std::move(step));
+        return true;
+    }
+
+    std::uint32_t add(Term term) {
+        query_.terms_.push_back(term);
+        return static_cast<std::uint32_t>(query_.terms_.size() - 1);
+    }
+
+    bool disjunction(std::uint32_t& term) {
+        if (!conjunction(term)) {
+            return false;
+        }
+        while (accept("||")) {
+            Term combined{TermKind::Or};
+            combined.left = term;
+            if (!conjunction(combined.right)) {
+                return false;
+            }
+            term = add(combined);
+        }
+        return true;
+    }
+
+    bool conjunction(std::uint32_t& term) {
+        if (!negation(term)) {
+            return false;
+        }
+        while (accept("&&")) {
+            Term combined{TermKind::And};
+            combined.left = term;
+            if (!negation(combined.right)) {
+                return false;
+            }
+            term = add(combined);
+        }
+        return true;
+    }
+
+    bool negation(std::uint32_t& term) {
+        if (accept('!')) {
+            Term negated{TermKind::Not};
+            if (!negation(negated.left)) {
+                return false;
+            }
+            term = add(negated);
+            return true;
+        }
+        if (accept('(')) {
+            if (!disjunction(term)) {
+                return false;
+            }
+            return accept(')') || fail("Expected ')'");
+        }
+        return comparison(term);
+    }
+
+    bool comparison(std::uint32_t& term) {
+        Term test{TermKind::Truthy};
+        if (!operand(test.left)) {
+            return false;
+        }
+        static constexpr std::pair<std::string_view, Comparator> comparators[] = {
+            {"==", Comparator::Equal},     {"!=", Comparator::NotEqual},
+            {"<=", Comparator::LessEqual}, {">=", Comparator::GreaterEqual},
+            {"<", Comparator::Less},       {">", Comparator::Greater},
+        };
+        for (const auto& [token, comparator] : comparators) {
+            if (accept(token)) {
+                test.kind = TermKind::Compare;
+                test.comparator = comparator;
+                if (!operand(test.right)) {
+                    return false;
+                }
+                break;
+            }
+        }
+        term = add(test);
+        return true;
+    }
+
+    bool operand(std::uint32_t& index) {
+        Operand result;
+        char c = peek();
+        if (c == '`' || c == '\'') {
+            std::size_t start = position_;
+            std::string text;
+            for (++position_; position_ < text_.size() && text_[position_] != c; ++position_) {
+                if (text_[position_] == '\\' && position_ + 1 < text_.size() && text_[position_ + 1] == c) {
+                    ++position_;
+                }
+                text += text_[position_];
+            }
+            if (position_ >= text_.size()) {
+                position_ = start;
+                return fail("Unterminated literal");
+            }
+            ++position_;
+            if (c == '\'') {
+                result.literal = JsonStringValue::create(std::move(text));
+            } else {
+                auto parsed = JsonParser::parse(text);
+                if (!parsed) {
+                    position_ = start;
+                    return fail("Invalid JSON literal");
+                }
+                result.literal = std::move(parsed.value());
+            }
+        } else {
+            Pipeline pipeline;
+            if (!path(pipeline)) {
+                return false;
+            }
+            result.pipeline = static_cast<std::uint32_t>(query_.pipelines_.size());
+            query_.pipelines_.push_back(std::move(pipeline));
+        }
+        query_.operands_.push_back(std::move(result));
+        index = static_cast<std::uint32_t>(query_.operands_.size() - 1);
+        return true;
+    }
+
+    JsonQuery& query_;
+    std::string_view text_;
+    std::size_t position_ = 0;
+    std::string message_;
+};
+
+// Runs the first segment of a query over parser events. Frames follow the
+// containers the query navigates; a value the query needs in full (a
+// filtered element, or one reached at a step that depends on its size)
+// is built from its events and the rest of the segment is run on it.
+// Everything else is skipped as the events go by.
+class JsonQuery::Matcher : public JsonHandler {
+public:
+    Matcher(const JsonQuery& query, const Segment& segment, std::size_t step) noexcept
+        : query_(query), segment_(segment), first_(step) {}
+
+    JsonRef<JsonValue> take_result() noexcept { return std::move(result_); }
+
+    bool on_null() override { return scalar([] { return JsonNull::create(); }); }
+    bool on_boolean(bool value) override { return scalar([value] { return JsonBoolean::create(value); }); }
+    bool on_integer(std::int64_t value) override { return scalar([value] { return JsonNumber::create(value); }); }
+    bool on_real(double value) override { return scalar([value] { return JsonNumber::create(value); }); }
+    bool on_string(std::string_view value) override {
+        return scalar([value] { return JsonStringValue::create(std::string(value)); });
+    }
+
+    bool on_start_object() override { return start(true); }
+    bool on_start_array() override { return start(false); }
+    bool on_end_object(std::size_t) override { return end(); }
+    bool on_end_array(std::size_t) override { return end(); }
+
+    bool on_key(std::string_view key) override {
+        if (!levels_.empty()) {
+            key_ = JsonKey(key);
+        } else if (skip_depth_ == 0) {
+            Frame& frame = frames_.back();
+            if (frame.kind == FrameKind::Member) {
+                frame.selected = key == segment_[frame.step].name;
+            }
+        }
+        return true;
+    }
+
+private:
+    // Member and Index keep the value their selected child produced;
+    // Project and Filter collect their children's non-null values
+    enum class FrameKind : std::uint8_t { Member, Index, Project, Filter };
+
+    struct Frame {
+        FrameKind kind;
+        std::size_t step;
+        std::int64_t position = 0;
+        bool selected = false;
+        JsonRef<JsonValue> slot{};
+        JsonRef<JsonArray> results{};
+    };
+
+    // A container being built, and the key it goes under in its parent
+    struct Level {
+        JsonBuilder::Mark mark;
+        bool object;
+        JsonKey key;
+    };
+
+    enum class Action : std::uint8_t { Skip, Navigate, Capture };
+
+    struct Next {
+        Action action;
+        std::size_t step;
+    };
+
+    // What the value starting now is to the query
+    Next next() noexcept {
+        if (frames_.empty()) {
+            return Next{Action::Navigate, first_};
+        }
+        Frame& frame = frames_.back();
+        switch (frame.kind) {
+            case FrameKind::Member:
+                return Next{frame.selected ? Action::Navigate : Action::Skip, frame.step + 1};
+            case FrameKind::Index:
+                return Next{frame.position++ == segment_[frame.step].index ? Action::Navigate : Action::Skip,
+                            frame.step + 1};
+            case FrameKind::Project:
+                return Next{Action::Navigate, frame.step + 1};
+            default:
+                return Next{Action::Capture, frame.step + 1};
+        }
+    }
+
+    template <typename Make>
+    bool scalar(Make make) {
+        if (!levels_.empty()) {
+            add(std::move(key_), make());
+            return true;
+        }
+        if (skip_depth_ > 0) {
+            return true;
+        }
+        Next next_value = next();
+        if (next_value.action == Action::Capture) {
+            finish(make(), next_value.step);
+        } else if (next_value.action == Action::Navigate) {
+            // Every step yields null on a scalar
+            deliver(next_value.step == segment_.size() ? JsonRef<JsonValue>(make()) : JsonRef<JsonValue>());
+        }
+        return true;
+    }
+
+    bool start(bool object) {
+        if (!levels_.empty()) {
+            levels_.push_back(Level{builder_.mark(), object, std::move(key_)});
+            return true;
+        }
+        if (skip_depth_ > 0) {
+            ++skip_depth_;
+            return true;
+        }
+
+        Next next_value = next();
+        if (next_value.action == Action::Skip) {
+            skip_depth_ = 1;
+            return true;
+        }
+        if (next_value.action == Action::Capture || next_value.step == segment_.size()) {
+            capture(next_value.step, object);
+            return true;
+        }
+
+        const Step& step = segment_[next_value.step];
+        FrameKind kind;
+        bool fits;
+        switch (step.kind) {
+            case StepKind::Member:
+                kind = FrameKind::Member;
+                fits = object;
+                break;
+            case StepKind::Index:
+                if (step.index < 0) {
+                    capture(next_value.step, object);
+                    return true;
+                }
+                kind = FrameKind::Index;
+                fits = !object;
+                break;
+            case StepKind::Elements:
+                kind = FrameKind::Project;
+                fits = !object;
+                break;
+            case StepKind::Values:
+                kind = FrameKind::Project;
+                fits = object;
+                break;
+            case StepKind::Filter:
+                kind = FrameKind::Filter;
+                fits = !object;
+                break;
+            default:
+                capture(next_value.step, object);
+                return true;
+        }
+
+        if (!fits) {
+            deliver(JsonRef<JsonValue>());
+            skip_depth_ = 1;
+            return true;
+        }
+        Frame frame{kind, next_value.step};
+        if (kind == FrameKind::Project || kind == FrameKind::Filter) {
+            frame.results = JsonArray::create();
+        }
+        frames_.push_back(std::move(frame));
+        return true;
+    }
+
+    bool end() {
+        if (!levels_.empty()) {
+            Level level = std::move(levels_.back());
+            levels_.pop_back();
+            JsonRef<JsonValue> node;
+            if (level.object) {
+                node = builder_.finish_object(level.mark);
+            } else {
+                node = builder_.finish_array(level.mark);
+            }
+            if (levels_.empty()) {
+                finish(std::move(node), capture_step_);
+            } else {
+                add(std::move(level.key), std::move(node));
+            }
+            return true;
+        }
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+
+        Frame frame = std::move(frames_.back());
+        frames_.pop_back();
+        if (frame.kind == FrameKind::Member || frame.kind == FrameKind::Index) {
+            deliver(std::move(frame.slot));
+        } else {
+            deliver(std::move(frame.results));
+        }
+        return true;
+    }
+
+    void capture(std::size_t step, bool object) {
+        capture_step_ = step;
+        levels_.push_back(Level{builder_.mark(), object, JsonKey()});
+    }
+
+    void add(JsonKey key, JsonRef<JsonValue> value) {
+        if (levels_.back().object) {
+            builder_.add(std::move(key), std::move(value));
+        } else {
+            builder_.add(std::move(value));
+        }
+    }
+
+    // A complete value; the steps from step on run on it as on a tree
+    void finish(JsonRef<JsonValue> value, std::size_t step) {
+        if (!frames_.empty() && frames_.back().kind == FrameKind::Filter) {
+            if (!query_.test(segment_[step - 1].condition, *value)) {
+                return;
+            }
+        }
+        deliver(query_.run(segment_, step, value.get()));
+    }
+
+    void deliver(JsonRef<JsonValue> value) {
+        if (frames_.empty()) {
+            result_ = std::move(value);
+            return;
+        }
+        Frame& frame = frames_.back();
+        if (frame.kind == FrameKind::Member || frame.kind == FrameKind::Index) {
+            frame.slot = std::move(value);
+        } else if (!is_null(value.get())) {
+            frame.results->push_back(std::move(value));
+        }
+    }
+
+    const JsonQuery& query_;
+    const Segment& segment_;
+    std::size_t first_;
+    std::vector<Frame> frames_;
+    std::size_t skip_depth_ = 0;
+
+    JsonBuilder builder_;
+    std::vector<Level> levels_;
+    JsonKey key_;
+    std::size_t capture_step_ = 0;
+
+    JsonRef<JsonValue> result_;
+};
+
+JsonQuery::JsonQuery() : expression_("@"), pipelines_(1, Pipeline(1)) {}
+
+Result<JsonQuery> JsonQuery::compile(std::string_view expression, JsonQueryError* error) {
+    JsonQuery query;
+    query.pipelines_.clear();
+    query.expression_.assign(expression.data(), expression.size());
+    Compiler compiler(query, expression);
+    if (!compiler.compile()) {
+        if (error) {
+            error->position = compiler.position();
+            error->message = compiler.message().empty() ? "Expected an expression" : compiler.message();
+        }
+        return Result<JsonQuery>(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    return Result<JsonQuery>(std::move(query));
+}
+
+JsonRef<JsonValue> JsonQuery::evaluate(const JsonValue& root) const {
+    return normalize(run(pipelines_[0], 0, share(&root)));
+}
+
+Result<JsonRef<JsonValue>> JsonQuery::evaluate_text(std::string_view input) const {
+    return stream(input, 0);
+}
+
+Result<JsonRef<JsonValue>> JsonQuery::evaluate(const JsonLazyValue& root) const {
+    const Segment& segment = pipelines_[0][0];
+    JsonLazyValue value = root;
+    std::size_t step = 0;
+    for (; step < segment.size(); ++step) {
+        const Step& current = segment[step];
+        Result<JsonLazyValue> next(make_error_code(JsonErrorCode::KeyNotFound));
+        if (current.kind == StepKind::Member) {
+            if (value.is_object()) {
+                next = value.get(current.name);
+            }
+        } else if (current.kind == StepKind::Index) {
+            if (value.is_array()) {
+                std::int64_t index = current.index;
+                if (index < 0) {
+                    auto size = value.size();
+                    if (!size) {
+                        return Result<JsonRef<JsonValue>>(size.error());
+                    }
+                    index += static_cast<std::int64_t>(size.value());
+                }
+                if (index >= 0) {
+                    next = value.at(static_cast<std::size_t>(index));
+                }
+            }
+        } else {
+            break;
+        }
+
+        if (!next) {
+            std::error_code code = next.error();
+            if (code == make_error_code(JsonErrorCode::KeyNotFound) ||
+                code == make_error_code(JsonErrorCode::IndexOutOfBounds)) {
+                return Result<JsonRef<JsonValue>>(JsonRef<JsonValue>());
+            }
+            return Result<JsonRef<JsonValue>>(code);
+        }
+        value = next.value();
+    }
+
+    if (step < segment.size()) {
+        return stream(value.raw(), step);
+    }
+    auto node = value.materialize();
+    if (!node) {
+        return node;
+    }
+    return Result<JsonRef<JsonValue>>(normalize(run(pipelines_[0], 1, node.value())));
+}
+
+Result<JsonRef<JsonValue>> JsonQuery::stream(std::string_view input, std::size_t step) const {
+    Matcher matcher(*this, pipelines_[0][0], step);
+    auto parsed = JsonParser::parse(input, matcher);
+    if (!parsed) {
+        return Result<JsonRef<JsonValue>>(parsed.error());
+    }
+    return Result<JsonRef<JsonValue>>(normalize(run(pipelines_[0], 1, matcher.take_result())));
+}
+
+JsonRef<JsonValue> JsonQuery::run(const Pipeline& pipeline, std::size_t segment,
+                                  JsonRef<JsonValue> value) const {
+    for (; segment < pipeline.size() && value; ++segment) {
+        value = run(pipeline[segment], 0, value.get());
+    }
+    return value;
+}
+
+JsonRef<JsonValue> JsonQuery::run(const Segment& segment, std::size_t step, const JsonValue* value) const {
+    // Projections run the rest of the segment on each element
+    auto project = [&](const JsonRef<JsonArray>& results, const JsonValue* element) {
+        JsonRef<JsonValue> result = run(segment, step + 1, element);
+        if (!is_null(result.get())) {
+            results->push_back(std::move(result));
+        }
+    };
+
+    for (; step < segment.size(); ++step) {
+        const Step& current = segment[step];
+        if (current.kind == StepKind::Member) {
+            if (!value->is_object()) {
+                return JsonRef<JsonValue>();
+            }
+            const auto& members = static_cast<const JsonObject*>(value)->values();
+            auto found = members.find(current.name);
+            if (found == members.end()) {
+                return JsonRef<JsonValue>();
+            }
+            value = found->second.get();
+            continue;
+        }
+        if (current.kind == StepKind::Values) {
+            if (!value->is_object()) {
+                return JsonRef<JsonValue>();
+            }
+            auto results = JsonArray::create();
+            for (const auto& [key, member] : static_cast<const JsonObject&>(*value)) {
+                project(results, member.get());
+            }
+            return results;
+        }
+
+        if (!value->is_array()) {
+            return JsonRef<JsonValue>();
+        }
+        const auto& elements = static_cast<const JsonArray*>(value)->values();
+        std::int64_t size = static_cast<std::int64_t>(elements.size());
+        if (current.kind == StepKind::Index) {
+            std::int64_t index = current.index < 0 ? current.index + size : current.index;
+            if (index < 0 || index >= size) {
+                return JsonRef<JsonValue>();
+            }
+            value = elements[static_cast<std::size_t>(index)].get();
+            continue;
+        }
+
+        auto results = JsonArray::create();
+        switch (current.kind) {
+            case StepKind::Elements:
+                for (const auto& element : elements) {
+                    project(results, element.get());
+                }
+                break;
+            case StepKind::Filter:
+                for (const auto& element : elements) {
+                    if (test(current.condition, *element)) {
+                        project(results, element.get());
+                    }
+                }
+                break;
+            case StepKind::Flatten:
+                for (const auto& element : elements) {
+                    if (element->is_array()) {
+                        for (const auto& inner : static_cast<const JsonArray&>(*element)) {
+                            project(results, inner.get());
+                        }
+                    } else {
+                        project(results, element.get());
+                    }
+                }
+                break;
+            default: {
+                // Slice bounds clamp as in Python; the stride is never 0
+                std::int64_t stride = current.stride;
+                auto clamp = [&](std::int64_t bound, std::int64_t low, std::int64_t high) {
+                    if (bound < 0) {
+                        bound += size;
+                    }
+                    return bound < low ? low : bound > high ? high : bound;
+                };
+                if (stride > 0) {
+                    std::int64_t start = current.has_start ? clamp(current.index, 0, size) : 0;
+                    std::int64_t stop = current.has_stop ? clamp(current.stop, 0, size) : size;
+                    for (std::int64_t i = start; i < stop; i += stride) {
+                        project(results, elements[static_cast<std::size_t>(i)].get());
+                        if (stop - i <= stride) {
+                            break;
+                        }
+                    }
+                } else {
+                    std::int64_t start = current.has_start ? clamp(current.index, -1, size - 1) : size - 1;
+                    std::int64_t stop = current.has_stop ? clamp(current.stop, -1, size - 1) : -1;
+                    for (std::int64_t i = start; i > stop; i += stride) {
+                        project(results, elements[static_cast<std::size_t>(i)].get());
+                        if (i - stop <= -stride) {
+                            break;
+                        }
+                    }
+                }
+                break;
+            }
+        }
+        return results;
+    }
+    return share(value);
+}
+
+bool JsonQuery::test(std::uint32_t index, const JsonValue& element) const {
+    const Term& term = terms_[index];
+    switch (term.kind) {
+        case TermKind::Or:
+            return test(term.left, element) || test(term.right, element);
+        case TermKind::And:
+            return test(term.left, element) && test(term.right, element);
+        case TermKind::Not:
+            return !test(term.left, element);
+        case TermKind::Truthy:
+            return truthy(operand(term.left, element).get());
+        default:
+            break;
+    }
+
+    JsonRef<JsonValue> left = operand(term.left, element);
+    JsonRef<JsonValue> right = operand(term.right, element);
+    bool equal;
+    if (is_null(left.get()) || is_null(right.get())) {
+        equal = is_null(left.get()) && is_null(right.get());
+    } else {
+        equal = left->equals(*right);
+    }
+    if (term.comparator == Comparator::Equal) {
+        return equal;
+    }
+    if (term.comparator == Comparator::NotEqual) {
+        return !equal;
+    }
+
+    // Ordering is only defined between numbers
+    if (!left || !right || !left->is_number() || !right->is_number()) {
+        return false;
+    }
+    int order;
+    if (left->is_integer() && right->is_integer()) {
+        std::int64_t lhs = left->integer_value();
+        std::int64_t rhs = right->integer_value();
+        order = lhs < rhs ? -1 : lhs > rhs ? 1 : 0;
+    } else {
+        double lhs = left->number_value();
+        double rhs = right->number_value();
+        if (lhs != lhs || rhs != rhs) {
+            return false;
+        }
+        order = lhs < rhs ? -1 : lhs > rhs ? 1 : 0;
+    }
+    switch (term.comparator) {
+        case Comparator::Less:
+            return order < 0;
+        case Comparator::LessEqual:
+            return order <= 0;
+        case Comparator::Greater:
+            return order > 0;
+        default:
+            return order >= 0;
+    }
+}
+
+JsonRef<JsonValue> JsonQuery::operand(std::uint32_t index, const JsonValue& element) const {
+    const Operand& source = operands_[index];
+    if (source.pipeline == none) {
+        return source.literal;
+    }
+    return run(pipelines_[source.pipeline], 0, share(&element));
+}
+
+} // namespace jansson
@@ -0,0 +1,137 @@
+#ifndef JSON_QUERY_HPP
+#define JSON_QUERY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_value.hpp"
+#include "json_lazy.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+// Why JsonQuery::compile failed: the offset in the expression and a
+// description
+struct JsonQueryError {
+    std::size_t position = 0;
+    std::string message;
+};
+
+// A JMESPath expression, compiled once into a list of steps and evaluated
+// any number of times.
+//
+// The supported subset covers paths and projections:
+//
+//   a.b  "quoted key"  @          members and the current value
+//   [2]  [-1]  [1:5:2]            elements and slices
+//   [*]  *                        array and object projections
+//   []                            flatten
+//   [?cond]                       filter projection
+//   a | b                         pipe
+//
+// A filter condition combines ==, !=, <, <=, > and >= comparisons and
+// truthiness tests with &&, || and !, over paths relative to the element
+// and `json` or 'raw string' literals. Semantics are those of JMESPath: a
+// projection applies the rest of the expression to each element and
+// drops null results, flatten and pipes end a projection, and any type
+// mismatch yields null. Multi-select lists and hashes and functions are
+// not supported.
+//
+// A query is immutable and may be shared between threads.
+class JsonQuery {
+public:
+    // The query "@", which yields its input
+    JsonQuery();
+
+    // Fails with InvalidArgument for an expression outside the grammar
+    static Result<JsonQuery> compile(std::string_view expression, JsonQueryError* error = nullptr);
+
+    const std::string& expression() const noexcept { return expression_; }
+
+    // Result of the query, or null where JMESPath gives null. Values found
+    // in root are shared with it; projections build new arrays of them.
+    JsonRef<JsonValue> evaluate(const JsonValue& root) const;
+
+    // Evaluate over JSON text in one event-driven pass, without building
+    // the document. Only values the query reaches are built: a whole
+    // element at a time for filters, and the whole value at a negative
+    // index, slice, flatten or pipe, where the rest runs as for a tree.
+    // Fails with the parser's error for malformed input.
+    Result<JsonRef<JsonValue>> evaluate_text(std::string_view input) const;
+
+    // Evaluate over a lazy document: members and elements on the path are
+    // looked up in its structural index, and from the first projection the
+    // text of the value reached is evaluated as by evaluate_text()
+    Result<JsonRef<JsonValue>> evaluate(const JsonLazyValue& root) const;
+
+private:
+    class Compiler;
+    class Matcher;
+
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+    enum class StepKind : std::uint8_t {
+        Member,     // name
+        Index,      // index
+        Slice,      // index (the start), stop, stride; has_start, has_stop
+        Elements,   // [*]
+        Values,     // *
+        Flatten,    // []
+        Filter      // condition
+    };
+
+    struct Step {
+        StepKind kind;
+        bool has_start = false;
+        bool has_stop = false;
+        std::uint32_t condition = none;
+        std::int64_t index = 0;
+        std::int64_t stop = 0;
+        std::int64_t stride = 1;
+        std::string name{};
+    };
+
+    // Steps between pipes (or before a flatten, which also ends any
+    // projection); each segment runs on the result of the one before
+    using Segment = std::vector<Step>;
+    using Pipeline = std::vector<Segment>;
+
+    enum class TermKind : std::uint8_t { Or, And, Not, Truthy, Compare };
+    enum class Comparator : std::uint8_t { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+    // Node of a filter condition. Or, And and Not combine the terms left
+    // and right; Truthy and Compare test the operands left and right.
+    struct Term {
+        TermKind kind;
+        Comparator comparator = Comparator::Equal;
+        std::uint32_t left = none;
+        std::uint32_t right = none;
+    };
+
+    // A literal, or a pipeline (in pipelines_) run on the element
+    struct Operand {
+        JsonRef<JsonValue> literal;
+        std::uint32_t pipeline = none;
+    };
+
+    JsonRef<JsonValue> run(const Pipeline& pipeline, std::size_t segment, JsonRef<JsonValue> value) const;
+    JsonRef<JsonValue> run(const Segment& segment, std::size_t step, const JsonValue* value) const;
+    bool test(std::uint32_t term, const JsonValue& element) const;
+    JsonRef<JsonValue> operand(std::uint32_t index, const JsonValue& element) const;
+
+    // evaluate_text() from a step of the first segment
+    Result<JsonRef<JsonValue>> stream(std::string_view input, std::size_t step) const;
+
+    std::string expression_;
+
+    // The query is pipelines_[0]; the rest are filter operands
+    std::vector<Pipeline> pipelines_;
+    std::vector<Term> terms_;
+    std::vector<Operand> operands_;
+};
+
+} // namespace jansson
+
+#endif // JSON_QUERY_HPP
@@ -0,0 +1,223 @@
+#ifndef JSON_REF_HPP
+#define JSON_REF_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Reference counts are atomic unless the library is built with
+// JANSSON_ATOMIC_REFCOUNT=0 (the CMake option of the same name). Non-atomic
+// counts are cheaper but only safe when every tree is confined to one thread
+// at a time; handing a whole tree to another thread (as the parallel parser
+// does) is still fine.
+#ifndef JANSSON_ATOMIC_REFCOUNT
+#define JANSSON_ATOMIC_REFCOUNT 1
+#endif
+
+namespace jansson {
+
+// Counter embedded in reference-counted objects
+class JsonRefCount {
+public:
+    constexpr JsonRefCount() noexcept = default;
+    
+    // Copies of the owning object start without references
+    JsonRefCount(const JsonRefCount&) noexcept {}
+    JsonRefCount& operator=(const JsonRefCount&) noexcept { return *this; }
+    
+    void increment() noexcept {
+#if JANSSON_ATOMIC_REFCOUNT
+        count_.fetch_add(1, std::memory_order_relaxed);
+#else
+        ++count_;
+#endif
+    }
+    
+    // Returns true when the last reference was dropped
+    bool decrement() noexcept {
+#if JANSSON_ATOMIC_REFCOUNT
+        return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+#else
+        return --count_ == 0;
+#endif
+    }
+    
+    std::uint32_t load() const noexcept {
+#if JANSSON_ATOMIC_REFCOUNT
+        return count_.load(std::memory_order_relaxed);
+#else
+        return count_;
+#endif
+    }
+    
+    // Set the count of an object no one else can see yet
+    void initialize(std::uint32_t count) noexcept {
+#if JANSSON_ATOMIC_REFCOUNT
+        count_.store(count, std::memory_order_relaxed);
+#else
+        count_ = count;
+#endif
+    }
+
+private:
+#if JANSSON_ATOMIC_REFCOUNT
+    std::atomic<std::uint32_t> count_{0};
+#else
+    std::uint32_t count_ = 0;
+#endif
+};
+
+// Owning reference to an intrusively counted object.
+//
+// The count lives in the object itself (T provides retain() and release()),
+// so a reference can be rebuilt from a plain pointer at any time and a
+// reference is a single pointer. This is what lets the C API hand out
+// json_t pointers that are the nodes themselves.
+template <typename T>
+class JsonRef {
+public:
+    using element_type = T;
+
+    // Tag selecting the constructor that takes over an existing count
+    struct Adopt {};
+    static constexpr Adopt adopt{};
+
+    constexpr JsonRef() noexcept = default;
+    constexpr JsonRef(std::nullptr_t) noexcept {}
+
+    // Add a reference to object
+    explicit JsonRef(T* object) noexcept : ptr_(object) {
+        if (ptr_) {
+            ptr_->retain();
+        }
+    }
+
+    // Take over a reference the caller already holds
+    JsonRef(T* object, Adopt) noexcept : ptr_(object) {}
+
+    JsonRef(const JsonRef& other) noexcept : JsonRef(other.ptr_) {}
+    JsonRef(JsonRef&& other) noexcept : ptr_(other.ptr_) {
+        other.ptr_ = nullptr;
+    }
+
+    template <typename U, std::enable_if_t<std::is_convertible_v<U*, T*>, int> = 0>
+    JsonRef(const JsonRef<U>& other) noexcept : JsonRef(other.get()) {}
+
+    template <typename U, std::enable_if_t<std::is_convertible_v<U*, T*>, int> = 0>
+    JsonRef(JsonRef<U>&& other) noexcept : ptr_(other.detach()) {}
+
+    ~JsonRef() {
+        if (ptr_) {
+            ptr_->release();
+        }
+    }
+
+    JsonRef& operator=(const JsonRef& other) noexcept {
+        JsonRef(other).swap(*this);
+        return *this;
+    }
+    JsonRef& operator=(JsonRef&& other) noexcept {
+        JsonRef(std::move(other)).swap(*this);
+        return *this;
+    }
+    template <typename U, std::enable_if_t<std::is_convertible_v<U*, T*>, int> = 0>
+    JsonRef& operator=(JsonRef<U>&& other) noexcept {
+        JsonRef(std::move(other)).swap(*this);
+        return *this;
+    }
+    JsonRef& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    T* get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    void reset() noexcept {
+        JsonRef().swap(*this);
+    }
+    void reset(T* object) noexcept {
+        JsonRef(object).swap(*this);
+    }
+
+    void swap(JsonRef& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+    }
+
+    // Give up the reference without releasing it
+    T* detach() noexcept {
+        T* object = ptr_;
+        ptr_ = nullptr;
+        return object;
+    }
+
+    long use_count() const noexcept {
+        return ptr_ ? static_cast<long>(ptr_->reference_count()) : 0;
+    }
+
+    // Interoperate with code holding std::shared_ptr: the shared pointer
+    // keeps one reference for as long as it (or a copy) lives
+    template <typename U, std::enable_if_t<std::is_convertible_v<T*, U*>, int> = 0>
+    operator std::shared_ptr<U>() const {
+        if (!ptr_) {
+            return nullptr;
+        }
+        ptr_->retain();
+        return std::shared_ptr<U>(ptr_, [object = ptr_](U*) {
+            object->release();
+        });
+    }
+
+private:
+    T* ptr_ = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const JsonRef<T>& lhs, const JsonRef<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template <typename T, typename U>
+bool operator!=(const JsonRef<T>& lhs, const JsonRef<U>& rhs) noexcept {
+    return lhs.get() != rhs.get();
+}
+
+template <typename T>
+bool operator==(const JsonRef<T>& lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+
+template <typename T>
+bool operator==(std::nullptr_t, const JsonRef<T>& rhs) noexcept {
+    return !rhs;
+}
+
+template <typename T>
+bool operator!=(const JsonRef<T>& lhs, std::nullptr_t) noexcept {
+    return static_cast<bool>(lhs);
+}
+
+template <typename T>
+bool operator!=(std::nullptr_t, const JsonRef<T>& rhs) noexcept {
+    return static_cast<bool>(rhs);
+}
+
+// Casts between references to related types, sharing the count
+template <typename T, typename U>
+JsonRef<T> static_pointer_cast(const JsonRef<U>& ref) noexcept {
+    return JsonRef<T>(static_cast<T*>(ref.get()));
+}
+
+template <typename T, typename U>
+JsonRef<T> static_pointer_cast(JsonRef<U>&& ref) noexcept {
+    return JsonRef<T>(static_cast<T*>(ref.detach()), JsonRef<T>::adopt);
+}
+
+} // namespace jansson
+
+#endif // JSON_REF_HPP
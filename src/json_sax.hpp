@@ -0,0 +1,37 @@
+#ifndef JSON_SAX_HPP
+#define JSON_SAX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace jansson {
+
+// Receiver for event-driven parsing (JsonParser::parse with a handler).
+//
+// Events arrive in document order; no tree is built, so memory use does
+// not depend on the size of the document. String views passed to a handler
+// are only valid for the duration of the call. Every callback returns
+// true to continue or false to stop parsing. The defaults accept and
+// ignore the event.
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+    
+    virtual bool on_null() { return true; }
+    virtual bool on_boolean(bool) { return true; }
+    virtual bool on_integer(std::int64_t) { return true; }
+    virtual bool on_real(double) { return true; }
+    virtual bool on_string(std::string_view) { return true; }
+    
+    virtual bool on_start_object() { return true; }
+    virtual bool on_key(std::string_view) { return true; }
+    virtual bool on_end_object(std::size_t) { return true; }
+    
+    virtual bool on_start_array() { return true; }
+    virtual bool on_end_array(std::size_t) { return true; }
+};
+
+} // namespace jansson
+
+#endif // JSON_SAX_HPP
@@ -0,0 +1,1022 @@
+#include "json_schema.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+#include "json_builder.hpp"
+#include "json_parser.hpp"
+#include "json_pointer.hpp"
+#include "json_sax.hpp"
+
+namespace jansson {
+
+// Reference token for a member name in a JSON Pointer
+static void append_token(std::string& path, std::string_view name) {
+    path += '/';
+    for (char c : name) {
+        if (c == '~') {
+            path += "~0";
+        } else if (c == '/') {
+            path += "~1";
+        } else {
+            path += c;
+        }
+    }
+}
+
+static std::string child_path(const std::string& path, std::string_view name) {
+    std::string result = path;
+    append_token(result, name);
+    return result;
+}
+
+// Code points in UTF-8 text, which the parser has already validated
+static std::size_t code_points(std::string_view text) noexcept {
+    std::size_t count = 0;
+    for (char c : text) {
+        count += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+    return count;
+}
+
+// Whether value is a multiple of divisor, allowing for rounding in the
+// division when either is not an integer
+static bool multiple_of(double value, double divisor) noexcept {
+    if (value == std::floor(value) && divisor == std::floor(divisor) &&
+        std::fabs(value) < 9007199254740992.0 && divisor < 9007199254740992.0) {
+        return std::fmod(value, divisor) == 0;
+    }
+    double quotient = value / divisor;
+    if (!std::isfinite(quotient)) {
+        return false;
+    }
+    return std::fabs(quotient - std::round(quotient)) <= 1e-9 * std::max(1.0, std::fabs(quotient));
+}
+
+// Replay a tree as parser events
+static bool emit(const JsonValue& value, JsonHandler& handler) {
+    switch (value.type()) {
+        case JsonType::Null:
+            return handler.on_null();
+        case JsonType::Boolean:
+            return handler.on_boolean(static_cast<const JsonBoolean&>(value).value());
+        case JsonType::Number: {
+            const auto& number = static_cast<const JsonNumber&>(value);
+            return number.is_integer() ? handler.on_integer(number.integer()) : handler.on_real(number.real());
+        }
+        case JsonType::String:
+            return handler.on_string(static_cast<const JsonStringValue&>(value).view());
+        case JsonType::Array: {
+            const auto& array = static_cast<const JsonArray&>(value);
+            if (!handler.on_start_array()) {
+                return false;
+            }
+            for (const auto& element : array) {
+                if (!emit(*element, handler)) {
+                    return false;
+                }
+            }
+            return handler.on_end_array(array.size());
+        }
+        default: {
+            const auto& object = static_cast<const JsonObject&>(value);
+            if (!handler.on_start_object()) {
+                return false;
+            }
+            for (const auto& [key, member] : object) {
+                if (!handler.on_key(key.view()) || !emit(*member, handler)) {
+                    return false;
+                }
+            }
+            return handler.on_end_object(object.size());
+        }
+    }
+}
+
+// Builds nodes_ from the schema document. Each subschema is compiled once,
+// however many times it is referenced; $ref targets are resolved after the
+// root, so references may point anywhere in the document, cycles included.
+class JsonSchema::Compiler {
+public:
+    Compiler(JsonSchema& schema, const JsonValue& root) noexcept : schema_(schema), root_(root) {}
+
+    bool compile() {
+        node(root_, "");
+        for (std::size_t i = 0; i < refs_.size() && !failed_; ++i) {
+            Ref ref = refs_[i];
+            if (ref.target.empty() || ref.target[0] != '#') {
+                fail(ref.path, "Only references within the schema are supported");
+                break;
+            }
+            auto pointer = JsonPointer::parse(std::string_view(ref.target).substr(1));
+            const JsonValue* target = pointer ? pointer.value().find(root_) : nullptr;
+            if (!target) {
+                fail(ref.path, "Unresolved $ref");
+                break;
+            }
+            std::uint32_t resolved = node(*target, pointer.value().to_string());
+            schema_.nodes_[ref.node].ref = resolved;
+        }
+        return !failed_;
+    }
+
+    const JsonSchemaError& error() const noexcept { return error_; }
+
+private:
+    struct Ref {
+        std::uint32_t node;
+        std::string target;
+        std::string path;
+    };
+
+    void fail(const std::string& path, const std::string& message) {
+        if (!failed_) {
+            failed_ = true;
+            error_.path = path;
+            error_.message = message;
+        }
+    }
+
+    bool count(const JsonValue& value, const std::string& path, std::size_t& out) {
+        if (!value.is_number() || value.number_value() < 0 ||
+            value.number_value() != std::floor(value.number_value())) {
+            fail(path, "Expected a non-negative integer");
+            return false;
+        }
+        out = value.is_integer() ? static_cast<std::size_t>(value.integer_value())
+                                 : static_cast<std::size_t>(std::min(value.number_value(), 1e18));
+        return true;
+    }
+
+    bool number(const JsonValue& value, const std::string& path, double& out) {
+        if (!value.is_number()) {
+            fail(path, "Expected a number");
+            return false;
+        }
+        out = value.number_value();
+        return true;
+    }
+
+    bool pattern(const std::string& source, const std::string& path, std::uint32_t& out) {
+        try {
+            schema_.patterns_.emplace_back(source, std::regex::ECMAScript);
+        } catch (const std::regex_error&) {
+            fail(path, "Invalid regular expression");
+            return false;
+        }
+        out = static_cast<std::uint32_t>(schema_.patterns_.size() - 1);
+        return true;
+    }
+
+    bool schemas(const JsonValue& value, const std::string& path, std::vector<std::uint32_t>& out) {
+        if (!value.is_array() || static_cast<const JsonArray&>(value).empty()) {
+            fail(path, "Expected a non-empty array of schemas");
+            return false;
+        }
+        std::size_t index = 0;
+        for (const auto& element : static_cast<const JsonArray&>(value)) {
+            out.push_back(node(*element, child_path(path, std::to_string(index++))));
+        }
+        return true;
+    }
+
+    bool type(const JsonValue& value, const std::string& path, std::uint8_t& types) {
+        static constexpr std::pair<std::string_view, std::uint8_t> names[] = {
+            {"null", NullType},     {"boolean", BooleanType}, {"integer", IntegerType},
+            {"number", NumberType}, {"string", StringType},   {"array", ArrayType},
+            {"object", ObjectType},
+        };
+        auto add = [&](const JsonValue& name) {
+            if (name.is_string()) {
+                for (const auto& [text, bit] : names) {
+                    if (name.string_value() == text) {
+                        types |= bit;
+                        return true;
+                    }
+                }
+            }
+            fail(path, "Unknown type");
+            return false;
+        };
+        if (!value.is_array()) {
+            return add(value);
+        }
+        for (const auto& name : static_cast<const JsonArray&>(value)) {
+            if (!add(*name)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::uint32_t node(const JsonValue& value, const std::string& path) {
+        auto compiled = compiled_.find(&value);
+        if (compiled != compiled_.end()) {
+            return compiled->second;
+        }
+        std::uint32_t index = static_cast<std::uint32_t>(schema_.nodes_.size());
+        schema_.nodes_.emplace_back();
+        compiled_.emplace(&value, index);
+        if (value.is_boolean()) {
+            schema_.nodes_[index].reject = !value.boolean_value();
+            return index;
+        }
+        if (!value.is_object()) {
+            fail(path, "Expected a schema (an object or a boolean)");
+            return index;
+        }
+
+        // Subschemas are compiled as they are met, growing nodes_, so
+        // the node is filled in locally and stored at the end
+        Node result;
+        const JsonValue* enumeration = nullptr;
+        const JsonValue* constant = nullptr;
+        const JsonValue* items = nullptr;
+        const JsonValue* additional_items = nullptr;
+        const JsonValue* exclusive_minimum = nullptr;
+        const JsonValue* exclusive_maximum = nullptr;
+        for (const auto& [key, member] : static_cast<const JsonObject&>(value)) {
+            std::string where = child_path(path, key.view());
+            std::string_view name = key.view();
+            const JsonValue& field = *member;
+            if (name == "type") {
+                type(field, where, result.types);
+            } else if (name == "enum") {
+                if (!field.is_array()) {
+                    fail(where, "Expected an array");
+                } else {
+                    enumeration = &field;
+                }
+            } else if (name == "const") {
+                constant = &field;
+            } else if (name == "minimum") {
+                number(field, where, result.minimum);
+            } else if (name == "maximum") {
+                number(field, where, result.maximum);
+            } else if (name == "exclusiveMinimum") {
+                exclusive_minimum = &field;
+            } else if (name == "exclusiveMaximum") {
+                exclusive_maximum = &field;
+            } else if (name == "multipleOf") {
+                if (number(field, where, result.multiple_of) && !(result.multiple_of > 0)) {
+                    fail(where, "Expected a positive number");
+                }
+            } else if (name == "minLength") {
+                count(field, where, result.min_length);
+            } else if (name == "maxLength") {
+                count(field, where, result.max_length);
+            } else if (name == "pattern") {
+                if (!field.is_string()) {
+                    fail(where, "Expected a regular expression");
+                } else {
+                    pattern(field.string_value(), where, result.pattern);
+                }
+            } else if (name == "items") {
+                items = &field;
+            } else if (name == "prefixItems") {
+                schemas(field, where, result.prefix_items);
+            } else if (name == "additionalItems") {
+                additional_items = &field;
+            } else if (name == "minItems") {
+                count(field, where, result.min_items);
+            } else if (name == "maxItems") {
+                count(field, where, result.max_items);
+            } else if (name == "uniqueItems") {
+                if (!field.is_boolean()) {
+                    fail(where, "Expected a boolean");
+                } else {
+                    result.unique_items = field.boolean_value();
+                }
+            } else if (name == "properties" || name == "patternProperties") {
+                if (!field.is_object()) {
+                    fail(where, "Expected an object of schemas");
+                    continue;
+                }
+                for (const auto& [property, subschema] : static_cast<const JsonObject&>(field)) {
+                    std::string at = child_path(where, property.view());
+                    if (name == "properties") {
+                        result.properties.try_emplace(property.str(), node(*subschema, at));
+                        continue;
+                    }
+                    std::uint32_t regex;
+                    if (pattern(property.str(), at, regex)) {
+                        result.pattern_properties.emplace_back(regex, node(*subschema, at));
+                    }
+                }
+            } else if (name == "additionalProperties") {
+                result.additional_properties = node(field, where);
+            } else if (name == "required") {
+                bool valid = field.is_array();
+                if (valid) {
+                    for (const auto& required : static_cast<const JsonArray&>(field)) {
+                        valid = valid && required->is_string();
+                        if (valid) {
+                            result.required.push_back(required->string_value());
+                        }
+                    }
+                }
+                if (!valid) {
+                    fail(where, "Expected an array of strings");
+                }
+            } else if (name == "minProperties") {
+                count(field, where, result.min_properties);
+            } else if (name == "maxProperties") {
+                count(field, where, result.max_properties);
+            } else if (name == "allOf") {
+                schemas(field, where, result.all_of);
+            } else if (name == "anyOf") {
+                schemas(field, where, result.any_of);
+            } else if (name == "oneOf") {
+                schemas(field, where, result.one_of);
+            } else if (name == "not") {
+                result.negated = node(field, where);
+            } else if (name == "$ref") {
+                if (!field.is_string()) {
+                    fail(where, "Expected a string");
+                } else {
+                    refs_.push_back(Ref{index, field.string_value(), where});
+                }
+            }
+        }
+
+        // Draft 4 booleans modify minimum and maximum; later drafts give
+        // the exclusive bounds separately, and the stricter bound applies
+        auto exclusive = [&](const JsonValue* bound, const char* name, double& limit, bool& flag, bool lower) {
+            if (!bound) {
+                return;
+            }
+            if (bound->is_boolean()) {
+                flag = bound->boolean_value();
+            } else if (!bound->is_number()) {
+                fail(child_path(path, name), "Expected a number or a boolean");
+            } else if (lower ? bound->number_value() >= limit : bound->number_value() <= limit) {
+                limit = bound->number_value();
+                flag = true;
+            }
+        };
+        exclusive(exclusive_minimum, "exclusiveMinimum", result.minimum, result.exclusive_minimum, true);
+        exclusive(exclusive_maximum, "exclusiveMaximum", result.maximum, result.exclusive_maximum, false);
+
+        // items as an array is the draft 7 form of prefixItems, with
+        // additionalItems for the rest
+        if (items && items->is_array()) {
+            schemas(*items, child_path(path, "items"), result.prefix_items);
+            if (additional_items) {
+                result.items = node(*additional_items, child_path(path, "additionalItems"));
+            }
+        } else if (items) {
+            result.items = node(*items, child_path(path, "items"));
+        }
+
+        if (constant) {
+            // With both, only the constant can pass, and only if enum has it
+            bool listed = !enumeration;
+            if (enumeration) {
+                for (const auto& element : static_cast<const JsonArray&>(*enumeration)) {
+                    listed = listed || element->equals(*constant);
+                }
+            }
+            result.restricted = true;
+            result.is_const = true;
+            result.reject = result.reject || !listed;
+            result.allowed.push_back(JsonRef<JsonValue>(const_cast<JsonValue*>(constant)));
+        } else if (enumeration) {
+            result.restricted = true;
+            for (const auto& element : static_cast<const JsonArray&>(*enumeration)) {
+                result.allowed.push_back(element);
+            }
+        }
+
+        schema_.nodes_[index] = std::move(result);
+        return index;
+    }
+
+    JsonSchema& schema_;
+    const JsonValue& root_;
+    std::unordered_map<const JsonValue*, std::uint32_t> compiled_;
+    std::vector<Ref> refs_;
+    bool failed_ = false;
+    JsonSchemaError error_;
+};
+
+// Validates the values of a document as their events arrive. Every value
+// has a range of evaluations on evals_, one per schema that applies:
+// those from the parent container's evaluations, and the allOf, anyOf,
+// oneOf, not and $ref branches they open. A failure travels up through
+// allOf-like links at once; anyOf, oneOf and not are settled when the
+// value ends, counting the branches that passed.
+class JsonSchema::Validator : public JsonHandler {
+public:
+    Validator(const JsonSchema& schema, bool build) noexcept
+        : schema_(schema), capture_(build ? 0 : no_capture), build_(build) {}
+
+    bool failed() const noexcept { return failed_; }
+    const JsonSchemaError& error() const noexcept { return error_; }
+    JsonRef<JsonValue> take_value() noexcept { return std::move(value_); }
+
+    bool on_null() override { return scalar(Scalar{JsonType::Null}); }
+    bool on_boolean(bool value) override {
+        Scalar scalar_value{JsonType::Boolean};
+        scalar_value.boolean = value;
+        return scalar(scalar_value);
+    }
+    bool on_integer(std::int64_t value) override {
+        Scalar scalar_value{JsonType::Number};
+        scalar_value.integer = value;
+        scalar_value.number = static_cast<double>(value);
+        scalar_value.exact = true;
+        scalar_value.integral = true;
+        return scalar(scalar_value);
+    }
+    bool on_real(double value) override {
+        Scalar scalar_value{JsonType::Number};
+        scalar_value.number = value;
+        scalar_value.integral = std::isfinite(value) && value == std::floor(value);
+        return scalar(scalar_value);
+    }
+    bool on_string(std::string_view value) override {
+        Scalar scalar_value{JsonType::String};
+        scalar_value.text = value;
+        return scalar(scalar_value);
+    }
+
+    bool on_start_object() override { return start(true); }
+    bool on_start_array() override { return start(false); }
+    bool on_end_object(std::size_t) override { return end(); }
+    bool on_end_array(std::size_t) override { return end(); }
+
+    bool on_key(std::string_view key) override {
+        if (skip_depth_ > 0) {
+            return true;
+        }
+        Frame& frame = frames_.back();
+        frame.key.assign(key.data(), key.size());
+        for (std::uint32_t i = frame.begin; i < frame.end; ++i) {
+            const Eval& eval = evals_[i];
+            if (eval.failed) {
+                continue;
+            }
+            const auto& required = schema_.nodes_[eval.node].required;
+            for (std::size_t j = 0; j < required.size(); ++j) {
+                if (required[j] == key) {
+                    seen_[eval.seen + j] = 1;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::size_t no_capture = static_cast<std::size_t>(-1);
+
+    // How an evaluation's outcome reaches its parent
+    enum class Role : std::uint8_t { All, Any, One, Not };
+
+    struct Eval {
+        std::uint32_t node;
+        std::uint32_t parent;
+        Role role;
+        bool failed = false;
+        bool negation_passed = false;
+        std::uint32_t any_passed = 0;
+        std::uint32_t one_passed = 0;
+
+        // Offset of the required flags in seen_
+        std::size_t seen = 0;
+    };
+
+    // An open container: its evaluations, members or elements so far, the
+    // current member, and where it starts on the builder
+    struct Frame {
+        std::uint32_t begin;
+        std::uint32_t end;
+        bool object;
+        std::size_t count = 0;
+        std::size_t seen = 0;
+        std::string key{};
+        JsonBuilder::Mark mark{};
+    };
+
+    struct Scalar {
+        JsonType type;
+        bool boolean = false;
+        bool integral = false;
+        bool exact = false;
+        std::int64_t integer = 0;
+        double number = 0;
+        std::string_view text{};
+    };
+
+    // References may loop without consuming a value; stop them here
+    static constexpr unsigned max_nesting = 64;
+
+    const Node& node(std::uint32_t eval) const noexcept { return schema_.nodes_[evals_[eval].node]; }
+
+    bool capturing(std::size_t depth) const noexcept { return capture_ != no_capture && depth >= capture_; }
+
+    // JSON Pointer to the value at depth (the number of containers around it)
+    std::string location(std::size_t depth) const {
+        std::string path;
+        for (std::size_t i = 0; i < depth; ++i) {
+            if (frames_[i].object) {
+                append_token(path, frames_[i].key);
+            } else {
+                path += '/';
+                path += std::to_string(frames_[i].count - 1);
+            }
+        }
+        return path;
+    }
+
+    void fail(std::uint32_t index, const char* message, std::size_t depth) {
+        fail(index, std::string(message), depth);
+    }
+
+    void fail(std::uint32_t index, const std::string& message, std::size_t depth) {
+        while (true) {
+            Eval& eval = evals_[index];
+            if (eval.failed) {
+                return;
+            }
+            eval.failed = true;
+            if (eval.role != Role::All) {
+                return;
+            }
+            if (eval.parent == none) {
+                failed_ = true;
+                error_.path = location(depth);
+                error_.message = message;
+                return;
+            }
+            index = eval.parent;
+        }
+    }
+
+    void open(std::uint32_t schema, std::uint32_t parent, Role role, std::size_t depth, unsigned nesting = 0) {
+        std::uint32_t index = static_cast<std::uint32_t>(evals_.size());
+        evals_.push_back(Eval{schema, parent, role});
+        const Node& node = schema_.nodes_[schema];
+        if (node.reject) {
+            fail(index, "Value not allowed by the schema", depth);
+            return;
+        }
+        if (nesting >= max_nesting) {
+            fail(index, "Schema references nest too deeply", depth);
+            return;
+        }
+        for (std::uint32_t branch : node.all_of) {
+            open(branch, index, Role::All, depth, nesting + 1);
+        }
+        for (std::uint32_t branch : node.any_of) {
+            open(branch, index, Role::Any, depth, nesting + 1);
+        }
+        for (std::uint32_t branch : node.one_of) {
+            open(branch, index, Role::One, depth, nesting + 1);
+        }
+        if (node.negated != none) {
+            open(node.negated, index, Role::Not, depth, nesting + 1);
+        }
+        if (node.ref != none) {
+            open(node.ref, index, Role::All, depth, nesting + 1);
+        }
+    }
+
+    // Open the evaluations of the value starting now; returns the first
+    std::uint32_t begin_value() {
+        std::uint32_t begin = static_cast<std::uint32_t>(evals_.size());
+        std::size_t depth = frames_.size();
+        if (frames_.empty()) {
+            open(0, none, Role::All, depth);
+            return begin;
+        }
+
+        Frame& frame = frames_.back();
+        ++frame.count;
+        for (std::uint32_t i = frame.begin; i < frame.end && !failed_; ++i) {
+            if (evals_[i].failed) {
+                continue;
+            }
+            const Node& parent = node(i);
+            if (frame.object) {
+                bool matched = false;
+                auto property = parent.properties.find(frame.key);
+                if (property != parent.properties.end()) {
+                    open(property->second, i, Role::All, depth);
+                    matched = true;
+                }
+                if (!parent.pattern_properties.empty() && frame.key.size() > max_pattern_subject) {
+                    fail(i, "Property name is too long to match patternProperties", depth);
+                    continue;
+                }
+                for (const auto& [pattern, schema] : parent.pattern_properties) {
+                    if (std::regex_search(frame.key, schema_.patterns_[pattern])) {
+                        open(schema, i, Role::All, depth);
+                        matched = true;
+                    }
+                }
+                if (!matched && parent.additional_properties != none) {
+                    open(parent.additional_properties, i, Role::All, depth);
+                }
+            } else {
+                std::size_t index = frame.count - 1;
+                if (index < parent.prefix_items.size()) {
+                    open(parent.prefix_items[index], i, Role::All, depth);
+                } else if (parent.items != none) {
+                    open(parent.items, i, Role::All, depth);
+                }
+            }
+        }
+        return begin;
+    }
+
+    // Settle the evaluations from begin on, innermost first, and drop them
+    void end_value(std::uint32_t begin, std::size_t depth) {
+        for (std::uint32_t i = static_cast<std::uint32_t>(evals_.size()); i-- > begin;) {
+            const Node& schema = node(i);
+            if (!evals_[i].failed) {
+                if (!schema.any_of.empty() && evals_[i].any_passed == 0) {
+                    fail(i, "Value matches no schema in anyOf", depth);
+                } else if (!schema.one_of.empty() && evals_[i].one_passed != 1) {
+                    fail(i, "Value must match exactly one schema in oneOf", depth);
+                } else if (schema.negated != none && evals_[i].negation_passed) {
+                    fail(i, "Value matches the schema in not", depth);
+                }
+            }
+            const Eval& eval = evals_[i];
+            if (eval.failed || eval.parent == none || eval.role == Role::All) {
+                continue;
+            }
+            Eval& parent = evals_[eval.parent];
+            if (eval.role == Role::Any) {
+                ++parent.any_passed;
+            } else if (eval.role == Role::One) {
+                ++parent.one_passed;
+            } else {
+                parent.negation_passed = true;
+            }
+        }
+        evals_.resize(begin);
+    }
+
+    bool check_type(std::uint32_t index, std::uint8_t bits, std::size_t depth) {
+        std::uint8_t types = node(index).types;
+        if (types == 0 || (types & bits) != 0) {
+            return true;
+        }
+        static constexpr std::pair<std::uint8_t, const char*> names[] = {
+            {NullType, "null"},     {BooleanType, "boolean"}, {IntegerType, "integer"},
+            {NumberType, "number"}, {StringType, "string"},   {ArrayType, "array"},
+            {ObjectType, "object"},
+        };
+        std::string message = "Expected ";
+        bool first = true;
+        for (const auto& [bit, name] : names) {
+            if (types & bit) {
+                message += first ? "" : " or ";
+                message += name;
+                first = false;
+            }
+        }
+        fail(index, message, depth);
+        return false;
+    }
+
+    void check_allowed(std::uint32_t index, const JsonValue& value, std::size_t depth) {
+        const Node& schema = node(index);
+        for (const auto& allowed : schema.allowed) {
+            if (allowed->equals(value)) {
+                return;
+            }
+        }
+        fail(index, schema.is_const ? "Value does not equal const" : "Value is not in enum", depth);
+    }
+
+    void check_scalar(std::uint32_t index, const Scalar& value, const JsonValue* built, std::size_t depth) {
+        const Node& schema = node(index);
+        std::uint8_t bits = value.type == JsonType::Null      ? NullType
+                            : value.type == JsonType::Boolean ? BooleanType
+                            : value.type == JsonType::String  ? StringType
+                            : value.integral                  ? IntegerType | NumberType
+                                                              : NumberType;
+        if (!check_type(index, bits, depth)) {
+            return;
+        }
+        if (schema.restricted) {
+            check_allowed(index, *built, depth);
+        }
+        if (value.type == JsonType::Number) {
+            double number = value.number;
+            if (number < schema.minimum || (schema.exclusive_minimum && number == schema.minimum)) {
+                fail(index, "Value is below the minimum", depth);
+            } else if (number > schema.maximum || (schema.exclusive_maximum && number == schema.maximum)) {
+                fail(index, "Value is above the maximum", depth);
+            } else if (schema.multiple_of > 0) {
+                bool divides = value.exact && schema.multiple_of == std::floor(schema.multiple_of) &&
+                                       schema.multiple_of < 9223372036854775807.0
+                                   ? value.integer % static_cast<std::int64_t>(schema.multiple_of) == 0
+                                   : multiple_of(number, schema.multiple_of);
+                if (!divides) {
+                    fail(index, "Value is not a multiple of multipleOf", depth);
+                }
+            }
+        } else if (value.type == JsonType::String) {
+            if (schema.min_length > 0 || schema.max_length != unbounded) {
+                std::size_t length = code_points(value.text);
+                if (length < schema.min_length) {
+                    fail(index, "String is shorter than minLength", depth);
+                } else if (length > schema.max_length) {
+                    fail(index, "String is longer than maxLength", depth);
+                }
+            }
+            if (schema.pattern != none) {
+                if (value.text.size() > max_pattern_subject) {
+                    fail(index, "String is too long to match pattern", depth);
+                } else if (!std::regex_search(value.text.begin(), value.text.end(),
+                                              schema_.patterns_[schema.pattern])) {
+                    fail(index, "String does not match pattern", depth);
+                }
+            }
+        }
+    }
+
+    void check_container(std::uint32_t index, const Frame& frame, const JsonValue* built, std::size_t depth) {
+        const Node& schema = node(index);
+        if (schema.restricted) {
+            check_allowed(index, *built, depth);
+        }
+        if (!frame.object) {
+            if (frame.count < schema.min_items) {
+                fail(index, "Array has fewer elements than minItems", depth);
+            } else if (frame.count > schema.max_items) {
+                fail(index, "Array has more elements than maxItems", depth);
+            } else if (schema.unique_items && !unique(static_cast<const JsonArray&>(*built))) {
+                fail(index, "Array elements are not unique", depth);
+            }
+            return;
+        }
+        if (frame.count < schema.min_properties) {
+            fail(index, "Object has fewer members than minProperties", depth);
+            return;
+        }
+        if (frame.count > schema.max_properties) {
+            fail(index, "Object has more members than maxProperties", depth);
+            return;
+        }
+        for (std::size_t j = 0; j < schema.required.size(); ++j) {
+            if (!seen_[evals_[index].seen + j]) {
+                fail(index, "Missing required member \"" + schema.required[j] + "\"", depth);
+                return;
+            }
+        }
+    }
+
+    // Equal elements have equal structural hashes, so only runs of equal
+    // hashes are compared
+    static bool unique(const JsonArray& array) {
+        std::vector<std::pair<std::size_t, std::size_t>> hashes;
+        hashes.reserve(array.size());
+        for (std::size_t i = 0; i < array.size(); ++i) {
+            hashes.emplace_back(array.values()[i]->hash(), i);
+        }
+        std::sort(hashes.begin(), hashes.end());
+        for (std::size_t i = 0; i < hashes.size(); ++i) {
+            for (std::size_t j = i + 1; j < hashes.size() && hashes[j].first == hashes[i].first; ++j) {
+                if (array.values()[hashes[i].second]->equals(*array.values()[hashes[j].second])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static JsonRef<JsonValue> build(const Scalar& value) {
+        switch (value.type) {
+            case JsonType::Null:
+                return JsonNull::create();
+            case JsonType::Boolean:
+                return JsonBoolean::create(value.boolean);
+            case JsonType::String:
+                return JsonStringValue::create(std::string(value.text));
+            default:
+                if (value.exact) {
+                    return JsonNumber::create(value.integer);
+                }
+                return JsonNumber::create(value.number);
+        }
+    }
+
+    // Add a finished value to the container being built around it
+    void add(JsonRef<JsonValue> value) {
+        const Frame& parent = frames_.back();
+        if (parent.object) {
+            builder_.add(JsonKey(parent.key), std::move(value));
+        } else {
+            builder_.add(std::move(value));
+        }
+    }
+
+    bool scalar(const Scalar& value) {
+        if (skip_depth_ > 0) {
+            return true;
+        }
+        std::size_t depth = frames_.size();
+        std::uint32_t begin = begin_value();
+        JsonRef<JsonValue> built;
+        bool wanted = capturing(depth);
+        for (std::uint32_t i = begin; i < evals_.size() && !wanted; ++i) {
+            wanted = !evals_[i].failed && node(i).restricted;
+        }
+        if (wanted) {
+            built = build(value);
+        }
+        for (std::uint32_t i = begin; i < evals_.size() && !failed_; ++i) {
+            if (!evals_[i].failed) {
+                check_scalar(i, value, built.get(), depth);
+            }
+        }
+        end_value(begin, depth);
+        if (capturing(depth)) {
+            if (depth > 0) {
+                add(std::move(built));
+            } else {
+                value_ = std::move(built);
+            }
+        }
+        return !failed_;
+    }
+
+    bool start(bool object) {
+        if (skip_depth_ > 0) {
+            ++skip_depth_;
+            return true;
+        }
+        std::size_t depth = frames_.size();
+        std::uint32_t begin = begin_value();
+        std::uint32_t end = static_cast<std::uint32_t>(evals_.size());
+
+        // Only evaluations that look inside need the events of the contents
+        bool inspected = false;
+        bool needs_value = false;
+        for (std::uint32_t i = begin; i < end && !failed_; ++i) {
+            if (evals_[i].failed || !check_type(i, object ? ObjectType : ArrayType, depth)) {
+                continue;
+            }
+            const Node& schema = node(i);
+            inspected = inspected || schema.restricted || schema.unique_items ||
+                        (object ? !schema.properties.empty() || !schema.pattern_properties.empty() ||
+                                      schema.additional_properties != none || !schema.required.empty() ||
+                                      schema.min_properties > 0 || schema.max_properties != unbounded
+                                : !schema.prefix_items.empty() || schema.items != none ||
+                                      schema.min_items > 0 || schema.max_items != unbounded);
+            needs_value = needs_value || schema.needs_value();
+        }
+        if (failed_) {
+            return false;
+        }
+        if (!inspected && !capturing(depth)) {
+            end_value(begin, depth);
+            skip_depth_ = 1;
+            return !failed_;
+        }
+
+        if (needs_value && capture_ == no_capture) {
+            capture_ = depth;
+        }
+        Frame frame{begin, end, object};
+        frame.seen = seen_.size();
+        if (object) {
+            for (std::uint32_t i = begin; i < end; ++i) {
+                evals_[i].seen = seen_.size();
+                seen_.resize(seen_.size() + node(i).required.size(), 0);
+            }
+        }
+        if (capturing(depth)) {
+            frame.mark = builder_.mark();
+        }
+        frames_.push_back(std::move(frame));
+        return true;
+    }
+
+    bool end() {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+        std::size_t depth = frames_.size() - 1;
+        Frame& frame = frames_.back();
+        JsonRef<JsonValue> built;
+        if (capturing(depth)) {
+            if (frame.object) {
+                built = builder_.finish_object(frame.mark);
+            } else {
+                built = builder_.finish_array(frame.mark);
+            }
+        }
+        for (std::uint32_t i = frame.begin; i < frame.end && !failed_; ++i) {
+            if (!evals_[i].failed) {
+                check_container(i, frame, built.get(), depth);
+            }
+        }
+        std::uint32_t begin = frame.begin;
+        seen_.resize(frame.seen);
+        frames_.pop_back();
+        end_value(begin, depth);
+
+        if (capturing(depth)) {
+            if (depth > capture_) {
+                add(std::move(built));
+            } else if (build_) {
+                value_ = std::move(built);
+            } else {
+                capture_ = no_capture;
+            }
+        }
+        return !failed_;
+    }
+
+    const JsonSchema& schema_;
+    std::vector<Eval> evals_;
+    std::vector<Frame> frames_;
+    std::vector<char> seen_;
+    std::size_t skip_depth_ = 0;
+
+    // Depth of the outermost value being built, or no_capture
+    JsonBuilder builder_;
+    std::size_t capture_;
+    bool build_;
+    JsonRef<JsonValue> value_;
+
+    bool failed_ = false;
+    JsonSchemaError error_;
+};
+
+JsonSchema::JsonSchema() : nodes_(1) {}
+
+Result<JsonSchema> JsonSchema::compile(const JsonValue& schema, JsonSchemaError* error) {
+    JsonSchema compiled;
+    compiled.nodes_.clear();
+    Compiler compiler(compiled, schema);
+    if (!compiler.compile()) {
+        if (error) {
+            *error = compiler.error();
+        }
+        return Result<JsonSchema>(make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    return Result<JsonSchema>(std::move(compiled));
+}
+
+bool JsonSchema::validate(const JsonValue& value, JsonSchemaError* error) const {
+    Validator validator(*this, false);
+    emit(value, validator);
+    if (validator.failed() && error) {
+        *error = validator.error();
+    }
+    return !validator.failed();
+}
+
+Result<bool> JsonSchema::validate(std::string_view input, JsonSchemaError* error) const {
+    return validate(input, JsonParseOptions(), error);
+}
+
+Result<bool> JsonSchema::validate(std::string_view input, const JsonParseOptions& options,
+                                  JsonSchemaError* error) const {
+    return run(input, options, false, nullptr, error);
+}
+
+Result<JsonRef<JsonValue>> JsonSchema::parse(std::string_view input, JsonSchemaError* error) const {
+    return parse(input, JsonParseOptions(), error);
+}
+
+Result<JsonRef<JsonValue>> JsonSchema::parse(std::string_view input, const JsonParseOptions& options,
+                                             JsonSchemaError* error) const {
+    JsonRef<JsonValue> value;
+    auto valid = run(input, options, true, &value, error);
+    if (!valid) {
+        return Result<JsonRef<JsonValue>>(valid.error());
+    }
+    if (!valid.value()) {
+        return Result<JsonRef<JsonValue>>(make_error_code(JsonErrorCode::SchemaViolation));
+    }
+    return Result<JsonRef<JsonValue>>(std::move(value));
+}
+
+Result<bool> JsonSchema::run(std::string_view input, const JsonParseOptions& options, bool build,
+                             JsonRef<JsonValue>* value, JsonSchemaError* error) const {
+    Validator validator(*this, build);
+    auto parsed = JsonParser::parse(input, options, validator);
+    if (validator.failed()) {
+        if (error) {
+            *error = validator.error();
+        }
+        return Result<bool>(false);
+    }
+    if (!parsed) {
+        return Result<bool>(parsed.error());
+    }
+    if (value) {
+        *value = validator.take_value();
+    }
+    return Result<bool>(true);
+}
+
+} // namespace jansson
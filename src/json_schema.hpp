@@ -0,0 +1,150 @@
+#ifndef JSON_SCHEMA_HPP
+#define JSON_SCHEMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_hash.hpp"
+#include "json_value.hpp"
+#include "json_error.hpp"
+
+namespace jansson {
+
+struct JsonParseOptions;
+
+// Why validation (or compiling a schema) failed: a JSON Pointer to the
+// offending value and a description
+struct JsonSchemaError {
+    std::string path;
+    std::string message;
+};
+
+// A JSON Schema, compiled once into a table of nodes and run as a
+// validator over parser events.
+//
+// Supported keywords: type, enum, const; minimum, maximum,
+// exclusiveMinimum, exclusiveMaximum (numeric, or the draft 4 booleans),
+// multipleOf; minLength, maxLength, pattern (ECMAScript); items (a schema,
+// or an array as in draft 7), prefixItems, additionalItems, minItems,
+// maxItems, uniqueItems; properties, patternProperties,
+// additionalProperties, required, minProperties, maxProperties; allOf,
+// anyOf, oneOf, not; and $ref to a JSON Pointer within the schema ("#",
+// "#/$defs/name"). Boolean schemas are accepted. Other keywords, formats
+// among them, are ignored. Patterns run on std::regex, whose stack use
+// grows with the subject, so strings and property names longer than
+// max_pattern_subject bytes are reported as violations instead of matched.
+//
+// Validation follows the events as they arrive. Each value gets one
+// evaluation per schema that applies to it, branches of allOf, anyOf,
+// oneOf and not included; a failure that cannot be undone by an
+// enclosing anyOf, oneOf or not stops the parse at once. Subtrees no
+// schema applies to are skipped, and values are only built where enum,
+// const or uniqueItems need to compare whole containers.
+//
+// A schema is immutable and may be shared between threads.
+class JsonSchema {
+public:
+    static constexpr std::size_t max_pattern_subject = 4096;
+
+    // The empty schema, which accepts everything
+    JsonSchema();
+
+    // Fails with InvalidArgument for a malformed keyword or an unresolved
+    // $ref; error describes the location in the schema
+    static Result<JsonSchema> compile(const JsonValue& schema, JsonSchemaError* error = nullptr);
+
+    // Validate a tree
+    bool validate(const JsonValue& value, JsonSchemaError* error = nullptr) const;
+
+    // Validate text without building it. The value is false if the text
+    // violates the schema, in which case parsing stopped at the first
+    // violation; malformed JSON fails with the parser's error.
+    Result<bool> validate(std::string_view input, JsonSchemaError* error = nullptr) const;
+
+    // The same under the parser limits in options, for untrusted input
+    Result<bool> validate(std::string_view input, const JsonParseOptions& options,
+                          JsonSchemaError* error = nullptr) const;
+
+    // Parse text and validate it in the same pass. Fails with
+    // SchemaViolation at the first violation, before the rest of the
+    // input is read, or with the parser's error.
+    Result<JsonRef<JsonValue>> parse(std::string_view input, JsonSchemaError* error = nullptr) const;
+    Result<JsonRef<JsonValue>> parse(std::string_view input, const JsonParseOptions& options,
+                                     JsonSchemaError* error = nullptr) const;
+
+private:
+    class Compiler;
+    class Validator;
+
+    static constexpr std::uint32_t none = UINT32_MAX;
+    static constexpr std::size_t unbounded = std::numeric_limits<std::size_t>::max();
+
+    // Bits of Node::types
+    enum TypeMask : std::uint8_t {
+        NullType = 1,
+        BooleanType = 2,
+        IntegerType = 4,
+        NumberType = 8,
+        StringType = 16,
+        ArrayType = 32,
+        ObjectType = 64
+    };
+
+    struct Node {
+        bool reject = false;
+        std::uint8_t types = 0;
+
+        // enum, or const as a single value
+        bool restricted = false;
+        bool is_const = false;
+        std::vector<JsonRef<JsonValue>> allowed;
+
+        double minimum = -std::numeric_limits<double>::infinity();
+        double maximum = std::numeric_limits<double>::infinity();
+        bool exclusive_minimum = false;
+        bool exclusive_maximum = false;
+        double multiple_of = 0;
+
+        std::size_t min_length = 0;
+        std::size_t max_length = unbounded;
+        std::uint32_t pattern = none;
+
+        std::vector<std::uint32_t> prefix_items;
+        std::uint32_t items = none;
+        std::size_t min_items = 0;
+        std::size_t max_items = unbounded;
+        bool unique_items = false;
+
+        JsonHash<std::string, std::uint32_t> properties;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> pattern_properties;
+        std::uint32_t additional_properties = none;
+        std::vector<std::string> required;
+        std::size_t min_properties = 0;
+        std::size_t max_properties = unbounded;
+
+        std::vector<std::uint32_t> all_of;
+        std::vector<std::uint32_t> any_of;
+        std::vector<std::uint32_t> one_of;
+        std::uint32_t negated = none;
+        std::uint32_t ref = none;
+
+        // Whether checking needs the value built
+        bool needs_value() const noexcept { return restricted || unique_items; }
+    };
+
+    // Run a validator over the events of input; parse() builds the value
+    Result<bool> run(std::string_view input, const JsonParseOptions& options, bool build,
+                     JsonRef<JsonValue>* value, JsonSchemaError* error) const;
+
+    // nodes_[0] is the root
+    std::vector<Node> nodes_;
+    std::vector<std::regex> patterns_;
+};
+
+} // namespace jansson
+
+#endif // JSON_SCHEMA_HPP
@@ -1,130 +1,457 @@
 #include "json_serializer.hpp"
-#include "string_utils.hpp"
-#include <sstream>
-#include <iomanip>
-#include <cmath>
+#include "json_stats.hpp"
+#include "json_thread_pool.hpp"
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace jansson {
 
-void JsonSerializer::serialize_value(std::ostream& os, const JsonValue& value, bool pretty_print, int indent, int current_indent) {
+namespace {
+
+// Output buffers larger than this are freed after a serialization rather
+// than kept for the next one
+constexpr std::size_t retained_output_bytes = 1 << 20;
+
+// Set once the thread's buffer has been destroyed at thread exit
+thread_local bool thread_output_gone = false;
+
+// The buffer that serialize() to a string writes into. Each thread keeps
+// one, so steady-state serialization allocates only the returned string,
+// at its final size; a serialization started while the buffer is in use
+// gets its own.
+class OutputLease {
+public:
+    OutputLease() {
+        if (!thread_output_gone) {
+            ThreadOutput& shared = thread_output();
+            if (!shared.in_use) {
+                shared.in_use = true;
+                writer_ = &shared.writer;
+                return;
+            }
+        }
+        own_ = std::make_unique<JsonStringWriter>();
+        writer_ = own_.get();
+    }
+
+    ~OutputLease() {
+        if (!own_) {
+            writer_->clear(retained_output_bytes);
+            thread_output().in_use = false;
+        }
+    }
+
+    OutputLease(const OutputLease&) = delete;
+    OutputLease& operator=(const OutputLease&) = delete;
+
+    JsonStringWriter& writer() noexcept { return *writer_; }
+
+private:
+    struct ThreadOutput {
+        JsonStringWriter writer;
+        bool in_use = false;
+
+        ~ThreadOutput() { thread_output_gone = true; }
+    };
+
+    static ThreadOutput& thread_output() {
+        static thread_local ThreadOutput shared;
+        return shared;
+    }
+
+    JsonStringWriter* writer_;
+    std::unique_ptr<JsonStringWriter> own_;
+};
+
+} // namespace
+
+void JsonSerializer::serialize_value(JsonWriter& writer, const JsonValue& value, const JsonSerializeOptions& options, int current_indent) {
     switch (value.type()) {
         case JsonType::Null:
-            os << "null";
+            writer.write("null", 4);
             break;
         case JsonType::Boolean:
-            os << (value.boolean_value() ? "true" : "false");
+            if (static_cast<const JsonBoolean&>(value).value()) {
+                writer.write("true", 4);
+            } else {
+                writer.write("false", 5);
+            }
             break;
         case JsonType::Number: {
-            double num = value.number_value();
-            if (std::floor(num) == num) {
-                os << static_cast<int64_t>(num);
+            const auto& number = static_cast<const JsonNumber&>(value);
+            char buffer[JsonNumber::max_formatted_length];
+            std::size_t length;
+            if (options.canonical) {
+                length = number.format_canonical(buffer);
+                if (length == 0) {
+                    throw JsonException("Canonical JSON cannot represent NaN or infinity");
+                }
             } else {
-                // Use default formatting for floating point
-                os << num;
+                length = number.format(buffer, options.real_precision);
             }
+            writer.write(buffer, length);
             break;
         }
         case JsonType::String:
-            os << value.to_string();
+            writer.write_escaped(static_cast<const JsonStringValue&>(value).view());
             break;
-        case JsonType::Array:
-            serialize_array(os, static_cast<const JsonArray&>(value), pretty_print, indent, current_indent);
+        case JsonType::Array: {
+            const auto& array = static_cast<const JsonArray&>(value);
+            if (array.container_state().caches_encoding()) {
+                serialize_cached(writer, array, array.container_state(), options, current_indent);
+            } else {
+                serialize_array(writer, array, options, current_indent);
+            }
             break;
-        case JsonType::Object:
-            serialize_object(os, static_cast<const JsonObject&>(value), pretty_print, indent, current_indent);
+        }
+        case JsonType::Object: {
+            const auto& object = static_cast<const JsonObject&>(value);
+            if (object.container_state().caches_encoding()) {
+                serialize_cached(writer, object, object.container_state(), options, current_indent);
+            } else {
+                serialize_object(writer, object, options, current_indent);
+            }
             break;
+        }
     }
 }
 
-void JsonSerializer::serialize_array(std::ostream& os, const JsonArray& array, bool pretty_print, int indent, int current_indent) {
-    os << "[";
+// Everything that changes the text of a container. Indentation only
+// matters when pretty printing, so compact text is reused at any depth.
+static std::uint64_t encoding_format(const JsonSerializeOptions& options, int current_indent) noexcept {
+    std::uint64_t format = static_cast<std::uint8_t>(options.real_precision);
+    format |= static_cast<std::uint64_t>(options.compact) << 8;
+    format |= static_cast<std::uint64_t>(options.sort_keys) << 9;
+    format |= static_cast<std::uint64_t>(options.canonical) << 11;
+    if (options.pretty_print) {
+        format |= std::uint64_t(1) << 10;
+        format |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(options.indent)) << 16;
+        format |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(current_indent)) << 32;
+    }
+    return format;
+}
+
+static const JsonContainerState& container_state_of(const JsonValue& container) noexcept {
+    return container.is_array() ? static_cast<const JsonArray&>(container).container_state()
+                                : static_cast<const JsonObject&>(container).container_state();
+}
+
+static bool is_current(const JsonEncoding& encoding) noexcept {
+    for (const auto& [container, version] : encoding.containers) {
+        if (container_state_of(*container).version() != version) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every container under root, root first and parents before children
+static void record_containers(const JsonValue& root, JsonEncoding& encoding) {
+    std::vector<const JsonValue*> pending{&root};
+    while (!pending.empty()) {
+        const JsonValue* container = pending.back();
+        pending.pop_back();
+        encoding.containers.emplace_back(container, container_state_of(*container).version());
+        auto visit = [&](const JsonRef<JsonValue>& child) {
+            if (child && (child->is_array() || child->is_object())) {
+                pending.push_back(child.get());
+            }
+        };
+        if (container->is_array()) {
+            for (const auto& element : static_cast<const JsonArray&>(*container)) {
+                visit(element);
+            }
+        } else {
+            for (const auto& member : static_cast<const JsonObject&>(*container)) {
+                visit(member.second);
+            }
+        }
+    }
+}
+
+void JsonSerializer::serialize_cached(JsonWriter& writer, const JsonValue& container, const JsonContainerState& state, const JsonSerializeOptions& options, int current_indent) {
+    std::uint64_t format = encoding_format(options, current_indent);
+    std::shared_ptr<const JsonEncoding> cached = state.cached_encoding();
+    if (cached && cached->format == format && is_current(*cached)) {
+        writer.write(cached->text);
+        return;
+    }
     
-    if (pretty_print) {
-        os << "\n";
+    auto encoding = std::make_shared<JsonEncoding>();
+    encoding->format = format;
+    record_containers(container, *encoding);
+    JsonStringWriter out;
+    if (container.is_array()) {
+        serialize_array(out, static_cast<const JsonArray&>(container), options, current_indent);
+    } else {
+        serialize_object(out, static_cast<const JsonObject&>(container), options, current_indent);
+    }
+    encoding->text = out.take();
+    writer.write(encoding->text);
+    state.store_encoding(std::move(encoding));
+}
+
+// Serialize count items on the pool. Each task writes a contiguous range
+// into its own buffer; buffers are appended to writer in range order. Work
+// proceeds in waves of one range per thread so that, with a streaming
+// writer, only a fraction of the output is held in memory at a time.
+template <typename WriteRange>
+static void serialize_parallel(JsonWriter& writer, std::size_t count, const JsonSerializeOptions& options, WriteRange write_range) {
+    JsonThreadPool& pool = options.pool ? *options.pool : JsonThreadPool::shared();
+    std::size_t threads = pool.size();
+    if (threads < 2) {
+        write_range(writer, 0, count);
+        return;
     }
     
-    bool first = true;
-    for (const auto& item : array) {
-        if (!first) {
-            os << ",";
-            if (pretty_print) {
-                os << "\n";
-            } else {
-                os << " ";
+    constexpr std::size_t waves = 8;
+    std::size_t range = std::max<std::size_t>(1, count / (threads * waves));
+    std::vector<std::string> parts(threads);
+    
+    for (std::size_t wave = 0; wave < count; wave += threads * range) {
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        {
+            JsonTaskGroup group(pool);
+            for (std::size_t t = 0; t < threads; ++t) {
+                std::size_t begin = wave + t * range;
+                if (begin >= count) {
+                    parts[t].clear();
+                    continue;
+                }
+                std::size_t end = std::min(begin + range, count);
+                group.run([&, t, begin, end] {
+                    try {
+                        JsonStringWriter out;
+                        write_range(out, begin, end);
+                        parts[t] = out.take();
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                });
             }
+            group.wait();
         }
-        
-        if (pretty_print) {
-            os << std::string(current_indent + indent, ' ');
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        for (const auto& part : parts) {
+            writer.write(part);
         }
-        
-        serialize_value(os, *item, pretty_print, indent, current_indent + indent);
-        first = false;
     }
+}
+
+static bool use_parallel(const JsonSerializeOptions& options, std::size_t count) noexcept {
+    return options.parallel_threshold != 0 && count >= options.parallel_threshold;
+}
+
+void JsonSerializer::serialize_array(JsonWriter& writer, const JsonArray& array, const JsonSerializeOptions& options, int current_indent) {
+    writer.put('[');
     
-    if (pretty_print && !array.empty()) {
-        os << "\n";
-        os << std::string(current_indent, ' ');
+    if (options.pretty_print) {
+        writer.put('\n');
     }
     
-    os << "]";
-}
-
-void JsonSerializer::serialize_object(std::ostream& os, const JsonObject& object, bool pretty_print, int indent, int current_indent) {
-    os << "{";
+    if (use_parallel(options, array.size())) {
+        JsonSerializeOptions inner = options;
+        inner.parallel_threshold = 0;
+        serialize_parallel(writer, array.size(), options, [&](JsonWriter& out, std::size_t begin, std::size_t end) {
+            serialize_elements(out, array, begin, end, inner, current_indent);
+        });
+    } else {
+        serialize_elements(writer, array, 0, array.size(), options, current_indent);
+    }
     
-    if (pretty_print) {
-        os << "\n";
+    if (options.pretty_print && !array.empty()) {
+        writer.put('\n');
+        writer.fill(' ', current_indent);
     }
     
-    bool first = true;
-    for (const auto& [key, value] : object) {
-        if (!first) {
-            os << ",";
-            if (pretty_print) {
-                os << "\n";
-            } else {
-                os << " ";
-            }
+    writer.put(']');
+}
+
+void JsonSerializer::write_separator(JsonWriter& writer, const JsonSerializeOptions& options) {
+    if (options.pretty_print) {
+        writer.write(",\n", 2);
+    } else if (options.compact) {
+        writer.put(',');
+    } else {
+        writer.write(", ", 2);
+    }
+}
+
+void JsonSerializer::serialize_elements(JsonWriter& writer, const JsonArray& array, std::size_t begin, std::size_t end, const JsonSerializeOptions& options, int current_indent) {
+    auto items = array.begin();
+    for (std::size_t i = begin; i < end; ++i) {
+        if (i != 0) {
+            write_separator(writer, options);
         }
         
-        if (pretty_print) {
-            os << std::string(current_indent + indent, ' ');
+        if (options.pretty_print) {
+            writer.fill(' ', current_indent + options.indent);
         }
         
-        os << JsonString::escape(key);
-        if (pretty_print) {
-            os << " : ";
+        serialize_value(writer, *items[i], options, current_indent + options.indent);
+    }
+}
+
+void JsonSerializer::serialize_object(JsonWriter& writer, const JsonObject& object, const JsonSerializeOptions& options, int current_indent) {
+    writer.put('{');
+    
+    if (options.pretty_print) {
+        writer.put('\n');
+    }
+    
+    if (options.sort_keys) {
+        std::uint32_t local[sorted_in_place];
+        std::shared_ptr<const JsonKeyOrder> order;
+        const std::uint32_t* positions = member_order(object, options.canonical, local, order);
+        auto member = [&](std::size_t i) -> const JsonObjectMap::value_type& {
+            return *(object.begin() + static_cast<std::ptrdiff_t>(positions[i]));
+        };
+        
+        if (use_parallel(options, object.size())) {
+            JsonSerializeOptions inner = options;
+            inner.parallel_threshold = 0;
+            serialize_parallel(writer, object.size(), options, [&](JsonWriter& out, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    serialize_member(out, member(i).first, *member(i).second, i == 0, inner, current_indent);
+                }
+            });
         } else {
-            os << ": ";
+            for (std::size_t i = 0; i < object.size(); ++i) {
+                serialize_member(writer, member(i).first, *member(i).second, i == 0, options, current_indent);
+            }
+        }
+    } else if (use_parallel(options, object.size())) {
+        // Members are ranged over by position
+        JsonSerializeOptions inner = options;
+        inner.parallel_threshold = 0;
+        serialize_parallel(writer, object.size(), options, [&](JsonWriter& out, std::size_t begin, std::size_t end) {
+            auto members = object.begin();
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto& [key, value] = members[static_cast<std::ptrdiff_t>(i)];
+                serialize_member(out, key, *value, i == 0, inner, current_indent);
+            }
+        });
+    } else {
+        bool first = true;
+        for (const auto& [key, value] : object) {
+            serialize_member(writer, key, *value, first, options, current_indent);
+            first = false;
         }
-        
-        serialize_value(os, *value, pretty_print, indent, current_indent + indent);
-        first = false;
     }
     
-    if (pretty_print && !object.empty()) {
-        os << "\n";
-        os << std::string(current_indent, ' ');
+    if (options.pretty_print && !object.empty()) {
+        writer.put('\n');
+        writer.fill(' ', current_indent);
     }
     
-    os << "}";
+    writer.put('}');
+}
+
+const std::uint32_t* JsonSerializer::member_order(const JsonObject& object, bool utf16, std::uint32_t* local, std::shared_ptr<const JsonKeyOrder>& order) {
+    if (!object.shape() && object.size() <= sorted_in_place) {
+        sort_members(object, utf16, local);
+        return local;
+    }
+    order = object.key_order();
+    return order->positions(utf16).data();
+}
+
+void JsonSerializer::sort_members(const JsonObject& object, bool utf16, std::uint32_t* positions) {
+    // Insertion sort: a handful of keys, no allocation
+    auto members = object.begin();
+    auto key = [&](std::uint32_t position) {
+        return members[static_cast<std::ptrdiff_t>(position)].first.view();
+    };
+    for (std::uint32_t i = 0; i < object.size(); ++i) {
+        std::uint32_t j = i;
+        for (; j > 0 && JsonKeyOrder::less(key(i), key(positions[j - 1]), utf16); --j) {
+            positions[j] = positions[j - 1];
+        }
+        positions[j] = i;
+    }
+}
+
+void JsonSerializer::serialize_member(JsonWriter& writer, std::string_view key, const JsonValue& value, bool first, const JsonSerializeOptions& options, int current_indent) {
+    if (!first) {
+        write_separator(writer, options);
+    }
+    
+    if (options.pretty_print) {
+        writer.fill(' ', current_indent + options.indent);
+    }
+    
+    writer.write_escaped(key);
+    if (options.compact) {
+        writer.put(':');
+    } else if (options.pretty_print) {
+        writer.write(" : ", 3);
+    } else {
+        writer.write(": ", 2);
+    }
+    
+    serialize_value(writer, value, options, current_indent + options.indent);
+}
+
+JsonSerializeOptions JsonSerializer::resolve(const JsonSerializeOptions& options) {
+    JsonSerializeOptions resolved = options;
+    if (resolved.canonical) {
+        resolved.pretty_print = false;
+        resolved.compact = true;
+        resolved.sort_keys = true;
+        resolved.real_precision = 0;
+    }
+    return resolved;
 }
 
 std::string JsonSerializer::serialize(const JsonValue& value) {
-    std::ostringstream oss;
-    serialize(oss, value, false, 2, 0);
-    return oss.str();
+    return serialize(value, JsonSerializeOptions());
 }
 
 std::string JsonSerializer::serialize(const JsonValue& value, bool pretty_print, int indent) {
-    std::ostringstream oss;
-    serialize(oss, value, pretty_print, indent, 0);
-    return oss.str();
+    JsonSerializeOptions options;
+    options.pretty_print = pretty_print;
+    options.indent = indent;
+    return serialize(value, options);
+}
+
+std::string JsonSerializer::serialize(const JsonValue& value, const JsonSerializeOptions& options) {
+    stats_detail::Timer timer;
+    OutputLease lease;
+    JsonStringWriter& writer = lease.writer();
+    serialize_value(writer, value, resolve(options), 0);
+    timer.finish_serialize(writer.size());
+    return std::string(writer.view());
 }
 
 void JsonSerializer::serialize(std::ostream& os, const JsonValue& value, bool pretty_print, int indent, int current_indent) {
-    serialize_value(os, value, pretty_print, indent, current_indent);
+    JsonSerializeOptions options;
+    options.pretty_print = pretty_print;
+    options.indent = indent;
+    serialize(os, value, options, current_indent);
+}
+
+void JsonSerializer::serialize(std::ostream& os, const JsonValue& value, const JsonSerializeOptions& options, int current_indent) {
+    stats_detail::Timer timer;
+    JsonStreamWriter writer(os);
+    serialize_value(writer, value, resolve(options), current_indent);
+    writer.flush();
+    timer.finish_serialize(writer.size());
+}
+
+void JsonSerializer::serialize(JsonWriter& writer, const JsonValue& value, const JsonSerializeOptions& options, int current_indent) {
+    stats_detail::Timer timer;
+    std::size_t start = writer.size();
+    serialize_value(writer, value, resolve(options), current_indent);
+    timer.finish_serialize(writer.size() - start);
 }
 
 } // namespace jansson
@@ -1,12 +1,54 @@
 #ifndef JSON_SERIALIZER_HPP
 #define JSON_SERIALIZER_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <ostream>
 #include "json_value.hpp"
+#include "json_writer.hpp"
 
 namespace jansson {
 
+class JsonThreadPool;
+
+// Options controlling JsonSerializer output
+struct JsonSerializeOptions {
+    bool pretty_print = false;
+    int indent = 2;
+    
+    // No space after ',' and ':' (and none before ':' when pretty printing)
+    bool compact = false;
+    
+    // Write object members ordered by key (bytewise) instead of in
+    // insertion order. Objects that share a shape share one precomputed
+    // order, and larger objects keep theirs until they change, so dumping
+    // again does not sort again.
+    bool sort_keys = false;
+    
+    // RFC 8785 (JCS) canonical output, for signing and content addressing:
+    // no whitespace, members ordered by the UTF-16 code units of their
+    // keys and numbers written as ECMAScript writes them. Overrides
+    // pretty_print, compact, sort_keys and real_precision; a NaN or
+    // infinite number throws JsonException.
+    bool canonical = false;
+    
+    // Significant digits for reals (1-17); 0 selects the shortest
+    // representation that parses back to the same value
+    int real_precision = 0;
+    
+    // Arrays and objects with at least this many elements are split into
+    // ranges that are serialized concurrently and written out in order, so
+    // the output is identical to a sequential run. Only the outermost such
+    // container is split. 0 disables parallel serialization.
+    std::size_t parallel_threshold = 0;
+    
+    // Pool for parallel serialization; nullptr selects JsonThreadPool::shared().
+    // Must not be called from a task running on the same pool.
+    JsonThreadPool* pool = nullptr;
+};
+
 class JsonSerializer {
 public:
     // Serialize JSON value to string
@@ -14,14 +56,48 @@ public:
     
     // Serialize with formatting options
     static std::string serialize(const JsonValue& value, bool pretty_print, int indent = 2);
+    static std::string serialize(const JsonValue& value, const JsonSerializeOptions& options);
     
     // Serialize to stream
     static void serialize(std::ostream& os, const JsonValue& value, bool pretty_print = false, int indent = 2, int current_indent = 0);
+    static void serialize(std::ostream& os, const JsonValue& value, const JsonSerializeOptions& options, int current_indent = 0);
+    
+    // Serialize to a writer (string, fixed buffer, stream, ...)
+    static void serialize(JsonWriter& writer, const JsonValue& value, const JsonSerializeOptions& options = JsonSerializeOptions(), int current_indent = 0);
 
 private:
-    static void serialize_value(std::ostream& os, const JsonValue& value, bool pretty_print, int indent, int current_indent);
-    static void serialize_object(std::ostream& os, const JsonObject& object, bool pretty_print, int indent, int current_indent);
-    static void serialize_array(std::ostream& os, const JsonArray& array, bool pretty_print, int indent, int current_indent);
+    // Writes the same output piece by piece
+    friend class JsonStreamSerializer;
+    
+    // Options with canonical applied
+    static JsonSerializeOptions resolve(const JsonSerializeOptions& options);
+    
+    static void serialize_value(JsonWriter& writer, const JsonValue& value, const JsonSerializeOptions& options, int current_indent);
+    static void serialize_object(JsonWriter& writer, const JsonObject& object, const JsonSerializeOptions& options, int current_indent);
+    static void serialize_array(JsonWriter& writer, const JsonArray& array, const JsonSerializeOptions& options, int current_indent);
+    
+    // Write a container that caches its encoding: the cached text while it
+    // is current, otherwise a fresh serialization that replaces it
+    static void serialize_cached(JsonWriter& writer, const JsonValue& container, const JsonContainerState& state, const JsonSerializeOptions& options, int current_indent);
+    
+    // Objects without a shape up to this size are sorted in place on each
+    // dump rather than keeping a JsonKeyOrder
+    static constexpr std::size_t sorted_in_place = 8;
+    
+    // Positions of object's members in key order. Small objects are sorted
+    // into local (sorted_in_place entries); otherwise order holds the shared
+    // order the result points into.
+    static const std::uint32_t* member_order(const JsonObject& object, bool utf16, std::uint32_t* local, std::shared_ptr<const JsonKeyOrder>& order);
+    
+    // Fill positions with 0..object.size()-1 in key order
+    static void sort_members(const JsonObject& object, bool utf16, std::uint32_t* positions);
+    
+    // ',' between elements or members, as options lay it out
+    static void write_separator(JsonWriter& writer, const JsonSerializeOptions& options);
+    
+    // Write elements [begin, end) with their separators and indentation
+    static void serialize_elements(JsonWriter& writer, const JsonArray& array, std::size_t begin, std::size_t end, const JsonSerializeOptions& options, int current_indent);
+    static void serialize_member(JsonWriter& writer, std::string_view key, const JsonValue& value, bool first, const JsonSerializeOptions& options, int current_indent);
 };
 
 } // namespace jansson
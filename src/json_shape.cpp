@@ -0,0 +1,93 @@
+#include "json_shape.hpp"
+
+namespace jansson {
+
+// JsonShape implementation
+std::size_t JsonShape::slot_of(std::string_view key) const {
+    auto it = slots_.find(key);
+    return it == slots_.end() ? npos : it->second;
+}
+
+bool JsonShape::matches(const JsonObject& object) const noexcept {
+    const auto& members = object.values();
+    if (members.size() != keys_.size()) {
+        return false;
+    }
+    auto member = members.begin();
+    for (const auto& key : keys_) {
+        if (!(member->first == key)) {
+            return false;
+        }
+        ++member;
+    }
+    return true;
+}
+
+// JsonShapeTable implementation
+static std::size_t layout_hash(const JsonObject& object) noexcept {
+    std::size_t hash = object.size();
+    for (const auto& member : object.values()) {
+        hash ^= member.first.hash() + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+std::shared_ptr<const JsonShape> JsonShapeTable::shape_of(const JsonObject& object) {
+    std::size_t hash = layout_hash(object);
+    if (synchronized_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return shape_of_locked(object, hash);
+    }
+    return shape_of_locked(object, hash);
+}
+
+std::shared_ptr<const JsonShape> JsonShapeTable::shape_of_locked(const JsonObject& object, std::size_t hash) {
+    auto range = shapes_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->matches(object)) {
+            return it->second;
+        }
+    }
+
+    auto shape = std::make_shared<JsonShape>();
+    shape->keys_.reserve(object.size());
+    shape->slots_.reserve(object.size());
+    for (const auto& member : object.values()) {
+        shape->slots_.try_emplace(member.first, static_cast<std::uint32_t>(shape->keys_.size()));
+        shape->keys_.push_back(member.first);
+    }
+    shape->index_ = shape->slots_.share_index();
+    std::vector<std::string_view> keys(shape->keys_.begin(), shape->keys_.end());
+    shape->order_ = std::make_shared<JsonKeyOrder>(keys);
+    shapes_.emplace(hash, shape);
+    return shape;
+}
+
+std::shared_ptr<const JsonShape> JsonShapeTable::assign(JsonObject& object) {
+    auto shape = shape_of(object);
+    object.adopt_shape(shape);
+    return shape;
+}
+
+std::size_t JsonShapeTable::size() const {
+    if (synchronized_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return shapes_.size();
+    }
+    return shapes_.size();
+}
+
+void JsonShapeTable::clear() {
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    if (synchronized_) {
+        lock.lock();
+    }
+    shapes_.clear();
+}
+
+JsonShapeTable& JsonShapeTable::global() {
+    static JsonShapeTable table(true);
+    return table;
+}
+
+} // namespace jansson
@@ -0,0 +1,91 @@
+#ifndef JSON_SHAPE_HPP
+#define JSON_SHAPE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "json_hash.hpp"
+#include "json_key.hpp"
+#include "json_value.hpp"
+
+namespace jansson {
+
+// Ordered key layout shared by objects with the same member names in the
+// same order, in the manner of hidden classes in JavaScript engines.
+//
+// Objects that adopt a shape drop their own hash index and use the
+// shape's, so a record array pays for one index however many records it
+// holds. A member's position in the shape is its position in every object
+// of that shape: resolve it once with slot_of() and read each record with
+// JsonObject::slot(). Shapes are immutable and may be shared between
+// threads.
+class JsonShape {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t size() const noexcept { return keys_.size(); }
+    const JsonKey& key(std::size_t slot) const { return keys_[slot]; }
+    const std::vector<JsonKey>& keys() const noexcept { return keys_; }
+
+    // Position of key, or npos
+    std::size_t slot_of(std::string_view key) const;
+
+    // Whether object has exactly this key layout
+    bool matches(const JsonObject& object) const noexcept;
+
+    // Slots in key order, shared by every object of the shape
+    const std::shared_ptr<const JsonKeyOrder>& key_order() const noexcept { return order_; }
+
+private:
+    friend class JsonShapeTable;
+    friend class JsonObject;
+
+    std::vector<JsonKey> keys_;
+    JsonHash<JsonKey, std::uint32_t> slots_;
+
+    // Index handed to objects (null for shapes small enough to be
+    // searched linearly)
+    std::shared_ptr<const JsonHashIndex> index_;
+    std::shared_ptr<const JsonKeyOrder> order_;
+};
+
+// Registry that maps key layouts to shapes. A table may be shared between
+// threads only if it was created synchronized.
+class JsonShapeTable {
+public:
+    explicit JsonShapeTable(bool synchronized = false) : synchronized_(synchronized) {}
+
+    JsonShapeTable(const JsonShapeTable&) = delete;
+    JsonShapeTable& operator=(const JsonShapeTable&) = delete;
+
+    // Shape of object's current key layout, created on first use
+    std::shared_ptr<const JsonShape> shape_of(const JsonObject& object);
+
+    // Look up object's shape and make the object adopt it
+    std::shared_ptr<const JsonShape> assign(JsonObject& object);
+
+    // Number of distinct shapes held
+    std::size_t size() const;
+
+    bool synchronized() const noexcept { return synchronized_; }
+
+    void clear();
+
+    // Process-wide synchronized table
+    static JsonShapeTable& global();
+
+private:
+    std::shared_ptr<const JsonShape> shape_of_locked(const JsonObject& object, std::size_t hash);
+
+    bool synchronized_;
+    mutable std::mutex mutex_;
+    std::unordered_multimap<std::size_t, std::shared_ptr<const JsonShape>> shapes_;
+};
+
+} // namespace jansson
+
+#endif // JSON_SHAPE_HPP
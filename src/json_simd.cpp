@@ -0,0 +1,789 @@
+#include "json_simd.hpp"
+#include <array>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define JANSSON_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define JANSSON_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JANSSON_TARGET(isa) __attribute__((target(isa)))
+#else
+#define JANSSON_TARGET(isa)
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace jansson {
+namespace simd {
+
+namespace {
+
+constexpr std::size_t kBlockSize = 64;
+
+// Character classes of one 64-byte block, one bit per byte
+struct BlockMasks {
+    std::uint64_t quote = 0;
+    std::uint64_t backslash = 0;
+    std::uint64_t op = 0;
+    std::uint64_t whitespace = 0;
+};
+
+// State carried from one block to the next
+struct Stage1State {
+    bool prev_escaped = false;         // first byte of the block is escaped
+    std::uint64_t prev_in_string = 0;  // all ones if the block starts inside a string
+    std::uint64_t prev_boundary = 1;   // previous byte ends a token
+};
+
+inline int trailing_zeros(std::uint64_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Bit i of the result is the XOR of bits 0..i of x
+inline std::uint64_t prefix_xor(std::uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Mask of the bytes escaped by a preceding backslash. Backslashes are rare,
+// so only the set bits are visited.
+inline std::uint64_t escaped_mask(std::uint64_t backslash, bool& prev_escaped) {
+    std::uint64_t escaped = 0;
+    if (prev_escaped) {
+        escaped = 1;
+        backslash &= ~std::uint64_t(1);
+        prev_escaped = false;
+    }
+
+    while (backslash) {
+        int i = trailing_zeros(backslash);
+        if (i == 63) {
+            prev_escaped = true;
+            break;
+        }
+        escaped |= std::uint64_t(1) << (i + 1);
+        backslash &= ~(std::uint64_t(3) << i);
+    }
+
+    return escaped;
+}
+
+inline void process_block(const BlockMasks& masks, Stage1State& state, std::uint64_t valid,
+                          std::uint32_t base, std::vector<std::uint32_t>& index) {
+    std::uint64_t escaped = escaped_mask(masks.backslash, state.prev_escaped);
+    std::uint64_t quotes = masks.quote & ~escaped;
+
+    // Opening quotes and string contents are set, closing quotes are clear
+    std::uint64_t in_string = prefix_xor(quotes) ^ state.prev_in_string;
+    state.prev_in_string =
+        static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+
+    std::uint64_t op = masks.op & ~in_string;
+    std::uint64_t boundary = masks.op | masks.whitespace | quotes;
+    std::uint64_t scalar = ~(boundary | in_string);
+    std::uint64_t scalar_starts = scalar & ((boundary << 1) | state.prev_boundary);
+    state.prev_boundary = boundary >> 63;
+
+    std::uint64_t bits = (op | quotes | scalar_starts) & valid;
+    while (bits) {
+        index.push_back(base + static_cast<std::uint32_t>(trailing_zeros(bits)));
+        bits &= bits - 1;
+    }
+}
+
+enum : std::uint8_t {
+    kQuote = 1,
+    kBackslash = 2,
+    kOp = 4,
+    kWhitespace = 8
+};
+
+constexpr std::array<std::uint8_t, 256> make_class_table() {
+    std::array<std::uint8_t, 256> table{};
+    table['"'] = kQuote;
+    table['\\'] = kBackslash;
+    table['{'] = kOp;
+    table['}'] = kOp;
+    table['['] = kOp;
+    table[']'] = kOp;
+    table[':'] = kOp;
+    table[','] = kOp;
+    table[' '] = kWhitespace;
+    table['\t'] = kWhitespace;
+    table['\n'] = kWhitespace;
+    table['\r'] = kWhitespace;
+    return table;
+}
+
+constexpr std::array<std::uint8_t, 256> kClassTable = make_class_table();
+
+BlockMasks classify_scalar(const std::uint8_t* block) {
+    BlockMasks masks;
+    for (std::size_t i = 0; i < kBlockSize; ++i) {
+        std::uint8_t cls = kClassTable[block[i]];
+        std::uint64_t bit = std::uint64_t(1) << i;
+        if (cls & kQuote) masks.quote |= bit;
+        if (cls & kBackslash) masks.backslash |= bit;
+        if (cls & kOp) masks.op |= bit;
+        if (cls & kWhitespace) masks.whitespace |= bit;
+    }
+    return masks;
+}
+
+#if defined(JANSSON_SIMD_X86)
+
+// '[' | 0x20 == '{' and ']' | 0x20 == '}', so four compares cover the six
+// structural characters.
+JANSSON_TARGET("sse2")
+BlockMasks classify_sse2(const std::uint8_t* block) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i open_brace = _mm_set1_epi8('{');
+    const __m128i close_brace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+
+    BlockMasks masks;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i folded = _mm_or_si128(v, lower);
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, open_brace), _mm_cmpeq_epi8(folded, close_brace)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, cr)));
+
+        int shift = 16 * i;
+        masks.quote |= std::uint64_t(static_cast<std::uint16_t>(
+                           _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= std::uint64_t(static_cast<std::uint16_t>(
+                               _mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(op))) << shift;
+        masks.whitespace |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(ws)))
+                            << shift;
+    }
+    return masks;
+}
+
+JANSSON_TARGET("avx2")
+BlockMasks classify_avx2(const std::uint8_t* block) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i open_brace = _mm256_set1_epi8('{');
+    const __m256i close_brace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+
+    BlockMasks masks;
+    for (int i = 0; i < 2; ++i) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        __m256i folded = _mm256_or_si256(v, lower);
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, open_brace),
+                            _mm256_cmpeq_epi8(folded, close_brace)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, cr)));
+
+        int shift = 32 * i;
+        masks.quote |= std::uint64_t(static_cast<std::uint32_t>(
+                           _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= std::uint64_t(static_cast<std::uint32_t>(
+                               _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(op))) << shift;
+        masks.whitespace |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(ws)))
+                            << shift;
+    }
+    return masks;
+}
+
+#endif // JANSSON_SIMD_X86
+
+#if defined(JANSSON_SIMD_NEON)
+
+inline std::uint64_t neon_movemask(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d) {
+    const uint8x16_t bits = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                             0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(a, bits), vandq_u8(b, bits));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(c, bits), vandq_u8(d, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+BlockMasks classify_neon(const std::uint8_t* block) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t lower = vdupq_n_u8(0x20);
+    const uint8x16_t open_brace = vdupq_n_u8('{');
+    const uint8x16_t close_brace = vdupq_n_u8('}');
+    const uint8x16_t colon = vdupq_n_u8(':');
+    const uint8x16_t comma = vdupq_n_u8(',');
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8x16_t cr = vdupq_n_u8('\r');
+
+    uint8x16_t q[4], bs[4], op[4], ws[4];
+    for (int i = 0; i < 4; ++i) {
+        uint8x16_t v = vld1q_u8(block + 16 * i);
+        uint8x16_t folded = vorrq_u8(v, lower);
+        q[i] = vceqq_u8(v, quote);
+        bs[i] = vceqq_u8(v, backslash);
+        op[i] = vorrq_u8(vorrq_u8(vceqq_u8(folded, open_brace), vceqq_u8(folded, close_brace)),
+                         vorrq_u8(vceqq_u8(v, colon), vceqq_u8(v, comma)));
+        ws[i] = vorrq_u8(vorrq_u8(vceqq_u8(v, space), vceqq_u8(v, tab)),
+                         vorrq_u8(vceqq_u8(v, newline), vceqq_u8(v, cr)));
+    }
+
+    BlockMasks masks;
+    masks.quote = neon_movemask(q[0], q[1], q[2], q[3]);
+    masks.backslash = neon_movemask(bs[0], bs[1], bs[2], bs[3]);
+    masks.op = neon_movemask(op[0], op[1], op[2], op[3]);
+    masks.whitespace = neon_movemask(ws[0], ws[1], ws[2], ws[3]);
+    return masks;
+}
+
+#endif // JANSSON_SIMD_NEON
+
+using ClassifyFn = BlockMasks (*)(const std::uint8_t*);
+
+ClassifyFn classifier_for(Isa isa) {
+    switch (isa) {
+#if defined(JANSSON_SIMD_X86)
+        case Isa::Sse2: return classify_sse2;
+        case Isa::Avx2: return classify_avx2;
+#endif
+#if defined(JANSSON_SIMD_NEON)
+        case Isa::Neon: return classify_neon;
+#endif
+        default: return classify_scalar;
+    }
+}
+
+// String kernels: find the first byte that needs escaping, and validate
+// UTF-8. Each ISA has a kernel; find_escape() and validate_utf8() resolve
+// the right one once.
+
+inline bool needs_escape(std::uint8_t c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+std::size_t find_escape_scalar(const char* data, std::size_t length) {
+    const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(data);
+    for (std::size_t i = 0; i < length; ++i) {
+        if (needs_escape(bytes[i])) {
+            return i;
+        }
+    }
+    return length;
+}
+
+// Length of the all-ASCII prefix, tested eight bytes at a time
+std::size_t ascii_prefix_scalar(const std::uint8_t* data, std::size_t length) {
+    std::size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if (word & UINT64_C(0x8080808080808080)) {
+            break;
+        }
+    }
+    while (i < length && data[i] < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+// Validate one multi-byte sequence starting at data[i]. Returns its length,
+// or 0 if it is malformed.
+std::size_t utf8_sequence_length(const std::uint8_t* data, std::size_t i, std::size_t length) {
+    std::uint8_t byte = data[i];
+    std::size_t count;
+    std::uint32_t code_point;
+    if (byte >= 0xC2 && byte <= 0xDF) {
+        count = 2;
+        code_point = byte & 0x1F;
+    } else if ((byte & 0xF0) == 0xE0) {
+        count = 3;
+        code_point = byte & 0x0F;
+    } else if (byte >= 0xF0 && byte <= 0xF4) {
+        count = 4;
+        code_point = byte & 0x07;
+    } else {
+        return 0;
+    }
+
+    if (length - i < count) {
+        return 0;
+    }
+    for (std::size_t j = 1; j < count; ++j) {
+        if ((data[i + j] & 0xC0) != 0x80) {
+            return 0;
+        }
+        code_point = (code_point << 6) | (data[i + j] & 0x3F);
+    }
+
+    if (count == 3 && (code_point < 0x800 || (code_point >= 0xD800 && code_point <= 0xDFFF))) {
+        return 0;
+    }
+    if (count == 4 && (code_point < 0x10000 || code_point > 0x10FFFF)) {
+        return 0;
+    }
+    return count;
+}
+
+using AsciiPrefixFn = std::size_t (*)(const std::uint8_t*, std::size_t);
+
+// Scalar validation that skips ASCII runs with the given kernel
+std::size_t find_invalid_utf8_with(const std::uint8_t* data, std::size_t length,
+                                   AsciiPrefixFn ascii_prefix) {
+    std::size_t i = 0;
+    while (i < length) {
+        if (data[i] < 0x80) {
+            i += ascii_prefix(data + i, length - i);
+            continue;
+        }
+        std::size_t count = utf8_sequence_length(data, i, length);
+        if (count == 0) {
+            return i;
+        }
+        i += count;
+    }
+    return std::string_view::npos;
+}
+
+bool validate_utf8_scalar(const std::uint8_t* data, std::size_t length) {
+    return find_invalid_utf8_with(data, length, ascii_prefix_scalar) == std::string_view::npos;
+}
+
+#if defined(JANSSON_SIMD_X86)
+
+JANSSON_TARGET("sse2")
+std::size_t find_escape_sse2(const char* data, std::size_t length) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(static_cast<char>(0xE0));
+    const __m128i zero = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmpeq_epi8(_mm_and_si128(v, control), zero));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return i + static_cast<std::size_t>(trailing_zeros(static_cast<std::uint64_t>(mask)));
+        }
+    }
+    return i + find_escape_scalar(data + i, length - i);
+}
+
+JANSSON_TARGET("sse2")
+std::size_t ascii_prefix_sse2(const std::uint8_t* data, std::size_t length) {
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int mask = _mm_movemask_epi8(v);
+        if (mask != 0) {
+            return i + static_cast<std::size_t>(trailing_zeros(static_cast<std::uint64_t>(mask)));
+        }
+    }
+    return i + ascii_prefix_scalar(data + i, length - i);
+}
+
+bool validate_utf8_sse2(const std::uint8_t* data, std::size_t length) {
+    return find_invalid_utf8_with(data, length, ascii_prefix_sse2) == std::string_view::npos;
+}
+
+JANSSON_TARGET("avx2")
+std::size_t find_escape_avx2(const char* data, std::size_t length) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(static_cast<char>(0xE0));
+    const __m256i zero = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpeq_epi8(_mm256_and_si256(v, control), zero));
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(special));
+        if (mask != 0) {
+            return i + static_cast<std::size_t>(trailing_zeros(mask));
+        }
+    }
+    return i + find_escape_sse2(data + i, length - i);
+}
+
+// UTF-8 validation after Keiser and Lemire, "Validating UTF-8 In Less Than
+// One Instruction Per Byte". Each byte is classified by table lookups on the
+// high nibble of the previous byte, the low nibble of the previous byte and
+// the high nibble of the current byte; the three lookups are ANDed, so a
+// bit survives only if all three agree on an error. Three- and four-byte
+// sequences are then checked by looking two and three bytes back.
+enum : std::uint8_t {
+    kTooShort = 1 << 0,      // lead byte followed by a non-continuation
+    kTooLong = 1 << 1,       // ASCII followed by a continuation
+    kOverlong3 = 1 << 2,     // E0 followed by 80..9F
+    kTooLarge = 1 << 3,      // F4 followed by 90..BF, or F5..FF
+    kSurrogate = 1 << 4,     // ED followed by A0..BF
+    kOverlong2 = 1 << 5,     // C0 or C1
+    kTooLarge1000 = 1 << 6,  // F5..FF followed by 80..8F
+    kOverlong4 = 1 << 6,     // F0 followed by 80..8F
+    kTwoConts = 1 << 7,      // two continuations in a row
+    kCarry = kTooShort | kTooLong | kTwoConts
+};
+
+JANSSON_TARGET("avx2")
+inline __m256i lookup16(__m256i table, __m256i nibbles) {
+    return _mm256_shuffle_epi8(table, nibbles);
+}
+
+JANSSON_TARGET("avx2")
+inline __m256i high_nibbles(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+// The input shifted back by N bytes, with the tail of prev shifted in
+template <int N>
+JANSSON_TARGET("avx2")
+inline __m256i previous(__m256i input, __m256i prev) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+
+JANSSON_TARGET("avx2")
+__m256i utf8_block_errors(__m256i input, __m256i prev_input) {
+    const __m256i byte_1_high_table = _mm256_setr_epi8(
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+    const __m256i byte_1_low_table = _mm256_setr_epi8(
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000);
+    const __m256i byte_2_high_table = _mm256_setr_epi8(
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort);
+
+    __m256i prev1 = previous<1>(input, prev_input);
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(lookup16(byte_1_high_table, high_nibbles(prev1)),
+                         lookup16(byte_1_low_table, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+        lookup16(byte_2_high_table, high_nibbles(input)));
+
+    // Bytes two or three after a three- or four-byte lead must be
+    // continuations; those are the only places kTwoConts is expected.
+    __m256i prev2 = previous<2>(input, prev_input);
+    __m256i prev3 = previous<3>(input, prev_input);
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                                    _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must_be_continuation, special);
+}
+
+// Non-zero if the block ends in the middle of a multi-byte sequence
+JANSSON_TARGET("avx2")
+__m256i utf8_incomplete(__m256i input) {
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+    return _mm256_subs_epu8(input, max_value);
+}
+
+JANSSON_TARGET("avx2")
+bool validate_utf8_avx2(const std::uint8_t* data, std::size_t length) {
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        if (_mm256_movemask_epi8(input) == 0) {
+            // All ASCII: only a sequence left open by the previous block
+            // can be an error
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            error = _mm256_or_si256(error, utf8_block_errors(input, prev_input));
+            prev_incomplete = utf8_incomplete(input);
+        }
+        prev_input = input;
+    }
+
+    if (i < length) {
+        // Pad the tail with ASCII, which terminates any open sequence
+        alignas(32) std::uint8_t tail[32] = {};
+        std::memcpy(tail, data + i, length - i);
+        __m256i input = _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+        error = _mm256_or_si256(error, utf8_block_errors(input, prev_input));
+    } else {
+        error = _mm256_or_si256(error, prev_incomplete);
+    }
+
+    return _mm256_testz_si256(error, error) != 0;
+}
+
+#endif // JANSSON_SIMD_X86
+
+#if defined(JANSSON_SIMD_NEON)
+
+std::size_t find_escape_neon(const char* data, std::size_t length) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x20);
+
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + i));
+        uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                      vcltq_u8(v, control));
+        if (vmaxvq_u8(special) != 0) {
+            return i + find_escape_scalar(data + i, 16);
+        }
+    }
+    return i + find_escape_scalar(data + i, length - i);
+}
+
+std::size_t ascii_prefix_neon(const std::uint8_t* data, std::size_t length) {
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(data + i)) >= 0x80) {
+            break;
+        }
+    }
+    return i + ascii_prefix_scalar(data + i, length - i);
+}
+
+bool validate_utf8_neon(const std::uint8_t* data, std::size_t length) {
+    return find_invalid_utf8_with(data, length, ascii_prefix_neon) == std::string_view::npos;
+}
+
+#endif // JANSSON_SIMD_NEON
+
+using FindEscapeFn = std::size_t (*)(const char*, std::size_t);
+using ValidateUtf8Fn = bool (*)(const std::uint8_t*, std::size_t);
+
+FindEscapeFn find_escape_for(Isa isa) {
+    switch (isa) {
+#if defined(JANSSON_SIMD_X86)
+        case Isa::Sse2: return find_escape_sse2;
+        case Isa::Avx2: return find_escape_avx2;
+#endif
+#if defined(JANSSON_SIMD_NEON)
+        case Isa::Neon: return find_escape_neon;
+#endif
+        default: return find_escape_scalar;
+    }
+}
+
+ValidateUtf8Fn validate_utf8_for(Isa isa) {
+    switch (isa) {
+#if defined(JANSSON_SIMD_X86)
+        case Isa::Sse2: return validate_utf8_sse2;
+        case Isa::Avx2: return validate_utf8_avx2;
+#endif
+#if defined(JANSSON_SIMD_NEON)
+        case Isa::Neon: return validate_utf8_neon;
+#endif
+        default: return validate_utf8_scalar;
+    }
+}
+
+Isa detect_isa() noexcept {
+#if defined(JANSSON_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Isa::Sse2;
+    }
+    return Isa::Scalar;
+#elif defined(JANSSON_SIMD_X86)
+    return Isa::Sse2;
+#elif defined(JANSSON_SIMD_NEON)
+    return Isa::Neon;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+} // namespace
+
+Isa active_isa() noexcept {
+    static const Isa isa = detect_isa();
+    return isa;
+}
+
+bool is_supported(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+        case Isa::Sse2:
+            return active_isa() == Isa::Sse2 || active_isa() == Isa::Avx2;
+        case Isa::Avx2:
+            return active_isa() == Isa::Avx2;
+        case Isa::Neon:
+            return active_isa() == Isa::Neon;
+    }
+    return false;
+}
+
+const char* isa_name(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse2: return "sse2";
+        case Isa::Avx2: return "avx2";
+        case Isa::Neon: return "neon";
+    }
+    return "unknown";
+}
+
+bool build_structural_index(std::string_view input, std::vector<std::uint32_t>& index) {
+    return build_structural_index(input, index, active_isa());
+}
+
+bool build_structural_index(std::string_view input, std::vector<std::uint32_t>& index,
+                            Isa isa) {
+    index.clear();
+    if (input.length() > std::numeric_limits<std::uint32_t>::max()) {
+        return false;
+    }
+
+    ClassifyFn classify = classifier_for(is_supported(isa) ? isa : Isa::Scalar);
+    const std::uint8_t* data = reinterpret_cast<const std::uint8_t*>(input.data());
+    std::size_t length = input.length();
+    index.reserve(length / 8 + 16);
+
+    Stage1State state;
+    std::size_t offset = 0;
+    for (; offset + kBlockSize <= length; offset += kBlockSize) {
+        process_block(classify(data + offset), state, ~std::uint64_t(0),
+                      static_cast<std::uint32_t>(offset), index);
+    }
+
+    if (offset < length) {
+        // Pad the tail with whitespace, which is never indexed
+        std::uint8_t tail[kBlockSize];
+        std::size_t remaining = length - offset;
+        std::memset(tail, ' ', kBlockSize);
+        std::memcpy(tail, data + offset, remaining);
+        std::uint64_t valid = (std::uint64_t(1) << remaining) - 1;
+        process_block(classify(tail), state, valid, static_cast<std::uint32_t>(offset), index);
+    }
+
+    return state.prev_in_string == 0;
+}
+
+std::size_t find_escape(const char* data, std::size_t length) noexcept {
+    static const FindEscapeFn kernel = find_escape_for(active_isa());
+    return kernel(data, length);
+}
+
+std::size_t find_escape(const char* data, std::size_t length, Isa isa) noexcept {
+    return find_escape_for(is_supported(isa) ? isa : Isa::Scalar)(data, length);
+}
+
+bool validate_utf8(std::string_view input) noexcept {
+    static const ValidateUtf8Fn kernel = validate_utf8_for(active_isa());
+    return kernel(reinterpret_cast<const std::uint8_t*>(input.data()), input.length());
+}
+
+bool validate_utf8(std::string_view input, Isa isa) noexcept {
+    return validate_utf8_for(is_supported(isa) ? isa : Isa::Scalar)(
+        reinterpret_cast<const std::uint8_t*>(input.data()), input.length());
+}
+
+std::size_t find_invalid_utf8(std::string_view input) noexcept {
+    return find_invalid_utf8_with(reinterpret_cast<const std::uint8_t*>(input.data()),
+                                  input.length(), ascii_prefix_scalar);
+}
+
+} // namespace simd
+} // namespace jansson
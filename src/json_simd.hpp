@@ -0,0 +1,59 @@
+#ifndef JSON_SIMD_HPP
+#define JSON_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace jansson {
+namespace simd {
+
+// Instruction sets the vectorized kernels are compiled for
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon
+};
+
+// Best instruction set supported by the running CPU (detected once)
+Isa active_isa() noexcept;
+
+// Whether the given instruction set can be used on the running CPU
+bool is_supported(Isa isa) noexcept;
+
+// Name of an instruction set, for diagnostics
+const char* isa_name(Isa isa) noexcept;
+
+// Stage 1: build the structural index of a JSON document.
+//
+// The index holds, in increasing order, the byte offset of every
+// structural character ({ } [ ] : ,) outside of strings, of both the
+// opening and closing quote of every string, and of the first byte of
+// every scalar (number or literal). Whitespace and string contents are
+// never indexed, so the parser can jump from token to token.
+//
+// Returns false if the input ends inside a string or is too large to be
+// indexed with 32-bit offsets.
+bool build_structural_index(std::string_view input, std::vector<std::uint32_t>& index);
+bool build_structural_index(std::string_view input, std::vector<std::uint32_t>& index, Isa isa);
+
+// Offset of the first byte that must be escaped inside a JSON string
+// ('"', '\\' or a control character below 0x20), or length if there is none
+std::size_t find_escape(const char* data, std::size_t length) noexcept;
+std::size_t find_escape(const char* data, std::size_t length, Isa isa) noexcept;
+
+// Whether input is well-formed UTF-8 (no overlong forms, surrogates or
+// code points above U+10FFFF)
+bool validate_utf8(std::string_view input) noexcept;
+bool validate_utf8(std::string_view input, Isa isa) noexcept;
+
+// Offset of the first byte of the first malformed UTF-8 sequence, or
+// std::string_view::npos if the input is valid
+std::size_t find_invalid_utf8(std::string_view input) noexcept;
+
+} // namespace simd
+} // namespace jansson
+
+#endif // JSON_SIMD_HPP
@@ -0,0 +1,154 @@
+#include "json_stats.hpp"
+#include "json_value.hpp"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace jansson {
+
+#if JANSSON_STATS
+
+namespace stats_detail {
+
+Counters& counters() noexcept {
+    static Counters instance;
+    return instance;
+}
+
+void parsed(std::size_t bytes, std::uint64_t nanoseconds) noexcept {
+    Counters& c = counters();
+    c.parses.fetch_add(1, std::memory_order_relaxed);
+    c.parse_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    c.parse_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    raise(c.largest_parse_bytes, bytes);
+    if (JsonStatsObserver* observer = c.observer.load(std::memory_order_acquire)) {
+        observer->on_parse(bytes, nanoseconds);
+    }
+}
+
+void serialized(std::size_t bytes, std::uint64_t nanoseconds) noexcept {
+    Counters& c = counters();
+    c.serializations.fetch_add(1, std::memory_order_relaxed);
+    c.serialize_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    c.serialize_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    if (JsonStatsObserver* observer = c.observer.load(std::memory_order_acquire)) {
+        observer->on_serialize(bytes, nanoseconds);
+    }
+}
+
+} // namespace stats_detail
+
+JsonStats json_stats() noexcept {
+    const stats_detail::Counters& c = stats_detail::counters();
+    auto load = [](const std::atomic<std::uint64_t>& counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+    
+    JsonStats stats;
+    for (std::size_t i = 0; i < JsonStats::type_count; ++i) {
+        stats.nodes_created[i] = load(c.nodes_created[i]);
+        stats.nodes_destroyed[i] = load(c.nodes_destroyed[i]);
+    }
+    stats.allocations = load(c.allocations);
+    stats.frees = load(c.frees);
+    stats.bytes_allocated = load(c.bytes_allocated);
+    stats.bytes_in_use = load(c.bytes_in_use);
+    stats.peak_bytes_in_use = load(c.peak_bytes_in_use);
+    stats.parses = load(c.parses);
+    stats.parse_bytes = load(c.parse_bytes);
+    stats.parse_nanoseconds = load(c.parse_nanoseconds);
+    stats.largest_parse_bytes = load(c.largest_parse_bytes);
+    stats.serializations = load(c.serializations);
+    stats.serialize_bytes = load(c.serialize_bytes);
+    stats.serialize_nanoseconds = load(c.serialize_nanoseconds);
+    return stats;
+}
+
+void reset_json_stats() noexcept {
+    stats_detail::Counters& c = stats_detail::counters();
+    for (std::size_t i = 0; i < JsonStats::type_count; ++i) {
+        c.nodes_created[i].store(0, std::memory_order_relaxed);
+        c.nodes_destroyed[i].store(0, std::memory_order_relaxed);
+    }
+    for (auto* counter : {&c.allocations, &c.frees, &c.bytes_allocated, &c.parses, &c.parse_bytes,
+                          &c.parse_nanoseconds, &c.largest_parse_bytes, &c.serializations,
+                          &c.serialize_bytes, &c.serialize_nanoseconds}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    c.peak_bytes_in_use.store(c.bytes_in_use.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void set_json_stats_observer(JsonStatsObserver* observer) noexcept {
+    stats_detail::counters().observer.store(observer, std::memory_order_release);
+}
+
+#else
+
+JsonStats json_stats() noexcept {
+    return JsonStats();
+}
+
+void reset_json_stats() noexcept {}
+
+void set_json_stats_observer(JsonStatsObserver*) noexcept {}
+
+#endif
+
+std::size_t memory_usage(const JsonValue& root) {
+    // Capacity of a string held in place by an empty std::string
+    static const std::size_t inline_capacity = std::string().capacity();
+    
+    std::size_t bytes = 0;
+    std::vector<const JsonValue*> pending{&root};
+    std::unordered_set<const JsonValue*> shared;
+    while (!pending.empty()) {
+        const JsonValue* value = pending.back();
+        pending.pop_back();
+        if (value->reference_count() > 1 && !shared.insert(value).second) {
+            continue;
+        }
+        
+        switch (value->type()) {
+            case JsonType::Null:
+                bytes += sizeof(JsonNull);
+                break;
+            case JsonType::Boolean:
+                bytes += sizeof(JsonBoolean);
+                break;
+            case JsonType::Number:
+                bytes += sizeof(JsonNumber);
+                break;
+            case JsonType::String: {
+                bytes += sizeof(JsonStringValue);
+                const auto* string = static_cast<const JsonStringValue*>(value);
+                if (!string->is_borrowed() && string->value().capacity() > inline_capacity) {
+                    bytes += string->value().capacity() + 1;
+                }
+                break;
+            }
+            case JsonType::Array: {
+                const JsonValueVector& values = value->array_value();
+                bytes += sizeof(JsonArray) + values.capacity() * sizeof(JsonRef<JsonValue>);
+                for (const auto& element : values) {
+                    if (element) {
+                        pending.push_back(element.get());
+                    }
+                }
+                break;
+            }
+            case JsonType::Object: {
+                const JsonObjectMap& values = value->object_value();
+                bytes += sizeof(JsonObject) + values.storage_bytes();
+                for (const auto& entry : values) {
+                    if (entry.second) {
+                        pending.push_back(entry.second.get());
+                    }
+                }
+                break;
+            }
+        }
+    }
+    return bytes;
+}
+
+} // namespace jansson
@@ -0,0 +1,165 @@
+#ifndef JSON_STATS_HPP
+#define JSON_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Library-wide counters are kept when the library is built with
+// JANSSON_STATS=1 (the CMake option of the same name). Otherwise every hook
+// below is an empty inline function, json_stats() returns zeros and the
+// instrumentation costs nothing.
+#ifndef JANSSON_STATS
+#define JANSSON_STATS 0
+#endif
+
+namespace jansson {
+
+class JsonValue;
+
+// Snapshot of the library's counters. Node counts are indexed by JsonType.
+// Bytes are those requested through the allocation functions (see
+// set_allocation_functions): nodes, container storage, key records, arena
+// blocks and json_malloc blocks. std::string contents are not included.
+struct JsonStats {
+    static constexpr std::size_t type_count = 6;
+
+    std::uint64_t nodes_created[type_count] = {};
+    std::uint64_t nodes_destroyed[type_count] = {};
+
+    std::uint64_t allocations = 0;
+    std::uint64_t frees = 0;
+    std::uint64_t bytes_allocated = 0;
+    std::uint64_t bytes_in_use = 0;
+    std::uint64_t peak_bytes_in_use = 0;
+
+    // Completed parses and serializations: how many, their total size and
+    // duration, and the largest input parsed
+    std::uint64_t parses = 0;
+    std::uint64_t parse_bytes = 0;
+    std::uint64_t parse_nanoseconds = 0;
+    std::uint64_t largest_parse_bytes = 0;
+    std::uint64_t serializations = 0;
+    std::uint64_t serialize_bytes = 0;
+    std::uint64_t serialize_nanoseconds = 0;
+};
+
+// Receives every completed parse and serialization, on the thread that ran
+// it, so callers can feed their own metrics. Only called in stats builds.
+class JsonStatsObserver {
+public:
+    virtual ~JsonStatsObserver() = default;
+
+    virtual void on_parse(std::size_t /*bytes*/, std::uint64_t /*nanoseconds*/) {}
+    virtual void on_serialize(std::size_t /*bytes*/, std::uint64_t /*nanoseconds*/) {}
+};
+
+constexpr bool json_stats_enabled = JANSSON_STATS != 0;
+
+JsonStats json_stats() noexcept;
+
+// Zero the counters. bytes_in_use is kept, since that memory is still in
+// use, and the peak restarts from it.
+void reset_json_stats() noexcept;
+
+// Install an observer (null removes it). It must stay valid until removed.
+void set_json_stats_observer(JsonStatsObserver* observer) noexcept;
+
+// Bytes held by the tree under root: nodes, array and object storage, and
+// string contents too long to live inside their node. A node shared within
+// the tree is counted once; interned keys and borrowed string bytes are not
+// counted. Available in every build.
+std::size_t memory_usage(const JsonValue& root);
+
+namespace stats_detail {
+
+#if JANSSON_STATS
+
+struct Counters {
+    std::atomic<std::uint64_t> nodes_created[JsonStats::type_count] = {};
+    std::atomic<std::uint64_t> nodes_destroyed[JsonStats::type_count] = {};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> frees{0};
+    std::atomic<std::uint64_t> bytes_allocated{0};
+    std::atomic<std::uint64_t> bytes_in_use{0};
+    std::atomic<std::uint64_t> peak_bytes_in_use{0};
+    std::atomic<std::uint64_t> parses{0};
+    std::atomic<std::uint64_t> parse_bytes{0};
+    std::atomic<std::uint64_t> parse_nanoseconds{0};
+    std::atomic<std::uint64_t> largest_parse_bytes{0};
+    std::atomic<std::uint64_t> serializations{0};
+    std::atomic<std::uint64_t> serialize_bytes{0};
+    std::atomic<std::uint64_t> serialize_nanoseconds{0};
+    std::atomic<JsonStatsObserver*> observer{nullptr};
+};
+
+Counters& counters() noexcept;
+
+inline void raise(std::atomic<std::uint64_t>& maximum, std::uint64_t value) noexcept {
+    std::uint64_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+inline void node_created(std::uint8_t type) noexcept {
+    counters().nodes_created[type].fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void node_destroyed(std::uint8_t type) noexcept {
+    counters().nodes_destroyed[type].fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void allocated(std::size_t bytes) noexcept {
+    Counters& c = counters();
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+    raise(c.peak_bytes_in_use, c.bytes_in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+inline void freed(std::size_t bytes) noexcept {
+    Counters& c = counters();
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void parsed(std::size_t bytes, std::uint64_t nanoseconds) noexcept;
+void serialized(std::size_t bytes, std::uint64_t nanoseconds) noexcept;
+
+// Times one parse or serialization from construction to finish()
+class Timer {
+public:
+    Timer() noexcept : start_(std::chrono::steady_clock::now()) {}
+
+    std::uint64_t elapsed() const noexcept {
+        auto duration = std::chrono::steady_clock::now() - start_;
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    void finish_parse(std::size_t bytes) const noexcept { parsed(bytes, elapsed()); }
+    void finish_serialize(std::size_t bytes) const noexcept { serialized(bytes, elapsed()); }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+#else
+
+inline void node_created(std::uint8_t) noexcept {}
+inline void node_destroyed(std::uint8_t) noexcept {}
+inline void allocated(std::size_t) noexcept {}
+inline void freed(std::size_t) noexcept {}
+
+class Timer {
+public:
+    void finish_parse(std::size_t) const noexcept {}
+    void finish_serialize(std::size_t) const noexcept {}
+};
+
+#endif
+
+} // namespace stats_detail
+
+} // namespace jansson
+
+#endif // JSON_STATS_HPP
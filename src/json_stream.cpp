@@ -0,0 +1,497 @@
+#include "json_stream.hpp"
+#include "json_parser.hpp"
+#include "json_simd.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace jansson {
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static bool is_literal_char(char c) {
+    return c >= 'a' && c <= 'z';
+}
+
+static std::size_t limit(std::size_t value) {
+    return value != 0 ? value : SIZE_MAX;
+}
+
+JsonStreamParser::JsonStreamParser() : JsonStreamParser(JsonParseOptions()) {}
+
+JsonStreamParser::JsonStreamParser(const JsonParseOptions& options)
+    : max_depth_(limit(options.max_depth)),
+      max_nodes_(limit(options.max_nodes)),
+      max_string_length_(limit(options.max_string_length)),
+      max_input_size_(limit(options.max_input_size)) {}
+
+Result<std::size_t> JsonStreamParser::feed(std::string_view chunk) {
+    if (failed_) {
+        return Result<std::size_t>(make_error_code(error_code_));
+    }
+
+    const char* data = chunk.data();
+    std::size_t length = chunk.size();
+    std::size_t before = completed_;
+    std::size_t pos = 0;
+
+    try {
+        while (pos < length) {
+            check_input_size(pos);
+            if (token_ != Token::None) {
+                pos = continue_token(data, pos, length);
+                continue;
+            }
+
+            char c = data[pos];
+            if (is_whitespace(c)) {
+                pos++;
+                continue;
+            }
+
+            switch (state_) {
+                case State::Value:
+                    start_value(c);
+                    break;
+                case State::ArrayFirst:
+                    if (c == ']') {
+                        close_container();
+                    } else {
+                        start_value(c);
+                    }
+                    break;
+                case State::ArrayNext:
+                    if (c == ',') {
+                        state_ = State::Value;
+                    } else if (c == ']') {
+                        close_container();
+                    } else {
+                        fail("Expected ',' or ']' in array");
+                    }
+                    break;
+                case State::ObjectFirstKey:
+                case State::ObjectKey:
+                    if (c == '"') {
+                        token_ = Token::Key;
+                        buffer_.assign(1, c);
+                    } else if (c == '}' && state_ == State::ObjectFirstKey) {
+                        close_container();
+                    } else {
+                        fail("Expected string key in object");
+                    }
+                    break;
+                case State::ObjectColon:
+                    if (c != ':') {
+                        fail("Expected ':' in object");
+                    }
+                    state_ = State::Value;
+                    break;
+                case State::ObjectNext:
+                    if (c == ',') {
+                        state_ = State::ObjectKey;
+                    } else if (c == '}') {
+                        close_container();
+                    } else {
+                        fail("Expected ',' or '}' in object");
+                    }
+                    break;
+            }
+            pos++;
+        }
+        check_input_size(pos);
+    } catch (const JsonException& e) {
+        failed_ = true;
+        error_message_ = e.what();
+        consumed_ += pos;
+        return Result<std::size_t>(make_error_code(error_code_));
+    }
+
+    consumed_ += length;
+    return Result<std::size_t>(completed_ - before);
+}
+
+Result<std::size_t> JsonStreamParser::finish() {
+    if (failed_) {
+        return Result<std::size_t>(make_error_code(error_code_));
+    }
+
+    std::size_t before = completed_;
+    try {
+        // Numbers and literals only end at a delimiter; the end of input is one
+        if (token_ == Token::Number || token_ == Token::Literal) {
+            complete_token();
+        }
+        if (in_value()) {
+            fail("Unexpected end of input");
+        }
+    } catch (const JsonException& e) {
+        failed_ = true;
+        error_message_ = e.what();
+        return Result<std::size_t>(make_error_code(error_code_));
+    }
+
+    return Result<std::size_t>(completed_ - before);
+}
+
+JsonRef<JsonValue> JsonStreamParser::take_value() {
+    if (values_.empty()) {
+        return nullptr;
+    }
+    auto value = std::move(values_.front());
+    values_.pop_front();
+    return value;
+}
+
+void JsonStreamParser::reset() {
+    state_ = State::Value;
+    token_ = Token::None;
+    escape_pending_ = false;
+    failed_ = false;
+    buffer_.clear();
+    stack_.clear();
+    values_.clear();
+    keys_.clear();
+    consumed_ = 0;
+    completed_ = 0;
+    error_message_.clear();
+    error_code_ = JsonErrorCode::ParseError;
+    nodes_ = 0;
+    value_begin_ = 0;
+}
+
+// Input counts from the first byte of a top-level value. Checked between
+// tokens and at the end of each chunk, so a long token is bounded by the
+// chunk holding it.
+void JsonStreamParser::check_input_size(std::size_t pos) {
+    std::size_t offset = consumed_ + pos;
+    if (!in_value()) {
+        value_begin_ = offset;
+    } else if (offset - value_begin_ > max_input_size_) {
+        fail("Input too large", JsonErrorCode::LimitExceeded);
+    }
+}
+
+// Append as much of the current token as this chunk holds. Returns the
+// position of the first byte not consumed.
+std::size_t JsonStreamParser::continue_token(const char* data, std::size_t pos,
+                                             std::size_t length) {
+    if (token_ == Token::String || token_ == Token::Key) {
+        while (pos < length) {
+            if (escape_pending_) {
+                buffer_ += data[pos++];
+                escape_pending_ = false;
+                continue;
+            }
+
+            // Copy the run up to the next quote, backslash or control byte
+            std::size_t run = simd::find_escape(data + pos, length - pos);
+            buffer_.append(data + pos, run);
+            pos += run;
+            // An escape decodes to at least one byte per six, so a longer
+            // token cannot fit the string length limit
+            if ((buffer_.size() - 1) / 6 > max_string_length_) {
+                fail("String too long", JsonErrorCode::LimitExceeded);
+            }
+            if (pos == length) {
+                break;
+            }
+
+            char c = data[pos++];
+            buffer_ += c;
+            if (c == '\\') {
+                escape_pending_ = true;
+            } else if (c == '"') {
+                complete_token();
+                break;
+            }
+            // Control characters are rejected when the token is decoded
+        }
+        return pos;
+    }
+
+    bool (*accepts)(char) = token_ == Token::Number ? is_number_char : is_literal_char;
+    std::size_t start = pos;
+    while (pos < length && accepts(data[pos])) {
+        pos++;
+    }
+    buffer_.append(data + start, pos - start);
+    if (pos < length) {
+        // The delimiter is processed by the caller
+        complete_token();
+    }
+    return pos;
+}
+
+// Decode the buffered token with the DOM parser's tokenizer
+void JsonStreamParser::complete_token() {
+    Token token = token_;
+    token_ = Token::None;
+
+    JsonParser::ParseContext ctx;
+    ctx.input = buffer_;
+    ctx.position = 0;
+    ctx.max_string_length = max_string_length_;
+
+    JsonRef<JsonValue> value;
+    switch (token) {
+        case Token::String:
+        case Token::Key: {
+            if (!simd::validate_utf8(buffer_)) {
+                fail("Invalid UTF-8 sequence", JsonErrorCode::InvalidUTF8);
+            }
+            std::string text;
+            if (!JsonParser::parse_raw_string(ctx, text)) {
+                fail(ctx.error_message.c_str(), ctx.error_code);
+            }
+            if (token == Token::Key) {
+                stack_.back().key = keys_.intern(text);
+                state_ = State::ObjectColon;
+                return;
+            }
+            value = JsonStringValue::create(std::move(text));
+            break;
+        }
+        case Token::Number: {
+            JsonParser::NumberToken number;
+            if (!JsonParser::scan_number(ctx, number)) {
+                fail(ctx.error_message.c_str());
+            }
+            if (ctx.position != buffer_.size()) {
+                fail("Invalid number format");
+            }
+            if (number.is_integer) {
+                value = JsonNumber::create(number.integer);
+            } else {
+                value = JsonNumber::create(number.real);
+            }
+            break;
+        }
+        case Token::Literal:
+            if (buffer_ == "true") {
+                value = JsonBoolean::create(true);
+            } else if (buffer_ == "false") {
+                value = JsonBoolean::create(false);
+            } else if (buffer_ == "null") {
+                value = JsonNull::create();
+            } else {
+                fail("Invalid literal");
+            }
+            break;
+        case Token::None:
+            return;
+    }
+
+    add_value(std::move(value));
+}
+
+void JsonStreamParser::start_value(char c) {
+    if (++nodes_ > max_nodes_) {
+        fail("Too many values", JsonErrorCode::LimitExceeded);
+    }
+    if ((c == '{' || c == '[') && stack_.size() >= max_depth_) {
+        fail("Maximum nesting depth exceeded", JsonErrorCode::LimitExceeded);
+    }
+    switch (c) {
+        case '{':
+            stack_.push_back(Frame{JsonObject::create(), JsonKey()});
+            state_ = State::ObjectFirstKey;
+            return;
+        case '[':
+            stack_.push_back(Frame{JsonArray::create(), JsonKey()});
+            state_ = State::ArrayFirst;
+            return;
+        case '"':
+            token_ = Token::String;
+            buffer_.assign(1, c);
+            return;
+        case 't':
+        case 'f':
+        case 'n':
+            token_ = Token::Literal;
+            buffer_.assign(1, c);
+            return;
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                token_ = Token::Number;
+                buffer_.assign(1, c);
+                return;
+            }
+            fail("Unexpected character");
+    }
+}
+
+void JsonStreamParser::add_value(JsonRef<JsonValue> value) {
+    if (stack_.empty()) {
+        values_.push_back(std::move(value));
+        completed_++;
+        nodes_ = 0;
+        state_ = State::Value;
+        return;
+    }
+
+    Frame& frame = stack_.back();
+    if (frame.container->is_array()) {
+        static_cast<JsonArray&>(*frame.container).push_back(std::move(value));
+        state_ = State::ArrayNext;
+    } else {
+        static_cast<JsonObject&>(*frame.container).set(std::move(frame.key), std::move(value));
+        state_ = State::ObjectNext;
+    }
+}
+
+void JsonStreamParser::close_container() {
+    JsonRef<JsonValue> container = std::move(stack_.back().container);
+    stack_.pop_back();
+    add_value(std::move(container));
+}
+
+void JsonStreamParser::fail(const char* message, JsonErrorCode code) {
+    error_code_ = code;
+    throw JsonException(message);
+}
+
+// Output is produced in pieces of at least this size, so a reader asking
+// for a few bytes at a time does not step the walk once per call
+static constexpr std::size_t min_produce_bytes = 256;
+
+// The consumed part of the buffer is dropped once it is this large
+static constexpr std::size_t compact_threshold = 64 * 1024;
+
+JsonStreamSerializer::JsonStreamSerializer(JsonRef<JsonValue> value, const JsonSerializeOptions& options)
+    : root_(std::move(value)), options_(JsonSerializer::resolve(options)) {
+    if (!root_) {
+        throw JsonException("Cannot serialize a null reference");
+    }
+}
+
+std::string_view JsonStreamSerializer::peek(std::size_t wanted) {
+    wanted = std::max(wanted, std::size_t(1));
+    std::size_t target = std::max(wanted, min_produce_bytes);
+    if (pending_.view().size() - consumed_ < wanted) {
+        if (consumed_ >= compact_threshold || consumed_ == pending_.view().size()) {
+            // Keep only the unconsumed tail
+            std::string tail(pending_.view().substr(consumed_));
+            pending_.clear();
+            pending_.write(tail);
+            consumed_ = 0;
+        }
+        while (!finished_ && pending_.view().size() - consumed_ < target) {
+            step();
+        }
+    }
+    return pending_.view().substr(consumed_);
+}
+
+void JsonStreamSerializer::consume(std::size_t bytes) noexcept {
+    bytes = std::min(bytes, pending_.view().size() - consumed_);
+    consumed_ += bytes;
+    total_consumed_ += bytes;
+}
+
+std::size_t JsonStreamSerializer::read(char* buffer, std::size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    std::string_view available = peek(size);
+    std::size_t count = std::min(size, available.size());
+    std::memcpy(buffer, available.data(), count);
+    consume(count);
+    return count;
+}
+
+void JsonStreamSerializer::write_value(const JsonValue& value, int indent) {
+    bool open = (value.is_array() && !static_cast<const JsonArray&>(value).container_state().caches_encoding()) ||
+                (value.is_object() && !static_cast<const JsonObject&>(value).container_state().caches_encoding());
+    if (!open) {
+        // Scalars, and containers whose cached encoding is written whole
+        JsonSerializer::serialize_value(pending_, value, options_, indent);
+        return;
+    }
+    
+    Frame frame{&value, 0, 0, indent, sorted_.size(), nullptr};
+    if (value.is_array()) {
+        pending_.put('[');
+        frame.size = static_cast<const JsonArray&>(value).size();
+    } else {
+        const auto& object = static_cast<const JsonObject&>(value);
+        pending_.put('{');
+        frame.size = object.size();
+        if (options_.sort_keys) {
+            if (!object.shape() && object.size() <= JsonSerializer::sorted_in_place) {
+                sorted_.resize(frame.members + object.size());
+                JsonSerializer::sort_members(object, options_.canonical, sorted_.data() + frame.members);
+            } else {
+                frame.order = object.key_order();
+            }
+        }
+    }
+    if (options_.pretty_print) {
+        pending_.put('\n');
+    }
+    stack_.push_back(frame);
+}
+
+void JsonStreamSerializer::step() {
+    if (!started_) {
+        started_ = true;
+        write_value(*root_, 0);
+        finished_ = stack_.empty();
+        return;
+    }
+    
+    Frame& frame = stack_.back();
+    bool is_array = frame.container->is_array();
+    if (frame.index == frame.size) {
+        if (options_.pretty_print && frame.size != 0) {
+            pending_.put('\n');
+            pending_.fill(' ', static_cast<std::size_t>(frame.indent));
+        }
+        pending_.put(is_array ? ']' : '}');
+        if (!is_array && options_.sort_keys) {
+            sorted_.resize(frame.members);
+        }
+        stack_.pop_back();
+        finished_ = stack_.empty();
+        return;
+    }
+    
+    std::size_t index = frame.index++;
+    int inner = frame.indent + options_.indent;
+    if (index != 0) {
+        JsonSerializer::write_separator(pending_, options_);
+    }
+    if (options_.pretty_print) {
+        pending_.fill(' ', static_cast<std::size_t>(inner));
+    }
+    
+    const JsonValue* value;
+    if (is_array) {
+        value = static_cast<const JsonArray*>(frame.container)->begin()[index].get();
+    } else {
+        const auto& object = *static_cast<const JsonObject*>(frame.container);
+        std::size_t position = index;
+        if (options_.sort_keys) {
+            position = frame.order ? frame.order->positions(options_.canonical)[index]
+                                   : sorted_[frame.members + index];
+        }
+        const JsonObjectMap::value_type* member = &*(object.begin() + static_cast<std::ptrdiff_t>(position));
+        pending_.write_escaped(member->first.view());
+        if (options_.compact) {
+            pending_.put(':');
+        } else if (options_.pretty_print) {
+            pending_.write(" : ", 3);
+        } else {
+            pending_.write(": ", 2);
+        }
+        value = member->second.get();
+    }
+    // May push a frame, after which frame no longer refers to this one
+    write_value(*value, inner);
+}
+
+} // namespace jansson
@@ -0,0 +1,195 @@
+#ifndef JSON_STREAM_HPP
+#define JSON_STREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_key.hpp"
+#include "json_value.hpp"
+#include "json_error.hpp"
+#include "json_serializer.hpp"
+#include "json_writer.hpp"
+
+namespace jansson {
+
+struct JsonParseOptions;
+
+// Resumable push parser.
+//
+// Input arrives in chunks of any size through feed(); tokens and nesting
+// may be split anywhere between chunks. The tree is built as tokens
+// complete, and every finished top-level value is queued for take_value().
+// Concatenated values ("{...} {...}", one value per line, ...) are
+// accepted. Only the token in progress is buffered, never the whole input.
+//
+// After an error the parser rejects further input until reset().
+//
+// The limits of JsonParseOptions apply to each top-level value: max_depth
+// (2048 by default), max_nodes, max_string_length, and max_input_size,
+// counting the bytes from the end of the previous value. Failing one is
+// reported as LimitExceeded. Other options do not apply.
+class JsonStreamParser {
+public:
+    JsonStreamParser();
+    explicit JsonStreamParser(const JsonParseOptions& options);
+
+    JsonStreamParser(const JsonStreamParser&) = delete;
+    JsonStreamParser& operator=(const JsonStreamParser&) = delete;
+
+    // Consume a chunk. The value is the number of top-level values
+    // completed by this chunk.
+    Result<std::size_t> feed(std::string_view chunk);
+
+    // Signal the end of input: completes a trailing top-level number and
+    // fails if a value is still open. The value is the number of values
+    // completed by this call.
+    Result<std::size_t> finish();
+
+    // Completed values, in input order
+    bool has_value() const noexcept { return !values_.empty(); }
+    std::size_t value_count() const noexcept { return values_.size(); }
+    JsonRef<JsonValue> take_value();
+
+    // Whether a value has been started but not completed
+    bool in_value() const noexcept { return token_ != Token::None || !stack_.empty(); }
+
+    // Bytes accepted so far; after an error, the offset of the bad byte
+    std::size_t bytes_consumed() const noexcept { return consumed_; }
+
+    const std::string& error_message() const noexcept { return error_message_; }
+
+    // Discard all state, including queued values; the limits are kept
+    void reset();
+
+private:
+    // What the parser expects next, outside of a token
+    enum class State : std::uint8_t {
+        Value,          // a value (top level or after ',' / ':')
+        ArrayFirst,     // a value or ']'
+        ArrayNext,      // ',' or ']'
+        ObjectFirstKey, // a key or '}'
+        ObjectKey,      // a key
+        ObjectColon,    // ':'
+        ObjectNext      // ',' or '}'
+    };
+
+    // Token being accumulated across chunks
+    enum class Token : std::uint8_t {
+        None,
+        String,
+        Key,
+        Number,
+        Literal
+    };
+
+    struct Frame {
+        JsonRef<JsonValue> container;
+        JsonKey key;
+    };
+
+    std::size_t continue_token(const char* data, std::size_t pos, std::size_t length);
+    void complete_token();
+    void start_value(char c);
+    void add_value(JsonRef<JsonValue> value);
+    void close_container();
+    [[noreturn]] void fail(const char* message, JsonErrorCode code = JsonErrorCode::ParseError);
+    
+    // Fail if the value in progress has used more input than allowed
+    void check_input_size(std::size_t pos);
+
+    State state_ = State::Value;
+    Token token_ = Token::None;
+    bool escape_pending_ = false;
+    bool failed_ = false;
+    std::string buffer_;
+    std::vector<Frame> stack_;
+    std::deque<JsonRef<JsonValue>> values_;
+    
+    // Member names are interned across all values of the stream
+    JsonKeyTable keys_;
+    std::size_t consumed_ = 0;
+    std::size_t completed_ = 0;
+    std::string error_message_;
+    JsonErrorCode error_code_ = JsonErrorCode::ParseError;
+    
+    // Limits, with 0 in the options mapped to the largest value, and the
+    // values and input counted against them since the last top-level value
+    std::size_t max_depth_;
+    std::size_t max_nodes_;
+    std::size_t max_string_length_;
+    std::size_t max_input_size_;
+    std::size_t nodes_ = 0;
+    std::size_t value_begin_ = 0;
+};
+
+// Resumable pull serializer.
+//
+// The counterpart of JsonStreamParser: output is produced on demand, a
+// little more than each call asks for, by walking the tree with an
+// explicit stack, so a large document can be sent in pieces as the
+// destination accepts them without ever existing whole in memory. The
+// output is the same as JsonSerializer::serialize with the same options,
+// except that containers are never split for parallel serialization. The
+// tree must not change until the output is complete.
+class JsonStreamSerializer {
+public:
+    explicit JsonStreamSerializer(JsonRef<JsonValue> value,
+                                  const JsonSerializeOptions& options = JsonSerializeOptions());
+
+    JsonStreamSerializer(const JsonStreamSerializer&) = delete;
+    JsonStreamSerializer& operator=(const JsonStreamSerializer&) = delete;
+
+    // Output not yet consumed: at least wanted bytes unless less remains.
+    // Valid until the next call.
+    std::string_view peek(std::size_t wanted = JsonChunkedWriter::default_chunk_size);
+
+    // Mark the first bytes of peek() as delivered
+    void consume(std::size_t bytes) noexcept;
+
+    // Copy up to size bytes of output into buffer; 0 once all is read
+    std::size_t read(char* buffer, std::size_t size);
+
+    // Whether every byte has been consumed
+    bool done() const noexcept { return finished_ && consumed_ == pending_.view().size(); }
+
+    // Bytes consumed so far
+    std::size_t bytes_consumed() const noexcept { return total_consumed_; }
+
+private:
+    struct Frame {
+        const JsonValue* container;
+        std::size_t index;
+        std::size_t size;
+        int indent;
+        
+        // Where the container's sorted members start in sorted_, for a
+        // small object, or the shared order of a larger one
+        std::size_t members;
+        std::shared_ptr<const JsonKeyOrder> order;
+    };
+
+    // Write the next piece of output: one element, member or closing bracket
+    void step();
+    void write_value(const JsonValue& value, int indent);
+
+    JsonRef<JsonValue> root_;
+    JsonSerializeOptions options_;
+    std::vector<Frame> stack_;
+    
+    // Member positions of the open small objects in key order, when
+    // sorting keys
+    std::vector<std::uint32_t> sorted_;
+    JsonStringWriter pending_;
+    std::size_t consumed_ = 0;
+    std::size_t total_consumed_ = 0;
+    bool started_ = false;
+    bool finished_ = false;
+};
+
+} // namespace jansson
+
+#endif // JSON_STREAM_HPP
@@ -0,0 +1,107 @@
+#include "json_thread_pool.hpp"
+
+namespace jansson {
+
+// JsonThreadPool implementation
+JsonThreadPool::JsonThreadPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) {
+            threads = 1;
+        }
+    }
+
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+JsonThreadPool::~JsonThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void JsonThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    available_.notify_one();
+}
+
+bool JsonThreadPool::run_pending() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty()) {
+            return false;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+    }
+    task();
+    return true;
+}
+
+JsonThreadPool& JsonThreadPool::shared() {
+    static JsonThreadPool pool;
+    return pool;
+}
+
+void JsonThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            available_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+// JsonTaskGroup implementation
+void JsonTaskGroup::run(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_++;
+    }
+    pool_.submit([this, task = std::move(task)] {
+        task();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) {
+            done_.notify_all();
+        }
+    });
+}
+
+void JsonTaskGroup::wait() {
+    // Help with the queue, which holds this group's tasks not yet started.
+    // Once it is empty they are all running elsewhere.
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_ == 0) {
+                return;
+            }
+        }
+        if (!pool_.run_pending()) {
+            break;
+        }
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+} // namespace jansson
@@ -0,0 +1,71 @@
+#ifndef JSON_THREAD_POOL_HPP
+#define JSON_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jansson {
+
+// Fixed set of worker threads consuming a FIFO task queue. Workers live as
+// long as the pool, so batches submitted over time share the same threads.
+class JsonThreadPool {
+public:
+    // 0 selects std::thread::hardware_concurrency()
+    explicit JsonThreadPool(std::size_t threads = 0);
+    ~JsonThreadPool();
+
+    JsonThreadPool(const JsonThreadPool&) = delete;
+    JsonThreadPool& operator=(const JsonThreadPool&) = delete;
+
+    // Queue a task. Tasks must not throw.
+    void submit(std::function<void()> task);
+
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    // Run one queued task on the calling thread. Returns false when the
+    // queue is empty.
+    bool run_pending();
+
+    // Process-wide pool sized to the hardware, created on first use
+    static JsonThreadPool& shared();
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    bool stopping_ = false;
+};
+
+// Tasks submitted to a pool that can be waited for as a group
+class JsonTaskGroup {
+public:
+    explicit JsonTaskGroup(JsonThreadPool& pool) noexcept : pool_(pool) {}
+    ~JsonTaskGroup() { wait(); }
+
+    JsonTaskGroup(const JsonTaskGroup&) = delete;
+    JsonTaskGroup& operator=(const JsonTaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+
+    // Block until every task run so far has finished. Queued tasks of the
+    // pool are run meanwhile, so a task may wait for a group of its own.
+    void wait();
+
+private:
+    JsonThreadPool& pool_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::size_t pending_ = 0;
+};
+
+} // namespace jansson
+
+#endif // JSON_THREAD_POOL_HPP
@@ -1,209 +1,647 @@
 #include "json_value.hpp"
+#include "json_shape.hpp"
 #include "json_hash.hpp"
+#include "json_serializer.hpp"
 #include "string_utils.hpp"
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
 #include <cmath>
+#include <charconv>
+#include <cstring>
 
 namespace jansson {
 
-// JsonNull implementation
-bool JsonNull::equals(const JsonValue& other) const noexcept {
-    return other.is_null();
-}
+// JsonStringValue implementation
+JsonStringValue::JsonStringValue(const std::string& value)
+    : JsonValue(JsonType::String), value_(value) {}
 
-std::shared_ptr<JsonValue> JsonNull::clone() const {
-    return create();
-}
+JsonStringValue::JsonStringValue(std::string&& value)
+    : JsonValue(JsonType::String), value_(std::move(value)) {}
 
-// JsonBoolean implementation
-bool JsonBoolean::equals(const JsonValue& other) const noexcept {
-    return other.is_boolean() && other.boolean_value() == value_;
-}
+JsonStringValue::JsonStringValue(std::string_view value)
+    : JsonValue(JsonType::String), value_(value) {}
 
-std::shared_ptr<JsonValue> JsonBoolean::clone() const {
-    return create(value_);
+void JsonStringValue::materialize() const {
+    value_.assign(borrowed_view_.data(), borrowed_view_.size());
+    borrowed_view_ = std::string_view();
 }
 
 // JsonNumber implementation
-std::string JsonNumber::to_string() const {
-    // Check if the number is an integer
-    if (std::floor(value_) == value_) {
-        return std::to_string(static_cast<int64_t>(value_));
+std::size_t JsonNumber::format(char* buffer, int precision) const noexcept {
+    char* end = buffer + max_formatted_length;
+    if (is_integer_) {
+        return static_cast<std::size_t>(std::to_chars(buffer, end, integer_).ptr - buffer);
     }
     
-    // Use default formatting for floating point
-    std::ostringstream oss;
-    oss << value_;
-    return oss.str();
+    std::to_chars_result result;
+    if (precision > 0 && precision <= 17) {
+        result = std::to_chars(buffer, end, real_, std::chars_format::general, precision);
+    } else {
+        // Shortest representation that round-trips
+        result = std::to_chars(buffer, end, real_);
+    }
+    return static_cast<std::size_t>(result.ptr - buffer);
 }
 
-bool JsonNumber::equals(const JsonValue& other) const noexcept {
-    return other.is_number() && 
-           std::abs(other.number_value() - value_) < 1e-12; // Allow for floating point tolerance
+std::size_t JsonNumber::format_canonical(char* buffer) const noexcept {
+    // Integers up to 2^53 are exact as doubles and printed digit for digit
+    constexpr std::int64_t max_exact = std::int64_t(1) << 53;
+    char* end = buffer + max_formatted_length;
+    if (is_integer_ && integer_ >= -max_exact && integer_ <= max_exact) {
+        return static_cast<std::size_t>(std::to_chars(buffer, end, integer_).ptr - buffer);
+    }
+    
+    double real = value();
+    if (!std::isfinite(real)) {
+        return 0;
+    }
+    char* out = buffer;
+    if (real == 0) {
+        *out = '0';
+        return 1;
+    }
+    if (real < 0) {
+        *out++ = '-';
+        real = -real;
+    }
+    
+    // Shortest digits d[.ddd]e±x, split into the digits and the position n
+    // of the decimal point relative to them
+    char scientific[max_formatted_length];
+    char* scientific_end = std::to_chars(scientific, scientific + sizeof(scientific), real,
+                                         std::chars_format::scientific).ptr;
+    char digits[max_formatted_length];
+    int count = 0;
+    const char* p = scientific;
+    for (; *p != 'e'; ++p) {
+        if (*p != '.') {
+            digits[count++] = *p;
+        }
+    }
+    bool negative_exponent = p[1] == '-';
+    int exponent = 0;
+    std::from_chars(p + 2, scientific_end, exponent);
+    int n = (negative_exponent ? -exponent : exponent) + 1;
+    
+    if (count <= n && n <= 21) {
+        std::memcpy(out, digits, static_cast<std::size_t>(count));
+        out += count;
+        out = std::fill_n(out, n - count, '0');
+    } else if (0 < n && n <= 21) {
+        std::memcpy(out, digits, static_cast<std::size_t>(n));
+        out += n;
+        *out++ = '.';
+        std::memcpy(out, digits + n, static_cast<std::size_t>(count - n));
+        out += count - n;
+    } else if (-6 < n && n <= 0) {
+        *out++ = '0';
+        *out++ = '.';
+        out = std::fill_n(out, -n, '0');
+        std::memcpy(out, digits, static_cast<std::size_t>(count));
+        out += count;
+    } else {
+        *out++ = digits[0];
+        if (count > 1) {
+            *out++ = '.';
+            std::memcpy(out, digits + 1, static_cast<std::size_t>(count - 1));
+            out += count - 1;
+        }
+        *out++ = 'e';
+        *out++ = n - 1 < 0 ? '-' : '+';
+        out = std::to_chars(out, end, n - 1 < 0 ? 1 - n : n - 1).ptr;
+    }
+    return static_cast<std::size_t>(out - buffer);
 }
 
-std::shared_ptr<JsonValue> JsonNumber::clone() const {
-    return create(value_);
+// JsonKeyOrder implementation
+JsonKeyOrder::JsonKeyOrder(const std::vector<std::string_view>& keys, std::uint32_t version)
+    : version_(version), bytewise_(keys.size()) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        bytewise_[i] = static_cast<std::uint32_t>(i);
+    }
+    std::sort(bytewise_.begin(), bytewise_.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return keys[lhs] < keys[rhs];
+    });
+    
+    // UTF-16 order needs its own sort only if keys have both lead bytes
+    // of U+E000..U+FFFF (0xEE, 0xEF) and of characters above U+FFFF
+    bool high_bmp = false;
+    bool supplementary = false;
+    for (std::string_view key : keys) {
+        for (char c : key) {
+            auto byte = static_cast<unsigned char>(c);
+            high_bmp |= byte == 0xEE || byte == 0xEF;
+            supplementary |= byte >= 0xF0;
+        }
+    }
+    if (high_bmp && supplementary) {
+        utf16_ = bytewise_;
+        std::stable_sort(utf16_.begin(), utf16_.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+            return less(keys[lhs], keys[rhs], true);
+        });
+    }
 }
 
-// JsonStringValue implementation
-JsonStringValue::JsonStringValue(const std::string& value)
-    : value_(value) {}
-
-JsonStringValue::JsonStringValue(std::string&& value)
-    : value_(std::move(value)) {}
-
-JsonStringValue::JsonStringValue(std::string_view value)
-    : value_(value) {}
+bool JsonKeyOrder::less(std::string_view lhs, std::string_view rhs, bool utf16) noexcept {
+    if (!utf16) {
+        return lhs < rhs;
+    }
+    std::size_t length = std::min(lhs.size(), rhs.size());
+    for (std::size_t i = 0; i < length; ++i) {
+        auto a = static_cast<unsigned char>(lhs[i]);
+        auto b = static_cast<unsigned char>(rhs[i]);
+        if (a != b) {
+            // The first difference between valid UTF-8 with a common prefix
+            // is in the same position of one character or at the lead byte
+            // of both. Surrogate pairs sort below U+E000..U+FFFF, so move
+            // those lead bytes above the four-byte ones.
+            auto rank = [](unsigned char byte) { return byte == 0xEE || byte == 0xEF ? byte + 7 : byte; };
+            return rank(a) < rank(b);
+        }
+    }
+    return lhs.size() < rhs.size();
+}
 
-std::string JsonStringValue::to_string() const {
-    return JsonString::escape(value_);
+// JsonArray implementation
+JsonRef<JsonValue> JsonArray::at(size_t index) const {
+    if (index >= values_.size()) {
+        throw JsonException("Array index out of bounds");
+    }
+    return values_[index];
 }
 
-bool JsonStringValue::equals(const JsonValue& other) const noexcept {
-    return other.is_string() && other.string_value() == value_;
+JsonRef<JsonValue> JsonArray::take(size_t index) {
+    if (index >= values_.size()) {
+        throw JsonException("Array index out of bounds");
+    }
+    auto position = values_.begin() + static_cast<std::ptrdiff_t>(index);
+    JsonRef<JsonValue> value = std::move(*position);
+    values_.erase(position);
+    state_.modified();
+    return value;
 }
 
-std::shared_ptr<JsonValue> JsonStringValue::clone() const {
-    return create(value_);
+// Make a shared container value private to its slot
+static void unshare(JsonRef<JsonValue>& slot) {
+    if (slot.use_count() > 1 && (slot->is_array() || slot->is_object())) {
+        slot = slot->cow_clone();
+    }
 }
 
-// JsonArray implementation
-std::shared_ptr<JsonValue> JsonArray::at(size_t index) const {
+JsonValue& JsonArray::mutable_at(size_t index) {
     if (index >= values_.size()) {
         throw JsonException("Array index out of bounds");
     }
-    return values_[index];
+    auto& slot = values_[index];
+    unshare(slot);
+    state_.modified();
+    return *slot;
 }
 
-std::string JsonArray::to_string() const {
-    std::ostringstream oss;
-    oss << "[";
-    
-    for (size_t i = 0; i < values_.size(); ++i) {
-        if (i > 0) {
-            oss << ", ";
-        }
-        oss << values_[i]->to_string();
+// JsonObject implementation
+template <typename K>
+void JsonObject::assign(K&& key, JsonRef<JsonValue> value) {
+    size_t before = values_.size();
+    values_[std::forward<K>(key)] = std::move(value);
+    if (values_.size() != before) {
+        shape_.reset();
     }
-    
-    oss << "]";
-    return oss.str();
+    state_.modified();
 }
 
-bool JsonArray::equals(const JsonValue& other) const noexcept {
-    if (!other.is_array()) {
-        return false;
+void JsonObject::set(const std::string& key, JsonRef<JsonValue> value) {
+    assign(std::string_view(key), std::move(value));
+}
+
+void JsonObject::set(std::string&& key, JsonRef<JsonValue> value) {
+    assign(std::string_view(key), std::move(value));
+}
+
+void JsonObject::set(std::string_view key, JsonRef<JsonValue> value) {
+    assign(key, std::move(value));
+}
+
+void JsonObject::set(const char* key, JsonRef<JsonValue> value) {
+    assign(std::string_view(key), std::move(value));
+}
+
+void JsonObject::set(JsonKey key, JsonRef<JsonValue> value) {
+    assign(std::move(key), std::move(value));
+}
+
+std::shared_ptr<const JsonKeyOrder> JsonObject::key_order() const {
+    if (shape_) {
+        return shape_->key_order();
     }
-    
-    const auto& other_array = other.array_value();
-    if (values_.size() != other_array.size()) {
-        return false;
+    std::uint32_t version = state_.version();
+    std::shared_ptr<const JsonKeyOrder> order = std::atomic_load(&key_order_);
+    if (order && order->version() == version) {
+        return order;
     }
-    
-    for (size_t i = 0; i < values_.size(); ++i) {
-        if (!values_[i]->equals(*other_array[i])) {
-            return false;
-        }
+    std::vector<std::string_view> keys;
+    keys.reserve(values_.size());
+    for (const auto& member : values_) {
+        keys.push_back(member.first.view());
     }
-    
+    order = std::make_shared<JsonKeyOrder>(keys, version);
+    std::atomic_store(&key_order_, order);
+    return order;
+}
+
+bool JsonObject::adopt_shape(std::shared_ptr<const JsonShape> shape) {
+    if (!shape || !shape->matches(*this)) {
+        return false;
+    }
+    values_.adopt_index(shape->index_);
+    shape_ = std::move(shape);
     return true;
 }
 
-std::shared_ptr<JsonValue> JsonArray::clone() const {
-    auto result = create();
-    for (const auto& value : values_) {
-        result->push_back(value->clone());
+JsonRef<JsonValue> JsonObject::get(std::string_view key) const {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+        return nullptr;
     }
-    return result;
+    return it->second;
 }
 
-// JsonObject implementation
-void JsonObject::set(const std::string& key, std::shared_ptr<JsonValue> value) {
-    values_[key] = std::move(value);
+bool JsonObject::has(std::string_view key) const {
+    return values_.contains(key);
 }
 
-std::shared_ptr<JsonValue> JsonObject::get(const std::string& key) const {
+JsonRef<JsonValue> JsonObject::take(std::string_view key) {
     auto it = values_.find(key);
     if (it == values_.end()) {
         return nullptr;
     }
-    return it->second;
+    JsonRef<JsonValue> value = std::move(it->second);
+    values_.erase(it);
+    shape_.reset();
+    state_.modified();
+    return value;
 }
 
-bool JsonObject::has(const std::string& key) const {
-    return values_.contains(key);
+JsonValue* JsonObject::mutable_get(std::string_view key) {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+        return nullptr;
+    }
+    unshare(it->second);
+    state_.modified();
+    return it->second.get();
 }
 
-void JsonObject::erase(const std::string& key) {
-    values_.erase(key);
+void JsonObject::erase(std::string_view key) {
+    if (values_.erase(key) != 0) {
+        shape_.reset();
+        state_.modified();
+    }
 }
 
-std::string JsonObject::to_string() const {
-    std::ostringstream oss;
-    oss << "{";
-    
-    bool first = true;
-    for (const auto& [key, value] : values_) {
-        if (!first) {
-            oss << ", ";
+// JsonValue implementation: operations that need the concrete type
+// switch on the tag.
+namespace {
+
+const JsonContainerState& state_of(const JsonValue& container) noexcept {
+    return container.is_array() ? static_cast<const JsonArray&>(container).container_state()
+                                : static_cast<const JsonObject&>(container).container_state();
+}
+
+// The hash a container keeps, or 0 if it keeps none that is current. A
+// container whose own hash is current may hold children whose kept hashes
+// are not (changed again since, or recomputed after a change below them),
+// so each child is checked through its own record.
+std::size_t current_hash(const JsonValue& container) noexcept {
+    const JsonContainerState& state = state_of(container);
+    auto record = state.cached_hash_record();
+    if (!record || record->version != state.version()) {
+        return 0;
+    }
+    for (const auto& child : record->children) {
+        if (state_of(*child.container).version() != child.version ||
+            current_hash(*child.container) != child.hash) {
+            return 0;
         }
-        oss << JsonString::escape(key) << ": " << value->to_string();
-        first = false;
     }
-    
-    oss << "}";
-    return oss.str();
+    return record->hash;
 }
 
-bool JsonObject::equals(const JsonValue& other) const noexcept {
-    if (!other.is_object()) {
+// Two containers whose kept hashes are current and differ are unequal. The
+// containers below them are only checked when their own hashes differ.
+bool hashes_differ(const JsonValue& lhs, const JsonValue& rhs) noexcept {
+    std::size_t left = state_of(lhs).cached_hash();
+    std::size_t right = state_of(rhs).cached_hash();
+    if (left == 0 || right == 0 || left == right) {
         return false;
     }
-    
-    const auto& other_obj = other.object_value();
-    if (values_.size() != other_obj.size()) {
+    return current_hash(lhs) == left && current_hash(rhs) == right;
+}
+
+bool array_equals(const JsonArray& lhs, const JsonArray& rhs) noexcept {
+    const auto& left = lhs.values();
+    const auto& right = rhs.values();
+    if (left.size() != right.size() || hashes_differ(lhs, rhs)) {
         return false;
     }
-    
-    for (const auto& [key, value] : values_) {
-        auto it = other_obj.find(key);
-        if (it == other_obj.end() || !value->equals(*it->second)) {
+
+    for (size_t i = 0; i < left.size(); ++i) {
+        if (!left[i]->equals(*right[i])) {
             return false;
         }
     }
-    
+
     return true;
 }
 
-std::shared_ptr<JsonValue> JsonObject::clone() const {
-    auto result = create();
-    for (const auto& [key, value] : values_) {
-        result->set(key, value->clone());
+bool object_equals(const JsonObject& lhs, const JsonObject& rhs) noexcept {
+    const auto& left = lhs.values();
+    const auto& right = rhs.values();
+    if (left.size() != right.size() || hashes_differ(lhs, rhs)) {
+        return false;
+    }
+
+    // Objects from one producer usually list their keys in the same order:
+    // compare position by position while they do. A key left over cannot
+    // be among those already matched, so the rest are looked up.
+    auto l = left.begin();
+    for (auto r = right.begin(); l != left.end() && l->first == r->first; ++l, ++r) {
+        if (!l->second->equals(*r->second)) {
+            return false;
+        }
+    }
+    for (; l != left.end(); ++l) {
+        auto it = right.find(l->first);
+        if (it == right.end() || !l->second->equals(*it->second)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::size_t combine(std::size_t seed, std::size_t value) noexcept {
+    return static_cast<std::size_t>(hash_detail::mix(seed ^ hash_detail::secret[0], value ^ hash_detail::secret[1]));
+}
+
+std::size_t compute_hash(const JsonValue& value, bool refresh) noexcept;
+
+// Hash of a container's elements or members, recording the containers
+// among them in record if there is one. record is cleared if that runs out
+// of memory.
+std::size_t hash_contents(const JsonValue& container, bool refresh, JsonHashRecord*& record) noexcept {
+    const auto type = static_cast<std::size_t>(container.type());
+    auto hash_member = [&](const JsonValue& value) noexcept {
+        std::size_t hash = compute_hash(value, refresh);
+        if (record && (value.is_array() || value.is_object())) {
+            try {
+                record->children.push_back({&value, state_of(value).version(), hash});
+            } catch (...) {
+                record = nullptr;
+            }
+        }
+        return hash;
+    };
+    
+    std::size_t hash;
+    if (container.is_array()) {
+        const auto& array = static_cast<const JsonArray&>(container);
+        hash = combine(type, array.size());
+        for (const auto& element : array) {
+            hash = combine(hash, hash_member(*element));
+        }
+    } else {
+        // Members are summed, as equality ignores their order
+        const auto& object = static_cast<const JsonObject&>(container);
+        std::size_t members = 0;
+        for (const auto& [key, member] : object) {
+            members += combine(key.hash(), hash_member(*member));
+        }
+        hash = combine(combine(type, object.size()), members);
+    }
+    return hash + (hash == 0);
+}
+
+// Hash of a value, reusing the hashes containers keep while they are
+// current, unless refresh
+std::size_t compute_hash(const JsonValue& value, bool refresh) noexcept {
+    const auto type = static_cast<std::size_t>(value.type());
+    switch (value.type()) {
+        case JsonType::Null:
+            return combine(type, 0);
+        case JsonType::Boolean:
+            return combine(type, static_cast<const JsonBoolean&>(value).value());
+        case JsonType::Number: {
+            // Integers hash as the double they compare as; 0.0 and -0.0 alike
+            double number = static_cast<const JsonNumber&>(value).value();
+            if (number == 0) {
+                number = 0;
+            }
+            std::uint64_t bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            return combine(type, static_cast<std::size_t>(bits));
+        }
+        case JsonType::String:
+            return combine(type, hash_bytes(static_cast<const JsonStringValue&>(value).view()));
+        case JsonType::Array:
+        case JsonType::Object: {
+            if (!refresh) {
+                std::size_t hash = current_hash(value);
+                if (hash != 0) {
+                    return hash;
+                }
+            }
+            // Without memory for a record the hash is still computed, but
+            // not kept
+            std::shared_ptr<JsonHashRecord> record;
+            try {
+                record = std::make_shared<JsonHashRecord>();
+            } catch (...) {
+            }
+            JsonHashRecord* filling = record.get();
+            if (filling) {
+                filling->version = state_of(value).version();
+            }
+            std::size_t hash = hash_contents(value, refresh, filling);
+            if (filling) {
+                filling->hash = hash;
+                state_of(value).store_hash_record(std::move(record));
+            }
+            return hash;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+std::string JsonValue::to_string() const {
+    switch (type_) {
+        case JsonType::Null:
+            return "null";
+        case JsonType::Boolean:
+            return static_cast<const JsonBoolean*>(this)->value() ? "true" : "false";
+        case JsonType::Number: {
+            char buffer[JsonNumber::max_formatted_length];
+            std::size_t length = static_cast<const JsonNumber*>(this)->format(buffer);
+            return std::string(buffer, length);
+        }
+        case JsonType::String:
+            return JsonString::escape(static_cast<const JsonStringValue*>(this)->view());
+        case JsonType::Array:
+        case JsonType::Object:
+            return JsonSerializer::serialize(*this);
+    }
+    return std::string();
+}
+
+bool JsonValue::equals(const JsonValue& other) const noexcept {
+    if (this == &other) {
+        return true;
+    }
+    if (type_ != other.type_) {
+        return false;
+    }
+
+    switch (type_) {
+        case JsonType::Null:
+            return true;
+        case JsonType::Boolean:
+            return static_cast<const JsonBoolean*>(this)->value() ==
+                   static_cast<const JsonBoolean&>(other).value();
+        case JsonType::Number: {
+            const auto& lhs = *static_cast<const JsonNumber*>(this);
+            const auto& rhs = static_cast<const JsonNumber&>(other);
+            if (lhs.is_integer() && rhs.is_integer()) {
+                return lhs.integer() == rhs.integer();
+            }
+            return lhs.value() == rhs.value();
+        }
+        case JsonType::String:
+            return static_cast<const JsonStringValue*>(this)->view() ==
+                   static_cast<const JsonStringValue&>(other).view();
+        case JsonType::Array:
+            return array_equals(*static_cast<const JsonArray*>(this),
+                                static_cast<const JsonArray&>(other));
+        case JsonType::Object:
+            return object_equals(*static_cast<const JsonObject*>(this),
+                                 static_cast<const JsonObject&>(other));
+    }
+    return false;
+}
+
+JsonRef<JsonValue> JsonValue::clone() const {
+    switch (type_) {
+        case JsonType::Null:
+            return JsonNull::create();
+        case JsonType::Boolean:
+            return JsonBoolean::create(static_cast<const JsonBoolean*>(this)->value());
+        case JsonType::Number: {
+            const auto& number = *static_cast<const JsonNumber*>(this);
+            if (number.is_integer()) {
+                return JsonNumber::create(number.integer());
+            }
+            return JsonNumber::create(number.real());
+        }
+        case JsonType::String:
+            return JsonStringValue::create(std::string(static_cast<const JsonStringValue*>(this)->view()));
+        case JsonType::Array: {
+            auto result = JsonArray::create();
+            for (const auto& value : static_cast<const JsonArray*>(this)->values()) {
+                result->push_back(value->clone());
+            }
+            return result;
+        }
+        case JsonType::Object: {
+            auto result = JsonObject::create();
+            const auto& source = static_cast<const JsonObject&>(*this);
+            for (const auto& [key, value] : source.values()) {
+                result->set(key, value->clone());
+            }
+            if (source.shape()) {
+                result->adopt_shape(source.shape());
+            }
+            return result;
+        }
     }
-    return result;
+    return nullptr;
 }
 
-// Default implementations that throw
-bool JsonValue::boolean_value() const {
-    throw JsonException("Value is not a boolean");
+std::size_t JsonValue::hash() const noexcept {
+    return compute_hash(*this, false);
 }
 
-double JsonValue::number_value() const {
-    throw JsonException("Value is not a number");
+std::size_t JsonValue::rehash() const noexcept {
+    return compute_hash(*this, true);
 }
 
-const std::string& JsonValue::string_value() const {
-    throw JsonException("Value is not a string");
+JsonRef<JsonValue> JsonValue::cow_clone() const {
+    if (in_arena_) {
+        return clone();
+    }
+    switch (type_) {
+        case JsonType::Array: {
+            const auto& source = static_cast<const JsonArray&>(*this).values_;
+            auto result = JsonArray::create();
+            result->values_.assign(source.begin(), source.end());
+            return result;
+        }
+        case JsonType::Object: {
+            const auto& source = static_cast<const JsonObject&>(*this);
+            auto result = JsonObject::create();
+            result->values_ = source.values_;
+            result->shape_ = source.shape_;
+            return result;
+        }
+        default:
+            return clone();
+    }
 }
 
-const std::vector<std::shared_ptr<JsonValue>>& JsonValue::array_value() const {
-    throw JsonException("Value is not an array");
+JsonRef<JsonValue> JsonValue::clone(JsonRef<JsonValue>&& source) {
+    if (!source) {
+        return nullptr;
+    }
+    // Arena nodes die with their arena, so they are always copied
+    if (source.use_count() != 1 || source->in_arena_) {
+        JsonRef<JsonValue> shared = std::move(source);
+        return shared->clone();
+    }
+    
+    // Sole owner: keep the node and make its children independent in
+    // place. Keys, and so the shape, are unchanged. A borrowed string
+    // takes its own copy of the bytes.
+    switch (source->type_) {
+        case JsonType::String:
+            static_cast<const JsonStringValue&>(*source).value();
+            break;
+        case JsonType::Array:
+            for (auto& value : static_cast<JsonArray&>(*source).values_) {
+                value = clone(std::move(value));
+            }
+            static_cast<JsonArray&>(*source).state_.modified();
+            break;
+        case JsonType::Object:
+            for (auto& member : static_cast<JsonObject&>(*source).values_) {
+                member.second = clone(std::move(member.second));
+            }
+            static_cast<JsonObject&>(*source).state_.modified();
+            break;
+        default:
+            break;
+    }
+    return std::move(source);
+}
+
+void JsonValue::destroy() const noexcept {
+    stats_detail::node_destroyed(static_cast<std::uint8_t>(type_));
+    if (in_arena_) {
+        this->~JsonValue();
+    } else {
+        delete this;
+    }
 }
 
-const JsonHash<std::string, std::shared_ptr<JsonValue>>& JsonValue::object_value() const {
-    throw JsonException("Value is not an object");
+void JsonValue::throw_type_error(const char* expected) {
+    throw JsonException(std::string("Value is not ") + expected);
 }
 
 } // namespace jansson
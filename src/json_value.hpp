@@ -1,13 +1,24 @@
 #ifndef JSON_VALUE_HPP
 #define JSON_VALUE_HPP
 
+#include <atomic>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <variant>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
 #include "json_error.hpp"
 #include "json_hash.hpp"
+#include "json_key.hpp"
+#include "json_ref.hpp"
+#include "json_stats.hpp"
+#include "memory_policy.hpp"
 
 namespace jansson {
 
@@ -19,9 +30,15 @@ class JsonNumber;
 class JsonStringValue;
 class JsonArray;
 class JsonObject;
+class JsonShape;
+
+// Container storage types. Both allocate through a std::pmr memory
+// resource so a tree can be built entirely inside a JsonArena.
+using JsonValueVector = std::pmr::vector<JsonRef<JsonValue>>;
+using JsonObjectMap = JsonHash<JsonKey, JsonRef<JsonValue>>;
 
 // JSON type enum (matches C API)
-enum class JsonType {
+enum class JsonType : std::uint8_t {
     Null,
     Boolean,
     Number,
@@ -30,159 +47,494 @@ enum class JsonType {
     Object
 };
 
-// Base JSON value class
-class JsonValue : public std::enable_shared_from_this<JsonValue> {
+// Base JSON value class.
+//
+// Every node stores its type tag in the base, so type checks and value
+// access are plain loads and operations that need the concrete type
+// (serialization, equals, clone) switch on the tag instead of going
+// through the vtable. The only virtual function is the destructor.
+//
+// Nodes are reference counted intrusively: the count sits in the base next
+// to the tag (in what would otherwise be padding) and is managed by
+// JsonRef. Nodes must be created through create(), make_value() or a
+// JsonDocument, never owned by a std::shared_ptr of their own.
+class JsonValue {
 public:
     virtual ~JsonValue() = default;
     
+    // Heap nodes are allocated through allocate_node (see set_node_pool_limit)
+    static void* operator new(std::size_t size) {
+        return allocate_node(size);
+    }
+    static void operator delete(void* pointer, std::size_t size) noexcept {
+        deallocate_node(pointer, size);
+    }
+    static void* operator new(std::size_t, void* storage) noexcept {
+        return storage;
+    }
+    static void operator delete(void*, void*) noexcept {}
+    
+    // Reference counting (see JsonRef)
+    void retain() const noexcept {
+        refs_.increment();
+    }
+    void release() const noexcept {
+        if (refs_.decrement()) {
+            destroy();
+        }
+    }
+    std::uint32_t reference_count() const noexcept {
+        return refs_.load();
+    }
+    
     // Get the type of this value
-    virtual JsonType type() const noexcept = 0;
+    JsonType type() const noexcept { return type_; }
     
     // Type checking
-    virtual bool is_null() const noexcept { return false; }
-    virtual bool is_boolean() const noexcept { return false; }
-    virtual bool is_number() const noexcept { return false; }
-    virtual bool is_string() const noexcept { return false; }
-    virtual bool is_array() const noexcept { return false; }
-    virtual bool is_object() const noexcept { return false; }
+    bool is_null() const noexcept { return type_ == JsonType::Null; }
+    bool is_boolean() const noexcept { return type_ == JsonType::Boolean; }
+    bool is_number() const noexcept { return type_ == JsonType::Number; }
+    bool is_string() const noexcept { return type_ == JsonType::String; }
+    bool is_array() const noexcept { return type_ == JsonType::Array; }
+    bool is_object() const noexcept { return type_ == JsonType::Object; }
+    bool is_integer() const noexcept;
+    bool is_real() const noexcept;
     
     // Value access (will throw if wrong type)
-    virtual bool boolean_value() const;
-    virtual double number_value() const;
-    virtual const std::string& string_value() const;
-    virtual const std::vector<std::shared_ptr<JsonValue>>& array_value() const;
-    virtual const JsonHash<std::string, std::shared_ptr<JsonValue>>& object_value() const;
+    bool boolean_value() const;
+    double number_value() const;
+    std::int64_t integer_value() const;
+    const std::string& string_value() const;
+    const JsonValueVector& array_value() const;
+    const JsonObjectMap& object_value() const;
     
     // String representation
-    virtual std::string to_string() const = 0;
+    std::string to_string() const;
+    
+    // Comparison. Numbers are equal when their values are: two integers
+    // exactly, otherwise as doubles.
+    bool equals(const JsonValue& other) const noexcept;
+    
+    // Structural hash, equal for values that are equal(); within a process
+    // only, as key hashes are seeded. Arrays and objects keep theirs with
+    // the versions of the containers below them (see JsonHashRecord), so a
+    // kept hash is reused after checking those, at a cost in the number of
+    // containers rather than values, and recomputed where anything changed,
+    // however it was reached. equals() rejects two containers whose kept
+    // hashes are current and differ without looking further.
+    std::size_t hash() const noexcept;
     
-    // Comparison
-    virtual bool equals(const JsonValue& other) const noexcept = 0;
+    // Recompute the hash of this value and of every container below it
+    std::size_t rehash() const noexcept;
     
     // Clone this value
-    virtual std::shared_ptr<JsonValue> clone() const = 0;
+    JsonRef<JsonValue> clone() const;
+    
+    // Copy-on-write clone: a new container holding the same children, so
+    // the cost is the width of this node rather than the size of the tree.
+    // Nested values stay shared until modified through the copy with
+    // mutable_at()/mutable_get(), which copy them (again shallowly) when
+    // someone else also refers to them; untouched subtrees are never
+    // copied. Modifying a nested value through a reference obtained
+    // elsewhere affects every tree that shares it. Scalars, and trees in
+    // an arena, get a regular clone().
+    JsonRef<JsonValue> cow_clone() const;
+    
+    // Clone for a caller that is dropping source: nodes that only source
+    // can reach are reused as they are, and only nodes shared with someone
+    // else are copied. The result is as independent as clone()'s.
+    static JsonRef<JsonValue> clone(JsonRef<JsonValue>&& source);
+
+protected:
+    explicit JsonValue(JsonType type) noexcept : type_(type) {}
+    
+    // A copy is a new node, with no references yet
+    JsonValue(const JsonValue& other) noexcept : type_(other.type_) {}
+    JsonValue& operator=(const JsonValue&) noexcept { return *this; }
+
+private:
+    template <typename T, typename... Args>
+    friend JsonRef<T> make_value(Args&&... args);
+    template <typename T, typename... Args>
+    friend JsonRef<T> make_value_in(JsonArena* arena, Args&&... args);
+    
+    // First reference to a node just constructed: a plain store, not a
+    // read-modify-write
+    template <typename T>
+    static JsonRef<T> adopt_new(T* node, bool in_arena) noexcept {
+        node->in_arena_ = in_arena;
+        node->refs_.initialize(1);
+        stats_detail::node_created(static_cast<std::uint8_t>(node->type_));
+        return JsonRef<T>(node, JsonRef<T>::adopt);
+    }
+    
+    [[noreturn]] static void throw_type_error(const char* expected);
+    
+    // Run the destructor; heap nodes are also freed, arena nodes leave
+    // their storage to the arena
+    void destroy() const noexcept;
+    
+    mutable JsonRefCount refs_;
+    JsonType type_;
+    bool in_arena_ = false;
 };
 
+// Create a node on the heap
+template <typename T, typename... Args>
+JsonRef<T> make_value(Args&&... args) {
+    return JsonValue::adopt_new(new T(std::forward<Args>(args)...), false);
+}
+
+// Create a node whose storage comes from arena, or from the heap without
+// one. The arena must outlive the node.
+template <typename T, typename... Args>
+JsonRef<T> make_value_in(JsonArena* arena, Args&&... args) {
+    if (!arena) {
+        return make_value<T>(std::forward<Args>(args)...);
+    }
+    void* storage = arena->allocate(sizeof(T), alignof(T));
+    return JsonValue::adopt_new(new (storage) T(std::forward<Args>(args)...), true);
+}
+
 // Null value
 class JsonNull : public JsonValue {
 public:
-    static std::shared_ptr<JsonNull> create() {
-        return std::shared_ptr<JsonNull>(new JsonNull());
-    }
+    JsonNull() noexcept : JsonValue(JsonType::Null) {}
     
-    JsonType type() const noexcept override { return JsonType::Null; }
-    bool is_null() const noexcept override { return true; }
-    
-    std::string to_string() const override { return "null"; }
-    bool equals(const JsonValue& other) const noexcept override;
-    std::shared_ptr<JsonValue> clone() const override;
+    static JsonRef<JsonNull> create() {
+        return make_value<JsonNull>();
+    }
 };
 
 // Boolean value
 class JsonBoolean : public JsonValue {
 public:
-    explicit JsonBoolean(bool value) : value_(value) {}
+    explicit JsonBoolean(bool value) noexcept : JsonValue(JsonType::Boolean), value_(value) {}
     
-    static std::shared_ptr<JsonBoolean> create(bool value) {
-        return std::shared_ptr<JsonBoolean>(new JsonBoolean(value));
+    static JsonRef<JsonBoolean> create(bool value) {
+        return make_value<JsonBoolean>(value);
     }
     
-    JsonType type() const noexcept override { return JsonType::Boolean; }
-    bool is_boolean() const noexcept override { return true; }
-    bool boolean_value() const override { return value_; }
-    
-    std::string to_string() const override { return value_ ? "true" : "false"; }
-    bool equals(const JsonValue& other) const noexcept override;
-    std::shared_ptr<JsonValue> clone() const override;
+    bool value() const noexcept { return value_; }
 
 private:
     bool value_;
 };
 
-// Number value (supports both integer and real)
+// Number value (supports both integer and real).
+// Integers are stored exactly as 64-bit values, so IDs above 2^53 survive
+// a parse/serialize round trip.
 class JsonNumber : public JsonValue {
 public:
-    explicit JsonNumber(double value) : value_(value) {}
+    explicit JsonNumber(double value) noexcept
+        : JsonValue(JsonType::Number), is_integer_(false), real_(value) {}
+    
+    template <typename T,
+              std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    explicit JsonNumber(T value) noexcept
+        : JsonValue(JsonType::Number), is_integer_(true),
+          integer_(static_cast<std::int64_t>(value)) {}
+    
+    static JsonRef<JsonNumber> create(double value) {
+        return make_value<JsonNumber>(value);
+    }
+    
+    // Integral arguments create an integer number
+    template <typename T,
+              std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    static JsonRef<JsonNumber> create(T value) {
+        return make_value<JsonNumber>(value);
+    }
+    
+    bool is_integer() const noexcept { return is_integer_; }
     
-    static std::shared_ptr<JsonNumber> create(double value) {
-        return std::shared_ptr<JsonNumber>(new JsonNumber(value));
+    // Value as a double (integers are converted)
+    double value() const noexcept {
+        return is_integer_ ? static_cast<double>(integer_) : real_;
     }
     
-    JsonType type() const noexcept override { return JsonType::Number; }
-    bool is_number() const noexcept override { return true; }
-    double number_value() const override { return value_; }
+    // Value as an integer (reals are truncated)
+    std::int64_t integer() const noexcept {
+        return is_integer_ ? integer_ : static_cast<std::int64_t>(real_);
+    }
+    
+    // Raw real payload, only meaningful when !is_integer()
+    double real() const noexcept { return real_; }
+    
+    // Buffer size that is always enough for format()
+    static constexpr std::size_t max_formatted_length = 32;
     
-    std::string to_string() const override;
-    bool equals(const JsonValue& other) const noexcept override;
-    std::shared_ptr<JsonValue> clone() const override;
+    // Format into buffer (at least max_formatted_length bytes) and return
+    // the number of characters written. Reals use the shortest form that
+    // parses back to the same double, or precision significant digits when
+    // precision is between 1 and 17.
+    std::size_t format(char* buffer, int precision = 0) const noexcept;
+    
+    // Format as ECMAScript's Number.prototype.toString does, which RFC 8785
+    // prescribes: the shortest round-trip digits, exponent notation only
+    // below 1e-6 or from 1e21, and -0 as 0. Integers beyond 2^53 are
+    // written as the nearest double. Returns 0 for NaN and infinities.
+    std::size_t format_canonical(char* buffer) const noexcept;
 
 private:
-    double value_;
+    bool is_integer_;
+    union {
+        double real_;
+        std::int64_t integer_;
+    };
 };
 
 // String value
 class JsonStringValue : public JsonValue {
 public:
+    // Tag selecting the borrowing constructor
+    struct Borrowed {};
+    static constexpr Borrowed borrowed{};
+    
     explicit JsonStringValue(const std::string& value);
     explicit JsonStringValue(std::string&& value);
     explicit JsonStringValue(std::string_view value);
     
-    static std::shared_ptr<JsonStringValue> create(const std::string& value) {
-        return std::shared_ptr<JsonStringValue>(new JsonStringValue(value));
+    // Reference bytes owned by someone else (e.g. a retained parse input)
+    // without copying them. The bytes must outlive this value, or until
+    // value() has been called once.
+    JsonStringValue(std::string_view value, Borrowed) noexcept
+        : JsonValue(JsonType::String), borrowed_view_(value) {}
+    
+    static JsonRef<JsonStringValue> create(const std::string& value) {
+        return make_value<JsonStringValue>(value);
+    }
+    
+    static JsonRef<JsonStringValue> create(std::string&& value) {
+        return make_value<JsonStringValue>(std::move(value));
+    }
+    
+    // Contents without materializing a borrowed string
+    std::string_view view() const noexcept {
+        return is_borrowed() ? borrowed_view_ : std::string_view(value_);
     }
     
-    static std::shared_ptr<JsonStringValue> create(std::string&& value) {
-        return std::shared_ptr<JsonStringValue>(new JsonStringValue(std::move(value)));
+    // Contents as an owned, NUL-terminated string. A borrowed string is
+    // copied into the value on first use; this is not safe to race with
+    // other readers of the same node.
+    const std::string& value() const {
+        if (is_borrowed()) {
+            materialize();
+        }
+        return value_;
     }
     
-    JsonType type() const noexcept override { return JsonType::String; }
-    bool is_string() const noexcept override { return true; }
-    const std::string& string_value() const override { return value_; }
+    bool is_borrowed() const noexcept { return borrowed_view_.data() != nullptr; }
+
+private:
+    void materialize() const;
+    
+    // Strings of up to 15 bytes live inside value_ (and so inside the
+    // node). A borrowed string is marked by a non-null borrowed_view_,
+    // which keeps the node at 64 bytes.
+    mutable std::string value_;
+    mutable std::string_view borrowed_view_;
+};
+
+// Serialized form of a container, cached by JsonSerializer for containers
+// that ask for it (see JsonArray::cache_encoding). format identifies the
+// options and indentation it was written with. containers lists the
+// container itself and every container below it, parents before children,
+// with the version each had: the text is current while every version
+// still matches, which is checked in that order so a container removed
+// from the tree is never looked at.
+struct JsonEncoding {
+    std::string text;
+    std::uint64_t format = 0;
+    std::vector<std::pair<const JsonValue*, std::uint32_t>> containers;
+};
+
+// Structural hash of a container and what it was computed from: the
+// container's version, and the version and hash of each container
+// directly inside it. The hash is current while the version matches and
+// each of those containers still has its version and a current hash equal
+// to the one recorded, which is checked parents before children as for a
+// JsonEncoding.
+struct JsonHashRecord {
+    struct Child {
+        const JsonValue* container;
+        std::uint32_t version;
+        std::size_t hash;
+    };
     
-    std::string to_string() const override;
-    bool equals(const JsonValue& other) const noexcept override;
-    std::shared_ptr<JsonValue> clone() const override;
+    std::size_t hash = 0;
+    std::uint32_t version = 0;
+    std::vector<Child> children;
+};
+
+// Positions of an object's members ordered by key, the order in which
+// sorted members are written: bytewise, the order of code points, and by
+// UTF-16 code units as RFC 8785 requires (the two differ only when keys
+// mix characters above U+FFFF with ones from U+E000 to U+FFFF). An order
+// is built once per key layout and shared; see JsonObject::key_order().
+class JsonKeyOrder {
+public:
+    // Order keys, given in member order; version is that of their object
+    explicit JsonKeyOrder(const std::vector<std::string_view>& keys, std::uint32_t version = 0);
+
+    const std::vector<std::uint32_t>& positions(bool utf16) const noexcept {
+        return utf16 && !utf16_.empty() ? utf16_ : bytewise_;
+    }
+
+    std::uint32_t version() const noexcept { return version_; }
+
+    // Whether lhs sorts before rhs
+    static bool less(std::string_view lhs, std::string_view rhs, bool utf16) noexcept;
 
 private:
-    std::string value_;
+    std::uint32_t version_;
+    std::vector<std::uint32_t> bytewise_;
+
+    // Empty when it would equal bytewise_
+    std::vector<std::uint32_t> utf16_;
+};
+
+// Mutation count of a container and what is cached from its contents: the
+// serialized text (when asked for) and the structural hash. Every change to
+// the container's elements or members, including handing one out through
+// mutable_at()/mutable_get(), moves the version on, which makes both out of
+// date.
+class JsonContainerState {
+public:
+    std::uint32_t version() const noexcept { return version_; }
+    void modified() noexcept { ++version_; }
+    
+    bool caches_encoding() const noexcept { return caches_encoding_; }
+    void cache_encoding(bool enabled) noexcept {
+        caches_encoding_ = enabled;
+        if (!enabled) {
+            store_encoding(nullptr);
+        }
+    }
+    
+    // The caches may be read and refilled by concurrent readers
+    std::shared_ptr<const JsonEncoding> cached_encoding() const noexcept {
+        return std::atomic_load(&encoding_);
+    }
+    void store_encoding(std::shared_ptr<const JsonEncoding> encoding) const noexcept {
+        std::atomic_store(&encoding_, std::move(encoding));
+    }
+    
+    std::shared_ptr<const JsonHashRecord> cached_hash_record() const noexcept {
+        return std::atomic_load(&hash_);
+    }
+    void store_hash_record(std::shared_ptr<const JsonHashRecord> record) const noexcept {
+        std::atomic_store(&hash_, std::move(record));
+    }
+    
+    // Structural hash computed since the container itself last changed, or
+    // 0; containers below it are not checked
+    std::size_t cached_hash() const noexcept {
+        auto record = cached_hash_record();
+        return record && record->version == version_ ? record->hash : 0;
+    }
+
+private:
+    std::uint32_t version_ = 0;
+    bool caches_encoding_ = false;
+    mutable std::shared_ptr<const JsonHashRecord> hash_;
+    mutable std::shared_ptr<const JsonEncoding> encoding_;
 };
 
 // Array value
 class JsonArray : public JsonValue {
 public:
-    JsonArray() = default;
-    explicit JsonArray(std::vector<std::shared_ptr<JsonValue>> values)
-        : values_(std::move(values)) {}
+    JsonArray() : JsonValue(JsonType::Array), values_(heap_resource()) {}
+    explicit JsonArray(std::pmr::memory_resource* resource)
+        : JsonValue(JsonType::Array), values_(resource) {}
+    explicit JsonArray(std::vector<JsonRef<JsonValue>> values)
+        : JsonValue(JsonType::Array),
+          values_(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()),
+                  heap_resource()) {}
+    // Take over finished storage without copying it
+    explicit JsonArray(JsonValueVector&& values) noexcept
+        : JsonValue(JsonType::Array), values_(std::move(values)) {}
     
-    static std::shared_ptr<JsonArray> create() {
-        return std::shared_ptr<JsonArray>(new JsonArray());
+    static JsonRef<JsonArray> create() {
+        return make_value<JsonArray>();
     }
     
-    JsonType type() const noexcept override { return JsonType::Array; }
-    bool is_array() const noexcept override { return true; }
-    const std::vector<std::shared_ptr<JsonValue>>& array_value() const override { return values_; }
+    const JsonValueVector& values() const noexcept { return values_; }
     
     // Array operations
-    void push_back(std::shared_ptr<JsonValue> value) {
+    void push_back(JsonRef<JsonValue> value) {
+        values_.push_back(std::move(value));
+        state_.modified();
+    }
+    
+    // Create a T from args at the end of the array
+    template <typename T, typename... Args>
+    T& emplace_back(Args&&... args) {
+        auto value = make_value<T>(std::forward<Args>(args)...);
+        T& node = *value;
         values_.push_back(std::move(value));
+        state_.modified();
+        return node;
     }
-    void insert(size_t index, std::shared_ptr<JsonValue> value){
+    void insert(size_t index, JsonRef<JsonValue> value){
         if (index > values_.size()) {
             throw std::out_of_range("Index out of bounds");
         }
         values_.insert(values_.begin() + index, std::move(value));
+        state_.modified();
     }
     void remove(size_t index) {
         if (index >= values_.size()) {
             throw std::out_of_range("Index out of bounds");
         }
         values_.erase(values_.begin() + index);
+        state_.modified();
+    }
+    // Replace the element at index
+    void set(size_t index, JsonRef<JsonValue> value) {
+        if (index >= values_.size()) {
+            throw std::out_of_range("Index out of bounds");
+        }
+        values_[index] = std::move(value);
+        state_.modified();
     }
     void clear() {
         values_.clear();
+        state_.modified();
+    }
+    
+    // Preallocate room for capacity elements
+    void reserve(size_t capacity) { values_.reserve(capacity); }
+    size_t capacity() const noexcept { return values_.capacity(); }
+    
+    // Append or insert the elements of [first, last) with a single
+    // reallocation at most; pass move iterators to move them in
+    template <typename InputIt>
+    void append_range(InputIt first, InputIt last) {
+        values_.insert(values_.end(), first, last);
+        state_.modified();
+    }
+    template <typename InputIt>
+    void insert_range(size_t index, InputIt first, InputIt last) {
+        if (index > values_.size()) {
+            throw std::out_of_range("Index out of bounds");
+        }
+        values_.insert(values_.begin() + static_cast<std::ptrdiff_t>(index), first, last);
+        state_.modified();
+    }
+    void append_range(std::vector<JsonRef<JsonValue>>&& values) {
+        append_range(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+        values.clear();
     }
     
-    std::shared_ptr<JsonValue> at(size_t index) const;
+    // Remove the element at index and hand over its reference
+    JsonRef<JsonValue> take(size_t index);
+    
+    // Element at index, for modification: a container element that is
+    // also referenced elsewhere is first replaced by its cow_clone()
+    JsonValue& mutable_at(size_t index);
+    
+    JsonRef<JsonValue> at(size_t index) const;
     size_t size() const noexcept { return values_.size(); }
     bool empty() const noexcept { return values_.empty(); }
     
@@ -190,48 +542,208 @@ public:
     auto begin() const { return values_.begin(); }
     auto end() const { return values_.end(); }
     
-    std::string to_string() const override;
-    bool equals(const JsonValue& other) const noexcept override;
-    std::shared_ptr<JsonValue> clone() const override;
+    // Keep the serialized form of this array once JsonSerializer has
+    // written it, and copy it into later output with the same options
+    // while nothing in the array has changed. Worth it for large subtrees
+    // that are written far more often than they change.
+    void cache_encoding(bool enabled = true) noexcept { state_.cache_encoding(enabled); }
+    const JsonContainerState& container_state() const noexcept { return state_; }
 
 private:
-    std::vector<std::shared_ptr<JsonValue>> values_;
+    friend class JsonValue;
+    
+    JsonValueVector values_;
+    JsonContainerState state_;
 };
 
 // Object value
 class JsonObject : public JsonValue {
 public:
-    JsonObject() = default;
+    JsonObject() : JsonValue(JsonType::Object), values_(heap_resource()) {}
+    explicit JsonObject(std::pmr::memory_resource* resource)
+        : JsonValue(JsonType::Object), values_(resource) {}
     
-    static std::shared_ptr<JsonObject> create() {
-        return std::shared_ptr<JsonObject>(new JsonObject());
+    static JsonRef<JsonObject> create() {
+        return make_value<JsonObject>();
     }
     
-    JsonType type() const noexcept override { return JsonType::Object; }
-    bool is_object() const noexcept override { return true; }
-    const JsonHash<std::string, std::shared_ptr<JsonValue>>& object_value() const override { return values_; }
+    const JsonObjectMap& values() const noexcept { return values_; }
     
     // Object operations
-    void set(const std::string& key, std::shared_ptr<JsonValue> value);
-    std::shared_ptr<JsonValue> get(const std::string& key) const;
-    bool has(const std::string& key) const;
-    void erase(const std::string& key);
+    void set(const std::string& key, JsonRef<JsonValue> value);
+    void set(std::string&& key, JsonRef<JsonValue> value);
+    void set(std::string_view key, JsonRef<JsonValue> value);
+    void set(const char* key, JsonRef<JsonValue> value);
+    
+    // Keys from a JsonKeyTable are shared rather than copied
+    void set(JsonKey key, JsonRef<JsonValue> value);
+    
+    // Create a T from args under key
+    template <typename T, typename K, typename... Args>
+    T& emplace(K&& key, Args&&... args) {
+        auto value = make_value<T>(std::forward<Args>(args)...);
+        T& node = *value;
+        set(std::forward<K>(key), std::move(value));
+        return node;
+    }
+    
+    // Lookups take any string-like key without copying it
+    JsonRef<JsonValue> get(std::string_view key) const;
+    bool has(std::string_view key) const;
+    void erase(std::string_view key);
+    
+    // Remove the member and hand over its reference (null if absent)
+    JsonRef<JsonValue> take(std::string_view key);
+    
+    // Member value for modification (null if absent): a container value
+    // that is also referenced elsewhere is first replaced by its
+    // cow_clone()
+    JsonValue* mutable_get(std::string_view key);
     size_t size() const noexcept { return values_.size(); }
     bool empty() const noexcept { return values_.empty(); }
-    void clear() { values_.clear(); }
+    void clear() {
+        values_.clear();
+        shape_.reset();
+        state_.modified();
+    }
+    
+    // Preallocate room (entries and index) for capacity members
+    void reserve(size_t capacity) { values_.reserve(capacity); }
+    
+    // Set every (key, value) pair of [first, last), reserving room first
+    // when the range size is known; pass move iterators to move them in
+    template <typename InputIt>
+    void insert_range(InputIt first, InputIt last) {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            reserve(values_.size() + static_cast<size_t>(std::distance(first, last)));
+        }
+        for (; first != last; ++first) {
+            auto&& member = *first;
+            set(std::get<0>(std::forward<decltype(member)>(member)),
+                std::get<1>(std::forward<decltype(member)>(member)));
+        }
+    }
     
     // Iterators
     auto begin() const { return values_.begin(); }
     auto end() const { return values_.end(); }
     
-    std::string to_string() const override;
-    bool equals(const JsonValue& other) const noexcept override;
-    std::shared_ptr<JsonValue> clone() const override;
+    // Key layout shared with other objects (see JsonShape), or null.
+    // Adding or removing a member drops the shape.
+    const std::shared_ptr<const JsonShape>& shape() const noexcept { return shape_; }
+    
+    // Take on shape if it matches the object's keys; returns false if not
+    bool adopt_shape(std::shared_ptr<const JsonShape> shape);
+    
+    // Value of the member at a position (a JsonShape slot)
+    const JsonRef<JsonValue>& slot(size_t index) const {
+        return (values_.begin() + static_cast<std::ptrdiff_t>(index))->second;
+    }
+
+    // Replace the value of the member at a position, keeping its key
+    void set_slot(size_t index, JsonRef<JsonValue> value) {
+        if (index >= values_.size()) {
+            throw std::out_of_range("Index out of bounds");
+        }
+        (values_.begin() + static_cast<std::ptrdiff_t>(index))->second = std::move(value);
+        state_.modified();
+    }
+
+    // Cache the serialized form, as JsonArray::cache_encoding does
+    void cache_encoding(bool enabled = true) noexcept { state_.cache_encoding(enabled); }
+    const JsonContainerState& container_state() const noexcept { return state_; }
+    
+    // Members in key order: the shape's order when the object has a shape,
+    // otherwise one built on first use and kept until the object changes.
+    // May be called by concurrent readers.
+    std::shared_ptr<const JsonKeyOrder> key_order() const;
 
 private:
-    JsonHash<std::string, std::shared_ptr<JsonValue>> values_;
+    friend class JsonValue;
+    
+    // Store value under key, dropping the shape if the key is new
+    template <typename K>
+    void assign(K&& key, JsonRef<JsonValue> value);
+    
+    JsonObjectMap values_;
+    std::shared_ptr<const JsonShape> shape_;
+    JsonContainerState state_;
+    mutable std::shared_ptr<const JsonKeyOrder> key_order_;
+};
+
+// Inline value accessors: a tag check and a direct load
+inline bool JsonValue::boolean_value() const {
+    if (type_ != JsonType::Boolean) {
+        throw_type_error("a boolean");
+    }
+    return static_cast<const JsonBoolean*>(this)->value();
+}
+
+inline double JsonValue::number_value() const {
+    if (type_ != JsonType::Number) {
+        throw_type_error("a number");
+    }
+    return static_cast<const JsonNumber*>(this)->value();
+}
+
+inline std::int64_t JsonValue::integer_value() const {
+    if (type_ != JsonType::Number) {
+        throw_type_error("a number");
+    }
+    return static_cast<const JsonNumber*>(this)->integer();
+}
+
+inline bool JsonValue::is_integer() const noexcept {
+    return type_ == JsonType::Number && static_cast<const JsonNumber*>(this)->is_integer();
+}
+
+inline bool JsonValue::is_real() const noexcept {
+    return type_ == JsonType::Number && !static_cast<const JsonNumber*>(this)->is_integer();
+}
+
+inline const std::string& JsonValue::string_value() const {
+    if (type_ != JsonType::String) {
+        throw_type_error("a string");
+    }
+    return static_cast<const JsonStringValue*>(this)->value();
+}
+
+inline const JsonValueVector& JsonValue::array_value() const {
+    if (type_ != JsonType::Array) {
+        throw_type_error("an array");
+    }
+    return static_cast<const JsonArray*>(this)->values();
+}
+
+inline const JsonObjectMap& JsonValue::object_value() const {
+    if (type_ != JsonType::Object) {
+        throw_type_error("an object");
+    }
+    return static_cast<const JsonObject*>(this)->values();
+}
+
+// Hash and equality by value, for hashed containers of values or refs,
+// e.g. std::unordered_set<JsonRef<JsonValue>, JsonValueHash, JsonValueEqual>
+struct JsonValueHash {
+    std::size_t operator()(const JsonValue& value) const noexcept { return value.hash(); }
+    template <typename T>
+    std::size_t operator()(const JsonRef<T>& value) const noexcept { return value ? value->hash() : 0; }
+};
+
+struct JsonValueEqual {
+    bool operator()(const JsonValue& lhs, const JsonValue& rhs) const noexcept { return lhs.equals(rhs); }
+    template <typename T, typename U>
+    bool operator()(const JsonRef<T>& lhs, const JsonRef<U>& rhs) const noexcept {
+        return lhs && rhs ? lhs->equals(*rhs) : !lhs && !rhs;
+    }
 };
 
 } // namespace jansson
 
+template <>
+struct std::hash<jansson::JsonValue> {
+    std::size_t operator()(const jansson::JsonValue& value) const noexcept { return value.hash(); }
+};
+
 #endif // JSON_VALUE_HPP
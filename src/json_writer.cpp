@@ -0,0 +1,220 @@
+#include "json_writer.hpp"
+#include "json_simd.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace jansson {
+
+namespace {
+
+constexpr char hex_digits[] = "0123456789abcdef";
+
+} // namespace
+
+void JsonWriter::write_slow(const char* data, std::size_t length) {
+    for (;;) {
+        std::size_t chunk = std::min(length, static_cast<std::size_t>(end_ - cursor_));
+        if (chunk > 0) {
+            std::memcpy(cursor_, data, chunk);
+            cursor_ += chunk;
+            data += chunk;
+            length -= chunk;
+        }
+        if (length == 0) {
+            return;
+        }
+        if (!grow(length)) {
+            dropped_ += length;
+            return;
+        }
+    }
+}
+
+void JsonWriter::fill(char c, std::size_t count) {
+    while (count > 0) {
+        if (cursor_ == end_ && !grow(count)) {
+            dropped_ += count;
+            return;
+        }
+        std::size_t chunk = std::min(count, static_cast<std::size_t>(end_ - cursor_));
+        std::memset(cursor_, c, chunk);
+        cursor_ += chunk;
+        count -= chunk;
+    }
+}
+
+void JsonWriter::write_escaped(std::string_view text) {
+    put('"');
+
+    const char* data = text.data();
+    std::size_t length = text.size();
+    std::size_t i = 0;
+
+    while (i < length) {
+        // Copy the run that needs no escaping in one go
+        std::size_t run = simd::find_escape(data + i, length - i);
+        if (run > 0) {
+            write(data + i, run);
+            i += run;
+            if (i == length) {
+                break;
+            }
+        }
+
+        unsigned char c = static_cast<unsigned char>(data[i++]);
+        switch (c) {
+            case '"': write("\\\"", 2); break;
+            case '\\': write("\\\\", 2); break;
+            case '\b': write("\\b", 2); break;
+            case '\f': write("\\f", 2); break;
+            case '\n': write("\\n", 2); break;
+            case '\r': write("\\r", 2); break;
+            case '\t': write("\\t", 2); break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xF]};
+                write(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+
+    put('"');
+}
+
+// JsonStringWriter implementation
+JsonStringWriter::JsonStringWriter(std::size_t initial_capacity)
+    : buffer_(std::max<std::size_t>(initial_capacity, 16), '\0')
+{
+    set_buffer(buffer_.data(), buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+std::string JsonStringWriter::take() {
+    buffer_.resize(buffered());
+    std::string result = std::move(buffer_);
+    buffer_.assign(16, '\0');
+    set_buffer(buffer_.data(), buffer_.data(), buffer_.data() + buffer_.size());
+    return result;
+}
+
+void JsonStringWriter::clear(std::size_t max_capacity) {
+    if (buffer_.size() > max_capacity) {
+        std::string().swap(buffer_);
+        buffer_.assign(16, '\0');
+    }
+    set_buffer(buffer_.data(), buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+bool JsonStringWriter::grow(std::size_t needed) {
+    std::size_t used = buffered();
+    buffer_.resize(std::max(buffer_.size() * 2, used + needed));
+    set_buffer(buffer_.data(), buffer_.data() + used, buffer_.data() + buffer_.size());
+    return true;
+}
+
+// JsonBufferWriter implementation
+JsonBufferWriter::JsonBufferWriter(char* buffer, std::size_t size) noexcept {
+    set_buffer(buffer, buffer, buffer + size);
+}
+
+bool JsonBufferWriter::grow(std::size_t) {
+    return false;
+}
+
+// JsonChunkedWriter implementation
+JsonChunkedWriter::JsonChunkedWriter(std::size_t chunk_size)
+    : buffer_(new char[std::max<std::size_t>(chunk_size, 16)]),
+      capacity_(std::max<std::size_t>(chunk_size, 16))
+{
+    set_buffer(buffer_.get(), buffer_.get(), buffer_.get() + capacity_);
+}
+
+void JsonChunkedWriter::flush() {
+    std::size_t pending = buffered();
+    if (pending > 0) {
+        if (!failed_ && write_chunk(buffer_.get(), pending)) {
+            add_flushed(pending);
+        } else {
+            failed_ = true;
+            add_dropped(pending);
+        }
+    }
+    set_buffer(buffer_.get(), buffer_.get(), buffer_.get() + capacity_);
+}
+
+bool JsonChunkedWriter::grow(std::size_t) {
+    flush();
+    return !failed_;
+}
+
+// JsonStreamWriter implementation
+JsonStreamWriter::JsonStreamWriter(std::ostream& os, std::size_t chunk_size)
+    : JsonChunkedWriter(chunk_size), os_(os) {}
+
+JsonStreamWriter::~JsonStreamWriter() {
+    flush();
+}
+
+bool JsonStreamWriter::write_chunk(const char* data, std::size_t length) {
+    os_.write(data, static_cast<std::streamsize>(length));
+    return static_cast<bool>(os_);
+}
+
+// JsonCallbackWriter implementation
+JsonCallbackWriter::JsonCallbackWriter(Callback callback, std::size_t chunk_size)
+    : JsonChunkedWriter(chunk_size), callback_(std::move(callback)) {}
+
+JsonCallbackWriter::~JsonCallbackWriter() {
+    flush();
+}
+
+bool JsonCallbackWriter::write_chunk(const char* data, std::size_t length) {
+    return callback_(data, length);
+}
+
+// JsonFileWriter implementation
+JsonFileWriter::JsonFileWriter(std::FILE* file, std::size_t chunk_size)
+    : JsonChunkedWriter(chunk_size), file_(file) {}
+
+JsonFileWriter::~JsonFileWriter() {
+    flush();
+}
+
+bool JsonFileWriter::write_chunk(const char* data, std::size_t length) {
+    return std::fwrite(data, 1, length, file_) == length;
+}
+
+// JsonFdWriter implementation
+JsonFdWriter::JsonFdWriter(int fd, std::size_t chunk_size)
+    : JsonChunkedWriter(chunk_size), fd_(fd) {}
+
+JsonFdWriter::~JsonFdWriter() {
+    flush();
+}
+
+bool JsonFdWriter::write_chunk(const char* data, std::size_t length) {
+    while (length > 0) {
+#if defined(_WIN32)
+        int written = _write(fd_, data, static_cast<unsigned>(length));
+#else
+        ssize_t written = ::write(fd_, data, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        length -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+} // namespace jansson
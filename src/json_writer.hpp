@@ -0,0 +1,216 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace jansson {
+
+// Output buffer used by the serializer.
+//
+// Bytes are appended into a contiguous window [cursor, end); the common
+// case is a bounds check and a memcpy. Only when the window is exhausted
+// does the writer call grow(), which a subclass implements by enlarging
+// its buffer, flushing it to a sink, or refusing. Bytes that a writer
+// refuses are still counted, so size() always reports the full length of
+// the output.
+class JsonWriter {
+public:
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+    virtual ~JsonWriter() = default;
+
+    void put(char c) {
+        if (cursor_ == end_ && !grow(1)) {
+            ++dropped_;
+            return;
+        }
+        *cursor_++ = c;
+    }
+
+    void write(const char* data, std::size_t length) {
+        if (static_cast<std::size_t>(end_ - cursor_) >= length) {
+            std::memcpy(cursor_, data, length);
+            cursor_ += length;
+        } else {
+            write_slow(data, length);
+        }
+    }
+
+    void write(std::string_view text) { write(text.data(), text.size()); }
+
+    // Append count copies of c (indentation)
+    void fill(char c, std::size_t count);
+
+    // Append text as a quoted JSON string, escaping as required
+    void write_escaped(std::string_view text);
+
+    // Total number of bytes written, including any the writer refused
+    std::size_t size() const noexcept {
+        return flushed_ + static_cast<std::size_t>(cursor_ - begin_) + dropped_;
+    }
+
+    // Whether some output was refused (fixed buffer too small, sink error)
+    bool truncated() const noexcept { return dropped_ != 0; }
+
+    // Hand buffered bytes to the sink, if the writer has one
+    virtual void flush() {}
+
+protected:
+    JsonWriter() = default;
+
+    // Make room for more output, typically by calling set_buffer(). `needed`
+    // is the number of bytes pending; at least one byte of space must be
+    // available on success. Returns false if no more output can be accepted.
+    virtual bool grow(std::size_t needed) = 0;
+
+    void set_buffer(char* begin, char* cursor, char* end) noexcept {
+        begin_ = begin;
+        cursor_ = cursor;
+        end_ = end;
+    }
+
+    char* buffer_begin() const noexcept { return begin_; }
+    std::size_t buffered() const noexcept { return static_cast<std::size_t>(cursor_ - begin_); }
+
+    // Account for bytes handed to a sink when the buffer is recycled
+    void add_flushed(std::size_t bytes) noexcept { flushed_ += bytes; }
+
+    // Account for buffered bytes a sink refused
+    void add_dropped(std::size_t bytes) noexcept { dropped_ += bytes; }
+
+private:
+    void write_slow(const char* data, std::size_t length);
+
+    char* begin_ = nullptr;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t flushed_ = 0;
+    std::size_t dropped_ = 0;
+};
+
+// Writer that accumulates output in a growable std::string
+class JsonStringWriter : public JsonWriter {
+public:
+    explicit JsonStringWriter(std::size_t initial_capacity = 256);
+
+    // Output written so far
+    std::string_view view() const noexcept { return std::string_view(buffer_.data(), buffered()); }
+
+    // Move the output out; the writer is empty afterwards
+    std::string take();
+
+    // Discard the output but keep the buffer for the next use, unless it
+    // has grown beyond max_capacity bytes
+    void clear(std::size_t max_capacity = static_cast<std::size_t>(-1));
+
+protected:
+    bool grow(std::size_t needed) override;
+
+private:
+    std::string buffer_;
+};
+
+// Writer into a caller-supplied fixed buffer. Output that does not fit is
+// discarded but counted, so size() reports the space that would be needed.
+// No terminating NUL is written.
+class JsonBufferWriter : public JsonWriter {
+public:
+    JsonBufferWriter(char* buffer, std::size_t size) noexcept;
+
+protected:
+    bool grow(std::size_t needed) override;
+};
+
+// Base for writers that collect output in a fixed-size buffer and hand it
+// to a sink one chunk at a time, so the whole document never has to exist
+// in memory. Subclasses call flush() from their destructor.
+class JsonChunkedWriter : public JsonWriter {
+public:
+    static constexpr std::size_t default_chunk_size = 4096;
+
+    // Pass buffered output to the sink
+    void flush() override;
+
+    // Whether the sink reported an error; later output is dropped
+    bool failed() const noexcept { return failed_; }
+
+protected:
+    explicit JsonChunkedWriter(std::size_t chunk_size = default_chunk_size);
+
+    bool grow(std::size_t needed) override;
+
+    // Deliver one chunk; returns false on error
+    virtual bool write_chunk(const char* data, std::size_t length) = 0;
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    std::size_t capacity_;
+    bool failed_ = false;
+};
+
+// Writer that flushes to a std::ostream
+class JsonStreamWriter : public JsonChunkedWriter {
+public:
+    explicit JsonStreamWriter(std::ostream& os, std::size_t chunk_size = default_chunk_size);
+    ~JsonStreamWriter() override;
+
+protected:
+    bool write_chunk(const char* data, std::size_t length) override;
+
+private:
+    std::ostream& os_;
+};
+
+// Writer that flushes to a callback
+class JsonCallbackWriter : public JsonChunkedWriter {
+public:
+    // Receives each chunk; returns false to report an error
+    using Callback = std::function<bool(const char* data, std::size_t length)>;
+
+    explicit JsonCallbackWriter(Callback callback, std::size_t chunk_size = default_chunk_size);
+    ~JsonCallbackWriter() override;
+
+protected:
+    bool write_chunk(const char* data, std::size_t length) override;
+
+private:
+    Callback callback_;
+};
+
+// Writer that flushes to a stdio stream
+class JsonFileWriter : public JsonChunkedWriter {
+public:
+    explicit JsonFileWriter(std::FILE* file, std::size_t chunk_size = default_chunk_size);
+    ~JsonFileWriter() override;
+
+protected:
+    bool write_chunk(const char* data, std::size_t length) override;
+
+private:
+    std::FILE* file_;
+};
+
+// Writer that flushes to a file descriptor (file, pipe or socket),
+// retrying short writes
+class JsonFdWriter : public JsonChunkedWriter {
+public:
+    explicit JsonFdWriter(int fd, std::size_t chunk_size = default_chunk_size);
+    ~JsonFdWriter() override;
+
+protected:
+    bool write_chunk(const char* data, std::size_t length) override;
+
+private:
+    int fd_;
+};
+
+} // namespace jansson
+
+#endif // JSON_WRITER_HPP
@@ -0,0 +1,172 @@
+#include "memory_policy.hpp"
+#include "json_stats.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace jansson {
+
+namespace {
+
+std::atomic<JsonMallocFunction> malloc_function{&std::malloc};
+std::atomic<JsonFreeFunction> free_function{&std::free};
+
+// Memory resource over allocate_memory. Every instance is interchangeable.
+class HeapResource : public std::pmr::memory_resource {
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (alignment > alignof(std::max_align_t)) {
+            throw std::bad_alloc();
+        }
+        return allocate_memory(bytes);
+    }
+
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t) override {
+        deallocate_memory(pointer, bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return dynamic_cast<const HeapResource*>(&other) != nullptr;
+    }
+};
+
+// Node sizes are rounded up to a multiple of this, whether or not the
+// pool is on, so that any block of a class can serve any size in it
+constexpr std::size_t node_granularity = 8;
+constexpr std::size_t node_classes = max_pooled_node_size / node_granularity;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Trivially destructible, so frees made by other destructors at thread
+// exit can still consult it; the blocks are freed by NodePoolOwner
+struct NodePool {
+    FreeBlock* blocks[node_classes];
+    std::uint32_t counts[node_classes];
+    std::size_t limit;
+    bool gone;
+};
+
+thread_local NodePool node_pool{};
+
+struct NodePoolOwner {
+    ~NodePoolOwner() {
+        trim_node_pool();
+        node_pool.limit = 0;
+        node_pool.gone = true;
+    }
+};
+
+std::size_t rounded_node_size(std::size_t size) noexcept {
+    return (size + node_granularity - 1) & ~(node_granularity - 1);
+}
+
+} // namespace
+
+void set_node_pool_limit(std::size_t blocks) noexcept {
+    if (node_pool.gone) {
+        return;
+    }
+    // The owner frees the pool at thread exit once the pool was ever on
+    static thread_local NodePoolOwner owner;
+    (void)owner;
+    node_pool.limit = blocks;
+    for (std::size_t i = 0; i < node_classes; ++i) {
+        while (node_pool.counts[i] > blocks) {
+            FreeBlock* block = node_pool.blocks[i];
+            node_pool.blocks[i] = block->next;
+            node_pool.counts[i]--;
+            deallocate_memory(block, (i + 1) * node_granularity);
+        }
+    }
+}
+
+std::size_t node_pool_limit() noexcept {
+    return node_pool.limit;
+}
+
+void trim_node_pool() noexcept {
+    for (std::size_t i = 0; i < node_classes; ++i) {
+        FreeBlock* block = node_pool.blocks[i];
+        while (block) {
+            FreeBlock* next = block->next;
+            deallocate_memory(block, (i + 1) * node_granularity);
+            block = next;
+        }
+        node_pool.blocks[i] = nullptr;
+        node_pool.counts[i] = 0;
+    }
+}
+
+void* allocate_node(std::size_t size) {
+    if (size > max_pooled_node_size) {
+        return allocate_memory(size);
+    }
+    size = rounded_node_size(size);
+    std::size_t index = size / node_granularity - 1;
+    if (FreeBlock* block = node_pool.blocks[index]) {
+        node_pool.blocks[index] = block->next;
+        node_pool.counts[index]--;
+        return block;
+    }
+    return allocate_memory(size);
+}
+
+void deallocate_node(void* pointer, std::size_t size) noexcept {
+    if (size > max_pooled_node_size) {
+        deallocate_memory(pointer, size);
+        return;
+    }
+    size = rounded_node_size(size);
+    std::size_t index = size / node_granularity - 1;
+    if (pointer && node_pool.counts[index] < node_pool.limit) {
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = node_pool.blocks[index];
+        node_pool.blocks[index] = block;
+        node_pool.counts[index]++;
+        return;
+    }
+    deallocate_memory(pointer, size);
+}
+
+void set_allocation_functions(JsonMallocFunction malloc_fn, JsonFreeFunction free_fn) noexcept {
+    malloc_function.store(malloc_fn ? malloc_fn : &std::malloc, std::memory_order_relaxed);
+    free_function.store(free_fn ? free_fn : &std::free, std::memory_order_relaxed);
+}
+
+void get_allocation_functions(JsonMallocFunction* malloc_fn, JsonFreeFunction* free_fn) noexcept {
+    if (malloc_fn) {
+        *malloc_fn = malloc_function.load(std::memory_order_relaxed);
+    }
+    if (free_fn) {
+        *free_fn = free_function.load(std::memory_order_relaxed);
+    }
+}
+
+void* allocate_memory(std::size_t size) {
+    // malloc(0) may return null, which is not a failure
+    void* pointer = malloc_function.load(std::memory_order_relaxed)(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    stats_detail::allocated(size);
+    return pointer;
+}
+
+void deallocate_memory(void* pointer, std::size_t size) noexcept {
+    if (pointer) {
+        stats_detail::freed(size);
+        free_function.load(std::memory_order_relaxed)(pointer);
+    }
+}
+
+std::pmr::memory_resource* heap_resource() noexcept {
+    // Never destroyed, so containers in static objects can still free
+    // their storage during exit
+    alignas(HeapResource) static unsigned char storage[sizeof(HeapResource)];
+    static HeapResource* resource = new (storage) HeapResource();
+    return resource;
+}
+
+} // namespace jansson
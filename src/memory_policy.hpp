@@ -2,11 +2,53 @@
 #define MEMORY_POLICY_HPP
 
 #include <memory>
+#include <memory_resource>
 #include <vector>
 #include <unordered_map>
+#include <cstddef>
+#include <cstdint>
 
 namespace jansson {
 
+// Functions behind every allocation the library makes for itself: nodes,
+// container storage, key records, arena blocks and json_malloc. The
+// defaults are malloc and free. Replace them before any library memory is
+// allocated; a block is always freed through the function current at the
+// time, which must therefore be able to free it.
+using JsonMallocFunction = void* (*)(std::size_t);
+using JsonFreeFunction = void (*)(void*);
+
+void set_allocation_functions(JsonMallocFunction malloc_fn, JsonFreeFunction free_fn) noexcept;
+void get_allocation_functions(JsonMallocFunction* malloc_fn, JsonFreeFunction* free_fn) noexcept;
+
+// Allocate through the current functions; throws std::bad_alloc on failure.
+// The size given to deallocate_memory must be the size allocated.
+void* allocate_memory(std::size_t size);
+void deallocate_memory(void* pointer, std::size_t size) noexcept;
+
+// Memory resource over allocate_memory, used by containers outside an arena.
+// Alignments beyond alignof(std::max_align_t) are not supported.
+std::pmr::memory_resource* heap_resource() noexcept;
+
+// Heap nodes are allocated through allocate_node. A thread can keep the
+// nodes it frees on free lists, one per size class up to
+// max_pooled_node_size bytes, and hand them out again to its next
+// allocations, so a worker that builds and drops similar trees for every
+// request stops reaching the allocation functions for nodes. Pools are off
+// (a limit of 0) until a thread enables its own; the limit is the number of
+// blocks kept per size class. Pooled blocks stay allocated, and counted as
+// in use by the stats, until trim_node_pool() or the thread exits.
+constexpr std::size_t max_pooled_node_size = 256;
+
+void set_node_pool_limit(std::size_t blocks) noexcept;
+std::size_t node_pool_limit() noexcept;
+
+// Free the blocks the calling thread's pool holds
+void trim_node_pool() noexcept;
+
+void* allocate_node(std::size_t size);
+void deallocate_node(void* pointer, std::size_t size) noexcept;
+
 // Allocator concept for JSON library
 template <typename T>
 class JsonAllocator {
@@ -18,11 +60,11 @@ public:
     JsonAllocator(const JsonAllocator<U>&) noexcept {}
     
     T* allocate(std::size_t n) {
-        return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(allocate_memory(n * sizeof(T)));
     }
     
-    void deallocate(T* p, std::size_t) noexcept {
-        ::operator delete(p);
+    void deallocate(T* p, std::size_t n) noexcept {
+        deallocate_memory(p, n * sizeof(T));
     }
 };
 
@@ -30,62 +72,177 @@ public:
 template <typename T>
 using DefaultAllocator = std::allocator<T>;
 
-// Arena allocator for bulk allocations
+// Monotonic arena: memory is carved out of large blocks and released all
+// at once by reset() or the destructor. Individual deallocation is a no-op.
+// As a std::pmr::memory_resource it can back containers directly, so a
+// whole tree (nodes and container storage) can come from one arena.
+class JsonArena : public std::pmr::memory_resource {
+public:
+    explicit JsonArena(std::size_t block_size = 64 * 1024)
+        : block_size_(block_size < 256 ? 256 : block_size) {}
+    
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
+    
+    ~JsonArena() override {
+        release();
+    }
+    
+    // Make all memory available again. The current block is kept so a
+    // worker thread that resets between requests does not hit the system
+    // allocator in steady state.
+    void reset() noexcept {
+        char* keep = current_block_ && current_size_ == block_size_ ? current_block_ : nullptr;
+        for (const Block& block : blocks_) {
+            if (block.data != keep) {
+                deallocate_memory(block.data, block.size);
+            }
+        }
+        blocks_.clear();
+        bytes_used_ = 0;
+        bytes_reserved_ = 0;
+        current_block_ = keep;
+        current_offset_ = 0;
+        current_size_ = 0;
+        if (keep) {
+            blocks_.push_back({keep, block_size_});
+            bytes_reserved_ = block_size_;
+            current_size_ = block_size_;
+        }
+    }
+    
+    // Return every block to the system
+    void release() noexcept {
+        for (const Block& block : blocks_) {
+            deallocate_memory(block.data, block.size);
+        }
+        blocks_.clear();
+        current_block_ = nullptr;
+        current_size_ = 0;
+        current_offset_ = 0;
+        bytes_used_ = 0;
+        bytes_reserved_ = 0;
+    }
+    
+    std::size_t bytes_used() const noexcept { return bytes_used_; }
+    std::size_t bytes_reserved() const noexcept { return bytes_reserved_; }
+    std::size_t block_size() const noexcept { return block_size_; }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (current_block_) {
+            char* p = align_up(current_block_ + current_offset_, alignment);
+            if (p + bytes <= current_block_ + current_size_) {
+                current_offset_ = static_cast<std::size_t>(p - current_block_) + bytes;
+                bytes_used_ += bytes;
+                return p;
+            }
+        }
+        
+        if (bytes + alignment > block_size_ / 4) {
+            // Large allocations get a dedicated block so the current block
+            // keeps serving small nodes
+            char* block = new_block(bytes + alignment);
+            bytes_used_ += bytes;
+            return align_up(block, alignment);
+        }
+        
+        current_block_ = new_block(block_size_);
+        current_size_ = block_size_;
+        char* p = align_up(current_block_, alignment);
+        current_offset_ = static_cast<std::size_t>(p - current_block_) + bytes;
+        bytes_used_ += bytes;
+        return p;
+    }
+    
+    void do_deallocate(void*, std::size_t, std::size_t) override {
+        // Memory is reclaimed by reset() or release()
+    }
+    
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    static char* align_up(char* p, std::size_t alignment) noexcept {
+        auto address = reinterpret_cast<std::uintptr_t>(p);
+        address = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+        return reinterpret_cast<char*>(address);
+    }
+    
+    char* new_block(std::size_t size) {
+        char* block = static_cast<char*>(allocate_memory(size));
+        try {
+            blocks_.push_back({block, size});
+        } catch (...) {
+            deallocate_memory(block, size);
+            throw;
+        }
+        bytes_reserved_ += size;
+        return block;
+    }
+    
+    struct Block {
+        char* data;
+        std::size_t size;
+    };
+    
+    std::size_t block_size_;
+    std::vector<Block> blocks_;
+    char* current_block_ = nullptr;
+    std::size_t current_size_ = 0;
+    std::size_t current_offset_ = 0;
+    std::size_t bytes_used_ = 0;
+    std::size_t bytes_reserved_ = 0;
+};
+
+// Memory resource for containers: the arena when given, the heap resource
+// otherwise
+inline std::pmr::memory_resource* memory_resource_of(JsonArena* arena) noexcept {
+    return arena ? static_cast<std::pmr::memory_resource*>(arena)
+                 : heap_resource();
+}
+
+// Allocator handle over a JsonArena. Copies and rebinds share the same
+// arena, so it can be used with allocate_shared and standard containers.
+// The arena must outlive everything allocated through the handle.
 template <typename T>
 class ArenaAllocator {
 public:
     using value_type = T;
     
-    explicit ArenaAllocator(std::size_t block_size = 4096)
-        : block_size_(block_size) {}
+    explicit ArenaAllocator(JsonArena& arena) noexcept
+        : arena_(&arena) {}
     
     template <typename U>
     ArenaAllocator(const ArenaAllocator<U>& other) noexcept
-        : block_size_(other.block_size_) {}
+        : arena_(other.arena_) {}
     
     T* allocate(std::size_t n) {
-        if (n > block_size_) {
-            // Fall back to regular allocation for large objects
-            return static_cast<T*>(::operator new(n * sizeof(T)));
-        }
-        
-        if (!current_block_ || current_offset_ + n * sizeof(T) > block_size_) {
-            // Allocate new block
-            current_block_ = static_cast<char*>(::operator new(block_size_));
-            current_offset_ = 0;
-            blocks_.push_back(current_block_);
-        }
-        
-        T* result = reinterpret_cast<T*>(current_block_ + current_offset_);
-        current_offset_ += n * sizeof(T);
-        return result;
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
     }
     
     void deallocate(T*, std::size_t) noexcept {
         // Arena allocator doesn't free individual objects
     }
     
-    ~ArenaAllocator() {
-        for (char* block : blocks_) {
-            ::operator delete(block);
-        }
+    JsonArena& arena() const noexcept { return *arena_; }
+    
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ == other.arena_;
     }
     
-    // Reset the arena (deallocates all memory)
-    void reset() {
-        for (char* block : blocks_) {
-            ::operator delete(block);
-        }
-        blocks_.clear();
-        current_block_ = nullptr;
-        current_offset_ = 0;
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ != other.arena_;
     }
 
 private:
-    std::size_t block_size_;
-    std::vector<char*> blocks_;
-    char* current_block_ = nullptr;
-    std::size_t current_offset_ = 0;
+    template <typename U>
+    friend class ArenaAllocator;
+    
+    JsonArena* arena_;
 };
 
 // Resource management pointer
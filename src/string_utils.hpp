@@ -1,12 +1,124 @@
 #ifndef STRING_UTILS_HPP
 #define STRING_UTILS_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
 
 namespace jansson {
 
+namespace unicode_detail {
+
+// Value of each byte as a hex digit, or -1
+struct HexTable {
+    std::int8_t values[256];
+
+    constexpr HexTable() : values() {
+        for (int i = 0; i < 256; ++i) {
+            values[i] = -1;
+        }
+        for (int i = 0; i < 10; ++i) {
+            values['0' + i] = static_cast<std::int8_t>(i);
+        }
+        for (int i = 0; i < 6; ++i) {
+            values['a' + i] = static_cast<std::int8_t>(10 + i);
+            values['A' + i] = static_cast<std::int8_t>(10 + i);
+        }
+    }
+};
+
+inline constexpr HexTable hex_table{};
+
+} // namespace unicode_detail
+
+// Value of the four hex digits at text, or -1 if one is not a hex digit
+inline std::int32_t decode_hex4(const char* text) noexcept {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text);
+    const std::int8_t* values = unicode_detail::hex_table.values;
+    const int v0 = values[bytes[0]];
+    const int v1 = values[bytes[1]];
+    const int v2 = values[bytes[2]];
+    const int v3 = values[bytes[3]];
+    if ((v0 | v1 | v2 | v3) < 0) {
+        return -1;
+    }
+    return static_cast<std::int32_t>((static_cast<std::uint32_t>(v0) << 12) |
+                                     (static_cast<std::uint32_t>(v1) << 8) |
+                                     (static_cast<std::uint32_t>(v2) << 4) |
+                                     static_cast<std::uint32_t>(v3));
+}
+
+// Append a code point (at most 0x10FFFF) as UTF-8
+inline void append_utf8(std::uint32_t code_point, std::string& out) {
+    char buffer[4];
+    std::size_t length;
+    if (code_point <= 0x7F) {
+        buffer[0] = static_cast<char>(code_point);
+        length = 1;
+    } else if (code_point <= 0x7FF) {
+        buffer[0] = static_cast<char>(0xC0 | (code_point >> 6));
+        buffer[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+        length = 2;
+    } else if (code_point <= 0xFFFF) {
+        buffer[0] = static_cast<char>(0xE0 | (code_point >> 12));
+        buffer[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        buffer[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+        length = 3;
+    } else {
+        buffer[0] = static_cast<char>(0xF0 | (code_point >> 18));
+        buffer[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        buffer[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        buffer[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+        length = 4;
+    }
+    out.append(buffer, length);
+}
+
+// How a \u escape failed to decode
+enum class UnicodeEscapeError {
+    None,
+    InvalidHex,         // fewer than four hex digits
+    UnpairedSurrogate   // a surrogate not part of a high-low pair
+};
+
+// Decode the \u escape whose hex digits start at text (length bytes
+// available) and append its code point to out as UTF-8. A high surrogate
+// must be followed by a \u escape of a low surrogate, and the pair
+// decodes to one code point. Returns the bytes used from text (4, or 10
+// for a pair), or 0 with error set. Shared by the parsers and
+// JsonString::unescape.
+inline std::size_t decode_unicode_escape(const char* text, std::size_t length, std::string& out,
+                                         UnicodeEscapeError& error) {
+    std::int32_t unit = length >= 4 ? decode_hex4(text) : -1;
+    if (unit < 0) {
+        error = UnicodeEscapeError::InvalidHex;
+        return 0;
+    }
+    if (unit < 0xD800 || unit > 0xDFFF) {
+        append_utf8(static_cast<std::uint32_t>(unit), out);
+        return 4;
+    }
+    if (unit >= 0xDC00 || length < 10 || text[4] != '\\' || text[5] != 'u') {
+        error = UnicodeEscapeError::UnpairedSurrogate;
+        return 0;
+    }
+    std::int32_t low = decode_hex4(text + 6);
+    if (low < 0) {
+        error = UnicodeEscapeError::InvalidHex;
+        return 0;
+    }
+    if (low < 0xDC00 || low > 0xDFFF) {
+        error = UnicodeEscapeError::UnpairedSurrogate;
+        return 0;
+    }
+    append_utf8(0x10000 + ((static_cast<std::uint32_t>(unit) - 0xD800) << 10) +
+                    (static_cast<std::uint32_t>(low) - 0xDC00),
+                out);
+    return 10;
+}
+
 class JsonString {
 public:
     // Construct from string (validates UTF-8)
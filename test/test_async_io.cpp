@@ -0,0 +1,138 @@
+#include <iostream>
+#include <cassert>
+#include <cerrno>
+#include <string>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "json_async.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static std::string pull(JsonStreamSerializer& serializer, size_t step) {
+    std::string out;
+    char buffer[64];
+    while (size_t count = serializer.read(buffer, std::min(step, sizeof(buffer)))) {
+        out.append(buffer, count);
+    }
+    assert(serializer.done());
+    return out;
+}
+
+// The pull serializer writes what JsonSerializer does, whatever the read size
+static void check_same(const JsonRef<JsonValue>& value, const JsonSerializeOptions& options) {
+    std::string expected = JsonSerializer::serialize(*value, options);
+    for (size_t step : {1, 7, 64}) {
+        JsonStreamSerializer serializer(value, options);
+        assert(pull(serializer, step) == expected);
+        assert(serializer.bytes_consumed() == expected.size());
+    }
+}
+
+static void set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    assert(flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+int main() {
+    std::cout << "Running test_async_io..." << std::endl;
+
+    auto document = JsonParser::parse(
+        "{\"name\": \"caf\\u00e9\", \"empty\": {}, \"list\": [], \"nested\": "
+        "{\"z\": [1, 2.5, [true, false, null]], \"a\": \"tab\\t\"}, \"n\": -7}").value();
+    JsonSerializeOptions plain;
+    JsonSerializeOptions pretty;
+    pretty.pretty_print = true;
+    pretty.indent = 3;
+    JsonSerializeOptions compact_sorted;
+    compact_sorted.compact = true;
+    compact_sorted.sort_keys = true;
+    JsonSerializeOptions pretty_sorted = pretty;
+    pretty_sorted.sort_keys = true;
+    for (const auto& options : {plain, pretty, compact_sorted, pretty_sorted}) {
+        check_same(document, options);
+        check_same(JsonParser::parse("[[], {}, [[[]]]]").value(), options);
+        check_same(JsonParser::parse("\"scalar\"").value(), options);
+    }
+
+    // A subtree that caches its encoding is written from the cache
+    auto cached = JsonParser::parse("[{\"k\": [1, 2]}, 3]").value();
+    static_cast<JsonObject&>(static_cast<JsonArray&>(*cached).mutable_at(0)).cache_encoding();
+    check_same(cached, plain);
+    check_same(cached, pretty);
+
+    // peek() and consume() hand out the output without copying
+    JsonStreamSerializer serializer(document);
+    std::string_view head = serializer.peek(5);
+    assert(head.size() >= 5 && head.substr(0, 9) == "{\"name\": ");
+    serializer.consume(2);
+    assert(serializer.peek(1).substr(0, 4) == "name");
+    assert(serializer.bytes_consumed() == 2 && !serializer.done());
+
+    // A large array goes through a small socket buffer in pieces, parsed on
+    // the other side as it arrives
+    auto large = JsonArray::create();
+    for (int i = 0; i < 20000; ++i) {
+        auto item = JsonObject::create();
+        item->set("id", JsonNumber::create(i));
+        item->set("label", JsonStringValue::create("item number " + std::to_string(i)));
+        large->push_back(item);
+    }
+    JsonRef<JsonValue> body = large;
+    std::string expected = JsonSerializer::serialize(*body);
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    set_nonblocking(fds[0]);
+    set_nonblocking(fds[1]);
+    int size = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    JsonFdSender sender(fds[0], body, JsonSerializeOptions(), 1024);
+    JsonFdReader reader(fds[1], 1500);
+    int blocked = 0;
+    bool sent = false;
+    bool received = false;
+    while (!received) {
+        if (!sent) {
+            auto status = sender.send();
+            assert(status);
+            if (status.value() == JsonIoStatus::Complete) {
+                sent = true;
+                assert(sender.done() && sender.bytes_sent() == expected.size());
+                close(fds[0]);
+            } else {
+                ++blocked;
+            }
+        }
+        auto status = reader.read();
+        assert(status);
+        received = status.value() == JsonIoStatus::Complete;
+    }
+    assert(blocked > 0);
+    assert(reader.bytes_read() == expected.size());
+    assert(reader.parser().value_count() == 1);
+    assert(reader.parser().take_value()->equals(*body));
+    assert(reader.read() && reader.read().value() == JsonIoStatus::Complete);
+    close(fds[1]);
+
+    // Malformed input fails with the parser's error, a bad descriptor with errno
+    int pipe_fds[2];
+    assert(pipe(pipe_fds) == 0);
+    set_nonblocking(pipe_fds[0]);
+    JsonFdReader bad(pipe_fds[0]);
+    assert(bad.read().value() == JsonIoStatus::WouldBlock);
+    assert(write(pipe_fds[1], "[1, }", 5) == 5);
+    assert(bad.read().error() == make_error_code(JsonErrorCode::ParseError));
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+
+    JsonFdSender closed(-1, document);
+    assert(closed.send().error() == std::error_code(EBADF, std::generic_category()));
+
+    std::cout << "test_async_io passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_binary.hpp"
+#include "json_document.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static std::string bytes(std::initializer_list<int> values) {
+    std::string result;
+    for (int value : values) {
+        result += static_cast<char>(value);
+    }
+    return result;
+}
+
+static void test_round_trip(JsonBinaryFormat format) {
+    std::string input = "{\"name\": \"service\", \"ok\": true, \"off\": false, \"none\": null,"
+                        " \"small\": 7, \"negative\": -33, \"big\": 9007199254740993,"
+                        " \"min\": -9223372036854775808, \"max\": 9223372036854775807,"
+                        " \"half\": 0.5, \"pi\": 3.141592653589793, \"text\": \"caf\\u00e9 \\\"quoted\\\"\","
+                        " \"list\": [1, 300, 70000, 5000000000, -1, -200, -40000, -3000000000, []],"
+                        " \"nested\": {\"a\": {\"b\": [{}]}}}";
+    auto original = JsonParser::parse(input);
+    assert(original);
+    
+    std::string encoded = JsonBinarySerializer::serialize(*original.value(), format);
+    assert(encoded.size() < JsonSerializer::serialize(*original.value()).size());
+    
+    auto decoded = JsonBinaryParser::parse(encoded, format);
+    assert(decoded);
+    assert(decoded.value()->equals(*original.value()));
+    assert(JsonSerializer::serialize(*decoded.value()) == JsonSerializer::serialize(*original.value()));
+    assert(decoded.value()->object_value().at("big")->is_integer());
+    assert(decoded.value()->object_value().at("half")->is_real());
+    
+    // Long strings and containers use the wider length forms
+    auto array = JsonArray::create();
+    for (int i = 0; i < 70000; ++i) {
+        array->push_back(JsonStringValue::create(std::string(i % 300, 'x')));
+    }
+    auto large = JsonBinaryParser::parse(JsonBinarySerializer::serialize(*array, format), format);
+    assert(large && large.value()->equals(*array));
+    
+    // Arena, borrowed strings and key interning
+    JsonDocument document;
+    JsonParseOptions options;
+    options.arena = &document.arena();
+    options.borrow_strings = true;
+    auto in_arena = JsonBinaryParser::parse(encoded, format, options);
+    assert(in_arena && in_arena.value()->equals(*original.value()));
+    const auto& name = static_cast<const JsonStringValue&>(*in_arena.value()->object_value().at("name"));
+    assert(name.is_borrowed());
+    assert(name.view().data() >= encoded.data() && name.view().data() < encoded.data() + encoded.size());
+    
+    // Truncated input and trailing bytes
+    for (std::size_t length = 0; length < encoded.size(); ++length) {
+        assert(!JsonBinaryParser::parse(std::string_view(encoded.data(), length), format));
+    }
+    auto trailing = JsonBinaryParser::parse(encoded + encoded, format);
+    assert(!trailing && trailing.error() == make_error_code(JsonErrorCode::ParseError));
+}
+
+int main() {
+    std::cout << "Running test_binary_formats..." << std::endl;
+    
+    test_round_trip(JsonBinaryFormat::Cbor);
+    test_round_trip(JsonBinaryFormat::MessagePack);
+    
+    // Known encodings (RFC 8949 appendix A, MessagePack spec)
+    auto sample = JsonParser::parse("{\"a\": [1, -1, 1.5, true, null, \"x\"]}").value();
+    assert(JsonBinarySerializer::serialize(*sample, JsonBinaryFormat::Cbor) ==
+           bytes({0xa1, 0x61, 'a', 0x86, 0x01, 0x20, 0xfa, 0x3f, 0xc0, 0x00, 0x00, 0xf5, 0xf6, 0x61, 'x'}));
+    assert(JsonBinarySerializer::serialize(*sample, JsonBinaryFormat::MessagePack) ==
+           bytes({0x81, 0xa1, 'a', 0x96, 0x01, 0xff, 0xca, 0x3f, 0xc0, 0x00, 0x00, 0xc3, 0xc0, 0xa1, 'x'}));
+    
+    // CBOR forms the encoder does not produce
+    auto half = JsonBinaryParser::parse(bytes({0xf9, 0x3c, 0x00}), JsonBinaryFormat::Cbor);
+    assert(half && half.value()->number_value() == 1.0);
+    auto tagged = JsonBinaryParser::parse(bytes({0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0}), JsonBinaryFormat::Cbor);
+    assert(tagged && tagged.value()->integer_value() == 1363896240);
+    auto indefinite = JsonBinaryParser::parse(
+        bytes({0xbf, 0x61, 'a', 0x9f, 0x01, 0xff, 0x7f, 0x61, 'b', 0x61, 'c', 0xff, 0xf7, 0xff}),
+        JsonBinaryFormat::Cbor);
+    assert(indefinite);
+    assert(JsonSerializer::serialize(*indefinite.value()) == "{\"a\": [1], \"bc\": null}");
+    auto huge = JsonBinaryParser::parse(bytes({0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}),
+                                        JsonBinaryFormat::Cbor);
+    assert(huge && huge.value()->is_real());
+    
+    // Items without a JSON equivalent
+    auto binary = JsonBinaryParser::parse(bytes({0x41, 0x00}), JsonBinaryFormat::Cbor);
+    assert(!binary && binary.error() == make_error_code(JsonErrorCode::InvalidType));
+    auto integer_key = JsonBinaryParser::parse(bytes({0xa1, 0x01, 0x02}), JsonBinaryFormat::Cbor);
+    assert(!integer_key && integer_key.error() == make_error_code(JsonErrorCode::InvalidType));
+    auto extension = JsonBinaryParser::parse(bytes({0xd4, 0x01, 0x00}), JsonBinaryFormat::MessagePack);
+    assert(!extension && extension.error() == make_error_code(JsonErrorCode::InvalidType));
+    auto bad_utf8 = JsonBinaryParser::parse(bytes({0xa1, 0xff}), JsonBinaryFormat::MessagePack);
+    assert(!bad_utf8 && bad_utf8.error() == make_error_code(JsonErrorCode::InvalidUTF8));
+    
+    // A length larger than the input is rejected before reserving
+    assert(!JsonBinaryParser::parse(bytes({0xdd, 0x7f, 0xff, 0xff, 0xff}), JsonBinaryFormat::MessagePack));
+    
+    // Nesting limit
+    std::string deep(JsonBinaryParser::max_depth + 1, static_cast<char>(0x81));
+    assert(!JsonBinaryParser::parse(deep, JsonBinaryFormat::Cbor));
+    
+    std::cout << "test_binary_formats passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_value.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_borrowed_refs..." << std::endl;
+    
+    json_t* arr = json_loads("[1, {\"name\": \"x\", \"tags\": [true]}, \"s\"]", 0, nullptr);
+    assert(arr != nullptr);
+    
+    // Accessors return the node itself: repeated lookups give the same
+    // pointer and nothing is allocated or needs releasing
+    json_t* first = json_array_get(arr, 0);
+    assert(first == json_array_get(arr, 0));
+    assert(json_integer_value(first) == 1);
+    json_t* object = json_array_get(arr, 1);
+    json_t* name = json_object_get(object, "name");
+    assert(name == json_object_get(object, "name"));
+    assert(std::string(json_string_value(name)) == "x");
+    assert(json_array_get(arr, 3) == nullptr);
+    assert(json_object_get(object, "missing") == nullptr);
+    
+    // Iterating a large array borrows every element
+    json_t* big = json_array();
+    for (int i = 0; i < 10000; ++i) {
+        json_t* value = json_integer(i);
+        assert(json_array_append(big, value) == 0);
+        json_delete(value);
+    }
+    long long sum = 0;
+    for (int pass = 0; pass < 10; ++pass) {
+        for (size_t i = 0; i < json_array_size(big); ++i) {
+            sum += json_integer_value(json_array_get(big, i));
+        }
+    }
+    assert(sum == 10LL * 9999 * 10000 / 2);
+    
+    // A borrowed value can be added to another container, which then
+    // keeps it alive after the original owner is gone
+    json_t* holder = json_object();
+    assert(json_object_set(holder, "tags", json_object_get(object, "tags")) == 0);
+    json_delete(arr);
+    json_t* tags = json_object_get(holder, "tags");
+    assert(json_array_size(tags) == 1);
+    assert(json_boolean_value(json_array_get(tags, 0)));
+    
+    // The count is the node's own: a containing array and the caller each
+    // hold one reference
+    json_t* item = json_string("kept");
+    json_t* list = json_array();
+    assert(json_array_append(list, item) == 0);
+    const JsonValue* node = reinterpret_cast<const JsonValue*>(item);
+    assert(node->reference_count() == 2);
+    json_delete(item);
+    assert(node->reference_count() == 1);
+    assert(std::string(json_string_value(json_array_get(list, 0))) == "kept");
+    
+    json_delete(list);
+    json_delete(holder);
+    json_delete(big);
+    
+    std::cout << "test_borrowed_refs passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_document.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_borrowed_strings..." << std::endl;
+    
+    std::string input = "{\"plain\": \"hello world\", \"escaped\": \"a\\nb\", \"list\": [\"x\", \"\"]}";
+    
+    JsonParseOptions options;
+    options.borrow_strings = true;
+    
+    // Plain strings reference the input, escaped ones are decoded
+    auto result = JsonParser::parse(input, options);
+    assert(result);
+    const auto& object = static_cast<const JsonObject&>(*result.value());
+    auto plain = static_pointer_cast<JsonStringValue>(object.get("plain"));
+    auto escaped = static_pointer_cast<JsonStringValue>(object.get("escaped"));
+    assert(plain->is_borrowed());
+    assert(plain->view() == "hello world");
+    assert(plain->view().data() >= input.data() &&
+           plain->view().data() < input.data() + input.size());
+    assert(!escaped->is_borrowed());
+    assert(escaped->view() == "a\nb");
+    
+    auto list = static_pointer_cast<JsonArray>(object.get("list"));
+    auto empty = static_pointer_cast<JsonStringValue>(list->at(1));
+    assert(empty->is_borrowed());
+    assert(empty->view().empty());
+    
+    // Same tree as a copying parse
+    auto copied = JsonParser::parse(input);
+    assert(copied);
+    assert(copied.value()->equals(*result.value()));
+    assert(JsonSerializer::serialize(*copied.value()) == JsonSerializer::serialize(*result.value()));
+    
+    // Also with the structural index
+    options.use_structural_index = true;
+    auto indexed = JsonParser::parse(input, options);
+    assert(indexed);
+    assert(indexed.value()->equals(*copied.value()));
+    options.use_structural_index = false;
+    
+    // value() materializes an owned copy
+    const std::string& owned = plain->value();
+    assert(!plain->is_borrowed());
+    assert(owned == "hello world");
+    assert(plain->view().data() == owned.data());
+    
+    // Clones never borrow
+    auto clone = static_pointer_cast<JsonStringValue>(list->at(0)->clone());
+    assert(!clone->is_borrowed());
+    assert(clone->view() == "x");
+    
+    // Errors are still reported
+    assert(!JsonParser::parse("[\"unterminated", options));
+    assert(!JsonParser::parse("[\"bad \x01 control\"]", options));
+    
+    // A document keeps its own copy of the input
+    JsonDocument doc;
+    {
+        std::string temporary = "[\"owned by the document\"]";
+        auto parsed = doc.parse(temporary, options);
+        assert(parsed);
+        temporary.assign(temporary.size(), '#');
+    }
+    const auto& array = static_cast<const JsonArray&>(*doc.root());
+    auto first = static_pointer_cast<JsonStringValue>(array.at(0));
+    assert(first->is_borrowed());
+    assert(first->view() == "owned by the document");
+    
+    // Borrowed empty strings, and short owned strings stored in the node
+    std::string source = "\"\"";
+    JsonStringValue borrowed_empty(std::string_view(source).substr(1, 0), JsonStringValue::borrowed);
+    assert(borrowed_empty.is_borrowed());
+    assert(borrowed_empty.view().empty());
+    assert(borrowed_empty.value().empty());
+    assert(!borrowed_empty.is_borrowed());
+    auto short_value = JsonStringValue::create(std::string("status_ok"));
+    const char* bytes = short_value->value().data();
+    const char* node = reinterpret_cast<const char*>(short_value.get());
+    assert(bytes >= node && bytes < node + sizeof(JsonStringValue));
+    assert(!short_value->is_borrowed());
+    static_assert(sizeof(JsonStringValue) <= 64, "string nodes fit in a cache line");
+    
+    std::cout << "test_borrowed_strings passed!" << std::endl;
+    return 0;
+}
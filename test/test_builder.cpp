@@ -0,0 +1,119 @@
+#include <iostream>
+#include <cassert>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json_builder.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_builder..." << std::endl;
+    
+    // reserve and bulk append
+    auto array = JsonArray::create();
+    array->reserve(100);
+    assert(array->capacity() >= 100);
+    std::vector<JsonRef<JsonValue>> numbers;
+    for (int i = 0; i < 100; ++i) {
+        numbers.push_back(JsonNumber::create(i));
+    }
+    const JsonValue* first = numbers[0].get();
+    std::size_t capacity = array->capacity();
+    array->append_range(std::move(numbers));
+    assert(numbers.empty());
+    assert(array->size() == 100);
+    assert(array->capacity() == capacity);
+    assert(array->values()[0].get() == first);
+    assert(array->values()[0].use_count() == 1);
+    
+    // Bulk insert copies (sharing nodes) unless given move iterators
+    std::vector<JsonRef<JsonValue>> extra = {JsonStringValue::create(std::string("a")),
+                                             JsonStringValue::create(std::string("b"))};
+    array->insert_range(1, extra.begin(), extra.end());
+    assert(array->size() == 102);
+    assert(array->values()[1] == extra[0]);
+    assert(extra[0].use_count() == 2);
+    bool threw = false;
+    try {
+        array->insert_range(1000, extra.begin(), extra.end());
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Objects: reserve and bulk set, last value wins for repeated keys
+    auto object = JsonObject::create();
+    object->reserve(16);
+    std::vector<std::pair<std::string, JsonRef<JsonValue>>> members = {
+        {"a", JsonNumber::create(1)},
+        {"b", JsonNumber::create(2)},
+        {"a", JsonNumber::create(3)}
+    };
+    object->insert_range(std::make_move_iterator(members.begin()),
+                         std::make_move_iterator(members.end()));
+    assert(object->size() == 2);
+    assert(object->get("a")->integer_value() == 3);
+    
+    // One-shot construction from complete lists
+    auto built = JsonBuilder::array({JsonNull::create(), JsonBoolean::create(true)});
+    assert(JsonSerializer::serialize(*built) == "[null, true]");
+    auto record = JsonBuilder::object({{JsonKey("id"), JsonNumber::create(7)},
+                                       {JsonKey("name"), JsonStringValue::create(std::string("x"))}});
+    assert(JsonSerializer::serialize(*record) == "{\"id\": 7, \"name\": \"x\"}");
+    
+    // Nested construction on the scratch stacks; each container is
+    // allocated at its final size
+    JsonBuilder builder;
+    JsonBuilder::Mark outer = builder.mark();
+    for (int i = 0; i < 3; ++i) {
+        JsonBuilder::Mark inner = builder.mark();
+        for (int j = 0; j <= i; ++j) {
+            builder.add(JsonNumber::create(j));
+        }
+        builder.add(JsonKey("row" + std::to_string(i)), builder.finish_array(inner));
+    }
+    auto rows = builder.finish_object(outer);
+    assert(JsonSerializer::serialize(*rows) ==
+           "{\"row0\": [0], \"row1\": [0, 1], \"row2\": [0, 1, 2]}");
+    assert(static_cast<const JsonArray&>(*rows->get("row2")).capacity() == 3);
+    
+    // Finishing an array while an object's members are pending is an error
+    JsonBuilder::Mark object_mark = builder.mark();
+    builder.add(JsonKey("k"), JsonNull::create());
+    threw = false;
+    try {
+        builder.finish_array(object_mark);
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+    builder.clear();
+    
+    // Arena-backed builder
+    JsonArena arena;
+    JsonBuilder in_arena(&arena);
+    JsonBuilder::Mark mark = in_arena.mark();
+    in_arena.add(JsonNumber::create(1));
+    auto arena_array = in_arena.finish_array(mark);
+    assert(arena.bytes_used() > 0);
+    assert(arena_array->size() == 1);
+    arena_array.reset();
+    
+    // Parsed containers are sized exactly
+    auto parsed = JsonParser::parse("[[1, 2, 3, 4, 5], {\"a\": [true], \"b\": {}}, []]");
+    assert(parsed);
+    const auto& top = static_cast<const JsonArray&>(*parsed.value());
+    assert(top.capacity() == 3);
+    assert(static_cast<const JsonArray&>(*top.values()[0]).capacity() == 5);
+    const auto& member = static_cast<const JsonObject&>(*top.values()[1]);
+    assert(static_cast<const JsonArray&>(*member.get("a")).capacity() == 1);
+    assert(JsonSerializer::serialize(*parsed.value()) ==
+           "[[1, 2, 3, 4, 5], {\"a\": [true], \"b\": {}}, []]");
+    
+    std::cout << "test_builder passed!" << std::endl;
+    return 0;
+}
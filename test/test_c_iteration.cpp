@@ -0,0 +1,97 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include "json_c_api.hpp"
+
+int main() {
+    std::cout << "Running test_c_iteration..." << std::endl;
+
+    json_t* object = json_loads("{\"b\": 1, \"a\": [true, null], \"c\": \"x\"}", 0, nullptr);
+    assert(object);
+
+    // Members come in insertion order with borrowed keys and values
+    std::string keys;
+    json_int_t sum = 0;
+    const char* key;
+    json_t* value;
+    json_object_foreach(object, key, value) {
+        keys += key;
+        if (json_is_integer(value)) {
+            sum += json_integer_value(value);
+        }
+    }
+    assert(keys == "bac" && sum == 1);
+
+    void* iter = json_object_iter(object);
+    assert(iter && std::strcmp(json_object_iter_key(iter), "b") == 0);
+    assert(json_object_iter_key_len(iter) == 1);
+    iter = json_object_iter_next(object, iter);
+    assert(json_object_iter_value(iter) == json_object_get(object, "a"));
+    iter = json_object_iter_next(object, iter);
+    assert(std::strcmp(json_string_value(json_object_iter_value(iter)), "x") == 0);
+    assert(!json_object_iter_next(object, iter));
+
+    iter = json_object_iter_at(object, "a");
+    assert(iter && json_is_array(json_object_iter_value(iter)));
+    assert(!json_object_iter_at(object, "missing"));
+
+    // Replacing a value keeps the member in place
+    assert(json_object_iter_set_new(object, iter, json_integer(5)) == JSON_ERROR_SUCCESS);
+    assert(json_integer_value(json_object_get(object, "a")) == 5);
+    json_t* replacement = json_string("y");
+    assert(json_object_iter_set(object, json_object_iter_at(object, "c"), replacement) == JSON_ERROR_SUCCESS);
+    json_decref(replacement);
+    char* text = json_dumps(object, JSON_COMPACT);
+    assert(std::strcmp(text, "{\"b\":1,\"a\":5,\"c\":\"y\"}") == 0);
+    json_dumps_free(text);
+
+    // Keys with embedded NULs and their lengths
+    json_object_setn_new(object, "n\0ul", 4, json_boolean(1));
+    size_t key_len = 0;
+    size_t total = 0;
+    json_object_keylen_foreach(object, key, key_len, value) {
+        total += key_len;
+    }
+    assert(total == 7);
+
+    // The safe form allows deleting the member being visited
+    void* n;
+    keys.clear();
+    json_object_foreach_safe(object, n, key, value) {
+        keys += key;
+        if (json_is_integer(value)) {
+            json_object_del(object, key);
+        }
+    }
+    assert(keys == std::string("bacn"));
+    assert(json_object_size(object) == 2 && json_object_get(object, "c") && !json_object_get(object, "b"));
+
+    // Arrays
+    json_t* array = json_loads("[10, 20, 30]", 0, nullptr);
+    size_t index;
+    sum = 0;
+    json_array_foreach(array, index, value) {
+        sum += json_integer_value(value) * static_cast<json_int_t>(index + 1);
+    }
+    assert(sum == 140 && index == 3);
+
+    // Empty containers, other types and foreign iterators
+    json_t* empty = json_object();
+    assert(!json_object_iter(empty) && !json_object_iter(array) && !json_object_iter(nullptr));
+    json_object_foreach(empty, key, value) {
+        assert(false);
+    }
+    void* foreign = json_object_iter(object);
+    assert(!json_object_iter_next(empty, foreign) && !json_object_iter_check(empty, foreign));
+    assert(json_object_iter_check(object, foreign) == foreign);
+    assert(json_object_iter_set(empty, foreign, array) == JSON_ERROR_INVALID_ARGUMENT);
+    assert(!json_object_iter_key(nullptr) && !json_object_iter_value(nullptr));
+
+    json_decref(empty);
+    json_decref(array);
+    json_decref(object);
+
+    std::cout << "test_c_iteration passed!" << std::endl;
+    return 0;
+}
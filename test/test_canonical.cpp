@@ -0,0 +1,200 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "json_c_api.hpp"
+#include "json_digest.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_shape.hpp"
+#include "json_stream.hpp"
+
+using namespace jansson;
+
+static JsonSerializeOptions canonical() {
+    JsonSerializeOptions options;
+    options.canonical = true;
+    return options;
+}
+
+static std::string canon(const JsonValue& value) {
+    return JsonSerializer::serialize(value, canonical());
+}
+
+static std::string canon(std::string_view text) {
+    return canon(*JsonParser::parse(text).value());
+}
+
+static std::string number(double value) {
+    return canon(*JsonNumber::create(value));
+}
+
+// The same output pulled piece by piece
+static std::string streamed(JsonRef<JsonValue> value, const JsonSerializeOptions& options) {
+    JsonStreamSerializer stream(std::move(value), options);
+    std::string out;
+    char buffer[5];
+    while (std::size_t count = stream.read(buffer, sizeof(buffer))) {
+        out.append(buffer, count);
+    }
+    return out;
+}
+
+int main() {
+    std::cout << "Running test_canonical..." << std::endl;
+
+    // Numbers as ECMAScript writes them (RFC 8785 appendix B)
+    assert(number(0.0) == "0" && number(-0.0) == "0");
+    assert(number(5e-324) == "5e-324");
+    assert(number(-1.7976931348623157e308) == "-1.7976931348623157e+308");
+    assert(number(9007199254740992.0) == "9007199254740992");
+    assert(number(-9007199254740992.0) == "-9007199254740992");
+    assert(number(295147905179352830000.0) == "295147905179352830000");
+    assert(number(9.999999999999997e+22) == "9.999999999999997e+22");
+    assert(number(1e21) == "1e+21" && number(1e23) == "1e+23");
+    assert(number(999999999999999700000.0) == "999999999999999700000");
+    assert(number(0.000001) == "0.000001" && number(1e-7) == "1e-7");
+    assert(number(333333333.33333329) == "333333333.3333333");
+    assert(number(100.0) == "100" && number(4.5) == "4.5" && number(0.002) == "0.002");
+    assert(number(1.5e-9) == "1.5e-9" && number(-123.25) == "-123.25");
+    assert(canon(*JsonNumber::create(-42)) == "-42");
+    assert(canon(*JsonNumber::create(std::int64_t(1) << 53)) == "9007199254740992");
+    assert(canon(*JsonNumber::create(INT64_MAX)) == "9223372036854776000");
+    bool threw = false;
+    try {
+        number(std::numeric_limits<double>::quiet_NaN());
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // The example of RFC 8785 section 3.2.2: layout options are overridden
+    const char* sample = R"({
+        "numbers": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001],
+        "string": "€$\u000F\u000aA'\u0042\u0022\u005c\\\"\/",
+        "literals": [null, true, false]
+    })";
+    const std::string expected =
+        "{\"literals\":[null,true,false],\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],"
+        "\"string\":\"\xe2\x82\xac$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}";
+    assert(canon(sample) == expected);
+    JsonSerializeOptions pretty = canonical();
+    pretty.pretty_print = true;
+    pretty.real_precision = 3;
+    auto sample_value = JsonParser::parse(sample).value();
+    assert(JsonSerializer::serialize(*sample_value, pretty) == expected);
+    assert(streamed(sample_value, pretty) == expected);
+
+    // Keys ordered by UTF-16 code units (RFC 8785 section 3.2.3): the emoji,
+    // a surrogate pair, sorts before U+FB33 though its code point is higher
+    const char* keys = R"({"€": "Euro", "\r": "CR", "דּ": "Dalet", "1": "One",
+                           "😀": "Emoji", "\u0080": "Control", "ö": "Umlaut"})";
+    std::string ordered = canon(keys);
+    std::vector<const char*> order = {"CR", "One", "Control", "Umlaut", "Euro", "Emoji", "Dalet"};
+    for (std::size_t i = 1; i < order.size(); ++i) {
+        assert(ordered.find(order[i - 1]) < ordered.find(order[i]));
+    }
+    assert(streamed(JsonParser::parse(keys).value(), canonical()) == ordered);
+    auto many_keys = JsonParser::parse(keys).value();
+    for (const char* key : {"x", "y", "z"}) {
+        static_cast<JsonObject&>(*many_keys).set(key, JsonNull::create());
+    }
+    std::string many_ordered = canon(*many_keys);
+    assert(many_ordered.find("Dalet") > many_ordered.find("Emoji") && many_ordered.find("\"z\"") < many_ordered.find("Control"));
+    assert(streamed(many_keys, canonical()) == many_ordered);
+
+    // sort_keys alone stays bytewise
+    JsonSerializeOptions sorted;
+    sorted.sort_keys = true;
+    sorted.compact = true;
+    std::string bytewise = JsonSerializer::serialize(*JsonParser::parse(keys).value(), sorted);
+    assert(bytewise.find("Dalet") < bytewise.find("Emoji"));
+    assert(JsonKeyOrder::less("\xef\xac\xb3", "\xf0\x9f\x98\x80", false));
+    assert(JsonKeyOrder::less("\xf0\x9f\x98\x80", "\xef\xac\xb3", true));
+    assert(JsonKeyOrder::less("ab", "abc", true) && !JsonKeyOrder::less("b", "a", true));
+
+    // A larger object builds its order once and keeps it until it changes
+    auto wide = JsonObject::create();
+    for (int i = 20; i > 0; --i) {
+        wide->set("k" + std::to_string(i), JsonNumber::create(i));
+    }
+    std::string wide_text = JsonSerializer::serialize(*wide, sorted);
+    assert(wide_text.rfind("{\"k1\":1,\"k10\":10,\"k11\":11,", 0) == 0);
+    auto wide_order = wide->key_order();
+    assert(wide_order->positions(false).size() == 20 && wide_order->positions(false)[0] == 19);
+    assert(JsonSerializer::serialize(*wide, sorted) == wide_text);
+    assert(wide->key_order() == wide_order);
+    wide->set("k0", JsonNumber::create(0));
+    assert(wide->key_order() != wide_order);
+    assert(JsonSerializer::serialize(*wide, sorted).rfind("{\"k0\":0,\"k1\":1,", 0) == 0);
+    assert(streamed(wide, sorted) == JsonSerializer::serialize(*wide, sorted));
+
+    // Objects of one shape share a single order
+    JsonShapeTable shapes;
+    auto records = JsonParser::parse(R"([{"b": 1, "a": 2, "c": 3}, {"b": 4, "a": 5, "c": 6}])").value();
+    const auto& list = static_cast<const JsonArray&>(*records);
+    auto* first = static_cast<JsonObject*>(list.at(0).get());
+    auto* second = static_cast<JsonObject*>(list.at(1).get());
+    shapes.assign(*first);
+    shapes.assign(*second);
+    assert(first->key_order() == second->key_order() && first->key_order() == first->shape()->key_order());
+    assert(canon(*records) == "[{\"a\":2,\"b\":1,\"c\":3},{\"a\":5,\"b\":4,\"c\":6}]");
+    assert(streamed(records, canonical()) == canon(*records));
+
+    // Parallel serialization gives the same bytes
+    auto big = JsonObject::create();
+    for (int i = 0; i < 200; ++i) {
+        big->set("key" + std::to_string(i * 7919 % 200), JsonNumber::create(i * 0.25));
+    }
+    JsonSerializeOptions parallel = canonical();
+    parallel.parallel_threshold = 16;
+    assert(JsonSerializer::serialize(*big, parallel) == canon(*big));
+
+    // Cached encodings are kept per format
+    auto cached = JsonParser::parse(R"({"z": [1.0, {"y": 2, "x": 1}], "a": true})").value();
+    static_cast<JsonObject&>(*cached).cache_encoding();
+    std::string plain = JsonSerializer::serialize(*cached);
+    assert(canon(*cached) == "{\"a\":true,\"z\":[1,{\"x\":1,\"y\":2}]}");
+    assert(JsonSerializer::serialize(*cached) == plain);
+
+    // SHA-256 test vectors (FIPS 180-2), whole and in pieces
+    assert(JsonSha256::hex(JsonSha256::hash("")) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assert(JsonSha256::hex(JsonSha256::hash("abc")) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    const std::string two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    const std::string two_blocks_digest = "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1";
+    assert(JsonSha256::hex(JsonSha256::hash(two_blocks)) == two_blocks_digest);
+    JsonSha256 hasher;
+    for (char c : two_blocks) {
+        hasher.update(&c, 1);
+    }
+    assert(JsonSha256::hex(hasher.finish()) == two_blocks_digest);
+    std::string million(1000000, 'a');
+    for (std::size_t offset = 0; offset < million.size(); offset += 999) {
+        hasher.update(std::string_view(million).substr(offset, 999));
+    }
+    assert(JsonSha256::hex(hasher.finish()) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    // The digest of a document is that of its canonical text, hashed as it
+    // is written
+    assert(json_digest(*sample_value) == JsonSha256::hash(expected));
+    assert(json_digest(*big, sorted) == JsonSha256::hash(JsonSerializer::serialize(*big, sorted)));
+    JsonDigestWriter writer(64);
+    JsonSerializer::serialize(writer, *big, canonical());
+    assert(writer.finish() == JsonSha256::hash(canon(*big)));
+    assert(writer.finish() == JsonSha256::hash(""));
+
+    // C API flag
+    json_error_code error = JSON_ERROR_SUCCESS;
+    json_t* json = json_loads("{\"b\": [1e2, -0.0], \"a\": 1}", 0, &error);
+    assert(json);
+    char* text = json_dumps(json, JSON_CANONICAL | JSON_INDENT(4));
+    assert(std::string(text) == "{\"a\":1,\"b\":[100,0]}");
+    json_dumps_free(text);
+    json_decref(json);
+
+    std::cout << "test_canonical passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "memory_policy.hpp"
+
+using namespace jansson;
+
+// Every operator new of the process, to see the parser's and serializer's
+// scratch buffers
+static size_t news = 0;
+
+void* operator new(std::size_t size) {
+    ++news;
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+// The library's own allocations
+static size_t mallocs = 0;
+static size_t frees = 0;
+
+static void* counting_malloc(size_t size) {
+    ++mallocs;
+    return std::malloc(size);
+}
+
+static void counting_free(void* pointer) {
+    ++frees;
+    std::free(pointer);
+}
+
+// Parses a document from inside a callback
+struct Nested : JsonHandler {
+    bool on_key(std::string_view) override {
+        auto inner = JsonParser::parse("{\"inner\\u0041\": [1, 2]}");
+        return inner && inner.value()->is_object();
+    }
+};
+
+static const char* document =
+    "{\"id\": 12, \"tags\": [\"a\", \"b\"], \"esc\\u0061ped\": {\"x\": [1.5, true, null]}}";
+
+static void parse_and_drop() {
+    auto result = JsonParser::parse(document);
+    assert(result);
+}
+
+int main() {
+    std::cout << "Running test_context_reuse..." << std::endl;
+
+    // Once warm, parsing allocates nothing but the tree itself, which is
+    // made through the allocation functions, and serializing allocates
+    // only the returned string
+    auto tree = JsonParser::parse(document);
+    assert(tree);
+    std::string expected = JsonSerializer::serialize(*tree.value());
+    parse_and_drop();
+    size_t before = news;
+    for (int i = 0; i < 10; ++i) {
+        parse_and_drop();
+    }
+    assert(news == before);
+    before = news;
+    for (int i = 0; i < 10; ++i) {
+        assert(JsonSerializer::serialize(*tree.value()) == expected);
+    }
+    assert(news == before + 10);
+
+    // A parse from inside a parse gets its own context
+    Nested nested;
+    assert(JsonParser::parse(document, nested));
+    assert(JsonSerializer::serialize(*JsonParser::parse(document).value()) == expected);
+
+    // Failures leave nothing behind for the next parse
+    assert(!JsonParser::parse("{\"a\": [1, {\"b\\n\": }]}"));
+    assert(JsonSerializer::serialize(*JsonParser::parse(document).value()) == expected);
+
+    // Nodes come from the thread's pool once it is on
+    set_allocation_functions(&counting_malloc, &counting_free);
+    assert(node_pool_limit() == 0);
+    size_t start = mallocs;
+    size_t freed = frees;
+    {
+        auto array = JsonParser::parse("[1, 2, 3, true, null]");
+        assert(array);
+    }
+    // Six nodes and the array's storage
+    assert(mallocs - start == 7 && frees - freed == 7);
+
+    set_node_pool_limit(64);
+    assert(JsonParser::parse("[1, 2, 3, true, null]"));
+    start = mallocs;
+    freed = frees;
+    for (int i = 0; i < 10; ++i) {
+        auto array = JsonParser::parse("[1, 2, 3, true, null]");
+        assert(array);
+    }
+    // Only the array's storage is allocated each time
+    assert(mallocs - start == 10 && frees - freed == 10);
+
+    // Lowering the limit or trimming gives the blocks back
+    set_node_pool_limit(1);
+    trim_node_pool();
+    assert(mallocs == frees);
+    set_node_pool_limit(0);
+
+    // A thread's pool is freed when the thread exits
+    std::thread worker([] {
+        set_node_pool_limit(16);
+        for (int i = 0; i < 5; ++i) {
+            parse_and_drop();
+        }
+    });
+    worker.join();
+    assert(mallocs == frees);
+
+    // Nodes freed on another thread join that thread's pool, not the one
+    // that allocated them
+    auto shared = JsonParser::parse(document);
+    std::thread other([value = std::move(shared.value())]() mutable {
+        set_node_pool_limit(16);
+        value = nullptr;
+    });
+    other.join();
+    assert(mallocs == frees);
+
+    set_allocation_functions(nullptr, nullptr);
+
+    std::cout << "test_context_reuse passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static JsonObject& as_object(JsonValue& value) {
+    return static_cast<JsonObject&>(value);
+}
+
+int main() {
+    std::cout << "Running test_cow_clone..." << std::endl;
+    
+    std::string input = "{\"service\": {\"name\": \"api\", \"limits\": {\"rps\": 100, \"burst\": 10}},"
+                        " \"regions\": [\"eu\", \"us\"], \"tables\": [";
+    for (int i = 0; i < 1000; ++i) {
+        if (i > 0) input += ", ";
+        input += "{\"id\": " + std::to_string(i) + ", \"tags\": [1, 2, 3]}";
+    }
+    input += "]}";
+    auto parsed = JsonParser::parse(input);
+    assert(parsed);
+    JsonRef<JsonValue> config = parsed.value();
+    std::string before = JsonSerializer::serialize(*config);
+    
+    // The copy shares every child with the source
+    auto copy = config->cow_clone();
+    assert(copy.get() != config.get());
+    assert(copy->equals(*config));
+    const auto& source_members = config->object_value();
+    const auto& copy_members = copy->object_value();
+    assert(copy_members.at("tables").get() == source_members.at("tables").get());
+    
+    // Modifying through the copy copies only the path to the change
+    JsonValue* service = as_object(*copy).mutable_get("service");
+    assert(service != source_members.at("service").get());
+    JsonValue* limits = as_object(*service).mutable_get("limits");
+    as_object(*limits).set("rps", JsonNumber::create(5));
+    assert(copy_members.at("service")->object_value().at("limits")->object_value().at("rps")->integer_value() == 5);
+    assert(JsonSerializer::serialize(*config) == before);
+    assert(copy_members.at("tables").get() == source_members.at("tables").get());
+    assert(copy_members.at("service")->object_value().at("name").get() ==
+           source_members.at("service")->object_value().at("name").get());
+    
+    // Once private to the copy, a path is modified in place
+    assert(as_object(*copy).mutable_get("service") == service);
+    assert(as_object(*service).mutable_get("limits") == limits);
+    
+    // Array elements
+    auto& tables = static_cast<JsonArray&>(*as_object(*copy).mutable_get("tables"));
+    as_object(tables.mutable_at(7)).set("id", JsonStringValue::create(std::string("seven")));
+    assert(config->object_value().at("tables")->array_value()[7]->object_value().at("id")->integer_value() == 7);
+    assert(tables.values()[8].get() == config->object_value().at("tables")->array_value()[8].get());
+    bool threw = false;
+    try {
+        tables.mutable_at(5000);
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(as_object(*copy).mutable_get("missing") == nullptr);
+    
+    // Top-level changes on either side stay on that side
+    as_object(*copy).set("added", JsonNull::create());
+    as_object(*config).erase("regions");
+    assert(copy->object_value().contains("regions"));
+    assert(!config->object_value().contains("added"));
+    
+    // Scalars and arena trees fall back to a regular clone
+    auto number = JsonNumber::create(3);
+    assert(number->cow_clone()->equals(*number));
+    
+    std::cout << "test_cow_clone passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_document.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_document..." << std::endl;
+    
+    // Parse a large array into the arena
+    std::string input = "[";
+    for (int i = 0; i < 100000; ++i) {
+        if (i > 0) input += ",";
+        input += std::to_string(i);
+    }
+    input += "]";
+    
+    JsonDocument doc;
+    {
+        auto result = doc.parse(input);
+        assert(result);
+        const auto& root = doc.root();
+        assert(root && root->is_array());
+        const auto& values = root->array_value();
+        assert(values.size() == 100000);
+        assert(values[0]->number_value() == 0);
+        assert(values[99999]->number_value() == 99999);
+        // The element vector is allocated in the arena along with the nodes
+        assert(doc.memory_usage() > 100000 * sizeof(JsonRef<JsonValue>));
+        assert(doc.memory_reserved() >= doc.memory_usage());
+    }
+    
+    // Re-parsing replaces the tree and reuses the arena; references into
+    // the previous tree must be dropped first
+    bool parsed = static_cast<bool>(doc.parse("{\"name\": \"arena\", \"tags\": [true, null]}"));
+    assert(parsed);
+    assert(doc.root()->is_object());
+    assert(JsonSerializer::serialize(*doc.root()->object_value().at("tags")) == "[true, null]");
+    
+    // Parse errors are reported and leave the document empty
+    parsed = static_cast<bool>(doc.parse("[1, 2"));
+    assert(!parsed);
+    assert(!doc.root());
+    
+    // Building a tree in the arena
+    auto obj = doc.make_object();
+    obj->set("id", doc.make_number(7));
+    obj->set("label", doc.make_string("seven"));
+    auto arr = doc.make_array();
+    arr->push_back(doc.make_boolean(false));
+    arr->push_back(doc.make_null());
+    obj->set("items", arr);
+    doc.set_root(obj);
+    assert(doc.root()->object_value().size() == 3);
+    assert(doc.root()->object_value().at("label")->string_value() == "seven");
+    
+    obj.reset();
+    arr.reset();
+    doc.clear();
+    assert(!doc.root());
+    assert(doc.memory_usage() == 0);
+    
+    // Resetting between requests keeps one block so steady state reuses it
+    JsonDocument worker(16 * 1024);
+    for (int i = 0; i < 10; ++i) {
+        parsed = static_cast<bool>(
+            worker.parse("{\"request\": " + std::to_string(i) + ", \"ok\": true}"));
+        assert(parsed);
+        assert(worker.memory_reserved() == 16 * 1024);
+        worker.clear();
+    }
+    worker.release();
+    assert(worker.memory_reserved() == 0);
+    
+    // Containers can draw from an arena directly
+    JsonArena shared_arena;
+    JsonArray standalone(&shared_arena);
+    standalone.push_back(JsonNull::create());
+    assert(shared_arena.bytes_used() >= sizeof(JsonRef<JsonValue>));
+    
+    // Arena allocations honor alignment
+    JsonArena arena(1024);
+    for (int i = 0; i < 100; ++i) {
+        void* p = arena.allocate(3, 1);
+        assert(p != nullptr);
+        void* q = arena.allocate(16, 16);
+        assert(reinterpret_cast<std::uintptr_t>(q) % 16 == 0);
+    }
+    void* big = arena.allocate(4096, 64);
+    assert(reinterpret_cast<std::uintptr_t>(big) % 64 == 0);
+    
+    std::cout << "test_document passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "json_writer.hpp"
+#include "json_serializer.hpp"
+#include "json_c_api.hpp"
+
+using namespace jansson;
+
+static int collect(const char* buffer, size_t size, void* data) {
+    auto* chunks = static_cast<std::vector<std::string>*>(data);
+    chunks->emplace_back(buffer, size);
+    return 0;
+}
+
+static int refuse(const char*, size_t, void*) {
+    return -1;
+}
+
+static std::string read_all(FILE* file) {
+    std::string text;
+    char buffer[512];
+    std::rewind(file);
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, n);
+    }
+    return text;
+}
+
+int main() {
+    std::cout << "Running test_dump_sinks..." << std::endl;
+    
+    auto array = JsonArray::create();
+    for (int i = 0; i < 2000; ++i) {
+        array->push_back(JsonStringValue::create("element " + std::to_string(i)));
+    }
+    std::string expected = JsonSerializer::serialize(*array);
+    assert(expected.size() > 3 * JsonChunkedWriter::default_chunk_size);
+    
+    // Callback writer delivers fixed-size chunks
+    std::vector<std::string> chunks;
+    {
+        JsonCallbackWriter writer([&chunks](const char* data, std::size_t length) {
+            chunks.emplace_back(data, length);
+            return true;
+        }, 1024);
+        JsonSerializer::serialize(writer, *array);
+    }
+    assert(chunks.size() > 1);
+    std::string joined;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        assert(chunks[i].size() <= 1024);
+        joined += chunks[i];
+    }
+    assert(joined == expected);
+    
+    // A failing sink stops the output and is reported
+    JsonCallbackWriter failing([](const char*, std::size_t) { return false; }, 64);
+    JsonSerializer::serialize(failing, *array);
+    failing.flush();
+    assert(failing.failed());
+    assert(failing.truncated());
+    assert(failing.size() == expected.size());
+    
+    // C API
+    json_t* root = json_object();
+    json_t* name = json_string("sink");
+    json_t* items = json_array();
+    json_object_set(root, "name", name);
+    json_object_set(root, "items", items);
+    for (int i = 0; i < 1500; ++i) {
+        json_t* item = json_integer(i);
+        json_array_append(items, item);
+        json_delete(item);
+    }
+    json_delete(name);
+    json_delete(items);
+    char* dumped = json_dumps(root, 0);
+    assert(dumped);
+    std::string text(dumped);
+    json_dumps_free(dumped);
+    assert(text.size() > JsonChunkedWriter::default_chunk_size);
+    
+    std::vector<std::string> c_chunks;
+    assert(json_dump_callback(root, collect, &c_chunks, 0) == 0);
+    assert(c_chunks.size() > 1);
+    std::string c_joined;
+    for (const auto& chunk : c_chunks) {
+        c_joined += chunk;
+    }
+    assert(c_joined == text);
+    assert(json_dump_callback(root, refuse, nullptr, 0) == -1);
+    assert(json_dump_callback(nullptr, collect, &c_chunks, 0) == -1);
+    
+    FILE* file = std::tmpfile();
+    assert(file);
+    assert(json_dumpf(root, file, 0) == 0);
+    assert(read_all(file) == text);
+    std::fclose(file);
+    
+    file = std::tmpfile();
+    assert(file);
+    assert(json_dumpfd(root, fileno(file), 0) == 0);
+    assert(read_all(file) == text);
+    std::fclose(file);
+    
+    // Pipes accept the output in pieces
+    int fds[2];
+    assert(pipe(fds) == 0);
+    json_t* small = json_string("over a pipe");
+    assert(json_dumpfd(small, fds[1], 0) == 0);
+    close(fds[1]);
+    char buffer[64];
+    ssize_t n = read(fds[0], buffer, sizeof(buffer));
+    close(fds[0]);
+    assert(std::string(buffer, n) == "\"over a pipe\"");
+    json_delete(small);
+    
+    char path[] = "/tmp/test_dump_sinks_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    assert(json_dump_file(root, path, 0) == 0);
+    json_error_code error;
+    json_t* loaded = json_load_file(path, 0, &error);
+    assert(loaded);
+    assert(json_object_size(loaded) == 2);
+    json_delete(loaded);
+    std::remove(path);
+    assert(json_dump_file(root, "/nonexistent-dir/out.json", 0) == -1);
+    
+    json_delete(root);
+    
+    std::cout << "test_dump_sinks passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static JsonRef<JsonObject> parse_object(std::string_view text) {
+    auto result = JsonParser::parse(text);
+    assert(result && result.value()->is_object());
+    return JsonRef<JsonObject>(static_cast<JsonObject*>(result.value().get()));
+}
+
+// Output of the same tree with no cache anywhere
+static std::string uncached(const JsonValue& value, const JsonSerializeOptions& options = JsonSerializeOptions()) {
+    return JsonSerializer::serialize(*value.clone(), options);
+}
+
+int main() {
+    std::cout << "Running test_encoding_cache..." << std::endl;
+
+    auto catalog = parse_object("{\"section\": \"books\", \"items\": [{\"id\": 1, \"tags\": [\"a\"]}, {\"id\": 2}]}");
+    catalog->cache_encoding();
+    assert(catalog->container_state().caches_encoding() && !catalog->container_state().cached_encoding());
+
+    // The first serialization fills the cache, later ones reuse it
+    std::string first = JsonSerializer::serialize(*catalog);
+    assert(first == uncached(*catalog));
+    auto cached = catalog->container_state().cached_encoding();
+    assert(cached && cached->text == first);
+    assert(JsonSerializer::serialize(*catalog) == first);
+    assert(catalog->container_state().cached_encoding() == cached);
+
+    // Spliced into larger documents, at any depth
+    auto response = JsonObject::create();
+    response->set("status", JsonNumber::create(200));
+    auto sections = JsonArray::create();
+    sections->push_back(catalog);
+    sections->push_back(catalog);
+    response->set("sections", sections);
+    assert(JsonSerializer::serialize(*response) == uncached(*response));
+    assert(catalog->container_state().cached_encoding() == cached);
+
+    // Each option set and pretty-printing depth gets its own text
+    JsonSerializeOptions compact;
+    compact.compact = true;
+    JsonSerializeOptions pretty;
+    pretty.pretty_print = true;
+    pretty.indent = 3;
+    JsonSerializeOptions sorted;
+    sorted.sort_keys = true;
+    for (const JsonSerializeOptions* options : {&compact, &pretty, &sorted}) {
+        assert(JsonSerializer::serialize(*response, *options) == uncached(*response, *options));
+        assert(JsonSerializer::serialize(*catalog, *options) == uncached(*catalog, *options));
+    }
+
+    // Changes to the container itself
+    catalog->set("section", JsonStringValue::create("music"));
+    assert(JsonSerializer::serialize(*catalog) == uncached(*catalog));
+    catalog->erase("section");
+    JsonStringWriter writer;
+    JsonSerializer::serialize(writer, *catalog);
+    assert(writer.view() == uncached(*catalog));
+
+    // Changes below it, however they were reached
+    auto items = catalog->get("items");
+    static_cast<JsonArray&>(*items).push_back(JsonNumber::create(3));
+    assert(JsonSerializer::serialize(*catalog) == uncached(*catalog));
+    auto& inner = static_cast<JsonObject&>(static_cast<JsonArray&>(*items).mutable_at(0));
+    static_cast<JsonArray&>(*inner.get("tags")).insert(0, JsonStringValue::create("z"));
+    assert(JsonSerializer::serialize(*response) == uncached(*response));
+    static_cast<JsonArray&>(*items).remove(1);
+    assert(JsonSerializer::serialize(*catalog, compact) == uncached(*catalog, compact));
+
+    // A container that left the tree no longer matters
+    auto detached = catalog->take("items");
+    assert(JsonSerializer::serialize(*catalog) == "{}");
+    static_cast<JsonArray&>(*detached).clear();
+    assert(JsonSerializer::serialize(*catalog) == "{}");
+
+    // Nested caches and disabling
+    auto outer = JsonArray::create();
+    auto nested = JsonArray::create();
+    nested->cache_encoding();
+    nested->push_back(JsonBoolean::create(true));
+    outer->push_back(nested);
+    outer->cache_encoding();
+    assert(JsonSerializer::serialize(*outer) == "[[true]]");
+    nested->push_back(JsonNull::create());
+    assert(JsonSerializer::serialize(*outer) == "[[true, null]]");
+    outer->cache_encoding(false);
+    assert(!outer->container_state().cached_encoding());
+    assert(JsonSerializer::serialize(*outer) == "[[true, null]]");
+
+    std::cout << "test_encoding_cache passed!" << std::endl;
+    return 0;
+}
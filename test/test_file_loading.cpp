@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include "json_file.hpp"
+#include "json_document.hpp"
+#include "json_parser.hpp"
+#include "json_c_api.hpp"
+
+using namespace jansson;
+
+static std::string write_temp(const std::string& name, const std::string& contents) {
+    std::string path = "test_file_loading_" + name + ".json";
+    FILE* file = std::fopen(path.c_str(), "wb");
+    assert(file != nullptr);
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fclose(file);
+    return path;
+}
+
+int main() {
+    std::cout << "Running test_file_loading..." << std::endl;
+    
+    std::string contents = "{\"name\": \"reference\", \"rows\": [";
+    for (int i = 0; i < 1000; ++i) {
+        if (i > 0) {
+            contents += ", ";
+        }
+        contents += "{\"id\": " + std::to_string(i) + ", \"tag\": \"row\"}";
+    }
+    contents += "]}";
+    std::string path = write_temp("data", contents);
+    std::string bad_path = write_temp("bad", "{\"unterminated\": [1, 2");
+    std::string empty_path = write_temp("empty", "");
+    
+    // Mapped view of the file
+    auto file = JsonMappedFile::open(path);
+    assert(file);
+    assert(file.value()->view() == contents);
+    assert(!JsonMappedFile::open("does/not/exist.json"));
+    auto empty = JsonMappedFile::open(empty_path);
+    assert(empty && empty.value()->size() == 0);
+    
+    // Parser entry point
+    auto parsed = JsonParser::parse_file(path);
+    assert(parsed);
+    assert(parsed.value()->equals(*JsonParser::parse(contents).value()));
+    assert(!JsonParser::parse_file(bad_path));
+    assert(!JsonParser::parse_file(empty_path));
+    
+    // A document keeps the mapping for borrowed strings
+    {
+        JsonDocument doc;
+        JsonParseOptions options;
+        options.borrow_strings = true;
+        auto root = doc.parse_file(path, options);
+        assert(root);
+        auto name = static_pointer_cast<JsonStringValue>(
+            static_cast<const JsonObject&>(*doc.root()).get("name"));
+        assert(name->is_borrowed());
+        assert(name->view() == "reference");
+        assert(static_cast<const JsonObject&>(*doc.root()).get("rows")->array_value().size() == 1000);
+    }
+    
+    // C API
+    json_error_code error;
+    json_t* json = json_load_file(path.c_str(), 0, &error);
+    assert(json != nullptr);
+    assert(error == JSON_ERROR_SUCCESS);
+    assert(json_array_size(json_object_get(json, "rows")) == 1000);
+    json_delete(json);
+    
+    assert(json_load_file("does/not/exist.json", 0, &error) == nullptr);
+    assert(error == JSON_ERROR_INVALID_ARGUMENT);
+    assert(json_load_file(bad_path.c_str(), 0, &error) == nullptr);
+    assert(error == JSON_ERROR_PARSE_ERROR);
+    
+    std::remove(path.c_str());
+    std::remove(bad_path.c_str());
+    std::remove(empty_path.c_str());
+    
+    std::cout << "test_file_loading passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "json_frozen.hpp"
+#include "json_document.hpp"
+#include "json_parser.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_frozen..." << std::endl;
+    
+    std::string input = "{\"name\": \"api\", \"enabled\": true, \"ratio\": 0.25, \"id\": 9007199254740993,"
+                        " \"nothing\": null, \"tags\": [\"a\", \"b\", []], \"wide\": {";
+    for (int i = 0; i < 40; ++i) {
+        if (i > 0) input += ", ";
+        input += "\"k" + std::to_string(39 - i) + "\": " + std::to_string(i);
+    }
+    input += "}, \"rows\": [";
+    for (int i = 0; i < 100; ++i) {
+        if (i > 0) input += ", ";
+        input += "{\"id\": " + std::to_string(i) + ", \"label\": \"row\"}";
+    }
+    input += "]}";
+    
+    JsonDocument document;
+    auto parsed = document.parse(input);
+    assert(parsed);
+    auto frozen = document.freeze();
+    assert(frozen);
+    
+    // The frozen copy is independent of the document
+    JsonRef<JsonValue> original = JsonParser::parse(input).value();
+    document.clear();
+    
+    JsonFrozenValue root = frozen->root();
+    assert(root.is_object());
+    assert(root.size() == 8);
+    assert(root.key_at(0) == "name");
+    assert(root.find("name").string_value() == "api");
+    assert(root.find("enabled").boolean_value());
+    assert(root.find("ratio").is_real());
+    assert(root.find("ratio").number_value() == 0.25);
+    assert(root.find("id").is_integer());
+    assert(root.find("id").integer_value() == 9007199254740993LL);
+    assert(root.find("nothing").is_null());
+    assert(!root.find("missing"));
+    assert(!root.find("name").find("x"));
+    assert(root.contains("tags"));
+    
+    JsonFrozenValue tags = root.find("tags");
+    assert(tags.is_array() && tags.size() == 3);
+    assert(tags.at(1).string_value() == "b");
+    assert(tags.at(2).is_array() && tags.at(2).size() == 0);
+    
+    // Large objects use the sorted index; members keep their order
+    JsonFrozenValue wide = root.find("wide");
+    assert(wide.size() == 40);
+    assert(wide.key_at(0) == "k39");
+    for (int i = 0; i < 40; ++i) {
+        assert(wide.find("k" + std::to_string(i)).integer_value() == 39 - i);
+    }
+    assert(!wide.find("k40"));
+    assert(!wide.find(""));
+    
+    JsonFrozenValue rows = root.find("rows");
+    assert(rows.at(57).find("id").integer_value() == 57);
+    assert(rows.at(99).find("label").string_value() == "row");
+    
+    // Errors
+    bool threw = false;
+    try {
+        rows.at(100);
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        root.find("name").integer_value();
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Thawing gives back an equal, ordinary tree
+    JsonRef<JsonValue> thawed = root.thaw();
+    assert(thawed->equals(*original));
+    assert(frozen->node_count() == 8 + 3 + 40 + 1 + 100 * 3);
+    assert(frozen->memory_usage() > 0);
+    
+    // Readers see whole versions while a writer swaps them
+    JsonFrozenSlot slot(JsonFrozenDocument::freeze(*JsonParser::parse("{\"version\": 0, \"copy\": 0}").value()));
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&slot, &done]() {
+            std::int64_t last = 0;
+            while (!done.load()) {
+                auto snapshot = slot.load();
+                JsonFrozenValue config = snapshot->root();
+                std::int64_t version = config.find("version").integer_value();
+                assert(version == config.find("copy").integer_value());
+                assert(version >= last);
+                last = version;
+            }
+        });
+    }
+    for (int v = 1; v <= 200; ++v) {
+        std::string text = "{\"version\": " + std::to_string(v) + ", \"copy\": " + std::to_string(v) + "}";
+        slot.store(JsonFrozenDocument::freeze(*JsonParser::parse(text).value()));
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    auto previous = slot.exchange(nullptr);
+    assert(previous->root().find("version").integer_value() == 200);
+    assert(!slot.load());
+    
+    JsonDocument empty;
+    assert(!empty.freeze());
+    
+    std::cout << "test_frozen passed!" << std::endl;
+    return 0;
+}
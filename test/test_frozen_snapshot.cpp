@@ -0,0 +1,87 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "json_frozen.hpp"
+#include "json_parser.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_frozen_snapshot..." << std::endl;
+    
+    std::string input = "{\"version\": 3, \"ratio\": -1.5, \"enabled\": false, \"labels\": [\"x\", \"y\", null],"
+                        " \"table\": {";
+    for (int i = 0; i < 50; ++i) {
+        if (i > 0) input += ", ";
+        input += "\"entry" + std::to_string(i) + "\": {\"code\": " + std::to_string(i * 7) + "}";
+    }
+    input += "}}";
+    JsonRef<JsonValue> tree = JsonParser::parse(input).value();
+    auto frozen = JsonFrozenDocument::freeze(*tree);
+    
+    // The image is the snapshot; writing it needs no further encoding
+    std::string path = "test_frozen_snapshot.bin";
+    auto saved = frozen->save(path);
+    assert(saved && saved.value() == frozen->snapshot().size());
+    
+    auto loaded = JsonFrozenDocument::load(path);
+    assert(loaded);
+    auto document = loaded.value();
+    assert(document->node_count() == frozen->node_count());
+    assert(document->snapshot() == frozen->snapshot());
+    JsonFrozenValue root = document->root();
+    assert(root.find("version").integer_value() == 3);
+    assert(root.find("ratio").number_value() == -1.5);
+    assert(!root.find("enabled").boolean_value());
+    assert(root.find("labels").at(1).string_value() == "y");
+    assert(root.find("table").find("entry42").find("code").integer_value() == 294);
+    assert(root.find("table").key_at(49) == "entry49");
+    assert(root.thaw()->equals(*tree));
+    
+    auto unverified = JsonFrozenDocument::load(path, false);
+    assert(unverified && unverified.value()->root().find("table").size() == 50);
+    
+    // In-memory images are copied
+    std::string image(frozen->snapshot());
+    auto copied = JsonFrozenDocument::from_snapshot(image);
+    assert(copied && !copied.value()->is_mapped());
+    assert(copied.value()->root().thaw()->equals(*tree));
+    
+    // Damaged images are rejected
+    assert(!JsonFrozenDocument::from_snapshot(""));
+    assert(!JsonFrozenDocument::from_snapshot(std::string_view(image.data(), image.size() - 1)));
+    std::string bad_magic = image;
+    bad_magic[0] = 'X';
+    assert(!JsonFrozenDocument::from_snapshot(bad_magic));
+    
+    // Point the root's children past the node table
+    std::string bad_child = image;
+    std::uint64_t payload = 1000000;
+    std::memcpy(&bad_child[40 + 8], &payload, sizeof(payload));
+    assert(!JsonFrozenDocument::from_snapshot(bad_child));
+    assert(JsonFrozenDocument::from_snapshot(bad_child, false));
+    
+    // A string running past the string table
+    std::string bad_string = image;
+    bool damaged = false;
+    for (std::size_t i = 0; i < frozen->node_count(); ++i) {
+        std::size_t offset = 40 + i * 16;
+        if (static_cast<JsonType>(bad_string[offset]) == JsonType::String) {
+            std::uint32_t size = 0xffffff;
+            std::memcpy(&bad_string[offset + 4], &size, sizeof(size));
+            damaged = true;
+            break;
+        }
+    }
+    assert(damaged);
+    assert(!JsonFrozenDocument::from_snapshot(bad_string));
+    
+    assert(!JsonFrozenDocument::load("missing_snapshot.bin"));
+    
+    std::remove(path.c_str());
+    
+    std::cout << "test_frozen_snapshot passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include "json_gzip.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+#if JANSSON_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace jansson;
+
+#if JANSSON_HAVE_ZLIB
+
+static std::string compress(const JsonValue& value, JsonCompression format = JsonCompression::Gzip) {
+    JsonStringWriter out;
+    {
+        JsonGzipWriter writer(out, format, 6, 512);
+        JsonSerializer::serialize(writer, value);
+    }
+    return out.take();
+}
+
+// Feed compressed in pieces of step bytes
+static JsonRef<JsonValue> inflate_all(std::string_view compressed, size_t step) {
+    JsonStreamParser parser;
+    JsonGzipReader reader(parser);
+    for (size_t offset = 0; offset < compressed.size(); offset += step) {
+        assert(reader.feed(compressed.substr(offset, step)));
+    }
+    assert(reader.finish());
+    assert(parser.value_count() == 1);
+    return parser.take_value();
+}
+
+#endif
+
+int main() {
+    std::cout << "Running test_gzip_io..." << std::endl;
+
+#if JANSSON_HAVE_ZLIB
+    auto records = JsonArray::create();
+    for (int i = 0; i < 5000; ++i) {
+        auto record = JsonObject::create();
+        record->set("id", JsonNumber::create(i));
+        record->set("name", JsonStringValue::create("record " + std::to_string(i % 50)));
+        records->push_back(record);
+    }
+    JsonRef<JsonValue> value = records;
+    std::string text = JsonSerializer::serialize(*value);
+
+    // Round trip through any chunking of the compressed bytes
+    std::string gzip = compress(*value);
+    assert(gzip.size() < text.size() / 4);
+    assert(static_cast<unsigned char>(gzip[0]) == 0x1f && static_cast<unsigned char>(gzip[1]) == 0x8b);
+    for (size_t step : {size_t(1), size_t(7), size_t(4096), gzip.size()}) {
+        assert(inflate_all(gzip, step)->equals(*value));
+    }
+    std::string zlib = compress(*value, JsonCompression::Zlib);
+    assert(zlib != gzip && inflate_all(zlib, 100)->equals(*value));
+
+    // The writer counts both sides
+    JsonStringWriter sink;
+    {
+        JsonGzipWriter writer(sink);
+        JsonSerializer::serialize(writer, *value);
+        writer.finish();
+        assert(writer.size() == text.size() && writer.compressed_size() == sink.size());
+        writer.write("ignored");
+        assert(writer.compressed_size() == sink.size());
+    }
+
+    // zlib's own reader accepts the output
+    z_stream z{};
+    assert(inflateInit2(&z, 15 + 16) == Z_OK);
+    std::string inflated(text.size() + 16, '\0');
+    z.next_in = reinterpret_cast<Bytef*>(&gzip[0]);
+    z.avail_in = static_cast<uInt>(gzip.size());
+    z.next_out = reinterpret_cast<Bytef*>(&inflated[0]);
+    z.avail_out = static_cast<uInt>(inflated.size());
+    assert(inflate(&z, Z_FINISH) == Z_STREAM_END);
+    inflated.resize(z.total_out);
+    inflateEnd(&z);
+    assert(inflated == text);
+
+    // Concatenated members read as one stream of values
+    auto first = JsonParser::parse("{\"a\": 1}").value();
+    auto second = JsonParser::parse("[2, 3]").value();
+    std::string joined = compress(*first) + compress(*second);
+    JsonStreamParser parser;
+    JsonGzipReader reader(parser);
+    assert(reader.feed(joined).value() == 2);
+    assert(reader.finish());
+    assert(parser.take_value()->equals(*first) && parser.take_value()->equals(*second));
+
+    // Corrupt, truncated and empty input
+    std::string corrupt = gzip;
+    corrupt[gzip.size() / 2] ^= 0x55;
+    corrupt[gzip.size() / 2 + 1] ^= 0x55;
+    JsonStreamParser corrupt_parser;
+    JsonGzipReader corrupt_reader(corrupt_parser);
+    bool failed = !corrupt_reader.feed(corrupt) || !corrupt_reader.finish();
+    assert(failed);
+    JsonStreamParser truncated_parser;
+    JsonGzipReader truncated(truncated_parser);
+    assert(truncated.feed(std::string_view(gzip).substr(0, gzip.size() - 10)));
+    assert(truncated.finish().error() == make_error_code(JsonErrorCode::InvalidArgument));
+    JsonStreamParser empty_parser;
+    JsonGzipReader empty(empty_parser);
+    assert(!empty.finish());
+
+    // Malformed JSON inside valid compression fails with the parser's error
+    JsonStringWriter bad;
+    {
+        JsonGzipWriter writer(bad);
+        writer.write("[1, }");
+    }
+    JsonStreamParser bad_parser;
+    JsonGzipReader bad_reader(bad_parser);
+    assert(bad_reader.feed(bad.view()).error() == make_error_code(JsonErrorCode::ParseError));
+
+    // Files
+    const char* path = "test_gzip_io.json.gz";
+    assert(write_gzip_file(path, *value));
+    auto loaded = parse_gzip_file(path);
+    assert(loaded && loaded.value()->equals(*value));
+    std::remove(path);
+    assert(parse_gzip_file(path).error() == make_error_code(JsonErrorCode::InvalidArgument));
+#else
+    std::cout << "zlib not available, skipping" << std::endl;
+#endif
+
+    std::cout << "test_gzip_io passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <unordered_set>
+#include "json_c_api.hpp"
+#include "json_hash.hpp"
+#include "json_key.hpp"
+#include "json_value.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_hash_seed..." << std::endl;
+
+    // The requested seed applies to the first hash; later requests do not
+    // change it, so existing tables stay searchable
+    json_object_seed(12345);
+    std::size_t first = hash_bytes("key");
+    std::uint64_t seed = hash_seed();
+    set_hash_seed(999);
+    assert(hash_seed() == seed && hash_bytes("key") == first);
+
+    // Every string type hashes alike, and the cached key hash matches
+    std::string text = "a somewhat longer member name, past the short-key path";
+    assert(JsonStringHash<std::string>{}(text) == hash_bytes(text));
+    assert(JsonStringHash<std::string_view>{}(text) == hash_bytes(text));
+    assert(JsonKey(text).hash() == hash_bytes(text));
+    assert(JsonKey().hash() == hash_bytes(""));
+
+    // Each length path, including reads that straddle the end of the key,
+    // depends on every byte
+    std::string bytes(200, 'x');
+    std::unordered_set<std::size_t> seen;
+    for (std::size_t length = 0; length <= bytes.size(); ++length) {
+        std::string_view prefix(bytes.data(), length);
+        assert(seen.insert(hash_bytes(prefix)).second);
+        for (std::size_t i = 0; i < length; ++i) {
+            std::string changed(prefix);
+            changed[i] = 'y';
+            assert(hash_bytes(changed) != hash_bytes(prefix));
+        }
+    }
+
+    // Similar keys spread over the table instead of clustering
+    std::unordered_set<std::uint32_t> tags;
+    for (int i = 0; i < 100000; ++i) {
+        tags.insert(static_cast<std::uint32_t>(hash_bytes("id" + std::to_string(i))));
+    }
+    assert(tags.size() > 99990);
+
+    auto object = JsonObject::create();
+    for (int i = 0; i < 1000; ++i) {
+        object->set("member" + std::to_string(i), JsonNumber::create(static_cast<std::int64_t>(i)));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        assert(object->get("member" + std::to_string(i))->integer_value() == i);
+    }
+
+    std::cout << "test_hash_seed passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <cassert>
+#include <climits>
+#include <string>
+#include "json_c_api.hpp"
+
+static std::string dump(const json_t* json) {
+    char* text = json_dumps(json, 0);
+    assert(text != nullptr);
+    std::string result(text);
+    json_dumps_free(text);
+    return result;
+}
+
+int main() {
+    std::cout << "Running test_integer_precision..." << std::endl;
+    
+    json_error_code error;
+    
+    // Integers above 2^53 round-trip exactly
+    json_t* json = json_loads("[9007199254740993, -9223372036854775808, 9223372036854775807]", 0, &error);
+    assert(json != nullptr);
+    json_t* big = json_array_get(json, 0);
+    assert(json_is_integer(big) == 1);
+    assert(json_is_real(big) == 0);
+    assert(json_integer_value(big) == 9007199254740993LL);
+    assert(json_integer_value(json_array_get(json, 1)) == LLONG_MIN);
+    assert(json_integer_value(json_array_get(json, 2)) == LLONG_MAX);
+    assert(dump(json) == "[9007199254740993, -9223372036854775808, 9223372036854775807]");
+    json_delete(json);
+    
+    // Values with a fraction or exponent, or out of range, are reals
+    json = json_loads("[1.5, 1e3, 9223372036854775808, -0]", 0, &error);
+    assert(json != nullptr);
+    assert(json_is_real(json_array_get(json, 0)) == 1);
+    assert(json_is_real(json_array_get(json, 1)) == 1);
+    assert(json_real_value(json_array_get(json, 1)) == 1000.0);
+    assert(json_is_real(json_array_get(json, 2)) == 1);
+    assert(json_is_integer(json_array_get(json, 3)) == 1);
+    assert(json_integer_value(json_array_get(json, 3)) == 0);
+    json_delete(json);
+    
+    // Constructors
+    json_t* integer = json_integer(1234567890123456789LL);
+    assert(json_is_integer(integer) == 1);
+    assert(json_is_number(integer) == 1);
+    assert(dump(integer) == "1234567890123456789");
+    json_delete(integer);
+    
+    json_t* real = json_real(2.5);
+    assert(json_is_real(real) == 1);
+    assert(json_real_value(real) == 2.5);
+    assert(json_integer_value(real) == 2);
+    json_delete(real);
+    
+    std::cout << "test_integer_precision passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include "json_lines.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_json_lines..." << std::endl;
+    
+    // Build a log with blank lines, CRLF endings and one bad record
+    std::string input;
+    const int count = 5000;
+    for (int i = 0; i < count; ++i) {
+        input += "{\"seq\": " + std::to_string(i) + ", \"msg\": \"event\"}";
+        input += (i % 3 == 0) ? "\r\n" : "\n";
+        if (i % 1000 == 0) {
+            input += "   \n";
+        }
+    }
+    input += "{\"seq\": broken}\n";
+    
+    JsonLinesOptions options;
+    options.threads = 4;
+    options.chunk_size = 4096;
+    JsonLinesReader reader(options);
+    assert(reader.thread_count() == 4);
+    
+    // Results come back in input order
+    auto records = reader.parse(input);
+    assert(records.size() == count + 1);
+    for (int i = 0; i < count; ++i) {
+        assert(records[i]);
+        assert(records[i].value()->object_value().find("seq")->second->integer_value() == i);
+    }
+    assert(!records[count]);
+    
+    // Callback delivery with line numbers, and stopping early
+    std::vector<std::size_t> lines;
+    std::size_t delivered = reader.parse(input, [&lines](std::size_t line, JsonLinesReader::RecordResult& record) {
+        assert(record);
+        lines.push_back(line);
+        return lines.size() < 10;
+    });
+    assert(delivered == 10);
+    assert(lines.size() == 10);
+    assert(lines[0] == 1);
+    assert(lines[1] == 3);  // line 2 is blank
+    assert(lines[2] == 4);
+    
+    // The shared pool and tiny inputs
+    JsonLinesReader shared;
+    assert(shared.thread_count() >= 1);
+    assert(shared.parse("").empty());
+    auto single = shared.parse("[1, 2]");
+    assert(single.size() == 1 && single[0]);
+    assert(single[0].value()->array_value().size() == 2);
+    
+    // Same results regardless of chunk size
+    JsonLinesOptions tiny;
+    tiny.threads = 3;
+    tiny.chunk_size = 1;
+    JsonLinesReader tiny_reader(tiny);
+    auto again = tiny_reader.parse(input);
+    assert(again.size() == records.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        assert(again[i].value()->equals(*records[i].value()));
+    }
+    
+    // Records that fan out to the shared pool themselves
+    JsonLinesOptions nested;
+    nested.parse.parallel_threshold = 2;
+    JsonLinesReader nested_reader(nested);
+    std::string arrays;
+    for (int i = 0; i < 2000; ++i) {
+        arrays += "[1, 2, 3, 4, 5, 6, 7, 8]\n";
+    }
+    auto parsed = nested_reader.parse(arrays);
+    assert(parsed.size() == 2000);
+    for (const auto& record : parsed) {
+        assert(record && record.value()->array_value().size() == 8);
+    }
+    
+    std::cout << "test_json_lines passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_parser.hpp"
+#include "json_patch.hpp"
+#include "json_pointer.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static JsonRef<JsonValue> parse(std::string_view text) {
+    auto result = JsonParser::parse(text);
+    assert(result);
+    return result.value();
+}
+
+static std::string compact(const JsonValue& value) {
+    JsonSerializeOptions options;
+    options.compact = true;
+    options.sort_keys = true;
+    return JsonSerializer::serialize(value, options);
+}
+
+// Apply a patch and return the document, or "error" and the failing operation
+static std::string patched(std::string_view document, std::string_view patch, JsonPatchError* error = nullptr) {
+    JsonRef<JsonValue> value = parse(document);
+    if (!JsonPatch::apply(value, *parse(patch), error)) {
+        return "error";
+    }
+    return compact(*value);
+}
+
+static std::string merged(std::string_view document, std::string_view patch) {
+    JsonRef<JsonValue> value = parse(document);
+    JsonMergePatch::apply(value, *parse(patch));
+    return compact(*value);
+}
+
+// Diffs that, applied to source, give target
+static void check_diffs(std::string_view source_text, std::string_view target_text) {
+    auto source = parse(source_text);
+    auto target = parse(target_text);
+    JsonRef<JsonValue> document = source->clone();
+    assert(JsonPatch::apply(document, *JsonPatch::diff(*source, *target)));
+    assert(document->equals(*target));
+
+    document = source->clone();
+    JsonMergePatch::apply(document, *JsonMergePatch::diff(*source, *target));
+    assert(document->equals(*target));
+}
+
+int main() {
+    std::cout << "Running test_json_patch..." << std::endl;
+
+    // RFC 6902 appendix A
+    assert(patched("{\"foo\": \"bar\"}", "[{\"op\": \"add\", \"path\": \"/baz\", \"value\": \"qux\"}]") ==
+           "{\"baz\":\"qux\",\"foo\":\"bar\"}");
+    assert(patched("{\"foo\": [\"bar\", \"baz\"]}", "[{\"op\": \"add\", \"path\": \"/foo/1\", \"value\": \"qux\"}]") ==
+           "{\"foo\":[\"bar\",\"qux\",\"baz\"]}");
+    assert(patched("{\"foo\": [\"bar\"]}", "[{\"op\": \"add\", \"path\": \"/foo/-\", \"value\": [\"abc\"]}]") ==
+           "{\"foo\":[\"bar\",[\"abc\"]]}");
+    assert(patched("{\"baz\": \"qux\", \"foo\": \"bar\"}", "[{\"op\": \"remove\", \"path\": \"/baz\"}]") ==
+           "{\"foo\":\"bar\"}");
+    assert(patched("{\"foo\": [\"bar\", \"qux\", \"baz\"]}", "[{\"op\": \"remove\", \"path\": \"/foo/1\"}]") ==
+           "{\"foo\":[\"bar\",\"baz\"]}");
+    assert(patched("{\"baz\": \"qux\", \"foo\": \"bar\"}", "[{\"op\": \"replace\", \"path\": \"/baz\", \"value\": \"boo\"}]") ==
+           "{\"baz\":\"boo\",\"foo\":\"bar\"}");
+    assert(patched("{\"foo\": {\"bar\": \"baz\", \"waldo\": \"fred\"}, \"qux\": {\"corge\": \"grault\"}}",
+                   "[{\"op\": \"move\", \"from\": \"/foo/waldo\", \"path\": \"/qux/thud\"}]") ==
+           "{\"foo\":{\"bar\":\"baz\"},\"qux\":{\"corge\":\"grault\",\"thud\":\"fred\"}}");
+    assert(patched("{\"foo\": [\"all\", \"grass\", \"cows\", \"eat\"]}",
+                   "[{\"op\": \"move\", \"from\": \"/foo/1\", \"path\": \"/foo/3\"}]") ==
+           "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}");
+    assert(patched("{\"baz\": \"qux\", \"foo\": [\"a\", 2, \"c\"]}",
+                   "[{\"op\": \"test\", \"path\": \"/baz\", \"value\": \"qux\"},"
+                   " {\"op\": \"test\", \"path\": \"/foo/1\", \"value\": 2}]") ==
+           "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}");
+    assert(patched("{\"/\": 9, \"~1\": 10}", "[{\"op\": \"test\", \"path\": \"/~01\", \"value\": 10},"
+                   " {\"op\": \"copy\", \"from\": \"/~1\", \"path\": \"/x\"}]") == "{\"/\":9,\"x\":9,\"~1\":10}");
+    assert(patched("[1]", "[{\"op\": \"replace\", \"path\": \"\", \"value\": {\"a\": 1}}]") == "{\"a\":1}");
+
+    // Errors name the failing operation, and earlier ones stay applied
+    JsonPatchError error;
+    assert(patched("{\"baz\": \"qux\"}", "[{\"op\": \"test\", \"path\": \"/baz\", \"value\": \"bar\"}]", &error) == "error");
+    assert(error.operation == 0 && error.message == "Test failed");
+    JsonRef<JsonValue> document = parse("{\"a\": [1]}");
+    auto result = JsonPatch::apply(document, *parse("[{\"op\": \"add\", \"path\": \"/b\", \"value\": 2},"
+                                                    " {\"op\": \"remove\", \"path\": \"/a/5\"}]"), &error);
+    assert(result.error() == make_error_code(JsonErrorCode::IndexOutOfBounds) && error.operation == 1);
+    assert(compact(*document) == "{\"a\":[1],\"b\":2}");
+    const char* malformed[] = {
+        "{}", "[1]", "[{\"path\": \"/a\"}]", "[{\"op\": \"add\", \"path\": \"a\", \"value\": 1}]",
+        "[{\"op\": \"add\", \"path\": \"/a\"}]", "[{\"op\": \"jump\", \"path\": \"/a\"}]",
+        "[{\"op\": \"move\", \"from\": \"/a\", \"path\": \"/a/b\"}]", "[{\"op\": \"remove\", \"path\": \"\"}]",
+    };
+    for (const char* patch : malformed) {
+        document = parse("{\"a\": {\"x\": 1}}");
+        assert(JsonPatch::apply(document, *parse(patch)).error() == make_error_code(JsonErrorCode::InvalidArgument));
+    }
+    assert(patched("{\"a\": 1}", "[{\"op\": \"add\", \"path\": \"/a/b\", \"value\": 1}]", &error) == "error");
+    assert(patched("{}", "[{\"op\": \"replace\", \"path\": \"/a\", \"value\": 1}]") == "error");
+    assert(patched("[1]", "[{\"op\": \"add\", \"path\": \"/2\", \"value\": 1}]") == "error");
+
+    // Patching in place: moved and untouched subtrees keep their nodes,
+    // while a tree sharing the document is not affected
+    document = parse("{\"config\": {\"limits\": {\"cpu\": 2}, \"tags\": [\"a\"]}, \"static\": {\"big\": [1, 2, 3]}}");
+    JsonRef<JsonValue> before = document->cow_clone();
+    const JsonValue* untouched = JsonPointer::parse("/static").value().find(*document);
+    assert(JsonPatch::apply(document, *parse("[{\"op\": \"replace\", \"path\": \"/config/limits/cpu\", \"value\": 4},"
+                                             " {\"op\": \"move\", \"from\": \"/config/limits\", \"path\": \"/limits\"}]")));
+    assert(JsonPointer::parse("/static").value().find(*document) == untouched);
+    assert(JsonPointer::parse("/limits").value().find(*document) != nullptr);
+    assert(compact(*document) == "{\"config\":{\"tags\":[\"a\"]},\"limits\":{\"cpu\":4},\"static\":{\"big\":[1,2,3]}}");
+    assert(compact(*before) == "{\"config\":{\"limits\":{\"cpu\":2},\"tags\":[\"a\"]},\"static\":{\"big\":[1,2,3]}}");
+
+    // Generated patches
+    auto source = parse("{\"a\": 1, \"b\": [1, 2, 3, 4], \"c\": {\"d\": true}, \"big\": [[1], [2], [3]]}");
+    auto target = parse("{\"a\": 2, \"b\": [1, 3, 4], \"c\": {\"d\": true, \"e\": null}, \"big\": [[1], [2], [3]]}");
+    auto patch = JsonPatch::diff(*source, *target);
+    assert(compact(*patch) == "[{\"op\":\"replace\",\"path\":\"/a\",\"value\":2},"
+                              "{\"op\":\"remove\",\"path\":\"/b/1\"},"
+                              "{\"op\":\"add\",\"path\":\"/c/e\",\"value\":null}]");
+    assert(JsonPatch::diff(*source, *source->clone())->empty());
+    
+    // Kept hashes follow changes made below them through other references
+    auto edited = source->clone();
+    assert(!JsonPatch::diff(*source, *target)->empty() && edited->hash() == source->hash());
+    auto& inner = static_cast<JsonArray&>(*static_cast<JsonObject&>(*edited).get("big")->array_value().at(1));
+    inner.set(0, JsonNumber::create(9));
+    assert(compact(*JsonPatch::diff(*source, *edited)) == "[{\"op\":\"replace\",\"path\":\"/big/1/0\",\"value\":9}]");
+    inner.set(0, JsonNumber::create(2));
+    assert(JsonPatch::diff(*source, *edited)->empty());
+    check_diffs("{\"a\": 1, \"b\": [1, 2, 3, 4], \"c\": {\"d\": true}}",
+                "{\"a\": [], \"b\": [0, 1, 5, 6, 4, 7], \"c\": {\"x~/y\": {\"z\": 1}}}");
+    check_diffs("[1, 2, 3]", "[]");
+    check_diffs("[]", "[1, 2, 3]");
+    check_diffs("[{\"k\": 1}, {\"k\": 2}]", "[{\"k\": 1}, {\"k\": 3}, {\"k\": 2}]");
+    check_diffs("{\"a\": 1}", "\"scalar\"");
+    check_diffs("{\"a\": {\"b\": {\"c\": 1, \"d\": 2}}}", "{\"a\": {\"b\": {\"d\": 3}}, \"e\": {\"f\": 1}}");
+
+    // RFC 7386 appendix A
+    assert(merged("{\"a\": \"b\"}", "{\"a\": \"c\"}") == "{\"a\":\"c\"}");
+    assert(merged("{\"a\": \"b\"}", "{\"b\": \"c\"}") == "{\"a\":\"b\",\"b\":\"c\"}");
+    assert(merged("{\"a\": \"b\"}", "{\"a\": null}") == "{}");
+    assert(merged("{\"a\": \"b\", \"b\": \"c\"}", "{\"a\": null}") == "{\"b\":\"c\"}");
+    assert(merged("{\"a\": [\"b\"]}", "{\"a\": \"c\"}") == "{\"a\":\"c\"}");
+    assert(merged("{\"a\": \"c\"}", "{\"a\": [\"b\"]}") == "{\"a\":[\"b\"]}");
+    assert(merged("{\"a\": {\"b\": \"c\"}}", "{\"a\": {\"b\": \"d\", \"c\": null}}") == "{\"a\":{\"b\":\"d\"}}");
+    assert(merged("{\"a\": [{\"b\": \"c\"}]}", "{\"a\": [1]}") == "{\"a\":[1]}");
+    assert(merged("[\"a\", \"b\"]", "[\"c\", \"d\"]") == "[\"c\",\"d\"]");
+    assert(merged("{\"a\": \"b\"}", "[\"c\"]") == "[\"c\"]");
+    assert(merged("{\"a\": \"foo\"}", "null") == "null");
+    assert(merged("{\"e\": null}", "{\"a\": 1}") == "{\"a\":1,\"e\":null}");
+    assert(merged("[1, 2]", "{\"a\": \"b\", \"c\": null}") == "{\"a\":\"b\"}");
+    assert(merged("{}", "{\"a\": {\"bb\": {\"ccc\": null}}}") == "{\"a\":{\"bb\":{}}}");
+
+    auto merge = JsonMergePatch::diff(*parse("{\"a\": 1, \"b\": {\"c\": 2, \"d\": 3}, \"e\": 4}"),
+                                      *parse("{\"a\": 1, \"b\": {\"c\": 5, \"d\": 3}, \"f\": [1]}"));
+    assert(compact(*merge) == "{\"b\":{\"c\":5},\"e\":null,\"f\":[1]}");
+
+    std::cout << "test_json_patch passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_pointer.hpp"
+#include "json_parser.hpp"
+
+using namespace jansson;
+
+static JsonPointer pointer(std::string_view text) {
+    auto parsed = JsonPointer::parse(text);
+    assert(parsed);
+    return parsed.value();
+}
+
+int main() {
+    std::cout << "Running test_json_pointer..." << std::endl;
+    
+    // The example document of RFC 6901 section 5
+    std::string input = "{\"foo\": [\"bar\", \"baz\"], \"\": 0, \"a/b\": 1, \"c%d\": 2, \"e^f\": 3,"
+                        " \"g|h\": 4, \"i\\\\j\": 5, \"k\\\"l\": 6, \" \": 7, \"m~n\": 8}";
+    JsonRef<JsonValue> document = JsonParser::parse(input).value();
+    
+    assert(pointer("").find(*document) == document.get());
+    assert(pointer("/foo").find(*document)->is_array());
+    assert(pointer("/foo/0").find(*document)->string_value() == "bar");
+    assert(pointer("/").find(*document)->integer_value() == 0);
+    assert(pointer("/a~1b").find(*document)->integer_value() == 1);
+    assert(pointer("/c%d").find(*document)->integer_value() == 2);
+    assert(pointer("/e^f").find(*document)->integer_value() == 3);
+    assert(pointer("/g|h").find(*document)->integer_value() == 4);
+    assert(pointer("/i\\j").find(*document)->integer_value() == 5);
+    assert(pointer("/k\"l").find(*document)->integer_value() == 6);
+    assert(pointer("/ ").find(*document)->integer_value() == 7);
+    assert(pointer("/m~0n").find(*document)->integer_value() == 8);
+    
+    // Paths that do not resolve
+    assert(!pointer("/missing").find(*document));
+    assert(!pointer("/foo/2").find(*document));
+    assert(!pointer("/foo/-").find(*document));
+    assert(!pointer("/foo/01").find(*document));
+    assert(!pointer("/foo/x").find(*document));
+    assert(!pointer("/foo/0/deeper").find(*document));
+    assert(!pointer("/foo/99999999999999999999999").find(*document));
+    
+    // Syntax errors
+    assert(!JsonPointer::parse("foo"));
+    assert(!JsonPointer::parse("/a~"));
+    assert(!JsonPointer::parse("/a~2"));
+    assert(JsonPointer::parse("/a~2").error() == make_error_code(JsonErrorCode::InvalidArgument));
+    
+    // Tokens are decoded once
+    JsonPointer escaped = pointer("/a~1b/~0/3/-");
+    assert(escaped.size() == 4);
+    assert(escaped.token(0) == "a/b");
+    assert(escaped.token(1) == "~");
+    assert(escaped.array_index(2) == 3);
+    assert(escaped.array_index(0) == JsonPointer::npos);
+    assert(escaped.is_end_of_array(3));
+    assert(escaped.to_string() == "/a~1b/~0/3/-");
+    assert(escaped.parent() == pointer("/a~1b/~0/3"));
+    assert(escaped.parent().parent().parent().parent() == JsonPointer());
+    assert(JsonPointer().parent().empty());
+    
+    // Owning and mutable lookups
+    JsonRef<JsonValue> baz = pointer("/foo/1").get(*document);
+    assert(baz && baz->string_value() == "baz");
+    assert(!pointer("/nope").get(*document));
+    JsonValue* array = pointer("/foo").find(static_cast<JsonValue&>(*document));
+    static_cast<JsonArray*>(array)->push_back(JsonNull::create());
+    assert(pointer("/foo/2").find(*document)->is_null());
+    
+    // Lazy documents only walk the index
+    JsonLazyDocument lazy;
+    assert(lazy.load("{\"skip\": {\"large\": [1, 2, 3]}, \"rules\": [{\"id\": \"r1\"}, {\"id\": \"r2\"}]}"));
+    auto id = pointer("/rules/1/id").find(lazy.root());
+    assert(id && id.value().get_string().value() == "r2");
+    assert(pointer("/rules/5").find(lazy.root()).error() == make_error_code(JsonErrorCode::IndexOutOfBounds));
+    assert(pointer("/rules/x").find(lazy.root()).error() == make_error_code(JsonErrorCode::IndexOutOfBounds));
+    assert(pointer("/absent").find(lazy.root()).error() == make_error_code(JsonErrorCode::KeyNotFound));
+    assert(pointer("/rules/0/id/z").find(lazy.root()).error() == make_error_code(JsonErrorCode::InvalidType));
+    
+    // Frozen documents
+    auto frozen = JsonFrozenDocument::freeze(*document);
+    assert(pointer("/m~0n").find(frozen->root()).integer_value() == 8);
+    assert(pointer("/foo/1").find(frozen->root()).string_value() == "baz");
+    assert(!pointer("/foo/7").find(frozen->root()));
+    assert(!pointer("/foo/0/x").find(frozen->root()));
+    
+    std::cout << "test_json_pointer passed!" << std::endl;
+    return 0;
+}
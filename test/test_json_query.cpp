@@ -0,0 +1,137 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_query.hpp"
+#include "json_lazy.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static const char* document = R"({
+    "users": [
+        {"name": "ann", "email": "ann@example.com", "active": true, "age": 31, "tags": ["a", "b"]},
+        {"name": "bob", "email": "bob@example.com", "active": false, "age": 25, "tags": []},
+        {"name": "cy", "active": true, "age": 40.5, "tags": ["c"], "manager": {"name": "ann"}},
+        {"name": "dee", "email": "dee@example.com", "active": true, "age": 19, "tags": [["x", "y"], "z"]}
+    ],
+    "counts": {"red": 2, "green": null, "blue": 5},
+    "matrix": [[1, 2], [3], [], 4],
+    "empty": [],
+    "text": "plain",
+    "odd key": {"0": "zero"}
+})";
+
+static std::string compact(const JsonRef<JsonValue>& value) {
+    if (!value) {
+        return "null";
+    }
+    JsonSerializeOptions options;
+    options.compact = true;
+    return JsonSerializer::serialize(*value, options);
+}
+
+// Evaluate on the tree, the text and a lazy document and check they agree
+static std::string query(const JsonValue& root, JsonLazyDocument& lazy, const char* expression) {
+    auto compiled = JsonQuery::compile(expression);
+    assert(compiled);
+    std::string expected = compact(compiled.value().evaluate(root));
+    auto streamed = compiled.value().evaluate_text(document);
+    assert(streamed && compact(streamed.value()) == expected);
+    auto lazily = compiled.value().evaluate(lazy.root());
+    assert(lazily && compact(lazily.value()) == expected);
+    return expected;
+}
+
+static JsonQueryError compile_failure(const char* expression) {
+    JsonQueryError error;
+    assert(!JsonQuery::compile(expression, &error));
+    return error;
+}
+
+int main() {
+    std::cout << "Running test_json_query..." << std::endl;
+
+    auto root = JsonParser::parse(document).value();
+    JsonLazyDocument lazy;
+    assert(lazy.load(document));
+    auto q = [&](const char* expression) { return query(*root, lazy, expression); };
+
+    // Members, indices and the current value
+    assert(q("text") == "\"plain\"");
+    assert(q("users[0].name") == "\"ann\"");
+    assert(q("users[-1].name") == "\"dee\"");
+    assert(q("users[2].manager.name") == "\"ann\"");
+    assert(q("\"odd key\".\"0\"") == "\"zero\"");
+    assert(q("@.counts.red") == "2");
+    assert(q("missing") == "null" && q("text.length") == "null" && q("users[9]") == "null");
+    assert(q("counts.green") == "null");
+    assert(q("@") == compact(root));
+
+    // Projections drop null results
+    assert(q("users[*].email") == "[\"ann@example.com\",\"bob@example.com\",\"dee@example.com\"]");
+    assert(q("counts.*") == "[2,5]");
+    assert(q("users[*].manager.name") == "[\"ann\"]");
+    assert(q("users[*].tags") == "[[\"a\",\"b\"],[],[\"c\"],[[\"x\",\"y\"],\"z\"]]");
+    assert(q("users[*].tags[0]") == "[\"a\",\"c\",[\"x\",\"y\"]]");
+    assert(q("empty[*]") == "[]" && q("text[*]") == "null" && q("users.*") == "null");
+
+    // Filters
+    assert(q("users[?active].email") == "[\"ann@example.com\",\"dee@example.com\"]");
+    assert(q("users[?!active].name") == "[\"bob\"]");
+    assert(q("users[?age > `30`].name") == "[\"ann\",\"cy\"]");
+    assert(q("users[?age <= `25` && active].name") == "[\"dee\"]");
+    assert(q("users[?name == 'bob' || manager.name == 'ann'].name") == "[\"bob\",\"cy\"]");
+    assert(q("users[?tags].name") == "[\"ann\",\"cy\",\"dee\"]");
+    assert(q("users[?email != `null`] | [0].name") == "\"ann\"");
+    assert(q("users[?!(age < `30` || name == 'cy')].age") == "[31]");
+    assert(q("users[?tags == `[\"c\"]`].name") == "[\"cy\"]");
+    assert(q("matrix[?@ == `4`]") == "[4]");
+    assert(q("users[?name > `1`]") == "[]");
+
+    // Flatten and slices
+    assert(q("matrix[]") == "[1,2,3,4]");
+    assert(q("users[*].tags[]") == "[\"a\",\"b\",\"c\",[\"x\",\"y\"],\"z\"]");
+    assert(q("users[*].tags[][]") == "[\"a\",\"b\",\"c\",\"x\",\"y\",\"z\"]");
+    assert(q("users[1:3].name") == "[\"bob\",\"cy\"]");
+    assert(q("users[::2].name") == "[\"ann\",\"cy\"]");
+    assert(q("users[::-1].name") == "[\"dee\",\"cy\",\"bob\",\"ann\"]");
+    assert(q("users[-2:].name") == "[\"cy\",\"dee\"]");
+    assert(q("users[5:0:-2].name") == "[\"dee\",\"bob\"]");
+    assert(q("users[10:]") == "[]");
+
+    // Pipes end projections
+    assert(q("users[*].name | [0]") == "\"ann\"");
+    assert(q("users[*].name[0]") == "[]");
+    assert(q("users | [1].name") == "\"bob\"");
+    assert(q("counts | red") == "2");
+
+    // Results share the tree's nodes
+    auto first = JsonQuery::compile("users[0]").value().evaluate(*root);
+    assert(first.get() == static_cast<const JsonArray&>(*static_cast<const JsonObject&>(*root).get("users")).at(0).get());
+
+    // A compiled query is reusable across documents
+    auto names = JsonQuery::compile("[?active].name").value();
+    assert(compact(names.evaluate(*JsonParser::parse("[{\"active\": 1, \"name\": \"x\"}]").value())) == "[\"x\"]");
+    assert(!names.evaluate(*JsonParser::parse("{}").value()));
+    assert(names.expression() == "[?active].name");
+    assert(JsonQuery().evaluate(*root).get() == root.get());
+
+    // Streaming scalars and malformed text
+    assert(compact(JsonQuery::compile("@").value().evaluate_text("12").value()) == "12");
+    assert(!JsonQuery::compile("a[*]").value().evaluate_text("{\"a\": [1,}"));
+
+    // Compile errors
+    assert(compile_failure("").message == "Expected an identifier");
+    assert(compile_failure("a.").position == 2);
+    assert(compile_failure("a[1").message == "Expected ']'");
+    assert(compile_failure("a[::0]").message == "Slice step cannot be 0");
+    assert(compile_failure("a[?b == `{`]").message == "Invalid JSON literal");
+    assert(compile_failure("a b").position == 2);
+    assert(compile_failure("a[?(b]").message == "Expected ')'");
+    assert(compile_failure("a[99999999999999999999]").message == "Number out of range");
+    assert(compile_failure("\"open").message == "Unterminated quoted identifier");
+
+    std::cout << "test_json_query passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_schema.hpp"
+#include "json_parser.hpp"
+
+using namespace jansson;
+
+static JsonSchema schema_of(const char* text) {
+    auto compiled = JsonSchema::compile(*JsonParser::parse(text).value());
+    assert(compiled);
+    return compiled.value();
+}
+
+// The text, tree and parse paths agree; returns the error message, empty
+// if input is valid
+static std::string check(const JsonSchema& schema, const char* input, std::string* path = nullptr) {
+    JsonSchemaError text_error;
+    auto streamed = schema.validate(std::string_view(input), &text_error);
+    assert(streamed);
+
+    JsonSchemaError tree_error;
+    bool tree = schema.validate(*JsonParser::parse(input).value(), &tree_error);
+    assert(tree == streamed.value());
+
+    JsonSchemaError parse_error;
+    auto parsed = schema.parse(input, &parse_error);
+    assert(bool(parsed) == tree);
+    if (tree) {
+        assert(parsed.value()->equals(*JsonParser::parse(input).value()));
+        return "";
+    }
+    assert(parsed.error() == make_error_code(JsonErrorCode::SchemaViolation));
+    assert(text_error.path == tree_error.path && text_error.path == parse_error.path);
+    assert(text_error.message == tree_error.message && text_error.message == parse_error.message);
+    if (path) {
+        *path = text_error.path;
+    }
+    return text_error.message;
+}
+
+int main() {
+    std::cout << "Running test_json_schema..." << std::endl;
+
+    JsonSchema request = schema_of(R"({
+        "type": "object",
+        "required": ["id", "user"],
+        "properties": {
+            "id": {"type": "integer", "minimum": 1},
+            "user": {"$ref": "#/$defs/user"},
+            "tags": {"type": "array", "items": {"type": "string", "maxLength": 4}, "uniqueItems": true},
+            "kind": {"enum": ["a", "b", {"c": 1}]},
+            "score": {"type": "number", "exclusiveMaximum": 10, "multipleOf": 0.5}
+        },
+        "additionalProperties": false,
+        "$defs": {
+            "user": {
+                "type": "object",
+                "properties": {
+                    "name": {"type": "string", "minLength": 1, "pattern": "^[a-z]+$"},
+                    "friends": {"type": "array", "items": {"$ref": "#/$defs/user"}, "maxItems": 2}
+                },
+                "required": ["name"]
+            }
+        }
+    })");
+
+    assert(check(request, R"({"id": 3, "user": {"name": "ann"}})").empty());
+    assert(check(request, R"({"id": 3, "user": {"name": "ann", "friends": [{"name": "bob", "friends": []}]},
+                              "tags": ["x", "y"], "kind": {"c": 1}, "score": 9.5})").empty());
+
+    std::string path;
+    assert(check(request, R"({"id": 0, "user": {"name": "ann"}})", &path) == "Value is below the minimum");
+    assert(path == "/id");
+    assert(check(request, R"({"id": 1.5, "user": {"name": "ann"}})") == "Expected integer");
+    assert(check(request, R"({"id": 1})", &path) == "Missing required member \"user\"" && path.empty());
+    assert(check(request, R"({"id": 1, "user": {"name": "Ann"}})", &path) == "String does not match pattern");
+    assert(path == "/user/name");
+    assert(check(request, R"({"id": 1, "user": {"name": "ann", "friends": [{"name": "b"}, {}]}})", &path) ==
+           "Missing required member \"name\"");
+    assert(path == "/user/friends/1");
+    assert(check(request, R"({"id": 1, "user": {"name": "a", "friends": [{"name": "b"}, {"name": "c"}, {"name": "d"}]}})") ==
+           "Array has more elements than maxItems");
+    assert(check(request, R"({"id": 1, "user": {"name": "a"}, "tags": ["x", "x"]})") == "Array elements are not unique");
+    assert(check(request, R"({"id": 1, "user": {"name": "a"}, "tags": ["long one"]})", &path) ==
+           "String is longer than maxLength");
+    assert(path == "/tags/0");
+    assert(check(request, R"({"id": 1, "user": {"name": "a"}, "kind": {"c": 2}})") == "Value is not in enum");
+    assert(check(request, R"({"id": 1, "user": {"name": "a"}, "score": 10})") == "Value is above the maximum");
+    assert(check(request, R"({"id": 1, "user": {"name": "a"}, "score": 0.7})") == "Value is not a multiple of multipleOf");
+    assert(check(request, R"({"id": 1, "user": {"name": "a"}, "extra~/": 1})", &path) == "Value not allowed by the schema");
+    assert(path == "/extra~0~1");
+    assert(check(request, "[]") == "Expected object");
+
+    // Combinators: failures inside anyOf, oneOf and not branches are not final
+    JsonSchema combined = schema_of(R"({
+        "type": "array",
+        "items": {
+            "anyOf": [{"type": "string"}, {"type": "integer", "minimum": 0}],
+            "not": {"const": "forbidden"}
+        },
+        "prefixItems": [{"oneOf": [{"type": "integer"}, {"type": "number", "maximum": 5}]}]
+    })");
+    assert(check(combined, R"([7, "x", 3])").empty());
+    assert(check(combined, R"([7.5, "x"])", &path) == "Value must match exactly one schema in oneOf" && path == "/0");
+    assert(check(combined, R"([2.5, "x"])").empty());
+    assert(check(combined, R"([7, -1])", &path) == "Value matches no schema in anyOf" && path == "/1");
+    assert(check(combined, R"([7, "forbidden"])") == "Value matches the schema in not");
+    assert(check(combined, R"([7, [1, 2]])") == "Value matches no schema in anyOf");
+    JsonSchema exclusive = schema_of(R"({"oneOf": [{"type": "integer"}, {"minimum": 0}]})");
+    assert(check(exclusive, "-1").empty() && check(exclusive, "0.5").empty());
+    assert(check(exclusive, "1") == "Value must match exactly one schema in oneOf");
+
+    // Draft 7 tuples, patternProperties, counts, const, boolean schemas
+    JsonSchema tuple = schema_of(R"({"items": [{"type": "null"}, {"type": "boolean"}], "additionalItems": false, "minItems": 1})");
+    assert(check(tuple, "[null, true]").empty());
+    assert(check(tuple, "[null, true, 1]", &path) == "Value not allowed by the schema" && path == "/2");
+    assert(check(tuple, "[]") == "Array has fewer elements than minItems");
+    JsonSchema patterned = schema_of(R"({"patternProperties": {"^x-": {"type": "string"}}, "additionalProperties": {"type": "integer"},
+                                        "maxProperties": 2, "minProperties": 1})");
+    assert(check(patterned, R"({"x-a": "s", "n": 1})").empty());
+    assert(check(patterned, R"({"x-a": 1})") == "Expected string");
+    assert(check(patterned, R"({"b": "s"})") == "Expected integer");
+    assert(check(patterned, R"({"a": 1, "b": 2, "c": 3})") == "Object has more members than maxProperties");
+    assert(check(patterned, "{}") == "Object has fewer members than minProperties");
+    
+    // Parser limits for untrusted input
+    JsonSchema lowercase = schema_of(R"({"type": "string", "pattern": "^[a-z]+$"})");
+    JsonParseOptions limits;
+    limits.max_nodes = 3;
+    assert(lowercase.validate(std::string_view("\"abc\""), limits).value());
+    assert(schema_of("true").validate(std::string_view("[1, 2, 3]"), limits).error() ==
+           make_error_code(JsonErrorCode::LimitExceeded));
+    limits.max_string_length = 2;
+    assert(lowercase.parse("\"abc\"", limits).error() == make_error_code(JsonErrorCode::LimitExceeded));
+
+    // Subjects too long for std::regex are violations, not stack overflows
+    std::string at_limit = "\"" + std::string(JsonSchema::max_pattern_subject, 'a') + "\"";
+    assert(check(lowercase, at_limit.c_str()).empty());
+    std::string long_text = "\"" + std::string(100000, 'a') + "\"";
+    assert(check(lowercase, long_text.c_str()) == "String is too long to match pattern");
+    std::string long_key = "{\"x-" + std::string(100000, 'a') + "\": \"s\"}";
+    assert(check(patterned, long_key.c_str()) == "Property name is too long to match patternProperties");
+    assert(check(schema_of(R"({"const": [1, {"a": null}]})"), R"([1, {"a": null}])").empty());
+    assert(check(schema_of(R"({"const": [1, {"a": null}]})"), R"([1, {"a": 0}])") == "Value does not equal const");
+    assert(check(schema_of("true"), R"({"anything": [1, 2]})").empty());
+    assert(check(schema_of("false"), "null") == "Value not allowed by the schema");
+    assert(check(schema_of(R"({"type": ["string", "null"], "minLength": 2})"), "\"\xc3\xa9\"") ==
+           "String is shorter than minLength");
+    assert(check(schema_of(R"({"type": "integer"})"), "2.0").empty());
+    assert(check(schema_of(R"({"minimum": 5, "exclusiveMinimum": true})"), "5") == "Value is below the minimum");
+    assert(check(JsonSchema(), R"([{"x": 1}])").empty());
+
+    // A schema that only recurses into itself fails rather than looping
+    assert(check(schema_of(R"({"$ref": "#"})"), "1") == "Schema references nest too deeply");
+
+    // The first violation stops the parse, even before malformed input
+    JsonSchema small = schema_of(R"({"type": "array", "items": {"maximum": 10}})");
+    JsonSchemaError error;
+    auto stopped = small.validate(std::string_view("[1, 2, 30, 4, }"), &error);
+    assert(stopped && !stopped.value() && error.path == "/2");
+    assert(!small.validate(std::string_view("[1, 2, }")));
+    assert(small.parse("[1, }").error() != make_error_code(JsonErrorCode::SchemaViolation));
+
+    // Skipped subtrees are still checked for syntax
+    JsonSchema loose = schema_of(R"({"properties": {"a": {"type": "integer"}}})");
+    assert(loose.validate(std::string_view(R"({"b": {"deep": [1, [2, {"x": null}]]}, "a": 1})")).value());
+    assert(!loose.validate(std::string_view(R"({"b": {"deep": [1, [2, {"x" null}]]}, "a": 1})")));
+
+    // Malformed schemas
+    JsonSchemaError schema_error;
+    auto must_fail = [&](const char* text) {
+        assert(!JsonSchema::compile(*JsonParser::parse(text).value(), &schema_error));
+        return schema_error.path + ": " + schema_error.message;
+    };
+    assert(must_fail(R"({"type": "text"})") == "/type: Unknown type");
+    assert(must_fail(R"({"properties": {"a": {"minLength": -1}}})") == "/properties/a/minLength: Expected a non-negative integer");
+    assert(must_fail(R"({"pattern": "("})") == "/pattern: Invalid regular expression");
+    assert(must_fail(R"({"$ref": "#/$defs/missing"})") == "/$ref: Unresolved $ref");
+    assert(must_fail(R"({"allOf": []})") == "/allOf: Expected a non-empty array of schemas");
+    assert(must_fail(R"({"items": 3})") == "/items: Expected a schema (an object or a boolean)");
+    assert(must_fail(R"({"multipleOf": 0})") == "/multipleOf: Expected a positive number");
+
+    std::cout << "test_json_schema passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+#include "json_key.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_stream.hpp"
+#include "json_thread_pool.hpp"
+
+using namespace jansson;
+
+// Key of the member at position index of an object
+static const JsonKey& key_at(const JsonValue& object, std::size_t index) {
+    return (object.object_value().begin() + index)->first;
+}
+
+int main() {
+    std::cout << "Running test_key_interning..." << std::endl;
+    
+    // Keys own NUL-terminated bytes and a cached hash
+    JsonKey plain(std::string_view("name"));
+    JsonKey copy = plain;
+    assert(copy.same_record(plain));
+    assert(copy == "name");
+    assert(std::string(copy.c_str()) == "name");
+    assert(plain.hash() == hash_bytes("name"));
+    JsonKey other(std::string_view("name"));
+    assert(other == plain && !other.same_record(plain));
+    assert(JsonKey().empty() && JsonKey() == "");
+    
+    // A table hands out one record per distinct name
+    JsonKeyTable table;
+    JsonKey a = table.intern("id");
+    JsonKey b = table.intern(std::string("id"));
+    assert(a.same_record(b));
+    assert(!table.intern("other").same_record(a));
+    assert(table.size() == 2);
+    {
+        JsonKey temporary = table.intern("temporary");
+        table.purge();
+        assert(table.size() == 2);
+    }
+    table.purge();
+    assert(table.size() == 1);
+    table.clear();
+    assert(a == "id" && a.same_record(b));
+    
+    // Parsing interns repeated member names within a document
+    std::string users = "{\"users\": [";
+    for (int i = 0; i < 50; ++i) {
+        if (i > 0) {
+            users += ", ";
+        }
+        users += "{\"id\": " + std::to_string(i) + ", \"name\": \"user\", \"email\": \"u@example.com\"}";
+    }
+    users += "]}";
+    auto parsed = JsonParser::parse(users);
+    assert(parsed);
+    const auto& records = static_cast<const JsonArray&>(*parsed.value()->object_value().at("users"));
+    for (std::size_t i = 1; i < records.size(); ++i) {
+        for (std::size_t k = 0; k < 3; ++k) {
+            assert(key_at(*records.at(i), k).same_record(key_at(*records.at(0), k)));
+        }
+    }
+    assert(JsonSerializer::serialize(*parsed.value()) == users);
+    
+    // A caller-provided table is shared across documents
+    JsonKeyTable shared;
+    JsonParseOptions options;
+    options.key_table = &shared;
+    auto first = JsonParser::parse("{\"id\": 1, \"tag\\u0041\": 2}", options);
+    auto second = JsonParser::parse("{\"id\": 3}", options);
+    assert(key_at(*first.value(), 0).same_record(key_at(*second.value(), 0)));
+    assert(key_at(*first.value(), 1) == "tagA");
+    assert(shared.size() == 2);
+    
+    // Interning can be turned off
+    options.key_table = nullptr;
+    options.intern_keys = false;
+    auto unshared = JsonParser::parse("[{\"id\": 1}, {\"id\": 2}]", options);
+    const auto& pair = static_cast<const JsonArray&>(*unshared.value());
+    assert(!key_at(*pair.at(0), 0).same_record(key_at(*pair.at(1), 0)));
+    
+    // Parallel parsing with the global (synchronized) table
+    JsonThreadPool pool(4);
+    options.intern_keys = true;
+    options.key_table = &JsonKeyTable::global();
+    options.parallel_threshold = 1;
+    options.pool = &pool;
+    auto parallel = JsonParser::parse(users.substr(10, users.size() - 11), options);
+    assert(parallel);
+    const auto& parallel_records = static_cast<const JsonArray&>(*parallel.value());
+    assert(parallel_records.size() == 50);
+    for (std::size_t i = 1; i < parallel_records.size(); ++i) {
+        assert(key_at(*parallel_records.at(i), 1).same_record(key_at(*parallel_records.at(0), 1)));
+    }
+    
+    // Concurrent interning into a synchronized table
+    JsonKeyTable concurrent(true);
+    std::vector<std::thread> threads;
+    std::vector<JsonKey> results(8);
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 1000; ++i) {
+                concurrent.intern("k" + std::to_string(i));
+            }
+            results[t] = concurrent.intern("k7");
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(concurrent.size() == 1000);
+    for (const auto& key : results) {
+        assert(key.same_record(results[0]));
+    }
+    
+    // The push parser interns across the values of a stream
+    JsonStreamParser stream;
+    assert(stream.feed("{\"seq\": 1}\n{\"seq\": 2}\n"));
+    auto one = stream.take_value();
+    auto two = stream.take_value();
+    assert(key_at(*one, 0).same_record(key_at(*two, 0)));
+    
+    // Objects accept interned keys directly
+    auto object = JsonObject::create();
+    object->set(table.intern("shared"), JsonNull::create());
+    assert(object->has("shared"));
+    assert(key_at(*object, 0).same_record(table.intern("shared")));
+    auto cloned = object->clone();
+    assert(key_at(*cloned, 0).same_record(key_at(*object, 0)));
+    
+    std::cout << "test_key_interning passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_lazy.hpp"
+#include "json_parser.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_lazy_document..." << std::endl;
+    
+    std::string input =
+        "{ \"route\": \"/users\", \"method\" : \"GET\",\n"
+        "  \"headers\": {\"x-id\": 42, \"x\\\"q\": true, \"empty\": {}},\n"
+        "  \"body\": [1, 2.5, \"three\", [4, [5]], null, {\"six\": 6}],\n"
+        "  \"broken\": [1, 2 3] }";
+    
+    JsonLazyDocument doc;
+    auto loaded = doc.load(input);
+    assert(loaded);
+    JsonLazyValue root = loaded.value();
+    assert(root.is_object());
+    
+    // Navigation
+    assert(root.get("route").value().get_string().value() == "/users");
+    assert(root.get("method").value().get_string().value() == "GET");
+    assert(root.get("missing").error() == make_error_code(JsonErrorCode::KeyNotFound));
+    
+    JsonLazyValue headers = root.get("headers").value();
+    assert(headers.get("x-id").value().get_integer().value() == 42);
+    assert(headers.get("x\"q").value().get_boolean().value());
+    assert(headers.get("empty").value().size().value() == 0);
+    assert(headers.size().value() == 3);
+    
+    JsonLazyValue body = root.get("body").value();
+    assert(body.is_array());
+    assert(body.size().value() == 6);
+    assert(body.at(0).value().get_integer().value() == 1);
+    assert(body.at(1).value().get_number().value() == 2.5);
+    assert(body.at(1).value().get_integer().error() == make_error_code(JsonErrorCode::InvalidType));
+    assert(body.at(2).value().get_string().value() == "three");
+    assert(body.at(3).value().at(1).value().at(0).value().get_integer().value() == 5);
+    assert(body.at(4).value().is_null());
+    assert(body.at(5).value().get("six").value().get_integer().value() == 6);
+    assert(body.at(6).error() == make_error_code(JsonErrorCode::IndexOutOfBounds));
+    assert(body.get("x").error() == make_error_code(JsonErrorCode::InvalidType));
+    
+    // Raw text and materialization
+    assert(body.at(3).value().raw() == "[4, [5]]");
+    assert(body.at(1).value().raw() == "2.5");
+    auto subtree = body.at(3).value().materialize();
+    assert(subtree);
+    assert(subtree.value()->is_array());
+    assert(subtree.value()->equals(*JsonParser::parse("[4, [5]]").value()));
+    assert(body.at(3).value().materialize().value() == subtree.value());
+    
+    // Errors in values that are never read go unnoticed; reading reports them
+    JsonLazyValue broken = root.get("broken").value();
+    assert(broken.at(0).value().get_integer().value() == 1);
+    assert(broken.size().error() == make_error_code(JsonErrorCode::SyntaxError));
+    assert(!root.materialize());
+    
+    // Load-time validation
+    assert(!doc.load("[1, 2"));
+    assert(!doc.load("[1, 2}"));
+    assert(!doc.load("{\"a\": \"unterminated}"));
+    assert(!doc.load("[1] [2]"));
+    assert(!doc.load(""));
+    assert(doc.load(std::string("\xC3\x28")).error() == make_error_code(JsonErrorCode::InvalidUTF8));
+    
+    // Scalar roots
+    auto scalar = doc.load("  -17  ");
+    assert(scalar);
+    assert(scalar.value().raw() == "-17");
+    assert(scalar.value().get_integer().value() == -17);
+    
+    std::cout << "test_lazy_document passed!" << std::endl;
+    return 0;
+}
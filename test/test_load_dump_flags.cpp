@@ -0,0 +1,95 @@
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static std::string dump(const json_t* json, size_t flags) {
+    char* text = json_dumps(json, flags);
+    assert(text);
+    std::string result(text);
+    json_dumps_free(text);
+    return result;
+}
+
+struct Chunks {
+    const char* text;
+    size_t offset;
+};
+
+// Hands out the input three bytes at a time
+static size_t read_chunks(void* buffer, size_t buflen, void* data) {
+    auto* chunks = static_cast<Chunks*>(data);
+    size_t left = std::char_traits<char>::length(chunks->text + chunks->offset);
+    size_t length = std::min<size_t>({buflen, left, 3});
+    std::memcpy(buffer, chunks->text + chunks->offset, length);
+    chunks->offset += length;
+    return length;
+}
+
+int main() {
+    std::cout << "Running test_load_dump_flags..." << std::endl;
+
+    json_error_code error = JSON_ERROR_SUCCESS;
+    json_t* json = json_loads("{\"b\": [1, 2.5], \"a\": {\"y\": null, \"x\": \"s\"}}", 0, &error);
+    assert(json && error == JSON_ERROR_SUCCESS);
+
+    // Output layout
+    assert(dump(json, 0) == "{\"b\": [1, 2.5], \"a\": {\"y\": null, \"x\": \"s\"}}");
+    assert(dump(json, JSON_COMPACT) == "{\"b\":[1,2.5],\"a\":{\"y\":null,\"x\":\"s\"}}");
+    assert(dump(json, JSON_SORT_KEYS) == "{\"a\": {\"x\": \"s\", \"y\": null}, \"b\": [1, 2.5]}");
+    assert(dump(json, JSON_SORT_KEYS | JSON_COMPACT | JSON_PRESERVE_ORDER) ==
+           "{\"a\":{\"x\":\"s\",\"y\":null},\"b\":[1,2.5]}");
+    assert(dump(json, JSON_INDENT(2) | JSON_COMPACT) ==
+           "{\n  \"b\":[\n    1,\n    2.5\n  ],\n  \"a\":{\n    \"y\":null,\n    \"x\":\"s\"\n  }\n}");
+
+    JsonSerializeOptions options;
+    options.pretty_print = true;
+    options.indent = 4;
+    assert(dump(json, JSON_INDENT(4)) == JsonSerializer::serialize(*JsonParser::parse(dump(json, 0)).value(), options));
+
+    json_t* real = json_real(3.14159265);
+    assert(dump(real, JSON_REAL_PRECISION(3)) == "3.14");
+    assert(dump(real, JSON_ENCODE_ANY) == "3.14159265");
+    json_decref(real);
+
+    char buffer[16];
+    assert(json_dumpb(json, buffer, sizeof(buffer), JSON_COMPACT) == 36);
+
+    // Top-level scalars are always accepted
+    json_t* scalar = json_loads(" 42 ", JSON_DECODE_ANY, &error);
+    assert(scalar && json_integer_value(scalar) == 42);
+    json_decref(scalar);
+
+    // Back-to-back values
+    assert(!json_loads("[1] [2]", 0, &error));
+    json_t* first = json_loads("[1] [2] garbage", JSON_DISABLE_EOF_CHECK, &error);
+    assert(first && json_array_size(first) == 1 && json_integer_value(json_array_get(first, 0)) == 1);
+    json_decref(first);
+
+    Chunks chunks{"{\"k\": [true]} {\"next\"", 0};
+    json_t* streamed = json_load_callback(read_chunks, &chunks, JSON_DISABLE_EOF_CHECK, &error);
+    assert(streamed && json_object_size(streamed) == 1);
+    assert(chunks.offset < std::char_traits<char>::length(chunks.text));
+    json_decref(streamed);
+
+    chunks = Chunks{"{\"k\": [true]} {\"next\"", 0};
+    assert(!json_load_callback(read_chunks, &chunks, 0, &error));
+    assert(error == JSON_ERROR_PARSE_ERROR);
+
+    chunks = Chunks{"17", 0};
+    json_t* number = json_load_callback(read_chunks, &chunks, JSON_DISABLE_EOF_CHECK | JSON_DECODE_ANY, &error);
+    assert(number && json_integer_value(number) == 17);
+    json_decref(number);
+
+    json_decref(json);
+
+    std::cout << "test_load_dump_flags passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "json_c_api.hpp"
+#include "json_parser.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_loadb..." << std::endl;
+
+    // Only buflen bytes are read; the buffer is not NUL-terminated
+    const char packet[] = {'{', '"', 'a', '"', ':', '1', '}', 'X', 'Y'};
+    json_error_code error = JSON_ERROR_UNKNOWN_ERROR;
+    json_t* json = json_loadb(packet, 7, 0, &error);
+    assert(json && error == JSON_ERROR_SUCCESS);
+    assert(json_integer_value(json_object_get(json, "a")) == 1);
+    json_decref(json);
+    assert(!json_loadb(packet, sizeof(packet), 0, &error));
+    assert(error == JSON_ERROR_PARSE_ERROR);
+    json = json_loadb(packet, sizeof(packet), JSON_DISABLE_EOF_CHECK, &error);
+    assert(json && json_object_size(json) == 1);
+    json_decref(json);
+    assert(!json_loadb(nullptr, 3, 0, &error));
+    assert(error == JSON_ERROR_INVALID_ARGUMENT);
+
+    // Pipelined values parsed in place
+    std::string stream = "{\"id\": 1}\n[2, 3] \"four\"\t5 ";
+    std::vector<std::string> values;
+    size_t offset = 0;
+    while (offset < stream.size()) {
+        size_t consumed = 0;
+        json_t* value = json_loadb_next(stream.data() + offset, stream.size() - offset, &consumed, 0, &error);
+        assert(value && consumed > 0);
+        char* text = json_dumps(value, JSON_COMPACT);
+        values.push_back(text);
+        json_dumps_free(text);
+        json_decref(value);
+        offset += consumed;
+    }
+    assert(offset == stream.size());
+    assert((values == std::vector<std::string>{"{\"id\":1}", "[2,3]", "\"four\"", "5"}));
+
+    // The C++ form reports the same offsets
+    std::string_view rest = stream;
+    size_t consumed = 0;
+    auto first = JsonParser::parse_first(rest, consumed);
+    assert(first && first.value()->is_object() && consumed == 10);
+    rest.remove_prefix(consumed);
+    auto second = JsonParser::parse_first(rest, consumed);
+    assert(second && second.value()->is_array() && consumed == 7);
+
+    // Bytes after the value are not examined, even if they are not UTF-8
+    std::string partial = "[1] \xe2\x82";
+    assert(JsonParser::parse_first(partial, consumed) && consumed == 4);
+    assert(!JsonParser::parse(partial));
+    std::string bad = "[\"\xff\"] 1";
+    assert(JsonParser::parse_first(bad, consumed).error() == make_error_code(JsonErrorCode::InvalidUTF8));
+    size_t count = 0;
+    assert(!json_loadb_next(bad.data(), bad.size(), &count, 0, &error));
+    assert(error == JSON_ERROR_INVALID_UTF8);
+
+    // An incomplete value is an error
+    assert(!JsonParser::parse_first("{\"a\": ", consumed));
+    assert(!json_loadb_next("  ", 2, &count, 0, &error));
+
+    std::cout << "test_loadb passed!" << std::endl;
+    return 0;
+}
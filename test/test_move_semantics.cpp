@@ -0,0 +1,125 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static std::uint32_t count_of(const json_t* json) {
+    return reinterpret_cast<const JsonValue*>(json)->reference_count();
+}
+
+int main() {
+    std::cout << "Running test_move_semantics..." << std::endl;
+    
+    // Emplacing builds the node in place and returns it
+    auto object = JsonObject::create();
+    std::string text(100, 'x');
+    const char* bytes = text.data();
+    auto& name = object->emplace<JsonStringValue>("name", std::move(text));
+    assert(name.view().data() == bytes);
+    assert(object->get("name").get() == &name);
+    auto& list = object->emplace<JsonArray>(std::string("list"));
+    list.emplace_back<JsonNumber>(1);
+    list.emplace_back<JsonBoolean>(true);
+    assert(JsonSerializer::serialize(*object) ==
+           "{\"name\": \"" + std::string(100, 'x') + "\", \"list\": [1, true]}");
+    
+    // take() moves the reference out
+    auto taken = list.take(0);
+    assert(taken->integer_value() == 1);
+    assert(taken.use_count() == 1);
+    assert(list.size() == 1);
+    auto member = object->take("list");
+    assert(member.get() == &list);
+    assert(!object->has("list"));
+    assert(!object->take("missing"));
+    
+    // Move-aware clone reuses nodes only the source can reach
+    auto parsed = JsonParser::parse("{\"a\": [1, 2], \"b\": {\"c\": \"d\"}}");
+    assert(parsed);
+    JsonRef<JsonValue> source = std::move(parsed.value());
+    const JsonValue* root = source.get();
+    auto reused = JsonValue::clone(std::move(source));
+    assert(!source);
+    assert(reused.get() == root);
+    
+    // ... and copies those shared with someone else
+    JsonRef<JsonValue> inner = reused->object_value().at("b");
+    auto copy = JsonValue::clone(std::move(reused));
+    assert(copy.get() == root);
+    assert(copy->object_value().at("b").get() != inner.get());
+    assert(copy->object_value().at("b")->equals(*inner));
+    JsonRef<JsonValue> kept = copy;
+    auto deep = JsonValue::clone(std::move(copy));
+    assert(deep.get() != kept.get());
+    assert(deep->equals(*kept));
+    
+    // Borrowed strings are copied, so the result outlives the input
+    {
+        std::string input = "{\"key\": [\"borrowed text\"]}";
+        JsonParseOptions options;
+        options.borrow_strings = true;
+        auto borrowed = JsonParser::parse(input, options);
+        assert(borrowed);
+        auto owned = JsonValue::clone(std::move(borrowed.value()));
+        input.assign(input.size(), '#');
+        input.clear();
+        input.shrink_to_fit();
+        auto text = static_pointer_cast<JsonStringValue>(owned->object_value().at("key")->array_value().at(0));
+        assert(!text->is_borrowed());
+        assert(JsonSerializer::serialize(*owned) == "{\"key\": [\"borrowed text\"]}");
+    }
+    
+    // Arena nodes are copied out of the arena
+    {
+        JsonArena arena;
+        JsonParseOptions options;
+        options.arena = &arena;
+        auto in_arena = JsonParser::parse("[1, {\"a\": \"b\"}]", options);
+        assert(in_arena);
+        const JsonValue* arena_root = in_arena.value().get();
+        auto heap = JsonValue::clone(std::move(in_arena.value()));
+        assert(heap.get() != arena_root);
+        arena.release();
+        assert(JsonSerializer::serialize(*heap) == "[1, {\"a\": \"b\"}]");
+    }
+    
+    // C API reference stealing
+    json_t* array = json_array();
+    json_t* number = json_integer(5);
+    assert(json_array_append_new(array, number) == 0);
+    assert(count_of(number) == 1);
+    assert(json_array_insert_new(array, json_string("first"), 0) == 0);
+    assert(std::string(json_string_value(json_array_get(array, 0))) == "first");
+    
+    json_t* obj = json_object();
+    assert(json_object_set_new(obj, "array", array) == 0);
+    assert(json_object_setn_new(obj, "flagged", 4, json_boolean(1)) == 0);
+    assert(json_boolean_value(json_object_get(obj, "flag")));
+    assert(json_array_size(json_object_get(obj, "array")) == 2);
+    
+    // A stolen reference is released even when the call fails
+    assert(json_array_append_new(obj, json_integer(1)) != 0);
+    assert(json_object_set_new(array, "key", json_integer(2)) != 0);
+    
+    // A container cannot be added to itself; the reference is still released
+    assert(json_array_append(array, array) == JSON_ERROR_INVALID_ARGUMENT);
+    assert(json_array_insert(array, array, 0) == JSON_ERROR_INVALID_ARGUMENT);
+    assert(json_object_set(obj, "self", obj) == JSON_ERROR_INVALID_ARGUMENT);
+    assert(count_of(array) == 1 && count_of(obj) == 1);
+    assert(json_array_size(array) == 2 && !json_object_get(obj, "self"));
+    json_t* owner = json_object();
+    json_incref(owner);
+    assert(json_object_set_new(owner, "self", owner) == JSON_ERROR_INVALID_ARGUMENT);
+    assert(count_of(owner) == 1);
+    json_decref(owner);
+    
+    json_decref(obj);
+    
+    std::cout << "test_move_semantics passed!" << std::endl;
+    return 0;
+}
@@ -43,6 +43,17 @@ int main() {
     value = json_object_get(obj, "age");
     assert(value == nullptr);
     
+    // Length-delimited keys (need not be NUL-terminated)
+    json_t* flag = json_boolean(1);
+    assert(json_object_setn(obj, "flagged-out", 4, flag) == 0);
+    json_delete(flag);
+    value = json_object_getn(obj, "flagXYZ", 4);
+    assert(value != nullptr);
+    assert(json_boolean_value(value));
+    assert(json_object_get(obj, "flag") != nullptr);
+    assert(json_object_deln(obj, "flag!", 4) == 0);
+    assert(json_object_getn(obj, "flag", 4) == nullptr);
+    
     // Test clearing object
     json_object_clear(obj);
     assert(json_object_size(obj) == 0);
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include "json_hash.hpp"
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_object_order..." << std::endl;
+    
+    // Iteration follows insertion order; reassignment keeps the position
+    auto object = JsonObject::create();
+    object->set("zeta", JsonNumber::create(1));
+    object->set("alpha", JsonNumber::create(2));
+    object->set("mid", JsonNumber::create(3));
+    object->set("alpha", JsonNumber::create(4));
+    assert(JsonSerializer::serialize(*object) == "{\"zeta\": 1, \"alpha\": 4, \"mid\": 3}");
+    
+    // Parsing preserves the document's member order
+    std::string text = "{\"b\": 1, \"a\": 2, \"d\": [3], \"c\": null}";
+    auto parsed = JsonParser::parse(text);
+    assert(parsed);
+    assert(JsonSerializer::serialize(*parsed.value()) == text);
+    
+    // Erasing keeps the order of the remaining members
+    object->erase("alpha");
+    assert(JsonSerializer::serialize(*object) == "{\"zeta\": 1, \"mid\": 3}");
+    object->erase("missing");
+    assert(object->size() == 2);
+    
+    // Large tables switch to the hashed index and stay consistent through
+    // inserts and erases
+    JsonHash<std::string, int> table;
+    const int count = 2000;
+    for (int i = 0; i < count; ++i) {
+        auto result = table.insert({"key" + std::to_string(i), i});
+        assert(result.second);
+    }
+    assert(!table.insert({"key7", 0}).second);
+    assert(table.size() == count);
+    for (int i = 0; i < count; ++i) {
+        assert(table.at("key" + std::to_string(i)) == i);
+    }
+    for (int i = 0; i < count; i += 3) {
+        assert(table.erase("key" + std::to_string(i)) == 1);
+    }
+    assert(table.erase("key0") == 0);
+    int expected = 0;
+    for (const auto& [key, value] : table) {
+        if (expected % 3 == 0) {
+            expected++;
+        }
+        assert(value == expected);
+        assert(key == "key" + std::to_string(expected));
+        expected++;
+    }
+    for (int i = 0; i < count; ++i) {
+        bool present = i % 3 != 0;
+        assert(table.contains("key" + std::to_string(i)) == present);
+    }
+    table["key0"] = -1;
+    assert(table.find("key0") == table.end() - 1);
+    
+    // Erase through iterators
+    auto it = table.begin();
+    while (it != table.end()) {
+        it = it->second % 2 == 0 ? table.erase(it) : it + 1;
+    }
+    for (const auto& entry : table) {
+        assert(entry.second % 2 != 0);
+        assert(table.find(entry.first)->second == entry.second);
+    }
+    
+    table.clear();
+    assert(table.empty());
+    assert(table.find("key1") == table.end());
+    table.reserve(100);
+    table.emplace("again", 5);
+    assert(table.at("again") == 5);
+    
+    bool thrown = false;
+    try {
+        table.at("absent");
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+    
+    // Heterogeneous lookup: string_view and C string keys
+    JsonHash<std::string, int> keyed;
+    for (int i = 0; i < 20; ++i) {
+        keyed["k" + std::to_string(i)] = i;
+    }
+    std::string_view view = "k13 trailing";
+    assert(keyed.find(view.substr(0, 3))->second == 13);
+    assert(keyed.contains("k19"));
+    assert(!keyed.contains(std::string_view("k1", 1)));
+    keyed[std::string_view("new")] = 99;
+    assert(keyed.at("new") == 99);
+    assert(keyed.erase(std::string_view("new")) == 1);
+    assert(JsonStringHash<std::string>{}(std::string("abc")) == JsonStringHash<std::string>{}(std::string_view("abc")));
+    
+    auto members = JsonObject::create();
+    std::string owned = "owned";
+    members->set(owned, JsonNumber::create(1));
+    members->set(std::string_view("viewed!").substr(0, 6), JsonNumber::create(2));
+    members->set("literal", JsonNumber::create(3));
+    members->set(std::string("moved"), JsonNumber::create(4));
+    assert(members->get(std::string_view("viewed")));
+    assert(members->get("literal")->integer_value() == 3);
+    assert(members->has(owned));
+    members->erase(std::string_view("moved"));
+    assert(!members->has("moved"));
+    assert(members->size() == 3);
+    
+    std::cout << "test_object_order passed!" << std::endl;
+    return 0;
+}
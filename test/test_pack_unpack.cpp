@@ -0,0 +1,140 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include "json_pack.hpp"
+#include "json_c_api.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static std::string dump(const json_t* json) {
+    char* text = json_dumps(json, 0);
+    std::string result(text);
+    json_dumps_free(text);
+    return result;
+}
+
+int main() {
+    std::cout << "Running test_pack_unpack..." << std::endl;
+
+    // C API packing
+    json_t* packed = json_pack("{s:i, s:[s, b, n], s:f, s:I}", "id", 7, "tags", "x", 1, "ratio", 0.5,
+                               "big", static_cast<json_int_t>(1) << 40);
+    assert(packed);
+    assert(dump(packed) == "{\"id\": 7, \"tags\": [\"x\", true, null], \"ratio\": 0.5, \"big\": 1099511627776}");
+
+    // Lengths, concatenation and optional values
+    json_t* inner = json_integer(3);
+    json_t* strings = json_pack("[s#, s%, s+#, s?, s*, o, O?, o*]", "abcdef", 2, "xyz", static_cast<size_t>(1),
+                                "foo", "barbaz", 3, nullptr, nullptr, inner, nullptr, nullptr);
+    assert(strings);
+    assert(dump(strings) == "[\"ab\", \"x\", \"foobar\", null, 3, null]");
+    json_decref(strings);
+
+    json_t* partial = json_pack("{s:s*, s:o?}", "skipped", nullptr, "kept", nullptr);
+    assert(dump(partial) == "{\"kept\": null}");
+    json_decref(partial);
+
+    // Pack errors
+    json_error_code error = JSON_ERROR_SUCCESS;
+    assert(!json_pack_ex(&error, 0, "{s:i", "a", 1));
+    assert(error == JSON_ERROR_INVALID_ARGUMENT);
+    assert(!json_pack_ex(&error, 0, "[s]", nullptr));
+    assert(error == JSON_ERROR_INVALID_ARGUMENT);
+    assert(!json_pack_ex(&error, 0, "[s]", "\xff"));
+    assert(error == JSON_ERROR_INVALID_UTF8);
+    assert(!json_pack_ex(&error, 0, "i x", 1));
+    assert(error == JSON_ERROR_INVALID_ARGUMENT);
+    assert(!json_pack_ex(&error, 0, ""));
+
+    // C API unpacking
+    int id = 0;
+    const char* tag = nullptr;
+    int flag = 0;
+    double ratio = 0;
+    json_int_t big = 0;
+    assert(json_unpack(packed, "{s:i, s:[s, b, n], s:F, s:I}", "id", &id, "tags", &tag, &flag, "ratio", &ratio,
+                       "big", &big) == 0);
+    assert(id == 7 && std::strcmp(tag, "x") == 0 && flag == 1 && ratio == 0.5 && big == (1LL << 40));
+
+    json_t* tags = nullptr;
+    size_t length = 0;
+    assert(json_unpack(packed, "{s:O, s:[s%]}", "tags", &tags, "tags", &tag, &length) == 0);
+    assert(json_array_size(tags) == 3 && length == 1);
+    json_decref(tags);
+
+    int missing = -1;
+    assert(json_unpack(packed, "{s?i, s?{s:i}}", "absent", &missing, "gone", "x", &missing) == 0);
+    assert(missing == -1);
+
+    assert(json_unpack_ex(packed, &error, 0, "{s:s}", "id", &tag) == -1);
+    assert(error == JSON_ERROR_INVALID_TYPE);
+    assert(json_unpack_ex(packed, &error, 0, "{s:i}", "absent", &id) == -1);
+    assert(error == JSON_ERROR_KEY_NOT_FOUND);
+    assert(json_unpack_ex(packed, &error, 0, "{s:[s, b, n, n]}", "tags", &tag, &flag) == -1);
+    assert(error == JSON_ERROR_INDEX_OUT_OF_BOUNDS);
+    assert(json_unpack_ex(packed, &error, 0, "{s:i !}", "id", &id) == -1);
+    assert(error == JSON_ERROR_INVALID_TYPE);
+    assert(json_unpack_ex(packed, &error, JSON_STRICT, "{s:i}", "id", &id) == -1);
+    assert(json_unpack_ex(packed, &error, JSON_STRICT, "{s:i *}", "id", &id) == 0);
+    assert(json_unpack_ex(packed, &error, JSON_STRICT, "{s:i, s:i, s:[s, b, n], s:f, s:I}", "id", &id, "id",
+                          &id, "tags", &tag, &flag, "ratio", &ratio, "big", &big) == 0);
+    assert(json_unpack_ex(packed, &error, JSON_VALIDATE_ONLY, "{s:i, s:[s, b, n]}", "id", "tags") == 0);
+    assert(json_unpack_ex(packed, &error, JSON_VALIDATE_ONLY, "{s:[s, s]}", "tags") == -1);
+    assert(json_unpack_ex(packed, &error, 0, "{s:i} x", "id", &id) == -1);
+    assert(error == JSON_ERROR_INVALID_ARGUMENT);
+    json_decref(packed);
+
+    // Compile-time formats
+    std::string name = "widget";
+    auto item = JsonNumber::create(std::int64_t(4));
+    JsonRef<JsonValue> message = pack(JSON_FORMAT("{s:i, s:s, s:[s#, b, f], s:o, s:s*, s:O?}"), "id", 9,
+                                      "name", name, "parts", "abc", 2, false, 2.5, "count", item,
+                                      "skipped", static_cast<const char*>(nullptr), "empty", JsonRef<JsonValue>());
+    assert(JsonSerializer::serialize(*message) ==
+           "{\"id\": 9, \"name\": \"widget\", \"parts\": [\"ab\", false, 2.5], \"count\": 4, \"empty\": null}");
+    assert(item.get() && item->reference_count() == 2);
+
+    bool threw = false;
+    try {
+        pack(JSON_FORMAT("[s]"), static_cast<const char*>(nullptr));
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+
+    int message_id = 0;
+    std::string message_name;
+    std::string_view part;
+    std::size_t part_length = 0;
+    bool enabled = true;
+    double weight = 0;
+    const JsonValue* count = nullptr;
+    JsonRef<JsonValue> parts;
+    std::int64_t absent = -1;
+    unpack(*message, JSON_FORMAT("{s:i, s:s, s:[s%, b, F!], s:o, s:O, s?I}"), "id", &message_id, "name",
+           &message_name, "parts", &part, &part_length, &enabled, &weight, "count", &count, "parts", &parts,
+           "absent", &absent);
+    assert(message_id == 9 && message_name == "widget" && part == "ab" && part_length == 2);
+    assert(!enabled && weight == 2.5 && count == item.get() && parts->is_array() && absent == -1);
+
+    std::string left;
+    try {
+        unpack(*message, JSON_FORMAT("{s:i, s:s !}"), "id", &message_id, "name", &message_name);
+    } catch (const JsonException& e) {
+        left = e.what();
+    }
+    assert(left == "3 object item(s) left unpacked: parts");
+
+    std::string mismatch;
+    try {
+        unpack(*message, JSON_FORMAT("{s:s}"), "id", &message_name);
+    } catch (const JsonException& e) {
+        mismatch = e.what();
+    }
+    assert(mismatch == "Expected string, got integer");
+
+    std::cout << "test_pack_unpack passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_thread_pool.hpp"
+
+using namespace jansson;
+
+static std::size_t array_size(const Result<JsonRef<JsonValue>>& result) {
+    assert(result);
+    assert(result.value()->is_array());
+    return static_cast<const JsonArray&>(*result.value()).size();
+}
+
+int main() {
+    std::cout << "Running test_parallel_parse..." << std::endl;
+    
+    // Mixed elements, including nested containers and strings holding
+    // brackets and commas
+    std::string input = " [";
+    for (int i = 0; i < 20000; ++i) {
+        if (i > 0) {
+            input += i % 3 == 0 ? ",\n " : ",";
+        }
+        switch (i % 5) {
+            case 0: input += std::to_string(i); break;
+            case 1: input += "\"s,[" + std::to_string(i) + "]\\\"\""; break;
+            case 2: input += "{\"id\": " + std::to_string(i) + ", \"v\": [1, {\"x\": null}]}"; break;
+            case 3: input += "[true, false, [], {}]"; break;
+            case 4: input += "-1.5e3"; break;
+        }
+    }
+    input += "] \n";
+    
+    JsonThreadPool pool(4);
+    JsonParseOptions options;
+    options.parallel_threshold = 1;
+    options.pool = &pool;
+    
+    auto sequential = JsonParser::parse(input);
+    assert(sequential);
+    auto parallel = JsonParser::parse(input, options);
+    assert(parallel);
+    assert(parallel.value()->is_array());
+    assert(static_cast<const JsonArray&>(*parallel.value()).size() == 20000);
+    assert(parallel.value()->equals(*sequential.value()));
+    assert(JsonSerializer::serialize(*parallel.value()) == JsonSerializer::serialize(*sequential.value()));
+    
+    // Shared pool and borrowed strings
+    options.pool = nullptr;
+    options.borrow_strings = true;
+    parallel = JsonParser::parse(input, options);
+    assert(parallel);
+    assert(parallel.value()->equals(*sequential.value()));
+    options.borrow_strings = false;
+    options.pool = &pool;
+    
+    // Small inputs and non-arrays take the sequential path
+    options.parallel_threshold = 1000;
+    assert(array_size(JsonParser::parse("[1, 2]", options)) == 2);
+    options.parallel_threshold = 1;
+    assert(array_size(JsonParser::parse("[]", options)) == 0);
+    assert(array_size(JsonParser::parse("[ 7 ]", options)) == 1);
+    assert(JsonParser::parse("{\"a\": [1, 2]}", options).value()->is_object());
+    assert(JsonParser::parse("\"text\"", options).value()->is_string());
+    
+    // Errors inside or between elements are still reported
+    assert(!JsonParser::parse("[1, 2,]", options));
+    assert(!JsonParser::parse("[, 1]", options));
+    assert(!JsonParser::parse("[1 2, 3]", options));
+    assert(!JsonParser::parse("[1, {\"a\" 1}, 3]", options));
+    assert(!JsonParser::parse("[1, 2] 3", options));
+    assert(!JsonParser::parse("[1, 2", options));
+    assert(!JsonParser::parse("[1, \"unterminated]", options));
+    assert(!JsonParser::parse("[1, }, 2]", options));
+    
+    std::cout << "test_parallel_parse passed!" << std::endl;
+    return 0;
+}
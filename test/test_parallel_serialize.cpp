@@ -0,0 +1,78 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <string>
+#include "json_value.hpp"
+#include "json_serializer.hpp"
+#include "json_thread_pool.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_parallel_serialize..." << std::endl;
+    
+    auto array = JsonArray::create();
+    for (int i = 0; i < 5000; ++i) {
+        auto record = JsonObject::create();
+        record->set("id", JsonNumber::create(static_cast<std::int64_t>(i)));
+        record->set("name", JsonStringValue::create("item " + std::to_string(i)));
+        auto tags = JsonArray::create();
+        tags->push_back(JsonBoolean::create(i % 2 == 0));
+        tags->push_back(JsonNull::create());
+        record->set("tags", tags);
+        array->push_back(record);
+    }
+    
+    JsonThreadPool pool(4);
+    
+    // Compact and pretty output match the sequential serializer
+    for (bool pretty : {false, true}) {
+        JsonSerializeOptions sequential;
+        sequential.pretty_print = pretty;
+        std::string expected = JsonSerializer::serialize(*array, sequential);
+        
+        JsonSerializeOptions parallel = sequential;
+        parallel.parallel_threshold = 100;
+        parallel.pool = &pool;
+        assert(JsonSerializer::serialize(*array, parallel) == expected);
+        
+        // Streaming writers receive the same bytes
+        std::ostringstream os;
+        JsonSerializer::serialize(os, *array, parallel);
+        assert(os.str() == expected);
+        
+        // The shared pool is used by default
+        parallel.pool = nullptr;
+        assert(JsonSerializer::serialize(*array, parallel) == expected);
+    }
+    
+    // Large objects, nested below a small container
+    auto object = JsonObject::create();
+    for (int i = 0; i < 3000; ++i) {
+        object->set("key" + std::to_string(i), JsonNumber::create(i * 0.5));
+    }
+    auto wrapper = JsonArray::create();
+    wrapper->push_back(object);
+    for (bool pretty : {false, true}) {
+        JsonSerializeOptions sequential;
+        sequential.pretty_print = pretty;
+        JsonSerializeOptions parallel = sequential;
+        parallel.parallel_threshold = 1000;
+        parallel.pool = &pool;
+        assert(JsonSerializer::serialize(*wrapper, parallel) == JsonSerializer::serialize(*wrapper, sequential));
+    }
+    
+    // Fewer elements than threads, and empty containers
+    auto small = JsonArray::create();
+    small->push_back(JsonNumber::create(1));
+    small->push_back(JsonNumber::create(2));
+    JsonSerializeOptions parallel;
+    parallel.parallel_threshold = 1;
+    parallel.pool = &pool;
+    assert(JsonSerializer::serialize(*small, parallel) == "[1, 2]");
+    assert(JsonSerializer::serialize(*JsonArray::create(), parallel) == "[]");
+    assert(JsonSerializer::serialize(*JsonObject::create(), parallel) == "{}");
+    
+    std::cout << "test_parallel_serialize passed!" << std::endl;
+    return 0;
+}
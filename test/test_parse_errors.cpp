@@ -0,0 +1,104 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_parser.hpp"
+#include "json_projection.hpp"
+
+using namespace jansson;
+
+static JsonParseError failure(std::string_view input, const JsonParseOptions& options = JsonParseOptions()) {
+    JsonParseError error;
+    auto result = JsonParser::parse(input, options, error);
+    assert(!result);
+    return error;
+}
+
+struct Counter : JsonHandler {
+    int events = 0;
+    bool on_integer(std::int64_t) override { return ++events, true; }
+    bool on_key(std::string_view) override { return ++events, true; }
+    bool on_start_object() override { return ++events, true; }
+    bool on_start_array() override { return ++events, true; }
+};
+
+int main() {
+    std::cout << "Running test_parse_errors..." << std::endl;
+
+    // Byte offset, line and column of the offending byte
+    JsonParseError error = failure("{\n  \"a\": [1, 2,\n        x]\n}");
+    assert(error.message == "Unexpected character");
+    assert(error.line == 3 && error.column == 9 && error.position == 24);
+
+    error = failure("[1, 2");
+    assert(error.message == "Expected ',' or ']' in array" && error.position == 5);
+    error = failure("{\"a\" 1}");
+    assert(error.message == "Expected ':' but found '1'" && error.line == 1 && error.column == 6);
+    error = failure("[tru]");
+    assert(error.message == "Invalid literal, expected 'true'" && error.position == 1);
+    error = failure("[1.]");
+    assert(error.position == 3);
+    error = failure("\"abc");
+    assert(error.message == "Unterminated string");
+    error = failure("[\"\\u12G4\"]");
+    assert(error.message == "Invalid Unicode escape sequence" && error.position == 2);
+    error = failure("\"\\u-123\"");
+    assert(error.message == "Invalid Unicode escape sequence");
+    error = failure("[1] x");
+    assert(error.message == "Unexpected trailing characters" && error.position == 4);
+    error = failure("\n\n[\"\xff\"]");
+    assert(error.message == "Invalid UTF-8 sequence" && error.line == 3 && error.column == 3);
+    error = failure("");
+    assert(error.message == "Unexpected end of input" && error.line == 1 && error.column == 1);
+
+    // The structural index, projection and parallel paths report the same position
+    std::string input = "[{\"a\": 1}, {\"a\": [2, }]";
+    JsonParseOptions indexed;
+    indexed.use_structural_index = true;
+    assert(failure(input).position == 21 && failure(input, indexed).position == 21);
+
+    JsonProjection projection({JsonPointer::parse("/0/a").value()});
+    JsonParseOptions projected;
+    projected.projection = &projection;
+    error = failure("[{\"a\": 1}, {\"a\": \"open]", projected);
+    assert(error.message == "Unterminated string" && error.position == 17);
+
+    std::string large = "[";
+    for (int i = 0; i < 200; ++i) {
+        large += "{\"v\": 1}, ";
+    }
+    large += "{\"v\": }]";
+    JsonParseOptions parallel;
+    parallel.parallel_threshold = 64;
+    size_t expected = large.size() - 2;
+    assert(failure(large).position == expected && failure(large, parallel).position == expected);
+
+    // The older interface reports the real position too
+    std::string message;
+    size_t position = 0;
+    assert(!JsonParser::parse_with_error("{\"k\": nul}", message, position));
+    assert(message == "Invalid literal, expected 'null'" && position == 6);
+
+    // Event parsing tells a malformed document apart from a stopped handler
+    Counter counter;
+    assert(JsonParser::parse("[1, {\"x\": }]", counter).error() == make_error_code(JsonErrorCode::ParseError));
+    assert(counter.events == 4);
+
+    // C API
+    json_error_t c_error;
+    assert(!json_loads_ex("{\"a\": 1,\n \"b\": }", 0, &c_error));
+    assert(c_error.code == JSON_ERROR_PARSE_ERROR);
+    assert(c_error.line == 2 && c_error.column == 7 && c_error.position == 15);
+    assert(std::strcmp(c_error.text, "Unexpected character") == 0);
+    assert(!json_loadb_ex("\"\xc3\"", 3, 0, &c_error) && c_error.code == JSON_ERROR_INVALID_UTF8);
+    assert(!json_loads_ex(nullptr, 0, &c_error) && c_error.code == JSON_ERROR_INVALID_ARGUMENT);
+
+    json_t* json = json_loadb_ex("[1, 2] tail", 6, 0, &c_error);
+    assert(json && c_error.code == JSON_ERROR_SUCCESS && c_error.text[0] == '\0');
+    assert(json_array_size(json) == 2);
+    json_decref(json);
+
+    std::cout << "test_parse_errors passed!" << std::endl;
+    return 0;
+}
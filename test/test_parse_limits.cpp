@@ -0,0 +1,144 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_parser.hpp"
+#include "json_projection.hpp"
+
+using namespace jansson;
+
+static std::string nested(size_t depth, const std::string& inner = "1") {
+    return std::string(depth, '[') + inner + std::string(depth, ']');
+}
+
+static bool exceeds(std::string_view input, const JsonParseOptions& options) {
+    return JsonParser::parse(input, options).error() == make_error_code(JsonErrorCode::LimitExceeded);
+}
+
+int main() {
+    std::cout << "Running test_parse_limits..." << std::endl;
+
+    JsonParseOptions defaults;
+    assert(defaults.max_depth == 2048 && defaults.max_nodes == 0);
+
+    // Nesting many times deeper than the default limit fails without
+    // exhausting the stack, in both the tree and event parsers
+    std::string hostile = std::string(1000000, '[');
+    assert(exceeds(hostile, defaults));
+    JsonHandler ignore;
+    assert(JsonParser::parse(hostile, ignore).error() == make_error_code(JsonErrorCode::LimitExceeded));
+    assert(JsonParser::parse(nested(2048), defaults));
+    assert(exceeds(nested(2049), defaults));
+
+    // The parser itself keeps no recursion, so the limit can be lifted
+    JsonParseOptions unlimited;
+    unlimited.max_depth = 0;
+    auto deep = JsonParser::parse(nested(20000), unlimited);
+    assert(deep);
+    const JsonValue* node = deep.value().get();
+    for (int i = 0; i < 20000; ++i) {
+        node = static_cast<const JsonArray*>(node)->at(0).get();
+    }
+    assert(node->is_number());
+
+    JsonParseOptions shallow;
+    shallow.max_depth = 3;
+    assert(JsonParser::parse("[{\"a\": [1]}, [], {}]", shallow));
+    assert(exceeds("[{\"a\": [{}]}]", shallow));
+    JsonParseError error;
+    assert(!JsonParser::parse("{\"a\": {\"b\": {\"c\": [2]}}}", shallow, error));
+    assert(error.message == "Maximum nesting depth exceeded" && error.position == 18);
+
+    // Every value counts, containers included
+    JsonParseOptions few;
+    few.max_nodes = 4;
+    assert(JsonParser::parse("[1, 2, 3]", few));
+    assert(JsonParser::parse("{\"a\": [true, null]}", few));
+    assert(exceeds("[1, 2, 3, 4]", few));
+    assert(exceeds("[[], [], [], []]", few));
+
+    JsonParseOptions parallel = few;
+    parallel.parallel_threshold = 16;
+    parallel.max_nodes = 50;
+    std::string many = "[";
+    for (int i = 0; i < 50; ++i) {
+        many += i ? ", 1" : "1";
+    }
+    many += "]";
+    assert(exceeds(many, parallel));
+    parallel.max_nodes = 51;
+    assert(JsonParser::parse(many, parallel));
+
+    // Decoded string and key length
+    JsonParseOptions short_strings;
+    short_strings.max_string_length = 3;
+    assert(JsonParser::parse("[\"abc\", \"\\u00e9\"]", short_strings));
+    assert(exceeds("\"abcd\"", short_strings));
+    assert(exceeds("\"ab\\nc\"", short_strings));
+    assert(exceeds("{\"long\": 1}", short_strings));
+    short_strings.borrow_strings = true;
+    short_strings.use_structural_index = true;
+    assert(exceeds("[\"abcd\"]", short_strings));
+
+    // Input size, or bytes consumed when more may follow
+    JsonParseOptions small_input;
+    small_input.max_input_size = 8;
+    assert(JsonParser::parse("[1, 2]  ", small_input));
+    assert(exceeds("[1, 2, 3]", small_input));
+    size_t consumed = 0;
+    assert(JsonParser::parse_first("[1] [1, 2, 3, 4]", small_input, consumed) && consumed == 4);
+    assert(JsonParser::parse_first("[1, 2, 3, 4] [1]", small_input, consumed).error() ==
+           make_error_code(JsonErrorCode::LimitExceeded));
+    
+    // ... judged on the first max_input_size bytes alone, so a value
+    // running past them is never built, while errors before them still
+    // read as such
+    auto first_error = [&](std::string_view input) {
+        return JsonParser::parse_first(input, small_input, consumed).error();
+    };
+    assert(first_error("\"abcdefghijk\"") == make_error_code(JsonErrorCode::LimitExceeded));
+    assert(first_error("1234567890") == make_error_code(JsonErrorCode::LimitExceeded));
+    assert(first_error("[1, [2, tru") == make_error_code(JsonErrorCode::LimitExceeded));
+    assert(first_error("[1, x] 12345") == make_error_code(JsonErrorCode::ParseError));
+    assert(JsonParser::parse_first("1234567 8", small_input, consumed) && consumed == 8);
+    assert(JsonParser::parse_first("\"abcdef\"9", small_input, consumed) && consumed == 8);
+    std::string flood = "[" + std::string(10000000, '[');
+    assert(first_error(flood) == make_error_code(JsonErrorCode::LimitExceeded));
+
+    // Event parsing takes the same limits
+    auto events_exceed = [&](std::string_view input, const JsonParseOptions& options) {
+        return JsonParser::parse(input, options, ignore).error() == make_error_code(JsonErrorCode::LimitExceeded);
+    };
+    assert(JsonParser::parse("[1, 2, 3]", few, ignore));
+    assert(events_exceed("[1, 2, 3, 4]", few));
+    assert(events_exceed("{\"long\": 1}", short_strings));
+    assert(events_exceed("[1, 2, 3]", small_input));
+    assert(events_exceed("[{\"a\": [{}]}]", shallow));
+    assert(JsonParser::parse(nested(3000), unlimited, ignore));
+
+    // Projected parsing applies the same limits
+    JsonProjection projection({JsonPointer::parse("/0").value()});
+    JsonParseOptions projected = shallow;
+    projected.projection = &projection;
+    assert(JsonParser::parse("[[[1]], [[[[[2]]]]]]", projected));
+    assert(exceeds("[[[[1]]], 2]", projected));
+
+    // C API loads use the default limits
+    json_error_t c_error;
+    assert(!json_loads_ex(nested(3000).c_str(), 0, &c_error));
+    assert(c_error.code == JSON_ERROR_LIMIT_EXCEEDED && c_error.position == 2048);
+    json_t* json = json_loads_ex(nested(100).c_str(), 0, &c_error);
+    assert(json && c_error.code == JSON_ERROR_SUCCESS);
+    json_decref(json);
+    json_error_code code = JSON_ERROR_SUCCESS;
+    assert(!json_loads(nested(3000).c_str(), 0, &code));
+    assert(code == JSON_ERROR_LIMIT_EXCEEDED);
+    code = JSON_ERROR_SUCCESS;
+    assert(!json_loadb("[\"\xff\"]", 5, 0, &code));
+    assert(code == JSON_ERROR_INVALID_UTF8);
+    assert(!json_loads("[1,", 0, &code));
+    assert(code == JSON_ERROR_PARSE_ERROR);
+
+    std::cout << "test_parse_limits passed!" << std::endl;
+    return 0;
+}
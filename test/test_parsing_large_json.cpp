@@ -46,7 +46,7 @@ int main() {
     json_t* user_name = json_object_get(first_user, "name");
     assert(user_name != nullptr);
     std::cout << "First user name: " << json_string_value(user_name) << std::endl;
-    assert(std::string(json_string_value(user_name)) == "User0");
+    assert(std::string(json_string_value(user_name)) == "User 0");
     
     // Verify last user
     json_t* last_user = json_array_get(users, 99);
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_c_api.hpp"
+
+int main() {
+    std::cout << "Running test_parsing_whitespace..." << std::endl;
+    
+    json_error_code error;
+    
+    // Whitespace inside strings must be preserved
+    json_t* json = json_loads("{ \"greeting\" : \"  Hello,\\tbig  World \" }", 0, &error);
+    assert(json != nullptr);
+    json_t* value = json_object_get(json, "greeting");
+    assert(value != nullptr);
+    assert(std::string(json_string_value(value)) == "  Hello,\tbig  World ");
+    json_delete(json);
+    
+    // Keys keep their whitespace as well
+    json = json_loads("{\"first name\": \"John\"}", 0, &error);
+    assert(json != nullptr);
+    assert(json_object_get(json, "first name") != nullptr);
+    assert(json_object_get(json, "firstname") == nullptr);
+    json_delete(json);
+    
+    // Whitespace between tokens is skipped
+    json = json_loads(" \n\t[ 1 ,\r\n 2 , 3 ] \n", 0, &error);
+    assert(json != nullptr);
+    assert(json_array_size(json) == 3);
+    json_delete(json);
+    
+    // Whitespace is not allowed inside numbers or literals
+    assert(json_loads("1 2", 0, &error) == nullptr);
+    assert(json_loads("[- 1]", 0, &error) == nullptr);
+    assert(json_loads("[tr ue]", 0, &error) == nullptr);
+    
+    // Raw control characters and unterminated strings are rejected
+    assert(json_loads("\"line\nbreak\"", 0, &error) == nullptr);
+    assert(json_loads("\"unterminated", 0, &error) == nullptr);
+    
+    std::cout << "test_parsing_whitespace passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_parser.hpp"
+#include "json_projection.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+static JsonPointer pointer(std::string_view text) {
+    return JsonPointer::parse(text).value();
+}
+
+static std::string project(std::string_view input, const JsonProjection& projection, bool indexed = false) {
+    JsonParseOptions options;
+    options.projection = &projection;
+    options.use_structural_index = indexed;
+    auto result = JsonParser::parse(input, options);
+    assert(result);
+    return JsonSerializer::serialize(*result.value());
+}
+
+int main() {
+    std::cout << "Running test_projection..." << std::endl;
+    
+    std::string event = "{\"id\": 17, \"user\": {\"name\": \"ann\", \"address\": {\"city\": \"Oslo\", \"zip\": \"0150\"}},"
+                        " \"payload\": {\"blob\": [1, [2, {\"x\": \"}]\\\"\"}], 3], \"text\": \"a\\\\\\\"b\"},"
+                        " \"items\": [{\"sku\": \"a\", \"qty\": 1}, {\"sku\": \"b\", \"qty\": 2}, {\"sku\": \"c\", \"qty\": 3}],"
+                        " \"flag\": true, \"ratio\": -1.5e3, \"none\": null}";
+    
+    JsonProjection fields({pointer("/id"), pointer("/user/address/city"), pointer("/items/1/sku"), pointer("/ratio")});
+    for (bool indexed : {false, true}) {
+        assert(project(event, fields, indexed) ==
+               "{\"id\": 17, \"user\": {\"address\": {\"city\": \"Oslo\"}}, \"items\": [{\"sku\": \"b\"}], \"ratio\": -1500}");
+    }
+    
+    // Whole subtrees, key whitelists and overlapping paths
+    JsonProjection subtree({pointer("/user"), pointer("/user/name"), pointer("/flag")});
+    assert(project(event, subtree, true) ==
+           "{\"user\": {\"name\": \"ann\", \"address\": {\"city\": \"Oslo\", \"zip\": \"0150\"}}, \"flag\": true}");
+    assert(project(event, JsonProjection::keys({"none", "id", "missing"})) == "{\"id\": 17, \"none\": null}");
+    
+    // Paths that need containers where the input has scalars
+    JsonProjection too_deep({pointer("/id/0"), pointer("/user/nick/first")});
+    assert(project(event, too_deep) == "{\"user\": {}}");
+    
+    // Nothing selected, everything selected, non-container roots
+    assert(project(event, JsonProjection()) == "{}");
+    JsonProjection all({pointer("")});
+    assert(all.selects_all());
+    JsonRef<JsonValue> full = JsonParser::parse(event).value();
+    JsonParseOptions options;
+    options.projection = &all;
+    assert(JsonParser::parse(event, options).value()->equals(*full));
+    assert(project("[5, [6, 7], 8]", JsonProjection({pointer("/1/1"), pointer("/2")})) == "[[7], 8]");
+    assert(project("42", fields) == "42");
+    
+    // Skipped text must still be well formed enough to skip
+    options.projection = &fields;
+    assert(!JsonParser::parse("{\"payload\": [1, 2", options));
+    assert(!JsonParser::parse("{\"payload\": \"open}", options));
+    assert(!JsonParser::parse("{\"payload\": @}", options));
+    assert(!JsonParser::parse("{\"payload\": 1 \"id\": 2}", options));
+    assert(!JsonParser::parse("{\"id\": 1} extra", options));
+    
+    // Keys of the result are interned as usual
+    options.projection = &fields;
+    JsonKeyTable table;
+    options.key_table = &table;
+    assert(JsonParser::parse(event, options));
+    assert(table.size() == 7);
+    
+    std::cout << "test_projection passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include "json_value.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_real_format..." << std::endl;
+    
+    // Shortest representation that round-trips
+    assert(JsonNumber(0.1).to_string() == "0.1");
+    assert(JsonNumber(-2.5).to_string() == "-2.5");
+    assert(JsonNumber(42.0).to_string() == "42");
+    assert(JsonNumber(1e300).to_string() == "1e+300");
+    
+    double third = 1.0 / 3.0;
+    std::string text = JsonNumber(third).to_string();
+    assert(std::strtod(text.c_str(), nullptr) == third);
+    
+    double smallest = 2.2250738585072014e-308;
+    text = JsonNumber(-smallest).to_string();
+    assert(text.size() < JsonNumber::max_formatted_length);
+    assert(std::strtod(text.c_str(), nullptr) == -smallest);
+    
+    // Integers are unaffected by precision
+    char buffer[JsonNumber::max_formatted_length];
+    JsonNumber integer(INT64_C(123456789));
+    assert(std::string(buffer, integer.format(buffer, 3)) == "123456789");
+    
+    // Fixed precision through the serializer
+    auto array = JsonArray::create();
+    array->push_back(JsonNumber::create(third));
+    array->push_back(JsonNumber::create(0.1));
+    
+    JsonSerializeOptions options;
+    options.real_precision = 3;
+    assert(JsonSerializer::serialize(*array, options) == "[0.333, 0.1]");
+    
+    options.real_precision = 17;
+    assert(JsonSerializer::serialize(*array, options) == "[0.33333333333333331, 0.10000000000000001]");
+    
+    assert(JsonSerializer::serialize(*array) == "[" + JsonNumber(third).to_string() + ", 0.1]");
+    
+    std::cout << "test_real_format passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cmath>
+#include "json_c_api.hpp"
+
+static double parse_real(const char* text) {
+    json_error_code error;
+    json_t* json = json_loads(text, 0, &error);
+    assert(json != nullptr);
+    assert(json_is_real(json) == 1);
+    double value = json_real_value(json);
+    json_delete(json);
+    return value;
+}
+
+static bool same_bits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+int main() {
+    std::cout << "Running test_real_parsing..." << std::endl;
+    
+    // Fast path: short mantissas with small exponents
+    assert(parse_real("0.1") == 0.1);
+    assert(parse_real("3.14159") == 3.14159);
+    assert(parse_real("-2.5e3") == -2500.0);
+    assert(parse_real("100e-2") == 1.0);
+    assert(parse_real("1e22") == 1e22);
+    
+    // Slow path: long mantissas and extreme exponents, correctly rounded
+    assert(parse_real("1e23") == 1e23);
+    assert(parse_real("1.7976931348623157e308") == 1.7976931348623157e308);
+    assert(parse_real("2.2250738585072014e-308") == 2.2250738585072014e-308);
+    assert(parse_real("5e-324") == 5e-324);
+    assert(parse_real("0.30000000000000004441") == 0.30000000000000004);
+    assert(parse_real("123456789012345678901234567890") == 123456789012345678901234567890.0);
+    assert(parse_real("9007199254740993.0") == 9007199254740992.0);
+    
+    // Underflow rounds to zero, keeping the sign
+    assert(same_bits(parse_real("1e-400"), 0.0));
+    assert(same_bits(parse_real("-1e-400"), -0.0));
+    assert(same_bits(parse_real("-0.0"), -0.0));
+    
+    // Overflow and malformed numbers are errors
+    json_error_code error;
+    assert(json_loads("1e400", 0, &error) == nullptr);
+    assert(json_loads("-1e400", 0, &error) == nullptr);
+    assert(json_loads("1.", 0, &error) == nullptr);
+    assert(json_loads("1e", 0, &error) == nullptr);
+    assert(json_loads("01", 0, &error) == nullptr);
+    assert(json_loads("+1", 0, &error) == nullptr);
+    
+    std::cout << "test_real_parsing passed!" << std::endl;
+    return 0;
+}
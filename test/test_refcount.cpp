@@ -0,0 +1,93 @@
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_value.hpp"
+
+using namespace jansson;
+
+static_assert(sizeof(JsonRef<JsonValue>) == sizeof(void*), "references are one pointer");
+
+static std::uint32_t count_of(const json_t* json) {
+    return reinterpret_cast<const JsonValue*>(json)->reference_count();
+}
+
+int main() {
+    std::cout << "Running test_refcount..." << std::endl;
+    
+    // New values start with one reference
+    json_t* value = json_string("text");
+    assert(count_of(value) == 1);
+    
+    // json_incref adds a reference and returns its argument
+    assert(json_incref(value) == value);
+    assert(count_of(value) == 2);
+    json_decref(value);
+    assert(count_of(value) == 1);
+    
+    // NULL is accepted
+    assert(json_incref(nullptr) == nullptr);
+    json_decref(nullptr);
+    
+    // Holding a borrowed reference past the container's lifetime
+    json_t* array = json_array();
+    assert(json_array_append(array, value) == 0);
+    json_decref(value);
+    json_t* kept = json_incref(json_array_get(array, 0));
+    json_decref(array);
+    assert(count_of(kept) == 1);
+    assert(std::string(json_string_value(kept)) == "text");
+    json_decref(kept);
+    
+#if defined(__GNUC__) || defined(__clang__)
+    // Scoped references
+    {
+        json_auto_t* scoped = json_object();
+        json_t* number = json_integer(42);
+        assert(json_object_set(scoped, "answer", number) == 0);
+        json_decref(number);
+        assert(json_integer_value(json_object_get(scoped, "answer")) == 42);
+    }
+#endif
+    
+    // JsonRef copies and moves share the node's count
+    auto node = JsonArray::create();
+    assert(node.use_count() == 1);
+    {
+        JsonRef<JsonValue> copy = node;
+        assert(node.use_count() == 2);
+        JsonRef<JsonValue> moved = std::move(copy);
+        assert(!copy);
+        assert(node.use_count() == 2);
+        
+        // A reference can be rebuilt from the bare pointer
+        JsonRef<JsonValue> rebuilt(moved.get());
+        assert(node.use_count() == 3);
+    }
+    assert(node.use_count() == 1);
+    
+    // Casting keeps the count
+    JsonRef<JsonValue> base = node;
+    auto derived = static_pointer_cast<JsonArray>(std::move(base));
+    assert(!base);
+    assert(node.use_count() == 2);
+    assert(derived == node);
+    derived.reset();
+    
+    // std::shared_ptr holders keep one reference between them
+    {
+        std::shared_ptr<JsonValue> shared = node;
+        auto shared_copy = shared;
+        assert(node.use_count() == 2);
+    }
+    assert(node.use_count() == 1);
+    
+    // Copying a node does not copy its count
+    JsonNumber original(5);
+    JsonNumber copied(original);
+    assert(copied.reference_count() == 0);
+    
+    std::cout << "test_refcount passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include "json_parser.hpp"
+
+using namespace jansson;
+
+// Records every event as a short token
+class RecordingHandler : public JsonHandler {
+public:
+    std::vector<std::string> events;
+    
+    bool on_null() override { events.push_back("null"); return true; }
+    bool on_boolean(bool value) override { events.push_back(value ? "true" : "false"); return true; }
+    bool on_integer(std::int64_t value) override { events.push_back("i:" + std::to_string(value)); return true; }
+    bool on_real(double value) override { events.push_back("r:" + std::to_string(value)); return true; }
+    bool on_string(std::string_view value) override { events.push_back("s:" + std::string(value)); return true; }
+    bool on_start_object() override { events.push_back("{"); return true; }
+    bool on_key(std::string_view key) override { events.push_back("k:" + std::string(key)); return true; }
+    bool on_end_object(std::size_t count) override { events.push_back("}" + std::to_string(count)); return true; }
+    bool on_start_array() override { events.push_back("["); return true; }
+    bool on_end_array(std::size_t count) override { events.push_back("]" + std::to_string(count)); return true; }
+};
+
+// Counts strings and stops after a limit
+class CountingHandler : public JsonHandler {
+public:
+    explicit CountingHandler(int limit) : limit_(limit) {}
+    int strings = 0;
+    
+    bool on_string(std::string_view) override { return ++strings < limit_; }
+
+private:
+    int limit_;
+};
+
+int main() {
+    std::cout << "Running test_sax..." << std::endl;
+    
+    RecordingHandler recorder;
+    auto result = JsonParser::parse(
+        "{\"a\": [1, -2.5, \"x\\ny\"], \"b\\u0041\": {\"c\": null}, \"d\": true, \"e\": {}}", recorder);
+    assert(result);
+    assert(result.value());
+    
+    std::vector<std::string> expected = {
+        "{", "k:a", "[", "i:1", "r:-2.500000", "s:x\ny", "]3",
+        "k:bA", "{", "k:c", "null", "}1",
+        "k:d", "true",
+        "k:e", "{", "}0",
+        "}4"
+    };
+    assert(recorder.events == expected);
+    
+    // Scalars at the top level
+    RecordingHandler scalar;
+    assert(JsonParser::parse("  false ", scalar).value());
+    assert(scalar.events == std::vector<std::string>{"false"});
+    
+    // Stopping early is not an error
+    CountingHandler counter(2);
+    result = JsonParser::parse("[\"a\", \"b\", \"c\", \"d\"]", counter);
+    assert(result);
+    assert(!result.value());
+    assert(counter.strings == 2);
+    
+    // Errors
+    JsonHandler ignore;
+    assert(!JsonParser::parse("[1, 2", ignore));
+    assert(!JsonParser::parse("{\"a\" 1}", ignore));
+    assert(!JsonParser::parse("{1: 2}", ignore));
+    assert(!JsonParser::parse("[1] x", ignore));
+    assert(JsonParser::parse(std::string("[\"\xC3\x28\"]"), ignore).error() ==
+           make_error_code(JsonErrorCode::InvalidUTF8));
+    
+    // A large document is processed without building a tree
+    std::string big = "[";
+    for (int i = 0; i < 10000; ++i) {
+        if (i > 0) {
+            big += ",";
+        }
+        big += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\"}";
+    }
+    big += "]";
+    CountingHandler all(1000000);
+    assert(JsonParser::parse(big, all).value());
+    assert(all.strings == 10000);
+    
+    std::cout << "test_sax passed!" << std::endl;
+    return 0;
+}
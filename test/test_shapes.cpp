@@ -0,0 +1,118 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_shape.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_thread_pool.hpp"
+
+using namespace jansson;
+
+static const JsonObject& as_object(const JsonRef<JsonValue>& value) {
+    assert(value && value->is_object());
+    return static_cast<const JsonObject&>(*value);
+}
+
+int main() {
+    std::cout << "Running test_shapes..." << std::endl;
+    
+    // Records with the same keys in the same order share one shape, and
+    // wide records share its index
+    std::string input = "[";
+    for (int i = 0; i < 100; ++i) {
+        if (i > 0) {
+            input += ", ";
+        }
+        input += "{";
+        for (int f = 0; f < 12; ++f) {
+            if (f > 0) {
+                input += ", ";
+            }
+            input += "\"field" + std::to_string(f) + "\": " + std::to_string(i * 100 + f);
+        }
+        input += "}";
+    }
+    input += ", {\"field1\": 0, \"field0\": 1}]";
+    
+    JsonShapeTable shapes;
+    JsonParseOptions options;
+    options.share_shapes = true;
+    options.shape_table = &shapes;
+    auto parsed = JsonParser::parse(input, options);
+    assert(parsed);
+    const auto& records = static_cast<const JsonArray&>(*parsed.value());
+    assert(shapes.size() == 2);
+    
+    auto shape = as_object(records.at(0)).shape();
+    assert(shape && shape->size() == 12);
+    std::size_t slot = shape->slot_of("field7");
+    assert(slot == 7);
+    assert(shape->slot_of("missing") == JsonShape::npos);
+    for (std::size_t i = 0; i < 100; ++i) {
+        const auto& record = as_object(records.at(i));
+        assert(record.shape() == shape);
+        assert(record.values().shares_index());
+        assert(record.slot(slot)->integer_value() == static_cast<std::int64_t>(i * 100 + 7));
+        assert(record.get("field11")->integer_value() == static_cast<std::int64_t>(i * 100 + 11));
+    }
+    
+    // Key order is part of the layout
+    const auto& reordered = as_object(records.at(100));
+    assert(reordered.shape() && reordered.shape() != shape);
+    assert(reordered.shape()->key(0) == "field1");
+    
+    // Output is unchanged
+    assert(JsonSerializer::serialize(*parsed.value()) == JsonSerializer::serialize(*JsonParser::parse(input).value()));
+    
+    // Replacing a value keeps the shape; adding or removing a key drops it
+    auto record = static_pointer_cast<JsonObject>(records.at(1));
+    record->set("field3", JsonStringValue::create("changed"));
+    assert(record->shape() == shape);
+    assert(record->slot(3)->string_value() == "changed");
+    record->set("extra", JsonNull::create());
+    assert(!record->shape());
+    assert(record->get("field3")->string_value() == "changed");
+    assert(record->get("extra")->is_null());
+    assert(!as_object(records.at(2)).get("extra"));
+    
+    auto other = static_pointer_cast<JsonObject>(records.at(2));
+    other->erase("field0");
+    assert(!other->shape());
+    assert(!other->has("field0") && other->has("field11"));
+    assert(as_object(records.at(3)).has("field0"));
+    
+    // Clones share the shape; shapes are only adopted by matching objects
+    auto cloned = records.at(4)->clone();
+    assert(as_object(cloned).shape() == shape);
+    auto mismatch = JsonObject::create();
+    mismatch->set("field0", JsonNull::create());
+    assert(!mismatch->adopt_shape(shape));
+    assert(!mismatch->shape());
+    
+    // Small objects are shaped without an index of their own
+    auto small = JsonParser::parse("[{\"a\": 1, \"b\": 2}, {\"a\": 3, \"b\": 4}]", options);
+    const auto& pair = static_cast<const JsonArray&>(*small.value());
+    assert(as_object(pair.at(0)).shape() == as_object(pair.at(1)).shape());
+    assert(as_object(pair.at(1)).slot(as_object(pair.at(1)).shape()->slot_of("b"))->integer_value() == 4);
+    
+    // Parallel parsing with the global table, and a local table by default
+    JsonThreadPool pool(4);
+    options.shape_table = &JsonShapeTable::global();
+    options.parallel_threshold = 1;
+    options.pool = &pool;
+    auto parallel = JsonParser::parse(input, options);
+    const auto& parallel_records = static_cast<const JsonArray&>(*parallel.value());
+    for (std::size_t i = 1; i < 100; ++i) {
+        assert(as_object(parallel_records.at(i)).shape() == as_object(parallel_records.at(0)).shape());
+    }
+    options.shape_table = nullptr;
+    options.parallel_threshold = 0;
+    auto local = JsonParser::parse(input, options);
+    assert(as_object(static_cast<const JsonArray&>(*local.value()).at(5)).shape());
+    
+    // Shapes are off by default
+    assert(!as_object(JsonParser::parse("{\"a\": 1}").value()).shape());
+    
+    std::cout << "test_shapes passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_stats.hpp"
+
+using namespace jansson;
+
+static size_t custom_mallocs = 0;
+static size_t custom_frees = 0;
+
+static void* counting_malloc(size_t size) {
+    ++custom_mallocs;
+    return std::malloc(size);
+}
+
+static void counting_free(void* pointer) {
+    ++custom_frees;
+    std::free(pointer);
+}
+
+struct Recorder : JsonStatsObserver {
+    size_t parsed = 0;
+    size_t serialized = 0;
+    void on_parse(size_t bytes, uint64_t) override { parsed += bytes; }
+    void on_serialize(size_t bytes, uint64_t) override { serialized += bytes; }
+};
+
+int main() {
+    std::cout << "Running test_stats..." << std::endl;
+
+    // Custom allocation functions see the library's allocations
+    json_set_alloc_funcs(counting_malloc, counting_free);
+    json_malloc_t malloc_fn = nullptr;
+    json_free_t free_fn = nullptr;
+    json_get_alloc_funcs(&malloc_fn, &free_fn);
+    assert(malloc_fn == counting_malloc && free_fn == counting_free);
+
+    json_t* json = json_loads("{\"items\": [1, 2, \"three\"]}", 0, nullptr);
+    assert(json && custom_mallocs > 0);
+    char* text = json_dumps(json, JSON_COMPACT);
+    assert(std::string(text) == "{\"items\":[1,2,\"three\"]}");
+    json_dumps_free(text);
+    json_decref(json);
+    assert(custom_frees == custom_mallocs);
+    void* block = json_malloc(10);
+    assert(block && custom_mallocs == custom_frees + 1);
+    json_free(block);
+    json_free(nullptr);
+    json_set_alloc_funcs(nullptr, nullptr);
+    json_get_alloc_funcs(&malloc_fn, &free_fn);
+    assert(malloc_fn == &std::malloc && free_fn == &std::free);
+
+    // Per-document footprint grows with the document
+    auto small = JsonParser::parse("[1]");
+    auto large = JsonParser::parse("[1, 2, 3, {\"a\": \"a string too long to live in the node\"}]");
+    assert(small && large);
+    size_t small_bytes = memory_usage(*small.value());
+    assert(small_bytes >= sizeof(JsonArray) + sizeof(JsonNumber));
+    assert(memory_usage(*large.value()) > small_bytes + 36);
+
+    // A subtree that appears twice is counted once
+    auto shared = JsonArray::create();
+    shared->push_back(large.value());
+    shared->push_back(large.value());
+    assert(memory_usage(*shared) < sizeof(JsonArray) + 2 * sizeof(JsonRef<JsonValue>) + memory_usage(*large.value()) + 1);
+
+    // Counters, only kept in stats builds
+    reset_json_stats();
+    Recorder recorder;
+    set_json_stats_observer(&recorder);
+    std::string input = "{\"a\": [true, null, 1.5, \"x\"]}";
+    {
+        auto parsed = JsonParser::parse(input);
+        assert(parsed);
+        std::string output = JsonSerializer::serialize(*parsed.value());
+        JsonStats stats = json_stats();
+        if constexpr (json_stats_enabled) {
+            assert(stats.parses == 1 && stats.parse_bytes == input.size());
+            assert(stats.largest_parse_bytes == input.size());
+            assert(stats.serializations == 1 && stats.serialize_bytes == output.size());
+            assert(stats.nodes_created[static_cast<int>(JsonType::Object)] == 1);
+            assert(stats.nodes_created[static_cast<int>(JsonType::Array)] == 1);
+            assert(stats.allocations > 0 && stats.peak_bytes_in_use >= stats.bytes_in_use);
+            assert(recorder.parsed == input.size() && recorder.serialized == output.size());
+        } else {
+            assert(stats.parses == 0 && stats.allocations == 0 && recorder.parsed == 0);
+        }
+    }
+    if constexpr (json_stats_enabled) {
+        JsonStats stats = json_stats();
+        assert(stats.nodes_destroyed[static_cast<int>(JsonType::Object)] == 1);
+        assert(stats.frees > 0);
+    }
+    set_json_stats_observer(nullptr);
+
+    std::cout << "test_stats passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include "json_stream.hpp"
+#include "json_parser.hpp"
+#include "json_c_api.hpp"
+
+using namespace jansson;
+
+struct ChunkSource {
+    std::string text;
+    size_t offset;
+    size_t chunk;
+};
+
+static size_t read_chunk(void* buffer, size_t buflen, void* data) {
+    auto* source = static_cast<ChunkSource*>(data);
+    size_t length = std::min({buflen, source->chunk, source->text.size() - source->offset});
+    source->text.copy(static_cast<char*>(buffer), length, source->offset);
+    source->offset += length;
+    return length;
+}
+
+int main() {
+    std::cout << "Running test_stream_parser..." << std::endl;
+    
+    const std::string document =
+        "{\"name\": \"caf\xC3\xA9 \\\"quoted\\\" \\u0041\", \"values\": [1, -2.5e3, true, false, null],"
+        " \"nested\": {\"deep\": [[], {}, [\"x\"]]}, \"big\": 12345678901234}";
+    auto expected = JsonParser::parse(document);
+    assert(expected);
+    
+    // Every chunk size produces the same tree as the one-shot parser
+    for (size_t chunk = 1; chunk <= document.size(); ++chunk) {
+        JsonStreamParser parser;
+        size_t completed = 0;
+        for (size_t offset = 0; offset < document.size(); offset += chunk) {
+            auto fed = parser.feed(std::string_view(document).substr(offset, chunk));
+            assert(fed);
+            completed += fed.value();
+        }
+        assert(parser.finish());
+        assert(completed == 1);
+        assert(!parser.in_value());
+        auto value = parser.take_value();
+        assert(value);
+        assert(value->equals(*expected.value()));
+        assert(!parser.has_value());
+    }
+    
+    // Concatenated values and a trailing number completed by finish()
+    JsonStreamParser multi;
+    assert(multi.feed("{\"a\": 1}\n[2, 3]\n\"four\" 5").value() == 3);
+    assert(multi.in_value());
+    auto finished = multi.finish();
+    assert(finished && finished.value() == 1);
+    assert(multi.value_count() == 4);
+    assert(multi.take_value()->is_object());
+    assert(multi.take_value()->is_array());
+    assert(multi.take_value()->string_value() == "four");
+    assert(multi.take_value()->integer_value() == 5);
+    
+    // Numbers split across chunks
+    JsonStreamParser split;
+    assert(split.feed("[12").value() == 0);
+    assert(split.feed("34.5").value() == 0);
+    assert(split.feed("e1]").value() == 1);
+    assert(split.take_value()->equals(*JsonParser::parse("[1234.5e1]").value()));
+    
+    // Errors
+    const char* invalid[] = {"[1,]", "{\"a\" 1}", "[1 2]", "{\"a\": tru}", "[\"\x01\"]", "{1: 2}", "[01]", "]"};
+    for (const char* text : invalid) {
+        JsonStreamParser parser;
+        bool ok = static_cast<bool>(parser.feed(text)) && static_cast<bool>(parser.finish());
+        assert(!ok);
+        assert(!parser.error_message().empty());
+        assert(!parser.feed("[]"));
+        parser.reset();
+        assert(parser.feed("[]").value() == 1);
+    }
+    
+    JsonStreamParser unterminated;
+    assert(unterminated.feed("{\"a\": [1, 2"));
+    assert(!unterminated.finish());
+    
+    JsonStreamParser position;
+    assert(!position.feed("[1, 2, x]"));
+    assert(position.bytes_consumed() == 7);
+    
+    // C API: callback, FILE and fd readers
+    ChunkSource source{document, 0, 7};
+    json_error_code error;
+    json_t* json = json_load_callback(read_chunk, &source, 0, &error);
+    assert(json != nullptr);
+    assert(error == JSON_ERROR_SUCCESS);
+    assert(json_object_size(json) == 4);
+    json_delete(json);
+    
+    ChunkSource two{"[1] [2]", 0, 100};
+    assert(json_load_callback(read_chunk, &two, 0, &error) == nullptr);
+    assert(error == JSON_ERROR_PARSE_ERROR);
+    
+    FILE* file = std::tmpfile();
+    assert(file != nullptr);
+    std::fwrite(document.data(), 1, document.size(), file);
+    std::rewind(file);
+    json = json_loadf(file, 0, &error);
+    assert(json != nullptr);
+    json_delete(json);
+    
+    std::rewind(file);
+    json = json_loadfd(fileno(file), 0, &error);
+    assert(json != nullptr);
+    assert(json_is_object(json) == 1);
+    json_delete(json);
+    std::fclose(file);
+    
+    assert(json_loadf(nullptr, 0, &error) == nullptr);
+    assert(error == JSON_ERROR_INVALID_ARGUMENT);
+    
+    // The parse limits apply to each value, by default nesting only
+    std::string deep = std::string(200000, '[') + std::string(200000, ']');
+    JsonStreamParser bounded;
+    assert(bounded.feed(deep).error() == make_error_code(JsonErrorCode::LimitExceeded));
+    assert(bounded.feed("1").error() == make_error_code(JsonErrorCode::LimitExceeded));
+    bounded.reset();
+    std::string allowed = std::string(2048, '[') + std::string(2048, ']');
+    assert(bounded.feed(allowed + allowed) && bounded.value_count() == 2);
+    
+    JsonParseOptions limits;
+    limits.max_nodes = 3;
+    limits.max_string_length = 4;
+    limits.max_input_size = 16;
+    JsonStreamParser limited(limits);
+    assert(limited.feed("[1, 2] [\"abcd\"] [3, \"\\u0041\"]") && limited.value_count() == 3);
+    assert(limited.feed("[1, 2, 3]").error() == make_error_code(JsonErrorCode::LimitExceeded));
+    limited.reset();
+    assert(limited.feed("\"ab").value() == 0);
+    assert(limited.feed("cde\"").error() == make_error_code(JsonErrorCode::LimitExceeded));
+    limited.reset();
+    assert(limited.feed(std::string(100000, ' ') + "[").value() == 0);
+    assert(limited.feed(std::string(100000, ' ')).error() == make_error_code(JsonErrorCode::LimitExceeded));
+    limited.reset();
+    assert(limited.feed("\"\xff\"").error() == make_error_code(JsonErrorCode::InvalidUTF8));
+    
+    // ... and are reported by the C API as by json_loads
+    file = std::tmpfile();
+    assert(file != nullptr);
+    std::fwrite(deep.data(), 1, deep.size(), file);
+    std::rewind(file);
+    assert(json_loadf(file, 0, &error) == nullptr);
+    assert(error == JSON_ERROR_LIMIT_EXCEEDED);
+    std::fclose(file);
+    ChunkSource bad_utf8{"[\"\xff\"]", 0, 2};
+    assert(json_load_callback(read_chunk, &bad_utf8, 0, &error) == nullptr);
+    assert(error == JSON_ERROR_INVALID_UTF8);
+    
+    std::cout << "test_stream_parser passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include "json_bind.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+namespace orders {
+
+struct Line {
+    std::string sku;
+    int quantity = 0;
+    double price = 0;
+};
+
+JSON_BIND(Line, sku, quantity, price)
+
+struct Order {
+    std::uint64_t id = 0;
+    std::string customer;
+    bool urgent = false;
+    std::vector<Line> lines;
+    std::optional<std::string> note;
+    std::map<std::string, std::int64_t> counters;
+    std::vector<std::vector<int>> grid;
+};
+
+JSON_BIND(Order, id, customer, urgent, lines, note, counters, grid)
+
+// Custom member names
+struct Renamed {
+    int value = 0;
+};
+
+constexpr auto json_fields(const Renamed*) noexcept {
+    return std::make_tuple(json_field("the-value", &Renamed::value));
+}
+
+} // namespace orders
+
+int main() {
+    std::cout << "Running test_struct_binding..." << std::endl;
+
+    std::string input =
+        "{\"id\": 42, \"customer\": \"Ada \\u00e9\", \"urgent\": true, \"skipped\": {\"a\": [1, {\"b\": 2}]},"
+        " \"lines\": [{\"sku\": \"A-1\", \"quantity\": 2, \"price\": 9.5},"
+        " {\"price\": 3, \"sku\": \"B-2\", \"quantity\": 1, \"extra\": null}],"
+        " \"note\": null, \"counters\": {\"x\": 1, \"y\": -2}, \"grid\": [[1, 2], [], [3]]}";
+
+    auto decoded = JsonBinder::decode<orders::Order>(input);
+    assert(decoded);
+    const orders::Order& order = decoded.value();
+    assert(order.id == 42 && order.customer == "Ada \xc3\xa9" && order.urgent);
+    assert(order.lines.size() == 2);
+    assert(order.lines[0].sku == "A-1" && order.lines[0].quantity == 2 && order.lines[0].price == 9.5);
+    assert(order.lines[1].sku == "B-2" && order.lines[1].quantity == 1 && order.lines[1].price == 3.0);
+    assert(!order.note);
+    assert(order.counters.size() == 2 && order.counters.at("y") == -2);
+    assert(order.grid.size() == 3 && order.grid[0][1] == 2 && order.grid[1].empty() && order.grid[2][0] == 3);
+
+    // Encoding matches the serializer's output for the same document
+    std::string encoded = JsonBinder::encode(order);
+    assert(encoded ==
+           "{\"id\": 42, \"customer\": \"Ada \xc3\xa9\", \"urgent\": true, \"lines\": [{\"sku\": \"A-1\", "
+           "\"quantity\": 2, \"price\": 9.5}, {\"sku\": \"B-2\", \"quantity\": 1, \"price\": 3}], "
+           "\"note\": null, \"counters\": {\"x\": 1, \"y\": -2}, \"grid\": [[1, 2], [], [3]]}");
+    assert(JsonSerializer::serialize(*JsonParser::parse(encoded).value()) == encoded);
+
+    // Decoding into an existing object replaces containers and keeps
+    // fields that the input does not mention
+    orders::Order reused = order;
+    assert(JsonBinder::decode("{\"lines\": [{\"sku\": \"C\"}], \"note\": \"hi\"}", reused));
+    assert(reused.lines.size() == 1 && reused.lines[0].sku == "C" && reused.lines[0].quantity == 0);
+    assert(reused.note && *reused.note == "hi");
+    assert(reused.customer == order.customer);
+
+    auto renamed = JsonBinder::decode<orders::Renamed>("{\"the-value\": 5, \"value\": 6}");
+    assert(renamed && renamed.value().value == 5);
+    assert(JsonBinder::encode(renamed.value()) == "{\"the-value\": 5}");
+
+    // Values that do not fit their targets
+    auto invalid_type = make_error_code(JsonErrorCode::InvalidType);
+    assert(JsonBinder::decode<orders::Order>("{\"customer\": 5}").error() == invalid_type);
+    assert(JsonBinder::decode<orders::Order>("{\"lines\": {}}").error() == invalid_type);
+    assert(JsonBinder::decode<orders::Order>("{\"id\": -1}").error() == invalid_type);
+    assert(JsonBinder::decode<orders::Line>("{\"quantity\": 1.5}").error() == invalid_type);
+    assert(JsonBinder::decode<orders::Line>("{\"quantity\": 3000000000}").error() == invalid_type);
+    assert(JsonBinder::decode<orders::Line>("[]").error() == invalid_type);
+    assert(!JsonBinder::decode<orders::Line>("{\"sku\": }"));
+
+    // Scalars and containers at the top level
+    assert(JsonBinder::decode<std::vector<int>>("[1, 2, 3]").value() == std::vector<int>({1, 2, 3}));
+    assert(JsonBinder::encode(std::vector<double>{0.5, -1500}) == "[0.5, -1500]");
+    assert(JsonBinder::decode<std::string>("\"x\"").value() == "x");
+
+    std::cout << "test_struct_binding passed!" << std::endl;
+    return 0;
+}
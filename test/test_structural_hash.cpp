@@ -0,0 +1,94 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <unordered_set>
+#include "json_parser.hpp"
+#include "json_value.hpp"
+
+using namespace jansson;
+
+static JsonRef<JsonValue> parse(std::string_view text) {
+    auto result = JsonParser::parse(text);
+    assert(result);
+    return result.value();
+}
+
+int main() {
+    std::cout << "Running test_structural_hash..." << std::endl;
+
+    // Equal values hash alike, whatever the member order
+    auto a = parse("{\"id\": 7, \"tags\": [\"x\", \"y\"], \"score\": 1.5, \"ok\": true, \"none\": null}");
+    auto b = parse("{\"none\": null, \"ok\": true, \"score\": 1.5, \"tags\": [\"x\", \"y\"], \"id\": 7}");
+    assert(a->equals(*b) && a->hash() == b->hash());
+    assert(std::hash<JsonValue>{}(*a) == a->hash());
+
+    // Numbers compare by value, exactly
+    assert(parse("1")->equals(*parse("1.0")) && parse("1")->hash() == parse("1.0")->hash());
+    assert(parse("0.0")->hash() == parse("-0.0")->hash());
+    assert(!parse("0.1")->equals(*parse("0.1000000000001")));
+    assert(!parse("9007199254740993")->equals(*parse("9007199254740992")));
+
+    // Differences in any part change the hash
+    const char* others[] = {
+        "{\"id\": 8, \"tags\": [\"x\", \"y\"], \"score\": 1.5, \"ok\": true, \"none\": null}",
+        "{\"id\": 7, \"tags\": [\"y\", \"x\"], \"score\": 1.5, \"ok\": true, \"none\": null}",
+        "{\"id\": 7, \"tags\": [\"x\", \"y\"], \"score\": 1.5, \"ok\": false, \"none\": null}",
+        "{\"id\": 7, \"tags\": [\"x\", \"y\"], \"score\": 1.5, \"ok\": true, \"null\": null}",
+        "{\"id\": 7, \"tags\": [\"x\", \"y\"], \"score\": 1.5, \"ok\": true}",
+        "[7, [\"x\", \"y\"], 1.5, true, null]",
+    };
+    for (const char* text : others) {
+        auto other = parse(text);
+        assert(!other->equals(*a) && other->hash() != a->hash());
+    }
+    assert(parse("[]")->hash() != parse("{}")->hash());
+    assert(parse("[[]]")->hash() != parse("[[], []]")->hash());
+
+    // Cached hashes follow changes made through the containers
+    auto& object = static_cast<JsonObject&>(*a);
+    std::size_t before = object.hash();
+    assert(object.container_state().cached_hash() == before);
+    object.set("id", JsonNumber::create(8));
+    assert(object.container_state().cached_hash() == 0);
+    assert(object.hash() != before && !object.equals(*b));
+    object.set("id", JsonNumber::create(7));
+    assert(object.hash() == before && object.equals(*b));
+    static_cast<JsonArray&>(*object.mutable_get("tags")).push_back(JsonStringValue::create("z"));
+    assert(object.hash() != before && !object.equals(*b));
+    static_cast<JsonArray&>(*object.mutable_get("tags")).remove(2);
+    assert(object.hash() == before);
+
+    // A change through another reference is seen too
+    auto& tags = static_cast<JsonArray&>(*object.get("tags"));
+    tags.clear();
+    assert(object.hash() != before && !object.equals(*b));
+    assert(object.hash() == object.rehash());
+    tags.push_back(JsonStringValue::create("x"));
+    tags.push_back(JsonStringValue::create("y"));
+    assert(object.hash() == before && object.equals(*b));
+    
+    // Kept hashes that differ only reject while they are current
+    auto left = parse("{\"a\": [1], \"b\": {\"c\": [true]}}");
+    auto right = parse("{\"a\": [2], \"b\": {\"c\": [false]}}");
+    assert(left->hash() != right->hash() && !left->equals(*right));
+    auto& right_object = static_cast<JsonObject&>(*right);
+    static_cast<JsonArray&>(*right_object.get("a")).set(0, JsonNumber::create(1));
+    auto& deep = static_cast<JsonArray&>(*static_cast<JsonObject&>(*right_object.get("b")).get("c"));
+    deep.set(0, JsonBoolean::create(true));
+    assert(left->equals(*right));
+    assert(left->hash() == right->hash());
+    assert(JsonValueHash{}(*left) == JsonValueHash{}(*right) && JsonValueEqual{}(*left, *right));
+
+    // Deduplicating documents
+    std::unordered_set<JsonRef<JsonValue>, JsonValueHash, JsonValueEqual> seen;
+    const char* events[] = {"{\"e\": 1, \"u\": \"a\"}", "{\"u\": \"a\", \"e\": 1}", "{\"e\": 2, \"u\": \"a\"}",
+                            "{\"e\": 1, \"u\": \"a\"}", "[1]", "[1.0]"};
+    std::size_t unique = 0;
+    for (const char* text : events) {
+        unique += seen.insert(parse(text)).second;
+    }
+    assert(unique == 3 && seen.size() == 3);
+
+    std::cout << "test_structural_hash passed!" << std::endl;
+    return 0;
+}
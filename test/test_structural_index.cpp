@@ -0,0 +1,82 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_simd.hpp"
+
+using namespace jansson;
+
+static const simd::Isa all_isas[] = {
+    simd::Isa::Scalar, simd::Isa::Sse2, simd::Isa::Avx2, simd::Isa::Neon
+};
+
+static std::vector<std::uint32_t> index_of(const std::string& input, simd::Isa isa) {
+    std::vector<std::uint32_t> index;
+    assert(simd::build_structural_index(input, index, isa));
+    return index;
+}
+
+static void check_same_parse(const std::string& input) {
+    JsonParseOptions indexed;
+    indexed.use_structural_index = true;
+    
+    auto plain = JsonParser::parse(input);
+    auto fast = JsonParser::parse(input, indexed);
+    assert(static_cast<bool>(plain) == static_cast<bool>(fast));
+    if (plain) {
+        assert(plain.value()->equals(*fast.value()));
+        assert(JsonSerializer::serialize(*plain.value()) ==
+               JsonSerializer::serialize(*fast.value()));
+    }
+}
+
+int main() {
+    std::cout << "Running test_structural_index..." << std::endl;
+    std::cout << "Active ISA: " << simd::isa_name(simd::active_isa()) << std::endl;
+    
+    // Index contents for a small document
+    std::string small = "{\"a\": [1, true, \"x,y\"], \"b\\\"\": null}";
+    std::vector<std::uint32_t> expected = {0, 1, 3, 4, 6, 7, 8, 10, 14, 16, 20, 21, 22, 24, 28, 29, 31, 35};
+    assert(index_of(small, simd::Isa::Scalar) == expected);
+    
+    // Every supported ISA must agree with the scalar kernel, including
+    // escapes and strings that straddle 64-byte blocks.
+    std::string large = "[";
+    for (int i = 0; i < 200; ++i) {
+        if (i > 0) large += ",";
+        large += "{\"id\": " + std::to_string(i) + ", \"text\": \"";
+        large += std::string(i % 70, 'a');
+        large += std::string(i % 5, '\\');
+        large += (i % 5) % 2 ? "\\\"" : "";
+        large += "\", \"flag\": false}";
+    }
+    large += "]";
+    
+    auto reference = index_of(large, simd::Isa::Scalar);
+    for (simd::Isa isa : all_isas) {
+        if (simd::is_supported(isa)) {
+            assert(index_of(large, isa) == reference);
+        }
+    }
+    
+    // Unterminated strings are detected by stage 1
+    std::vector<std::uint32_t> index;
+    assert(!simd::build_structural_index("[\"abc", index));
+    
+    // The indexed parser produces the same trees and rejects the same inputs
+    check_same_parse(small);
+    check_same_parse(large);
+    check_same_parse("  [ 1 , 2 ,\n 3 ]  ");
+    check_same_parse("{\"k\": \"v\" }");
+    check_same_parse("\"plain string with spaces\"");
+    check_same_parse("[1 2]");
+    check_same_parse("[123x]");
+    check_same_parse("{\"a\" 1}");
+    check_same_parse("[\"unterminated]");
+    check_same_parse("[tru]");
+    
+    std::cout << "test_structural_index passed!" << std::endl;
+    return 0;
+}
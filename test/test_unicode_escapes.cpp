@@ -0,0 +1,113 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include "json_c_api.hpp"
+#include "json_parser.hpp"
+#include "json_stream.hpp"
+#include "string_utils.hpp"
+
+using namespace jansson;
+
+static std::string parsed_string(std::string_view input, const JsonParseOptions& options = JsonParseOptions()) {
+    auto result = JsonParser::parse(input, options);
+    assert(result && result.value()->is_string());
+    return std::string(static_cast<const JsonStringValue&>(*result.value()).view());
+}
+
+static std::string parse_failure(std::string_view input) {
+    JsonParseError error;
+    assert(!JsonParser::parse(input, JsonParseOptions(), error));
+    return error.message;
+}
+
+struct Strings : JsonHandler {
+    std::string all;
+    bool on_string(std::string_view text) override { return all += text, true; }
+    bool on_key(std::string_view text) override { return all += text, true; }
+};
+
+int main() {
+    std::cout << "Running test_unicode_escapes..." << std::endl;
+
+    // One to three byte code points, in either case
+    assert(parsed_string("\"\\u0041\\u00e9\\u00E9\\u20ac\"") == "A\xc3\xa9\xc3\xa9\xe2\x82\xac");
+    assert(parsed_string("\"\\u0000\"") == std::string(1, '\0'));
+    assert(parsed_string("\"\\uffff\"") == "\xef\xbf\xbf");
+
+    // Surrogate pairs combine into four-byte sequences
+    const char* emoji = "\xf0\x9f\x98\x80";                 // U+1F600
+    const char* clef = "\xf0\x9d\x84\x9e";                  // U+1D11E
+    const char* highest = "\xf4\x8f\xbf\xbf";               // U+10FFFF
+    assert(parsed_string("\"\\ud83d\\ude00\"") == emoji);
+    assert(parsed_string("\"x\\uD834\\uDD1Ey\"") == std::string("x") + clef + "y");
+    assert(parsed_string("\"\\udbff\\udfff\"") == highest);
+
+    JsonParseOptions indexed;
+    indexed.use_structural_index = true;
+    assert(parsed_string("\"\\ud83d\\ude00\"", indexed) == emoji);
+
+    // Keys, including interned ones and the event parser
+    auto object = JsonParser::parse("{\"\\ud83d\\ude00\": 1}").value();
+    assert(static_cast<const JsonObject&>(*object).has(emoji));
+    JsonParseOptions interned;
+    interned.intern_keys = true;
+    object = JsonParser::parse("{\"k\\u00e9\": 1}", interned).value();
+    assert(static_cast<const JsonObject&>(*object).has("k\xc3\xa9"));
+    Strings strings;
+    assert(JsonParser::parse("{\"\\ud834\\udd1e\": [\"\\ud83d\\ude00\"]}", strings));
+    assert(strings.all == std::string(clef) + emoji);
+
+    // Unpaired surrogates and bad digits are errors at the escape
+    assert(parse_failure("\"\\ud83d\"") == "Invalid Unicode surrogate pair");
+    assert(parse_failure("\"\\ud83dx\"") == "Invalid Unicode surrogate pair");
+    assert(parse_failure("\"\\ud83d\\u0041\"") == "Invalid Unicode surrogate pair");
+    assert(parse_failure("\"\\ude00\\ud83d\"") == "Invalid Unicode surrogate pair");
+    assert(parse_failure("\"\\ud83d\\uZZZZ\"") == "Invalid Unicode escape sequence");
+    assert(parse_failure("\"\\u12\"") == "Invalid Unicode escape sequence");
+    assert(parse_failure("\"\\u+123\"") == "Invalid Unicode escape sequence");
+    JsonParseError error;
+    assert(!JsonParser::parse("[\"ab\", \"c\\udc00\"]", JsonParseOptions(), error));
+    assert(error.position == 9);
+
+    // The push parser decodes a pair split across chunks
+    JsonStreamParser stream;
+    assert(stream.feed("[\"\\ud83d\\u").value() == 0);
+    assert(stream.feed("de00\"]").value() == 1);
+    auto array = stream.take_value();
+    assert(static_cast<const JsonStringValue&>(*static_cast<const JsonArray&>(*array).at(0)).view() == emoji);
+
+    // JsonString::unescape shares the decoder
+    assert(JsonString::unescape("\"\\ud83d\\ude00 \\u00e9\"") == std::string(emoji) + " \xc3\xa9");
+    bool threw = false;
+    try {
+        JsonString::unescape("\"\\udc00\"");
+    } catch (const JsonException& e) {
+        threw = std::strcmp(e.what(), "Invalid Unicode surrogate pair") == 0;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        JsonString::unescape("\"\\u00g0\"");
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // The decoder itself
+    assert(decode_hex4("00fF") == 0xff && decode_hex4("12G4") < 0 && decode_hex4("-123") < 0);
+    std::string out;
+    UnicodeEscapeError code = UnicodeEscapeError::None;
+    assert(decode_unicode_escape("d83d\\ude00", 10, out, code) == 10 && out == emoji);
+    assert(decode_unicode_escape("d83d\\ude00", 9, out, code) == 0 && code == UnicodeEscapeError::UnpairedSurrogate);
+    assert(decode_unicode_escape("00e", 3, out, code) == 0 && code == UnicodeEscapeError::InvalidHex);
+
+    // C API
+    json_t* json = json_loads("\"\\ud83d\\ude00\"", 0, nullptr);
+    assert(json && std::strcmp(json_string_value(json), emoji) == 0);
+    json_decref(json);
+    assert(!json_loads("\"\\udead\"", 0, nullptr));
+
+    std::cout << "test_unicode_escapes passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <string>
+#include "json_parser.hpp"
+#include "json_simd.hpp"
+#include "string_utils.hpp"
+
+using namespace jansson;
+
+static const simd::Isa all_isas[] = {
+    simd::Isa::Scalar, simd::Isa::Sse2, simd::Isa::Avx2, simd::Isa::Neon
+};
+
+static void check_utf8(const std::string& input, bool expected) {
+    for (simd::Isa isa : all_isas) {
+        assert(simd::validate_utf8(input, isa) == expected);
+    }
+    assert((simd::find_invalid_utf8(input) == std::string::npos) == expected);
+}
+
+static void append_code_point(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+int main() {
+    std::cout << "Running test_utf8_validation..." << std::endl;
+    
+    // Well-formed input
+    check_utf8("", true);
+    check_utf8("plain ascii", true);
+    check_utf8("caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80", true);
+    check_utf8("\xF4\x8F\xBF\xBF", true);
+    check_utf8("\xED\x9F\xBF", true);
+    
+    // Malformed input
+    check_utf8("\x80", false);                 // lone continuation
+    check_utf8("\xC3", false);                 // truncated
+    check_utf8("\xC0\xAF", false);             // overlong
+    check_utf8("\xE0\x80\xAF", false);         // overlong
+    check_utf8("\xF0\x80\x80\xAF", false);     // overlong
+    check_utf8("\xED\xA0\x80", false);         // surrogate
+    check_utf8("\xF4\x90\x80\x80", false);     // above U+10FFFF
+    check_utf8("\xF8\x88\x80\x80\x80", false); // five-byte form
+    check_utf8("\xE2\x82", false);             // truncated
+    
+    // Errors and sequences straddling 16/32-byte boundaries
+    for (size_t prefix = 0; prefix < 70; ++prefix) {
+        std::string pad(prefix, 'a');
+        check_utf8(pad + "\xE2\x82\xAC" + pad, true);
+        check_utf8(pad + "\xF0\x9F\x98\x80", true);
+        check_utf8(pad + "\xE2\x82", false);
+        check_utf8(pad + "\xE2\x82" + pad, false);
+        check_utf8(pad + "\xED\xA0\x80" + pad, false);
+        assert(simd::find_invalid_utf8(pad + "\xC3" + pad) == prefix);
+    }
+    
+    // Random sequences of code points, optionally with one byte corrupted
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<std::uint32_t> plane(0, 3);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int round = 0; round < 3000; ++round) {
+        std::string text;
+        int count = static_cast<int>(rng() % 80);
+        for (int i = 0; i < count; ++i) {
+            std::uint32_t limits[] = {0x80, 0x800, 0x10000, 0x110000};
+            std::uint32_t cp = rng() % limits[plane(rng)];
+            if (cp >= 0xD800 && cp <= 0xDFFF) {
+                cp = 'x';
+            }
+            append_code_point(text, cp);
+        }
+        check_utf8(text, true);
+        if (!text.empty()) {
+            text[rng() % text.size()] = static_cast<char>(byte(rng));
+            bool expected = simd::find_invalid_utf8(text) == std::string::npos;
+            check_utf8(text, expected);
+        }
+    }
+    
+    // Escape scanning
+    for (size_t prefix = 0; prefix < 70; ++prefix) {
+        std::string clean(prefix, 'q');
+        for (simd::Isa isa : all_isas) {
+            assert(simd::find_escape(clean.data(), clean.size(), isa) == prefix);
+            for (char special : {'"', '\\', '\n', '\x1F'}) {
+                std::string text = clean + special + "tail\"";
+                assert(simd::find_escape(text.data(), text.size(), isa) == prefix);
+            }
+            std::string high = clean + "\xC3\xA9\x7F";
+            assert(simd::find_escape(high.data(), high.size(), isa) == high.size());
+        }
+    }
+    
+    // JsonString and the parser reject malformed input
+    bool threw = false;
+    try {
+        JsonString bad(std::string("\xC3("));
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    auto result = JsonParser::parse("[\"ok\", \"\xED\xA0\x80\"]");
+    assert(!result);
+    assert(result.error() == make_error_code(JsonErrorCode::InvalidUTF8));
+    
+    std::string message;
+    size_t position = 0;
+    result = JsonParser::parse_with_error("[\"\xFF\"]", message, position);
+    assert(!result);
+    assert(position == 2);
+    
+    result = JsonParser::parse("[\"caf\xC3\xA9\"]");
+    assert(result);
+    
+    std::cout << "test_utf8_validation passed!" << std::endl;
+    return 0;
+}
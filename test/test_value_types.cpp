@@ -0,0 +1,73 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "json_value.hpp"
+#include "json_serializer.hpp"
+
+using namespace jansson;
+
+// Nodes carry a vtable pointer, the tag and the reference count, nothing else
+static_assert(sizeof(JsonNull) <= 2 * sizeof(void*), "JsonNull too large");
+static_assert(sizeof(JsonNumber) <= 3 * sizeof(void*), "JsonNumber too large");
+
+int main() {
+    std::cout << "Running test_value_types..." << std::endl;
+    
+    std::shared_ptr<JsonValue> values[] = {
+        JsonNull::create(),
+        JsonBoolean::create(true),
+        JsonNumber::create(1.5),
+        JsonStringValue::create(std::string("text")),
+        JsonArray::create(),
+        JsonObject::create()
+    };
+    const JsonType types[] = {
+        JsonType::Null, JsonType::Boolean, JsonType::Number,
+        JsonType::String, JsonType::Array, JsonType::Object
+    };
+    
+    for (int i = 0; i < 6; ++i) {
+        assert(values[i]->type() == types[i]);
+        assert(values[i]->is_null() == (i == 0));
+        assert(values[i]->is_boolean() == (i == 1));
+        assert(values[i]->is_number() == (i == 2));
+        assert(values[i]->is_string() == (i == 3));
+        assert(values[i]->is_array() == (i == 4));
+        assert(values[i]->is_object() == (i == 5));
+        
+        // A clone equals its source and nothing of another type
+        auto copy = values[i]->clone();
+        assert(copy->type() == types[i]);
+        for (int j = 0; j < 6; ++j) {
+            assert(copy->equals(*values[j]) == (i == j));
+        }
+    }
+    
+    // Accessors throw on the wrong type
+    bool threw = false;
+    try {
+        values[3]->number_value();
+    } catch (const JsonException&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    assert(values[1]->boolean_value());
+    assert(values[2]->number_value() == 1.5);
+    assert(values[3]->string_value() == "text");
+    
+    // Deep clone of a nested tree
+    auto root = JsonObject::create();
+    auto list = JsonArray::create();
+    list->push_back(JsonNumber::create(1));
+    list->push_back(JsonStringValue::create(std::string("two")));
+    root->set("list", list);
+    auto copy = root->clone();
+    assert(copy->equals(*root));
+    list->push_back(JsonNull::create());
+    assert(!copy->equals(*root));
+    assert(root->to_string() == "{\"list\": [1, \"two\", null]}");
+    
+    std::cout << "test_value_types passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "json_writer.hpp"
+#include "string_utils.hpp"
+#include "json_serializer.hpp"
+#include "json_c_api.hpp"
+
+using namespace jansson;
+
+int main() {
+    std::cout << "Running test_writer..." << std::endl;
+    
+    // String writer grows past its initial capacity
+    JsonStringWriter string_writer(16);
+    for (int i = 0; i < 100; ++i) {
+        string_writer.write("abcdefghij", 10);
+    }
+    string_writer.fill(' ', 50);
+    string_writer.put('!');
+    assert(string_writer.size() == 1051);
+    assert(!string_writer.truncated());
+    std::string text = string_writer.take();
+    assert(text.size() == 1051);
+    assert(text.compare(0, 10, "abcdefghij") == 0);
+    assert(text.back() == '!');
+    
+    // Escaping
+    JsonStringWriter escape_writer;
+    escape_writer.write_escaped(std::string_view("a\"b\\c\n\x01z", 8));
+    assert(escape_writer.view() == "\"a\\\"b\\\\c\\n\\u0001z\"");
+    assert(JsonString::escape("tab\there") == "\"tab\\there\"");
+    
+    // Fixed buffer: output that does not fit is counted but dropped
+    auto array = JsonArray::create();
+    array->push_back(JsonNumber::create(1));
+    array->push_back(JsonStringValue::create("two"));
+    array->push_back(JsonBoolean::create(true));
+    const std::string expected = "[1, \"two\", true]";
+    
+    char buffer[64];
+    JsonBufferWriter fits(buffer, sizeof(buffer));
+    JsonSerializer::serialize(fits, *array);
+    assert(fits.size() == expected.size());
+    assert(!fits.truncated());
+    assert(std::string(buffer, fits.size()) == expected);
+    
+    char small[8];
+    JsonBufferWriter too_small(small, sizeof(small));
+    JsonSerializer::serialize(too_small, *array);
+    assert(too_small.size() == expected.size());
+    assert(too_small.truncated());
+    assert(std::memcmp(small, expected.data(), sizeof(small)) == 0);
+    
+    // Stream writer flushes in chunks
+    auto big = JsonArray::create();
+    for (int i = 0; i < 2000; ++i) {
+        big->push_back(JsonStringValue::create("element"));
+    }
+    std::ostringstream oss;
+    JsonSerializer::serialize(oss, *big);
+    assert(oss.str() == JsonSerializer::serialize(*big));
+    assert(oss.str().size() > 4096);
+    
+    // Pretty printing through the writer
+    auto object = JsonObject::create();
+    object->set("k", JsonNull::create());
+    assert(JsonSerializer::serialize(*object, true, 4) == "{\n    \"k\" : null\n}");
+    
+    // C API
+    json_error_code error;
+    json_t* json = json_loads("[1, \"two\", true]", 0, &error);
+    assert(json != nullptr);
+    assert(json_dumpb(json, buffer, sizeof(buffer), 0) == expected.size());
+    assert(std::string(buffer, expected.size()) == expected);
+    assert(json_dumpb(json, small, sizeof(small), 0) == expected.size());
+    assert(json_dumpb(json, nullptr, 0, 0) == expected.size());
+    json_delete(json);
+    
+    std::cout << "test_writer passed!" << std::endl;
+    return 0;
+}